@@ -0,0 +1,603 @@
+/**
+ * SharpDicom Native Codecs - Benchmark Executable
+ *
+ * Measures encode and decode throughput and per-frame latency percentiles
+ * for every codec compiled into the library, per frame size and thread
+ * count. Frames are synthetic gradients with noise unless compressed frame
+ * files are given, in which case each file is identified with probe_frame()
+ * and decoded as a reference corpus.
+ *
+ * Usage: sharpdicom_bench [-n frames] [-t threads,...] [-s sizes,...] [files...]
+ *
+ * Each thread count runs the frames split over that many pool threads, one
+ * frame at a time per thread, so the codecs themselves run single-threaded
+ * and the scaling shown is frame-level parallelism. The j2kdef rows repeat
+ * j2k with the library's default worker count instead; at 1 thread they
+ * run on the calling thread, where large frames get OpenJPEG workers.
+ */
+
+/* clock_gettime() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/jpeg_wrapper.h"
+#include "../src/j2k_wrapper.h"
+#include "../src/jls_wrapper.h"
+#include "../src/rle_wrapper.h"
+#include "../src/probe.h"
+#include "../src/thread_pool.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define MAX_LIST 16
+#define DEFAULT_FRAMES 64
+
+static double now_us(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+#endif
+}
+
+/*============================================================================
+ * Codec table
+ *============================================================================*/
+
+/** Geometry of one frame; samples are interleaved, little-endian */
+typedef struct {
+    int32_t width;
+    int32_t height;
+    int32_t components;
+    int32_t bits;           /* Bits stored */
+    int32_t bytes;          /* Bytes per sample (1 or 2) */
+} bench_format;
+
+typedef struct {
+    const char* name;
+    /** SHARPDICOM_HAS_* bit the codec needs */
+    int feature;
+    /** Whether frames with more than 8 bits per sample are supported */
+    int wide_samples;
+    int (*bound)(const bench_format* fmt, size_t* max_size);
+    int (*encode)(const bench_format* fmt, const uint8_t* raw, size_t raw_len,
+                  uint8_t* output, size_t output_len, size_t* size);
+    int (*decode)(const bench_format* fmt, const uint8_t* input, size_t input_len,
+                  uint8_t* output, size_t output_len);
+} bench_codec;
+
+static size_t raw_size(const bench_format* fmt) {
+    return (size_t)fmt->width * (size_t)fmt->height * (size_t)fmt->components * (size_t)fmt->bytes;
+}
+
+static int jpeg_bound(const bench_format* fmt, size_t* max_size) {
+    int bound = 0;
+    int status = jpeg_get_encode_bound(fmt->width, fmt->height, fmt->components, JPEG_SAMP_444, &bound);
+    *max_size = (size_t)bound;
+    return status;
+}
+
+static int jpeg_bench_encode(const bench_format* fmt, const uint8_t* raw, size_t raw_len,
+                             uint8_t* output, size_t output_len, size_t* size) {
+    (void)raw_len;
+    int actual = 0;
+    int status = jpeg_encode_to_buffer(raw, fmt->width, fmt->height, fmt->components,
+                                       output, (int)output_len, &actual, 90, JPEG_SAMP_444);
+    *size = (size_t)actual;
+    return status;
+}
+
+static int jpeg_bench_decode(const bench_format* fmt, const uint8_t* input, size_t input_len,
+                             uint8_t* output, size_t output_len) {
+    return jpeg_decode(input, (int)input_len, output, (int)output_len, NULL, NULL, NULL,
+                       fmt->components == 1 ? JPEG_CS_UNKNOWN : JPEG_CS_RGB);
+}
+
+/** Lossless, and single-threaded so frames scale across the pool instead */
+static const J2kEncodeParams j2k_params = { 1, 0.0f, 0.0f, 0, 0, 0, 0, J2K_FORMAT_J2K, 0, 0, 0, 0, 1 };
+static const J2kDecodeOptions j2k_options = { 0, 0, 1, NULL };
+
+static int j2k_bound(const bench_format* fmt, size_t* max_size) {
+    return j2k_get_encode_bound(fmt->width, fmt->height, fmt->components, fmt->bits, &j2k_params, max_size);
+}
+
+static int j2k_bench_encode(const bench_format* fmt, const uint8_t* raw, size_t raw_len,
+                            uint8_t* output, size_t output_len, size_t* size) {
+    return j2k_encode(raw, raw_len, fmt->width, fmt->height, fmt->components, fmt->bits, 0,
+                      &j2k_params, output, output_len, size);
+}
+
+static int j2k_bench_decode(const bench_format* fmt, const uint8_t* input, size_t input_len,
+                            uint8_t* output, size_t output_len) {
+    (void)fmt;
+    return j2k_decode(input, input_len, output, output_len, &j2k_options, NULL, NULL, NULL);
+}
+
+/* Same frames with the library's default worker count, against the single-threaded rows */
+static const J2kEncodeParams j2k_default_params = { 1, 0.0f, 0.0f, 0, 0, 0, 0, J2K_FORMAT_J2K, 0, 0, 0, 0, 0 };
+
+static int j2k_default_bench_encode(const bench_format* fmt, const uint8_t* raw, size_t raw_len,
+                                    uint8_t* output, size_t output_len, size_t* size) {
+    return j2k_encode(raw, raw_len, fmt->width, fmt->height, fmt->components, fmt->bits, 0,
+                      &j2k_default_params, output, output_len, size);
+}
+
+static int j2k_default_bench_decode(const bench_format* fmt, const uint8_t* input, size_t input_len,
+                                    uint8_t* output, size_t output_len) {
+    (void)fmt;
+    return j2k_decode(input, input_len, output, output_len, NULL, NULL, NULL, NULL);
+}
+
+static jls_encode_params_t jls_params_for(const bench_format* fmt) {
+    jls_encode_params_t params = {
+        fmt->width, fmt->height, fmt->components, fmt->bits, 0,
+        fmt->components == 1 ? JLS_INTERLEAVE_NONE : JLS_INTERLEAVE_SAMPLE
+    };
+    return params;
+}
+
+static int jls_bound(const bench_format* fmt, size_t* max_size) {
+    jls_encode_params_t params = jls_params_for(fmt);
+    return jls_get_encode_bound(&params, max_size);
+}
+
+static int jls_bench_encode(const bench_format* fmt, const uint8_t* raw, size_t raw_len,
+                            uint8_t* output, size_t output_len, size_t* size) {
+    jls_encode_params_t params = jls_params_for(fmt);
+    return jls_encode(raw, raw_len, output, output_len, size, &params);
+}
+
+static int jls_bench_decode(const bench_format* fmt, const uint8_t* input, size_t input_len,
+                            uint8_t* output, size_t output_len) {
+    (void)fmt;
+    return jls_decode(input, input_len, output, output_len, NULL);
+}
+
+static rle_params_t rle_params_for(const bench_format* fmt) {
+    rle_params_t params = {
+        fmt->width, fmt->height, fmt->components, fmt->bytes * 8, RLE_PLANAR_INTERLEAVED
+    };
+    return params;
+}
+
+static int rle_bound(const bench_format* fmt, size_t* max_size) {
+    rle_params_t params = rle_params_for(fmt);
+    return rle_get_encode_bound(&params, max_size);
+}
+
+static int rle_bench_encode(const bench_format* fmt, const uint8_t* raw, size_t raw_len,
+                            uint8_t* output, size_t output_len, size_t* size) {
+    rle_params_t params = rle_params_for(fmt);
+    return rle_encode(raw, raw_len, output, output_len, size, &params);
+}
+
+static int rle_bench_decode(const bench_format* fmt, const uint8_t* input, size_t input_len,
+                            uint8_t* output, size_t output_len) {
+    rle_params_t params = rle_params_for(fmt);
+    return rle_decode(input, input_len, output, output_len, &params);
+}
+
+static const bench_codec codecs[] = {
+    { "jpeg", SHARPDICOM_HAS_JPEG, 0, jpeg_bound, jpeg_bench_encode, jpeg_bench_decode },
+    { "j2k",  SHARPDICOM_HAS_J2K,  1, j2k_bound,  j2k_bench_encode,  j2k_bench_decode },
+    { "jls",  SHARPDICOM_HAS_JLS,  1, jls_bound,  jls_bench_encode,  jls_bench_decode },
+    { "rle",  SHARPDICOM_HAS_RLE,  1, rle_bound,  rle_bench_encode,  rle_bench_decode },
+    { "j2kdef", SHARPDICOM_HAS_J2K, 1, j2k_bound, j2k_default_bench_encode, j2k_default_bench_decode },
+};
+
+#define NUM_CODECS ((int)(sizeof(codecs) / sizeof(codecs[0])))
+
+/** Codec table entry for a probe_info_t codec, or NULL */
+static const bench_codec* codec_for_probe(int32_t codec) {
+    switch (codec) {
+        case BATCH_CODEC_JPEG:    return &codecs[0];
+        case BATCH_CODEC_J2K:     return &codecs[1];
+        case BATCH_CODEC_JPEG_LS: return &codecs[2];
+        default:                  return NULL;
+    }
+}
+
+/*============================================================================
+ * Timed runs
+ *============================================================================*/
+
+typedef struct {
+    const bench_codec* codec;
+    const bench_format* fmt;
+    int encode;
+    /** Raw frame for encode, compressed frame for decode */
+    const uint8_t* input;
+    size_t input_len;
+    /** One output buffer per worker */
+    uint8_t** outputs;
+    size_t output_len;
+    int per_worker;
+    /** workers * per_worker latencies in microseconds */
+    double* latency_us;
+    volatile int failures;
+} bench_run;
+
+static int run_one(bench_run* run, uint8_t* output) {
+    if (run->encode) {
+        size_t size = 0;
+        return run->codec->encode(run->fmt, run->input, run->input_len, output, run->output_len, &size);
+    }
+    return run->codec->decode(run->fmt, run->input, run->input_len, output, run->output_len);
+}
+
+static void run_worker(void* context, size_t index) {
+    bench_run* run = (bench_run*)context;
+    uint8_t* output = run->outputs[index];
+    for (int i = 0; i < run->per_worker; i++) {
+        double start = now_us();
+        int status = run_one(run, output);
+        run->latency_us[index * (size_t)run->per_worker + (size_t)i] = now_us() - start;
+        if (status != SHARPDICOM_OK) {
+            __atomic_fetch_add(&run->failures, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, size_t count, double q) {
+    size_t index = (size_t)(q * (double)(count - 1) + 0.5);
+    return sorted[index];
+}
+
+static void print_header(void) {
+    printf("%-6s %-6s %-16s %7s %6s %9s %9s %9s %9s %9s %7s\n",
+           "codec", "op", "frame", "threads", "frames", "MB/s", "fps",
+           "p50_us", "p90_us", "p99_us", "ratio");
+}
+
+/**
+ * Time one codec direction on every thread count and print a row each.
+ *
+ * @param compressed_len    Compressed frame size, for the ratio column
+ */
+static int bench_op(const bench_codec* codec, const bench_format* fmt, const char* label,
+                    int encode, const uint8_t* input, size_t input_len, size_t output_len,
+                    size_t compressed_len, const int* threads, int num_threads, int frames) {
+    uint8_t* outputs[THREAD_POOL_MAX_THREADS];
+    int max_workers = 1;
+    for (int t = 0; t < num_threads; t++) {
+        if (threads[t] > max_workers) {
+            max_workers = threads[t];
+        }
+    }
+    int allocated = 0;
+    for (; allocated < max_workers; allocated++) {
+        outputs[allocated] = (uint8_t*)malloc(output_len);
+        if (outputs[allocated] == NULL) {
+            break;
+        }
+    }
+    double* latency = (double*)malloc(sizeof(double) * ((size_t)frames + (size_t)max_workers));
+    if (allocated < max_workers || latency == NULL) {
+        fprintf(stderr, "%s: out of memory\n", codec->name);
+        for (int i = 0; i < allocated; i++) {
+            free(outputs[i]);
+        }
+        free(latency);
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    double raw_mb = (double)raw_size(fmt) / 1e6;
+    double ratio = compressed_len != 0 ? (double)raw_size(fmt) / (double)compressed_len : 0.0;
+    int result = SHARPDICOM_OK;
+
+    for (int t = 0; t < num_threads && result == SHARPDICOM_OK; t++) {
+        int workers = threads[t];
+        bench_run run = {
+            codec, fmt, encode, input, input_len, outputs, output_len,
+            (frames + workers - 1) / workers, latency, 0
+        };
+
+        /* Warm the thread's codec handles and caches outside the timing */
+        if (run_one(&run, outputs[0]) != SHARPDICOM_OK) {
+            fprintf(stderr, "%s %s %s: %s\n", codec->name, encode ? "encode" : "decode",
+                    label, sharpdicom_last_error());
+            result = SHARPDICOM_ERR_INTERNAL;
+            break;
+        }
+
+        double start = now_us();
+        thread_pool_parallel_for((size_t)workers, workers, run_worker, &run);
+        double elapsed = now_us() - start;
+
+        size_t count = (size_t)workers * (size_t)run.per_worker;
+        qsort(latency, count, sizeof(double), compare_double);
+        double fps = (double)count * 1e6 / elapsed;
+        printf("%-6s %-6s %-16s %7d %6zu %9.1f %9.1f %9.1f %9.1f %9.1f %7.2f%s\n",
+               codec->name, encode ? "encode" : "decode", label, workers, count,
+               fps * raw_mb, fps, percentile(latency, count, 0.50),
+               percentile(latency, count, 0.90), percentile(latency, count, 0.99), ratio,
+               run.failures != 0 ? "  (errors)" : "");
+    }
+
+    for (int i = 0; i < max_workers; i++) {
+        free(outputs[i]);
+    }
+    free(latency);
+    return result;
+}
+
+/*============================================================================
+ * Synthetic frames
+ *============================================================================*/
+
+/** Gradient plus a few bits of noise: compressible but not trivially */
+static void fill_frame(const bench_format* fmt, uint8_t* raw) {
+    uint32_t state = 0x9E3779B9u;
+    int32_t max_value = (1 << fmt->bits) - 1;
+    size_t i = 0;
+    for (int32_t y = 0; y < fmt->height; y++) {
+        for (int32_t x = 0; x < fmt->width; x++) {
+            for (int32_t c = 0; c < fmt->components; c++) {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                int32_t value = (int32_t)(((int64_t)(x + y + c * 64) * max_value) /
+                                          (fmt->width + fmt->height + 128));
+                value += (int32_t)(state & 7) - 4;
+                value = value < 0 ? 0 : (value > max_value ? max_value : value);
+                raw[i++] = (uint8_t)value;
+                if (fmt->bytes == 2) {
+                    raw[i++] = (uint8_t)(value >> 8);
+                }
+            }
+        }
+    }
+}
+
+static void bench_synthetic(const int* sizes, int num_sizes, const int* threads, int num_threads,
+                            int frames, int features) {
+    /* 12-bit grayscale (CT/MR-like) and 8-bit RGB (ultrasound/photo-like) */
+    static const bench_format shapes[] = {
+        { 0, 0, 1, 12, 2 },
+        { 0, 0, 3, 8, 1 },
+    };
+
+    for (int s = 0; s < num_sizes; s++) {
+        for (size_t f = 0; f < sizeof(shapes) / sizeof(shapes[0]); f++) {
+            bench_format fmt = shapes[f];
+            fmt.width = sizes[s];
+            fmt.height = sizes[s];
+            char label[32];
+            snprintf(label, sizeof(label), "%dx%dx%d/%d", fmt.width, fmt.height,
+                     fmt.components, fmt.bits);
+
+            size_t raw_len = raw_size(&fmt);
+            uint8_t* raw = (uint8_t*)malloc(raw_len);
+            if (raw == NULL) {
+                fprintf(stderr, "%s: out of memory\n", label);
+                continue;
+            }
+            fill_frame(&fmt, raw);
+
+            for (int c = 0; c < NUM_CODECS; c++) {
+                const bench_codec* codec = &codecs[c];
+                if ((features & codec->feature) == 0 || (fmt.bits > 8 && !codec->wide_samples)) {
+                    continue;
+                }
+
+                size_t bound = 0;
+                uint8_t* encoded = NULL;
+                size_t encoded_len = 0;
+                int status = codec->bound(&fmt, &bound);
+                if (status == SHARPDICOM_OK) {
+                    encoded = (uint8_t*)malloc(bound);
+                    status = encoded != NULL
+                        ? codec->encode(&fmt, raw, raw_len, encoded, bound, &encoded_len)
+                        : SHARPDICOM_ERR_OUT_OF_MEMORY;
+                }
+                if (status != SHARPDICOM_OK) {
+                    fprintf(stderr, "%s encode %s: %s\n", codec->name, label, sharpdicom_last_error());
+                    free(encoded);
+                    continue;
+                }
+
+                bench_op(codec, &fmt, label, 1, raw, raw_len, bound, encoded_len,
+                         threads, num_threads, frames);
+                bench_op(codec, &fmt, label, 0, encoded, encoded_len, raw_len, encoded_len,
+                         threads, num_threads, frames);
+                free(encoded);
+            }
+            free(raw);
+        }
+    }
+}
+
+/*============================================================================
+ * Reference corpus
+ *============================================================================*/
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    uint8_t* data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long length = ftell(file);
+        if (length > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = (uint8_t*)malloc((size_t)length);
+            if (data != NULL && fread(data, 1, (size_t)length, file) != (size_t)length) {
+                free(data);
+                data = NULL;
+            }
+            *size = (size_t)length;
+        }
+    }
+    fclose(file);
+    return data;
+}
+
+static void bench_corpus(char** paths, int num_paths, const int* threads, int num_threads,
+                         int frames, int features) {
+    for (int p = 0; p < num_paths; p++) {
+        size_t size = 0;
+        uint8_t* data = read_file(paths[p], &size);
+        if (data == NULL) {
+            fprintf(stderr, "%s: cannot read\n", paths[p]);
+            continue;
+        }
+
+        probe_info_t info;
+        const bench_codec* codec = NULL;
+        if (probe_frame(data, size, &info) == SHARPDICOM_OK) {
+            codec = codec_for_probe(info.codec);
+        }
+        if (codec == NULL || (features & codec->feature) == 0 || info.height <= 0 ||
+            (info.bits_per_sample > 8 && !codec->wide_samples)) {
+            fprintf(stderr, "%s: not a decodable JPEG, JPEG-LS or JPEG 2000 frame\n", paths[p]);
+            free(data);
+            continue;
+        }
+
+        bench_format fmt = {
+            info.width, info.height, info.num_components, info.bits_per_sample,
+            info.bits_per_sample > 8 ? 2 : 1
+        };
+        const char* name = strrchr(paths[p], '/');
+        char label[32];
+        snprintf(label, sizeof(label), "%.16s", name != NULL ? name + 1 : paths[p]);
+
+        bench_op(codec, &fmt, label, 0, data, size, raw_size(&fmt), size,
+                 threads, num_threads, frames);
+        free(data);
+    }
+}
+
+/*============================================================================
+ * Statistics
+ *============================================================================*/
+
+static void print_stats(void) {
+    static const char* const names[SHARPDICOM_STATS_CODECS] = {
+        "jpeg", "j2k", "jls", "rle", "video", "deflate"
+    };
+
+    sharpdicom_stats_t stats;
+    if (sharpdicom_get_stats(&stats) != SHARPDICOM_OK) {
+        return;
+    }
+
+    printf("\n%-8s %-6s %9s %7s %11s %11s %11s\n",
+           "codec", "op", "calls", "errors", "MB_in", "MB_out", "ms");
+    for (int c = 0; c < SHARPDICOM_STATS_CODECS; c++) {
+        for (int op = 0; op < 2; op++) {
+            const sharpdicom_op_stats_t* s = op == 0 ? &stats.codecs[c].decode : &stats.codecs[c].encode;
+            if (s->calls == 0) {
+                continue;
+            }
+            printf("%-8s %-6s %9llu %7llu %11.1f %11.1f %11.1f\n",
+                   names[c], op == 0 ? "decode" : "encode",
+                   (unsigned long long)s->calls, (unsigned long long)s->errors,
+                   (double)s->bytes_in / 1e6, (double)s->bytes_out / 1e6, (double)s->time_ns / 1e6);
+        }
+    }
+    printf("GPU dispatch: %llu GPU, %llu CPU, %llu fallbacks, %llu queue overflows\n",
+           (unsigned long long)stats.gpu_frames, (unsigned long long)stats.cpu_frames,
+           (unsigned long long)stats.gpu_fallbacks, (unsigned long long)stats.gpu_queue_overflows);
+}
+
+/*============================================================================
+ * Main
+ *============================================================================*/
+
+/** Parse a comma-separated list of positive integers; returns the count, 0 if invalid */
+static int parse_list(const char* text, int* values, int max_values, int max_value) {
+    int count = 0;
+    while (*text != '\0' && count < max_values) {
+        char* end = NULL;
+        long value = strtol(text, &end, 10);
+        if (end == text || value <= 0 || value > max_value || (*end != ',' && *end != '\0')) {
+            return 0;
+        }
+        values[count++] = (int)value;
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return count;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "Usage: sharpdicom_bench [-n frames] [-t threads,...] [-s sizes,...] [files...]\n"
+            "  -n  Frames per measurement (default %d)\n"
+            "  -t  Thread counts (default 1 and all pool threads)\n"
+            "  -s  Synthetic frame sizes in pixels (default 256,512,1024)\n"
+            "  files  Compressed JPEG, JPEG-LS or JPEG 2000 frames to decode instead\n",
+            DEFAULT_FRAMES);
+}
+
+int main(int argc, char** argv) {
+    int frames = DEFAULT_FRAMES;
+    int threads[MAX_LIST];
+    int num_threads = 0;
+    int sizes[MAX_LIST] = { 256, 512, 1024 };
+    int num_sizes = 3;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        const char* value = (arg + 1 < argc) ? argv[arg + 1] : "";
+        if (strcmp(argv[arg], "-n") == 0) {
+            frames = atoi(value);
+        } else if (strcmp(argv[arg], "-t") == 0) {
+            num_threads = parse_list(value, threads, MAX_LIST, THREAD_POOL_MAX_THREADS);
+        } else if (strcmp(argv[arg], "-s") == 0) {
+            num_sizes = parse_list(value, sizes, MAX_LIST, 16384);
+        } else {
+            usage();
+            return 2;
+        }
+        if (frames <= 0 || (strcmp(argv[arg], "-t") == 0 && num_threads == 0) || num_sizes == 0) {
+            usage();
+            return 2;
+        }
+        arg++;
+    }
+
+    if (num_threads == 0) {
+        threads[num_threads++] = 1;
+        int32_t pool = thread_pool_concurrency();
+        if (pool > 1) {
+            threads[num_threads++] = pool;
+        }
+    }
+
+    int features = sharpdicom_features();
+    printf("=== SharpDicom Native Codec Benchmark ===\n");
+    printf("Version %d, features 0x%x, SIMD 0x%x, %d pool threads\n\n",
+           sharpdicom_version(), features, sharpdicom_simd_features(), thread_pool_concurrency());
+
+    sharpdicom_reset_stats();
+    print_header();
+    if (arg < argc) {
+        bench_corpus(argv + arg, argc - arg, threads, num_threads, frames, features);
+    } else {
+        bench_synthetic(sizes, num_sizes, threads, num_threads, frames, features);
+    }
+    print_stats();
+    return 0;
+}
@@ -8,6 +8,8 @@ const std = @import("std");
 /// - OpenJPEG: vendor/openjpeg/src (downloaded in CI)
 /// - CharLS: vendor/charls/src (downloaded in CI)
 /// - FFmpeg: vendor/ffmpeg/src (downloaded in CI)
+/// - zlib-ng: vendor/zlib-ng/src (downloaded in CI)
+/// - OpenJPH: vendor/openjph/src (downloaded in CI, HTJ2K encode)
 pub fn build(b: *std.Build) void {
     // All vendor libraries disabled for Phase 13a - building stubs only.
     // Cross-compilation of vendor libraries requires proper sysroot setup.
@@ -16,6 +18,8 @@ pub fn build(b: *std.Build) void {
     const have_openjpeg = false; // Needs CMake-generated config + sysroot
     const have_charls = false;
     const have_ffmpeg = false;
+    const have_zlibng = false; // Native API build (ZLIB_COMPAT=OFF), runtime CPU detection
+    const have_openjph = false; // HTJ2K encode (C++); only used together with OpenJPEG
     // Target configurations for all supported platforms
     // Using GNU ABI for Windows for better Zig cross-compilation support
     const targets = [_]std.Target.Query{
@@ -82,6 +86,16 @@ pub fn build(b: *std.Build) void {
             "-Werror",
         };
 
+        // C++ flags for the OpenJPH shim
+        const cpp_flags = &[_][]const u8{
+            "-std=c++17",
+            "-fstack-protector-strong",
+            "-D_FORTIFY_SOURCE=2",
+            "-Wall",
+            "-Wextra",
+            "-Werror",
+        };
+
         // Feature flags (only defined when corresponding library is available)
         const jpeg_flags = common_flags ++ &[_][]const u8{
             "-DSHARPDICOM_WITH_JPEG",
@@ -114,12 +128,13 @@ pub fn build(b: *std.Build) void {
 
         // J2K wrapper (OpenJPEG)
         if (have_openjpeg) {
+            const j2k_flags = common_flags ++ &[_][]const u8{
+                "-DSHARPDICOM_HAS_OPENJPEG",
+                "-DSHARPDICOM_WITH_J2K",
+            };
             lib.addCSourceFile(.{
                 .file = b.path("src/j2k_wrapper.c"),
-                .flags = common_flags ++ &[_][]const u8{
-                    "-DSHARPDICOM_HAS_OPENJPEG",
-                    "-DSHARPDICOM_WITH_J2K",
-                },
+                .flags = if (have_openjph) j2k_flags ++ &[_][]const u8{"-DSHARPDICOM_HAS_OPENJPH"} else j2k_flags,
             });
 
             // Add OpenJPEG include path
@@ -127,6 +142,23 @@ pub fn build(b: *std.Build) void {
 
             // Add OpenJPEG source files needed for compilation
             addOpenJpegSources(lib, b, common_flags);
+
+            // OpenJPEG allocation hooks on the library allocator (in place of opj_malloc.c)
+            lib.addCSourceFile(.{
+                .file = b.path("src/opj_alloc.c"),
+                .flags = j2k_flags,
+            });
+
+            // HTJ2K encoder shim (OpenJPH, C++)
+            if (have_openjph) {
+                lib.addCSourceFile(.{
+                    .file = b.path("src/htj2k_encoder.cpp"),
+                    .flags = cpp_flags,
+                });
+                lib.addIncludePath(b.path("vendor/openjph/src/src/core"));
+                lib.linkSystemLibrary("openjph");
+                lib.linkLibCpp();
+            }
         } else {
             // Build stub version
             lib.addCSourceFile(.{
@@ -141,6 +173,62 @@ pub fn build(b: *std.Build) void {
             .flags = common_flags,
         });
 
+        // Pixel conversion kernels (SIMD selected at runtime, no -m flags needed)
+        lib.addCSourceFile(.{
+            .file = b.path("src/pixel_convert.c"),
+            .flags = common_flags,
+        });
+
+        // Window / VOI LUT display conversion (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/display.c"),
+            .flags = common_flags,
+        });
+
+        // RLE codec (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/rle_wrapper.c"),
+            .flags = common_flags,
+        });
+
+        // J2K codestream scanner for progressive decode (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/j2k_codestream.c"),
+            .flags = common_flags,
+        });
+
+        // Memory allocator with per-thread block cache (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/allocator.c"),
+            .flags = common_flags,
+        });
+
+        // Per-codec call, byte and time counters (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/codec_stats.c"),
+            .flags = common_flags,
+        });
+
+        // Shared worker pool, multi-frame batch decode and transcode (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/thread_pool.c"),
+            .flags = common_flags,
+        });
+        lib.addCSourceFile(.{
+            .file = b.path("src/batch_decode.c"),
+            .flags = common_flags,
+        });
+        lib.addCSourceFile(.{
+            .file = b.path("src/transcode.c"),
+            .flags = common_flags,
+        });
+
+        // Header-only frame probe (native, no external dependency)
+        lib.addCSourceFile(.{
+            .file = b.path("src/probe.c"),
+            .flags = common_flags,
+        });
+
         // JLS wrapper (CharLS)
         if (have_charls) {
             lib.addCSourceFile(.{
@@ -186,6 +274,27 @@ pub fn build(b: *std.Build) void {
             });
         }
 
+        // Deflate wrapper (zlib-ng)
+        if (have_zlibng) {
+            lib.addCSourceFile(.{
+                .file = b.path("src/deflate_wrapper.c"),
+                .flags = common_flags ++ &[_][]const u8{
+                    "-DSHARPDICOM_HAS_ZLIBNG",
+                    "-DSHARPDICOM_WITH_DEFLATE",
+                },
+            });
+            // Add zlib-ng include path (zlib-ng.h is generated by its CMake configure)
+            lib.addIncludePath(b.path("vendor/zlib-ng/src"));
+            // Link against zlib-ng; its SIMD kernels are selected at runtime
+            lib.linkSystemLibrary("z-ng");
+        } else {
+            // Build stub version (deflate functions will error at runtime)
+            lib.addCSourceFile(.{
+                .file = b.path("src/deflate_wrapper.c"),
+                .flags = common_flags,
+            });
+        }
+
         // Include paths
         lib.addIncludePath(b.path("src"));
 
@@ -202,101 +311,85 @@ pub fn build(b: *std.Build) void {
         b.getInstallStep().dependOn(&install_step.step);
     }
 
-    // Native test executable (for local platform only)
+    // Native test executables (for local platform only)
     const native_target = b.standardTargetOptions(.{});
-    const test_exe = b.addExecutable(.{
-        .name = "test_version",
-        .target = native_target,
-        .optimize = optimize,
-    });
+    const test_flags = &[_][]const u8{
+        "-std=c11",
+        "-Wall",
+        "-Wextra",
+    };
 
-    // Link libc for standard library headers
-    test_exe.linkLibC();
+    // Library sources linked into every test, built as stubs (without vendor
+    // libraries for simplicity)
+    const test_lib_sources = [_][]const u8{
+        "src/sharpdicom_codecs.c",
+        "src/jpeg_wrapper.c",
+        "src/j2k_wrapper.c",
+        "src/gpu_wrapper.c",
+        "src/jls_wrapper.c",
+        "src/video_wrapper.c",
+        "src/pixel_convert.c",
+        "src/display.c",
+        "src/rle_wrapper.c",
+        "src/deflate_wrapper.c",
+        "src/j2k_codestream.c",
+        "src/allocator.c",
+        "src/codec_stats.c",
+        "src/thread_pool.c",
+        "src/batch_decode.c",
+        "src/transcode.c",
+        "src/probe.c",
+    };
 
-    test_exe.addCSourceFile(.{
-        .file = b.path("test/test_version.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+    const test_names = [_][]const u8{
+        "test_version",
+        "test_pixel_convert",
+        "test_rle",
+        "test_j2k_codestream",
+        "test_thread_pool",
+        "test_transcode",
+        "test_probe",
+        "test_allocator",
+    };
 
-    test_exe.addIncludePath(b.path("src"));
+    // Test step
+    const test_step = b.step("test", "Run native tests");
 
-    // Link against the native platform's library
-    test_exe.addCSourceFile(.{
-        .file = b.path("src/sharpdicom_codecs.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+    for (test_names) |test_name| {
+        const test_exe = b.addExecutable(.{
+            .name = test_name,
+            .target = native_target,
+            .optimize = optimize,
+        });
 
-    // Add jpeg_wrapper stub for tests (without libjpeg-turbo for simplicity)
-    test_exe.addCSourceFile(.{
-        .file = b.path("src/jpeg_wrapper.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+        // Link libc for standard library headers
+        test_exe.linkLibC();
 
-    // Add j2k_wrapper stub for tests (without OpenJPEG for simplicity)
-    test_exe.addCSourceFile(.{
-        .file = b.path("src/j2k_wrapper.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+        test_exe.addCSourceFile(.{
+            .file = b.path(b.fmt("test/{s}.c", .{test_name})),
+            .flags = test_flags,
+        });
 
-    // Add gpu_wrapper for tests
-    test_exe.addCSourceFile(.{
-        .file = b.path("src/gpu_wrapper.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+        for (test_lib_sources) |src| {
+            test_exe.addCSourceFile(.{
+                .file = b.path(src),
+                .flags = test_flags,
+            });
+        }
 
-    // Add jls_wrapper stub for tests (without CharLS for simplicity)
-    test_exe.addCSourceFile(.{
-        .file = b.path("src/jls_wrapper.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+        test_exe.addIncludePath(b.path("src"));
 
-    // Add video_wrapper stub for tests (without FFmpeg for simplicity)
-    test_exe.addCSourceFile(.{
-        .file = b.path("src/video_wrapper.c"),
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-        },
-    });
+        // Link -ldl on Linux for dynamic library loading
+        if (native_target.result.os.tag == .linux) {
+            test_exe.linkSystemLibrary("dl");
+        }
 
-    // Link -ldl on Linux for dynamic library loading
-    if (native_target.result.os.tag == .linux) {
-        test_exe.linkSystemLibrary("dl");
+        const test_install = b.addInstallArtifact(test_exe, .{});
+        const run_test = b.addRunArtifact(test_exe);
+        test_step.dependOn(&test_install.step);
+        test_step.dependOn(&run_test.step);
     }
 
-    const test_install = b.addInstallArtifact(test_exe, .{});
-
-    // Test step
-    const test_step = b.step("test", "Run native tests");
-    const run_test = b.addRunArtifact(test_exe);
-    test_step.dependOn(&test_install.step);
-    test_step.dependOn(&run_test.step);
-
     // Single-platform build step (for development)
     const single_step = b.step("native", "Build for native platform only");
     const native_lib = b.addSharedLibrary(.{
@@ -316,9 +409,64 @@ pub fn build(b: *std.Build) void {
         "-Wextra",
         "-Werror",
     };
+    const native_vendors = VendorLibraries{
+        .libjpeg = have_libjpeg,
+        .openjpeg = have_openjpeg,
+        .charls = have_charls,
+        .ffmpeg = have_ffmpeg,
+        .zlibng = have_zlibng,
+        .openjph = have_openjph,
+    };
+
+    addNativeLibrarySources(native_lib, b, native_flags, native_vendors);
 
+    const native_install = b.addInstallArtifact(native_lib, .{});
+    single_step.dependOn(&native_install.step);
+
+    // Benchmark step: `zig build bench -Doptimize=ReleaseFast -- [options] [files...]`
+    // Built from the same sources and vendor libraries as the native library,
+    // so it measures every codec that build provides
+    const bench_step = b.step("bench", "Run the native codec benchmark");
+    const bench_exe = b.addExecutable(.{
+        .name = "sharpdicom_bench",
+        .target = native_target,
+        .optimize = optimize,
+    });
+    bench_exe.linkLibC();
+    bench_exe.addCSourceFile(.{
+        .file = b.path("bench/sharpdicom_bench.c"),
+        .flags = native_flags,
+    });
+    addNativeLibrarySources(bench_exe, b, native_flags, native_vendors);
+    const bench_install = b.addInstallArtifact(bench_exe, .{});
+    const run_bench = b.addRunArtifact(bench_exe);
+    if (b.args) |args| {
+        run_bench.addArgs(args);
+    }
+    bench_step.dependOn(&bench_install.step);
+    bench_step.dependOn(&run_bench.step);
+}
+
+/// Vendor libraries compiled into the native-platform builds
+const VendorLibraries = struct {
+    libjpeg: bool,
+    openjpeg: bool,
+    charls: bool,
+    ffmpeg: bool,
+    zlibng: bool,
+    openjph: bool,
+};
+
+/// Add the library sources, vendor libraries and feature flags of the
+/// native-platform build to a compile step (the library or the benchmark)
+fn addNativeLibrarySources(
+    native_lib: *std.Build.Step.Compile,
+    b: *std.Build,
+    comptime native_flags: []const []const u8,
+    comptime vendors: VendorLibraries,
+) void {
     // Native flags with JPEG enabled (only when libjpeg is available)
-    const native_jpeg_flags = if (have_libjpeg)
+    const native_jpeg_flags = if (vendors.libjpeg)
         native_flags ++ &[_][]const u8{"-DSHARPDICOM_WITH_JPEG"}
     else
         native_flags;
@@ -329,7 +477,7 @@ pub fn build(b: *std.Build) void {
     });
 
     // JPEG wrapper for native build
-    if (have_libjpeg) {
+    if (vendors.libjpeg) {
         native_lib.addCSourceFile(.{
             .file = b.path("src/jpeg_wrapper.c"),
             .flags = native_jpeg_flags,
@@ -344,16 +492,30 @@ pub fn build(b: *std.Build) void {
     }
 
     // J2K wrapper for native build
-    if (have_openjpeg) {
+    if (vendors.openjpeg) {
+        const native_j2k_flags = native_flags ++ &[_][]const u8{
+            "-DSHARPDICOM_HAS_OPENJPEG",
+            "-DSHARPDICOM_WITH_J2K",
+        };
         native_lib.addCSourceFile(.{
             .file = b.path("src/j2k_wrapper.c"),
-            .flags = native_flags ++ &[_][]const u8{
-                "-DSHARPDICOM_HAS_OPENJPEG",
-                "-DSHARPDICOM_WITH_J2K",
-            },
+            .flags = if (vendors.openjph) native_j2k_flags ++ &[_][]const u8{"-DSHARPDICOM_HAS_OPENJPH"} else native_j2k_flags,
         });
         native_lib.addIncludePath(b.path("vendor/openjpeg/src/src/lib/openjp2"));
         addOpenJpegSources(native_lib, b, native_flags);
+        native_lib.addCSourceFile(.{
+            .file = b.path("src/opj_alloc.c"),
+            .flags = native_j2k_flags,
+        });
+        if (vendors.openjph) {
+            native_lib.addCSourceFile(.{
+                .file = b.path("src/htj2k_encoder.cpp"),
+                .flags = &[_][]const u8{ "-std=c++17", "-fstack-protector-strong", "-Wall", "-Wextra", "-Werror" },
+            });
+            native_lib.addIncludePath(b.path("vendor/openjph/src/src/core"));
+            native_lib.linkSystemLibrary("openjph");
+            native_lib.linkLibCpp();
+        }
     } else {
         native_lib.addCSourceFile(.{
             .file = b.path("src/j2k_wrapper.c"),
@@ -367,8 +529,64 @@ pub fn build(b: *std.Build) void {
         .flags = native_flags,
     });
 
+    // Pixel conversion kernels for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/pixel_convert.c"),
+        .flags = native_flags,
+    });
+
+    // Display conversion for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/display.c"),
+        .flags = native_flags,
+    });
+
+    // RLE codec for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/rle_wrapper.c"),
+        .flags = native_flags,
+    });
+
+    // J2K codestream scanner for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/j2k_codestream.c"),
+        .flags = native_flags,
+    });
+
+    // Memory allocator for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/allocator.c"),
+        .flags = native_flags,
+    });
+
+    // Codec statistics for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/codec_stats.c"),
+        .flags = native_flags,
+    });
+
+    // Worker pool, batch decode and transcode for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/thread_pool.c"),
+        .flags = native_flags,
+    });
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/batch_decode.c"),
+        .flags = native_flags,
+    });
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/transcode.c"),
+        .flags = native_flags,
+    });
+
+    // Header-only frame probe for native build
+    native_lib.addCSourceFile(.{
+        .file = b.path("src/probe.c"),
+        .flags = native_flags,
+    });
+
     // JLS wrapper for native build
-    if (have_charls) {
+    if (vendors.charls) {
         native_lib.addCSourceFile(.{
             .file = b.path("src/jls_wrapper.c"),
             .flags = native_flags ++ &[_][]const u8{
@@ -387,7 +605,7 @@ pub fn build(b: *std.Build) void {
     }
 
     // Video wrapper for native build
-    if (have_ffmpeg) {
+    if (vendors.ffmpeg) {
         native_lib.addCSourceFile(.{
             .file = b.path("src/video_wrapper.c"),
             .flags = native_flags ++ &[_][]const u8{
@@ -406,15 +624,30 @@ pub fn build(b: *std.Build) void {
         });
     }
 
+    // Deflate wrapper for native build
+    if (vendors.zlibng) {
+        native_lib.addCSourceFile(.{
+            .file = b.path("src/deflate_wrapper.c"),
+            .flags = native_flags ++ &[_][]const u8{
+                "-DSHARPDICOM_HAS_ZLIBNG",
+                "-DSHARPDICOM_WITH_DEFLATE",
+            },
+        });
+        native_lib.addIncludePath(b.path("vendor/zlib-ng/src"));
+        native_lib.linkSystemLibrary("z-ng");
+    } else {
+        native_lib.addCSourceFile(.{
+            .file = b.path("src/deflate_wrapper.c"),
+            .flags = native_flags,
+        });
+    }
+
     native_lib.addIncludePath(b.path("src"));
 
     // Link -ldl on Linux for dynamic library loading
-    if (native_target.result.os.tag == .linux) {
+    if (native_lib.rootModuleTarget().os.tag == .linux) {
         native_lib.linkSystemLibrary("dl");
     }
-
-    const native_install = b.addInstallArtifact(native_lib, .{});
-    single_step.dependOn(&native_install.step);
 }
 
 /// Maps Zig target to .NET Runtime Identifier
@@ -470,7 +703,7 @@ fn addOpenJpegSources(lib: *std.Build.Step.Compile, b: *std.Build, _: []const []
         "mqc.c",
         "openjpeg.c",
         "opj_clock.c",
-        "opj_malloc.c",
+        // opj_malloc.c is replaced by src/opj_alloc.c
         "pi.c",
         "sparse_array.c",
         "t1.c",
@@ -496,11 +729,18 @@ fn addOpenJpegSources(lib: *std.Build.Step.Compile, b: *std.Build, _: []const []
         "-DUSE_JPIP=0",
     };
 
+    // thread.c only provides a real worker pool when a mutex backend is selected;
+    // without one opj_has_thread_support() is false and decoding stays single-threaded
+    const opj_thread_flags = if (lib.rootModuleTarget().os.tag == .windows)
+        opj_flags ++ &[_][]const u8{"-DMUTEX_win32"}
+    else
+        opj_flags ++ &[_][]const u8{"-DMUTEX_pthread"};
+
     for (opj_sources) |src| {
         const full_path = std.fmt.allocPrint(b.allocator, "{s}/{s}", .{ opj_base, src }) catch continue;
         lib.addCSourceFile(.{
             .file = b.path(full_path),
-            .flags = opj_flags,
+            .flags = opj_thread_flags,
         });
     }
 
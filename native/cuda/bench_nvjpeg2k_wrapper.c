@@ -0,0 +1,242 @@
+/**
+ * Benchmark for nvJPEG2000 Wrapper
+ *
+ * Decodes each JPEG 2000 codestream given on the command line on the GPU,
+ * one frame per call and in nvj2k_decode_batch() batches, and reports
+ * throughput and per-frame latency percentiles.
+ *
+ * Usage: bench_nvjpeg2k_wrapper [-n frames] [-b batch,...] files...
+ */
+
+/* clock_gettime() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "nvjpeg2k_wrapper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define MAX_BATCHES 8
+#define DEFAULT_FRAMES 64
+
+static double now_us(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+#endif
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double q) {
+    return sorted[(int)(q * (double)(count - 1) + 0.5)];
+}
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    uint8_t* data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long length = ftell(file);
+        if (length > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data = (uint8_t*)malloc((size_t)length);
+            if (data != NULL && fread(data, 1, (size_t)length, file) != (size_t)length) {
+                free(data);
+                data = NULL;
+            }
+            *size = (size_t)length;
+        }
+    }
+    fclose(file);
+    return data;
+}
+
+/** Decoded size of a codestream, from a decode into pooled device memory */
+static int decoded_size(const uint8_t* input, size_t input_len, size_t* size) {
+    nvj2k_device_result_t result;
+    nvj2k_device_image_t* image = NULL;
+    int status = nvj2k_decode_to_device(-1, input, input_len, NULL, 0, NULL, &result, &image);
+    if (status == NVJ2K_OK) {
+        *size = result.output_size;
+    }
+    nvj2k_release_device_image(image);
+    return status;
+}
+
+static void print_row(const char* label, const char* mode, int batch, int count,
+                      double elapsed_us, double* latency, size_t raw_size, size_t input_len) {
+    qsort(latency, (size_t)count, sizeof(double), compare_double);
+    double fps = (double)count * 1e6 / elapsed_us;
+    printf("%-16s %-6s %5d %6d %9.1f %9.1f %9.1f %9.1f %9.1f %7.2f\n",
+           label, mode, batch, count, fps * (double)raw_size / 1e6, fps,
+           percentile(latency, count, 0.50), percentile(latency, count, 0.90),
+           percentile(latency, count, 0.99), (double)raw_size / (double)input_len);
+}
+
+static int bench_file(const char* path, int frames, const int* batches, int num_batches) {
+    size_t input_len = 0;
+    uint8_t* input = read_file(path, &input_len);
+    if (input == NULL) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return 1;
+    }
+
+    const char* name = strrchr(path, '/');
+    char label[32];
+    snprintf(label, sizeof(label), "%.16s", name != NULL ? name + 1 : path);
+
+    size_t raw_size = 0;
+    if (decoded_size(input, input_len, &raw_size) != NVJ2K_OK) {
+        fprintf(stderr, "%s: %s\n", path, nvj2k_last_error());
+        free(input);
+        return 1;
+    }
+
+    int max_batch = 1;
+    for (int i = 0; i < num_batches; i++) {
+        if (batches[i] > max_batch) {
+            max_batch = batches[i];
+        }
+    }
+
+    const uint8_t** inputs = (const uint8_t**)malloc(sizeof(*inputs) * (size_t)max_batch);
+    size_t* input_lens = (size_t*)malloc(sizeof(*input_lens) * (size_t)max_batch);
+    uint8_t** outputs = (uint8_t**)calloc((size_t)max_batch, sizeof(*outputs));
+    size_t* output_lens = (size_t*)malloc(sizeof(*output_lens) * (size_t)max_batch);
+    nvj2k_batch_result_t* results = (nvj2k_batch_result_t*)malloc(sizeof(*results) * (size_t)max_batch);
+    double* latency = (double*)malloc(sizeof(double) * (size_t)(frames + max_batch));
+    int ok = inputs && input_lens && outputs && output_lens && results && latency;
+    for (int i = 0; ok && i < max_batch; i++) {
+        inputs[i] = input;
+        input_lens[i] = input_len;
+        output_lens[i] = raw_size;
+        outputs[i] = (uint8_t*)malloc(raw_size);
+        ok = (outputs[i] != NULL);
+    }
+
+    int failures = 0;
+    if (ok) {
+        /* Single frames: latency is the full call, including the copy back */
+        nvj2k_decode_result_t result;
+        nvj2k_decode(input, input_len, outputs[0], raw_size, NULL, &result);
+        double start = now_us();
+        for (int i = 0; i < frames; i++) {
+            double t0 = now_us();
+            failures += nvj2k_decode(input, input_len, outputs[0], raw_size, NULL, &result) != NVJ2K_OK;
+            latency[i] = now_us() - t0;
+        }
+        print_row(label, "single", 1, frames, now_us() - start, latency, raw_size, input_len);
+
+        /* Batches: each frame's latency is the batch time over its frames */
+        for (int b = 0; b < num_batches; b++) {
+            int batch = batches[b];
+            int calls = (frames + batch - 1) / batch;
+            nvj2k_decode_batch(inputs, input_lens, outputs, output_lens, batch, NULL, results);
+            start = now_us();
+            for (int c = 0; c < calls; c++) {
+                double t0 = now_us();
+                failures += batch - nvj2k_decode_batch(inputs, input_lens, outputs, output_lens,
+                                                       batch, NULL, results);
+                double per_frame = (now_us() - t0) / batch;
+                for (int i = 0; i < batch; i++) {
+                    latency[c * batch + i] = per_frame;
+                }
+            }
+            print_row(label, "batch", batch, calls * batch, now_us() - start, latency, raw_size, input_len);
+        }
+    } else {
+        fprintf(stderr, "%s: out of memory\n", path);
+    }
+    if (failures != 0) {
+        fprintf(stderr, "%s: %d decodes failed: %s\n", path, failures, nvj2k_last_error());
+    }
+
+    for (int i = 0; outputs != NULL && i < max_batch; i++) {
+        free(outputs[i]);
+    }
+    free((void*)inputs);
+    free(input_lens);
+    free(outputs);
+    free(output_lens);
+    free(results);
+    free(latency);
+    free(input);
+    return (ok && failures == 0) ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    int frames = DEFAULT_FRAMES;
+    int batches[MAX_BATCHES] = { 4, 16 };
+    int num_batches = 2;
+
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "-n") == 0) {
+            frames = atoi(argv[arg + 1]);
+        } else if (strcmp(argv[arg], "-b") == 0) {
+            num_batches = 0;
+            for (char* item = strtok(argv[arg + 1], ","); item != NULL && num_batches < MAX_BATCHES;
+                 item = strtok(NULL, ",")) {
+                int batch = atoi(item);
+                if (batch > 0) {
+                    batches[num_batches++] = batch;
+                }
+            }
+        } else {
+            break;
+        }
+    }
+    if (arg >= argc || frames <= 0 || argv[arg][0] == '-') {
+        fprintf(stderr, "Usage: bench_nvjpeg2k_wrapper [-n frames] [-b batch,...] files...\n");
+        return 2;
+    }
+
+    if (nvj2k_init(-1) != NVJ2K_OK) {
+        fprintf(stderr, "nvJPEG2000 unavailable: %s\n", nvj2k_last_error());
+        return 1;
+    }
+
+    nvj2k_device_info_t info;
+    if (nvj2k_get_device_info(&info) == NVJ2K_OK) {
+        printf("Device %d: %s (compute %d.%d)\n\n", info.device_id, info.name,
+               info.compute_major, info.compute_minor);
+    }
+
+    printf("%-16s %-6s %5s %6s %9s %9s %9s %9s %9s %7s\n",
+           "frame", "mode", "batch", "frames", "MB/s", "fps", "p50_us", "p90_us", "p99_us", "ratio");
+    int failed = 0;
+    for (; arg < argc; arg++) {
+        failed |= bench_file(argv[arg], frames, batches, num_batches);
+    }
+
+    nvj2k_pool_stats_t pool;
+    if (nvj2k_get_pool_stats(&pool) == NVJ2K_OK) {
+        printf("\nPools: device %llu hits / %llu misses, pinned %llu hits / %llu misses\n",
+               (unsigned long long)pool.device_hits, (unsigned long long)pool.device_misses,
+               (unsigned long long)pool.pinned_hits, (unsigned long long)pool.pinned_misses);
+    }
+
+    nvj2k_shutdown();
+    return failed;
+}
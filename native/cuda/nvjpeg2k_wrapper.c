@@ -5,6 +5,15 @@
  * GPU-accelerated JPEG 2000 decoding. It manages CUDA contexts, streams,
  * and nvJPEG2000 handles with thread-safe initialization.
  *
+ * Several GPUs can be driven at once: each initialized device has its own
+ * nvJPEG2000 handle, streams, decode state and memory pool, and frames are
+ * spread across devices by queue depth and free memory.
+ *
+ * Each host thread decodes with its own nvJPEG2000 decode state and CUDA
+ * stream, bound to the device's shared handle, so concurrent callers keep
+ * a GPU busy without contending on a lock. The global lock guards only
+ * initialization and bookkeeping that happens once per thread.
+ *
  * Build: nvcc -shared -o nvjpeg2k_wrapper.so nvjpeg2k_wrapper.c -lnvjpeg2k -lcudart
  */
 
@@ -12,6 +21,7 @@
 #include "nvjpeg2k_wrapper.h"
 #include "../src/sharpdicom_codecs.h"
 
+#include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -49,12 +59,14 @@ static void set_error(const char* msg) {
     }
 }
 
+#ifdef HAVE_NVJPEG2K
 static void set_error_fmt(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
     vsnprintf(tls_error, sizeof(tls_error), fmt, args);
     va_end(args);
 }
+#endif
 
 /*============================================================================
  * Global state (protected by mutex/critical section)
@@ -62,21 +74,7 @@ static void set_error_fmt(const char* fmt, ...) {
 
 #ifdef HAVE_NVJPEG2K
 
-/* Initialization state */
-static volatile int g_initialized = 0;
-static int g_device_id = -1;
-
-/* CUDA objects */
-static cudaStream_t g_stream = NULL;
-
-/* nvJPEG2000 handles */
-static nvjpeg2kHandle_t g_handle = NULL;
-static nvjpeg2kDecodeState_t g_state = NULL;
-
-/* Device info cache */
-static nvj2k_device_info_t g_device_info = {0};
-
-/* Mutex for thread-safe initialization */
+/* Mutex for thread-safe initialization, the memory pools and slot lists */
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 static CRITICAL_SECTION g_init_lock;
@@ -98,6 +96,12 @@ static void unlock(void) {
     LeaveCriticalSection(&g_init_lock);
 }
 
+/* Queue depth counters */
+typedef volatile LONG counter_t;
+#define counter_inc(c) InterlockedIncrement(c)
+#define counter_dec(c) InterlockedDecrement(c)
+#define counter_get(c) InterlockedCompareExchange(c, 0, 0)
+
 #else
 #include <pthread.h>
 static pthread_mutex_t g_init_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -109,6 +113,12 @@ static void lock(void) {
 static void unlock(void) {
     pthread_mutex_unlock(&g_init_lock);
 }
+
+/* Queue depth counters */
+typedef volatile long counter_t;
+#define counter_inc(c) __atomic_add_fetch(c, 1, __ATOMIC_RELAXED)
+#define counter_dec(c) __atomic_sub_fetch(c, 1, __ATOMIC_RELAXED)
+#define counter_get(c) __atomic_load_n(c, __ATOMIC_RELAXED)
 #endif
 
 /*============================================================================
@@ -180,7 +190,7 @@ static void fill_device_info(int device_id, nvj2k_device_info_t* info) {
         info->compute_major = prop.major;
         info->compute_minor = prop.minor;
         info->total_memory = prop.totalGlobalMem;
-        strncpy(info->name, prop.name, sizeof(info->name) - 1);
+        snprintf(info->name, sizeof(info->name), "%s", prop.name);
     }
 
     size_t free_mem = 0, total_mem = 0;
@@ -189,200 +199,311 @@ static void fill_device_info(int device_id, nvj2k_device_info_t* info) {
     }
 }
 
-#endif /* HAVE_NVJPEG2K */
-
 /*============================================================================
- * Public API implementation
+ * Memory pools
+ *
+ * Device output buffers and pinned staging buffers are recycled through
+ * power-of-two size classes, so a long-running decode service reaches a
+ * steady state without CUDA allocations. A block is only released back to
+ * its pool once the stream that used it has been synchronized.
+ * Pool state is guarded by the global lock. Each device has its own device
+ * pool; device pool operations must run with that device current.
  *============================================================================*/
 
-NVJ2K_API int nvj2k_available(void) {
-#ifdef HAVE_NVJPEG2K
-    /* Check if CUDA driver/runtime is available */
-    int device_count = 0;
-    cudaError_t err = cudaGetDeviceCount(&device_count);
-
-    /* Reset CUDA error state */
-    cudaGetLastError();
-
-    if (err != cudaSuccess || device_count == 0) {
-        return 0;
+/** Smallest size class is 1 << NVJ2K_POOL_MIN_SHIFT bytes (64 KiB) */
+#define NVJ2K_POOL_MIN_SHIFT 16
+
+/** Number of size classes (64 KiB .. 2 GiB); larger blocks are never cached */
+#define NVJ2K_POOL_CLASSES 16
+
+/** Default byte caps for idle memory held by the pools */
+#define NVJ2K_DEFAULT_DEVICE_POOL_LIMIT ((size_t)512 << 20)
+#define NVJ2K_DEFAULT_PINNED_POOL_LIMIT ((size_t)256 << 20)
+
+typedef struct pool_block {
+    void* ptr;
+    size_t size;                /* Allocated size */
+    int size_class;             /* -1 for oversized blocks */
+    struct pool_block* next;
+} pool_block_t;
+
+typedef struct {
+    int pinned;                 /* 1 = page-locked host memory, 0 = device memory */
+    pool_block_t* free_lists[NVJ2K_POOL_CLASSES];
+    size_t limit;               /* Maximum idle bytes kept */
+    size_t cached_bytes;
+    size_t in_use_bytes;
+    uint64_t hits;
+    uint64_t misses;
+} memory_pool_t;
+
+/* Pinned memory is portable across devices, so one pool serves them all */
+static memory_pool_t g_pinned_pool = { 1, { NULL }, NVJ2K_DEFAULT_PINNED_POOL_LIMIT, 0, 0, 0, 0 };
+
+/* Limit applied to each device pool */
+static size_t g_device_pool_limit = NVJ2K_DEFAULT_DEVICE_POOL_LIMIT;
+
+static int pool_size_class(size_t size) {
+    size_t class_size = (size_t)1 << NVJ2K_POOL_MIN_SHIFT;
+    int size_class = 0;
+    while (class_size < size) {
+        if (++size_class >= NVJ2K_POOL_CLASSES) {
+            return -1;
+        }
+        class_size <<= 1;
     }
-
-    /* Check for suitable device */
-    return find_suitable_device() >= 0 ? 1 : 0;
-#else
-    return 0;
-#endif
+    return size_class;
 }
 
-NVJ2K_API int nvj2k_init(int device_id) {
-#ifdef HAVE_NVJPEG2K
-    lock();
+static cudaError_t pool_alloc_memory(const memory_pool_t* pool, void** ptr, size_t size) {
+    return pool->pinned ? cudaMallocHost(ptr, size) : cudaMalloc(ptr, size);
+}
 
-    /* Already initialized? */
-    if (g_initialized) {
-        unlock();
-        set_error("Already initialized. Call nvj2k_shutdown() first.");
-        return NVJ2K_ERR_INVALID_ARGUMENT;
+static void pool_free_memory(const memory_pool_t* pool, void* ptr) {
+    if (pool->pinned) {
+        cudaFreeHost(ptr);
+    } else {
+        cudaFree(ptr);
     }
+}
 
-    /* Find device */
-    int selected_device = device_id;
-    if (selected_device < 0) {
-        selected_device = find_suitable_device();
-        if (selected_device < 0) {
-            unlock();
-            set_error("No suitable CUDA device found (requires compute 5.0+)");
-            return NVJ2K_ERR_NO_DEVICE;
+/**
+ * Free cached blocks, largest first, until at most max_cached bytes are idle.
+ * Caller must hold the global lock.
+ */
+static void pool_trim_locked(memory_pool_t* pool, size_t max_cached) {
+    for (int c = NVJ2K_POOL_CLASSES - 1; c >= 0 && pool->cached_bytes > max_cached; c--) {
+        while (pool->free_lists[c] && pool->cached_bytes > max_cached) {
+            pool_block_t* block = pool->free_lists[c];
+            pool->free_lists[c] = block->next;
+            pool->cached_bytes -= block->size;
+            pool_free_memory(pool, block->ptr);
+            free(block);
         }
     }
+}
 
-    /* Verify device has required compute capability */
-    if (!check_compute_capability(selected_device)) {
+/**
+ * Take a block of at least size bytes from the pool, allocating on a miss.
+ * Returns NULL (with the error set) if memory cannot be allocated.
+ */
+static pool_block_t* pool_acquire(memory_pool_t* pool, size_t size) {
+    int size_class = pool_size_class(size);
+
+    lock();
+    if (size_class >= 0 && pool->free_lists[size_class]) {
+        pool_block_t* block = pool->free_lists[size_class];
+        pool->free_lists[size_class] = block->next;
+        pool->cached_bytes -= block->size;
+        pool->in_use_bytes += block->size;
+        pool->hits++;
         unlock();
-        set_error("GPU does not meet minimum compute capability (5.0+)");
-        return NVJ2K_ERR_UNSUPPORTED_GPU;
+        block->next = NULL;
+        return block;
     }
+    pool->misses++;
+    unlock();
 
-    /* Set device */
-    cudaError_t cuda_err = cudaSetDevice(selected_device);
-    if (cuda_err != cudaSuccess) {
-        unlock();
-        set_error_fmt("Failed to set CUDA device: %s", cudaGetErrorString(cuda_err));
-        return NVJ2K_ERR_CUDA_ERROR;
+    pool_block_t* block = (pool_block_t*)calloc(1, sizeof(pool_block_t));
+    if (!block) {
+        set_error("Failed to allocate pool block");
+        return NULL;
     }
+    block->size = (size_class >= 0) ? ((size_t)1 << (NVJ2K_POOL_MIN_SHIFT + size_class)) : size;
+    block->size_class = size_class;
 
-    /* Create CUDA stream */
-    cuda_err = cudaStreamCreate(&g_stream);
+    cudaError_t cuda_err = pool_alloc_memory(pool, &block->ptr, block->size);
     if (cuda_err != cudaSuccess) {
+        /* Give idle blocks of other sizes back to CUDA and retry once */
+        lock();
+        pool_trim_locked(pool, 0);
         unlock();
-        set_error_fmt("Failed to create CUDA stream: %s", cudaGetErrorString(cuda_err));
-        return NVJ2K_ERR_CUDA_ERROR;
+        cuda_err = pool_alloc_memory(pool, &block->ptr, block->size);
+    }
+    if (cuda_err != cudaSuccess) {
+        set_error_fmt("Failed to allocate %s memory: %s",
+                      pool->pinned ? "pinned" : "GPU", cudaGetErrorString(cuda_err));
+        free(block);
+        return NULL;
     }
 
-    /* Create nvJPEG2000 handle */
-    nvjpeg2kStatus_t nv_status = nvjpeg2kCreate(NVJPEG2K_BACKEND_DEFAULT, NULL, &g_handle);
-    if (nv_status != NVJPEG2K_STATUS_SUCCESS) {
-        cudaStreamDestroy(g_stream);
-        g_stream = NULL;
-        unlock();
-        set_error_fmt("Failed to create nvJPEG2000 handle: %d", (int)nv_status);
-        return NVJ2K_ERR_INTERNAL;
+    lock();
+    pool->in_use_bytes += block->size;
+    unlock();
+    return block;
+}
+
+/**
+ * Return a block to the pool, freeing it instead if caching it would exceed
+ * the pool limit. The block must no longer be in use by any stream.
+ * Caller must hold the global lock.
+ */
+static void pool_release_locked(memory_pool_t* pool, pool_block_t* block) {
+    if (!block) {
+        return;
     }
 
-    /* Create decode state */
-    nv_status = nvjpeg2kDecodeStateCreate(g_handle, &g_state);
-    if (nv_status != NVJPEG2K_STATUS_SUCCESS) {
-        nvjpeg2kDestroy(g_handle);
-        g_handle = NULL;
-        cudaStreamDestroy(g_stream);
-        g_stream = NULL;
-        unlock();
-        set_error_fmt("Failed to create decode state: %d", (int)nv_status);
-        return NVJ2K_ERR_INTERNAL;
+    pool->in_use_bytes -= block->size;
+    if (block->size_class >= 0 && pool->cached_bytes + block->size <= pool->limit) {
+        block->next = pool->free_lists[block->size_class];
+        pool->free_lists[block->size_class] = block;
+        pool->cached_bytes += block->size;
+        return;
     }
 
-    /* Cache device info */
-    g_device_id = selected_device;
-    fill_device_info(selected_device, &g_device_info);
+    pool_free_memory(pool, block->ptr);
+    free(block);
+}
 
-    g_initialized = 1;
-    unlock();
-    return NVJ2K_OK;
+/**
+ * Return a block to the pool. See pool_release_locked().
+ */
+static void pool_release(memory_pool_t* pool, pool_block_t* block) {
+    if (!block) {
+        return;
+    }
 
-#else
-    (void)device_id;
-    set_error("nvJPEG2000 support not compiled in");
-    return NVJ2K_ERR_UNSUPPORTED_GPU;
-#endif
+    lock();
+    pool_release_locked(pool, block);
+    unlock();
 }
 
-NVJ2K_API int nvj2k_get_device_info(nvj2k_device_info_t* info) {
-#ifdef HAVE_NVJPEG2K
-    if (!info) {
-        set_error("info parameter is NULL");
-        return NVJ2K_ERR_INVALID_ARGUMENT;
+/*============================================================================
+ * Device contexts
+ *============================================================================*/
+
+struct pipeline_slot;
+
+/**
+ * State for one initialized GPU.
+ */
+typedef struct {
+    int device_id;                      /* CUDA device ID */
+    nvjpeg2kHandle_t handle;            /* nvJPEG2000 handle shared by all threads */
+    nvj2k_device_info_t info;           /* Cached device info */
+    memory_pool_t pool;                 /* Device memory pool */
+    struct pipeline_slot* idle_slots;   /* Idle slots (global lock) */
+    struct pipeline_slot* bound_slots;  /* Slots owned by a thread (global lock) */
+    counter_t pending;                  /* Frames queued or decoding on this device */
+} device_context_t;
+
+/* Initialized devices */
+static device_context_t g_devices[NVJ2K_MAX_DEVICES];
+static int g_num_devices = 0;
+static volatile int g_initialized = 0;
+
+/* Bumped by nvj2k_shutdown() so threads drop contexts from an earlier init */
+static volatile unsigned g_generation = 0;
+
+/**
+ * Make a device current for the calling thread.
+ */
+static int use_device(const device_context_t* dev) {
+    cudaError_t cuda_err = cudaSetDevice(dev->device_id);
+    if (cuda_err != cudaSuccess) {
+        set_error_fmt("Failed to set CUDA device: %s", cudaGetErrorString(cuda_err));
+        return NVJ2K_ERR_CUDA_ERROR;
     }
+    return NVJ2K_OK;
+}
 
-    if (!g_initialized) {
-        set_error("Not initialized. Call nvj2k_init() first.");
-        return NVJ2K_ERR_NOT_INITIALIZED;
+/**
+ * Pick the device with the fewest pending frames; ties go to the device with
+ * the most free memory as of the last device info refresh.
+ */
+static device_context_t* select_device(void) {
+    device_context_t* best = &g_devices[0];
+    long best_pending = counter_get(&best->pending);
+
+    for (int i = 1; i < g_num_devices; i++) {
+        device_context_t* dev = &g_devices[i];
+        long pending = counter_get(&dev->pending);
+        if (pending < best_pending ||
+            (pending == best_pending && dev->info.free_memory > best->info.free_memory)) {
+            best = dev;
+            best_pending = pending;
+        }
     }
 
-    *info = g_device_info;
-    return NVJ2K_OK;
-#else
-    (void)info;
-    set_error("nvJPEG2000 support not compiled in");
-    return NVJ2K_ERR_UNSUPPORTED_GPU;
-#endif
+    return best;
 }
 
-NVJ2K_API void nvj2k_shutdown(void) {
-#ifdef HAVE_NVJPEG2K
-    lock();
+/**
+ * Create the nvJPEG2000 handle for a device.
+ * Caller must hold the global lock.
+ */
+static int device_create(device_context_t* dev, int device_id) {
+    memset(dev, 0, sizeof(*dev));
+    dev->device_id = device_id;
+    dev->pool.pinned = 0;
+    dev->pool.limit = g_device_pool_limit;
 
-    if (g_state) {
-        nvjpeg2kDecodeStateDestroy(g_state);
-        g_state = NULL;
+    /* Verify device has required compute capability */
+    if (!check_compute_capability(device_id)) {
+        set_error("GPU does not meet minimum compute capability (5.0+)");
+        return NVJ2K_ERR_UNSUPPORTED_GPU;
     }
 
-    if (g_handle) {
-        nvjpeg2kDestroy(g_handle);
-        g_handle = NULL;
+    /* Set device */
+    int status = use_device(dev);
+    if (status != NVJ2K_OK) {
+        return status;
     }
 
-    if (g_stream) {
-        cudaStreamDestroy(g_stream);
-        g_stream = NULL;
+    /* Create nvJPEG2000 handle */
+    nvjpeg2kStatus_t nv_status = nvjpeg2kCreate(NVJPEG2K_BACKEND_DEFAULT, NULL, NULL, &dev->handle);
+    if (nv_status != NVJPEG2K_STATUS_SUCCESS) {
+        set_error_fmt("Failed to create nvJPEG2000 handle: %d", (int)nv_status);
+        return NVJ2K_ERR_INTERNAL;
     }
 
-    g_device_id = -1;
-    g_initialized = 0;
-    memset(&g_device_info, 0, sizeof(g_device_info));
-
-    unlock();
-#endif
+    /* Cache device info */
+    fill_device_info(device_id, &dev->info);
+    return NVJ2K_OK;
 }
 
-NVJ2K_API int nvj2k_decode(
+/*============================================================================
+ * Frame decode helpers
+ *============================================================================*/
+
+/** Maximum number of components decoded on the GPU path */
+#define NVJ2K_MAX_COMPONENTS 4
+
+/**
+ * Number of frames nvj2k_decode_batch() keeps in flight per device. With
+ * three slots the host parse of frame N+1 overlaps the GPU decode of frame N
+ * and the device-to-host copy of frame N-1.
+ */
+#define NVJ2K_PIPELINE_DEPTH 3
+
+/**
+ * Geometry of a parsed frame and the size of its decoded output.
+ */
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t num_components;
+    uint32_t precision;
+    int bytes_per_sample;
+    size_t output_size;
+} frame_layout_t;
+
+/**
+ * Parse a codestream into an nvJPEG2000 stream and compute its output layout.
+ */
+static int parse_frame(
+    nvjpeg2kHandle_t handle,
+    nvjpeg2kStream_t j2k_stream,
     const uint8_t* input,
     size_t input_len,
-    uint8_t* output,
-    size_t output_len,
     const nvj2k_decode_params_t* params,
-    nvj2k_decode_result_t* result
+    frame_layout_t* layout
 ) {
-#ifdef HAVE_NVJPEG2K
-    if (!input || input_len == 0) {
-        set_error("input is NULL or empty");
-        return NVJ2K_ERR_INVALID_ARGUMENT;
-    }
-
-    if (!output || output_len == 0) {
-        set_error("output is NULL or empty");
-        return NVJ2K_ERR_INVALID_ARGUMENT;
-    }
-
-    if (!g_initialized) {
-        set_error("Not initialized. Call nvj2k_init() first.");
-        return NVJ2K_ERR_NOT_INITIALIZED;
-    }
-
     nvjpeg2kStatus_t status;
 
-    /* Create stream for parsing */
-    nvjpeg2kStream_t j2k_stream = NULL;
-    status = nvjpeg2kStreamCreate(&j2k_stream);
-    if (status != NVJPEG2K_STATUS_SUCCESS) {
-        set_error_fmt("Failed to create J2K stream: %d", (int)status);
-        return NVJ2K_ERR_INTERNAL;
-    }
-
     /* Parse the codestream */
-    status = nvjpeg2kStreamParse(g_handle, input, input_len, 0, 0, j2k_stream);
+    status = nvjpeg2kStreamParse(handle, input, input_len, 0, 0, j2k_stream);
     if (status != NVJPEG2K_STATUS_SUCCESS) {
-        nvjpeg2kStreamDestroy(j2k_stream);
         set_error_fmt("Failed to parse J2K codestream: %d", (int)status);
         return NVJ2K_ERR_DECODE_FAILED;
     }
@@ -391,126 +512,877 @@ NVJ2K_API int nvj2k_decode(
     nvjpeg2kImageInfo_t image_info;
     status = nvjpeg2kStreamGetImageInfo(j2k_stream, &image_info);
     if (status != NVJPEG2K_STATUS_SUCCESS) {
-        nvjpeg2kStreamDestroy(j2k_stream);
         set_error_fmt("Failed to get image info: %d", (int)status);
         return NVJ2K_ERR_DECODE_FAILED;
     }
 
-    /* Apply reduction factor if specified */
-    int reduce = (params && params->reduce_factor > 0) ? params->reduce_factor : 0;
-    uint32_t decode_width = image_info.image_width >> reduce;
-    uint32_t decode_height = image_info.image_height >> reduce;
-    if (decode_width == 0) decode_width = 1;
-    if (decode_height == 0) decode_height = 1;
+    if (image_info.num_components == 0 || image_info.num_components > NVJ2K_MAX_COMPONENTS) {
+        set_error_fmt("Unsupported component count: %u", image_info.num_components);
+        return NVJ2K_ERR_DECODE_FAILED;
+    }
 
     /* Get component info for first component (assume all same) */
     nvjpeg2kImageComponentInfo_t comp_info;
     status = nvjpeg2kStreamGetImageComponentInfo(j2k_stream, &comp_info, 0);
     if (status != NVJPEG2K_STATUS_SUCCESS) {
-        nvjpeg2kStreamDestroy(j2k_stream);
         set_error_fmt("Failed to get component info: %d", (int)status);
         return NVJ2K_ERR_DECODE_FAILED;
     }
 
-    /* Calculate expected output size (with overflow protection) */
-    int bytes_per_sample = (comp_info.precision + 7) / 8;
-    size_t expected_size = safe_mul4_size((size_t)decode_width, (size_t)decode_height,
-                                          (size_t)image_info.num_components, (size_t)bytes_per_sample);
+    /* Apply reduction factor if specified */
+    int reduce = (params && params->reduce_factor > 0) ? params->reduce_factor : 0;
+    layout->width = image_info.image_width >> reduce;
+    layout->height = image_info.image_height >> reduce;
+    if (layout->width == 0) layout->width = 1;
+    if (layout->height == 0) layout->height = 1;
+
+    layout->num_components = image_info.num_components;
+    layout->precision = comp_info.precision;
+    layout->bytes_per_sample = (comp_info.precision + 7) / 8;
 
-    if (expected_size == 0 || output_len < expected_size) {
-        nvjpeg2kStreamDestroy(j2k_stream);
-        set_error_fmt("Output buffer too small or dimensions too large: need %zu, got %zu", expected_size, output_len);
+    /* Calculate expected output size (with overflow protection) */
+    layout->output_size = safe_mul4_size((size_t)layout->width, (size_t)layout->height,
+                                         (size_t)layout->num_components, (size_t)layout->bytes_per_sample);
+    if (layout->output_size == 0) {
+        set_error("Image dimensions too large");
         return NVJ2K_ERR_INVALID_ARGUMENT;
     }
 
-    /* Allocate device memory */
-    uint8_t* d_output = NULL;
-    cudaError_t cuda_err = cudaMalloc(&d_output, expected_size);
-    if (cuda_err != cudaSuccess) {
-        nvjpeg2kStreamDestroy(j2k_stream);
-        set_error_fmt("Failed to allocate GPU memory: %s", cudaGetErrorString(cuda_err));
-        return NVJ2K_ERR_OUT_OF_MEMORY;
-    }
+    return NVJ2K_OK;
+}
 
-    /* Set up decode parameters */
-    nvjpeg2kDecodeParams_t decode_params;
-    status = nvjpeg2kDecodeParamsCreate(&decode_params);
-    if (status != NVJPEG2K_STATUS_SUCCESS) {
-        cudaFree(d_output);
-        nvjpeg2kStreamDestroy(j2k_stream);
-        set_error_fmt("Failed to create decode params: %d", (int)status);
-        return NVJ2K_ERR_INTERNAL;
+/**
+ * Enqueue the decode of a parsed frame on a CUDA stream.
+ * Output is planar: component c starts at d_output + c * width * height * bytes_per_sample.
+ */
+static int enqueue_decode(
+    nvjpeg2kHandle_t handle,
+    nvjpeg2kDecodeState_t state,
+    nvjpeg2kStream_t j2k_stream,
+    nvjpeg2kDecodeParams_t decode_params,
+    const frame_layout_t* layout,
+    uint8_t* d_output,
+    cudaStream_t stream
+) {
+    void* pixel_data[NVJ2K_MAX_COMPONENTS];
+    size_t pitch_in_bytes[NVJ2K_MAX_COMPONENTS];
+
+    size_t pitch = (size_t)layout->width * (size_t)layout->bytes_per_sample;
+    size_t comp_size = pitch * (size_t)layout->height;
+    for (uint32_t c = 0; c < layout->num_components; c++) {
+        pixel_data[c] = d_output + c * comp_size;
+        pitch_in_bytes[c] = pitch;
     }
 
-    /* Configure output image */
     nvjpeg2kImage_t output_image;
-    output_image.num_components = image_info.num_components;
-
-    /* For interleaved output, we use a single buffer */
-    size_t comp_size = safe_mul3_size((size_t)decode_width, (size_t)decode_height, (size_t)bytes_per_sample);
-    size_t pitch = safe_mul_size((size_t)decode_width, (size_t)bytes_per_sample);
-    for (uint32_t c = 0; c < image_info.num_components && c < NVJPEG2K_MAX_COMPONENT; c++) {
-        output_image.pixel_data[c] = d_output + c * comp_size;
-        output_image.pitch_in_bytes[c] = pitch;
-        output_image.pixel_type = (bytes_per_sample == 1) ? NVJPEG2K_UINT8 :
-                                   (bytes_per_sample == 2) ? NVJPEG2K_UINT16 : NVJPEG2K_UINT8;
-    }
+    output_image.pixel_data = pixel_data;
+    output_image.pitch_in_bytes = pitch_in_bytes;
+    output_image.pixel_type = (layout->bytes_per_sample == 1) ? NVJPEG2K_UINT8 : NVJPEG2K_UINT16;
+    output_image.num_components = layout->num_components;
 
-    /* Decode */
-    status = nvjpeg2kDecode(g_handle, g_state, j2k_stream, decode_params, &output_image, g_stream);
+    nvjpeg2kStatus_t status = nvjpeg2kDecodeImage(handle, state, j2k_stream, decode_params,
+                                                  &output_image, stream);
     if (status != NVJPEG2K_STATUS_SUCCESS) {
-        nvjpeg2kDecodeParamsDestroy(decode_params);
-        cudaFree(d_output);
-        nvjpeg2kStreamDestroy(j2k_stream);
         set_error_fmt("Decode failed: %d", (int)status);
         return NVJ2K_ERR_DECODE_FAILED;
     }
 
-    /* Synchronize and copy to host */
-    cuda_err = cudaStreamSynchronize(g_stream);
-    if (cuda_err != cudaSuccess) {
-        nvjpeg2kDecodeParamsDestroy(decode_params);
-        cudaFree(d_output);
-        nvjpeg2kStreamDestroy(j2k_stream);
-        set_error_fmt("Stream sync failed: %s", cudaGetErrorString(cuda_err));
-        return NVJ2K_ERR_CUDA_ERROR;
+    return NVJ2K_OK;
+}
+
+/*============================================================================
+ * Batch decode pipeline
+ *============================================================================*/
+
+/**
+ * One in-flight frame of the batch pipeline. Each slot belongs to a device
+ * and owns the nvJPEG2000 stream and decode state for its frame, so frames
+ * in different slots can be parsed, decoded and copied back concurrently.
+ * Idle slots are kept on their device's list so their streams and decode
+ * state are reused across batches. A slot can also be bound to a host
+ * thread as its single-frame decode context.
+ */
+typedef struct pipeline_slot {
+    device_context_t* device;
+    nvjpeg2kStream_t j2k_stream;
+    nvjpeg2kDecodeState_t state;
+    cudaStream_t stream;
+    cudaEvent_t done;           /* Recorded after the device-to-host copy */
+    pool_block_t* d_block;      /* Device output */
+    pool_block_t* h_block;      /* Pinned host copy of the output */
+    int frame;                  /* Batch index in flight, -1 when idle */
+    frame_layout_t layout;
+    struct pipeline_slot* next;
+} pipeline_slot_t;
+
+/**
+ * Destroy a slot that holds no pool blocks. Its device must be current.
+ */
+static void slot_destroy(pipeline_slot_t* slot) {
+    if (slot->done) cudaEventDestroy(slot->done);
+    if (slot->stream) cudaStreamDestroy(slot->stream);
+    if (slot->state) nvjpeg2kDecodeStateDestroy(slot->state);
+    if (slot->j2k_stream) nvjpeg2kStreamDestroy(slot->j2k_stream);
+    free(slot);
+}
+
+/**
+ * Take an idle slot of a device, creating one if none is available.
+ * Returns NULL (with the error set) on failure.
+ */
+static pipeline_slot_t* slot_acquire(device_context_t* dev) {
+    lock();
+    pipeline_slot_t* slot = dev->idle_slots;
+    if (slot) {
+        dev->idle_slots = slot->next;
     }
+    unlock();
 
-    cuda_err = cudaMemcpy(output, d_output, expected_size, cudaMemcpyDeviceToHost);
-    if (cuda_err != cudaSuccess) {
-        nvjpeg2kDecodeParamsDestroy(decode_params);
-        cudaFree(d_output);
-        nvjpeg2kStreamDestroy(j2k_stream);
-        set_error_fmt("GPU->CPU copy failed: %s", cudaGetErrorString(cuda_err));
-        return NVJ2K_ERR_CUDA_ERROR;
+    if (slot) {
+        slot->next = NULL;
+        slot->frame = -1;
+        return slot;
     }
 
-    /* Fill result */
-    if (result) {
-        result->width = (int)decode_width;
-        result->height = (int)decode_height;
-        result->num_components = (int)image_info.num_components;
-        result->precision = (int)comp_info.precision;
-        result->output_size = expected_size;
+    if (use_device(dev) != NVJ2K_OK) {
+        return NULL;
     }
 
-    /* Cleanup */
-    nvjpeg2kDecodeParamsDestroy(decode_params);
-    cudaFree(d_output);
-    nvjpeg2kStreamDestroy(j2k_stream);
+    slot = (pipeline_slot_t*)calloc(1, sizeof(pipeline_slot_t));
+    if (!slot) {
+        set_error("Failed to allocate pipeline slot");
+        return NULL;
+    }
+    slot->device = dev;
+    slot->frame = -1;
 
-    return NVJ2K_OK;
+    nvjpeg2kStatus_t status = nvjpeg2kStreamCreate(&slot->j2k_stream);
+    if (status == NVJPEG2K_STATUS_SUCCESS) {
+        status = nvjpeg2kDecodeStateCreate(dev->handle, &slot->state);
+    }
+    if (status != NVJPEG2K_STATUS_SUCCESS) {
+        slot_destroy(slot);
+        set_error_fmt("Failed to create pipeline decode state: %d", (int)status);
+        return NULL;
+    }
 
-#else
-    (void)input;
-    (void)input_len;
-    (void)output;
-    (void)output_len;
-    (void)params;
-    (void)result;
-    set_error("nvJPEG2000 support not compiled in");
-    return NVJ2K_ERR_UNSUPPORTED_GPU;
-#endif
+    cudaError_t cuda_err = cudaStreamCreateWithFlags(&slot->stream, cudaStreamNonBlocking);
+    if (cuda_err == cudaSuccess) {
+        cuda_err = cudaEventCreateWithFlags(&slot->done, cudaEventDisableTiming);
+    }
+    if (cuda_err != cudaSuccess) {
+        slot_destroy(slot);
+        set_error_fmt("Failed to create pipeline stream: %s", cudaGetErrorString(cuda_err));
+        return NULL;
+    }
+
+    return slot;
+}
+
+/**
+ * Return an idle slot to its device's list. Its buffers go back to the pools.
+ */
+static void slot_release(pipeline_slot_t* slot) {
+    device_context_t* dev = slot->device;
+
+    use_device(dev);
+    pool_release(&g_pinned_pool, slot->h_block);
+    pool_release(&dev->pool, slot->d_block);
+    slot->h_block = NULL;
+    slot->d_block = NULL;
+
+    lock();
+    slot->next = dev->idle_slots;
+    dev->idle_slots = slot;
+    unlock();
+}
+
+/**
+ * Make sure the slot's device buffer, and its pinned buffer if with_host is
+ * set, hold at least size bytes. The slot must be idle and its device current.
+ */
+static int slot_reserve(pipeline_slot_t* slot, size_t size, int with_host) {
+    if (!slot->d_block || slot->d_block->size < size) {
+        pool_release(&slot->device->pool, slot->d_block);
+        slot->d_block = pool_acquire(&slot->device->pool, size);
+        if (!slot->d_block) {
+            return NVJ2K_ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (with_host && (!slot->h_block || slot->h_block->size < size)) {
+        pool_release(&g_pinned_pool, slot->h_block);
+        slot->h_block = pool_acquire(&g_pinned_pool, size);
+        if (!slot->h_block) {
+            return NVJ2K_ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    return NVJ2K_OK;
+}
+
+/**
+ * Parse a frame and enqueue its decode and device-to-host copy on the slot.
+ * The slot must be idle.
+ */
+static int slot_submit(
+    pipeline_slot_t* slot,
+    int frame,
+    const uint8_t* input,
+    size_t input_len,
+    size_t output_len,
+    const nvj2k_decode_params_t* params,
+    nvjpeg2kDecodeParams_t decode_params
+) {
+    device_context_t* dev = slot->device;
+
+    int status = use_device(dev);
+    if (status != NVJ2K_OK) {
+        return status;
+    }
+
+    status = parse_frame(dev->handle, slot->j2k_stream, input, input_len, params, &slot->layout);
+    if (status != NVJ2K_OK) {
+        return status;
+    }
+
+    if (output_len < slot->layout.output_size) {
+        set_error_fmt("Output buffer too small: need %zu, got %zu", slot->layout.output_size, output_len);
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    status = slot_reserve(slot, slot->layout.output_size, 1);
+    if (status != NVJ2K_OK) {
+        return status;
+    }
+
+    status = enqueue_decode(dev->handle, slot->state, slot->j2k_stream, decode_params, &slot->layout,
+                            (uint8_t*)slot->d_block->ptr, slot->stream);
+    if (status != NVJ2K_OK) {
+        /* Drain whatever was queued before the slot is reused */
+        cudaStreamSynchronize(slot->stream);
+        return status;
+    }
+
+    cudaError_t cuda_err = cudaMemcpyAsync(slot->h_block->ptr, slot->d_block->ptr, slot->layout.output_size,
+                                           cudaMemcpyDeviceToHost, slot->stream);
+    if (cuda_err == cudaSuccess) {
+        cuda_err = cudaEventRecord(slot->done, slot->stream);
+    }
+    if (cuda_err != cudaSuccess) {
+        cudaStreamSynchronize(slot->stream);
+        set_error_fmt("GPU->CPU copy failed: %s", cudaGetErrorString(cuda_err));
+        return NVJ2K_ERR_CUDA_ERROR;
+    }
+
+    slot->frame = frame;
+    counter_inc(&dev->pending);
+    return NVJ2K_OK;
+}
+
+/**
+ * Parse a frame and enqueue its decode into device memory on the slot.
+ * Decodes into device_output if given, otherwise into the slot's device
+ * buffer. Nothing is copied back to the host. The slot must be idle.
+ */
+static int slot_submit_device(
+    pipeline_slot_t* slot,
+    const uint8_t* input,
+    size_t input_len,
+    void* device_output,
+    size_t device_output_len,
+    const nvj2k_decode_params_t* params,
+    nvjpeg2kDecodeParams_t decode_params,
+    void** out_ptr
+) {
+    device_context_t* dev = slot->device;
+
+    int status = use_device(dev);
+    if (status != NVJ2K_OK) {
+        return status;
+    }
+
+    status = parse_frame(dev->handle, slot->j2k_stream, input, input_len, params, &slot->layout);
+    if (status != NVJ2K_OK) {
+        return status;
+    }
+
+    uint8_t* target = (uint8_t*)device_output;
+    if (target) {
+        if (device_output_len < slot->layout.output_size) {
+            set_error_fmt("Device buffer too small: need %zu, got %zu", slot->layout.output_size, device_output_len);
+            return NVJ2K_ERR_INVALID_ARGUMENT;
+        }
+    } else {
+        status = slot_reserve(slot, slot->layout.output_size, 0);
+        if (status != NVJ2K_OK) {
+            return status;
+        }
+        target = (uint8_t*)slot->d_block->ptr;
+    }
+
+    status = enqueue_decode(dev->handle, slot->state, slot->j2k_stream, decode_params, &slot->layout,
+                            target, slot->stream);
+    if (status != NVJ2K_OK) {
+        cudaStreamSynchronize(slot->stream);
+        return status;
+    }
+
+    cudaError_t cuda_err = cudaEventRecord(slot->done, slot->stream);
+    if (cuda_err != cudaSuccess) {
+        cudaStreamSynchronize(slot->stream);
+        set_error_fmt("Failed to record decode event: %s", cudaGetErrorString(cuda_err));
+        return NVJ2K_ERR_CUDA_ERROR;
+    }
+
+    slot->frame = 0;
+    counter_inc(&dev->pending);
+    *out_ptr = target;
+    return NVJ2K_OK;
+}
+
+/**
+ * Wait for the slot's frame to reach pinned memory and mark the slot idle.
+ */
+static int slot_wait(pipeline_slot_t* slot) {
+    slot->frame = -1;
+
+    cudaError_t cuda_err = cudaEventSynchronize(slot->done);
+    counter_dec(&slot->device->pending);
+    if (cuda_err != cudaSuccess) {
+        set_error_fmt("Stream sync failed: %s", cudaGetErrorString(cuda_err));
+        return NVJ2K_ERR_CUDA_ERROR;
+    }
+
+    return NVJ2K_OK;
+}
+
+/**
+ * Wait for the slot's frame, copy it to the caller's buffer and fill its result.
+ * Returns 1 if the frame decoded successfully, 0 otherwise.
+ */
+static int slot_retire(pipeline_slot_t* slot, uint8_t** outputs, nvj2k_batch_result_t* results) {
+    int frame = slot->frame;
+    nvj2k_batch_result_t* result = &results[frame];
+
+    result->status = slot_wait(slot);
+    if (result->status != NVJ2K_OK) {
+        return 0;
+    }
+
+    memcpy(outputs[frame], slot->h_block->ptr, slot->layout.output_size);
+
+    result->width = (int)slot->layout.width;
+    result->height = (int)slot->layout.height;
+    result->num_components = (int)slot->layout.num_components;
+    result->precision = (int)slot->layout.precision;
+    result->output_size = slot->layout.output_size;
+    return 1;
+}
+
+/**
+ * Choose the slot for the next frame: an idle slot, else one whose frame has
+ * already completed, else the slot holding the oldest frame. Completed slots
+ * are retired here, so faster devices pick up more of the batch.
+ */
+static pipeline_slot_t* next_slot(
+    pipeline_slot_t** slots,
+    int num_slots,
+    uint8_t** outputs,
+    nvj2k_batch_result_t* results,
+    int* success_count
+) {
+    pipeline_slot_t* oldest = NULL;
+
+    for (int s = 0; s < num_slots; s++) {
+        if (slots[s]->frame < 0) {
+            return slots[s];
+        }
+    }
+
+    for (int s = 0; s < num_slots; s++) {
+        if (cudaEventQuery(slots[s]->done) == cudaSuccess) {
+            *success_count += slot_retire(slots[s], outputs, results);
+            return slots[s];
+        }
+        if (!oldest || slots[s]->frame < oldest->frame) {
+            oldest = slots[s];
+        }
+    }
+
+    *success_count += slot_retire(oldest, outputs, results);
+    return oldest;
+}
+
+/*============================================================================
+ * Per-thread decode contexts
+ *
+ * A thread's first single-frame decode on a device binds a slot to it; later
+ * decodes reuse the slot's stream, decode state and buffers without taking
+ * the global lock. The slot goes back to the device's idle list when the
+ * thread exits, and a shutdown invalidates all bindings via g_generation.
+ *============================================================================*/
+
+typedef struct {
+    unsigned generation;                        /* g_generation when bound */
+    pipeline_slot_t* slots[NVJ2K_MAX_DEVICES];  /* Bound slot per device index */
+} thread_contexts_t;
+
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD g_context_key = FLS_OUT_OF_INDEXES;
+#define CONTEXT_EXIT_CALLBACK WINAPI
+#define context_key_get() ((thread_contexts_t*)FlsGetValue(g_context_key))
+#define context_key_set(ctx) FlsSetValue(g_context_key, (ctx))
+#else
+static pthread_key_t g_context_key;
+static int g_context_key_created = 0;
+#define CONTEXT_EXIT_CALLBACK
+#define context_key_get() ((thread_contexts_t*)pthread_getspecific(g_context_key))
+#define context_key_set(ctx) pthread_setspecific(g_context_key, (ctx))
+#endif
+
+/**
+ * Thread exit: return the thread's slots to their idle lists, keeping their
+ * buffers for the next thread. Slots from an earlier init are already gone.
+ */
+static void CONTEXT_EXIT_CALLBACK thread_contexts_exit(void* data) {
+    thread_contexts_t* ctx = (thread_contexts_t*)data;
+    if (!ctx) {
+        return;
+    }
+
+    lock();
+    if (ctx->generation == g_generation) {
+        for (int i = 0; i < g_num_devices; i++) {
+            pipeline_slot_t* slot = ctx->slots[i];
+            if (!slot) {
+                continue;
+            }
+
+            device_context_t* dev = &g_devices[i];
+            for (pipeline_slot_t** link = &dev->bound_slots; *link; link = &(*link)->next) {
+                if (*link == slot) {
+                    *link = slot->next;
+                    break;
+                }
+            }
+            slot->next = dev->idle_slots;
+            dev->idle_slots = slot;
+        }
+    }
+    unlock();
+
+    free(ctx);
+}
+
+/**
+ * Create the thread-exit hook once per process.
+ * Caller must hold the global lock.
+ */
+static int context_key_create_locked(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    if (g_context_key == FLS_OUT_OF_INDEXES) {
+        g_context_key = FlsAlloc(thread_contexts_exit);
+        if (g_context_key == FLS_OUT_OF_INDEXES) {
+            set_error("Failed to allocate thread context key");
+            return NVJ2K_ERR_INTERNAL;
+        }
+    }
+#else
+    if (!g_context_key_created) {
+        if (pthread_key_create(&g_context_key, thread_contexts_exit) != 0) {
+            set_error("Failed to allocate thread context key");
+            return NVJ2K_ERR_INTERNAL;
+        }
+        g_context_key_created = 1;
+    }
+#endif
+    return NVJ2K_OK;
+}
+
+/**
+ * Get the calling thread's decode slot for a device, binding one on first use.
+ * Returns NULL (with the error set) on failure.
+ */
+static pipeline_slot_t* thread_slot(device_context_t* dev) {
+    thread_contexts_t* ctx = context_key_get();
+    if (!ctx) {
+        ctx = (thread_contexts_t*)calloc(1, sizeof(thread_contexts_t));
+        if (!ctx) {
+            set_error("Failed to allocate thread decode context");
+            return NULL;
+        }
+        ctx->generation = g_generation;
+        context_key_set(ctx);
+    } else if (ctx->generation != g_generation) {
+        memset(ctx->slots, 0, sizeof(ctx->slots));
+        ctx->generation = g_generation;
+    }
+
+    int index = (int)(dev - g_devices);
+    if (!ctx->slots[index]) {
+        pipeline_slot_t* slot = slot_acquire(dev);
+        if (!slot) {
+            return NULL;
+        }
+
+        lock();
+        slot->next = dev->bound_slots;
+        dev->bound_slots = slot;
+        unlock();
+
+        ctx->slots[index] = slot;
+    }
+
+    return ctx->slots[index];
+}
+
+/**
+ * Decode one frame on a device using the calling thread's context.
+ */
+static int decode_on_device(
+    device_context_t* dev,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_decode_result_t* result
+) {
+    pipeline_slot_t* slot = thread_slot(dev);
+    if (!slot) {
+        return NVJ2K_ERR_OUT_OF_MEMORY;
+    }
+
+    /* Set up decode parameters */
+    nvjpeg2kDecodeParams_t decode_params;
+    nvjpeg2kStatus_t status = nvjpeg2kDecodeParamsCreate(&decode_params);
+    if (status != NVJPEG2K_STATUS_SUCCESS) {
+        set_error_fmt("Failed to create decode params: %d", (int)status);
+        return NVJ2K_ERR_INTERNAL;
+    }
+
+    /* Decode and copy to pinned memory, then to the caller's buffer */
+    int rc = slot_submit(slot, 0, input, input_len, output_len, params, decode_params);
+    if (rc == NVJ2K_OK) {
+        rc = slot_wait(slot);
+    }
+    nvjpeg2kDecodeParamsDestroy(decode_params);
+
+    if (rc != NVJ2K_OK) {
+        return rc;
+    }
+
+    memcpy(output, slot->h_block->ptr, slot->layout.output_size);
+
+    /* Fill result */
+    if (result) {
+        result->width = (int)slot->layout.width;
+        result->height = (int)slot->layout.height;
+        result->num_components = (int)slot->layout.num_components;
+        result->precision = (int)slot->layout.precision;
+        result->output_size = slot->layout.output_size;
+    }
+
+    return NVJ2K_OK;
+}
+
+/**
+ * Decode output left in device memory. Holds the slot that decoded it until
+ * nvj2k_release_device_image().
+ */
+struct nvj2k_device_image {
+    pipeline_slot_t* slot;
+    nvjpeg2kDecodeParams_t decode_params;
+};
+
+#endif /* HAVE_NVJPEG2K */
+
+/*============================================================================
+ * Public API implementation
+ *============================================================================*/
+
+NVJ2K_API int nvj2k_available(void) {
+#ifdef HAVE_NVJPEG2K
+    /* Check if CUDA driver/runtime is available */
+    int device_count = 0;
+    cudaError_t err = cudaGetDeviceCount(&device_count);
+
+    /* Reset CUDA error state */
+    cudaGetLastError();
+
+    if (err != cudaSuccess || device_count == 0) {
+        return 0;
+    }
+
+    /* Check for suitable device */
+    return find_suitable_device() >= 0 ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+NVJ2K_API int nvj2k_init(int device_id) {
+#ifdef HAVE_NVJPEG2K
+    /* Find device */
+    int selected_device = device_id;
+    if (selected_device < 0) {
+        selected_device = find_suitable_device();
+        if (selected_device < 0) {
+            set_error("No suitable CUDA device found (requires compute 5.0+)");
+            return NVJ2K_ERR_NO_DEVICE;
+        }
+    }
+
+    return nvj2k_init_devices(&selected_device, 1);
+
+#else
+    (void)device_id;
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
+}
+
+NVJ2K_API int nvj2k_init_devices(const int* device_ids, int count) {
+#ifdef HAVE_NVJPEG2K
+    if (count < 0 || (count > 0 && !device_ids)) {
+        set_error("Invalid device list");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Build the candidate list: all suitable devices if none given */
+    int candidates[NVJ2K_MAX_DEVICES];
+    int num_candidates = 0;
+    if (count == 0) {
+        int device_count = 0;
+        if (cudaGetDeviceCount(&device_count) != cudaSuccess) {
+            device_count = 0;
+        }
+        for (int i = 0; i < device_count && num_candidates < NVJ2K_MAX_DEVICES; i++) {
+            if (check_compute_capability(i)) {
+                candidates[num_candidates++] = i;
+            }
+        }
+        if (num_candidates == 0) {
+            set_error("No suitable CUDA device found (requires compute 5.0+)");
+            return NVJ2K_ERR_NO_DEVICE;
+        }
+    } else {
+        if (count > NVJ2K_MAX_DEVICES) {
+            set_error("Too many devices requested");
+            return NVJ2K_ERR_INVALID_ARGUMENT;
+        }
+        for (int i = 0; i < count; i++) {
+            if (device_ids[i] < 0) {
+                set_error("Invalid device ID");
+                return NVJ2K_ERR_INVALID_ARGUMENT;
+            }
+            for (int j = 0; j < i; j++) {
+                if (device_ids[j] == device_ids[i]) {
+                    set_error("Duplicate device ID");
+                    return NVJ2K_ERR_INVALID_ARGUMENT;
+                }
+            }
+            candidates[num_candidates++] = device_ids[i];
+        }
+    }
+
+    lock();
+
+    /* Already initialized? */
+    if (g_initialized) {
+        unlock();
+        set_error("Already initialized. Call nvj2k_shutdown() first.");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    int status = context_key_create_locked();
+    if (status != NVJ2K_OK) {
+        unlock();
+        return status;
+    }
+
+    for (int i = 0; i < num_candidates; i++) {
+        status = device_create(&g_devices[i], candidates[i]);
+        if (status != NVJ2K_OK) {
+            /* Undo the devices created so far */
+            for (int j = 0; j < i; j++) {
+                nvjpeg2kDestroy(g_devices[j].handle);
+                memset(&g_devices[j], 0, sizeof(g_devices[j]));
+            }
+            unlock();
+            return status;
+        }
+    }
+
+    g_num_devices = num_candidates;
+    g_initialized = 1;
+    unlock();
+    return NVJ2K_OK;
+
+#else
+    (void)device_ids;
+    (void)count;
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
+}
+
+NVJ2K_API int nvj2k_get_device_count(void) {
+#ifdef HAVE_NVJPEG2K
+    return g_initialized ? g_num_devices : 0;
+#else
+    return 0;
+#endif
+}
+
+NVJ2K_API int nvj2k_get_device_info(nvj2k_device_info_t* info) {
+    return nvj2k_get_device_info_at(0, info);
+}
+
+NVJ2K_API int nvj2k_get_device_info_at(int index, nvj2k_device_info_t* info) {
+#ifdef HAVE_NVJPEG2K
+    if (!info) {
+        set_error("info parameter is NULL");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!g_initialized) {
+        set_error("Not initialized. Call nvj2k_init() first.");
+        return NVJ2K_ERR_NOT_INITIALIZED;
+    }
+
+    if (index < 0 || index >= g_num_devices) {
+        set_error("Device index out of range");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Refresh free memory; also feeds the device selection tie-break */
+    device_context_t* dev = &g_devices[index];
+    size_t free_mem = 0, total_mem = 0;
+    if (use_device(dev) == NVJ2K_OK && cudaMemGetInfo(&free_mem, &total_mem) == cudaSuccess) {
+        dev->info.free_memory = free_mem;
+    }
+
+    *info = dev->info;
+    return NVJ2K_OK;
+#else
+    (void)index;
+    (void)info;
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
+}
+
+NVJ2K_API int nvj2k_get_queue_depth(int index) {
+#ifdef HAVE_NVJPEG2K
+    if (!g_initialized || index < 0 || index >= g_num_devices) {
+        return 0;
+    }
+    return (int)counter_get(&g_devices[index].pending);
+#else
+    (void)index;
+    return 0;
+#endif
+}
+
+NVJ2K_API void nvj2k_shutdown(void) {
+#ifdef HAVE_NVJPEG2K
+    lock();
+
+    for (int i = 0; i < g_num_devices; i++) {
+        device_context_t* dev = &g_devices[i];
+        cudaSetDevice(dev->device_id);
+
+        /* Destroy idle and thread-bound slots while the handle is still
+         * alive. Threads notice the new generation and drop their bindings. */
+        pipeline_slot_t* lists[2] = { dev->idle_slots, dev->bound_slots };
+        for (int l = 0; l < 2; l++) {
+            while (lists[l]) {
+                pipeline_slot_t* slot = lists[l];
+                lists[l] = slot->next;
+                pool_release_locked(&g_pinned_pool, slot->h_block);
+                pool_release_locked(&dev->pool, slot->d_block);
+                slot_destroy(slot);
+            }
+        }
+
+        if (dev->handle) {
+            nvjpeg2kDestroy(dev->handle);
+        }
+
+        /* Release cached device memory */
+        pool_trim_locked(&dev->pool, 0);
+
+        memset(dev, 0, sizeof(*dev));
+    }
+
+    pool_trim_locked(&g_pinned_pool, 0);
+
+    g_num_devices = 0;
+    g_initialized = 0;
+    g_generation++;
+
+    unlock();
+#endif
+}
+
+NVJ2K_API int nvj2k_decode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_decode_result_t* result
+) {
+    return nvj2k_decode_on_device(-1, input, input_len, output, output_len, params, result);
+}
+
+NVJ2K_API int nvj2k_decode_on_device(
+    int device_index,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_decode_result_t* result
+) {
+#ifdef HAVE_NVJPEG2K
+    if (!input || input_len == 0) {
+        set_error("input is NULL or empty");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!output || output_len == 0) {
+        set_error("output is NULL or empty");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!g_initialized) {
+        set_error("Not initialized. Call nvj2k_init() first.");
+        return NVJ2K_ERR_NOT_INITIALIZED;
+    }
+
+    if (device_index >= g_num_devices) {
+        set_error("Device index out of range");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    device_context_t* dev = (device_index < 0) ? select_device() : &g_devices[device_index];
+
+    return decode_on_device(dev, input, input_len, output, output_len, params, result);
+
+#else
+    (void)device_index;
+    (void)input;
+    (void)input_len;
+    (void)output;
+    (void)output_len;
+    (void)params;
+    (void)result;
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
 }
 
 NVJ2K_API int nvj2k_decode_batch(
@@ -533,6 +1405,8 @@ NVJ2K_API int nvj2k_decode_batch(
         return 0;
     }
 
+    memset(results, 0, (size_t)count * sizeof(nvj2k_batch_result_t));
+
     if (!g_initialized) {
         set_error("Not initialized. Call nvj2k_init() first.");
         /* Mark all as failed */
@@ -542,41 +1416,72 @@ NVJ2K_API int nvj2k_decode_batch(
         return 0;
     }
 
+    /* Decode parameters are read-only and shared by all slots */
+    nvjpeg2kDecodeParams_t decode_params;
+    nvjpeg2kStatus_t nv_status = nvjpeg2kDecodeParamsCreate(&decode_params);
+    if (nv_status != NVJPEG2K_STATUS_SUCCESS) {
+        set_error_fmt("Failed to create decode params: %d", (int)nv_status);
+        for (int i = 0; i < count; i++) {
+            results[i].status = NVJ2K_ERR_INTERNAL;
+        }
+        return 0;
+    }
+
+    /*
+     * Take pipeline slots, starting with the least busy device and going
+     * round-robin so even a short batch is spread across GPUs. Run with
+     * fewer slots if some cannot be created.
+     */
+    pipeline_slot_t* slots[NVJ2K_PIPELINE_DEPTH * NVJ2K_MAX_DEVICES];
+    int max_slots = NVJ2K_PIPELINE_DEPTH * g_num_devices;
+    int wanted = (count < max_slots) ? count : max_slots;
+    int first = (int)(select_device() - g_devices);
+    int num_slots = 0;
+    for (int s = 0; s < max_slots && num_slots < wanted; s++) {
+        pipeline_slot_t* slot = slot_acquire(&g_devices[(first + s) % g_num_devices]);
+        if (slot) {
+            slots[num_slots++] = slot;
+        }
+    }
+
+    if (num_slots == 0) {
+        nvjpeg2kDecodeParamsDestroy(decode_params);
+        for (int i = 0; i < count; i++) {
+            results[i].status = NVJ2K_ERR_INTERNAL;
+        }
+        return 0;
+    }
+
     int success_count = 0;
 
-    /* Decode each frame
-     * Note: nvJPEG2000 batch API could be used here for even better
-     * performance, but for simplicity we decode sequentially with
-     * the same CUDA stream for GPU parallelism.
+    /*
+     * Before a slot is reused its previous frame is retired, so parsing
+     * frame i overlaps the GPU work already queued on the other slots.
      */
     for (int i = 0; i < count; i++) {
-        nvj2k_decode_result_t single_result;
-        int status = nvj2k_decode(
-            inputs[i],
-            input_lens[i],
-            outputs[i],
-            output_lens[i],
-            params,
-            &single_result
-        );
-
-        results[i].status = status;
-        if (status == NVJ2K_OK) {
-            results[i].width = single_result.width;
-            results[i].height = single_result.height;
-            results[i].num_components = single_result.num_components;
-            results[i].precision = single_result.precision;
-            results[i].output_size = single_result.output_size;
-            success_count++;
-        } else {
-            results[i].width = 0;
-            results[i].height = 0;
-            results[i].num_components = 0;
-            results[i].precision = 0;
-            results[i].output_size = 0;
+        if (!inputs[i] || input_lens[i] == 0 || !outputs[i] || output_lens[i] == 0) {
+            set_error("input or output is NULL or empty");
+            results[i].status = NVJ2K_ERR_INVALID_ARGUMENT;
+            continue;
         }
+
+        pipeline_slot_t* slot = next_slot(slots, num_slots, outputs, results, &success_count);
+        results[i].status = slot_submit(slot, i, inputs[i], input_lens[i], output_lens[i],
+                                        params, decode_params);
     }
 
+    /* Drain the remaining frames */
+    for (int s = 0; s < num_slots; s++) {
+        if (slots[s]->frame >= 0) {
+            success_count += slot_retire(slots[s], outputs, results);
+        }
+    }
+
+    for (int s = 0; s < num_slots; s++) {
+        slot_release(slots[s]);
+    }
+    nvjpeg2kDecodeParamsDestroy(decode_params);
+
     return success_count;
 
 #else
@@ -584,14 +1489,193 @@ NVJ2K_API int nvj2k_decode_batch(
     (void)input_lens;
     (void)outputs;
     (void)output_lens;
-    (void)count;
     (void)params;
-    (void)results;
+    if (results) {
+        for (int i = 0; i < count; i++) {
+            memset(&results[i], 0, sizeof(results[i]));
+            results[i].status = NVJ2K_ERR_UNSUPPORTED_GPU;
+        }
+    }
     set_error("nvJPEG2000 support not compiled in");
     return 0;
 #endif
 }
 
+NVJ2K_API int nvj2k_decode_to_device(
+    int device_index,
+    const uint8_t* input,
+    size_t input_len,
+    void* device_output,
+    size_t device_output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_device_result_t* result,
+    nvj2k_device_image_t** out_image
+) {
+    if (out_image) {
+        *out_image = NULL;
+    }
+
+#ifdef HAVE_NVJPEG2K
+    if (!input || input_len == 0) {
+        set_error("input is NULL or empty");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!result || !out_image) {
+        set_error("result or out_image is NULL");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    if (device_output && device_index < 0) {
+        set_error("A caller-supplied device buffer requires an explicit device index");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!g_initialized) {
+        set_error("Not initialized. Call nvj2k_init() first.");
+        return NVJ2K_ERR_NOT_INITIALIZED;
+    }
+
+    if (device_index >= g_num_devices) {
+        set_error("Device index out of range");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    device_context_t* dev = (device_index < 0) ? select_device() : &g_devices[device_index];
+
+    nvj2k_device_image_t* image = (nvj2k_device_image_t*)calloc(1, sizeof(nvj2k_device_image_t));
+    if (!image) {
+        set_error("Failed to allocate device image");
+        return NVJ2K_ERR_OUT_OF_MEMORY;
+    }
+
+    image->slot = slot_acquire(dev);
+    if (!image->slot) {
+        free(image);
+        return NVJ2K_ERR_OUT_OF_MEMORY;
+    }
+
+    nvjpeg2kStatus_t nv_status = nvjpeg2kDecodeParamsCreate(&image->decode_params);
+    if (nv_status != NVJPEG2K_STATUS_SUCCESS) {
+        slot_release(image->slot);
+        free(image);
+        set_error_fmt("Failed to create decode params: %d", (int)nv_status);
+        return NVJ2K_ERR_INTERNAL;
+    }
+
+    void* device_ptr = NULL;
+    int rc = slot_submit_device(image->slot, input, input_len, device_output, device_output_len,
+                                params, image->decode_params, &device_ptr);
+    if (rc != NVJ2K_OK) {
+        nvjpeg2kDecodeParamsDestroy(image->decode_params);
+        slot_release(image->slot);
+        free(image);
+        return rc;
+    }
+
+    const frame_layout_t* layout = &image->slot->layout;
+    result->device_ptr = device_ptr;
+    result->pitch = (size_t)layout->width * (size_t)layout->bytes_per_sample;
+    result->plane_size = result->pitch * (size_t)layout->height;
+    result->device_id = dev->device_id;
+    result->stream = (void*)image->slot->stream;
+    result->event = (void*)image->slot->done;
+    result->width = (int)layout->width;
+    result->height = (int)layout->height;
+    result->num_components = (int)layout->num_components;
+    result->precision = (int)layout->precision;
+    result->output_size = layout->output_size;
+
+    *out_image = image;
+    return NVJ2K_OK;
+
+#else
+    (void)device_index;
+    (void)input;
+    (void)input_len;
+    (void)device_output;
+    (void)device_output_len;
+    (void)params;
+    (void)result;
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
+}
+
+NVJ2K_API void nvj2k_release_device_image(nvj2k_device_image_t* image) {
+#ifdef HAVE_NVJPEG2K
+    if (!image) {
+        return;
+    }
+
+    /* The decode must be finished before its buffer can be reused */
+    pipeline_slot_t* slot = image->slot;
+    use_device(slot->device);
+    slot_wait(slot);
+
+    nvjpeg2kDecodeParamsDestroy(image->decode_params);
+    slot_release(slot);
+    free(image);
+#else
+    (void)image;
+#endif
+}
+
+NVJ2K_API int nvj2k_set_pool_limit(size_t device_bytes, size_t pinned_bytes) {
+#ifdef HAVE_NVJPEG2K
+    lock();
+    g_device_pool_limit = device_bytes;
+    for (int i = 0; i < g_num_devices; i++) {
+        g_devices[i].pool.limit = device_bytes;
+        if (g_devices[i].pool.cached_bytes > device_bytes) {
+            cudaSetDevice(g_devices[i].device_id);
+            pool_trim_locked(&g_devices[i].pool, device_bytes);
+        }
+    }
+    g_pinned_pool.limit = pinned_bytes;
+    pool_trim_locked(&g_pinned_pool, pinned_bytes);
+    unlock();
+    return NVJ2K_OK;
+#else
+    (void)device_bytes;
+    (void)pinned_bytes;
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
+}
+
+NVJ2K_API int nvj2k_get_pool_stats(nvj2k_pool_stats_t* stats) {
+    if (!stats) {
+        set_error("stats parameter is NULL");
+        return NVJ2K_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+#ifdef HAVE_NVJPEG2K
+    /* Device figures are totals across all devices */
+    lock();
+    stats->device_limit = g_device_pool_limit;
+    for (int i = 0; i < g_num_devices; i++) {
+        const memory_pool_t* pool = &g_devices[i].pool;
+        stats->device_cached_bytes += pool->cached_bytes;
+        stats->device_in_use_bytes += pool->in_use_bytes;
+        stats->device_hits += pool->hits;
+        stats->device_misses += pool->misses;
+    }
+    stats->pinned_limit = g_pinned_pool.limit;
+    stats->pinned_cached_bytes = g_pinned_pool.cached_bytes;
+    stats->pinned_in_use_bytes = g_pinned_pool.in_use_bytes;
+    stats->pinned_hits = g_pinned_pool.hits;
+    stats->pinned_misses = g_pinned_pool.misses;
+    unlock();
+    return NVJ2K_OK;
+#else
+    set_error("nvJPEG2000 support not compiled in");
+    return NVJ2K_ERR_UNSUPPORTED_GPU;
+#endif
+}
+
 NVJ2K_API const char* nvj2k_last_error(void) {
     return tls_error;
 }
@@ -70,6 +70,9 @@ typedef struct nvj2k_device_info {
     char name[256];          /* Device name */
 } nvj2k_device_info_t;
 
+/** Maximum number of GPUs the wrapper drives at once */
+#define NVJ2K_MAX_DEVICES 16
+
 /*============================================================================
  * Decode parameters
  *============================================================================*/
@@ -99,7 +102,7 @@ typedef struct nvj2k_decode_result {
  *============================================================================*/
 
 /**
- * Initialize the nvJPEG2000 wrapper.
+ * Initialize the nvJPEG2000 wrapper on a single GPU.
  * Must be called before any other functions.
  *
  * @param device_id CUDA device ID to use (-1 for default/first available)
@@ -107,6 +110,25 @@ typedef struct nvj2k_decode_result {
  */
 NVJ2K_API int nvj2k_init(int device_id);
 
+/**
+ * Initialize the nvJPEG2000 wrapper on several GPUs.
+ * Each device gets its own handle, streams, decode state and memory pool.
+ * Decodes are spread across the devices by queue depth, then free memory.
+ *
+ * @param device_ids CUDA device IDs to use (NULL for all suitable devices)
+ * @param count      Number of entries in device_ids (0 for all suitable devices,
+ *                   at most NVJ2K_MAX_DEVICES)
+ * @return NVJ2K_OK on success, error code on failure
+ */
+NVJ2K_API int nvj2k_init_devices(const int* device_ids, int count);
+
+/**
+ * Get the number of initialized devices.
+ *
+ * @return Device count, or 0 if not initialized
+ */
+NVJ2K_API int nvj2k_get_device_count(void);
+
 /**
  * Check if nvJPEG2000 GPU acceleration is available.
  * Can be called before nvj2k_init() to check availability.
@@ -116,13 +138,31 @@ NVJ2K_API int nvj2k_init(int device_id);
 NVJ2K_API int nvj2k_available(void);
 
 /**
- * Get information about the GPU being used.
+ * Get information about the GPU being used (the first initialized device).
  *
  * @param info Pointer to device info structure to fill
  * @return NVJ2K_OK on success, error code on failure
  */
 NVJ2K_API int nvj2k_get_device_info(nvj2k_device_info_t* info);
 
+/**
+ * Get information about an initialized device. Free memory is refreshed.
+ *
+ * @param index Device index (0 to nvj2k_get_device_count() - 1)
+ * @param info  Pointer to device info structure to fill
+ * @return NVJ2K_OK on success, error code on failure
+ */
+NVJ2K_API int nvj2k_get_device_info_at(int index, nvj2k_device_info_t* info);
+
+/**
+ * Get the number of frames currently queued or decoding on a device.
+ * Device-resident decodes count until they are released.
+ *
+ * @param index Device index (0 to nvj2k_get_device_count() - 1)
+ * @return Queue depth, or 0 for an invalid index
+ */
+NVJ2K_API int nvj2k_get_queue_depth(int index);
+
 /**
  * Shutdown the nvJPEG2000 wrapper and release all resources.
  * After calling this, nvj2k_init() must be called again before use.
@@ -134,7 +174,9 @@ NVJ2K_API void nvj2k_shutdown(void);
  *============================================================================*/
 
 /**
- * Decode a single JPEG 2000 codestream.
+ * Decode a single JPEG 2000 codestream on the least busy device.
+ * Each calling thread uses its own decode state and CUDA stream, so
+ * concurrent calls from different threads decode in parallel.
  *
  * @param input      Input compressed data
  * @param input_len  Length of input data in bytes
@@ -153,6 +195,28 @@ NVJ2K_API int nvj2k_decode(
     nvj2k_decode_result_t* result
 );
 
+/**
+ * Decode a single JPEG 2000 codestream on a specific device.
+ *
+ * @param device_index Device index (-1 to pick the least busy device)
+ * @param input        Input compressed data
+ * @param input_len    Length of input data in bytes
+ * @param output       Output buffer for decoded pixels
+ * @param output_len   Size of output buffer in bytes
+ * @param params       Decode parameters (NULL for defaults)
+ * @param result       Output: decode result information
+ * @return NVJ2K_OK on success, error code on failure
+ */
+NVJ2K_API int nvj2k_decode_on_device(
+    int device_index,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_decode_result_t* result
+);
+
 /*============================================================================
  * Batch decoding
  *============================================================================*/
@@ -171,7 +235,11 @@ typedef struct nvj2k_batch_result {
 
 /**
  * Decode multiple JPEG 2000 codestreams in batch.
- * More efficient than multiple nvj2k_decode() calls for multi-frame images.
+ * More efficient than multiple nvj2k_decode() calls for multi-frame images:
+ * frames are pipelined across several CUDA streams and decode states, so
+ * parsing, GPU decode and the copy back to host memory of consecutive
+ * frames overlap. With several devices initialized, frames are distributed
+ * across all of them and each next frame goes to the first free slot.
  *
  * @param inputs       Array of input data pointers
  * @param input_lens   Array of input data lengths
@@ -192,6 +260,118 @@ NVJ2K_API int nvj2k_decode_batch(
     nvj2k_batch_result_t* results
 );
 
+/*============================================================================
+ * Device-resident decoding
+ *============================================================================*/
+
+/**
+ * Opaque handle to a decoded image kept in device memory.
+ */
+typedef struct nvj2k_device_image nvj2k_device_image_t;
+
+/**
+ * Result of a decode into device memory.
+ * Output is planar: component c starts at device_ptr + c * plane_size,
+ * and each row holds width * ceil(precision / 8) bytes.
+ */
+typedef struct nvj2k_device_result {
+    void* device_ptr;        /* Decoded pixels in device memory */
+    size_t pitch;            /* Bytes per row of one component */
+    size_t plane_size;       /* Bytes per component plane */
+    int device_id;           /* CUDA device holding the output */
+    void* stream;            /* cudaStream_t the decode was enqueued on */
+    void* event;             /* cudaEvent_t recorded when the output is ready */
+    int width;               /* Decoded image width */
+    int height;              /* Decoded image height */
+    int num_components;      /* Number of components */
+    int precision;           /* Bit depth per component */
+    size_t output_size;      /* Size of decoded data in bytes */
+} nvj2k_device_result_t;
+
+/**
+ * Decode a JPEG 2000 codestream into device memory without copying it
+ * back to the host. The call returns once the decode is enqueued; make
+ * consumer streams wait on result->event (cudaStreamWaitEvent) before
+ * reading the output.
+ *
+ * @param device_index      Device index (-1 to pick the least busy device;
+ *                          required when device_output is given)
+ * @param input             Input compressed data
+ * @param input_len         Length of input data in bytes
+ * @param device_output     Device buffer on that device to decode into
+ *                          (NULL to use a buffer from the device pool)
+ * @param device_output_len Size of device_output in bytes
+ * @param params            Decode parameters (NULL for defaults)
+ * @param result            Output: device pointer, layout and sync objects
+ * @param out_image         Output: handle to pass to nvj2k_release_device_image()
+ * @return NVJ2K_OK on success, error code on failure
+ */
+NVJ2K_API int nvj2k_decode_to_device(
+    int device_index,
+    const uint8_t* input,
+    size_t input_len,
+    void* device_output,
+    size_t device_output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_device_result_t* result,
+    nvj2k_device_image_t** out_image
+);
+
+/**
+ * Release a device-resident decode. Waits for the decode to finish, then
+ * returns its stream and any pooled output buffer for reuse. Consumer work
+ * reading a pooled output must have completed before this call. All images
+ * must be released before nvj2k_shutdown(). NULL is ignored.
+ *
+ * @param image Handle from nvj2k_decode_to_device()
+ */
+NVJ2K_API void nvj2k_release_device_image(nvj2k_device_image_t* image);
+
+/*============================================================================
+ * Memory pools
+ *============================================================================*/
+
+/**
+ * Memory pool statistics.
+ *
+ * Device output buffers and pinned host staging buffers used by
+ * nvj2k_decode() and nvj2k_decode_batch() are recycled through size-class
+ * pools. Hits are requests served from cached memory; misses required a
+ * CUDA allocation. Device figures are totals over all initialized devices.
+ */
+typedef struct nvj2k_pool_stats {
+    size_t device_limit;         /* Maximum idle device bytes kept */
+    size_t device_cached_bytes;  /* Idle device bytes currently held */
+    size_t device_in_use_bytes;  /* Device bytes handed out to decodes */
+    uint64_t device_hits;        /* Device requests served from the pool */
+    uint64_t device_misses;      /* Device requests that called cudaMalloc */
+    size_t pinned_limit;         /* Maximum idle pinned bytes kept */
+    size_t pinned_cached_bytes;  /* Idle pinned bytes currently held */
+    size_t pinned_in_use_bytes;  /* Pinned bytes handed out to decodes */
+    uint64_t pinned_hits;        /* Pinned requests served from the pool */
+    uint64_t pinned_misses;      /* Pinned requests that called cudaMallocHost */
+} nvj2k_pool_stats_t;
+
+/**
+ * Set the maximum number of idle bytes each pool keeps cached. The device
+ * limit applies to each device separately.
+ * Memory above the new limit is released immediately; buffers in use are
+ * unaffected. A limit of 0 disables caching. May be called before nvj2k_init().
+ *
+ * @param device_bytes Idle device memory cap (default 512 MiB)
+ * @param pinned_bytes Idle pinned host memory cap (default 256 MiB)
+ * @return NVJ2K_OK on success, error code on failure
+ */
+NVJ2K_API int nvj2k_set_pool_limit(size_t device_bytes, size_t pinned_bytes);
+
+/**
+ * Get memory pool statistics. Counters accumulate for the process lifetime.
+ *
+ * @param stats Pointer to statistics structure to fill
+ * @return NVJ2K_OK on success, error code on failure
+ */
+NVJ2K_API int nvj2k_get_pool_stats(nvj2k_pool_stats_t* stats);
+
 /*============================================================================
  * Error handling
  *============================================================================*/
@@ -107,20 +107,61 @@ int main(void) {
         tests_failed++;
     }
 
+    /* Test 8: pool statistics */
+    printf("Test 8: nvj2k_get_pool_stats()... ");
+    nvj2k_pool_stats_t pool_stats;
+    result = nvj2k_get_pool_stats(&pool_stats);
+    if (nvj2k_get_pool_stats(NULL) == NVJ2K_ERR_INVALID_ARGUMENT &&
+        (result == NVJ2K_OK || result == NVJ2K_ERR_UNSUPPORTED_GPU) &&
+        pool_stats.device_in_use_bytes == 0 && pool_stats.pinned_in_use_bytes == 0) {
+        printf("PASSED\n");
+        tests_passed++;
+    } else {
+        printf("FAILED (result: %d)\n", result);
+        tests_failed++;
+    }
+
+    /* Test 9: device queries without init */
+    printf("Test 9: nvj2k_get_device_count() without init... ");
+    nvj2k_device_info_t indexed_info;
+    if (nvj2k_get_device_count() == 0 && nvj2k_get_queue_depth(0) == 0 &&
+        nvj2k_get_device_info_at(0, &indexed_info) != NVJ2K_OK) {
+        printf("PASSED\n");
+        tests_passed++;
+    } else {
+        printf("FAILED\n");
+        tests_failed++;
+    }
+
+    /* Test 10: device-resident decode without init */
+    printf("Test 10: nvj2k_decode_to_device() without init... ");
+    nvj2k_device_result_t device_result;
+    nvj2k_device_image_t* device_image = (nvj2k_device_image_t*)&device_result;
+    result = nvj2k_decode_to_device(-1, dummy_input, sizeof(dummy_input), NULL, 0,
+                                    NULL, &device_result, &device_image);
+    nvj2k_release_device_image(NULL);
+    if (result != NVJ2K_OK && device_image == NULL) {
+        printf("PASSED\n");
+        tests_passed++;
+    } else {
+        printf("FAILED (result: %d)\n", result);
+        tests_failed++;
+    }
+
     /* If GPU is available, test initialization */
     if (available) {
         printf("\nGPU Availability Tests\n");
         printf("-----------------------\n");
 
-        /* Test 8: Initialize */
-        printf("Test 8: nvj2k_init(-1)... ");
+        /* Test 11: Initialize */
+        printf("Test 11: nvj2k_init(-1)... ");
         result = nvj2k_init(-1);
         if (result == NVJ2K_OK) {
             printf("PASSED\n");
             tests_passed++;
 
-            /* Test 9: Get device info after init */
-            printf("Test 9: nvj2k_get_device_info() after init... ");
+            /* Test 12: Get device info after init */
+            printf("Test 12: nvj2k_get_device_info() after init... ");
             result = nvj2k_get_device_info(&info);
             if (result == NVJ2K_OK) {
                 printf("PASSED\n");
@@ -135,14 +176,14 @@ int main(void) {
                 tests_failed++;
             }
 
-            /* Test 10: Shutdown */
-            printf("Test 10: nvj2k_shutdown()... ");
+            /* Test 13: Shutdown */
+            printf("Test 13: nvj2k_shutdown()... ");
             nvj2k_shutdown();
             printf("PASSED\n");
             tests_passed++;
 
-            /* Test 11: After shutdown, should be NOT_INITIALIZED */
-            printf("Test 11: After shutdown state... ");
+            /* Test 14: After shutdown, should be NOT_INITIALIZED */
+            printf("Test 14: After shutdown state... ");
             result = nvj2k_get_device_info(&info);
             if (result == NVJ2K_ERR_NOT_INITIALIZED) {
                 printf("PASSED\n");
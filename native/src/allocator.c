@@ -0,0 +1,323 @@
+/**
+ * SharpDicom Memory Allocator Implementation
+ *
+ * Each block starts with a header holding the backing allocation, the
+ * usable capacity and the size class, placed just in front of the 32-byte
+ * aligned pointer handed out. Cacheable blocks are rounded up to their size
+ * class, so a freed block fits any later request of the same class; the
+ * thread cache keeps a few blocks per class and hands them back out LIFO.
+ *
+ * A thread registers its cache on its first free, and the cache is drained
+ * from a thread-exit destructor (pthread key / fiber-local storage).
+ */
+
+/* pthread_key_create() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "allocator.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Forward declaration from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+
+#if defined(_MSC_VER)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+/*============================================================================
+ * Size classes
+ *============================================================================*/
+
+#define CACHE_MIN_SHIFT         16  /* log2(ALLOCATOR_CACHE_MIN_SIZE) */
+#define CACHE_MAX_SHIFT         31  /* Blocks of 2 GiB and more are not cached */
+#define CACHE_SUBCLASSES        4   /* Classes per power of two */
+#define CACHE_CLASSES           ((CACHE_MAX_SHIFT - CACHE_MIN_SHIFT) * CACHE_SUBCLASSES)
+#define CACHE_BLOCKS_PER_CLASS  4
+
+static int floor_log2(size_t value) {
+    int shift = 0;
+    while (value >>= 1) {
+        shift++;
+    }
+    return shift;
+}
+
+/**
+ * Finds the size class of a request and the capacity a block of it gets:
+ * sizes are rounded up to a multiple of a quarter of their power of two.
+ *
+ * @return Class index, or -1 for blocks that are not cached (capacity = size)
+ */
+static int size_class(size_t size, size_t* capacity) {
+    *capacity = size;
+    if (size < ALLOCATOR_CACHE_MIN_SIZE) return -1;
+
+    int shift = floor_log2(size);
+    if (shift >= CACHE_MAX_SHIFT) return -1;
+
+    size_t step = (size_t)1 << (shift - 2);
+    size_t rounded = (size + step - 1) & ~(step - 1);
+    if (rounded == ((size_t)2 << shift)) {
+        shift++;
+        if (shift >= CACHE_MAX_SHIFT) return -1;
+    }
+
+    *capacity = rounded;
+    return (shift - CACHE_MIN_SHIFT) * CACHE_SUBCLASSES +
+           (int)(rounded >> (shift - 2)) - CACHE_SUBCLASSES;
+}
+
+/*============================================================================
+ * Blocks
+ *============================================================================*/
+
+typedef struct {
+    /** Pointer returned by the backing allocator */
+    void* base;
+    /** Usable bytes from the block pointer */
+    size_t capacity;
+    /** Size class, or -1 if the block is never cached */
+    int32_t size_class;
+} block_header;
+
+static void* heap_alloc(void* opaque, size_t size) {
+    (void)opaque;
+    return malloc(size);
+}
+
+static void heap_free(void* opaque, void* ptr) {
+    (void)opaque;
+    free(ptr);
+}
+
+static sharpdicom_allocator_t g_backing = { heap_alloc, heap_free, NULL };
+
+/** Set once the first block is allocated; the backing allocator is fixed from then on */
+static volatile int32_t g_backing_used = 0;
+
+/** Read without a lock: a new limit applies from the next free on each thread */
+static volatile size_t g_cache_limit = ALLOCATOR_DEFAULT_CACHE_LIMIT;
+
+static block_header* header_of(void* ptr) {
+    return (block_header*)((uint8_t*)ptr - ALLOCATOR_ALIGNMENT);
+}
+
+static void* block_new(size_t capacity, int size_class) {
+    /* Header in the first aligned slot, plus slack to align the block itself */
+    if (capacity > SIZE_MAX - 2 * ALLOCATOR_ALIGNMENT) return NULL;
+
+    g_backing_used = 1;
+    uint8_t* base = (uint8_t*)g_backing.alloc(g_backing.opaque, capacity + 2 * ALLOCATOR_ALIGNMENT);
+    if (base == NULL) return NULL;
+
+    uintptr_t address = ((uintptr_t)base + 2 * ALLOCATOR_ALIGNMENT - 1) &
+                        ~(uintptr_t)(ALLOCATOR_ALIGNMENT - 1);
+    void* ptr = (void*)address;
+
+    block_header* header = header_of(ptr);
+    header->base = base;
+    header->capacity = capacity;
+    header->size_class = size_class;
+    return ptr;
+}
+
+static void block_release(void* ptr) {
+    g_backing.free(g_backing.opaque, header_of(ptr)->base);
+}
+
+/*============================================================================
+ * Thread cache
+ *============================================================================*/
+
+#define CACHE_UNREGISTERED  0  /* No free on this thread yet */
+#define CACHE_ACTIVE        1  /* Drained when the thread exits */
+#define CACHE_CLOSED        2  /* Thread is exiting, or no exit hook was available */
+
+typedef struct {
+    void* blocks[CACHE_CLASSES][CACHE_BLOCKS_PER_CLASS];
+    uint8_t counts[CACHE_CLASSES];
+    size_t bytes;
+    int32_t state;
+} thread_cache;
+
+static THREAD_LOCAL thread_cache tls_cache;
+
+static void cache_drain(thread_cache* cache) {
+    for (int c = 0; c < CACHE_CLASSES; c++) {
+        while (cache->counts[c] > 0) {
+            block_release(cache->blocks[c][--cache->counts[c]]);
+        }
+    }
+    cache->bytes = 0;
+}
+
+static void cache_thread_exit(thread_cache* cache) {
+    cache_drain(cache);
+    /* Frees from later destructors on this thread go straight back */
+    cache->state = CACHE_CLOSED;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+
+static DWORD g_cache_fls = FLS_OUT_OF_INDEXES;
+static volatile LONG g_cache_fls_init = 0;
+
+static VOID NTAPI cache_fls_callback(PVOID data) {
+    if (data != NULL) cache_thread_exit((thread_cache*)data);
+}
+
+static int register_thread_exit(thread_cache* cache) {
+    /* Same one-time initialization as thread_pool.c */
+    if (g_cache_fls_init != 2) {
+        LONG state = InterlockedCompareExchange(&g_cache_fls_init, 1, 0);
+        if (state == 0) {
+            g_cache_fls = FlsAlloc(cache_fls_callback);
+            InterlockedExchange(&g_cache_fls_init, 2);
+        } else {
+            while (g_cache_fls_init != 2) {
+                Sleep(0);
+            }
+        }
+    }
+    return g_cache_fls != FLS_OUT_OF_INDEXES && FlsSetValue(g_cache_fls, cache);
+}
+#else
+    #include <pthread.h>
+
+static pthread_key_t g_cache_key;
+static pthread_once_t g_cache_key_once = PTHREAD_ONCE_INIT;
+static int g_cache_key_valid = 0;
+
+static void cache_key_destructor(void* data) {
+    cache_thread_exit((thread_cache*)data);
+}
+
+static void cache_key_create(void) {
+    g_cache_key_valid = (pthread_key_create(&g_cache_key, cache_key_destructor) == 0);
+}
+
+static int register_thread_exit(thread_cache* cache) {
+    pthread_once(&g_cache_key_once, cache_key_create);
+    return g_cache_key_valid && pthread_setspecific(g_cache_key, cache) == 0;
+}
+#endif
+
+/**
+ * Gets the calling thread's cache for storing a block, registering the
+ * thread-exit hook on first use. Without the hook a cache would leak when
+ * its thread ends, so such threads do not cache.
+ */
+static thread_cache* cache_for_store(void) {
+    thread_cache* cache = &tls_cache;
+    if (cache->state == CACHE_UNREGISTERED) {
+        cache->state = register_thread_exit(cache) ? CACHE_ACTIVE : CACHE_CLOSED;
+    }
+    return (cache->state == CACHE_ACTIVE) ? cache : NULL;
+}
+
+/*============================================================================
+ * Allocation functions
+ *============================================================================*/
+
+void* allocator_alloc(size_t size) {
+    if (size == 0) size = 1;
+
+    size_t capacity;
+    int size_class_index = size_class(size, &capacity);
+    if (size_class_index >= 0) {
+        thread_cache* cache = &tls_cache;
+        if (cache->counts[size_class_index] > 0) {
+            void* ptr = cache->blocks[size_class_index][--cache->counts[size_class_index]];
+            cache->bytes -= header_of(ptr)->capacity;
+            return ptr;
+        }
+    }
+    return block_new(capacity, size_class_index);
+}
+
+void* allocator_calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+
+    size_t total = count * size;
+    void* ptr = allocator_alloc(total);
+    if (ptr != NULL) {
+        memset(ptr, 0, total);
+    }
+    return ptr;
+}
+
+void* allocator_realloc(void* ptr, size_t size) {
+    if (ptr == NULL) return allocator_alloc(size);
+
+    size_t capacity = header_of(ptr)->capacity;
+    if (size <= capacity) return ptr;
+
+    void* grown = allocator_alloc(size);
+    if (grown == NULL) return NULL;
+    memcpy(grown, ptr, capacity);
+    allocator_free(ptr);
+    return grown;
+}
+
+void allocator_free(void* ptr) {
+    if (ptr == NULL) return;
+
+    block_header* header = header_of(ptr);
+    if (header->size_class >= 0) {
+        size_t limit = g_cache_limit;
+        thread_cache* cache = cache_for_store();
+        if (cache != NULL &&
+            cache->counts[header->size_class] < CACHE_BLOCKS_PER_CLASS &&
+            cache->bytes <= limit && header->capacity <= limit - cache->bytes) {
+            cache->blocks[header->size_class][cache->counts[header->size_class]++] = ptr;
+            cache->bytes += header->capacity;
+            return;
+        }
+    }
+    block_release(ptr);
+}
+
+/*============================================================================
+ * Configuration
+ *============================================================================*/
+
+int allocator_set_backing(const sharpdicom_allocator_t* backing) {
+    if (backing != NULL && (backing->alloc == NULL || backing->free == NULL)) {
+        set_error("Invalid argument: allocator needs both alloc and free callbacks");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (g_backing_used) {
+        set_error("Allocator cannot be changed after memory has been allocated");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (backing != NULL) {
+        g_backing = *backing;
+    } else {
+        g_backing.alloc = heap_alloc;
+        g_backing.free = heap_free;
+        g_backing.opaque = NULL;
+    }
+    return SHARPDICOM_OK;
+}
+
+void allocator_set_cache_limit(size_t bytes) {
+    g_cache_limit = bytes;
+}
+
+size_t allocator_cache_limit(void) {
+    return g_cache_limit;
+}
+
+void allocator_release_thread_cache(void) {
+    cache_drain(&tls_cache);
+}
@@ -0,0 +1,90 @@
+/**
+ * SharpDicom Memory Allocator
+ *
+ * Allocation entry points for the library's own working memory and for
+ * the codec libraries that accept allocation hooks (OpenJPEG, zlib-ng).
+ * Memory comes from the allocator installed with sharpdicom_set_allocator()
+ * (the C heap by default); blocks of 64 KiB and more are rounded to one of
+ * four size classes per power of two and kept in a per-thread cache when
+ * freed, so the next frame of the same geometry on that thread reuses them
+ * without going back to the heap.
+ *
+ * Every pointer is 32-byte aligned and must be released with
+ * allocator_free(). Buffers returned to callers of the exported API (the
+ * ones released with j2k_free(), jls_free(), rle_free() or jpeg_free())
+ * stay on the C heap and do not come from here.
+ *
+ * Internal to the native library - not part of the exported API.
+ * Thread Safety: All functions are thread-safe. A block may be freed on a
+ * different thread than the one that allocated it.
+ */
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Alignment of every allocator block */
+#define ALLOCATOR_ALIGNMENT 32
+
+/** Smallest block kept in the thread cache */
+#define ALLOCATOR_CACHE_MIN_SIZE ((size_t)64 * 1024)
+
+/** Default bytes one thread may keep cached */
+#define ALLOCATOR_DEFAULT_CACHE_LIMIT ((size_t)64 * 1024 * 1024)
+
+/**
+ * Allocates a block of at least size bytes (1 if size is 0).
+ *
+ * @return Block, or NULL if out of memory
+ */
+void* allocator_alloc(size_t size);
+
+/**
+ * Allocates a zeroed block of count * size bytes.
+ *
+ * @return Block, or NULL if out of memory or the size overflows
+ */
+void* allocator_calloc(size_t count, size_t size);
+
+/**
+ * Resizes a block, keeping its contents (malloc when ptr is NULL).
+ * The block is reused in place while it is large enough.
+ *
+ * @return Resized block, or NULL if out of memory (ptr is still valid)
+ */
+void* allocator_realloc(void* ptr, size_t size);
+
+/**
+ * Releases a block (NULL is ignored). Cacheable blocks go to the calling
+ * thread's cache while it is under its limit.
+ */
+void allocator_free(void* ptr);
+
+/**
+ * Installs the backing allocator (NULL = C heap). Only possible before the
+ * first block is allocated.
+ *
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT if a callback
+ *         is missing or blocks were already allocated
+ */
+int allocator_set_backing(const sharpdicom_allocator_t* backing);
+
+/** Sets the bytes each thread may keep cached (0 disables caching). */
+void allocator_set_cache_limit(size_t bytes);
+
+/** Gets the per-thread cache limit in bytes. */
+size_t allocator_cache_limit(void);
+
+/** Returns every block cached by the calling thread to the backing allocator. */
+void allocator_release_thread_cache(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALLOCATOR_H */
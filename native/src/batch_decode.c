@@ -0,0 +1,350 @@
+/**
+ * SharpDicom Multi-Frame Batch Decode Implementation
+ *
+ * Frames are spread over the shared worker pool (thread_pool.h). Each
+ * worker decodes with its own thread-local codec handles: libjpeg-turbo
+ * handles inside jpeg_wrapper.c, and one jls_decoder_t per thread here.
+ * OpenJPEG codecs are single-use, so J2K frames get a fresh decoder each.
+ *
+ * The JPEG-LS decoder is destroyed from a thread-exit destructor (pthread
+ * key / fiber-local storage), so retired pool workers do not leak it.
+ */
+
+/* pthread_key_create() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "batch_decode.h"
+#include "jpeg_wrapper.h"
+#include "jls_wrapper.h"
+#include "thread_pool.h"
+
+#include <limits.h>
+#include <string.h>
+
+/* Forward declaration from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+
+#if defined(_MSC_VER)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #define claim_flag(p) (InterlockedCompareExchange((volatile LONG*)(p), 1, 0) == 0)
+#else
+    static int claim_flag(volatile int32_t* p) {
+        int32_t expected = 0;
+        return __atomic_compare_exchange_n(p, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+#endif
+
+/** Reused JPEG-LS decoder of the current thread (created on first use) */
+static THREAD_LOCAL jls_decoder_t* tls_jls_decoder = NULL;
+
+static void decoder_thread_exit(jls_decoder_t** decoder) {
+    jls_decoder_destroy(*decoder);
+    *decoder = NULL;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+static DWORD g_decoder_fls = FLS_OUT_OF_INDEXES;
+static volatile LONG g_decoder_fls_init = 0;
+
+static VOID NTAPI decoder_fls_callback(PVOID data) {
+    if (data != NULL) decoder_thread_exit((jls_decoder_t**)data);
+}
+
+static int register_thread_exit(jls_decoder_t** decoder) {
+    /* Same one-time initialization as allocator.c */
+    if (g_decoder_fls_init != 2) {
+        LONG state = InterlockedCompareExchange(&g_decoder_fls_init, 1, 0);
+        if (state == 0) {
+            g_decoder_fls = FlsAlloc(decoder_fls_callback);
+            InterlockedExchange(&g_decoder_fls_init, 2);
+        } else {
+            while (g_decoder_fls_init != 2) {
+                Sleep(0);
+            }
+        }
+    }
+    return g_decoder_fls != FLS_OUT_OF_INDEXES && FlsSetValue(g_decoder_fls, decoder);
+}
+#else
+    #include <pthread.h>
+
+static pthread_key_t g_decoder_key;
+static pthread_once_t g_decoder_key_once = PTHREAD_ONCE_INIT;
+static int g_decoder_key_valid = 0;
+
+static void decoder_key_destructor(void* data) {
+    decoder_thread_exit((jls_decoder_t**)data);
+}
+
+static void decoder_key_create(void) {
+    g_decoder_key_valid = (pthread_key_create(&g_decoder_key, decoder_key_destructor) == 0);
+}
+
+static int register_thread_exit(jls_decoder_t** decoder) {
+    pthread_once(&g_decoder_key_once, decoder_key_create);
+    return g_decoder_key_valid && pthread_setspecific(g_decoder_key, decoder) == 0;
+}
+#endif
+
+/*============================================================================
+ * Per-frame decoders
+ *============================================================================*/
+
+static int decode_jpeg_frame(
+    const uint8_t* input, size_t input_len,
+    uint8_t* output, size_t output_len,
+    const batch_decode_options_t* options,
+    batch_decode_result_t* result
+) {
+    if (input_len > INT_MAX) {
+        set_error("JPEG frame too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    /* jpeg_decode() checks the size it needs, so clamping the capacity is safe */
+    int capacity = (output_len > INT_MAX) ? INT_MAX : (int)output_len;
+
+    int width = 0, height = 0, components = 0;
+    int status = jpeg_decode(input, (int)input_len, output, capacity,
+                             &width, &height, &components, options->jpeg_colorspace);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    result->width = width;
+    result->height = height;
+    result->num_components = components;
+    result->precision = 8;
+    result->output_size = (size_t)width * (size_t)height * (size_t)components;
+    return SHARPDICOM_OK;
+}
+
+static int decode_jls_frame(
+    const uint8_t* input, size_t input_len,
+    uint8_t* output, size_t output_len,
+    batch_decode_result_t* result
+) {
+    /* Without the exit hook the decoder would leak with its thread, so it is not kept */
+    int keep = 1;
+    if (tls_jls_decoder == NULL) {
+        int status = jls_decoder_create(&tls_jls_decoder);
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+        keep = register_thread_exit(&tls_jls_decoder);
+    }
+
+    size_t size = output_len;
+    jls_decode_params_t params;
+    memset(&params, 0, sizeof(params));
+    int status = jls_decoder_decode_frame(tls_jls_decoder, input, input_len,
+                                          &output, &size, &params);
+    if (!keep) {
+        decoder_thread_exit(&tls_jls_decoder);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    result->width = params.width;
+    result->height = params.height;
+    result->num_components = params.components;
+    result->precision = params.bits_per_sample;
+    result->output_size = size;
+    return SHARPDICOM_OK;
+}
+
+static int decode_j2k_frame(
+    const uint8_t* input, size_t input_len,
+    uint8_t* output, size_t output_len,
+    const J2kDecodeOptions* j2k_options,
+    batch_decode_result_t* result
+) {
+    j2k_decoder_t* decoder = NULL;
+    int status = j2k_decoder_create(j2k_options, &decoder);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    J2kImageInfo info;
+    int32_t width = 0, height = 0, components = 0;
+    status = j2k_decoder_set_input(decoder, input, input_len);
+    if (status == SHARPDICOM_OK) {
+        status = j2k_decoder_get_info(decoder, &info);
+    }
+    if (status == SHARPDICOM_OK) {
+        status = j2k_decoder_decode(decoder, output, output_len, &width, &height, &components);
+    }
+    j2k_decoder_destroy(decoder);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    /* Display output is one byte per sample */
+    int display = (j2k_options && j2k_options->display);
+    size_t bytes_per_sample = (info.bits_per_component <= 8 || display) ? 1 : 2;
+    result->width = width;
+    result->height = height;
+    result->num_components = components;
+    result->precision = info.bits_per_component;
+    result->output_size = (size_t)width * (size_t)height * (size_t)components * bytes_per_sample;
+    return SHARPDICOM_OK;
+}
+
+static int decode_rle_frame(
+    const uint8_t* input, size_t input_len,
+    uint8_t* output, size_t output_len,
+    const rle_params_t* params,
+    batch_decode_result_t* result
+) {
+    size_t size = 0;
+    int status = rle_get_decode_size(params, &size);
+    if (status == SHARPDICOM_OK) {
+        status = rle_decode(input, input_len, output, output_len, params);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    result->width = params->width;
+    result->height = params->height;
+    result->num_components = params->samples_per_pixel;
+    result->precision = params->bits_allocated;
+    result->output_size = size;
+    return SHARPDICOM_OK;
+}
+
+/*============================================================================
+ * Batch loop
+ *============================================================================*/
+
+typedef struct {
+    int codec;
+    const uint8_t** inputs;
+    const size_t* input_lens;
+    uint8_t** outputs;
+    const size_t* output_lens;
+    const batch_decode_options_t* options;
+    J2kDecodeOptions j2k;
+    batch_decode_result_t* results;
+    /** Set by the first frame to fail, which then owns 'error' */
+    volatile int32_t error_claimed;
+    char error[256];
+} batch_context;
+
+static void decode_frame_task(void* context, size_t index) {
+    batch_context* ctx = (batch_context*)context;
+    batch_decode_result_t* result = &ctx->results[index];
+    const uint8_t* input = ctx->inputs[index];
+    size_t input_len = ctx->input_lens[index];
+    uint8_t* output = ctx->outputs[index];
+    size_t output_len = ctx->output_lens[index];
+
+    memset(result, 0, sizeof(*result));
+
+    int status;
+    if (!input || input_len == 0 || !output) {
+        set_error("Invalid batch frame: NULL buffer or empty input");
+        status = SHARPDICOM_ERR_INVALID_ARGUMENT;
+    } else {
+        switch (ctx->codec) {
+            case BATCH_CODEC_JPEG:
+                status = decode_jpeg_frame(input, input_len, output, output_len, ctx->options, result);
+                break;
+            case BATCH_CODEC_JPEG_LS:
+                status = decode_jls_frame(input, input_len, output, output_len, result);
+                break;
+            case BATCH_CODEC_J2K:
+                status = decode_j2k_frame(input, input_len, output, output_len, &ctx->j2k, result);
+                break;
+            default:
+                status = decode_rle_frame(input, input_len, output, output_len, &ctx->options->rle, result);
+                break;
+        }
+    }
+
+    result->status = status;
+    if (status != SHARPDICOM_OK && claim_flag(&ctx->error_claimed)) {
+        /* The message is in this thread's error slot; hand it to the caller */
+        const char* message = sharpdicom_last_error();
+        strncpy(ctx->error, message ? message : "Batch frame decode failed", sizeof(ctx->error) - 1);
+        ctx->error[sizeof(ctx->error) - 1] = '\0';
+    }
+}
+
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+SHARPDICOM_API int batch_decode(
+    int codec,
+    const uint8_t** inputs,
+    const size_t* input_lens,
+    uint8_t** outputs,
+    const size_t* output_lens,
+    int count,
+    const batch_decode_options_t* options,
+    batch_decode_result_t* results
+) {
+    if (!inputs || !input_lens || !outputs || !output_lens || !results || count <= 0) {
+        set_error("Invalid batch decode arguments");
+        return 0;
+    }
+    if (codec < BATCH_CODEC_JPEG || codec > BATCH_CODEC_RLE) {
+        set_error("Unknown batch codec");
+        return 0;
+    }
+
+    batch_decode_options_t defaults;
+    if (!options) {
+        if (codec == BATCH_CODEC_RLE) {
+            set_error("RLE batch decode requires options with frame geometry");
+            return 0;
+        }
+        memset(&defaults, 0, sizeof(defaults));
+        defaults.jpeg_colorspace = JPEG_CS_RGB;
+        options = &defaults;
+    }
+
+    batch_context ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.codec = codec;
+    ctx.inputs = inputs;
+    ctx.input_lens = input_lens;
+    ctx.outputs = outputs;
+    ctx.output_lens = output_lens;
+    ctx.options = options;
+    ctx.results = results;
+
+    /* Frames already run in parallel; keep OpenJPEG from starting its own threads */
+    ctx.j2k = options->j2k;
+    if (options->max_threads != 1) {
+        ctx.j2k.num_threads = 1;
+    }
+
+    int status = thread_pool_parallel_for((size_t)count, options->max_threads, decode_frame_task, &ctx);
+    if (status != SHARPDICOM_OK) {
+        return 0;
+    }
+
+    int success_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (results[i].status == SHARPDICOM_OK) {
+            success_count++;
+        }
+    }
+    if (ctx.error_claimed) {
+        set_error(ctx.error);
+    }
+    return success_count;
+}
@@ -0,0 +1,100 @@
+/**
+ * SharpDicom Multi-Frame Batch Decode API
+ *
+ * Decodes all frames of a multi-frame object in one call on the shared
+ * native worker pool, instead of one managed call per frame. Frames run in
+ * parallel; each worker reuses its thread-local codec handles.
+ *
+ * Thread Safety: All functions are thread-safe. Concurrent batches share
+ * the same worker pool.
+ */
+
+#ifndef BATCH_DECODE_H
+#define BATCH_DECODE_H
+
+#include "sharpdicom_codecs.h"
+#include "j2k_wrapper.h"
+#include "rle_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================
+ * Codec identifiers
+ *============================================================================*/
+
+#define BATCH_CODEC_JPEG        1   /* JPEG 8-bit baseline/extended (1.2.840.10008.1.2.4.50/51) */
+#define BATCH_CODEC_JPEG_LS     2   /* JPEG-LS lossless/near-lossless (1.2.840.10008.1.2.4.80/81) */
+#define BATCH_CODEC_J2K         3   /* JPEG 2000 / HTJ2K (1.2.840.10008.1.2.4.90/91, 4.201-203) */
+#define BATCH_CODEC_RLE         4   /* RLE Lossless (1.2.840.10008.1.2.5) */
+
+/*============================================================================
+ * Batch structures
+ *============================================================================*/
+
+/**
+ * Options shared by every frame of a batch.
+ */
+typedef struct {
+    /** Threads to decode on, including the caller (0 = whole pool, 1 = calling thread only) */
+    int32_t max_threads;
+    /** JPEG output colorspace (JpegColorspace value; JPEG_CS_RGB keeps grayscale as-is) */
+    int32_t jpeg_colorspace;
+    /** JPEG 2000 options; num_threads only applies when the batch runs on one thread */
+    J2kDecodeOptions j2k;
+    /** RLE frame geometry (required for BATCH_CODEC_RLE, ignored otherwise) */
+    rle_params_t rle;
+} batch_decode_options_t;
+
+/**
+ * Result for a single frame; mirrors gpu_batch_result_t.
+ */
+typedef struct {
+    int status;              /* SHARPDICOM_OK or error code */
+    int width;               /* Decoded width */
+    int height;              /* Decoded height */
+    int num_components;      /* Number of components */
+    int precision;           /* Bits per sample */
+    size_t output_size;      /* Bytes written to the frame's output buffer */
+} batch_decode_result_t;
+
+/*============================================================================
+ * Batch API functions
+ *============================================================================*/
+
+/**
+ * Decodes a batch of frames with one codec.
+ *
+ * Every frame is decoded into its own caller-allocated buffer and gets its
+ * own result; one failing frame does not stop the others. If any frame
+ * fails, the error message of a failed frame is left for
+ * sharpdicom_last_error() on the calling thread.
+ *
+ * @param codec         BATCH_CODEC_* identifier
+ * @param inputs        Array of compressed frame pointers
+ * @param input_lens    Array of compressed frame lengths
+ * @param outputs       Array of output buffer pointers
+ * @param output_lens   Array of output buffer sizes
+ * @param count         Number of frames
+ * @param options       Batch options (can be NULL for defaults, except for RLE)
+ * @param results       Array of per-frame results (must have 'count' elements)
+ *
+ * @return Number of successfully decoded frames (0 with an error message on bad arguments)
+ */
+SHARPDICOM_API int batch_decode(
+    int codec,
+    const uint8_t** inputs,
+    const size_t* input_lens,
+    uint8_t** outputs,
+    const size_t* output_lens,
+    int count,
+    const batch_decode_options_t* options,
+    batch_decode_result_t* results
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_DECODE_H */
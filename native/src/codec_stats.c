@@ -0,0 +1,123 @@
+/**
+ * SharpDicom Codec Statistics Implementation
+ *
+ * One block of counters per codec and direction, each padded to its own
+ * cache line so that threads working on different codecs do not share
+ * lines.
+ */
+
+/* clock_gettime() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "codec_stats.h"
+
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+
+/* Same relaxed 64-bit counters as gpu_wrapper.c */
+#define counter_load(p) InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define counter_store(p, v) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+#define counter_add(p, v) InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v))
+#else
+    #include <time.h>
+
+#define counter_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define counter_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define counter_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#endif
+
+typedef struct {
+    volatile int64_t calls;
+    volatile int64_t errors;
+    volatile int64_t bytes_in;
+    volatile int64_t bytes_out;
+    volatile int64_t time_ns;
+    int64_t padding[3];
+} op_counters;
+
+static op_counters g_counters[SHARPDICOM_STATS_CODECS][2];
+
+static op_counters* counters_for(int codec, int op) {
+    if (codec < 0 || codec >= SHARPDICOM_STATS_CODECS ||
+        (op != CODEC_STATS_DECODE && op != CODEC_STATS_ENCODE)) {
+        return NULL;
+    }
+    return &g_counters[codec][op];
+}
+
+int64_t codec_stats_start(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (int64_t)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void codec_stats_add(int codec, int op, int64_t start_ns,
+                     size_t bytes_in, size_t bytes_out, int status) {
+    op_counters* counters = counters_for(codec, op);
+    if (counters == NULL) {
+        return;
+    }
+
+    int64_t elapsed = codec_stats_start() - start_ns;
+    if (status < 0) {
+        counter_add(&counters->errors, 1);
+    } else if (bytes_out != 0) {
+        counter_add(&counters->bytes_out, (int64_t)bytes_out);
+    }
+    if (bytes_in != 0) {
+        counter_add(&counters->bytes_in, (int64_t)bytes_in);
+    }
+    if (elapsed > 0) {
+        counter_add(&counters->time_ns, elapsed);
+    }
+}
+
+void codec_stats_record(int codec, int op, int64_t start_ns,
+                        size_t bytes_in, size_t bytes_out, int status) {
+    op_counters* counters = counters_for(codec, op);
+    if (counters == NULL) {
+        return;
+    }
+    counter_add(&counters->calls, 1);
+    codec_stats_add(codec, op, start_ns, bytes_in, bytes_out, status);
+}
+
+static void snapshot_op(const op_counters* counters, sharpdicom_op_stats_t* stats) {
+    stats->calls = (uint64_t)counter_load(&counters->calls);
+    stats->errors = (uint64_t)counter_load(&counters->errors);
+    stats->bytes_in = (uint64_t)counter_load(&counters->bytes_in);
+    stats->bytes_out = (uint64_t)counter_load(&counters->bytes_out);
+    stats->time_ns = (uint64_t)counter_load(&counters->time_ns);
+}
+
+void codec_stats_snapshot(sharpdicom_codec_stats_t* codecs) {
+    for (int c = 0; c < SHARPDICOM_STATS_CODECS; c++) {
+        snapshot_op(&g_counters[c][CODEC_STATS_DECODE], &codecs[c].decode);
+        snapshot_op(&g_counters[c][CODEC_STATS_ENCODE], &codecs[c].encode);
+    }
+}
+
+void codec_stats_reset(void) {
+    for (int c = 0; c < SHARPDICOM_STATS_CODECS; c++) {
+        for (int op = 0; op < 2; op++) {
+            op_counters* counters = &g_counters[c][op];
+            counter_store(&counters->calls, 0);
+            counter_store(&counters->errors, 0);
+            counter_store(&counters->bytes_in, 0);
+            counter_store(&counters->bytes_out, 0);
+            counter_store(&counters->time_ns, 0);
+        }
+    }
+}
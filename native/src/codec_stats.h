@@ -0,0 +1,67 @@
+/**
+ * SharpDicom Codec Statistics
+ *
+ * Counters behind sharpdicom_get_stats(). Each codec wrapper brackets the
+ * frame it hands to its codec library with codec_stats_start() and
+ * codec_stats_record(); the counters are relaxed atomics, so recording
+ * costs two clock reads and a few atomic adds per frame.
+ *
+ * Internal to the native library - not part of the exported API.
+ * Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef CODEC_STATS_H
+#define CODEC_STATS_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Directions of codec_stats_record() */
+#define CODEC_STATS_DECODE  0
+#define CODEC_STATS_ENCODE  1
+
+/**
+ * Reads the monotonic clock at the start of a codec call.
+ *
+ * @return Timestamp in nanoseconds
+ */
+int64_t codec_stats_start(void);
+
+/**
+ * Counts one call that started at start_ns.
+ *
+ * @param codec         SHARPDICOM_STATS_* index
+ * @param op            CODEC_STATS_DECODE or CODEC_STATS_ENCODE
+ * @param start_ns      Value of codec_stats_start() when the call began
+ * @param bytes_in      Bytes read by the call
+ * @param bytes_out     Bytes written (ignored when status is an error)
+ * @param status        Return code of the call
+ */
+void codec_stats_record(int codec, int op, int64_t start_ns,
+                        size_t bytes_in, size_t bytes_out, int status);
+
+/**
+ * Adds time and bytes to a direction without counting a call, for work
+ * that continues an earlier call (packets drained from a video encoder).
+ */
+void codec_stats_add(int codec, int op, int64_t start_ns,
+                     size_t bytes_in, size_t bytes_out, int status);
+
+/**
+ * Copies the counters of every codec.
+ *
+ * @param codecs        Array of SHARPDICOM_STATS_CODECS entries
+ */
+void codec_stats_snapshot(sharpdicom_codec_stats_t* codecs);
+
+/** Resets the counters of every codec. */
+void codec_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CODEC_STATS_H */
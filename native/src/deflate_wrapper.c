@@ -0,0 +1,548 @@
+/**
+ * SharpDicom Deflate Wrapper Implementation (zlib-ng)
+ *
+ * Wraps the zlib-ng native (zng_*) API for incremental inflate/deflate.
+ * zlib-ng dispatches to its SIMD adler32/crc32, chunk-copy and longest-match
+ * kernels at runtime, so no per-target flags are needed here.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "deflate_wrapper.h"
+#include "sharpdicom_codecs.h"
+#include "allocator.h"
+#include "codec_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef SHARPDICOM_HAS_ZLIBNG
+#include <zlib-ng.h>
+#endif
+
+/*============================================================================
+ * Internal helper: Set error message
+ *============================================================================*/
+
+/* Forward declaration from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+
+/**
+ * Format and set an error message.
+ * Marked unused for stub builds where this function isn't called.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((unused))
+#endif
+static void set_error_fmt(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    set_error(buffer);
+}
+
+#ifdef SHARPDICOM_HAS_ZLIBNG
+
+/*============================================================================
+ * Stream state
+ *============================================================================*/
+
+struct deflate_decoder {
+    zng_stream stream;
+    int finished;
+};
+
+struct deflate_encoder {
+    zng_stream stream;
+    int finished;
+};
+
+/** zlib windowBits selecting the container format at the maximum window */
+static int window_bits(int format) {
+    switch (format) {
+        case DEFLATE_FORMAT_RAW:  return -15;
+        case DEFLATE_FORMAT_ZLIB: return 15;
+        case DEFLATE_FORMAT_GZIP: return 15 + 16;
+        default:                  return 0;
+    }
+}
+
+/** zng_stream counts are 32-bit; larger chunks are fed in slices */
+static uint32_t clamp_avail(size_t len) {
+    return len > UINT32_MAX ? UINT32_MAX : (uint32_t)len;
+}
+
+/** zlib-ng allocation hooks on the library allocator */
+static void* stream_alloc(void* opaque, unsigned int items, unsigned int size) {
+    (void)opaque;
+    return allocator_calloc(items, size);
+}
+
+static void stream_free(void* opaque, void* address) {
+    (void)opaque;
+    allocator_free(address);
+}
+
+/** Map a zlib-ng return code to a SharpDicom error, recording the message */
+static int zng_to_sharpdicom_error(int ret, const zng_stream* stream, const char* what) {
+    const char* detail = (stream != NULL && stream->msg != NULL) ? stream->msg : "no detail";
+    switch (ret) {
+        case Z_DATA_ERROR:
+            set_error_fmt("%s: invalid deflate data (%s)", what, detail);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        case Z_NEED_DICT:
+            set_error_fmt("%s: stream requires a preset dictionary", what);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        case Z_MEM_ERROR:
+            set_error_fmt("%s: out of memory", what);
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        default:
+            set_error_fmt("%s: zlib-ng error %d (%s)", what, ret, detail);
+            return SHARPDICOM_ERR_INTERNAL;
+    }
+}
+
+/**
+ * Drive zng_inflate/zng_deflate over one caller chunk.
+ *
+ * Keeps calling until the input is used up, the output is full, the stream
+ * ends, or zlib-ng reports it cannot make progress (Z_BUF_ERROR), which
+ * just means the caller must supply more input or output space.
+ *
+ * @param flush     Z_* flush for the final input slice (encoder only)
+ */
+static int run_stream(
+    zng_stream* stream,
+    int is_encoder,
+    int flush,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int* stream_end
+) {
+    int64_t start = codec_stats_start();
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    int result = SHARPDICOM_OK;
+
+    for (;;) {
+        uint32_t avail_in = clamp_avail(input_len - in_pos);
+        uint32_t avail_out = clamp_avail(output_len - out_pos);
+        int last_slice = (input_len - in_pos) == avail_in;
+
+        stream->next_in = input != NULL ? input + in_pos : NULL;
+        stream->avail_in = avail_in;
+        stream->next_out = output + out_pos;
+        stream->avail_out = avail_out;
+
+        int ret = is_encoder
+            ? zng_deflate(stream, last_slice ? flush : Z_NO_FLUSH)
+            : zng_inflate(stream, Z_NO_FLUSH);
+
+        in_pos += avail_in - stream->avail_in;
+        out_pos += avail_out - stream->avail_out;
+
+        if (ret == Z_STREAM_END) {
+            *stream_end = 1;
+            break;
+        }
+        if (ret == Z_BUF_ERROR) {
+            break;
+        }
+        if (ret != Z_OK) {
+            result = zng_to_sharpdicom_error(ret, stream,
+                                             is_encoder ? "Deflate failed" : "Inflate failed");
+            if (is_encoder && result == SHARPDICOM_ERR_INTERNAL) {
+                result = SHARPDICOM_ERR_ENCODE_FAILED;
+            }
+            break;
+        }
+        if (out_pos == output_len) {
+            break;
+        }
+        /* Output to spare once all input is taken: nothing more is pending */
+        if (in_pos == input_len && stream->avail_out != 0) {
+            break;
+        }
+    }
+
+    stream->next_in = NULL;
+    stream->avail_in = 0;
+    stream->next_out = NULL;
+    stream->avail_out = 0;
+
+    /* Streams are counted per chunk, since a stream has no frame boundary */
+    codec_stats_record(SHARPDICOM_STATS_DEFLATE,
+                       is_encoder ? CODEC_STATS_ENCODE : CODEC_STATS_DECODE,
+                       start, in_pos, out_pos, result);
+
+    *consumed = in_pos;
+    *produced = out_pos;
+    return result;
+}
+
+/*============================================================================
+ * Inflate
+ *============================================================================*/
+
+SHARPDICOM_API int deflate_decoder_create(
+    int format,
+    deflate_decoder_t** decoder_out
+) {
+    if (decoder_out == NULL) {
+        set_error("Invalid argument: NULL decoder_out");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *decoder_out = NULL;
+
+    int bits = window_bits(format);
+    if (bits == 0) {
+        set_error_fmt("Invalid argument: unknown deflate format %d", format);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    deflate_decoder_t* decoder = (deflate_decoder_t*)allocator_calloc(1, sizeof(deflate_decoder_t));
+    if (decoder == NULL) {
+        set_error("Failed to allocate inflate stream");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    decoder->stream.zalloc = stream_alloc;
+    decoder->stream.zfree = stream_free;
+    int ret = zng_inflateInit2(&decoder->stream, bits);
+    if (ret != Z_OK) {
+        int result = zng_to_sharpdicom_error(ret, &decoder->stream, "Failed to initialize inflate");
+        allocator_free(decoder);
+        return result;
+    }
+
+    *decoder_out = decoder;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int deflate_decoder_process(
+    deflate_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int* finished
+) {
+    if (decoder == NULL || consumed == NULL || produced == NULL) {
+        set_error("Invalid argument: NULL decoder, consumed or produced");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if ((input == NULL && input_len != 0) || (output == NULL && output_len != 0)) {
+        set_error("Invalid argument: NULL buffer with non-zero length");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *consumed = 0;
+    *produced = 0;
+    if (!decoder->finished && (input_len != 0 || output_len != 0)) {
+        uint8_t none = 0;
+        int result = run_stream(&decoder->stream, 0, Z_NO_FLUSH, input, input_len, consumed,
+                                output != NULL ? output : &none, output_len, produced,
+                                &decoder->finished);
+        if (result != SHARPDICOM_OK) {
+            return result;
+        }
+    }
+
+    if (finished != NULL) {
+        *finished = decoder->finished;
+    }
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int deflate_decoder_reset(
+    deflate_decoder_t* decoder
+) {
+    if (decoder == NULL) {
+        set_error("Invalid argument: NULL decoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int ret = zng_inflateReset(&decoder->stream);
+    if (ret != Z_OK) {
+        return zng_to_sharpdicom_error(ret, &decoder->stream, "Failed to reset inflate");
+    }
+    decoder->finished = 0;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API void deflate_decoder_destroy(
+    deflate_decoder_t* decoder
+) {
+    if (decoder == NULL) {
+        return;
+    }
+    zng_inflateEnd(&decoder->stream);
+    allocator_free(decoder);
+}
+
+/*============================================================================
+ * Deflate
+ *============================================================================*/
+
+SHARPDICOM_API int deflate_encoder_create(
+    int format,
+    int level,
+    deflate_encoder_t** encoder_out
+) {
+    if (encoder_out == NULL) {
+        set_error("Invalid argument: NULL encoder_out");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *encoder_out = NULL;
+
+    int bits = window_bits(format);
+    if (bits == 0) {
+        set_error_fmt("Invalid argument: unknown deflate format %d", format);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (level != DEFLATE_LEVEL_DEFAULT && (level < 0 || level > 9)) {
+        set_error_fmt("Invalid argument: compression level %d must be 0-9", level);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    deflate_encoder_t* encoder = (deflate_encoder_t*)allocator_calloc(1, sizeof(deflate_encoder_t));
+    if (encoder == NULL) {
+        set_error("Failed to allocate deflate stream");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    encoder->stream.zalloc = stream_alloc;
+    encoder->stream.zfree = stream_free;
+    int ret = zng_deflateInit2(&encoder->stream, level, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK) {
+        int result = zng_to_sharpdicom_error(ret, &encoder->stream, "Failed to initialize deflate");
+        allocator_free(encoder);
+        return result;
+    }
+
+    *encoder_out = encoder;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int deflate_encoder_process(
+    deflate_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int flush,
+    int* finished
+) {
+    if (encoder == NULL || consumed == NULL || produced == NULL) {
+        set_error("Invalid argument: NULL encoder, consumed or produced");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if ((input == NULL && input_len != 0) || output == NULL) {
+        set_error("Invalid argument: NULL input or output buffer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int zflush;
+    switch (flush) {
+        case DEFLATE_FLUSH_NONE:   zflush = Z_NO_FLUSH; break;
+        case DEFLATE_FLUSH_SYNC:   zflush = Z_SYNC_FLUSH; break;
+        case DEFLATE_FLUSH_FINISH: zflush = Z_FINISH; break;
+        default:
+            set_error_fmt("Invalid argument: unknown flush mode %d", flush);
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *consumed = 0;
+    *produced = 0;
+    if (!encoder->finished && output_len != 0) {
+        int result = run_stream(&encoder->stream, 1, zflush, input, input_len, consumed,
+                                output, output_len, produced, &encoder->finished);
+        if (result != SHARPDICOM_OK) {
+            return result;
+        }
+    }
+
+    if (finished != NULL) {
+        *finished = encoder->finished;
+    }
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int deflate_encoder_get_bound(
+    deflate_encoder_t* encoder,
+    size_t input_len,
+    size_t* max_size
+) {
+    if (encoder == NULL || max_size == NULL) {
+        set_error("Invalid argument: NULL encoder or max_size");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *max_size = zng_deflateBound(&encoder->stream, input_len);
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int deflate_encoder_reset(
+    deflate_encoder_t* encoder
+) {
+    if (encoder == NULL) {
+        set_error("Invalid argument: NULL encoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int ret = zng_deflateReset(&encoder->stream);
+    if (ret != Z_OK) {
+        return zng_to_sharpdicom_error(ret, &encoder->stream, "Failed to reset deflate");
+    }
+    encoder->finished = 0;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API void deflate_encoder_destroy(
+    deflate_encoder_t* encoder
+) {
+    if (encoder == NULL) {
+        return;
+    }
+    zng_deflateEnd(&encoder->stream);
+    allocator_free(encoder);
+}
+
+SHARPDICOM_API const char* deflate_version(void) {
+    return zlibng_version();
+}
+
+#else /* SHARPDICOM_HAS_ZLIBNG not defined */
+
+/*============================================================================
+ * Stub implementations when zlib-ng is not available
+ *============================================================================*/
+
+SHARPDICOM_API int deflate_decoder_create(
+    int format,
+    deflate_decoder_t** decoder_out
+) {
+    (void)format;
+    if (decoder_out != NULL) {
+        *decoder_out = NULL;
+    }
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int deflate_decoder_process(
+    deflate_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int* finished
+) {
+    (void)decoder;
+    (void)input;
+    (void)input_len;
+    (void)consumed;
+    (void)output;
+    (void)output_len;
+    (void)produced;
+    (void)finished;
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int deflate_decoder_reset(
+    deflate_decoder_t* decoder
+) {
+    (void)decoder;
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void deflate_decoder_destroy(
+    deflate_decoder_t* decoder
+) {
+    (void)decoder;
+}
+
+SHARPDICOM_API int deflate_encoder_create(
+    int format,
+    int level,
+    deflate_encoder_t** encoder_out
+) {
+    (void)format;
+    (void)level;
+    if (encoder_out != NULL) {
+        *encoder_out = NULL;
+    }
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int deflate_encoder_process(
+    deflate_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int flush,
+    int* finished
+) {
+    (void)encoder;
+    (void)input;
+    (void)input_len;
+    (void)consumed;
+    (void)output;
+    (void)output_len;
+    (void)produced;
+    (void)flush;
+    (void)finished;
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int deflate_encoder_get_bound(
+    deflate_encoder_t* encoder,
+    size_t input_len,
+    size_t* max_size
+) {
+    (void)encoder;
+    (void)input_len;
+    (void)max_size;
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int deflate_encoder_reset(
+    deflate_encoder_t* encoder
+) {
+    (void)encoder;
+    set_error("Deflate support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void deflate_encoder_destroy(
+    deflate_encoder_t* encoder
+) {
+    (void)encoder;
+}
+
+SHARPDICOM_API const char* deflate_version(void) {
+    return NULL;
+}
+
+#endif /* SHARPDICOM_HAS_ZLIBNG */
@@ -0,0 +1,236 @@
+/**
+ * SharpDicom Deflate Wrapper API (zlib-ng)
+ *
+ * Streaming inflate/deflate for the Deflated Explicit VR Little Endian
+ * transfer syntax (1.2.840.10008.1.2.1.99) using zlib-ng's native API,
+ * which selects its SSE2/AVX2/NEON/CRC32 kernels at runtime.
+ *
+ * Data is processed in caller-provided input and output chunks against an
+ * opaque stream handle, so a dataset can be inflated incrementally as it
+ * arrives without buffering the whole object.
+ *
+ * Thread Safety: Distinct handles may be used concurrently.
+ * Each handle is NOT thread-safe; use one handle per stream.
+ * Error messages are stored in thread-local storage via sharpdicom_last_error().
+ */
+
+#ifndef DEFLATE_WRAPPER_H
+#define DEFLATE_WRAPPER_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================
+ * Deflate stream formats and flush modes
+ *============================================================================*/
+
+/** Stream container formats */
+#define DEFLATE_FORMAT_RAW      0  /* RFC 1951 raw deflate (DICOM deflated transfer syntax) */
+#define DEFLATE_FORMAT_ZLIB     1  /* RFC 1950 zlib wrapper */
+#define DEFLATE_FORMAT_GZIP     2  /* RFC 1952 gzip wrapper */
+
+/** Encoder flush modes */
+#define DEFLATE_FLUSH_NONE      0  /* Buffer input for best compression */
+#define DEFLATE_FLUSH_SYNC      1  /* Emit all pending output on a byte boundary */
+#define DEFLATE_FLUSH_FINISH    2  /* Complete the stream once all input is consumed */
+
+/** Compression level that selects the zlib-ng default (currently 6) */
+#define DEFLATE_LEVEL_DEFAULT   (-1)
+
+/*============================================================================
+ * Opaque handles
+ *============================================================================*/
+
+/** Opaque handle to an incremental inflate stream */
+typedef struct deflate_decoder deflate_decoder_t;
+
+/** Opaque handle to an incremental deflate stream */
+typedef struct deflate_encoder deflate_encoder_t;
+
+/*============================================================================
+ * Inflate API
+ *============================================================================*/
+
+/**
+ * Create an inflate stream.
+ *
+ * The decoder must be destroyed with deflate_decoder_destroy() when done.
+ *
+ * @param format        DEFLATE_FORMAT_* of the compressed data
+ * @param decoder_out   Receives the new decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL decoder_out or bad format
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ *         - SHARPDICOM_ERR_UNSUPPORTED: zlib-ng not compiled in
+ */
+SHARPDICOM_API int deflate_decoder_create(
+    int format,
+    deflate_decoder_t** decoder_out
+);
+
+/**
+ * Inflate the next chunk of a stream.
+ *
+ * Consumes as much of input and fills as much of output as possible. Call
+ * again with the unconsumed input and/or a fresh output chunk until
+ * *finished is set. Data following the end of the deflate stream (such as
+ * the pad byte of an odd-length dataset) is left unconsumed.
+ *
+ * @param decoder       Decoder handle
+ * @param input         Next compressed bytes (may be NULL if input_len is 0)
+ * @param input_len     Number of compressed bytes available
+ * @param consumed      Receives the number of input bytes used
+ * @param output        Buffer for decompressed bytes
+ * @param output_len    Size of output buffer in bytes
+ * @param produced      Receives the number of output bytes written
+ * @param finished      Receives 1 once the end of the stream was reached (may be NULL)
+ *
+ * @return SHARPDICOM_OK on success (including when more input or output
+ *         space is needed), or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL handle or out-parameters
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Invalid deflate data
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ *         - SHARPDICOM_ERR_UNSUPPORTED: zlib-ng not compiled in
+ */
+SHARPDICOM_API int deflate_decoder_process(
+    deflate_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int* finished
+);
+
+/**
+ * Reset a decoder to start a new stream of the same format,
+ * keeping its allocated window.
+ *
+ * @param decoder       Decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int deflate_decoder_reset(
+    deflate_decoder_t* decoder
+);
+
+/**
+ * Destroy a decoder and free its resources.
+ *
+ * @param decoder       Decoder handle (may be NULL)
+ */
+SHARPDICOM_API void deflate_decoder_destroy(
+    deflate_decoder_t* decoder
+);
+
+/*============================================================================
+ * Deflate API
+ *============================================================================*/
+
+/**
+ * Create a deflate stream.
+ *
+ * The encoder must be destroyed with deflate_encoder_destroy() when done.
+ *
+ * @param format        DEFLATE_FORMAT_* to produce
+ * @param level         Compression level 0-9, or DEFLATE_LEVEL_DEFAULT
+ * @param encoder_out   Receives the new encoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL encoder_out, bad format or level
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ *         - SHARPDICOM_ERR_UNSUPPORTED: zlib-ng not compiled in
+ */
+SHARPDICOM_API int deflate_encoder_create(
+    int format,
+    int level,
+    deflate_encoder_t** encoder_out
+);
+
+/**
+ * Deflate the next chunk of a stream.
+ *
+ * With DEFLATE_FLUSH_FINISH, keep calling with fresh output chunks (and no
+ * further input) until *finished is set.
+ *
+ * @param encoder       Encoder handle
+ * @param input         Next uncompressed bytes (may be NULL if input_len is 0)
+ * @param input_len     Number of uncompressed bytes available
+ * @param consumed      Receives the number of input bytes used
+ * @param output        Buffer for compressed bytes
+ * @param output_len    Size of output buffer in bytes
+ * @param produced      Receives the number of output bytes written
+ * @param flush         DEFLATE_FLUSH_* mode
+ * @param finished      Receives 1 once the stream is complete (may be NULL)
+ *
+ * @return SHARPDICOM_OK on success (including when more output space is
+ *         needed), or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL handle, out-parameters or bad flush
+ *         - SHARPDICOM_ERR_ENCODE_FAILED: zlib-ng reported a stream error
+ *         - SHARPDICOM_ERR_UNSUPPORTED: zlib-ng not compiled in
+ */
+SHARPDICOM_API int deflate_encoder_process(
+    deflate_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* consumed,
+    uint8_t* output,
+    size_t output_len,
+    size_t* produced,
+    int flush,
+    int* finished
+);
+
+/**
+ * Get an upper bound on the compressed size of input_len bytes
+ * for this encoder's format and level.
+ *
+ * @param encoder       Encoder handle
+ * @param input_len     Uncompressed size in bytes
+ * @param max_size      Receives maximum compressed size
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int deflate_encoder_get_bound(
+    deflate_encoder_t* encoder,
+    size_t input_len,
+    size_t* max_size
+);
+
+/**
+ * Reset an encoder to start a new stream with the same settings.
+ *
+ * @param encoder       Encoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int deflate_encoder_reset(
+    deflate_encoder_t* encoder
+);
+
+/**
+ * Destroy an encoder and free its resources.
+ *
+ * @param encoder       Encoder handle (may be NULL)
+ */
+SHARPDICOM_API void deflate_encoder_destroy(
+    deflate_encoder_t* encoder
+);
+
+/**
+ * Get the zlib-ng library version string.
+ *
+ * @return              Version string (e.g., "2.2.2"), or NULL if not available
+ */
+SHARPDICOM_API const char* deflate_version(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEFLATE_WRAPPER_H */
@@ -0,0 +1,64 @@
+/**
+ * SharpDicom Display Conversion Implementation
+ *
+ * Front end over the display kernels in pixel_convert.c for samples that a
+ * decoder has already written.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "display.h"
+#include "pixel_convert.h"
+
+#include <stdint.h>
+
+/* Forward declarations from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+SHARPDICOM_API int display_apply(
+    const uint8_t* input,
+    size_t input_len,
+    int32_t width,
+    int32_t height,
+    int32_t components,
+    int32_t bits_stored,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len
+) {
+    if (!input || !display || !output) {
+        set_error("Invalid parameters: input, display or output is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (width <= 0 || height <= 0 || components <= 0 || bits_stored < 1 || bits_stored > 16) {
+        set_error("Invalid geometry: dimensions must be positive and bits stored 1-16");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t count = safe_mul3_size((size_t)width, (size_t)height, (size_t)components);
+    size_t bytes_per_sample = (bits_stored <= 8) ? 1 : 2;
+    if (count == 0 || count > SIZE_MAX / bytes_per_sample) {
+        set_error("Image dimensions too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (input_len < count * bytes_per_sample) {
+        set_error("Input buffer too small for specified dimensions");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (output_len < count) {
+        set_error("Output buffer too small for display pixels");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    pixel_display_map map;
+    int status = pixel_display_map_init(&map, display, bits_stored, display->is_signed != 0);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    pixel_display_samples(input, count, bits_stored, display->is_signed != 0, &map, output);
+    pixel_display_map_release(&map);
+    return SHARPDICOM_OK;
+}
@@ -0,0 +1,113 @@
+/**
+ * SharpDicom Display Conversion API
+ *
+ * Maps stored pixel values to 8-bit display values in one pass: Modality
+ * LUT rescale (Rescale Slope / Intercept), then the VOI transform - a
+ * window (PS3.3 C.11.2.1.2) or a caller-built VOI LUT - then an optional
+ * MONOCHROME1 inversion.
+ *
+ * Decoders that take a display_params_t (J2kDecodeOptions.display,
+ * jls_decode_display(), gpu_j2k_decode_display()) write display pixels
+ * instead of 16-bit samples, so the frame is not walked a second time.
+ * JPEG 2000 applies the transform inside its output conversion loop;
+ * display_apply() covers samples that are already decoded.
+ *
+ * Applies to every component alike; output keeps the sample order of the
+ * input (interleaved or planar), one byte per sample.
+ *
+ * Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================
+ * VOI LUT functions (VOI LUT Function, 0028,1056)
+ *============================================================================*/
+
+#define DISPLAY_VOI_LINEAR          0  /* LINEAR: center - 0.5, width - 1 (C.11.2.1.2.1) */
+#define DISPLAY_VOI_LINEAR_EXACT    1  /* LINEAR_EXACT (C.11.2.1.3.2) */
+#define DISPLAY_VOI_SIGMOID         2  /* SIGMOID (C.11.2.1.3.1) */
+
+/*============================================================================
+ * Display parameters
+ *============================================================================*/
+
+/**
+ * Stored value to display value transform.
+ *
+ * Window center and width are in rescaled (modality) units, as in the
+ * dataset. A zero-initialised struct maps the full stored range linearly
+ * onto 0-255.
+ */
+typedef struct {
+    /** Rescale Slope (0 = 1) */
+    double rescale_slope;
+    /** Rescale Intercept */
+    double rescale_intercept;
+    /** Window Center */
+    double window_center;
+    /** Window Width (<= 0 = full rescaled range of the stored values) */
+    double window_width;
+    /** DISPLAY_VOI_* applied to the window */
+    int32_t voi_function;
+    /** Non-zero to invert the output (MONOCHROME1) */
+    int32_t invert;
+    /** Whether stored values are two's complement; only read where the decoder cannot tell */
+    int32_t is_signed;
+    /** First rescaled value mapped by lut (LUT Descriptor, second value) */
+    int32_t lut_first;
+    /** Entries in lut */
+    int32_t lut_count;
+    /** VOI LUT already scaled to 8 bits, used instead of the window (NULL = window) */
+    const uint8_t* lut;
+} display_params_t;
+
+/*============================================================================
+ * Display API functions
+ *============================================================================*/
+
+/**
+ * Converts decoded samples to display values.
+ *
+ * Samples are uint8_t when bits_stored is at most 8 and native-endian
+ * uint16_t otherwise; bits above bits_stored are ignored.
+ *
+ * @param input         Decoded samples
+ * @param input_len     Size of input in bytes
+ * @param width         Pixels per row
+ * @param height        Number of rows
+ * @param components    Samples per pixel
+ * @param bits_stored   Bits Stored of the samples (1-16)
+ * @param display       Transform to apply
+ * @param output        Receives width * height * components display bytes
+ * @param output_len    Size of output in bytes
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL pointers, bad geometry,
+ *           buffers too small or an invalid window / LUT
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Table allocation failed
+ */
+SHARPDICOM_API int display_apply(
+    const uint8_t* input,
+    size_t input_len,
+    int32_t width,
+    int32_t height,
+    int32_t components,
+    int32_t bits_stored,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISPLAY_H */
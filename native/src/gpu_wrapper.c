@@ -5,12 +5,21 @@
  * at runtime. Falls back to CPU implementations when GPU is unavailable.
  */
 
+/* clock_gettime() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "gpu_wrapper.h"
 #include "sharpdicom_codecs.h"
+#include "allocator.h"
+#include "j2k_wrapper.h"
+#include "pixel_convert.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 /*============================================================================
  * Dynamic library loading
@@ -101,10 +110,28 @@ typedef struct {
     size_t output_size;
 } nvj2k_batch_result_t;
 
+typedef struct {
+    void* device_ptr;
+    size_t pitch;
+    size_t plane_size;
+    int device_id;
+    void* stream;
+    void* event;
+    int width;
+    int height;
+    int num_components;
+    int precision;
+    size_t output_size;
+} nvj2k_device_result_t;
+
 /* Function pointer types */
 typedef int (*pfn_nvj2k_available)(void);
 typedef int (*pfn_nvj2k_init)(int device_id);
+typedef int (*pfn_nvj2k_init_devices)(const int* device_ids, int count);
+typedef int (*pfn_nvj2k_get_device_count)(void);
 typedef int (*pfn_nvj2k_get_device_info)(nvj2k_device_info_t* info);
+typedef int (*pfn_nvj2k_get_device_info_at)(int index, nvj2k_device_info_t* info);
+typedef int (*pfn_nvj2k_get_queue_depth)(int index);
 typedef void (*pfn_nvj2k_shutdown)(void);
 typedef int (*pfn_nvj2k_decode)(
     const uint8_t* input, size_t input_len,
@@ -119,6 +146,15 @@ typedef int (*pfn_nvj2k_decode_batch)(
     const nvj2k_decode_params_t* params,
     nvj2k_batch_result_t* results
 );
+typedef int (*pfn_nvj2k_decode_to_device)(
+    int device_index,
+    const uint8_t* input, size_t input_len,
+    void* device_output, size_t device_output_len,
+    const nvj2k_decode_params_t* params,
+    nvj2k_device_result_t* result,
+    void** out_image
+);
+typedef void (*pfn_nvj2k_release_device_image)(void* image);
 typedef const char* (*pfn_nvj2k_last_error)(void);
 typedef void (*pfn_nvj2k_clear_error)(void);
 
@@ -127,11 +163,18 @@ static lib_handle_t g_nvj2k_lib = LIB_INVALID;
 static volatile int g_nvj2k_loaded = 0;
 static volatile int g_nvj2k_available = 0;
 static nvj2k_device_info_t g_device_info = {0};
+static int g_device_count = 0;
 
 /* Function pointers */
 static pfn_nvj2k_available fn_nvj2k_available = NULL;
 static pfn_nvj2k_init fn_nvj2k_init = NULL;
 static pfn_nvj2k_get_device_info fn_nvj2k_get_device_info = NULL;
+static pfn_nvj2k_init_devices fn_nvj2k_init_devices = NULL;
+static pfn_nvj2k_get_device_count fn_nvj2k_get_device_count = NULL;
+static pfn_nvj2k_get_device_info_at fn_nvj2k_get_device_info_at = NULL;
+static pfn_nvj2k_get_queue_depth fn_nvj2k_get_queue_depth = NULL;
+static pfn_nvj2k_decode_to_device fn_nvj2k_decode_to_device = NULL;
+static pfn_nvj2k_release_device_image fn_nvj2k_release_device_image = NULL;
 static pfn_nvj2k_shutdown fn_nvj2k_shutdown = NULL;
 static pfn_nvj2k_decode fn_nvj2k_decode = NULL;
 static pfn_nvj2k_decode_batch fn_nvj2k_decode_batch = NULL;
@@ -173,6 +216,15 @@ static void lock(void) {
 static void unlock(void) {
     LeaveCriticalSection(&g_lock);
 }
+
+/* Publish/observe the loaded flag read outside the lock */
+#define load_acquire(p) InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define store_release(p, v) InterlockedExchange((volatile LONG*)(p), (v))
+
+/* Relaxed 64-bit counters for dispatch statistics */
+#define counter_load(p) InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define counter_store(p, v) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+#define counter_add(p, v) InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v))
 #else
 #include <pthread.h>
 static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
@@ -184,6 +236,15 @@ static void lock(void) {
 static void unlock(void) {
     pthread_mutex_unlock(&g_lock);
 }
+
+/* Publish/observe the loaded flag read outside the lock */
+#define load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/* Relaxed 64-bit counters for dispatch statistics */
+#define counter_load(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define counter_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define counter_add(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
 #endif
 
 /*============================================================================
@@ -236,74 +297,473 @@ static int load_nvj2k_functions(void) {
 
     #undef LOAD_FUNC
 
+    /* Multi-GPU entry points are optional; older wrappers drive one device */
+    fn_nvj2k_init_devices = (pfn_nvj2k_init_devices)get_symbol(g_nvj2k_lib, "nvj2k_init_devices");
+    fn_nvj2k_get_device_count = (pfn_nvj2k_get_device_count)get_symbol(g_nvj2k_lib, "nvj2k_get_device_count");
+    fn_nvj2k_get_device_info_at = (pfn_nvj2k_get_device_info_at)get_symbol(g_nvj2k_lib, "nvj2k_get_device_info_at");
+    fn_nvj2k_get_queue_depth = (pfn_nvj2k_get_queue_depth)get_symbol(g_nvj2k_lib, "nvj2k_get_queue_depth");
+    if (!fn_nvj2k_init_devices || !fn_nvj2k_get_device_count || !fn_nvj2k_get_device_info_at ||
+        !fn_nvj2k_get_queue_depth) {
+        fn_nvj2k_init_devices = NULL;
+        fn_nvj2k_get_device_count = NULL;
+        fn_nvj2k_get_device_info_at = NULL;
+        fn_nvj2k_get_queue_depth = NULL;
+    }
+
+    /* Device-resident decode is optional as well */
+    fn_nvj2k_decode_to_device = (pfn_nvj2k_decode_to_device)get_symbol(g_nvj2k_lib, "nvj2k_decode_to_device");
+    fn_nvj2k_release_device_image = (pfn_nvj2k_release_device_image)get_symbol(g_nvj2k_lib, "nvj2k_release_device_image");
+    if (!fn_nvj2k_decode_to_device || !fn_nvj2k_release_device_image) {
+        fn_nvj2k_decode_to_device = NULL;
+        fn_nvj2k_release_device_image = NULL;
+    }
+
     return 1;
 }
 
 /**
- * Initialize nvJPEG2000 wrapper.
- * Thread-safe, lazy initialization.
+ * Load and initialize the nvJPEG2000 wrapper.
+ * Caller must hold the lock. Returns 1 if the GPU can be used.
  */
-static void ensure_nvj2k_loaded(void) {
-    if (g_nvj2k_loaded) return;
-
-    lock();
-
-    /* Double-check after lock */
-    if (g_nvj2k_loaded) {
-        unlock();
-        return;
-    }
-
-    g_nvj2k_loaded = 1; /* Mark as loaded (even if failed) to prevent retry */
-    g_nvj2k_available = 0;
-
+static int load_nvj2k_locked(void) {
     /* Try to load library */
     if (!try_load_nvj2k()) {
-        unlock();
-        return;
+        return 0;
     }
 
     /* Load functions */
     if (!load_nvj2k_functions()) {
         close_library(g_nvj2k_lib);
         g_nvj2k_lib = LIB_INVALID;
-        unlock();
-        return;
+        return 0;
     }
 
     /* Check if GPU is actually available */
     if (!fn_nvj2k_available()) {
         close_library(g_nvj2k_lib);
         g_nvj2k_lib = LIB_INVALID;
-        unlock();
-        return;
+        return 0;
     }
 
-    /* Initialize nvJPEG2000 */
-    if (fn_nvj2k_init(-1) != 0) {
+    /* Initialize nvJPEG2000 on all suitable devices */
+    int status = fn_nvj2k_init_devices ? fn_nvj2k_init_devices(NULL, 0) : fn_nvj2k_init(-1);
+    if (status != 0) {
         close_library(g_nvj2k_lib);
         g_nvj2k_lib = LIB_INVALID;
-        unlock();
-        return;
+        return 0;
     }
 
     /* Get device info */
     fn_nvj2k_get_device_info(&g_device_info);
+    g_device_count = fn_nvj2k_get_device_count ? fn_nvj2k_get_device_count() : 1;
+    return 1;
+}
 
-    g_nvj2k_available = 1;
+/**
+ * Initialize nvJPEG2000 wrapper.
+ * Thread-safe, lazy initialization. The lock is only taken until the first
+ * load attempt has finished; decodes after that run without it.
+ */
+static void ensure_nvj2k_loaded(void) {
+    if (load_acquire(&g_nvj2k_loaded)) return;
+
+    lock();
+
+    /* Double-check after lock */
+    if (g_nvj2k_loaded) {
+        unlock();
+        return;
+    }
+
+    g_nvj2k_available = load_nvj2k_locked();
+
+    /* Mark as loaded (even if failed) to prevent retry. Set last so threads
+     * on the fast path never see a half-initialized wrapper. */
+    store_release(&g_nvj2k_loaded, 1);
     unlock();
 }
 
 /*============================================================================
- * Forward declarations for CPU fallback (declared in j2k_wrapper.h)
+ * Dispatch policy
+ *
+ * Each frame is routed to the CPU or GPU from its sample count, read from
+ * the SIZ marker without decoding. Decode times are tracked per power-of-two
+ * size bucket as an exponentially weighted moving average for each path;
+ * once both paths have samples in a bucket the faster one is used, with an
+ * occasional frame sent the other way so the estimates follow the load.
+ * Frames also go to the CPU while every GPU queue is at the depth limit.
  *============================================================================*/
 
-/* CPU JPEG 2000 decode - will be implemented in j2k_wrapper.c */
-extern int j2k_decode(
-    const uint8_t* input, size_t input_len,
-    uint8_t* output, size_t output_len,
-    int* width, int* height, int* components
-);
+/** Number of log2 size buckets (up to 2^40 samples) */
+#define DISPATCH_BUCKETS 41
+
+/** Frames measured on each path before a bucket's estimates are trusted */
+#define DISPATCH_WARMUP 4
+
+/** Every Nth frame of a bucket tries the slower path */
+#define DISPATCH_EXPLORE_INTERVAL 64
+
+/** EWMA weight of a new sample is 1 / (1 << DISPATCH_EWMA_SHIFT) */
+#define DISPATCH_EWMA_SHIFT 3
+
+/** Default per-device GPU queue depth above which frames go to the CPU */
+#define DISPATCH_DEFAULT_MAX_QUEUE_DEPTH 8
+
+typedef struct {
+    volatile int64_t cost_ns[2];     /* EWMA decode time: [0] CPU, [1] GPU */
+    volatile int64_t samples[2];     /* Measured frames per path */
+    volatile int64_t decisions;      /* Frames routed through this bucket */
+} dispatch_bucket_t;
+
+static dispatch_bucket_t g_buckets[DISPATCH_BUCKETS];
+
+/* Policy */
+static volatile int g_dispatch_mode = GPU_DISPATCH_AUTO;
+static volatile int64_t g_min_gpu_pixels = 0;
+static volatile int g_max_queue_depth = DISPATCH_DEFAULT_MAX_QUEUE_DEPTH;
+
+/* Statistics */
+static volatile int64_t g_gpu_frames = 0;
+static volatile int64_t g_cpu_frames = 0;
+static volatile int64_t g_gpu_fallbacks = 0;
+static volatile int64_t g_queue_overflows = 0;
+
+#define PATH_CPU 0
+#define PATH_GPU 1
+
+/** Header fields needed for dispatch and CPU results */
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t components;
+    uint32_t precision;
+    /** Whether the first component is signed (Ssiz bit 7) */
+    uint32_t is_signed;
+} frame_header_t;
+
+static uint32_t read_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/**
+ * Read image geometry from a raw codestream or a JP2 file's jp2c box.
+ * Returns 1 on success, 0 if the header is not recognized.
+ */
+static int read_frame_header(const uint8_t* data, size_t len, frame_header_t* header) {
+    /* JP2: walk top-level boxes to the contiguous codestream */
+    if (len >= 12 && read_be32(data) == 12 && memcmp(data + 4, "jP  ", 4) == 0) {
+        size_t pos = 0;
+        while (pos + 8 <= len) {
+            uint64_t box_len = read_be32(data + pos);
+            size_t header_len = 8;
+            if (box_len == 1) {
+                if (pos + 16 > len) return 0;
+                box_len = ((uint64_t)read_be32(data + pos + 8) << 32) | read_be32(data + pos + 12);
+                header_len = 16;
+            } else if (box_len == 0) {
+                box_len = len - pos;
+            }
+            if (box_len < header_len || box_len > len - pos) return 0;
+            if (memcmp(data + pos + 4, "jp2c", 4) == 0) {
+                data += pos + header_len;
+                len = (size_t)box_len - header_len;
+                break;
+            }
+            pos += (size_t)box_len;
+        }
+    }
+
+    /* SOC, then SIZ up to the first component's Ssiz */
+    if (len < 45 || data[0] != 0xFF || data[1] != 0x4F || data[2] != 0xFF || data[3] != 0x51) {
+        return 0;
+    }
+
+    uint32_t x1 = read_be32(data + 8), y1 = read_be32(data + 12);
+    uint32_t x0 = read_be32(data + 16), y0 = read_be32(data + 20);
+    uint32_t components = ((uint32_t)data[40] << 8) | data[41];
+    if (x1 <= x0 || y1 <= y0 || components == 0) {
+        return 0;
+    }
+
+    header->width = x1 - x0;
+    header->height = y1 - y0;
+    header->components = components;
+    header->precision = (uint32_t)(data[42] & 0x7F) + 1;
+    header->is_signed = (data[42] & 0x80) ? 1 : 0;
+    return 1;
+}
+
+static int64_t now_ns(void) {
+#if defined(_WIN32) || defined(_WIN64)
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (int64_t)((double)counter.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/** Size bucket for a sample count: floor(log2(samples)) */
+static int dispatch_bucket(uint64_t samples) {
+    int bucket = 0;
+    while (samples > 1 && bucket < DISPATCH_BUCKETS - 1) {
+        samples >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/** Fold a measured decode time into the bucket's estimate for a path */
+static void dispatch_record(uint64_t samples, int path, int64_t elapsed_ns) {
+    if (samples == 0 || elapsed_ns <= 0) {
+        return;
+    }
+
+    dispatch_bucket_t* bucket = &g_buckets[dispatch_bucket(samples)];
+    int64_t seen = counter_add(&bucket->samples[path], 1);
+    int64_t cost = counter_load(&bucket->cost_ns[path]);
+
+    /* Concurrent updates may drop a sample; the average tolerates that */
+    if (seen == 0) {
+        counter_store(&bucket->cost_ns[path], elapsed_ns);
+    } else {
+        counter_store(&bucket->cost_ns[path], cost + ((elapsed_ns - cost) >> DISPATCH_EWMA_SHIFT));
+    }
+}
+
+/** 1 if every GPU already has at least max_depth frames in flight */
+static int gpu_queues_full(int max_depth) {
+    if (max_depth <= 0 || !fn_nvj2k_get_queue_depth) {
+        return 0;
+    }
+
+    for (int i = 0; i < g_device_count; i++) {
+        if (fn_nvj2k_get_queue_depth(i) < max_depth) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Choose CPU or GPU for a frame of the given sample count (0 if unknown).
+ * The GPU must be available.
+ */
+static int dispatch_choose(uint64_t samples) {
+    int mode = g_dispatch_mode;
+    if (mode == GPU_DISPATCH_CPU) {
+        return PATH_CPU;
+    }
+    if (mode == GPU_DISPATCH_GPU) {
+        return PATH_GPU;
+    }
+
+    if (gpu_queues_full(g_max_queue_depth)) {
+        counter_add(&g_queue_overflows, 1);
+        return PATH_CPU;
+    }
+
+    /* Unknown size: keep the GPU default */
+    if (samples == 0) {
+        return PATH_GPU;
+    }
+
+    int64_t min_gpu_pixels = counter_load(&g_min_gpu_pixels);
+    if (min_gpu_pixels > 0) {
+        return (samples < (uint64_t)min_gpu_pixels) ? PATH_CPU : PATH_GPU;
+    }
+
+    /* Learned: measure both paths, then take the faster one */
+    dispatch_bucket_t* bucket = &g_buckets[dispatch_bucket(samples)];
+    if (counter_load(&bucket->samples[PATH_GPU]) < DISPATCH_WARMUP) {
+        return PATH_GPU;
+    }
+    if (counter_load(&bucket->samples[PATH_CPU]) < DISPATCH_WARMUP) {
+        return PATH_CPU;
+    }
+
+    int faster = (counter_load(&bucket->cost_ns[PATH_GPU]) <= counter_load(&bucket->cost_ns[PATH_CPU]))
+        ? PATH_GPU : PATH_CPU;
+    int64_t decision = counter_add(&bucket->decisions, 1);
+    if (decision % DISPATCH_EXPLORE_INTERVAL == DISPATCH_EXPLORE_INTERVAL - 1) {
+        return 1 - faster;
+    }
+    return faster;
+}
+
+/** Sample count of a frame from its header, 0 if it cannot be read */
+static uint64_t frame_samples(const uint8_t* input, size_t input_len) {
+    frame_header_t header;
+    if (!read_frame_header(input, input_len, &header)) {
+        return 0;
+    }
+    return (uint64_t)header.width * header.height * header.components;
+}
+
+/**
+ * Decode a frame on the CPU with OpenJPEG.
+ *
+ * @param display    Transform to display pixels, applied by the OpenJPEG output conversion (NULL = none)
+ */
+static int decode_on_cpu(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const display_params_t* display,
+    gpu_decode_result_t* result
+) {
+    J2kDecodeOptions options;
+    memset(&options, 0, sizeof(options));
+    options.display = display;
+
+    int32_t width = 0, height = 0, components = 0;
+    int status = j2k_decode(input, input_len, output, output_len, display ? &options : NULL,
+                            &width, &height, &components);
+
+    if (status == 0) {
+        if (result) {
+            frame_header_t header;
+            int precision = read_frame_header(input, input_len, &header) ? (int)header.precision : 8;
+
+            result->width = width;
+            result->height = height;
+            result->num_components = components;
+            result->precision = precision;
+            result->output_size = safe_mul4_size((size_t)width, (size_t)height, (size_t)components,
+                                                 display ? 1 : (size_t)((precision + 7) / 8));
+        }
+        return GPU_OK;
+    }
+
+    set_error(sharpdicom_last_error());
+    return GPU_ERR_DECODE_FAILED;
+}
+
+/**
+ * Decode a frame on the GPU into stored samples, then map them to display
+ * pixels in output. nvJPEG2000 writes its own buffer, so the transform is a
+ * single pass over a host staging copy.
+ *
+ * @return 0 on success, or the nvJPEG2000 / GPU error code
+ */
+static int decode_display_on_gpu(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const display_params_t* display,
+    nvj2k_decode_result_t* nvj2k_result
+) {
+    frame_header_t header;
+    if (!read_frame_header(input, input_len, &header) || header.precision > 16) {
+        set_error("Display decode needs a readable header with at most 16 bits per sample");
+        return GPU_ERR_DECODE_FAILED;
+    }
+    size_t samples = safe_mul3_size(header.width, header.height, header.components);
+    size_t staging_len = safe_mul_size(samples, (header.precision <= 8) ? 1 : 2);
+    if (samples == 0 || staging_len == 0 || output_len < samples) {
+        set_error("Output buffer too small for display pixels");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    pixel_display_map map;
+    if (pixel_display_map_init(&map, display, (int32_t)header.precision, (int)header.is_signed) != SHARPDICOM_OK) {
+        set_error(sharpdicom_last_error());
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+    uint8_t* staging = (uint8_t*)allocator_alloc(staging_len);
+    if (!staging) {
+        pixel_display_map_release(&map);
+        set_error("Failed to allocate display staging buffer");
+        return GPU_ERR_OUT_OF_MEMORY;
+    }
+
+    int status = fn_nvj2k_decode(input, input_len, staging, staging_len, NULL, nvj2k_result);
+    if (status == 0) {
+        pixel_display_samples(staging, samples, (int32_t)header.precision, (int)header.is_signed,
+                              &map, output);
+        nvj2k_result->output_size = samples;
+    }
+    allocator_free(staging);
+    pixel_display_map_release(&map);
+    return status;
+}
+
+/**
+ * Shared path of gpu_j2k_decode() and gpu_j2k_decode_display().
+ */
+static int decode_frame(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const display_params_t* display,
+    gpu_decode_result_t* result
+) {
+    if (!input || input_len == 0) {
+        set_error("Input is NULL or empty");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!output || output_len == 0) {
+        set_error("Output is NULL or empty");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    ensure_nvj2k_loaded();
+
+    uint64_t samples = frame_samples(input, input_len);
+    int use_gpu = g_nvj2k_available && !tls_prefer_cpu && fn_nvj2k_decode &&
+                  dispatch_choose(samples) == PATH_GPU;
+
+    if (use_gpu) {
+        nvj2k_decode_result_t nvj2k_result;
+        int64_t start = now_ns();
+        int status = display
+            ? decode_display_on_gpu(input, input_len, output, output_len, display, &nvj2k_result)
+            : fn_nvj2k_decode(
+                input, input_len,
+                output, output_len,
+                NULL, /* Use defaults */
+                &nvj2k_result
+            );
+
+        if (status == 0) {
+            dispatch_record(samples, PATH_GPU, now_ns() - start);
+            counter_add(&g_gpu_frames, 1);
+            if (result) {
+                result->width = nvj2k_result.width;
+                result->height = nvj2k_result.height;
+                result->num_components = nvj2k_result.num_components;
+                result->precision = nvj2k_result.precision;
+                result->output_size = nvj2k_result.output_size;
+            }
+            return GPU_OK;
+        }
+
+        /* GPU decode failed - copy error and fall back to CPU */
+        counter_add(&g_gpu_fallbacks, 1);
+        if (fn_nvj2k_last_error) {
+            set_error(fn_nvj2k_last_error());
+        }
+    }
+
+    /* CPU path - use OpenJPEG j2k_decode */
+    int64_t start = now_ns();
+    int status = decode_on_cpu(input, input_len, output, output_len, display, result);
+    if (status == GPU_OK) {
+        /* Only time frames the policy chose, not GPU failures */
+        if (!use_gpu) {
+            dispatch_record(samples, PATH_CPU, now_ns() - start);
+        }
+        counter_add(&g_cpu_frames, 1);
+    }
+    return status;
+}
 
 /*============================================================================
  * Public API implementation
@@ -360,8 +820,56 @@ int gpu_get_memory_info(size_t* total_memory, size_t* free_memory) {
         fn_nvj2k_get_device_info(&g_device_info);
     }
 
-    if (total_memory) *total_memory = g_device_info.total_memory;
-    if (free_memory) *free_memory = g_device_info.free_memory;
+    size_t total = g_device_info.total_memory;
+    size_t free_bytes = g_device_info.free_memory;
+
+    /* Sum over the remaining devices; refreshing also updates the free
+     * memory the wrapper uses to place work */
+    for (int i = 1; i < g_device_count && fn_nvj2k_get_device_info_at; i++) {
+        nvj2k_device_info_t info;
+        if (fn_nvj2k_get_device_info_at(i, &info) == 0) {
+            total += info.total_memory;
+            free_bytes += info.free_memory;
+        }
+    }
+
+    if (total_memory) *total_memory = total;
+    if (free_memory) *free_memory = free_bytes;
+
+    return GPU_OK;
+}
+
+int gpu_get_device_count(void) {
+    ensure_nvj2k_loaded();
+    return g_nvj2k_available ? g_device_count : 0;
+}
+
+int gpu_get_device_memory_info(int index, size_t* total_memory, size_t* free_memory) {
+    ensure_nvj2k_loaded();
+
+    if (!g_nvj2k_available) {
+        set_error("No GPU available");
+        return GPU_ERR_NOT_AVAILABLE;
+    }
+
+    if (index < 0 || index >= g_device_count) {
+        set_error("Device index out of range");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    nvj2k_device_info_t info;
+    int status = fn_nvj2k_get_device_info_at
+        ? fn_nvj2k_get_device_info_at(index, &info)
+        : fn_nvj2k_get_device_info(&info);
+    if (status != 0) {
+        if (fn_nvj2k_last_error) {
+            set_error(fn_nvj2k_last_error());
+        }
+        return GPU_ERR_INTERNAL;
+    }
+
+    if (total_memory) *total_memory = info.total_memory;
+    if (free_memory) *free_memory = info.free_memory;
 
     return GPU_OK;
 }
@@ -374,70 +882,104 @@ int gpu_prefers_cpu(void) {
     return tls_prefer_cpu;
 }
 
-int gpu_j2k_decode(
-    const uint8_t* input,
-    size_t input_len,
-    uint8_t* output,
-    size_t output_len,
-    gpu_decode_result_t* result
-) {
-    if (!input || input_len == 0) {
-        set_error("Input is NULL or empty");
+int gpu_set_dispatch_policy(const gpu_dispatch_policy_t* policy) {
+    if (!policy) {
+        set_error("Policy is NULL");
         return GPU_ERR_INVALID_ARGUMENT;
     }
 
-    if (!output || output_len == 0) {
-        set_error("Output is NULL or empty");
+    if (policy->mode < GPU_DISPATCH_AUTO || policy->mode > GPU_DISPATCH_CPU ||
+        policy->max_queue_depth < 0) {
+        set_error("Invalid dispatch policy");
         return GPU_ERR_INVALID_ARGUMENT;
     }
 
-    ensure_nvj2k_loaded();
+    g_dispatch_mode = policy->mode;
+    counter_store(&g_min_gpu_pixels, (int64_t)policy->min_gpu_pixels);
+    g_max_queue_depth = policy->max_queue_depth;
+    return GPU_OK;
+}
 
-    /* Use GPU if available and not preferring CPU */
-    if (g_nvj2k_available && !tls_prefer_cpu && fn_nvj2k_decode) {
-        nvj2k_decode_result_t nvj2k_result;
-        int status = fn_nvj2k_decode(
-            input, input_len,
-            output, output_len,
-            NULL, /* Use defaults */
-            &nvj2k_result
-        );
+int gpu_get_dispatch_policy(gpu_dispatch_policy_t* policy) {
+    if (!policy) {
+        set_error("Policy is NULL");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
 
-        if (status == 0) {
-            if (result) {
-                result->width = nvj2k_result.width;
-                result->height = nvj2k_result.height;
-                result->num_components = nvj2k_result.num_components;
-                result->precision = nvj2k_result.precision;
-                result->output_size = nvj2k_result.output_size;
-            }
-            return GPU_OK;
-        }
+    policy->mode = g_dispatch_mode;
+    policy->min_gpu_pixels = (uint64_t)counter_load(&g_min_gpu_pixels);
+    policy->max_queue_depth = g_max_queue_depth;
+    return GPU_OK;
+}
 
-        /* GPU decode failed - copy error and fall back to CPU */
-        if (fn_nvj2k_last_error) {
-            set_error(fn_nvj2k_last_error());
+int gpu_get_dispatch_stats(gpu_dispatch_stats_t* stats) {
+    if (!stats) {
+        set_error("Stats is NULL");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->gpu_frames = (uint64_t)counter_load(&g_gpu_frames);
+    stats->cpu_frames = (uint64_t)counter_load(&g_cpu_frames);
+    stats->gpu_fallbacks = (uint64_t)counter_load(&g_gpu_fallbacks);
+    stats->queue_overflows = (uint64_t)counter_load(&g_queue_overflows);
+
+    /* Smallest bucket where both paths are measured and the GPU wins */
+    for (int b = 0; b < DISPATCH_BUCKETS; b++) {
+        const dispatch_bucket_t* bucket = &g_buckets[b];
+        if (counter_load(&bucket->samples[PATH_CPU]) >= DISPATCH_WARMUP &&
+            counter_load(&bucket->samples[PATH_GPU]) >= DISPATCH_WARMUP &&
+            counter_load(&bucket->cost_ns[PATH_GPU]) <= counter_load(&bucket->cost_ns[PATH_CPU])) {
+            stats->learned_min_gpu_pixels = (uint64_t)1 << b;
+            break;
         }
     }
 
-    /* CPU fallback - use OpenJPEG j2k_decode */
-    int width = 0, height = 0, components = 0;
-    int status = j2k_decode(input, input_len, output, output_len,
-                            &width, &height, &components);
+    return GPU_OK;
+}
 
-    if (status == 0) {
-        if (result) {
-            result->width = width;
-            result->height = height;
-            result->num_components = components;
-            result->precision = 8; /* Default, may need refinement */
-            result->output_size = safe_mul3_size((size_t)width, (size_t)height, (size_t)components);
+void gpu_reset_dispatch_counters(void) {
+    counter_store(&g_gpu_frames, 0);
+    counter_store(&g_cpu_frames, 0);
+    counter_store(&g_gpu_fallbacks, 0);
+    counter_store(&g_queue_overflows, 0);
+}
+
+void gpu_reset_dispatch_stats(void) {
+    gpu_reset_dispatch_counters();
+
+    for (int b = 0; b < DISPATCH_BUCKETS; b++) {
+        for (int path = 0; path < 2; path++) {
+            counter_store(&g_buckets[b].cost_ns[path], 0);
+            counter_store(&g_buckets[b].samples[path], 0);
         }
-        return GPU_OK;
+        counter_store(&g_buckets[b].decisions, 0);
     }
+}
 
-    set_error(sharpdicom_last_error());
-    return GPU_ERR_DECODE_FAILED;
+int gpu_j2k_decode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    gpu_decode_result_t* result
+) {
+    return decode_frame(input, input_len, output, output_len, NULL, result);
+}
+
+int gpu_j2k_decode_display(
+    const uint8_t* input,
+    size_t input_len,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len,
+    gpu_decode_result_t* result
+) {
+    if (!display) {
+        set_error("Display parameters are NULL");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+    return decode_frame(input, input_len, output, output_len, display, result);
 }
 
 int gpu_j2k_decode_batch(
@@ -460,10 +1002,22 @@ int gpu_j2k_decode_batch(
 
     ensure_nvj2k_loaded();
 
-    /* Use GPU batch decode if available */
-    if (g_nvj2k_available && !tls_prefer_cpu && fn_nvj2k_decode_batch) {
+    /* Frames of a batch usually share one size, so the first readable one decides */
+    uint64_t samples = 0;
+    for (int i = 0; i < count; i++) {
+        if (inputs[i] && input_lens[i] != 0) {
+            samples = frame_samples(inputs[i], input_lens[i]);
+            break;
+        }
+    }
+
+    /* Use GPU batch decode if available and chosen */
+    int gpu_failed = 0;
+    int64_t gpu_ns = 0;
+    if (g_nvj2k_available && !tls_prefer_cpu && fn_nvj2k_decode_batch &&
+        dispatch_choose(samples) == PATH_GPU) {
         nvj2k_batch_result_t* nvj2k_results = (nvj2k_batch_result_t*)
-            malloc(count * sizeof(nvj2k_batch_result_t));
+            allocator_alloc(count * sizeof(nvj2k_batch_result_t));
 
         if (!nvj2k_results) {
             set_error("Memory allocation failed");
@@ -473,12 +1027,21 @@ int gpu_j2k_decode_batch(
             return 0;
         }
 
+        int64_t start = now_ns();
         int success = fn_nvj2k_decode_batch(
             inputs, input_lens,
             outputs, output_lens,
             count, NULL, nvj2k_results
         );
 
+        gpu_ns = now_ns() - start;
+
+        /* Pipelined batches are charged per frame */
+        if (success == count) {
+            dispatch_record(samples, PATH_GPU, gpu_ns / count);
+        }
+        counter_add(&g_gpu_frames, success);
+
         /* Copy results */
         for (int i = 0; i < count; i++) {
             results[i].status = nvj2k_results[i].status;
@@ -489,25 +1052,46 @@ int gpu_j2k_decode_batch(
             results[i].output_size = nvj2k_results[i].output_size;
         }
 
-        free(nvj2k_results);
+        allocator_free(nvj2k_results);
 
         if (success > 0) {
             return success;
         }
 
-        /* All failed on GPU, fall through to CPU */
+        /* All failed on GPU - copy error and fall back to CPU */
+        gpu_failed = 1;
+        if (fn_nvj2k_last_error) {
+            set_error(fn_nvj2k_last_error());
+        }
     }
 
-    /* CPU fallback - decode one by one */
+    /*
+     * Per-frame decode; each frame is dispatched on its own, except after a
+     * failed GPU batch, which must not be retried on the GPU
+     */
     int success_count = 0;
+    int64_t start = now_ns();
 
     for (int i = 0; i < count; i++) {
         gpu_decode_result_t single_result;
-        int status = gpu_j2k_decode(
-            inputs[i], input_lens[i],
-            outputs[i], output_lens[i],
-            &single_result
-        );
+        int status;
+        if (!gpu_failed) {
+            status = gpu_j2k_decode(
+                inputs[i], input_lens[i],
+                outputs[i], output_lens[i],
+                &single_result
+            );
+        } else if (!inputs[i] || input_lens[i] == 0 || !outputs[i] || output_lens[i] == 0) {
+            set_error("Input or output is NULL or empty");
+            status = GPU_ERR_INVALID_ARGUMENT;
+        } else {
+            counter_add(&g_gpu_fallbacks, 1);
+            status = decode_on_cpu(inputs[i], input_lens[i], outputs[i], output_lens[i],
+                                   NULL, &single_result);
+            if (status == GPU_OK) {
+                counter_add(&g_cpu_frames, 1);
+            }
+        }
 
         results[i].status = status;
         if (status == GPU_OK) {
@@ -526,9 +1110,85 @@ int gpu_j2k_decode_batch(
         }
     }
 
+    /* The GPU choice cost its failed attempt plus the CPU redo */
+    if (gpu_failed && success_count == count) {
+        dispatch_record(samples, PATH_GPU, (gpu_ns + now_ns() - start) / count);
+    }
+
     return success_count;
 }
 
+int gpu_j2k_decode_to_device(
+    int device_index,
+    const uint8_t* input,
+    size_t input_len,
+    void* device_output,
+    size_t device_output_len,
+    gpu_device_result_t* result,
+    gpu_device_image_t** out_image
+) {
+    if (out_image) {
+        *out_image = NULL;
+    }
+
+    if (!input || input_len == 0) {
+        set_error("Input is NULL or empty");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!result || !out_image) {
+        set_error("Result or image pointer is NULL");
+        return GPU_ERR_INVALID_ARGUMENT;
+    }
+
+    ensure_nvj2k_loaded();
+
+    /* No CPU fallback: the caller wants GPU memory */
+    if (!g_nvj2k_available || !fn_nvj2k_decode_to_device) {
+        set_error("No GPU available for device-resident decode");
+        return GPU_ERR_NOT_AVAILABLE;
+    }
+
+    nvj2k_device_result_t nvj2k_result;
+    void* image = NULL;
+    int status = fn_nvj2k_decode_to_device(
+        device_index,
+        input, input_len,
+        device_output, device_output_len,
+        NULL, /* Use defaults */
+        &nvj2k_result,
+        &image
+    );
+
+    if (status != 0) {
+        if (fn_nvj2k_last_error) {
+            set_error(fn_nvj2k_last_error());
+        }
+        return GPU_ERR_DECODE_FAILED;
+    }
+
+    result->device_ptr = nvj2k_result.device_ptr;
+    result->pitch = nvj2k_result.pitch;
+    result->plane_size = nvj2k_result.plane_size;
+    result->device_id = nvj2k_result.device_id;
+    result->stream = nvj2k_result.stream;
+    result->event = nvj2k_result.event;
+    result->width = nvj2k_result.width;
+    result->height = nvj2k_result.height;
+    result->num_components = nvj2k_result.num_components;
+    result->precision = nvj2k_result.precision;
+    result->output_size = nvj2k_result.output_size;
+
+    *out_image = (gpu_device_image_t*)image;
+    return GPU_OK;
+}
+
+void gpu_release_device_image(gpu_device_image_t* image) {
+    if (image && fn_nvj2k_release_device_image) {
+        fn_nvj2k_release_device_image(image);
+    }
+}
+
 const char* gpu_last_error(void) {
     return tls_error;
 }
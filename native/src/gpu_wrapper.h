@@ -14,6 +14,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "display.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -71,6 +73,29 @@ typedef struct gpu_batch_result {
     size_t output_size;      /* Actual output size */
 } gpu_batch_result_t;
 
+/**
+ * Opaque handle to a decoded image kept in GPU memory.
+ */
+typedef struct gpu_device_image gpu_device_image_t;
+
+/**
+ * Result of a decode into GPU memory.
+ * Output is planar: component c starts at device_ptr + c * plane_size.
+ */
+typedef struct gpu_device_result {
+    void* device_ptr;        /* Decoded pixels in device memory */
+    size_t pitch;            /* Bytes per row of one component */
+    size_t plane_size;       /* Bytes per component plane */
+    int device_id;           /* CUDA device holding the output */
+    void* stream;            /* cudaStream_t the decode was enqueued on */
+    void* event;             /* cudaEvent_t recorded when the output is ready */
+    int width;               /* Decoded image width */
+    int height;              /* Decoded image height */
+    int num_components;      /* Number of components */
+    int precision;           /* Bit depth per component */
+    size_t output_size;      /* Size of decoded data in bytes */
+} gpu_device_result_t;
+
 /*============================================================================
  * GPU availability functions
  *============================================================================*/
@@ -99,7 +124,7 @@ gpu_type_t gpu_get_type(void);
 int gpu_get_device_name(char* buffer, size_t buf_size);
 
 /**
- * Get GPU memory information.
+ * Get GPU memory information, summed over all devices in use.
  *
  * @param total_memory Pointer to store total memory (bytes)
  * @param free_memory  Pointer to store free memory (bytes)
@@ -107,6 +132,26 @@ int gpu_get_device_name(char* buffer, size_t buf_size);
  */
 int gpu_get_memory_info(size_t* total_memory, size_t* free_memory);
 
+/**
+ * Get the number of GPUs used for decoding.
+ * gpu_j2k_decode() and gpu_j2k_decode_batch() spread work across all of
+ * them, preferring the device with the shortest queue, then the most free
+ * memory.
+ *
+ * @return Device count, or 0 if no GPU is available
+ */
+int gpu_get_device_count(void);
+
+/**
+ * Get memory information for one GPU.
+ *
+ * @param index        Device index (0 to gpu_get_device_count() - 1)
+ * @param total_memory Pointer to store total memory (bytes)
+ * @param free_memory  Pointer to store free memory (bytes)
+ * @return GPU_OK on success, error code on failure
+ */
+int gpu_get_device_memory_info(int index, size_t* total_memory, size_t* free_memory);
+
 /*============================================================================
  * GPU preference control
  *============================================================================*/
@@ -126,13 +171,85 @@ void gpu_prefer_cpu(int prefer_cpu);
  */
 int gpu_prefers_cpu(void);
 
+/*============================================================================
+ * Dispatch policy
+ *============================================================================*/
+
+/**
+ * How gpu_j2k_decode() and gpu_j2k_decode_batch() pick CPU or GPU.
+ */
+typedef enum gpu_dispatch_mode {
+    GPU_DISPATCH_AUTO = 0,   /* Per frame, by size, GPU queue depth and measured cost */
+    GPU_DISPATCH_GPU = 1,    /* Always GPU when available (CPU only on failure) */
+    GPU_DISPATCH_CPU = 2     /* Always CPU */
+} gpu_dispatch_mode_t;
+
+/**
+ * Dispatch policy settings.
+ */
+typedef struct gpu_dispatch_policy {
+    int mode;                 /* gpu_dispatch_mode_t (default GPU_DISPATCH_AUTO) */
+    uint64_t min_gpu_pixels;  /* Samples (width * height * components) below which
+                                 frames go to the CPU; 0 = learn from timings */
+    int max_queue_depth;      /* Frames go to the CPU while every GPU has this many
+                                 in flight; 0 = no limit (default 8) */
+} gpu_dispatch_policy_t;
+
+/**
+ * Dispatch statistics since startup or the last reset.
+ */
+typedef struct gpu_dispatch_stats {
+    uint64_t gpu_frames;              /* Frames decoded on the GPU */
+    uint64_t cpu_frames;              /* Frames decoded on the CPU */
+    uint64_t gpu_fallbacks;           /* GPU decodes that failed and were redone on the CPU */
+    uint64_t queue_overflows;         /* Frames sent to the CPU because GPU queues were full */
+    uint64_t learned_min_gpu_pixels;  /* Smallest measured size where the GPU is faster (0 = unknown) */
+} gpu_dispatch_stats_t;
+
+/**
+ * Set the CPU/GPU dispatch policy for all threads.
+ * gpu_prefer_cpu() still forces the CPU for the calling thread.
+ *
+ * @param policy Policy to apply
+ * @return GPU_OK on success, error code on failure
+ */
+int gpu_set_dispatch_policy(const gpu_dispatch_policy_t* policy);
+
+/**
+ * Get the current dispatch policy.
+ *
+ * @param policy Pointer to policy structure to fill
+ * @return GPU_OK on success, error code on failure
+ */
+int gpu_get_dispatch_policy(gpu_dispatch_policy_t* policy);
+
+/**
+ * Get dispatch statistics.
+ *
+ * @param stats Pointer to statistics structure to fill
+ * @return GPU_OK on success, error code on failure
+ */
+int gpu_get_dispatch_stats(gpu_dispatch_stats_t* stats);
+
+/**
+ * Reset dispatch statistics and the learned timings.
+ */
+void gpu_reset_dispatch_stats(void);
+
+/**
+ * Reset the frame counters of the dispatch statistics, keeping the learned
+ * timings.
+ */
+void gpu_reset_dispatch_counters(void);
+
 /*============================================================================
  * JPEG 2000 decode functions
  *============================================================================*/
 
 /**
- * Decode a single JPEG 2000 codestream using GPU if available.
- * Falls back to CPU if GPU is not available or prefer_cpu is set.
+ * Decode a single JPEG 2000 codestream on the CPU or GPU, as chosen by the
+ * dispatch policy. Falls back to CPU if GPU is not available, the GPU decode
+ * fails or prefer_cpu is set.
  *
  * @param input      Input compressed data
  * @param input_len  Length of input data in bytes
@@ -149,6 +266,30 @@ int gpu_j2k_decode(
     gpu_decode_result_t* result
 );
 
+/**
+ * Decode a single JPEG 2000 codestream to 8-bit display pixels, as
+ * gpu_j2k_decode() chooses the device. The CPU path applies the transform
+ * in the OpenJPEG output conversion; the GPU path maps the staged samples
+ * in one pass. Codestreams over 16 bits per sample decode on the CPU.
+ *
+ * @param input      Input compressed data
+ * @param input_len  Length of input data in bytes
+ * @param display    Stored value to display value transform
+ * @param output     Output buffer for display pixels (one byte per sample)
+ * @param output_len Size of output buffer in bytes
+ * @param result     Output: decode result information (precision of the codestream,
+ *                   output_size in display bytes)
+ * @return GPU_OK on success, error code on failure
+ */
+int gpu_j2k_decode_display(
+    const uint8_t* input,
+    size_t input_len,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len,
+    gpu_decode_result_t* result
+);
+
 /**
  * Decode multiple JPEG 2000 codestreams in batch.
  * More efficient than multiple gpu_j2k_decode() calls on GPU.
@@ -170,6 +311,40 @@ int gpu_j2k_decode_batch(
     gpu_batch_result_t* results
 );
 
+/**
+ * Decode a JPEG 2000 codestream into GPU memory for a CUDA consumer,
+ * skipping the copies to and from host memory. There is no CPU fallback.
+ * Returns once the decode is enqueued; wait on result->event before
+ * reading the output.
+ *
+ * @param device_index      Device index (-1 to pick the least busy GPU;
+ *                          required when device_output is given)
+ * @param input             Input compressed data
+ * @param input_len         Length of input data in bytes
+ * @param device_output     Device buffer to decode into (NULL for a pooled buffer)
+ * @param device_output_len Size of device_output in bytes
+ * @param result            Output: device pointer, layout and sync objects
+ * @param out_image         Output: handle to pass to gpu_release_device_image()
+ * @return GPU_OK on success, GPU_ERR_NOT_AVAILABLE without a GPU, or error code
+ */
+int gpu_j2k_decode_to_device(
+    int device_index,
+    const uint8_t* input,
+    size_t input_len,
+    void* device_output,
+    size_t device_output_len,
+    gpu_device_result_t* result,
+    gpu_device_image_t** out_image
+);
+
+/**
+ * Release a GPU-resident decode once consumers are done with its output.
+ * NULL is ignored.
+ *
+ * @param image Handle from gpu_j2k_decode_to_device()
+ */
+void gpu_release_device_image(gpu_device_image_t* image);
+
 /*============================================================================
  * Error handling
  *============================================================================*/
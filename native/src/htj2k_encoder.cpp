@@ -0,0 +1,183 @@
+/**
+ * SharpDicom HTJ2K Encoder Implementation (OpenJPH)
+ *
+ * Feeds component-interleaved samples line by line into an
+ * ojph::codestream writing to memory, then copies the codestream into the
+ * space the caller's output callback provides for its final size. OpenJPH reports errors by throwing, so every entry point
+ * catches and maps them to SharpDicom error codes.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "htj2k_encoder.h"
+#include "sharpdicom_codecs.h"
+
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <new>
+
+#include <openjph/ojph_arch.h>
+#include <openjph/ojph_codestream.h>
+#include <openjph/ojph_file.h>
+#include <openjph/ojph_mem.h>
+#include <openjph/ojph_params.h>
+
+extern "C" void set_error_fmt(const char* fmt, ...);
+extern "C" void set_error(const char* message);
+
+namespace {
+
+/** OpenJPH progression order names indexed by J2kEncodeParams.progression_order */
+const char* const kProgressionOrders[] = { "LRCP", "RLCP", "RPCL", "PCRL", "CPRL" };
+
+/**
+ * Irreversible quantization step for a 1-100 quality: 1/256 (OpenJPH's
+ * default) at quality 80, halving every 10 points above and doubling every
+ * 10 points below.
+ */
+float quality_to_step(float quality) {
+    if (quality <= 0.0f) {
+        return 1.0f / 256.0f;
+    }
+    if (quality > 100.0f) {
+        quality = 100.0f;
+    }
+    return (1.0f / 256.0f) * std::exp2((80.0f - quality) / 10.0f);
+}
+
+/** Read sample (x, c) of one interleaved row, as the OpenJPEG path does */
+inline ojph::si32 read_sample(
+    const uint8_t* row, int32_t x, int32_t c, int32_t num_components,
+    int32_t bytes_per_sample, int32_t signed_offset
+) {
+    size_t idx = (size_t)x * (size_t)num_components + (size_t)c;
+    int32_t val;
+    if (bytes_per_sample == 1) {
+        val = (int32_t)row[idx];
+    } else {
+        uint16_t s;
+        std::memcpy(&s, row + idx * 2, sizeof(s));
+        val = (int32_t)s;
+    }
+    return (ojph::si32)(val - signed_offset);
+}
+
+}  // namespace
+
+extern "C" int htj2k_encode_ojph(
+    const uint8_t* input,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    int32_t num_resolutions,
+    htj2k_output_fn output,
+    void* opaque,
+    size_t* out_size
+) {
+    if (params->format == J2K_FORMAT_JP2) {
+        set_error("HTJ2K encode writes raw codestreams only (J2K_FORMAT_J2K)");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (!params->lossless && params->compression_ratio > 0) {
+        set_error("HTJ2K lossy encode has no rate control; use quality instead of compression_ratio");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->num_quality_layers > 1) {
+        set_error("HTJ2K encode supports a single quality layer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->progression_order < 0 || params->progression_order > 4) {
+        set_error_fmt("Invalid progression order %d", params->progression_order);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    const int32_t bytes_per_sample = (bits_per_component <= 8) ? 1 : 2;
+    const int32_t signed_offset = is_signed ? (1 << (bits_per_component - 1)) : 0;
+    const size_t row_bytes = (size_t)width * (size_t)num_components * (size_t)bytes_per_sample;
+
+    try {
+        ojph::codestream codestream;
+
+        ojph::param_siz siz = codestream.access_siz();
+        siz.set_image_extent(ojph::point((ojph::ui32)width, (ojph::ui32)height));
+        siz.set_num_components((ojph::ui32)num_components);
+        for (int32_t c = 0; c < num_components; c++) {
+            siz.set_component((ojph::ui32)c, ojph::point(1, 1),
+                              (ojph::ui32)bits_per_component, is_signed != 0);
+        }
+        siz.set_image_offset(ojph::point(0, 0));
+        siz.set_tile_offset(ojph::point(0, 0));
+        if (params->tile_width > 0 && params->tile_height > 0) {
+            siz.set_tile_size(ojph::size((ojph::ui32)params->tile_width,
+                                         (ojph::ui32)params->tile_height));
+        } else {
+            siz.set_tile_size(ojph::size((ojph::ui32)width, (ojph::ui32)height));
+        }
+
+        ojph::param_cod cod = codestream.access_cod();
+        cod.set_num_decomposition((ojph::ui32)(num_resolutions - 1));
+        ojph::ui32 cblk_w = 64;
+        ojph::ui32 cblk_h = 64;
+        if (params->cblk_width_exp >= 4 && params->cblk_width_exp <= 10) {
+            cblk_w = 1u << params->cblk_width_exp;
+        }
+        if (params->cblk_height_exp >= 4 && params->cblk_height_exp <= 10) {
+            cblk_h = 1u << params->cblk_height_exp;
+        }
+        cod.set_block_dims(cblk_w, cblk_h);
+        cod.set_progression_order(kProgressionOrders[params->progression_order]);
+        cod.set_color_transform(num_components == 3);
+        cod.set_reversible(params->lossless != 0);
+        if (!params->lossless) {
+            codestream.access_qcd().set_irrev_quant(quality_to_step(params->quality));
+        }
+
+        /* Interleaved input: lines arrive component by component for each row */
+        codestream.set_planar(false);
+
+        ojph::mem_outfile file;
+        file.open();
+        codestream.write_headers(&file);
+
+        ojph::ui32 next_comp = 0;
+        ojph::line_buf* line = codestream.exchange(NULL, next_comp);
+        for (int32_t y = 0; y < height; y++) {
+            const uint8_t* row = input + (size_t)y * row_bytes;
+            for (int32_t c = 0; c < num_components; c++) {
+                ojph::si32* dst = line->i32;
+                for (int32_t x = 0; x < width; x++) {
+                    dst[x] = read_sample(row, x, (int32_t)next_comp, num_components,
+                                         bytes_per_sample, signed_offset);
+                }
+                line = codestream.exchange(line, next_comp);
+            }
+        }
+        codestream.flush();
+
+        /* mem_outfile releases its buffer on close, so copy out first */
+        size_t size = (size_t)file.tell();
+        uint8_t* data = NULL;
+        int status = output(opaque, size, &data);
+        if (status != SHARPDICOM_OK) {
+            codestream.close();
+            return status;
+        }
+        std::memcpy(data, file.get_data(), size);
+        *out_size = size;
+        codestream.close();
+    } catch (const std::bad_alloc&) {
+        set_error("HTJ2K encode: out of memory");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    } catch (const std::exception& e) {
+        set_error_fmt("HTJ2K encode failed: %s", e.what());
+        return SHARPDICOM_ERR_ENCODE_FAILED;
+    } catch (...) {
+        set_error("HTJ2K encode failed");
+        return SHARPDICOM_ERR_ENCODE_FAILED;
+    }
+
+    return SHARPDICOM_OK;
+}
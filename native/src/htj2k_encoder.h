@@ -0,0 +1,70 @@
+/**
+ * SharpDicom HTJ2K Encoder (OpenJPH)
+ *
+ * Encodes component-interleaved samples to an HTJ2K (ISO/IEC 15444-15)
+ * codestream with OpenJPH, which provides the HT block encoder OpenJPEG
+ * lacks. j2k_encode() routes here when J2kEncodeParams.high_throughput is
+ * set; HTJ2K decoding goes through OpenJPEG's ht_dec.c.
+ *
+ * Only compiled when SHARPDICOM_HAS_OPENJPH is defined.
+ *
+ * Internal to the native library - not part of the exported API.
+ * Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef HTJ2K_ENCODER_H
+#define HTJ2K_ENCODER_H
+
+#include "j2k_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Destination for an encoded HTJ2K codestream: provide at least size bytes
+ * at *data, growing the output if it can.
+ *
+ * @return SHARPDICOM_OK, or negative error code (error message set)
+ */
+typedef int (*htj2k_output_fn)(void* opaque, size_t size, uint8_t** data);
+
+/**
+ * Encode raw pixels to an HTJ2K codestream.
+ *
+ * Arguments have already been validated by j2k_encode(); samples are read
+ * exactly as the OpenJPEG path reads them.
+ *
+ * @param input             Component-interleaved samples (8-bit, or 16-bit native-endian)
+ * @param width             Image width in pixels
+ * @param height            Image height in pixels
+ * @param num_components    Number of components (1-4)
+ * @param bits_per_component Bits per component (1-16)
+ * @param is_signed         Whether samples are signed
+ * @param params            Encoding parameters (high_throughput set)
+ * @param num_resolutions   Resolution levels to code (>= 1)
+ * @param output            Called once with the finished codestream's size
+ * @param opaque            Passed to output
+ * @param out_size          Receives the codestream size
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+int htj2k_encode_ojph(
+    const uint8_t* input,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    int32_t num_resolutions,
+    htj2k_output_fn output,
+    void* opaque,
+    size_t* out_size
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTJ2K_ENCODER_H */
@@ -0,0 +1,951 @@
+/**
+ * SharpDicom JPEG 2000 Codestream Scanner Implementation
+ *
+ * A resumable state machine over the codestream's marker structure. The main
+ * header yields the image/tile geometry and the default coding style, each
+ * tile-part header yields its PLT packet lengths, and every packet that has
+ * fully arrived advances its tile's position in the packet sequence. The
+ * position maps back to (layer, resolution) through the progression order
+ * and the per-resolution precinct counts, so no packet header is decoded.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "j2k_codestream.h"
+#include "sharpdicom_codecs.h"
+#include "allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Forward declarations from sharpdicom_codecs.c */
+extern void set_error_fmt(const char* fmt, ...);
+extern void set_error(const char* message);
+
+/*============================================================================
+ * Codestream constants (ISO/IEC 15444-1 Annex A)
+ *============================================================================*/
+
+#define CS_MARKER_SOC   0xFF4F
+#define CS_MARKER_SOT   0xFF90
+#define CS_MARKER_SOD   0xFF93
+#define CS_MARKER_EOC   0xFFD9
+#define CS_MARKER_SIZ   0xFF51
+#define CS_MARKER_COD   0xFF52
+#define CS_MARKER_COC   0xFF53
+#define CS_MARKER_POC   0xFF5F
+#define CS_MARKER_PLT   0xFF58
+#define CS_MARKER_PPM   0xFF60
+#define CS_MARKER_PPT   0xFF61
+
+/** Part 1 limits */
+#define CS_MAX_LEVELS       32
+#define CS_MAX_RESOLUTIONS  (CS_MAX_LEVELS + 1)
+#define CS_MAX_COMPONENTS   16384
+
+/** Default precinct exponents (PPx = PPy = 15) when Scod bit 0 is clear */
+#define CS_DEFAULT_PRECINCT 0xFF
+
+/** Progression orders as coded in SGcod */
+#define CS_PROG_LRCP    0
+#define CS_PROG_RLCP    1
+#define CS_PROG_RPCL    2
+#define CS_PROG_PCRL    3
+#define CS_PROG_CPRL    4
+
+/*============================================================================
+ * Scanner state
+ *============================================================================*/
+
+typedef enum {
+    CS_STATE_SOC = 0,       /* Waiting for SOC */
+    CS_STATE_MAIN,          /* Waiting for the complete main header */
+    CS_STATE_MARKER,        /* Between tile-parts: expecting SOT or EOC */
+    CS_STATE_PART_HEADER,   /* Waiting for the complete tile-part header */
+    CS_STATE_PART_BODY,     /* Inside tile-part packet data */
+    CS_STATE_DONE,          /* EOC scanned */
+    CS_STATE_FAILED         /* Malformed data seen; only a reset recovers */
+} cs_state;
+
+/** Per-component coding style (COD default, overridden by a main-header COC) */
+typedef struct {
+    uint8_t xr;
+    uint8_t yr;
+    uint8_t levels;
+    /** Precinct exponents per resolution: PPx in the low nibble, PPy in the high nibble */
+    uint8_t precincts[CS_MAX_RESOLUTIONS];
+} cs_component;
+
+/** Tile flags */
+#define CS_TILE_COMPLETE    0x01  /* Every tile-part of the tile has arrived */
+#define CS_TILE_UNTRACKED   0x02  /* Packet sequence can no longer be followed */
+#define CS_TILE_DIRTY       0x04  /* Summary needs recomputing */
+
+/**
+ * Per-tile progress. The summary encodes the decodable resolution count as
+ * a non-increasing step function of the requested layer count L:
+ * L <= l1 -> r1, L <= l2 -> r2, otherwise r3.
+ */
+typedef struct {
+    uint32_t packets_done;
+    uint8_t parts_seen;
+    uint8_t parts_total;
+    uint8_t flags;
+    uint8_t r1, r2, r3;
+    uint32_t l1, l2;
+} cs_tile;
+
+struct j2k_cs_scanner {
+    cs_state state;
+    /** Next unscanned byte */
+    size_t pos;
+
+    /* Image and tile geometry (SIZ) */
+    uint64_t x1, y1, x0, y0;
+    uint64_t tile_w, tile_h, tile_x0, tile_y0;
+    uint32_t tiles_x, tiles_y;
+
+    /* Coding style (COD/COC) */
+    int has_siz;
+    int has_cod;
+    uint32_t progression;
+    uint32_t num_layers;
+    uint32_t num_resolutions;
+    /** Packets cannot be mapped to (layer, resolution) anywhere in the stream */
+    int untracked;
+
+    cs_component* comps;
+    uint32_t num_comps;
+    uint32_t comps_cap;
+
+    cs_tile* tiles;
+    uint32_t num_tiles;
+    uint32_t tiles_cap;
+
+    /* Current tile-part */
+    size_t sot_pos;
+    size_t body_start;
+    /** End of the tile-part (0 = Psot of zero, runs to EOC) */
+    size_t part_end;
+    /** End of the last complete packet */
+    size_t packet_end;
+    uint32_t tile;
+    uint32_t* plt;
+    size_t plt_count;
+    size_t plt_cap;
+    size_t plt_next;
+    int part_has_plt;
+
+    /* Reporting limits */
+    int32_t max_reduce;
+    int32_t max_layers;
+};
+
+/*============================================================================
+ * Byte helpers
+ *============================================================================*/
+
+static uint32_t rd16(const uint8_t* p) {
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static uint32_t rd32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t ceil_div(uint64_t a, uint64_t b) {
+    return (a + b - 1) / b;
+}
+
+static uint64_t max_u64(uint64_t a, uint64_t b) {
+    return a > b ? a : b;
+}
+
+static uint64_t min_u64(uint64_t a, uint64_t b) {
+    return a < b ? a : b;
+}
+
+/*============================================================================
+ * Header segment collection
+ *============================================================================*/
+
+/**
+ * Walk marker segments from pos until the stop marker begins.
+ *
+ * @return 1 with *stop_pos set when the stop marker is present, 0 if more
+ *         data is needed, or SHARPDICOM_ERR_CORRUPT_DATA
+ */
+static int find_header_end(const uint8_t* data, size_t size, size_t pos,
+                           uint32_t stop_marker, size_t* stop_pos) {
+    for (;;) {
+        if (size - pos < 2) {
+            return 0;
+        }
+        uint32_t marker = rd16(data + pos);
+        if (marker == stop_marker) {
+            *stop_pos = pos;
+            return 1;
+        }
+        if ((marker & 0xFF00) != 0xFF00 || marker < 0xFF30) {
+            set_error_fmt("Invalid JPEG 2000 marker 0x%04X at offset %zu", marker, pos);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (size - pos < 4) {
+            return 0;
+        }
+        size_t seg_len = rd16(data + pos + 2);
+        if (seg_len < 2) {
+            set_error_fmt("Invalid length for JPEG 2000 marker 0x%04X", marker);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (size - pos - 2 < seg_len) {
+            return 0;
+        }
+        pos += 2 + seg_len;
+    }
+}
+
+/*============================================================================
+ * Main header parsing
+ *============================================================================*/
+
+static int parse_siz(j2k_cs_scanner_t* cs, const uint8_t* seg, size_t len) {
+    if (len < 38) {
+        set_error("Truncated SIZ marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    cs->x1 = rd32(seg + 2);
+    cs->y1 = rd32(seg + 6);
+    cs->x0 = rd32(seg + 10);
+    cs->y0 = rd32(seg + 14);
+    cs->tile_w = rd32(seg + 18);
+    cs->tile_h = rd32(seg + 22);
+    cs->tile_x0 = rd32(seg + 26);
+    cs->tile_y0 = rd32(seg + 30);
+    uint32_t num_comps = rd16(seg + 34);
+
+    if (num_comps == 0 || num_comps > CS_MAX_COMPONENTS || len < 36 + 3 * (size_t)num_comps) {
+        set_error("Invalid component count in SIZ marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (cs->x1 <= cs->x0 || cs->y1 <= cs->y0 || cs->tile_w == 0 || cs->tile_h == 0 ||
+        cs->tile_x0 > cs->x0 || cs->tile_y0 > cs->y0 ||
+        cs->tile_x0 + cs->tile_w <= cs->x0 || cs->tile_y0 + cs->tile_h <= cs->y0) {
+        set_error("Invalid image or tile geometry in SIZ marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+
+    uint64_t tiles_x = ceil_div(cs->x1 - cs->tile_x0, cs->tile_w);
+    uint64_t tiles_y = ceil_div(cs->y1 - cs->tile_y0, cs->tile_h);
+    if (tiles_x * tiles_y > J2K_CS_MAX_TILES) {
+        set_error_fmt("Too many tiles in SIZ marker: %llu", (unsigned long long)(tiles_x * tiles_y));
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    cs->tiles_x = (uint32_t)tiles_x;
+    cs->tiles_y = (uint32_t)tiles_y;
+
+    if (num_comps > cs->comps_cap) {
+        cs_component* comps = (cs_component*)allocator_realloc(cs->comps, num_comps * sizeof(cs_component));
+        if (!comps) {
+            set_error("Failed to allocate component table");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        cs->comps = comps;
+        cs->comps_cap = num_comps;
+    }
+    cs->num_comps = num_comps;
+
+    for (uint32_t c = 0; c < num_comps; c++) {
+        cs_component* comp = &cs->comps[c];
+        memset(comp, 0, sizeof(*comp));
+        comp->xr = seg[36 + 3 * c + 1];
+        comp->yr = seg[36 + 3 * c + 2];
+        if (comp->xr == 0 || comp->yr == 0) {
+            set_error("Invalid component subsampling in SIZ marker");
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+    }
+
+    cs->has_siz = 1;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Apply the SPcod/SPcoc fields (levels ... precincts) to a component.
+ * sp points at the decomposition level count.
+ */
+static int apply_coding_style(cs_component* comp, int user_precincts,
+                              const uint8_t* sp, size_t sp_len) {
+    if (sp_len < 5) {
+        set_error("Truncated coding style marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t levels = sp[0];
+    if (levels > CS_MAX_LEVELS) {
+        set_error_fmt("Invalid decomposition level count %u", levels);
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (user_precincts && sp_len < 5 + levels + 1) {
+        set_error("Truncated precinct sizes in coding style marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    comp->levels = (uint8_t)levels;
+    for (uint32_t r = 0; r <= levels; r++) {
+        comp->precincts[r] = user_precincts ? sp[5 + r] : CS_DEFAULT_PRECINCT;
+    }
+    return SHARPDICOM_OK;
+}
+
+static int parse_cod(j2k_cs_scanner_t* cs, const uint8_t* seg, size_t len) {
+    if (len < 10) {
+        set_error("Truncated COD marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t scod = seg[0];
+    cs->progression = seg[1];
+    cs->num_layers = rd16(seg + 2);
+    if (cs->progression > CS_PROG_CPRL || cs->num_layers == 0) {
+        set_error("Invalid progression order or layer count in COD marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    for (uint32_t c = 0; c < cs->num_comps; c++) {
+        int status = apply_coding_style(&cs->comps[c], scod & 1, seg + 5, len - 5);
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+    }
+    cs->has_cod = 1;
+    return SHARPDICOM_OK;
+}
+
+static int parse_coc(j2k_cs_scanner_t* cs, const uint8_t* seg, size_t len) {
+    size_t idx_len = (cs->num_comps < 257) ? 1 : 2;
+    if (len < idx_len + 1) {
+        set_error("Truncated COC marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t c = (idx_len == 1) ? seg[0] : rd16(seg);
+    if (c >= cs->num_comps) {
+        set_error_fmt("COC marker names component %u of %u", c, cs->num_comps);
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t scoc = seg[idx_len];
+    return apply_coding_style(&cs->comps[c], scoc & 1, seg + idx_len + 1, len - idx_len - 1);
+}
+
+/** Parse the complete main header between SOC and the first SOT */
+static int parse_main_header(j2k_cs_scanner_t* cs, const uint8_t* data, size_t end) {
+    size_t pos = 2;
+    int cocs_pending = 0;
+
+    /* COC may precede COD, so apply COD first and COCs in a second pass */
+    for (int pass = 0; pass < 2; pass++) {
+        pos = 2;
+        while (pos < end) {
+            uint32_t marker = rd16(data + pos);
+            size_t seg_len = rd16(data + pos + 2);
+            const uint8_t* seg = data + pos + 4;
+            size_t body = seg_len - 2;
+            int status = SHARPDICOM_OK;
+
+            if (pos == 2 && marker != CS_MARKER_SIZ) {
+                set_error("JPEG 2000 main header does not start with SIZ");
+                return SHARPDICOM_ERR_CORRUPT_DATA;
+            }
+            if (pass == 0) {
+                switch (marker) {
+                case CS_MARKER_SIZ:
+                    status = parse_siz(cs, seg, body);
+                    break;
+                case CS_MARKER_COD:
+                    status = parse_cod(cs, seg, body);
+                    break;
+                case CS_MARKER_COC:
+                    cocs_pending = 1;
+                    break;
+                case CS_MARKER_POC:
+                case CS_MARKER_PPM:
+                    /* Progression changes or relocated packet headers */
+                    cs->untracked = 1;
+                    break;
+                default:
+                    break;
+                }
+            } else if (marker == CS_MARKER_COC) {
+                status = parse_coc(cs, seg, body);
+            }
+            if (status != SHARPDICOM_OK) {
+                return status;
+            }
+            pos += 2 + seg_len;
+        }
+        if (pass == 0 && (!cs->has_siz || !cs->has_cod)) {
+            set_error("JPEG 2000 main header lacks SIZ or COD");
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (!cocs_pending) {
+            break;
+        }
+    }
+
+    /* Packets of components with different level counts interleave unevenly */
+    cs->num_resolutions = (uint32_t)cs->comps[0].levels + 1;
+    for (uint32_t c = 1; c < cs->num_comps; c++) {
+        if ((uint32_t)cs->comps[c].levels + 1 != cs->num_resolutions) {
+            cs->untracked = 1;
+            if ((uint32_t)cs->comps[c].levels + 1 > cs->num_resolutions) {
+                cs->num_resolutions = (uint32_t)cs->comps[c].levels + 1;
+            }
+        }
+    }
+
+    uint32_t num_tiles = cs->tiles_x * cs->tiles_y;
+    if (num_tiles > cs->tiles_cap) {
+        cs_tile* tiles = (cs_tile*)allocator_realloc(cs->tiles, num_tiles * sizeof(cs_tile));
+        if (!tiles) {
+            set_error("Failed to allocate tile table");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        cs->tiles = tiles;
+        cs->tiles_cap = num_tiles;
+    }
+    cs->num_tiles = num_tiles;
+    memset(cs->tiles, 0, num_tiles * sizeof(cs_tile));
+
+    return SHARPDICOM_OK;
+}
+
+/*============================================================================
+ * Tile-part parsing
+ *============================================================================*/
+
+/** Append the packet lengths of one PLT marker */
+static int parse_plt(j2k_cs_scanner_t* cs, const uint8_t* seg, size_t len) {
+    uint64_t value = 0;
+    for (size_t i = 1; i < len; i++) {
+        value = (value << 7) | (seg[i] & 0x7F);
+        if (value > UINT32_MAX) {
+            set_error("Packet length in PLT marker out of range");
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (seg[i] & 0x80) {
+            continue;
+        }
+        if (cs->plt_count == cs->plt_cap) {
+            size_t cap = cs->plt_cap ? cs->plt_cap * 2 : 256;
+            uint32_t* plt = (uint32_t*)allocator_realloc(cs->plt, cap * sizeof(uint32_t));
+            if (!plt) {
+                set_error("Failed to allocate packet length table");
+                return SHARPDICOM_ERR_OUT_OF_MEMORY;
+            }
+            cs->plt = plt;
+            cs->plt_cap = cap;
+        }
+        cs->plt[cs->plt_count++] = (uint32_t)value;
+        value = 0;
+    }
+    if (len > 1 && (seg[len - 1] & 0x80)) {
+        set_error("PLT marker ends inside a packet length");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    return SHARPDICOM_OK;
+}
+
+/** Parse the complete tile-part header between the SOT segment and SOD */
+static int parse_part_header(j2k_cs_scanner_t* cs, const uint8_t* data, size_t sod_pos) {
+    cs_tile* tile = &cs->tiles[cs->tile];
+    size_t pos = cs->sot_pos + 12;
+
+    cs->plt_count = 0;
+    cs->plt_next = 0;
+    cs->part_has_plt = 0;
+
+    while (pos < sod_pos) {
+        uint32_t marker = rd16(data + pos);
+        size_t seg_len = rd16(data + pos + 2);
+        switch (marker) {
+        case CS_MARKER_PLT: {
+            int status = parse_plt(cs, data + pos + 4, seg_len - 2);
+            if (status != SHARPDICOM_OK) {
+                return status;
+            }
+            cs->part_has_plt = 1;
+            break;
+        }
+        case CS_MARKER_COD:
+        case CS_MARKER_COC:
+        case CS_MARKER_POC:
+        case CS_MARKER_PPT:
+            /* Tile-specific coding style or relocated packet headers */
+            tile->flags |= CS_TILE_UNTRACKED;
+            break;
+        default:
+            break;
+        }
+        pos += 2 + seg_len;
+    }
+
+    cs->body_start = sod_pos + 2;
+    cs->packet_end = cs->body_start;
+    if (cs->part_end != 0 && cs->part_end < cs->body_start) {
+        set_error("Tile-part length shorter than its header");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    return SHARPDICOM_OK;
+}
+
+/** Parse an SOT segment at cs->pos (12 bytes available) */
+static int parse_sot(j2k_cs_scanner_t* cs, const uint8_t* data) {
+    const uint8_t* seg = data + cs->pos + 4;
+    if (rd16(data + cs->pos + 2) != 10) {
+        set_error("Invalid SOT marker length");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t tile_index = rd16(seg);
+    uint32_t psot = rd32(seg + 2);
+    uint32_t tpsot = seg[6];
+    uint32_t tnsot = seg[7];
+
+    if (tile_index >= cs->num_tiles) {
+        set_error_fmt("SOT marker names tile %u of %u", tile_index, cs->num_tiles);
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (psot != 0 && psot < 14) {
+        set_error("Invalid tile-part length in SOT marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+
+    cs_tile* tile = &cs->tiles[tile_index];
+    if (tpsot != tile->parts_seen) {
+        set_error_fmt("Tile %u: tile-part %u arrived after %u parts", tile_index, tpsot,
+                      (uint32_t)tile->parts_seen);
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (tnsot != 0) {
+        tile->parts_total = (uint8_t)tnsot;
+    }
+
+    cs->tile = tile_index;
+    cs->sot_pos = cs->pos;
+    cs->part_end = psot ? cs->pos + psot : 0;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Count the packets of the current tile-part that have fully arrived and
+ * finish the tile-part once all of its bytes are present.
+ *
+ * @return 1 when the tile-part is complete, 0 if more data is needed
+ */
+static int scan_part_body(j2k_cs_scanner_t* cs, const uint8_t* data, size_t size) {
+    cs_tile* tile = &cs->tiles[cs->tile];
+    size_t end = size;
+    int finished = 0;
+
+    if (cs->part_end != 0) {
+        if (size >= cs->part_end) {
+            end = cs->part_end;
+            finished = 1;
+        }
+    } else if (size - cs->body_start >= 2 && rd16(data + size - 2) == CS_MARKER_EOC) {
+        /* Psot of zero: the tile-part runs to EOC, which packet data cannot contain */
+        end = size - 2;
+        finished = 1;
+    }
+
+    if (cs->part_has_plt) {
+        while (cs->plt_next < cs->plt_count && end - cs->packet_end >= cs->plt[cs->plt_next]) {
+            cs->packet_end += cs->plt[cs->plt_next++];
+            if (!cs->untracked && !(tile->flags & CS_TILE_UNTRACKED)) {
+                tile->packets_done++;
+                tile->flags |= CS_TILE_DIRTY;
+            }
+        }
+    }
+
+    if (!finished) {
+        return 0;
+    }
+
+    /* PLT must describe the tile-part exactly for later parts to line up */
+    if (!cs->part_has_plt || cs->plt_next != cs->plt_count || cs->packet_end != end) {
+        tile->flags |= CS_TILE_UNTRACKED;
+    }
+    tile->parts_seen++;
+    if (tile->parts_total != 0 && tile->parts_seen >= tile->parts_total) {
+        tile->flags |= CS_TILE_COMPLETE;
+    }
+    tile->flags |= CS_TILE_DIRTY;
+    cs->pos = end;
+    return 1;
+}
+
+/*============================================================================
+ * Progress accounting
+ *============================================================================*/
+
+/**
+ * Packets per resolution level of one tile: the precinct counts of every
+ * component at that level (B.6), since each layer holds one packet per
+ * precinct.
+ */
+static void tile_packets_per_resolution(const j2k_cs_scanner_t* cs, uint32_t t, uint64_t* packets) {
+    uint64_t p = t % cs->tiles_x;
+    uint64_t q = t / cs->tiles_x;
+    uint64_t tx0 = max_u64(cs->tile_x0 + p * cs->tile_w, cs->x0);
+    uint64_t ty0 = max_u64(cs->tile_y0 + q * cs->tile_h, cs->y0);
+    uint64_t tx1 = min_u64(cs->tile_x0 + (p + 1) * cs->tile_w, cs->x1);
+    uint64_t ty1 = min_u64(cs->tile_y0 + (q + 1) * cs->tile_h, cs->y1);
+
+    memset(packets, 0, CS_MAX_RESOLUTIONS * sizeof(uint64_t));
+    for (uint32_t c = 0; c < cs->num_comps; c++) {
+        const cs_component* comp = &cs->comps[c];
+        uint64_t tcx0 = ceil_div(tx0, comp->xr);
+        uint64_t tcx1 = ceil_div(tx1, comp->xr);
+        uint64_t tcy0 = ceil_div(ty0, comp->yr);
+        uint64_t tcy1 = ceil_div(ty1, comp->yr);
+        for (uint32_t r = 0; r <= comp->levels; r++) {
+            uint32_t n = comp->levels - r;
+            uint64_t scale = (uint64_t)1 << n;
+            uint64_t rx0 = ceil_div(tcx0, scale);
+            uint64_t rx1 = ceil_div(tcx1, scale);
+            uint64_t ry0 = ceil_div(tcy0, scale);
+            uint64_t ry1 = ceil_div(tcy1, scale);
+            if (rx1 <= rx0 || ry1 <= ry0) {
+                continue;
+            }
+            uint32_t ppx = comp->precincts[r] & 0x0F;
+            uint32_t ppy = comp->precincts[r] >> 4;
+            uint64_t nx = ceil_div(rx1, (uint64_t)1 << ppx) - (rx0 >> ppx);
+            uint64_t ny = ceil_div(ry1, (uint64_t)1 << ppy) - (ry0 >> ppy);
+            packets[r] += nx * ny;
+        }
+    }
+}
+
+/** Recompute a tile's decodable step function from its packet count */
+static void tile_update_summary(const j2k_cs_scanner_t* cs, uint32_t t) {
+    cs_tile* tile = &cs->tiles[t];
+    const uint8_t full = (uint8_t)cs->num_resolutions;
+
+    tile->flags &= (uint8_t)~CS_TILE_DIRTY;
+    tile->l1 = tile->l2 = UINT32_MAX;
+    tile->r1 = tile->r2 = tile->r3 = 0;
+
+    if (tile->flags & CS_TILE_COMPLETE) {
+        tile->r1 = full;
+        return;
+    }
+    if (tile->packets_done == 0) {
+        tile->l1 = tile->l2 = 0;
+        return;
+    }
+
+    uint64_t packets[CS_MAX_RESOLUTIONS];
+    tile_packets_per_resolution(cs, t, packets);
+    uint64_t done = tile->packets_done;
+    uint32_t layers = cs->num_layers;
+
+    if (cs->progression == CS_PROG_LRCP) {
+        /* Layer-major: whole layers at every resolution, then a partial layer */
+        uint64_t per_layer = 0;
+        for (uint32_t r = 0; r < cs->num_resolutions; r++) {
+            per_layer += packets[r];
+        }
+        uint64_t layers_done = per_layer ? done / per_layer : layers;
+        if (layers_done >= layers) {
+            tile->r1 = full;
+            return;
+        }
+        uint64_t rem = done - layers_done * per_layer;
+        uint8_t partial = 0;
+        while (partial < full && rem >= packets[partial]) {
+            rem -= packets[partial++];
+        }
+        tile->l1 = (uint32_t)layers_done;
+        tile->r1 = full;
+        tile->l2 = (uint32_t)layers_done + 1;
+        tile->r2 = partial;
+        tile->r3 = 0;
+        return;
+    }
+
+    if (cs->progression == CS_PROG_PCRL || cs->progression == CS_PROG_CPRL) {
+        /* Position/component-major: no resolution is whole until the tile is */
+        tile->l1 = tile->l2 = 0;
+        return;
+    }
+
+    /* Resolution-major (RLCP, RPCL): whole resolutions, then a partial one */
+    uint8_t res_done = 0;
+    while (res_done < full && done >= (uint64_t)layers * packets[res_done]) {
+        done -= (uint64_t)layers * packets[res_done++];
+    }
+    if (res_done >= full) {
+        tile->r1 = full;
+        return;
+    }
+    /* RLCP orders the partial resolution layer by layer; RPCL does not */
+    uint32_t layers_partial = 0;
+    if (cs->progression == CS_PROG_RLCP) {
+        layers_partial = (uint32_t)(done / packets[res_done]);
+    }
+    tile->l1 = layers_partial;
+    tile->r1 = (uint8_t)(res_done + 1);
+    tile->l2 = layers_partial;
+    tile->r2 = res_done;
+    tile->r3 = res_done;
+}
+
+static uint32_t tile_resolutions_at(const cs_tile* tile, uint32_t layers) {
+    if (layers <= tile->l1) {
+        return tile->r1;
+    }
+    if (layers <= tile->l2) {
+        return tile->r2;
+    }
+    return tile->r3;
+}
+
+/** Resolutions decodable across all tiles when decoding `layers` layers */
+static uint32_t resolutions_at(const j2k_cs_scanner_t* cs, uint32_t layers, uint32_t cap) {
+    uint32_t res = cap;
+    for (uint32_t t = 0; t < cs->num_tiles && res > 0; t++) {
+        uint32_t r = tile_resolutions_at(&cs->tiles[t], layers);
+        if (r < res) {
+            res = r;
+        }
+    }
+    return res;
+}
+
+static void fill_progress(j2k_cs_scanner_t* cs, J2kCsProgress* progress) {
+    memset(progress, 0, sizeof(*progress));
+
+    if (cs->state <= CS_STATE_MAIN) {
+        return;
+    }
+    progress->header_ready = 1;
+    progress->num_resolutions = (int32_t)cs->num_resolutions;
+    progress->num_layers = (int32_t)cs->num_layers;
+    progress->complete = (cs->state == CS_STATE_DONE);
+
+    /* Prefix boundary: never inside a header, and inside a body only after a whole packet */
+    if (cs->state == CS_STATE_PART_HEADER) {
+        progress->decodable_end = cs->sot_pos;
+    } else if (cs->state == CS_STATE_PART_BODY) {
+        if (cs->part_has_plt && cs->packet_end > cs->body_start) {
+            progress->decodable_end = cs->packet_end;
+            progress->cut_sot = cs->sot_pos;
+        } else {
+            progress->decodable_end = cs->sot_pos;
+        }
+    } else {
+        progress->decodable_end = cs->pos;
+    }
+
+    for (uint32_t t = 0; t < cs->num_tiles; t++) {
+        if (cs->state == CS_STATE_DONE) {
+            cs->tiles[t].flags |= CS_TILE_COMPLETE | CS_TILE_DIRTY;
+        }
+        if (cs->tiles[t].flags & CS_TILE_DIRTY) {
+            tile_update_summary(cs, t);
+        }
+    }
+
+    uint32_t res_cap = cs->num_resolutions;
+    if (cs->max_reduce > 0) {
+        res_cap = ((uint32_t)cs->max_reduce < res_cap) ? res_cap - (uint32_t)cs->max_reduce : 1;
+    }
+    uint32_t layer_cap = cs->num_layers;
+    if (cs->max_layers > 0 && (uint32_t)cs->max_layers < layer_cap) {
+        layer_cap = (uint32_t)cs->max_layers;
+    }
+
+    /* Prefer resolution, then the most layers at that resolution (monotone in layers) */
+    uint32_t res = resolutions_at(cs, 1, res_cap);
+    if (res == 0) {
+        return;
+    }
+    uint32_t lo = 1;
+    uint32_t hi = layer_cap;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (resolutions_at(cs, mid, res_cap) == res) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    progress->resolutions = (int32_t)res;
+    progress->layers = (int32_t)lo;
+}
+
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+int j2k_cs_scanner_create(j2k_cs_scanner_t** scanner_out) {
+    if (!scanner_out) {
+        set_error("Invalid parameters: scanner_out is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    j2k_cs_scanner_t* cs = (j2k_cs_scanner_t*)allocator_calloc(1, sizeof(j2k_cs_scanner_t));
+    if (!cs) {
+        set_error("Failed to allocate codestream scanner");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    *scanner_out = cs;
+    return SHARPDICOM_OK;
+}
+
+void j2k_cs_scanner_reset(j2k_cs_scanner_t* scanner) {
+    if (!scanner) {
+        return;
+    }
+    /* Keep the tables; everything else starts over */
+    cs_component* comps = scanner->comps;
+    uint32_t comps_cap = scanner->comps_cap;
+    cs_tile* tiles = scanner->tiles;
+    uint32_t tiles_cap = scanner->tiles_cap;
+    uint32_t* plt = scanner->plt;
+    size_t plt_cap = scanner->plt_cap;
+    int32_t max_reduce = scanner->max_reduce;
+    int32_t max_layers = scanner->max_layers;
+
+    memset(scanner, 0, sizeof(*scanner));
+    scanner->comps = comps;
+    scanner->comps_cap = comps_cap;
+    scanner->tiles = tiles;
+    scanner->tiles_cap = tiles_cap;
+    scanner->plt = plt;
+    scanner->plt_cap = plt_cap;
+    scanner->max_reduce = max_reduce;
+    scanner->max_layers = max_layers;
+}
+
+void j2k_cs_scanner_set_limits(j2k_cs_scanner_t* scanner, int32_t max_reduce, int32_t max_layers) {
+    if (!scanner) {
+        return;
+    }
+    scanner->max_reduce = max_reduce > 0 ? max_reduce : 0;
+    scanner->max_layers = max_layers > 0 ? max_layers : 0;
+}
+
+int j2k_cs_scanner_update(
+    j2k_cs_scanner_t* cs,
+    const uint8_t* data,
+    size_t size,
+    J2kCsProgress* progress
+) {
+    if (!cs || !progress || (!data && size > 0)) {
+        set_error("Invalid parameters: scanner, data, or progress is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (cs->state == CS_STATE_FAILED) {
+        set_error("Codestream scanner stopped at malformed data");
+        memset(progress, 0, sizeof(*progress));
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (size < cs->pos) {
+        set_error("Codestream prefix shrank between scanner updates");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int status = SHARPDICOM_OK;
+    int progressing = 1;
+    while (progressing && status == SHARPDICOM_OK) {
+        progressing = 0;
+        switch (cs->state) {
+        case CS_STATE_SOC:
+            if (size < 2) {
+                break;
+            }
+            if (rd16(data) != CS_MARKER_SOC) {
+                set_error("Not a raw JPEG 2000 codestream (missing SOC marker)");
+                status = SHARPDICOM_ERR_CORRUPT_DATA;
+                break;
+            }
+            cs->pos = 2;
+            cs->state = CS_STATE_MAIN;
+            progressing = 1;
+            break;
+
+        case CS_STATE_MAIN: {
+            size_t sot_pos = 0;
+            int found = find_header_end(data, size, 2, CS_MARKER_SOT, &sot_pos);
+            if (found < 0) {
+                status = found;
+            } else if (found) {
+                status = parse_main_header(cs, data, sot_pos);
+                cs->pos = sot_pos;
+                cs->state = CS_STATE_MARKER;
+                progressing = 1;
+            }
+            break;
+        }
+
+        case CS_STATE_MARKER: {
+            if (size - cs->pos < 2) {
+                break;
+            }
+            uint32_t marker = rd16(data + cs->pos);
+            if (marker == CS_MARKER_EOC) {
+                cs->state = CS_STATE_DONE;
+            } else if (marker != CS_MARKER_SOT) {
+                set_error_fmt("Expected SOT or EOC at offset %zu, found 0x%04X", cs->pos, marker);
+                status = SHARPDICOM_ERR_CORRUPT_DATA;
+            } else if (size - cs->pos >= 12) {
+                status = parse_sot(cs, data);
+                cs->state = CS_STATE_PART_HEADER;
+                progressing = 1;
+            }
+            break;
+        }
+
+        case CS_STATE_PART_HEADER: {
+            size_t sod_pos = 0;
+            int found = find_header_end(data, size, cs->sot_pos + 12, CS_MARKER_SOD, &sod_pos);
+            if (found < 0) {
+                status = found;
+            } else if (found) {
+                status = parse_part_header(cs, data, sod_pos);
+                cs->state = CS_STATE_PART_BODY;
+                progressing = 1;
+            }
+            break;
+        }
+
+        case CS_STATE_PART_BODY:
+            if (scan_part_body(cs, data, size)) {
+                cs->state = CS_STATE_MARKER;
+                progressing = 1;
+            }
+            break;
+
+        case CS_STATE_DONE:
+        case CS_STATE_FAILED:
+            break;
+        }
+    }
+
+    if (status != SHARPDICOM_OK) {
+        if (status == SHARPDICOM_ERR_CORRUPT_DATA) {
+            cs->state = CS_STATE_FAILED;
+        }
+        memset(progress, 0, sizeof(*progress));
+        return status;
+    }
+
+    fill_progress(cs, progress);
+    return SHARPDICOM_OK;
+}
+
+void j2k_cs_scanner_destroy(j2k_cs_scanner_t* scanner) {
+    if (!scanner) {
+        return;
+    }
+    allocator_free(scanner->comps);
+    allocator_free(scanner->tiles);
+    allocator_free(scanner->plt);
+    allocator_free(scanner);
+}
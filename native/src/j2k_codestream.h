@@ -0,0 +1,112 @@
+/**
+ * SharpDicom JPEG 2000 Codestream Scanner
+ *
+ * Incrementally walks the marker structure of a raw JPEG 2000 codestream
+ * (ISO/IEC 15444-1 Annex A) as it arrives and works out which resolution
+ * levels and quality layers the bytes received so far fully contain.
+ *
+ * Packets are located through PLT (packet length) markers. Tile-parts
+ * without PLT are accounted for only when their tile is complete, and
+ * streams with PPM/PPT headers or POC progression changes fall back to
+ * whole-tile granularity. The scanner never decodes packet headers.
+ *
+ * No external library is required; j2k_progressive_* builds on it.
+ *
+ * Internal to the native library - not part of the exported API.
+ * Thread Safety: Distinct scanners may be used concurrently.
+ */
+
+#ifndef J2K_CODESTREAM_H
+#define J2K_CODESTREAM_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Most tiles a codestream can have: the SOT Isot field indexes tiles 0..65534 */
+#define J2K_CS_MAX_TILES 65535
+
+/** Opaque incremental codestream scanner */
+typedef struct j2k_cs_scanner j2k_cs_scanner_t;
+
+/** What the scanned prefix of a codestream can be decoded to */
+typedef struct {
+    /** 1 once the main header (SOC up to the first SOT) has been scanned */
+    int32_t header_ready;
+    /** Resolution levels and quality layers coded (valid once header_ready) */
+    int32_t num_resolutions;
+    int32_t num_layers;
+    /** Resolution levels / layers fully contained in the prefix (0 = nothing decodable) */
+    int32_t resolutions;
+    int32_t layers;
+    /** 1 once the EOC marker has been scanned */
+    int32_t complete;
+    /** Length of the prefix backing resolutions/layers, ending on a packet or tile-part boundary */
+    size_t decodable_end;
+    /** Offset of the SOT whose tile-part is cut short at decodable_end, or 0 if none */
+    size_t cut_sot;
+} J2kCsProgress;
+
+/**
+ * Create a scanner positioned before the SOC marker.
+ *
+ * @param scanner_out   Receives the new scanner
+ *
+ * @return SHARPDICOM_OK, SHARPDICOM_ERR_INVALID_ARGUMENT or SHARPDICOM_ERR_OUT_OF_MEMORY
+ */
+int j2k_cs_scanner_create(j2k_cs_scanner_t** scanner_out);
+
+/**
+ * Rewind a scanner for a new codestream, keeping its allocations.
+ *
+ * @param scanner       Scanner handle
+ */
+void j2k_cs_scanner_reset(j2k_cs_scanner_t* scanner);
+
+/**
+ * Limit the reported level, e.g. to the caller's reduce/layer options.
+ * Scanning itself is unaffected.
+ *
+ * @param scanner       Scanner handle
+ * @param max_reduce    Resolution levels above full size the caller never decodes (0 = none)
+ * @param max_layers    Maximum quality layers the caller decodes (0 = all)
+ */
+void j2k_cs_scanner_set_limits(j2k_cs_scanner_t* scanner, int32_t max_reduce, int32_t max_layers);
+
+/**
+ * Scan newly arrived bytes.
+ *
+ * data/size describe everything received so far; each call resumes where
+ * the previous one stopped, so total work is linear in the codestream size.
+ *
+ * @param scanner       Scanner handle
+ * @param data          All bytes received so far (prefix of the codestream)
+ * @param size          Number of bytes received (never less than on the previous call)
+ * @param progress      Receives the decodable state
+ *
+ * @return SHARPDICOM_OK on success (including when more data is needed), or:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL arguments or shrinking size
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Not a raw codestream or malformed markers
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+int j2k_cs_scanner_update(
+    j2k_cs_scanner_t* scanner,
+    const uint8_t* data,
+    size_t size,
+    J2kCsProgress* progress
+);
+
+/**
+ * Destroy a scanner.
+ *
+ * @param scanner       Scanner handle (may be NULL)
+ */
+void j2k_cs_scanner_destroy(j2k_cs_scanner_t* scanner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* J2K_CODESTREAM_H */
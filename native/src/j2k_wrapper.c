@@ -2,12 +2,17 @@
  * SharpDicom JPEG 2000 Wrapper Implementation
  *
  * Wraps OpenJPEG library for JPEG 2000 encoding and decoding.
- * Supports resolution level decode (thumbnails), ROI decode, and tiled encoding.
+ * Supports resolution level decode (thumbnails), ROI decode (optionally
+ * through a decoded-tile cache), progressive decode of partially received
+ * codestreams, and tiled encoding.
  */
 
 #define SHARPDICOM_CODECS_EXPORTS
 #include "j2k_wrapper.h"
 #include "sharpdicom_codecs.h"
+#include "allocator.h"
+#include "codec_stats.h"
+#include "pixel_convert.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +30,20 @@ extern void set_error(const char* message);
 
 #include <openjpeg.h>
 
+#include "j2k_codestream.h"
+#include "thread_pool.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+#ifdef SHARPDICOM_HAS_OPENJPH
+#include "htj2k_encoder.h"
+#endif
+
 /*============================================================================
  * Memory stream for OpenJPEG
  *============================================================================*/
@@ -36,10 +55,21 @@ typedef struct {
     size_t offset;
 } MemoryStreamReader;
 
+/** Smallest capacity a growable output buffer is grown to */
+#define J2K_OUTPUT_MIN_CAPACITY (64 * 1024)
+
+/**
+ * Stream user data for memory output. Bytes between 'end' and a position
+ * reached by a forward skip or seek are only zeroed if nothing is written
+ * over them (OpenJPEG skips ahead to reserve space it fills in later).
+ */
 typedef struct {
     uint8_t* data;
     size_t capacity;
-    size_t size;
+    size_t size;                /* Write position */
+    size_t end;                 /* Bytes of data written so far */
+    J2kOutputBuffer* growable;  /* Buffer to grow on demand, NULL if data is fixed */
+    int out_of_space;           /* Set when data was full and could not grow */
 } MemoryStreamWriter;
 
 static OPJ_SIZE_T mem_stream_read(void* buffer, OPJ_SIZE_T nb_bytes, void* user_data) {
@@ -82,13 +112,61 @@ static OPJ_BOOL mem_stream_seek_read(OPJ_OFF_T nb_bytes, void* user_data) {
     return OPJ_TRUE;
 }
 
+/**
+ * Make data hold at least 'needed' bytes. A growable buffer at least
+ * doubles so a run of writes costs amortized O(1) copies.
+ */
+static int writer_reserve(MemoryStreamWriter* writer, size_t needed) {
+    if (needed <= writer->capacity) {
+        return 1;
+    }
+    J2kOutputBuffer* out = writer->growable;
+    if (!out) {
+        writer->out_of_space = 1;
+        return 0;
+    }
+
+    size_t target = writer->capacity * 2;
+    if (target < needed) target = needed;
+    if (target < J2K_OUTPUT_MIN_CAPACITY) target = J2K_OUTPUT_MIN_CAPACITY;
+
+    size_t capacity = target;
+    uint8_t* data = out->grow
+        ? out->grow(out->opaque, writer->data, writer->end, target, &capacity)
+        : (uint8_t*)realloc(writer->data, target);
+    if (data) {
+        writer->data = out->data = data;
+        writer->capacity = out->capacity = capacity;
+    }
+    if (!data || capacity < needed) {
+        writer->out_of_space = 1;
+        return 0;
+    }
+    return 1;
+}
+
+/** Zero what a skip or seek past the written bytes left undefined */
+static int writer_fill_gap(MemoryStreamWriter* writer) {
+    if (writer->size > writer->end) {
+        if (!writer_reserve(writer, writer->size)) {
+            return 0;
+        }
+        memset(writer->data + writer->end, 0, writer->size - writer->end);
+        writer->end = writer->size;
+    }
+    return 1;
+}
+
 static OPJ_SIZE_T mem_stream_write(void* buffer, OPJ_SIZE_T nb_bytes, void* user_data) {
     MemoryStreamWriter* writer = (MemoryStreamWriter*)user_data;
-    if (writer->size + nb_bytes > writer->capacity) {
+    if (!writer_reserve(writer, writer->size + nb_bytes) || !writer_fill_gap(writer)) {
         return (OPJ_SIZE_T)-1; /* Buffer overflow */
     }
     memcpy(writer->data + writer->size, buffer, nb_bytes);
     writer->size += nb_bytes;
+    if (writer->size > writer->end) {
+        writer->end = writer->size;
+    }
     return nb_bytes;
 }
 
@@ -104,31 +182,32 @@ static OPJ_OFF_T mem_stream_skip_write(OPJ_OFF_T nb_bytes, void* user_data) {
         writer->size -= back;
         return nb_bytes;
     }
-    /* Forward skip - fill with zeros */
-    if (writer->size + (OPJ_SIZE_T)nb_bytes > writer->capacity) {
+    /* Forward skip - only moves the position; see writer_fill_gap() */
+    if (!writer->growable && writer->size + (OPJ_SIZE_T)nb_bytes > writer->capacity) {
         OPJ_OFF_T available = (OPJ_OFF_T)(writer->capacity - writer->size);
-        memset(writer->data + writer->size, 0, (size_t)available);
         writer->size = writer->capacity;
+        writer->out_of_space = 1;
         return available;
     }
-    memset(writer->data + writer->size, 0, (size_t)nb_bytes);
     writer->size += (size_t)nb_bytes;
     return nb_bytes;
 }
 
 static OPJ_BOOL mem_stream_seek_write(OPJ_OFF_T nb_bytes, void* user_data) {
     MemoryStreamWriter* writer = (MemoryStreamWriter*)user_data;
-    if (nb_bytes < 0 || (OPJ_SIZE_T)nb_bytes > writer->capacity) {
+    if (nb_bytes < 0 || (!writer->growable && (OPJ_SIZE_T)nb_bytes > writer->capacity)) {
         return OPJ_FALSE;
     }
-    /* Extend with zeros if seeking past current size */
-    if ((OPJ_SIZE_T)nb_bytes > writer->size) {
-        memset(writer->data + writer->size, 0, (size_t)nb_bytes - writer->size);
-    }
     writer->size = (size_t)nb_bytes;
     return OPJ_TRUE;
 }
 
+/** Append bytes at the end of the written data */
+static int writer_append(MemoryStreamWriter* writer, const uint8_t* data, size_t len) {
+    writer->size = writer->end;
+    return mem_stream_write((void*)data, len, writer) == len;
+}
+
 /*============================================================================
  * OpenJPEG message handlers
  *============================================================================*/
@@ -140,12 +219,12 @@ static void opj_error_callback(const char* msg, void* client_data) {
         /* Remove trailing newline if present */
         size_t len = strlen(msg);
         if (len > 0 && msg[len - 1] == '\n') {
-            char* clean = (char*)malloc(len);
+            char* clean = (char*)allocator_alloc(len);
             if (clean) {
                 memcpy(clean, msg, len - 1);
                 clean[len - 1] = '\0';
                 set_error(clean);
-                free(clean);
+                allocator_free(clean);
             }
         } else {
             set_error(msg);
@@ -198,6 +277,108 @@ static J2kFormat detect_format(const uint8_t* data, size_t size) {
     return J2K_FORMAT_J2K;
 }
 
+/*============================================================================
+ * Helper: Detect HTJ2K (Part 15) codestreams
+ *============================================================================*/
+
+#define J2K_MARKER_SOT  0xFF90
+#define J2K_MARKER_CAP  0xFF50
+#define J2K_MARKER_COD  0xFF52
+
+/** Pcap bit announcing Part 15 capabilities in the CAP marker */
+#define J2K_PCAP_PART15 0x00020000u
+
+/** Code-block style bit selecting the HT block coder in COD/COC */
+#define J2K_CBLK_STYLE_HT 0x40
+
+static uint32_t read_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/**
+ * Locate the codestream inside a JP2 file by walking its top-level boxes
+ * to the contiguous codestream ('jp2c') box. Returns NULL if absent.
+ */
+static const uint8_t* find_jp2_codestream(const uint8_t* data, size_t size, size_t* cs_size) {
+    size_t pos = 0;
+    while (size - pos >= 8) {
+        uint64_t box_len = read_be32(data + pos);
+        uint32_t box_type = read_be32(data + pos + 4);
+        size_t header = 8;
+        if (box_len == 1) {
+            if (size - pos < 16) {
+                return NULL;
+            }
+            box_len = ((uint64_t)read_be32(data + pos + 8) << 32) | read_be32(data + pos + 12);
+            header = 16;
+        } else if (box_len == 0) {
+            box_len = size - pos;
+        }
+        if (box_len < header || box_len > size - pos) {
+            return NULL;
+        }
+        if (box_type == 0x6A703263) { /* 'jp2c' */
+            *cs_size = (size_t)box_len - header;
+            return data + pos + header;
+        }
+        pos += (size_t)box_len;
+    }
+    return NULL;
+}
+
+/**
+ * Image area (width * height) from the SIZ marker, which has to follow SOC.
+ * Returns 0 if it cannot be read; OpenJPEG reports the error on decode.
+ */
+static uint64_t codestream_pixels(const uint8_t* data, size_t size, J2kFormat format) {
+    if (data && format == J2K_FORMAT_JP2) {
+        data = find_jp2_codestream(data, size, &size);
+    }
+    /* SOC, then SIZ up to and including YOsiz */
+    if (!data || size < 24 || data[0] != 0xFF || data[1] != 0x4F || data[2] != 0xFF || data[3] != 0x51) {
+        return 0;
+    }
+    uint32_t x1 = read_be32(data + 8), y1 = read_be32(data + 12);
+    uint32_t x0 = read_be32(data + 16), y0 = read_be32(data + 20);
+    return (x1 > x0 && y1 > y0) ? (uint64_t)(x1 - x0) * (y1 - y0) : 0;
+}
+
+/**
+ * Scan the main header for the Part 15 CAP bit or an HT code-block style
+ * in the default COD marker.
+ */
+static int detect_htj2k(const uint8_t* data, size_t size, J2kFormat format) {
+    if (format == J2K_FORMAT_JP2) {
+        data = find_jp2_codestream(data, size, &size);
+        if (!data) {
+            return 0;
+        }
+    }
+    if (size < 4 || data[0] != 0xFF || data[1] != 0x4F) {
+        return 0;
+    }
+
+    size_t pos = 2;
+    while (size - pos >= 4) {
+        uint32_t marker = ((uint32_t)data[pos] << 8) | data[pos + 1];
+        size_t seg_len = ((size_t)data[pos + 2] << 8) | data[pos + 3];
+        if (marker == J2K_MARKER_SOT || seg_len < 2 || seg_len > size - pos - 2) {
+            break;
+        }
+        const uint8_t* seg = data + pos + 4;
+        size_t body = seg_len - 2;
+        if (marker == J2K_MARKER_CAP && body >= 4 && (read_be32(seg) & J2K_PCAP_PART15)) {
+            return 1;
+        }
+        /* Scod, progression, layers(2), MCT, levels, xcb, ycb, style */
+        if (marker == J2K_MARKER_COD && body >= 9 && (seg[8] & J2K_CBLK_STYLE_HT)) {
+            return 1;
+        }
+        pos += 2 + seg_len;
+    }
+    return 0;
+}
+
 /*============================================================================
  * Helper: Create stream for reading
  *============================================================================*/
@@ -249,26 +430,65 @@ static J2kColorSpace map_colorspace(OPJ_COLOR_SPACE opj_cs) {
 }
 
 /*============================================================================
- * API Implementation
+ * Helper: Decode worker threads
  *============================================================================*/
 
-SHARPDICOM_API int j2k_get_info(
-    const uint8_t* input,
-    size_t input_len,
-    J2kImageInfo* info
-) {
-    if (!input || input_len == 0 || !info) {
-        set_error("Invalid parameters: input, input_len, or info is NULL/zero");
-        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+/** Upper bound on workers (guards against absurd caller values) */
+#define J2K_MAX_THREADS 256
+
+/**
+ * Smallest frame (width * height) that gets the library thread budget by
+ * default. Below it, starting and joining the workers costs more than the
+ * decode or encode they would share.
+ */
+#define J2K_AUTO_THREADS_MIN_PIXELS (1024u * 1024u)
+
+/** Process-wide default worker count (0 = the library thread budget) */
+static volatile int32_t g_default_threads = 0;
+
+/**
+ * Resolve the worker count for a decode or encode call.
+ * 0 falls back to the process default, which in turn falls back to the
+ * library thread budget (sharpdicom_set_thread_count) for frames of at least
+ * J2K_AUTO_THREADS_MIN_PIXELS, and to one thread for smaller or unknown
+ * sizes (pixels = 0). On a pool worker the call is already one of several
+ * in parallel, so it stays single-threaded.
+ */
+static int32_t resolve_pool_threads(int32_t requested, uint64_t pixels) {
+    if (requested <= 0) {
+        requested = g_default_threads;
+    }
+    if (requested <= 0) {
+        requested = (thread_pool_on_worker() || pixels < J2K_AUTO_THREADS_MIN_PIXELS)
+            ? 1 : thread_pool_budget();
     }
+    if (requested < 1) requested = 1;
+    if (requested > J2K_MAX_THREADS) requested = J2K_MAX_THREADS;
+    return requested;
+}
 
-    memset(info, 0, sizeof(J2kImageInfo));
+/** resolve_pool_threads() for work OpenJPEG itself spreads across threads */
+static int32_t resolve_threads(int32_t requested, uint64_t pixels) {
+    return opj_has_thread_support() ? resolve_pool_threads(requested, pixels) : 1;
+}
 
-    /* Detect format */
-    J2kFormat format = detect_format(input, input_len);
-    info->format = format;
+/*============================================================================
+ * Helper: Create and configure a decompressor
+ *============================================================================*/
 
-    /* Create codec based on format */
+/**
+ * Create an OpenJPEG decompressor with message handlers, decode options and
+ * worker threads applied. OpenJPEG requires the thread count to be set before
+ * the header is read, so header-only callers pass num_threads = 1.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int create_decompressor(
+    J2kFormat format,
+    const J2kDecodeOptions* options,
+    int32_t num_threads,
+    opj_codec_t** out_codec
+) {
     OPJ_CODEC_FORMAT codec_format = (format == J2K_FORMAT_JP2) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K;
     opj_codec_t* codec = opj_create_decompress(codec_format);
     if (!codec) {
@@ -285,31 +505,303 @@ SHARPDICOM_API int j2k_get_info(
     opj_dparameters_t params;
     opj_set_default_decoder_parameters(&params);
 
+    /* Apply decode options */
+    if (options) {
+        params.cp_reduce = (OPJ_UINT32)options->reduce;
+        params.cp_layer = (OPJ_UINT32)options->max_quality_layers;
+    }
+
     if (!opj_setup_decoder(codec, &params)) {
         set_error("Failed to setup decoder parameters");
         opj_destroy_codec(codec);
         return SHARPDICOM_ERR_INTERNAL;
     }
 
+    /* Non-fatal if the pool cannot be created - decode stays on this thread */
+    if (num_threads > 1) {
+        opj_codec_set_threads(codec, (int)num_threads);
+    }
+
+    *out_codec = codec;
+    return SHARPDICOM_OK;
+}
+
+/*============================================================================
+ * Helper: Convert decoded components into the caller's output layout
+ *============================================================================*/
+
+/**
+ * Compute the bytes a strided buffer must span: stride * (rows - 1) + row_bytes.
+ * Returns 0 on overflow.
+ */
+static size_t strided_size(size_t stride, size_t rows, size_t row_bytes) {
+    size_t body = safe_mul_size(stride, rows - 1);
+    if (body == 0 && stride != 0 && rows > 1) return 0;
+    if (body > SIZE_MAX - row_bytes) return 0;
+    return body + row_bytes;
+}
+
+/**
+ * Validate a layout against the output geometry and resolve the start of
+ * every destination: dst[0] for interleaved output, dst[c] per component
+ * for planar output.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int resolve_layout(
+    const J2kOutputLayout* layout,
+    size_t width,
+    size_t height,
+    uint32_t num_comps,
+    size_t bytes_per_sample,
+    uint8_t** dst,
+    size_t* stride_out
+) {
+    int planar = (layout->mode == J2K_LAYOUT_PLANAR);
+
+    if (planar && num_comps > J2K_MAX_PLANES) {
+        set_error_fmt("Planar output supports at most %d components (image has %u)",
+                      J2K_MAX_PLANES, (unsigned)num_comps);
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    /* Row geometry (with overflow protection) */
+    size_t row_bytes = safe_mul3_size(width, planar ? 1 : (size_t)num_comps, bytes_per_sample);
+    size_t stride = layout->row_stride ? layout->row_stride : row_bytes;
+    if (row_bytes == 0 || stride < row_bytes || stride % bytes_per_sample != 0) {
+        set_error("Invalid row stride: smaller than a row or not sample-aligned");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    size_t span = strided_size(stride, height, row_bytes);
+    if (span == 0) {
+        set_error("Image dimensions too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!planar) {
+        if (!layout->data || layout->data_len < span) {
+            set_error("Output buffer too small for decoded image");
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+        dst[0] = layout->data;
+        *stride_out = stride;
+        return SHARPDICOM_OK;
+    }
+
+    /* Resolve and validate every destination before writing any of them */
+    size_t plane_step = safe_mul_size(stride, height);
+    for (uint32_t c = 0; c < num_comps; c++) {
+        if (layout->planes[c]) {
+            dst[c] = layout->planes[c];
+            if (layout->plane_lens[c] < span) {
+                set_error_fmt("Plane %u buffer too small for decoded image", (unsigned)c);
+                return SHARPDICOM_ERR_INVALID_ARGUMENT;
+            }
+        } else {
+            /* Carve plane c out of data at c * stride * height */
+            size_t start = safe_mul_size(plane_step, (size_t)c);
+            if (!layout->data || plane_step == 0 || (c > 0 && start == 0) ||
+                layout->data_len < span || layout->data_len - span < start) {
+                set_error_fmt("Output buffer too small for plane %u", (unsigned)c);
+                return SHARPDICOM_ERR_INVALID_ARGUMENT;
+            }
+            dst[c] = layout->data + start;
+        }
+    }
+    *stride_out = stride;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Write the decoded components of an image into the caller-described layout
+ * using the SIMD conversion kernels. Validates strides and buffer sizes
+ * against the dimensions of the first component.
+ *
+ * @param display       Transform to display pixels in the same pass (NULL = stored samples)
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int write_to_layout(
+    const opj_image_t* image,
+    const J2kOutputLayout* layout,
+    const display_params_t* display
+) {
+    OPJ_UINT32 num_comps = image->numcomps;
+    size_t width = (size_t)image->comps[0].w;
+    size_t height = (size_t)image->comps[0].h;
+    int32_t bits = (int32_t)image->comps[0].prec;
+    size_t bytes_per_sample = (bits <= 8 || display) ? 1 : 2;
+    int planar = (layout->mode == J2K_LAYOUT_PLANAR);
+
+    if (num_comps == 0 || width == 0 || height == 0) {
+        set_error("Decoded image has no samples");
+        return SHARPDICOM_ERR_DECODE_FAILED;
+    }
+
+    uint8_t* dst[J2K_MAX_PLANES];
+    size_t stride = 0;
+    int status = resolve_layout(layout, width, height, num_comps, bytes_per_sample, dst, &stride);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    /* Every plane is read with the first component's geometry */
+    const int32_t* planes[J2K_MAX_PLANES];
+    int32_t offsets[J2K_MAX_PLANES];
+    const int32_t** src = planes;
+    int32_t* src_offsets = offsets;
+
+    if (num_comps > J2K_MAX_PLANES) {
+        src = (const int32_t**)allocator_alloc(num_comps * sizeof(*src));
+        src_offsets = (int32_t*)allocator_alloc(num_comps * sizeof(*src_offsets));
+        if (!src || !src_offsets) {
+            allocator_free((void*)src);
+            allocator_free(src_offsets);
+            set_error("Failed to allocate component table");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    for (OPJ_UINT32 c = 0; c < num_comps; c++) {
+        const opj_image_comp_t* comp = &image->comps[c];
+        if (comp->w != image->comps[0].w || comp->h != image->comps[0].h || !comp->data) {
+            set_error("Subsampled JPEG 2000 components are not supported");
+            status = SHARPDICOM_ERR_UNSUPPORTED;
+            break;
+        }
+        src[c] = comp->data;
+        /* Handle signed values */
+        src_offsets[c] = (comp->sgnd && bits >= 1 && bits <= 31) ? (1 << (bits - 1)) : 0;
+    }
+
+    /* Display output maps the signed values themselves, so offsets are unused */
+    pixel_display_map map;
+    memset(&map, 0, sizeof(map));
+    if (status == SHARPDICOM_OK && display) {
+        status = pixel_display_map_init(&map, display, bits, image->comps[0].sgnd != 0);
+    }
+
+    if (status == SHARPDICOM_OK && display && !planar) {
+        pixel_interleave_display_i32(src, (int)num_comps, width, height, &map, dst[0], stride);
+    } else if (status == SHARPDICOM_OK && display) {
+        for (OPJ_UINT32 c = 0; c < num_comps; c++) {
+            pixel_interleave_display_i32(&src[c], 1, width, height, &map, dst[c], stride);
+        }
+    } else if (status == SHARPDICOM_OK && !planar) {
+        pixel_interleave_i32(src, src_offsets, (int)num_comps, width, height,
+                             (int)bytes_per_sample, dst[0], stride);
+    } else if (status == SHARPDICOM_OK) {
+        for (OPJ_UINT32 c = 0; c < num_comps; c++) {
+            pixel_interleave_i32(&src[c], &src_offsets[c], 1, width, height,
+                                 (int)bytes_per_sample, dst[c], stride);
+        }
+    }
+    pixel_display_map_release(&map);
+
+    if (src != planes) {
+        allocator_free((void*)src);
+        allocator_free(src_offsets);
+    }
+    return status;
+}
+
+/*============================================================================
+ * Decoder context
+ *
+ * Holds a codec whose main header has been parsed. One-shot API calls use a
+ * context on the stack; j2k_decoder_t handles keep it between calls so the
+ * header is parsed once per codestream. OpenJPEG codecs cannot decode twice,
+ * so a context re-parses the header only when asked to decode again.
+ *============================================================================*/
+
+struct j2k_decoder {
+    /** Decode options fixed at creation */
+    J2kDecodeOptions options;
+    /** Whether options were supplied (NULL = library defaults) */
+    int has_options;
+    /**
+     * Worker threads requested for decode (0 = default for the frame size,
+     * 1 = header only / single-threaded); resolved per codestream
+     */
+    int32_t num_threads;
+    /** Caller-owned codestream (must outlive the context or next set_input) */
+    const uint8_t* input;
+    size_t input_len;
+    J2kFormat format;
+    /** Stream state for the parsed codec */
+    MemoryStreamReader reader;
+    opj_codec_t* codec;
+    opj_stream_t* stream;
+    opj_image_t* image;
+    /** Header information cached from the first parse */
+    J2kImageInfo info;
+    int has_info;
+};
+
+static void decoder_init(struct j2k_decoder* dec, const J2kDecodeOptions* options, int32_t num_threads) {
+    memset(dec, 0, sizeof(*dec));
+    if (options) {
+        dec->options = *options;
+        dec->has_options = 1;
+    }
+    dec->num_threads = num_threads;
+}
+
+/** Release the parsed codec state (keeps input and cached info) */
+static void decoder_release(struct j2k_decoder* dec) {
+    if (dec->image) {
+        opj_image_destroy(dec->image);
+        dec->image = NULL;
+    }
+    if (dec->stream) {
+        opj_stream_destroy(dec->stream);
+        dec->stream = NULL;
+    }
+    if (dec->codec) {
+        opj_destroy_codec(dec->codec);
+        dec->codec = NULL;
+    }
+}
+
+/** Create a codec for dec->input and read its main header */
+static int decoder_parse(struct j2k_decoder* dec) {
+    uint64_t pixels = codestream_pixels(dec->input, dec->input_len, dec->format);
+    int32_t num_threads = resolve_threads(dec->num_threads, pixels);
+    int status = create_decompressor(dec->format, dec->has_options ? &dec->options : NULL,
+                                     num_threads, &dec->codec);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
     /* Create memory stream */
-    MemoryStreamReader reader = { input, input_len, 0 };
-    opj_stream_t* stream = create_read_stream(&reader);
-    if (!stream) {
+    dec->reader.data = dec->input;
+    dec->reader.size = dec->input_len;
+    dec->reader.offset = 0;
+    dec->stream = create_read_stream(&dec->reader);
+    if (!dec->stream) {
         set_error("Failed to create memory stream");
-        opj_destroy_codec(codec);
+        decoder_release(dec);
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
     }
 
     /* Read header */
-    opj_image_t* image = NULL;
-    if (!opj_read_header(stream, codec, &image)) {
+    if (!opj_read_header(dec->stream, dec->codec, &dec->image)) {
         set_error("Failed to read JPEG 2000 header");
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
+        dec->image = NULL;
+        decoder_release(dec);
         return SHARPDICOM_ERR_CORRUPT_DATA;
     }
 
-    /* Extract information */
+    return SHARPDICOM_OK;
+}
+
+/** Extract image information from a parsed header */
+static void decoder_fill_info(struct j2k_decoder* dec) {
+    J2kImageInfo* info = &dec->info;
+    const opj_image_t* image = dec->image;
+
+    memset(info, 0, sizeof(J2kImageInfo));
+    info->format = dec->format;
+    info->is_htj2k = detect_htj2k(dec->input, dec->input_len, dec->format);
     info->width = (int32_t)(image->x1 - image->x0);
     info->height = (int32_t)(image->y1 - image->y0);
     info->num_components = (int32_t)image->numcomps;
@@ -321,7 +813,7 @@ SHARPDICOM_API int j2k_get_info(
     }
 
     /* Get codestream info for resolution levels */
-    opj_codestream_info_v2_t* cs_info = opj_get_cstr_info(codec);
+    opj_codestream_info_v2_t* cs_info = opj_get_cstr_info(dec->codec);
     if (cs_info) {
         /* Get tile info for resolution count */
         if (cs_info->m_default_tile_info.tccp_info) {
@@ -335,150 +827,99 @@ SHARPDICOM_API int j2k_get_info(
         opj_destroy_cstr_info(&cs_info);
     }
 
-    /* Cleanup */
-    opj_image_destroy(image);
-    opj_stream_destroy(stream);
-    opj_destroy_codec(codec);
+    dec->has_info = 1;
+}
+
+/** Attach a codestream to the context and parse its main header */
+static int decoder_attach(struct j2k_decoder* dec, const uint8_t* input, size_t input_len) {
+    decoder_release(dec);
+    dec->has_info = 0;
+    dec->input = input;
+    dec->input_len = input_len;
+    dec->format = detect_format(input, input_len);
+
+    int status = decoder_parse(dec);
+    if (status != SHARPDICOM_OK) {
+        dec->input = NULL;
+        dec->input_len = 0;
+        return status;
+    }
 
+    decoder_fill_info(dec);
     return SHARPDICOM_OK;
 }
 
-SHARPDICOM_API int j2k_decode(
-    const uint8_t* input,
-    size_t input_len,
-    uint8_t* output,
-    size_t output_len,
-    const J2kDecodeOptions* options,
+/**
+ * Decode the attached codestream into a layout.
+ *
+ * @param region        {x0, y0, x1, y1} in full resolution space, or NULL for the whole image
+ */
+static int decoder_run(
+    struct j2k_decoder* dec,
+    const J2kOutputLayout* layout,
+    const int32_t* region,
     int32_t* out_width,
     int32_t* out_height,
     int32_t* out_components
 ) {
-    if (!input || input_len == 0 || !output || output_len == 0) {
-        set_error("Invalid parameters: input or output buffer is NULL/zero");
+    if (!dec->input) {
+        set_error("No codestream attached to decoder");
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Detect format */
-    J2kFormat format = detect_format(input, input_len);
-
-    /* Create codec */
-    OPJ_CODEC_FORMAT codec_format = (format == J2K_FORMAT_JP2) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K;
-    opj_codec_t* codec = opj_create_decompress(codec_format);
-    if (!codec) {
-        set_error("Failed to create OpenJPEG decompressor");
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
-    }
-
-    /* Set up message handlers */
-    opj_set_error_handler(codec, opj_error_callback, NULL);
-    opj_set_warning_handler(codec, opj_warning_callback, NULL);
-    opj_set_info_handler(codec, opj_info_callback, NULL);
-
-    /* Set decode parameters */
-    opj_dparameters_t params;
-    opj_set_default_decoder_parameters(&params);
-
-    /* Apply decode options */
-    if (options) {
-        params.cp_reduce = (OPJ_UINT32)options->reduce;
-        params.cp_layer = (OPJ_UINT32)options->max_quality_layers;
-    }
-
-    if (!opj_setup_decoder(codec, &params)) {
-        set_error("Failed to setup decoder parameters");
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_INTERNAL;
-    }
+    int64_t start = codec_stats_start();
+    size_t input_len = dec->input_len;
 
-    /* Create memory stream */
-    MemoryStreamReader reader = { input, input_len, 0 };
-    opj_stream_t* stream = create_read_stream(&reader);
-    if (!stream) {
-        set_error("Failed to create memory stream");
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    /* A previous decode consumed the codec - parse the header again */
+    if (!dec->codec) {
+        int status = decoder_parse(dec);
+        if (status != SHARPDICOM_OK) {
+            codec_stats_record(SHARPDICOM_STATS_J2K, CODEC_STATS_DECODE, start, input_len, 0, status);
+            return status;
+        }
     }
 
-    /* Read header */
-    opj_image_t* image = NULL;
-    if (!opj_read_header(stream, codec, &image)) {
-        set_error("Failed to read JPEG 2000 header");
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_CORRUPT_DATA;
+    /* Set decode area (ROI) */
+    if (region && !opj_set_decode_area(dec->codec, dec->image,
+                                       (OPJ_INT32)region[0], (OPJ_INT32)region[1],
+                                       (OPJ_INT32)region[2], (OPJ_INT32)region[3])) {
+        set_error("Failed to set decode area");
+        decoder_release(dec);
+        codec_stats_record(SHARPDICOM_STATS_J2K, CODEC_STATS_DECODE, start,
+                           input_len, 0, SHARPDICOM_ERR_INVALID_ARGUMENT);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Decode image */
-    if (!opj_decode(codec, stream, image)) {
-        set_error("Failed to decode JPEG 2000 image");
-        opj_image_destroy(image);
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
+    /* Decode image or region */
+    if (!opj_decode(dec->codec, dec->stream, dec->image)) {
+        set_error(region ? "Failed to decode JPEG 2000 region" : "Failed to decode JPEG 2000 image");
+        decoder_release(dec);
+        codec_stats_record(SHARPDICOM_STATS_J2K, CODEC_STATS_DECODE, start,
+                           input_len, 0, SHARPDICOM_ERR_DECODE_FAILED);
         return SHARPDICOM_ERR_DECODE_FAILED;
     }
 
-    /* End decoding */
-    if (!opj_end_decompress(codec, stream)) {
-        /* Non-fatal - some files don't have proper end marker */
-    }
+    /* End decoding - non-fatal, some files don't have proper end marker */
+    opj_end_decompress(dec->codec, dec->stream);
 
-    /* Calculate output dimensions */
+    /* Output dimensions (region may be smaller due to reduction) */
+    const opj_image_t* image = dec->image;
     int32_t width = (int32_t)(image->comps[0].w);
     int32_t height = (int32_t)(image->comps[0].h);
     int32_t num_comps = (int32_t)image->numcomps;
-    int32_t bits = (int32_t)image->comps[0].prec;
-    int32_t bytes_per_sample = (bits <= 8) ? 1 : 2;
+    const display_params_t* display = dec->has_options ? dec->options.display : NULL;
+    size_t sample_bytes = (display || image->comps[0].prec <= 8) ? 1 : 2;
 
-    /* Check output buffer size (with overflow protection) */
-    size_t required_size = safe_mul4_size((size_t)width, (size_t)height, (size_t)num_comps, (size_t)bytes_per_sample);
-    if (required_size == 0 || output_len < required_size) {
-        set_error("Output buffer too small or image dimensions too large");
-        opj_image_destroy(image);
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_INVALID_ARGUMENT;
-    }
+    /* Convert into the requested layout */
+    int status = write_to_layout(image, layout, display);
 
-    /* Copy decoded data to output buffer (component-interleaved) */
-    if (bytes_per_sample == 1) {
-        /* 8-bit output */
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                size_t pixel_idx = (size_t)y * (size_t)width + (size_t)x;
-                size_t out_idx = pixel_idx * (size_t)num_comps;
-                for (int32_t c = 0; c < num_comps; c++) {
-                    int32_t val = image->comps[c].data[pixel_idx];
-                    /* Handle signed values */
-                    if (image->comps[c].sgnd) {
-                        val += (1 << (bits - 1));
-                    }
-                    /* Clamp to [0, 255] */
-                    if (val < 0) val = 0;
-                    if (val > 255) val = 255;
-                    output[out_idx + c] = (uint8_t)val;
-                }
-            }
-        }
-    } else {
-        /* 16-bit output (little-endian) */
-        uint16_t* out16 = (uint16_t*)output;
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                size_t pixel_idx = (size_t)y * (size_t)width + (size_t)x;
-                size_t out_idx = pixel_idx * (size_t)num_comps;
-                for (int32_t c = 0; c < num_comps; c++) {
-                    int32_t val = image->comps[c].data[pixel_idx];
-                    /* Handle signed values */
-                    if (image->comps[c].sgnd) {
-                        val += (1 << (bits - 1));
-                    }
-                    /* Clamp to [0, 65535] */
-                    if (val < 0) val = 0;
-                    if (val > 65535) val = 65535;
-                    out16[out_idx + c] = (uint16_t)val;
-                }
-            }
-        }
+    /* The codec cannot be reused for another decode */
+    decoder_release(dec);
+
+    codec_stats_record(SHARPDICOM_STATS_J2K, CODEC_STATS_DECODE, start, input_len,
+                       (size_t)width * (size_t)height * (size_t)num_comps * sample_bytes, status);
+    if (status != SHARPDICOM_OK) {
+        return status;
     }
 
     /* Return output dimensions */
@@ -486,14 +927,112 @@ SHARPDICOM_API int j2k_decode(
     if (out_height) *out_height = height;
     if (out_components) *out_components = num_comps;
 
-    /* Cleanup */
-    opj_image_destroy(image);
-    opj_stream_destroy(stream);
-    opj_destroy_codec(codec);
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Shared one-shot decode path for the whole-image and region entry points.
+ *
+ * @param region        {x0, y0, x1, y1} in full resolution space, or NULL for the whole image
+ */
+static int decode_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    const int32_t* region,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    struct j2k_decoder dec;
+    decoder_init(&dec, options, options ? options->num_threads : 0);
+
+    int status = decoder_attach(&dec, input, input_len);
+    if (status == SHARPDICOM_OK) {
+        status = decoder_run(&dec, layout, region, out_width, out_height, out_components);
+    }
+
+    decoder_release(&dec);
+    return status;
+}
+
+/** Build the dense interleaved layout used by the buffer-based entry points */
+static J2kOutputLayout interleaved_layout(uint8_t* output, size_t output_len) {
+    J2kOutputLayout layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.mode = J2K_LAYOUT_INTERLEAVED;
+    layout.data = output;
+    layout.data_len = output_len;
+    return layout;
+}
 
+/** Check that a layout names at least one destination */
+static int validate_layout(const J2kOutputLayout* layout) {
+    if (!layout) {
+        set_error("Invalid parameters: layout is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (layout->mode != J2K_LAYOUT_INTERLEAVED && layout->mode != J2K_LAYOUT_PLANAR) {
+        set_error("Invalid layout mode");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (layout->mode == J2K_LAYOUT_INTERLEAVED && (!layout->data || layout->data_len == 0)) {
+        set_error("Invalid parameters: layout data buffer is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
     return SHARPDICOM_OK;
 }
 
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+SHARPDICOM_API int j2k_get_info(
+    const uint8_t* input,
+    size_t input_len,
+    J2kImageInfo* info
+) {
+    if (!input || input_len == 0 || !info) {
+        set_error("Invalid parameters: input, input_len, or info is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(info, 0, sizeof(J2kImageInfo));
+
+    /* Header only, no worker threads */
+    struct j2k_decoder dec;
+    decoder_init(&dec, NULL, 1);
+
+    int status = decoder_attach(&dec, input, input_len);
+    if (status == SHARPDICOM_OK) {
+        *info = dec.info;
+    }
+
+    decoder_release(&dec);
+    return status;
+}
+
+SHARPDICOM_API int j2k_decode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!input || input_len == 0 || !output || output_len == 0) {
+        set_error("Invalid parameters: input or output buffer is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    J2kOutputLayout layout = interleaved_layout(output, output_len);
+    return decode_to_layout(input, input_len, &layout, NULL, options,
+                            out_width, out_height, out_components);
+}
+
 SHARPDICOM_API int j2k_decode_region(
     const uint8_t* input,
     size_t input_len,
@@ -518,163 +1057,130 @@ SHARPDICOM_API int j2k_decode_region(
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Detect format */
-    J2kFormat format = detect_format(input, input_len);
-
-    /* Create codec */
-    OPJ_CODEC_FORMAT codec_format = (format == J2K_FORMAT_JP2) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K;
-    opj_codec_t* codec = opj_create_decompress(codec_format);
-    if (!codec) {
-        set_error("Failed to create OpenJPEG decompressor");
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
-    }
-
-    /* Set up message handlers */
-    opj_set_error_handler(codec, opj_error_callback, NULL);
-    opj_set_warning_handler(codec, opj_warning_callback, NULL);
-    opj_set_info_handler(codec, opj_info_callback, NULL);
-
-    /* Set decode parameters */
-    opj_dparameters_t params;
-    opj_set_default_decoder_parameters(&params);
+    const int32_t region[4] = { x0, y0, x1, y1 };
+    J2kOutputLayout layout = interleaved_layout(output, output_len);
+    return decode_to_layout(input, input_len, &layout, region, options,
+                            out_width, out_height, out_components);
+}
 
-    /* Apply decode options */
-    if (options) {
-        params.cp_reduce = (OPJ_UINT32)options->reduce;
-        params.cp_layer = (OPJ_UINT32)options->max_quality_layers;
+SHARPDICOM_API int j2k_decode_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!input || input_len == 0) {
+        set_error("Invalid parameters: input buffer is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    if (!opj_setup_decoder(codec, &params)) {
-        set_error("Failed to setup decoder parameters");
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_INTERNAL;
+    int status = validate_layout(layout);
+    if (status != SHARPDICOM_OK) {
+        return status;
     }
 
-    /* Create memory stream */
-    MemoryStreamReader reader = { input, input_len, 0 };
-    opj_stream_t* stream = create_read_stream(&reader);
-    if (!stream) {
-        set_error("Failed to create memory stream");
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
-    }
+    return decode_to_layout(input, input_len, layout, NULL, options,
+                            out_width, out_height, out_components);
+}
 
-    /* Read header */
-    opj_image_t* image = NULL;
-    if (!opj_read_header(stream, codec, &image)) {
-        set_error("Failed to read JPEG 2000 header");
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_CORRUPT_DATA;
+SHARPDICOM_API int j2k_decode_region_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!input || input_len == 0) {
+        set_error("Invalid parameters: input buffer is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Set decode area (ROI) */
-    if (!opj_set_decode_area(codec, image,
-                            (OPJ_INT32)x0, (OPJ_INT32)y0,
-                            (OPJ_INT32)x1, (OPJ_INT32)y1)) {
-        set_error("Failed to set decode area");
-        opj_image_destroy(image);
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
+    if (x0 >= x1 || y0 >= y1) {
+        set_error("Invalid region: x0 >= x1 or y0 >= y1");
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Decode region */
-    if (!opj_decode(codec, stream, image)) {
-        set_error("Failed to decode JPEG 2000 region");
-        opj_image_destroy(image);
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_DECODE_FAILED;
+    int status = validate_layout(layout);
+    if (status != SHARPDICOM_OK) {
+        return status;
     }
 
-    /* End decoding */
-    opj_end_decompress(codec, stream);
+    const int32_t region[4] = { x0, y0, x1, y1 };
+    return decode_to_layout(input, input_len, layout, region, options,
+                            out_width, out_height, out_components);
+}
 
-    /* Calculate output dimensions (region may be smaller due to reduction) */
-    int32_t width = (int32_t)(image->comps[0].w);
-    int32_t height = (int32_t)(image->comps[0].h);
-    int32_t num_comps = (int32_t)image->numcomps;
-    int32_t bits = (int32_t)image->comps[0].prec;
-    int32_t bytes_per_sample = (bits <= 8) ? 1 : 2;
+/*============================================================================
+ * Encoding
+ *============================================================================*/
 
-    /* Check output buffer size (with overflow protection) */
-    size_t required_size = safe_mul4_size((size_t)width, (size_t)height, (size_t)num_comps, (size_t)bytes_per_sample);
-    if (required_size == 0 || output_len < required_size) {
-        set_error("Output buffer too small for region or dimensions too large");
-        opj_image_destroy(image);
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+#if defined(_WIN32) || defined(_WIN64)
+    #define claim_flag(p) (InterlockedCompareExchange((volatile LONG*)(p), 1, 0) == 0)
+#else
+    static int claim_flag(volatile int32_t* p) {
+        int32_t expected = 0;
+        return __atomic_compare_exchange_n(p, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
     }
+#endif
 
-    /* Copy decoded data to output buffer (component-interleaved) */
-    if (bytes_per_sample == 1) {
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                size_t pixel_idx = (size_t)y * (size_t)width + (size_t)x;
-                size_t out_idx = pixel_idx * (size_t)num_comps;
-                for (int32_t c = 0; c < num_comps; c++) {
-                    int32_t val = image->comps[c].data[pixel_idx];
-                    if (image->comps[c].sgnd) {
-                        val += (1 << (bits - 1));
-                    }
-                    if (val < 0) val = 0;
-                    if (val > 255) val = 255;
-                    output[out_idx + c] = (uint8_t)val;
-                }
-            }
-        }
-    } else {
-        uint16_t* out16 = (uint16_t*)output;
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                size_t pixel_idx = (size_t)y * (size_t)width + (size_t)x;
-                size_t out_idx = pixel_idx * (size_t)num_comps;
-                for (int32_t c = 0; c < num_comps; c++) {
-                    int32_t val = image->comps[c].data[pixel_idx];
-                    if (image->comps[c].sgnd) {
-                        val += (1 << (bits - 1));
-                    }
-                    if (val < 0) val = 0;
-                    if (val > 65535) val = 65535;
-                    out16[out_idx + c] = (uint16_t)val;
-                }
-            }
-        }
-    }
+#define J2K_MARKER_SOC  0xFF4F
+#define J2K_MARKER_SIZ  0xFF51
+#define J2K_MARKER_EOC  0xFFD9
 
-    /* Return output dimensions */
-    if (out_width) *out_width = width;
-    if (out_height) *out_height = height;
-    if (out_components) *out_components = num_comps;
+static uint16_t read_be16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
 
-    /* Cleanup */
-    opj_image_destroy(image);
-    opj_stream_destroy(stream);
-    opj_destroy_codec(codec);
+static void write_be16(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
 
-    return SHARPDICOM_OK;
+static void write_be32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
 }
 
-SHARPDICOM_API int j2k_encode(
-    const uint8_t* input,
+/** Defaults used when J2kEncodeParams is NULL (lossless) */
+static const J2kEncodeParams default_encode_params = {
+    .lossless = 1,
+    .compression_ratio = 0,
+    .quality = 0,
+    .num_resolutions = 0,
+    .num_quality_layers = 0,
+    .tile_width = 0,
+    .tile_height = 0,
+    .format = J2K_FORMAT_J2K,
+    .cblk_width_exp = 0,
+    .cblk_height_exp = 0,
+    .progression_order = 0,
+    .high_throughput = 0,
+    .num_threads = 0
+};
+
+/**
+ * Validate encode arguments shared by j2k_encode() and j2k_encode_to_buffer().
+ *
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT (error message set)
+ */
+static int validate_encode_input(
     size_t input_len,
     int32_t width,
     int32_t height,
     int32_t num_components,
-    int32_t bits_per_component,
-    int32_t is_signed,
-    const J2kEncodeParams* params,
-    uint8_t* output,
-    size_t output_len,
-    size_t* out_size
+    int32_t bits_per_component
 ) {
-    if (!input || input_len == 0 || !output || output_len == 0 || !out_size) {
-        set_error("Invalid parameters: input, output, or out_size is NULL/zero");
-        return SHARPDICOM_ERR_INVALID_ARGUMENT;
-    }
-
     if (width <= 0 || height <= 0) {
         set_error("Invalid dimensions: width and height must be positive");
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
@@ -699,39 +1205,54 @@ SHARPDICOM_API int j2k_encode(
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Use defaults if params is NULL */
-    J2kEncodeParams default_params = {
-        .lossless = 1,
-        .compression_ratio = 0,
-        .quality = 0,
-        .num_resolutions = 0,
-        .num_quality_layers = 0,
-        .tile_width = 0,
-        .tile_height = 0,
-        .format = J2K_FORMAT_J2K,
-        .cblk_width_exp = 0,
-        .cblk_height_exp = 0,
-        .progression_order = 0
-    };
-    if (!params) {
-        params = &default_params;
+    return SHARPDICOM_OK;
+}
+
+/** Resolution levels to encode (0 = based on image size) */
+static int32_t encode_resolutions(const J2kEncodeParams* params, int32_t width, int32_t height) {
+    int32_t num_res = params->num_resolutions;
+    if (num_res <= 0) {
+        int32_t min_dim = (width < height) ? width : height;
+        num_res = 1;
+        while ((min_dim >> num_res) >= 32 && num_res < 7) {
+            num_res++;
+        }
     }
+    return num_res;
+}
 
+/**
+ * Create an OpenJPEG image from the [x0, x1) x [y0, y1) region of the
+ * component-interleaved input, placed at (x0, y0) on the reference grid.
+ *
+ * @return Image, or NULL if allocation failed (error message set)
+ */
+static opj_image_t* create_encode_image(
+    const uint8_t* input,
+    int32_t width,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1
+) {
     /* Create image component parameters */
-    opj_image_cmptparm_t* cmptparms = (opj_image_cmptparm_t*)calloc(
+    opj_image_cmptparm_t* cmptparms = (opj_image_cmptparm_t*)allocator_calloc(
         (size_t)num_components, sizeof(opj_image_cmptparm_t));
     if (!cmptparms) {
         set_error("Failed to allocate component parameters");
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        return NULL;
     }
 
     for (int32_t c = 0; c < num_components; c++) {
         cmptparms[c].dx = 1;
         cmptparms[c].dy = 1;
-        cmptparms[c].w = (OPJ_UINT32)width;
-        cmptparms[c].h = (OPJ_UINT32)height;
-        cmptparms[c].x0 = 0;
-        cmptparms[c].y0 = 0;
+        cmptparms[c].w = (OPJ_UINT32)(x1 - x0);
+        cmptparms[c].h = (OPJ_UINT32)(y1 - y0);
+        cmptparms[c].x0 = (OPJ_UINT32)x0;
+        cmptparms[c].y0 = (OPJ_UINT32)y0;
         cmptparms[c].prec = (OPJ_UINT32)bits_per_component;
         cmptparms[c].bpp = (OPJ_UINT32)bits_per_component;
         cmptparms[c].sgnd = (OPJ_UINT32)is_signed;
@@ -749,117 +1270,139 @@ SHARPDICOM_API int j2k_encode(
 
     /* Create image */
     opj_image_t* image = opj_image_create((OPJ_UINT32)num_components, cmptparms, color_space);
-    free(cmptparms);
+    allocator_free(cmptparms);
 
     if (!image) {
         set_error("Failed to create OpenJPEG image");
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        return NULL;
     }
 
-    image->x0 = 0;
-    image->y0 = 0;
-    image->x1 = (OPJ_UINT32)width;
-    image->y1 = (OPJ_UINT32)height;
+    image->x0 = (OPJ_UINT32)x0;
+    image->y0 = (OPJ_UINT32)y0;
+    image->x1 = (OPJ_UINT32)x1;
+    image->y1 = (OPJ_UINT32)y1;
 
     /* Copy input data to image components */
-    int32_t bytes_per_sample = (bits_per_component <= 8) ? 1 : 2;
-
-    if (bytes_per_sample == 1) {
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                size_t pixel_idx = (size_t)y * (size_t)width + (size_t)x;
-                size_t in_idx = pixel_idx * (size_t)num_components;
+    size_t region_width = (size_t)(x1 - x0);
+    int32_t offset = is_signed ? (1 << (bits_per_component - 1)) : 0;
+    if (bits_per_component <= 8) {
+        for (int32_t y = y0; y < y1; y++) {
+            const uint8_t* row = input + ((size_t)y * (size_t)width + (size_t)x0) * (size_t)num_components;
+            size_t pixel_idx = (size_t)(y - y0) * region_width;
+            for (size_t x = 0; x < region_width; x++, pixel_idx++) {
                 for (int32_t c = 0; c < num_components; c++) {
-                    int32_t val = (int32_t)input[in_idx + c];
-                    if (is_signed) {
-                        val -= (1 << (bits_per_component - 1));
-                    }
-                    image->comps[c].data[pixel_idx] = val;
+                    image->comps[c].data[pixel_idx] = (int32_t)row[x * (size_t)num_components + c] - offset;
                 }
             }
         }
     } else {
         const uint16_t* in16 = (const uint16_t*)input;
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                size_t pixel_idx = (size_t)y * (size_t)width + (size_t)x;
-                size_t in_idx = pixel_idx * (size_t)num_components;
+        for (int32_t y = y0; y < y1; y++) {
+            const uint16_t* row = in16 + ((size_t)y * (size_t)width + (size_t)x0) * (size_t)num_components;
+            size_t pixel_idx = (size_t)(y - y0) * region_width;
+            for (size_t x = 0; x < region_width; x++, pixel_idx++) {
                 for (int32_t c = 0; c < num_components; c++) {
-                    int32_t val = (int32_t)in16[in_idx + c];
-                    if (is_signed) {
-                        val -= (1 << (bits_per_component - 1));
-                    }
-                    image->comps[c].data[pixel_idx] = val;
+                    image->comps[c].data[pixel_idx] = (int32_t)row[x * (size_t)num_components + c] - offset;
                 }
             }
         }
     }
 
-    /* Set encoder parameters */
-    opj_cparameters_t cparams;
-    opj_set_default_encoder_parameters(&cparams);
+    return image;
+}
+
+/** Translate J2kEncodeParams into OpenJPEG encoder parameters */
+static void setup_encode_parameters(opj_cparameters_t* cparams, const J2kEncodeParams* params, int32_t num_res) {
+    opj_set_default_encoder_parameters(cparams);
 
     /* Apply encoding parameters */
     if (params->lossless) {
-        cparams.irreversible = 0;  /* Use 5/3 reversible DWT */
-        cparams.tcp_numlayers = 1;
-        cparams.tcp_rates[0] = 0; /* Lossless */
+        cparams->irreversible = 0;  /* Use 5/3 reversible DWT */
+        cparams->tcp_numlayers = 1;
+        cparams->tcp_rates[0] = 0; /* Lossless */
     } else {
-        cparams.irreversible = 1;  /* Use 9/7 irreversible DWT */
+        cparams->irreversible = 1;  /* Use 9/7 irreversible DWT */
         if (params->compression_ratio > 0) {
-            cparams.tcp_numlayers = 1;
-            cparams.tcp_rates[0] = params->compression_ratio;
-            cparams.cp_disto_alloc = 1;
+            cparams->tcp_numlayers = 1;
+            cparams->tcp_rates[0] = params->compression_ratio;
+            cparams->cp_disto_alloc = 1;
         } else if (params->quality > 0) {
-            cparams.tcp_numlayers = 1;
+            cparams->tcp_numlayers = 1;
             /* Map quality 1-100 to distortion (higher quality = lower distortion) */
-            cparams.tcp_distoratio[0] = params->quality;
-            cparams.cp_fixed_quality = 1;
+            cparams->tcp_distoratio[0] = params->quality;
+            cparams->cp_fixed_quality = 1;
         }
     }
 
     /* Resolution levels */
-    if (params->num_resolutions > 0) {
-        cparams.numresolution = params->num_resolutions;
-    } else {
-        /* Calculate based on image size */
-        int32_t min_dim = (width < height) ? width : height;
-        int32_t num_res = 1;
-        while ((min_dim >> num_res) >= 32 && num_res < 7) {
-            num_res++;
-        }
-        cparams.numresolution = num_res;
-    }
+    cparams->numresolution = num_res;
 
     /* Quality layers */
     if (params->num_quality_layers > 0 && !params->lossless) {
-        cparams.tcp_numlayers = (int)params->num_quality_layers;
+        cparams->tcp_numlayers = (int)params->num_quality_layers;
     }
 
     /* Tiling */
     if (params->tile_width > 0 && params->tile_height > 0) {
-        cparams.tile_size_on = OPJ_TRUE;
-        cparams.cp_tdx = params->tile_width;
-        cparams.cp_tdy = params->tile_height;
+        cparams->tile_size_on = OPJ_TRUE;
+        cparams->cp_tdx = params->tile_width;
+        cparams->cp_tdy = params->tile_height;
     }
 
     /* Code-block size */
     if (params->cblk_width_exp >= 4 && params->cblk_width_exp <= 10) {
-        cparams.cblockw_init = (1 << params->cblk_width_exp);
+        cparams->cblockw_init = (1 << params->cblk_width_exp);
     }
     if (params->cblk_height_exp >= 4 && params->cblk_height_exp <= 10) {
-        cparams.cblockh_init = (1 << params->cblk_height_exp);
+        cparams->cblockh_init = (1 << params->cblk_height_exp);
     }
 
     /* Progression order */
-    cparams.prog_order = (OPJ_PROG_ORDER)params->progression_order;
+    cparams->prog_order = (OPJ_PROG_ORDER)params->progression_order;
+}
+
+/** Error for a writer that ran out of space, or 0 if it did not */
+static int writer_space_error(const MemoryStreamWriter* writer) {
+    if (!writer->out_of_space) {
+        return 0;
+    }
+    if (writer->growable) {
+        set_error("Failed to grow output buffer");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    set_error("Output buffer too small for encoded data (see j2k_get_encode_bound)");
+    return SHARPDICOM_ERR_ENCODE_FAILED;
+}
+
+#ifdef SHARPDICOM_HAS_OPENJPH
+/** htj2k_output_fn: room for a whole codestream at the start of a writer */
+static int writer_output(void* opaque, size_t size, uint8_t** data) {
+    MemoryStreamWriter* writer = (MemoryStreamWriter*)opaque;
+    if (!writer_reserve(writer, size)) {
+        return writer_space_error(writer);
+    }
+    *data = writer->data;
+    return SHARPDICOM_OK;
+}
+#endif
 
+/**
+ * Compress an image into a writer with one OpenJPEG codec.
+ * cparams may be modified by OpenJPEG.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int compress_image(
+    opj_cparameters_t* cparams,
+    opj_image_t* image,
+    OPJ_CODEC_FORMAT codec_format,
+    int32_t num_threads,
+    MemoryStreamWriter* writer
+) {
     /* Create codec */
-    OPJ_CODEC_FORMAT codec_format = (params->format == J2K_FORMAT_JP2) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K;
     opj_codec_t* codec = opj_create_compress(codec_format);
     if (!codec) {
         set_error("Failed to create OpenJPEG compressor");
-        opj_image_destroy(image);
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
     }
 
@@ -869,63 +1412,1567 @@ SHARPDICOM_API int j2k_encode(
     opj_set_info_handler(codec, opj_info_callback, NULL);
 
     /* Setup encoder */
-    if (!opj_setup_encoder(codec, &cparams, image)) {
+    if (!opj_setup_encoder(codec, cparams, image)) {
         set_error("Failed to setup encoder parameters");
         opj_destroy_codec(codec);
-        opj_image_destroy(image);
         return SHARPDICOM_ERR_INTERNAL;
     }
 
+    /* Encoder threads are a no-op on OpenJPEG versions without them */
+    if (num_threads > 1) {
+        opj_codec_set_threads(codec, (int)num_threads);
+    }
+
     /* Create memory stream for output */
-    MemoryStreamWriter writer = { output, output_len, 0 };
-    opj_stream_t* stream = create_write_stream(&writer);
+    opj_stream_t* stream = create_write_stream(writer);
     if (!stream) {
         set_error("Failed to create output stream");
         opj_destroy_codec(codec);
-        opj_image_destroy(image);
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
     }
 
     /* Encode */
+    int status = SHARPDICOM_OK;
     if (!opj_start_compress(codec, image, stream)) {
         set_error("Failed to start compression");
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        opj_image_destroy(image);
-        return SHARPDICOM_ERR_ENCODE_FAILED;
-    }
-
-    if (!opj_encode(codec, stream)) {
+        status = SHARPDICOM_ERR_ENCODE_FAILED;
+    } else if (!opj_encode(codec, stream)) {
         set_error("Failed to encode image");
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        opj_image_destroy(image);
-        return SHARPDICOM_ERR_ENCODE_FAILED;
-    }
-
-    if (!opj_end_compress(codec, stream)) {
+        status = SHARPDICOM_ERR_ENCODE_FAILED;
+    } else if (!opj_end_compress(codec, stream)) {
         set_error("Failed to finish compression");
-        opj_stream_destroy(stream);
-        opj_destroy_codec(codec);
-        opj_image_destroy(image);
-        return SHARPDICOM_ERR_ENCODE_FAILED;
+        status = SHARPDICOM_ERR_ENCODE_FAILED;
     }
 
-    /* Return size */
-    *out_size = writer.size;
-
-    /* Cleanup */
+    /* Cleanup (destroying the stream flushes it) */
     opj_stream_destroy(stream);
     opj_destroy_codec(codec);
-    opj_image_destroy(image);
-
-    return SHARPDICOM_OK;
-}
 
-SHARPDICOM_API void j2k_free(void* ptr) {
-    if (ptr) {
-        free(ptr);
+    if (status == SHARPDICOM_OK && !writer_fill_gap(writer)) {
+        status = SHARPDICOM_ERR_ENCODE_FAILED;
+    }
+    if (writer->out_of_space) {
+        status = writer_space_error(writer);
     }
+    return status;
+}
+
+/** Shared state of a tile-parallel encode */
+typedef struct {
+    const uint8_t* input;
+    int32_t width;
+    int32_t height;
+    int32_t num_components;
+    int32_t bits_per_component;
+    int32_t is_signed;
+    /** Parameters of the whole image; each tile moves the tile grid origin */
+    const opj_cparameters_t* cparams;
+    uint32_t tiles_x;
+    /** One single-tile codestream per tile */
+    J2kOutputBuffer* tiles;
+    /** Set by the first tile to fail, which then owns 'status' and 'error' */
+    volatile int32_t error_claimed;
+    int status;
+    char error[256];
+} tile_encode_context;
+
+/**
+ * Encode one tile as a codestream of its own. With the tile grid origin at
+ * the tile's corner, OpenJPEG codes the tile exactly as it would inside
+ * the full image, so the tile-parts can be spliced together afterwards.
+ */
+static void encode_tile_task(void* context, size_t index) {
+    tile_encode_context* ctx = (tile_encode_context*)context;
+    const opj_cparameters_t* base = ctx->cparams;
+
+    int32_t tx = (int32_t)(index % ctx->tiles_x);
+    int32_t ty = (int32_t)(index / ctx->tiles_x);
+    int32_t x0 = tx * base->cp_tdx;
+    int32_t y0 = ty * base->cp_tdy;
+    int32_t x1 = (x0 + base->cp_tdx < ctx->width) ? x0 + base->cp_tdx : ctx->width;
+    int32_t y1 = (y0 + base->cp_tdy < ctx->height) ? y0 + base->cp_tdy : ctx->height;
+
+    int status = SHARPDICOM_ERR_OUT_OF_MEMORY;
+    opj_image_t* image = create_encode_image(ctx->input, ctx->width, ctx->num_components,
+                                             ctx->bits_per_component, ctx->is_signed, x0, y0, x1, y1);
+    if (image) {
+        opj_cparameters_t cparams = *base;
+        cparams.cp_tx0 = x0;
+        cparams.cp_ty0 = y0;
+
+        J2kOutputBuffer* tile = &ctx->tiles[index];
+        MemoryStreamWriter writer = { NULL, 0, 0, 0, tile, 0 };
+        status = compress_image(&cparams, image, OPJ_CODEC_J2K, 1, &writer);
+        tile->size = writer.end;
+        opj_image_destroy(image);
+    }
+
+    if (status != SHARPDICOM_OK && claim_flag(&ctx->error_claimed)) {
+        /* The message is in this thread's error slot; hand it to the caller */
+        const char* message = sharpdicom_last_error();
+        strncpy(ctx->error, message ? message : "Tile encode failed", sizeof(ctx->error) - 1);
+        ctx->error[sizeof(ctx->error) - 1] = '\0';
+        ctx->status = status;
+    }
+}
+
+/**
+ * Splice single-tile codestreams into one: the first tile's main header
+ * with SIZ widened to the full image, then each tile's tile-parts with
+ * Isot set to the tile index, then EOC. The main headers of all tiles are
+ * identical apart from SIZ.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int splice_tiles(
+    J2kOutputBuffer* tiles,
+    uint32_t num_tiles,
+    int32_t width,
+    int32_t height,
+    MemoryStreamWriter* writer
+) {
+    for (uint32_t i = 0; i < num_tiles; i++) {
+        uint8_t* data = tiles[i].data;
+        size_t size = tiles[i].size;
+
+        /* SOC, SIZ and the rest of the main header up to the first SOT */
+        if (size < 2 + 40 || read_be16(data) != J2K_MARKER_SOC || read_be16(data + 2) != J2K_MARKER_SIZ ||
+            read_be16(data + size - 2) != J2K_MARKER_EOC) {
+            set_error("Unexpected codestream layout from tile encode");
+            return SHARPDICOM_ERR_INTERNAL;
+        }
+        size_t first_sot = 2;
+        while (first_sot + 4 <= size && read_be16(data + first_sot) != J2K_MARKER_SOT) {
+            first_sot += 2 + read_be16(data + first_sot + 2);
+        }
+        size_t end = size - 2;
+        if (first_sot >= end) {
+            set_error("Unexpected codestream layout from tile encode");
+            return SHARPDICOM_ERR_INTERNAL;
+        }
+
+        /* Renumber every tile-part; Psot includes the SOT marker segment */
+        for (size_t pos = first_sot; pos < end; ) {
+            uint32_t psot = (pos + 12 <= end && read_be16(data + pos) == J2K_MARKER_SOT)
+                ? read_be32(data + pos + 6) : 0;
+            if (psot < 14 || psot > end - pos) {
+                set_error("Unexpected tile-part layout from tile encode");
+                return SHARPDICOM_ERR_INTERNAL;
+            }
+            write_be16(data + pos + 4, i);
+            pos += psot;
+        }
+
+        if (i == 0) {
+            /* Xsiz, Ysiz = the full image; image and tile grid offsets = 0 */
+            write_be32(data + 8, (uint32_t)width);
+            write_be32(data + 12, (uint32_t)height);
+            write_be32(data + 16, 0);
+            write_be32(data + 20, 0);
+            write_be32(data + 32, 0);
+            write_be32(data + 36, 0);
+            if (!writer_append(writer, data, first_sot)) {
+                return writer_space_error(writer);
+            }
+        }
+        if (!writer_append(writer, data + first_sot, end - first_sot)) {
+            return writer_space_error(writer);
+        }
+    }
+
+    static const uint8_t eoc[2] = { 0xFF, 0xD9 };
+    if (!writer_append(writer, eoc, sizeof(eoc))) {
+        return writer_space_error(writer);
+    }
+    return SHARPDICOM_OK;
+}
+
+/** J2kGrowFn for the per-tile codestreams, which stay inside the library */
+static uint8_t* grow_tile_buffer(void* opaque, uint8_t* data, size_t used,
+                                 size_t min_capacity, size_t* new_capacity) {
+    (void)opaque;
+    (void)used;
+    uint8_t* grown = (uint8_t*)allocator_realloc(data, min_capacity);
+    if (grown) {
+        *new_capacity = min_capacity;
+    }
+    return grown;
+}
+
+/**
+ * Encode the tiles of an image in parallel and splice them into writer.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int encode_tiles_parallel(
+    const uint8_t* input,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const opj_cparameters_t* cparams,
+    uint32_t tiles_x,
+    uint32_t num_tiles,
+    int32_t num_threads,
+    MemoryStreamWriter* writer
+) {
+    J2kOutputBuffer* tiles = (J2kOutputBuffer*)allocator_calloc(num_tiles, sizeof(J2kOutputBuffer));
+    if (!tiles) {
+        set_error("Failed to allocate tile buffers");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    for (uint32_t i = 0; i < num_tiles; i++) {
+        tiles[i].grow = grow_tile_buffer;
+    }
+
+    tile_encode_context ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.input = input;
+    ctx.width = width;
+    ctx.height = height;
+    ctx.num_components = num_components;
+    ctx.bits_per_component = bits_per_component;
+    ctx.is_signed = is_signed;
+    ctx.cparams = cparams;
+    ctx.tiles_x = tiles_x;
+    ctx.tiles = tiles;
+
+    int status = thread_pool_parallel_for(num_tiles, num_threads, encode_tile_task, &ctx);
+    if (status == SHARPDICOM_OK && ctx.error_claimed) {
+        set_error(ctx.error);
+        status = ctx.status;
+    }
+    if (status == SHARPDICOM_OK) {
+        status = splice_tiles(tiles, num_tiles, width, height, writer);
+    }
+
+    for (uint32_t i = 0; i < num_tiles; i++) {
+        allocator_free(tiles[i].data);
+    }
+    allocator_free(tiles);
+    return status;
+}
+
+/**
+ * Encode into a writer: OpenJPH for HT, tile-parallel OpenJPEG for tiled
+ * J2K codestreams, otherwise one OpenJPEG codec. On success writer->end
+ * is the codestream length.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int encode_to_writer(
+    const uint8_t* input,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    MemoryStreamWriter* writer
+) {
+    if (!params) {
+        params = &default_encode_params;
+    }
+
+    int32_t num_res = encode_resolutions(params, width, height);
+
+    /* HT block coding is done by OpenJPH; OpenJPEG only decodes HTJ2K */
+    if (params->high_throughput) {
+#ifdef SHARPDICOM_HAS_OPENJPH
+        /* OpenJPH encodes into its own buffer; the writer grows to the final size */
+        size_t size = 0;
+        int status = htj2k_encode_ojph(input, width, height, num_components, bits_per_component,
+                                       is_signed, params, num_res, writer_output, writer, &size);
+        writer->end = (status == SHARPDICOM_OK) ? size : 0;
+        return status;
+#else
+        set_error("HTJ2K encode requires OpenJPH, which is not compiled in");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+#endif
+    }
+
+    opj_cparameters_t cparams;
+    setup_encode_parameters(&cparams, params, num_res);
+
+    int32_t num_threads = resolve_pool_threads(params->num_threads, (uint64_t)width * (uint64_t)height);
+
+    /* Tiles are independent coding units: encode them side by side */
+    if (cparams.tile_size_on && params->format != J2K_FORMAT_JP2 && num_threads > 1) {
+        uint32_t tiles_x = (uint32_t)((width + cparams.cp_tdx - 1) / cparams.cp_tdx);
+        uint32_t tiles_y = (uint32_t)((height + cparams.cp_tdy - 1) / cparams.cp_tdy);
+        uint64_t num_tiles = (uint64_t)tiles_x * tiles_y;
+        /* More tiles than SOT can index: let OpenJPEG reject the parameters */
+        if (num_tiles > 1 && num_tiles <= J2K_CS_MAX_TILES) {
+            return encode_tiles_parallel(input, width, height, num_components, bits_per_component,
+                                         is_signed, &cparams, tiles_x, (uint32_t)num_tiles,
+                                         num_threads, writer);
+        }
+    }
+
+    opj_image_t* image = create_encode_image(input, width, num_components, bits_per_component,
+                                             is_signed, 0, 0, width, height);
+    if (!image) {
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    OPJ_CODEC_FORMAT codec_format = (params->format == J2K_FORMAT_JP2) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K;
+    int status = compress_image(&cparams, image, codec_format,
+                                opj_has_thread_support() ? num_threads : 1, writer);
+    opj_image_destroy(image);
+    return status;
+}
+
+SHARPDICOM_API int j2k_encode(
+    const uint8_t* input,
+    size_t input_len,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    uint8_t* output,
+    size_t output_len,
+    size_t* out_size
+) {
+    if (!input || input_len == 0 || !output || output_len == 0 || !out_size) {
+        set_error("Invalid parameters: input, output, or out_size is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int status = validate_encode_input(input_len, width, height, num_components, bits_per_component);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    MemoryStreamWriter writer = { output, output_len, 0, 0, NULL, 0 };
+    int64_t start = codec_stats_start();
+    status = encode_to_writer(input, width, height, num_components, bits_per_component,
+                              is_signed, params, &writer);
+    codec_stats_record(SHARPDICOM_STATS_J2K, CODEC_STATS_ENCODE, start, input_len,
+                       status == SHARPDICOM_OK ? writer.end : 0, status);
+    if (status == SHARPDICOM_OK) {
+        *out_size = writer.end;
+    }
+    return status;
+}
+
+SHARPDICOM_API int j2k_encode_to_buffer(
+    const uint8_t* input,
+    size_t input_len,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    J2kOutputBuffer* output
+) {
+    if (!input || input_len == 0 || !output) {
+        set_error("Invalid parameters: input or output is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    output->size = 0;
+
+    int status = validate_encode_input(input_len, width, height, num_components, bits_per_component);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    MemoryStreamWriter writer = { output->data, output->data ? output->capacity : 0, 0, 0, output, 0 };
+    int64_t start = codec_stats_start();
+    status = encode_to_writer(input, width, height, num_components, bits_per_component,
+                              is_signed, params, &writer);
+    codec_stats_record(SHARPDICOM_STATS_J2K, CODEC_STATS_ENCODE, start, input_len,
+                       status == SHARPDICOM_OK ? writer.end : 0, status);
+    if (status == SHARPDICOM_OK) {
+        output->size = writer.end;
+    }
+    return status;
+}
+
+SHARPDICOM_API int j2k_get_encode_bound(
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    const J2kEncodeParams* params,
+    size_t* max_size
+) {
+    if (!max_size) {
+        set_error("Invalid parameters: max_size is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *max_size = 0;
+
+    int32_t bytes_per_sample = (bits_per_component <= 8) ? 1 : 2;
+    if (bits_per_component < 1 || bits_per_component > 16 || num_components < 1 || num_components > 4) {
+        set_error("Invalid components or bits_per_component");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    size_t raw = (width > 0 && height > 0) ? safe_mul4_size(
+        (size_t)width, (size_t)height, (size_t)num_components, (size_t)bytes_per_sample) : 0;
+    if (raw == 0) {
+        set_error("Invalid dimensions: width and height must be positive");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!params) {
+        params = &default_encode_params;
+    }
+    size_t num_tiles = 1;
+    if (params->tile_width > 0 && params->tile_height > 0) {
+        num_tiles = ((size_t)width + (size_t)params->tile_width - 1) / (size_t)params->tile_width *
+                    (((size_t)height + (size_t)params->tile_height - 1) / (size_t)params->tile_height);
+    }
+
+    /* Expansion of noise-like data, headers (incl. JP2 boxes), and per-tile SOT/SOD */
+    size_t bound = raw + raw / 4 + 4096 + num_tiles * 64;
+    if (bound < raw) {
+        set_error("Image too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *max_size = bound;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_decoder_create(
+    const J2kDecodeOptions* options,
+    j2k_decoder_t** decoder_out
+) {
+    if (!decoder_out) {
+        set_error("Invalid parameters: decoder_out is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *decoder_out = NULL;
+
+    j2k_decoder_t* dec = (j2k_decoder_t*)allocator_alloc(sizeof(j2k_decoder_t));
+    if (!dec) {
+        set_error("Failed to allocate decoder context");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    decoder_init(dec, options, options ? options->num_threads : 0);
+    *decoder_out = dec;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_decoder_set_input(
+    j2k_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len
+) {
+    if (!decoder || !input || input_len == 0) {
+        set_error("Invalid parameters: decoder or input is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    return decoder_attach(decoder, input, input_len);
+}
+
+SHARPDICOM_API int j2k_decoder_get_info(
+    j2k_decoder_t* decoder,
+    J2kImageInfo* info
+) {
+    if (!decoder || !info) {
+        set_error("Invalid parameters: decoder or info is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!decoder->has_info) {
+        set_error("No codestream attached to decoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *info = decoder->info;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_decoder_decode(
+    j2k_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!decoder || !output || output_len == 0) {
+        set_error("Invalid parameters: decoder or output buffer is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    J2kOutputLayout layout = interleaved_layout(output, output_len);
+    return decoder_run(decoder, &layout, NULL, out_width, out_height, out_components);
+}
+
+SHARPDICOM_API int j2k_decoder_decode_to_layout(
+    j2k_decoder_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!decoder) {
+        set_error("Invalid parameters: decoder is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int status = validate_layout(layout);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    return decoder_run(decoder, layout, NULL, out_width, out_height, out_components);
+}
+
+SHARPDICOM_API int j2k_decoder_decode_region_to_layout(
+    j2k_decoder_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!decoder) {
+        set_error("Invalid parameters: decoder is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (x0 >= x1 || y0 >= y1) {
+        set_error("Invalid region: x0 >= x1 or y0 >= y1");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int status = validate_layout(layout);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    const int32_t region[4] = { x0, y0, x1, y1 };
+    return decoder_run(decoder, layout, region, out_width, out_height, out_components);
+}
+
+SHARPDICOM_API void j2k_decoder_destroy(
+    j2k_decoder_t* decoder
+) {
+    if (!decoder) {
+        return;
+    }
+
+    decoder_release(decoder);
+    allocator_free(decoder);
+}
+
+/*============================================================================
+ * Progressive decoder
+ *
+ * Owns a growing copy of the codestream and a marker scanner that is fed
+ * each chunk once. A decode runs a one-shot decoder context over the prefix
+ * the scanner vouches for, closed off as a complete codestream: a tile-part
+ * cut short at a packet boundary gets its Psot rewritten to the received
+ * length and an EOC is written after the prefix. Both edits are undone
+ * afterwards so later chunks append to the original bytes.
+ *
+ * Only the marker scan is incremental. OpenJPEG codecs decode once, so each
+ * decode parses the main header again and re-decodes the code-blocks of
+ * every resolution it outputs.
+ *============================================================================*/
+
+/** Initial buffer size; grows by doubling */
+#define J2K_PROGRESSIVE_MIN_CAPACITY (64 * 1024)
+
+struct j2k_progressive {
+    /** Decode options fixed at creation */
+    J2kDecodeOptions options;
+    int32_t num_threads;
+    /** Received codestream, with room for the 2-byte EOC after any prefix */
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    j2k_cs_scanner_t* scanner;
+    J2kCsProgress progress;
+    /** Header information for get_info, read when header_ready */
+    J2kImageInfo info;
+    int has_info;
+    /** Image area on the reference grid, for reduced output sizes */
+    uint32_t x0, y0, x1, y1;
+};
+
+/** Size of [x0, x1) after `reduce` halvings (B.5: ceil(x / 2^reduce)) */
+static int32_t reduced_extent(uint32_t x0, uint32_t x1, int32_t reduce) {
+    uint64_t scale = (uint64_t)1 << reduce;
+    return (int32_t)(((uint64_t)x1 + scale - 1) / scale - ((uint64_t)x0 + scale - 1) / scale);
+}
+
+/** Parse the main header with OpenJPEG once the scanner has seen all of it */
+static int progressive_read_header(struct j2k_progressive* prog) {
+    struct j2k_decoder dec;
+    decoder_init(&dec, NULL, 1);
+
+    int status = decoder_attach(&dec, prog->data, prog->size);
+    if (status == SHARPDICOM_OK) {
+        prog->info = dec.info;
+        prog->x0 = dec.image->x0;
+        prog->y0 = dec.image->y0;
+        prog->x1 = dec.image->x1;
+        prog->y1 = dec.image->y1;
+        prog->has_info = 1;
+    }
+
+    decoder_release(&dec);
+    return status;
+}
+
+static void progressive_fill_status(const struct j2k_progressive* prog, int improved,
+                                    J2kProgressiveStatus* status) {
+    memset(status, 0, sizeof(*status));
+    status->header_ready = prog->has_info;
+    status->resolutions = prog->progress.resolutions;
+    status->quality_layers = prog->progress.layers;
+    status->improved = improved;
+    status->complete = prog->progress.complete;
+    status->bytes_received = prog->size;
+    if (prog->has_info && prog->progress.resolutions > 0) {
+        int32_t reduce = prog->progress.num_resolutions - prog->progress.resolutions;
+        status->width = reduced_extent(prog->x0, prog->x1, reduce);
+        status->height = reduced_extent(prog->y0, prog->y1, reduce);
+    }
+}
+
+SHARPDICOM_API int j2k_progressive_create(
+    const J2kDecodeOptions* options,
+    j2k_progressive_t** decoder_out
+) {
+    if (!decoder_out) {
+        set_error("Invalid parameters: decoder_out is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *decoder_out = NULL;
+
+    j2k_progressive_t* prog = (j2k_progressive_t*)allocator_calloc(1, sizeof(j2k_progressive_t));
+    if (!prog) {
+        set_error("Failed to allocate progressive decoder");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    int status = j2k_cs_scanner_create(&prog->scanner);
+    if (status != SHARPDICOM_OK) {
+        allocator_free(prog);
+        return status;
+    }
+
+    if (options) {
+        prog->options = *options;
+        j2k_cs_scanner_set_limits(prog->scanner, options->reduce, options->max_quality_layers);
+    }
+    prog->num_threads = options ? options->num_threads : 0;
+
+    *decoder_out = prog;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_progressive_push(
+    j2k_progressive_t* decoder,
+    const uint8_t* data,
+    size_t data_len,
+    J2kProgressiveStatus* status
+) {
+    if (!decoder || (!data && data_len > 0)) {
+        set_error("Invalid parameters: decoder or data is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Keep two spare bytes past the data for the EOC written at decode time */
+    if (data_len > SIZE_MAX - decoder->size - 2) {
+        set_error("Codestream too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    size_t needed = decoder->size + data_len + 2;
+    if (needed > decoder->capacity) {
+        size_t capacity = decoder->capacity ? decoder->capacity : J2K_PROGRESSIVE_MIN_CAPACITY;
+        while (capacity < needed) {
+            capacity = (capacity > SIZE_MAX / 2) ? needed : capacity * 2;
+        }
+        uint8_t* grown = (uint8_t*)allocator_realloc(decoder->data, capacity);
+        if (!grown) {
+            set_error("Failed to grow progressive decoder buffer");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        decoder->data = grown;
+        decoder->capacity = capacity;
+    }
+    if (data_len > 0) {
+        memcpy(decoder->data + decoder->size, data, data_len);
+        decoder->size += data_len;
+    }
+
+    /* Tell a JP2 file apart from a corrupt codestream, which takes 12 bytes */
+    J2kCsProgress previous = decoder->progress;
+    if (decoder->size >= 2 && (decoder->data[0] != 0xFF || decoder->data[1] != 0x4F)) {
+        if (decoder->size < 12) {
+            if (status) {
+                progressive_fill_status(decoder, 0, status);
+            }
+            return SHARPDICOM_OK;
+        }
+        if (detect_format(decoder->data, decoder->size) == J2K_FORMAT_JP2) {
+            set_error("Progressive decode takes raw J2K codestreams, not JP2 files");
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+    }
+
+    int result = j2k_cs_scanner_update(decoder->scanner, decoder->data, decoder->size,
+                                       &decoder->progress);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    if (decoder->progress.header_ready && !decoder->has_info) {
+        result = progressive_read_header(decoder);
+        if (result != SHARPDICOM_OK) {
+            return result;
+        }
+    }
+
+    if (status) {
+        int improved = decoder->progress.resolutions != previous.resolutions ||
+                       decoder->progress.layers != previous.layers;
+        progressive_fill_status(decoder, improved, status);
+    }
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_progressive_get_info(
+    j2k_progressive_t* decoder,
+    J2kImageInfo* info
+) {
+    if (!decoder || !info) {
+        set_error("Invalid parameters: decoder or info is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (!decoder->has_info) {
+        set_error("JPEG 2000 main header has not arrived yet");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *info = decoder->info;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_progressive_decode(
+    j2k_progressive_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!decoder) {
+        set_error("Invalid parameters: decoder is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    int status = validate_layout(layout);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    const J2kCsProgress* progress = &decoder->progress;
+    if (!decoder->has_info || progress->resolutions == 0) {
+        set_error("No resolution level of the codestream has arrived yet");
+        return SHARPDICOM_ERR_DECODE_FAILED;
+    }
+
+    /* Decode exactly the level the received packets cover */
+    J2kDecodeOptions options = decoder->options;
+    options.reduce = progress->num_resolutions - progress->resolutions;
+    options.max_quality_layers = (progress->layers < progress->num_layers) ? progress->layers : 0;
+
+    /* Close the prefix off as a complete codestream */
+    size_t end = progress->decodable_end;
+    size_t cut_sot = progress->cut_sot;
+    uint8_t saved_tail[2];
+    uint8_t saved_psot[4] = { 0 };
+    memcpy(saved_tail, decoder->data + end, sizeof(saved_tail));
+    if (cut_sot) {
+        uint8_t* psot = decoder->data + cut_sot + 6;
+        size_t part_len = end - cut_sot;
+        memcpy(saved_psot, psot, sizeof(saved_psot));
+        psot[0] = (uint8_t)(part_len >> 24);
+        psot[1] = (uint8_t)(part_len >> 16);
+        psot[2] = (uint8_t)(part_len >> 8);
+        psot[3] = (uint8_t)part_len;
+    }
+    decoder->data[end] = 0xFF;
+    decoder->data[end + 1] = 0xD9;
+
+    struct j2k_decoder dec;
+    decoder_init(&dec, &options, decoder->num_threads);
+    status = decoder_attach(&dec, decoder->data, end + 2);
+    if (status == SHARPDICOM_OK) {
+        status = decoder_run(&dec, layout, NULL, out_width, out_height, out_components);
+    }
+    decoder_release(&dec);
+
+    memcpy(decoder->data + end, saved_tail, sizeof(saved_tail));
+    if (cut_sot) {
+        memcpy(decoder->data + cut_sot + 6, saved_psot, sizeof(saved_psot));
+    }
+    return status;
+}
+
+SHARPDICOM_API int j2k_progressive_reset(
+    j2k_progressive_t* decoder
+) {
+    if (!decoder) {
+        set_error("Invalid parameters: decoder is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    decoder->size = 0;
+    decoder->has_info = 0;
+    memset(&decoder->progress, 0, sizeof(decoder->progress));
+    j2k_cs_scanner_reset(decoder->scanner);
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API void j2k_progressive_destroy(
+    j2k_progressive_t* decoder
+) {
+    if (!decoder) {
+        return;
+    }
+
+    j2k_cs_scanner_destroy(decoder->scanner);
+    allocator_free(decoder->data);
+    allocator_free(decoder);
+}
+
+/*============================================================================
+ * Decoded-tile cache
+ *
+ * A region request parses the main header, looks up every tile the region
+ * overlaps, decodes only the missing ones with opj_get_decoded_tile() on
+ * that one codec and assembles the output from cached tiles. Tiles are kept
+ * as interleaved output samples in a hash table threaded onto an LRU list.
+ * Entries a request is reading are pinned: eviction skips them, and an entry
+ * dropped by evict/clear while pinned is freed by its last reader.
+ *============================================================================*/
+
+#if defined(_WIN32) || defined(_WIN64)
+typedef CRITICAL_SECTION tile_cache_mutex_t;
+static int mutex_init(tile_cache_mutex_t* m) { InitializeCriticalSection(m); return 0; }
+static void mutex_destroy(tile_cache_mutex_t* m) { DeleteCriticalSection(m); }
+static void mutex_lock(tile_cache_mutex_t* m) { EnterCriticalSection(m); }
+static void mutex_unlock(tile_cache_mutex_t* m) { LeaveCriticalSection(m); }
+#else
+typedef pthread_mutex_t tile_cache_mutex_t;
+static int mutex_init(tile_cache_mutex_t* m) { return pthread_mutex_init(m, NULL); }
+static void mutex_destroy(tile_cache_mutex_t* m) { pthread_mutex_destroy(m); }
+static void mutex_lock(tile_cache_mutex_t* m) { pthread_mutex_lock(m); }
+static void mutex_unlock(tile_cache_mutex_t* m) { pthread_mutex_unlock(m); }
+#endif
+
+/** Initial hash bucket count (power of two); doubles with the tile count */
+#define J2K_TILE_CACHE_MIN_BUCKETS 256
+
+/** Identifies one decoded form of a codestream */
+struct tile_key {
+    uint64_t codestream_id;
+    int32_t reduce;
+    /** 0 = all layers */
+    int32_t max_layers;
+};
+
+struct j2k_tile_entry {
+    struct tile_key key;
+    uint32_t tile_index;
+    /** Tile area at the decoded resolution */
+    uint32_t x0, y0, width, height;
+    /** Interleaved output samples, width * components * bytes_per_sample per row */
+    uint8_t* samples;
+    /** Bytes charged against the budget */
+    size_t cost;
+    /** Requests currently reading samples */
+    int32_t pins;
+    /** Cleared when dropped from the table while pinned */
+    int in_table;
+    struct j2k_tile_entry* hash_next;
+    /** Towards the most / least recently used entry */
+    struct j2k_tile_entry* lru_prev;
+    struct j2k_tile_entry* lru_next;
+};
+
+struct j2k_tile_cache {
+    tile_cache_mutex_t lock;
+    struct j2k_tile_entry** buckets;
+    size_t num_buckets;
+    struct j2k_tile_entry* lru_head;
+    struct j2k_tile_entry* lru_tail;
+    /** Counters, budget and occupancy; guarded by lock */
+    J2kTileCacheStats stats;
+};
+
+/** One tile a region request covers */
+struct tile_slot {
+    uint32_t tile_index;
+    /** Tile area at the decoded resolution */
+    uint32_t x0, y0, x1, y1;
+    /** Pinned cache entry, NULL until cached or decoded */
+    struct j2k_tile_entry* entry;
+};
+
+/** Output geometry of a region request at the decoded resolution */
+struct tile_region {
+    uint32_t x0, y0, x1, y1;
+    uint32_t num_comps;
+    size_t bytes_per_sample;
+};
+
+/** ceil(v / 2^r) */
+static uint32_t ceil_div_pow2(uint64_t v, int32_t r) {
+    return (uint32_t)((v + ((uint64_t)1 << r) - 1) >> r);
+}
+
+/** splitmix64 finaliser */
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static size_t tile_hash(const struct tile_key* key, uint32_t tile_index) {
+    uint64_t h = mix64(key->codestream_id);
+    h = mix64(h ^ tile_index);
+    h = mix64(h ^ (((uint64_t)(uint32_t)key->reduce << 32) | (uint32_t)key->max_layers));
+    return (size_t)h;
+}
+
+static int tile_key_equal(const struct tile_key* a, const struct tile_key* b) {
+    return a->codestream_id == b->codestream_id && a->reduce == b->reduce &&
+           a->max_layers == b->max_layers;
+}
+
+static void tile_entry_free(struct j2k_tile_entry* entry) {
+    allocator_free(entry->samples);
+    allocator_free(entry);
+}
+
+/* The helpers below expect the cache lock to be held */
+
+static void lru_unlink(struct j2k_tile_cache* cache, struct j2k_tile_entry* entry) {
+    if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+    else cache->lru_head = entry->lru_next;
+    if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+    else cache->lru_tail = entry->lru_prev;
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void lru_push_front(struct j2k_tile_cache* cache, struct j2k_tile_entry* entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) cache->lru_head->lru_prev = entry;
+    else cache->lru_tail = entry;
+    cache->lru_head = entry;
+}
+
+static struct j2k_tile_entry* tile_cache_find(
+    struct j2k_tile_cache* cache, const struct tile_key* key, uint32_t tile_index
+) {
+    struct j2k_tile_entry* entry = cache->buckets[tile_hash(key, tile_index) & (cache->num_buckets - 1)];
+    while (entry && (entry->tile_index != tile_index || !tile_key_equal(&entry->key, key))) {
+        entry = entry->hash_next;
+    }
+    return entry;
+}
+
+/** Pin an entry for the caller and mark it most recently used */
+static void tile_cache_pin(struct j2k_tile_cache* cache, struct j2k_tile_entry* entry) {
+    entry->pins++;
+    lru_unlink(cache, entry);
+    lru_push_front(cache, entry);
+}
+
+/** Double the bucket count; on allocation failure chains just get longer */
+static void tile_cache_grow(struct j2k_tile_cache* cache) {
+    size_t count = cache->num_buckets * 2;
+    struct j2k_tile_entry** buckets = (struct j2k_tile_entry**)allocator_calloc(count, sizeof(*buckets));
+    if (!buckets) {
+        return;
+    }
+    for (size_t i = 0; i < cache->num_buckets; i++) {
+        struct j2k_tile_entry* entry = cache->buckets[i];
+        while (entry) {
+            struct j2k_tile_entry* next = entry->hash_next;
+            size_t b = tile_hash(&entry->key, entry->tile_index) & (count - 1);
+            entry->hash_next = buckets[b];
+            buckets[b] = entry;
+            entry = next;
+        }
+    }
+    allocator_free(cache->buckets);
+    cache->buckets = buckets;
+    cache->num_buckets = count;
+}
+
+static void tile_cache_insert(struct j2k_tile_cache* cache, struct j2k_tile_entry* entry) {
+    if (cache->stats.num_tiles >= cache->num_buckets) {
+        tile_cache_grow(cache);
+    }
+    size_t b = tile_hash(&entry->key, entry->tile_index) & (cache->num_buckets - 1);
+    entry->hash_next = cache->buckets[b];
+    cache->buckets[b] = entry;
+    entry->in_table = 1;
+    lru_push_front(cache, entry);
+    cache->stats.bytes_used += entry->cost;
+    cache->stats.num_tiles++;
+}
+
+/** Drop an entry from the table; it is freed now or by its last reader */
+static void tile_cache_remove(struct j2k_tile_cache* cache, struct j2k_tile_entry* entry) {
+    struct j2k_tile_entry** link =
+        &cache->buckets[tile_hash(&entry->key, entry->tile_index) & (cache->num_buckets - 1)];
+    while (*link != entry) {
+        link = &(*link)->hash_next;
+    }
+    *link = entry->hash_next;
+    lru_unlink(cache, entry);
+    cache->stats.bytes_used -= entry->cost;
+    cache->stats.num_tiles--;
+    entry->in_table = 0;
+    if (entry->pins == 0) {
+        tile_entry_free(entry);
+    }
+}
+
+static void tile_cache_unpin(struct j2k_tile_entry* entry) {
+    if (--entry->pins == 0 && !entry->in_table) {
+        tile_entry_free(entry);
+    }
+}
+
+/** Evict unpinned entries, least recently used first, until within budget */
+static void tile_cache_trim(struct j2k_tile_cache* cache) {
+    struct j2k_tile_entry* entry = cache->lru_tail;
+    while (entry && cache->stats.bytes_used > cache->stats.byte_budget) {
+        struct j2k_tile_entry* prev = entry->lru_prev;
+        if (entry->pins == 0) {
+            tile_cache_remove(cache, entry);
+            cache->stats.evictions++;
+        }
+        entry = prev;
+    }
+}
+
+/**
+ * Work out the output geometry of a region and the tiles it overlaps.
+ * The region is clipped to the image on the right and bottom; tiles that
+ * vanish at the decoded resolution are left out.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int tile_region_plan(
+    struct j2k_decoder* dec,
+    const int32_t* region,
+    int32_t reduce,
+    struct tile_region* out,
+    struct tile_slot** slots_out,
+    size_t* count_out
+) {
+    const opj_image_t* image = dec->image;
+
+    if (image->numcomps == 0) {
+        set_error("JPEG 2000 image has no components");
+        return SHARPDICOM_ERR_DECODE_FAILED;
+    }
+    for (OPJ_UINT32 c = 0; c < image->numcomps; c++) {
+        if (image->comps[c].dx != 1 || image->comps[c].dy != 1) {
+            set_error("Subsampled JPEG 2000 components are not supported");
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+    }
+    if ((int64_t)region[0] < (int64_t)image->x0 || (int64_t)region[1] < (int64_t)image->y0 ||
+        (int64_t)region[0] >= (int64_t)image->x1 || (int64_t)region[1] >= (int64_t)image->y1) {
+        set_error("Invalid region: outside the image");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    uint32_t x0 = (uint32_t)region[0];
+    uint32_t y0 = (uint32_t)region[1];
+    uint32_t x1 = ((uint32_t)region[2] < image->x1) ? (uint32_t)region[2] : image->x1;
+    uint32_t y1 = ((uint32_t)region[3] < image->y1) ? (uint32_t)region[3] : image->y1;
+
+    out->x0 = ceil_div_pow2(x0, reduce);
+    out->y0 = ceil_div_pow2(y0, reduce);
+    out->x1 = ceil_div_pow2(x1, reduce);
+    out->y1 = ceil_div_pow2(y1, reduce);
+    out->num_comps = image->numcomps;
+    out->bytes_per_sample = (image->comps[0].prec <= 8) ? 1 : 2;
+    if (out->x0 >= out->x1 || out->y0 >= out->y1) {
+        set_error("Invalid region: empty at the requested reduce level");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Tile grid (A.5.1) */
+    opj_codestream_info_v2_t* cs_info = opj_get_cstr_info(dec->codec);
+    if (!cs_info) {
+        set_error("Failed to read JPEG 2000 tile layout");
+        return SHARPDICOM_ERR_DECODE_FAILED;
+    }
+    uint64_t tx0 = cs_info->tx0, ty0 = cs_info->ty0;
+    uint64_t tdx = cs_info->tdx, tdy = cs_info->tdy;
+    uint32_t tw = cs_info->tw, th = cs_info->th;
+    opj_destroy_cstr_info(&cs_info);
+    if (tdx == 0 || tdy == 0 || tw == 0 || th == 0 || tx0 > x0 || ty0 > y0) {
+        set_error("Invalid JPEG 2000 tile layout");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+
+    uint32_t p0 = (uint32_t)((x0 - tx0) / tdx);
+    uint32_t q0 = (uint32_t)((y0 - ty0) / tdy);
+    uint32_t p1 = (uint32_t)((x1 - 1 - tx0) / tdx);
+    uint32_t q1 = (uint32_t)((y1 - 1 - ty0) / tdy);
+    if (p1 >= tw) p1 = tw - 1;
+    if (q1 >= th) q1 = th - 1;
+
+    size_t max_slots = safe_mul_size((size_t)(p1 - p0) + 1, (size_t)(q1 - q0) + 1);
+    struct tile_slot* slots = (struct tile_slot*)allocator_calloc(max_slots, sizeof(*slots));
+    if (!slots) {
+        set_error("Failed to allocate tile table");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    size_t count = 0;
+    for (uint32_t q = q0; q <= q1; q++) {
+        uint64_t a = ty0 + q * tdy;
+        uint64_t b = a + tdy;
+        uint32_t ty_lo = ceil_div_pow2(a > image->y0 ? a : image->y0, reduce);
+        uint32_t ty_hi = ceil_div_pow2(b < image->y1 ? b : image->y1, reduce);
+        if (ty_lo >= ty_hi || ty_hi <= out->y0 || ty_lo >= out->y1) continue;
+
+        for (uint32_t p = p0; p <= p1; p++) {
+            a = tx0 + p * tdx;
+            b = a + tdx;
+            uint32_t tx_lo = ceil_div_pow2(a > image->x0 ? a : image->x0, reduce);
+            uint32_t tx_hi = ceil_div_pow2(b < image->x1 ? b : image->x1, reduce);
+            if (tx_lo >= tx_hi || tx_hi <= out->x0 || tx_lo >= out->x1) continue;
+
+            struct tile_slot* slot = &slots[count++];
+            slot->tile_index = q * tw + p;
+            slot->x0 = tx_lo;
+            slot->y0 = ty_lo;
+            slot->x1 = tx_hi;
+            slot->y1 = ty_hi;
+        }
+    }
+
+    *slots_out = slots;
+    *count_out = count;
+    return SHARPDICOM_OK;
+}
+
+/** Pin the cached tiles of a request and count the rest as misses */
+static void tile_cache_acquire(
+    struct j2k_tile_cache* cache,
+    const struct tile_key* key,
+    struct tile_slot* slots,
+    size_t count
+) {
+    mutex_lock(&cache->lock);
+    for (size_t i = 0; i < count; i++) {
+        struct j2k_tile_entry* entry = tile_cache_find(cache, key, slots[i].tile_index);
+        if (entry) {
+            tile_cache_pin(cache, entry);
+            slots[i].entry = entry;
+            cache->stats.hits++;
+        } else {
+            cache->stats.misses++;
+        }
+    }
+    mutex_unlock(&cache->lock);
+}
+
+/**
+ * Decode the tiles of a request that were not cached and add them to the
+ * cache pinned. The lock is not held while decoding; if another request
+ * adds the same tile meanwhile its entry is used instead.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int tile_cache_fill(
+    struct j2k_tile_cache* cache,
+    struct j2k_decoder* dec,
+    const struct tile_key* key,
+    const struct tile_region* region,
+    struct tile_slot* slots,
+    size_t count
+) {
+    opj_image_t* image = dec->image;
+
+    for (size_t i = 0; i < count; i++) {
+        struct tile_slot* slot = &slots[i];
+        if (slot->entry) {
+            continue;
+        }
+
+        if (!opj_get_decoded_tile(dec->codec, dec->stream, image, slot->tile_index)) {
+            set_error_fmt("Failed to decode JPEG 2000 tile %u", (unsigned)slot->tile_index);
+            return SHARPDICOM_ERR_DECODE_FAILED;
+        }
+        if (image->numcomps != region->num_comps) {
+            set_error("JP2 palette or channel mapping is not supported for cached decoding");
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+        uint32_t width = slot->x1 - slot->x0;
+        uint32_t height = slot->y1 - slot->y0;
+        if (image->comps[0].w != width || image->comps[0].h != height) {
+            set_error_fmt("Decoded tile %u does not match the tile grid", (unsigned)slot->tile_index);
+            return SHARPDICOM_ERR_DECODE_FAILED;
+        }
+
+        size_t bytes = safe_mul4_size(width, height, region->num_comps, region->bytes_per_sample);
+        struct j2k_tile_entry* entry = (struct j2k_tile_entry*)allocator_calloc(1, sizeof(*entry));
+        if (entry && bytes) {
+            entry->samples = (uint8_t*)allocator_alloc(bytes);
+        }
+        if (!entry || !entry->samples) {
+            allocator_free(entry);
+            set_error("Failed to allocate tile cache entry");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        entry->key = *key;
+        entry->tile_index = slot->tile_index;
+        entry->x0 = slot->x0;
+        entry->y0 = slot->y0;
+        entry->width = width;
+        entry->height = height;
+        entry->cost = bytes + sizeof(*entry);
+
+        J2kOutputLayout tile_layout = interleaved_layout(entry->samples, bytes);
+        int status = write_to_layout(image, &tile_layout, NULL);
+        if (status != SHARPDICOM_OK) {
+            tile_entry_free(entry);
+            return status;
+        }
+
+        mutex_lock(&cache->lock);
+        struct j2k_tile_entry* existing = tile_cache_find(cache, key, slot->tile_index);
+        if (existing) {
+            tile_cache_pin(cache, existing);
+            slot->entry = existing;
+        } else {
+            entry->pins = 1;
+            tile_cache_insert(cache, entry);
+            slot->entry = entry;
+            tile_cache_trim(cache);
+        }
+        mutex_unlock(&cache->lock);
+
+        if (existing) {
+            tile_entry_free(entry);
+        }
+    }
+    return SHARPDICOM_OK;
+}
+
+/** Copy the overlap of every tile with the region into the resolved destinations */
+static void tile_region_compose(
+    const struct tile_region* region,
+    const struct tile_slot* slots,
+    size_t count,
+    int planar,
+    uint8_t* const* dst,
+    size_t stride
+) {
+    size_t bps = region->bytes_per_sample;
+    size_t pixel = (size_t)region->num_comps * bps;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct j2k_tile_entry* entry = slots[i].entry;
+        uint32_t ix0 = (entry->x0 > region->x0) ? entry->x0 : region->x0;
+        uint32_t iy0 = (entry->y0 > region->y0) ? entry->y0 : region->y0;
+        uint32_t ix1 = (entry->x0 + entry->width < region->x1) ? entry->x0 + entry->width : region->x1;
+        uint32_t iy1 = (entry->y0 + entry->height < region->y1) ? entry->y0 + entry->height : region->y1;
+        size_t span = (size_t)(ix1 - ix0);
+        size_t tile_row = (size_t)entry->width * pixel;
+
+        for (uint32_t y = iy0; y < iy1; y++) {
+            const uint8_t* src = entry->samples + (size_t)(y - entry->y0) * tile_row +
+                                 (size_t)(ix0 - entry->x0) * pixel;
+            size_t dst_row = (size_t)(y - region->y0) * stride;
+
+            if (!planar) {
+                memcpy(dst[0] + dst_row + (size_t)(ix0 - region->x0) * pixel, src, span * pixel);
+                continue;
+            }
+            for (uint32_t c = 0; c < region->num_comps; c++) {
+                uint8_t* out = dst[c] + dst_row + (size_t)(ix0 - region->x0) * bps;
+                const uint8_t* in = src + (size_t)c * bps;
+                if (bps == 1) {
+                    for (size_t x = 0; x < span; x++) {
+                        out[x] = in[x * pixel];
+                    }
+                } else {
+                    for (size_t x = 0; x < span; x++) {
+                        memcpy(out + x * 2, in + x * pixel, 2);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/** Unpin the tiles of a request and bring the cache back within budget */
+static void tile_cache_release(struct j2k_tile_cache* cache, struct tile_slot* slots, size_t count) {
+    mutex_lock(&cache->lock);
+    for (size_t i = 0; i < count; i++) {
+        if (slots[i].entry) {
+            tile_cache_unpin(slots[i].entry);
+        }
+    }
+    tile_cache_trim(cache);
+    mutex_unlock(&cache->lock);
+}
+
+SHARPDICOM_API int j2k_tile_cache_create(
+    size_t byte_budget,
+    j2k_tile_cache_t** cache_out
+) {
+    if (!cache_out || byte_budget == 0) {
+        set_error("Invalid parameters: cache_out is NULL or byte_budget is 0");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    *cache_out = NULL;
+
+    j2k_tile_cache_t* cache = (j2k_tile_cache_t*)allocator_calloc(1, sizeof(*cache));
+    if (cache) {
+        cache->num_buckets = J2K_TILE_CACHE_MIN_BUCKETS;
+        cache->buckets = (struct j2k_tile_entry**)allocator_calloc(cache->num_buckets, sizeof(*cache->buckets));
+    }
+    if (!cache || !cache->buckets) {
+        allocator_free(cache);
+        set_error("Failed to allocate tile cache");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    if (mutex_init(&cache->lock) != 0) {
+        allocator_free(cache->buckets);
+        allocator_free(cache);
+        set_error("Failed to initialize tile cache lock");
+        return SHARPDICOM_ERR_INTERNAL;
+    }
+    cache->stats.byte_budget = byte_budget;
+
+    *cache_out = cache;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_decode_region_cached(
+    j2k_tile_cache_t* cache,
+    uint64_t codestream_id,
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    if (!cache || codestream_id == 0) {
+        set_error("Invalid parameters: cache is NULL or codestream_id is 0");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (!input || input_len == 0) {
+        set_error("Invalid parameters: input buffer is NULL/zero");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (x0 >= x1 || y0 >= y1) {
+        set_error("Invalid region: x0 >= x1 or y0 >= y1");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int status = validate_layout(layout);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    if (options && options->display) {
+        set_error("Display output is not supported for cached tile decodes");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    struct tile_key key;
+    key.codestream_id = codestream_id;
+    key.reduce = options ? options->reduce : 0;
+    key.max_layers = (options && options->max_quality_layers > 0) ? options->max_quality_layers : 0;
+    if (key.reduce < 0 || key.reduce >= OPJ_J2K_MAXRLVLS) {
+        set_error("Invalid reduce level");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    struct j2k_decoder dec;
+    decoder_init(&dec, options, options ? options->num_threads : 0);
+    status = decoder_attach(&dec, input, input_len);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    /* Asking for every coded layer decodes the same tiles as asking for all */
+    if (key.max_layers >= dec.info.num_quality_layers) {
+        key.max_layers = 0;
+    }
+
+    const int32_t coords[4] = { x0, y0, x1, y1 };
+    struct tile_region region;
+    struct tile_slot* slots = NULL;
+    size_t count = 0;
+    uint8_t* dst[J2K_MAX_PLANES];
+    size_t stride = 0;
+
+    status = tile_region_plan(&dec, coords, key.reduce, &region, &slots, &count);
+    if (status == SHARPDICOM_OK) {
+        /* Validate the destination before decoding anything */
+        status = resolve_layout(layout, region.x1 - region.x0, region.y1 - region.y0,
+                                region.num_comps, region.bytes_per_sample, dst, &stride);
+    }
+    if (status == SHARPDICOM_OK) {
+        tile_cache_acquire(cache, &key, slots, count);
+        status = tile_cache_fill(cache, &dec, &key, &region, slots, count);
+    }
+    if (status == SHARPDICOM_OK) {
+        tile_region_compose(&region, slots, count, layout->mode == J2K_LAYOUT_PLANAR, dst, stride);
+    }
+    if (slots) {
+        tile_cache_release(cache, slots, count);
+        allocator_free(slots);
+    }
+    decoder_release(&dec);
+
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    if (out_width) *out_width = (int32_t)(region.x1 - region.x0);
+    if (out_height) *out_height = (int32_t)(region.y1 - region.y0);
+    if (out_components) *out_components = (int32_t)region.num_comps;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_tile_cache_evict(
+    j2k_tile_cache_t* cache,
+    uint64_t codestream_id
+) {
+    if (!cache) {
+        set_error("Invalid parameters: cache is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    mutex_lock(&cache->lock);
+    struct j2k_tile_entry* entry = cache->lru_head;
+    while (entry) {
+        struct j2k_tile_entry* next = entry->lru_next;
+        if (entry->key.codestream_id == codestream_id) {
+            tile_cache_remove(cache, entry);
+        }
+        entry = next;
+    }
+    mutex_unlock(&cache->lock);
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_tile_cache_clear(
+    j2k_tile_cache_t* cache
+) {
+    if (!cache) {
+        set_error("Invalid parameters: cache is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    mutex_lock(&cache->lock);
+    while (cache->lru_head) {
+        tile_cache_remove(cache, cache->lru_head);
+    }
+    mutex_unlock(&cache->lock);
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int j2k_tile_cache_get_stats(
+    j2k_tile_cache_t* cache,
+    J2kTileCacheStats* stats
+) {
+    if (!cache || !stats) {
+        set_error("Invalid parameters: cache or stats is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    mutex_unlock(&cache->lock);
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API void j2k_tile_cache_destroy(
+    j2k_tile_cache_t* cache
+) {
+    if (!cache) {
+        return;
+    }
+
+    struct j2k_tile_entry* entry = cache->lru_head;
+    while (entry) {
+        struct j2k_tile_entry* next = entry->lru_next;
+        tile_entry_free(entry);
+        entry = next;
+    }
+    mutex_destroy(&cache->lock);
+    allocator_free(cache->buckets);
+    allocator_free(cache);
+}
+
+SHARPDICOM_API int j2k_set_default_threads(int32_t num_threads) {
+    if (num_threads < 0) {
+        set_error("Invalid thread count: must be >= 0");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    g_default_threads = (num_threads > J2K_MAX_THREADS) ? J2K_MAX_THREADS : num_threads;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int32_t j2k_get_default_threads(void) {
+    return resolve_threads(0, J2K_AUTO_THREADS_MIN_PIXELS);
+}
+
+SHARPDICOM_API void j2k_free(void* ptr) {
+    if (ptr) {
+        free(ptr);
+    }
+}
+
+SHARPDICOM_API int32_t j2k_htj2k_support(void) {
+    int32_t support = 0;
+
+    /* OpenJPEG decodes HT code-blocks (ht_dec.c) from 2.5.0 on */
+    int major = 0;
+    int minor = 0;
+    if (sscanf(opj_version(), "%d.%d", &major, &minor) == 2 &&
+        (major > 2 || (major == 2 && minor >= 5))) {
+        support |= J2K_HTJ2K_DECODE;
+    }
+
+#ifdef SHARPDICOM_HAS_OPENJPH
+    support |= J2K_HTJ2K_ENCODE;
+#endif
+
+    return support;
 }
 
 SHARPDICOM_API const char* j2k_version(void) {
@@ -1004,6 +3051,54 @@ SHARPDICOM_API int j2k_decode_region(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+SHARPDICOM_API int j2k_decode_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)input;
+    (void)input_len;
+    (void)layout;
+    (void)options;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decode_region_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)input;
+    (void)input_len;
+    (void)layout;
+    (void)x0;
+    (void)y0;
+    (void)x1;
+    (void)y1;
+    (void)options;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
 SHARPDICOM_API int j2k_encode(
     const uint8_t* input,
     size_t input_len,
@@ -1032,12 +3127,304 @@ SHARPDICOM_API int j2k_encode(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+SHARPDICOM_API int j2k_encode_to_buffer(
+    const uint8_t* input,
+    size_t input_len,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    J2kOutputBuffer* output
+) {
+    (void)input;
+    (void)input_len;
+    (void)width;
+    (void)height;
+    (void)num_components;
+    (void)bits_per_component;
+    (void)is_signed;
+    (void)params;
+    if (output) output->size = 0;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_get_encode_bound(
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    const J2kEncodeParams* params,
+    size_t* max_size
+) {
+    (void)width;
+    (void)height;
+    (void)num_components;
+    (void)bits_per_component;
+    (void)params;
+    if (max_size) *max_size = 0;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decoder_create(
+    const J2kDecodeOptions* options,
+    j2k_decoder_t** decoder_out
+) {
+    (void)options;
+    if (decoder_out) *decoder_out = NULL;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decoder_set_input(
+    j2k_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len
+) {
+    (void)decoder;
+    (void)input;
+    (void)input_len;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decoder_get_info(
+    j2k_decoder_t* decoder,
+    J2kImageInfo* info
+) {
+    (void)decoder;
+    (void)info;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decoder_decode(
+    j2k_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)decoder;
+    (void)output;
+    (void)output_len;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decoder_decode_to_layout(
+    j2k_decoder_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)decoder;
+    (void)layout;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decoder_decode_region_to_layout(
+    j2k_decoder_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)decoder;
+    (void)layout;
+    (void)x0;
+    (void)y0;
+    (void)x1;
+    (void)y1;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void j2k_decoder_destroy(
+    j2k_decoder_t* decoder
+) {
+    (void)decoder;
+}
+
+SHARPDICOM_API int j2k_progressive_create(
+    const J2kDecodeOptions* options,
+    j2k_progressive_t** decoder_out
+) {
+    (void)options;
+    if (decoder_out) *decoder_out = NULL;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_progressive_push(
+    j2k_progressive_t* decoder,
+    const uint8_t* data,
+    size_t data_len,
+    J2kProgressiveStatus* status
+) {
+    (void)decoder;
+    (void)data;
+    (void)data_len;
+    (void)status;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_progressive_get_info(
+    j2k_progressive_t* decoder,
+    J2kImageInfo* info
+) {
+    (void)decoder;
+    (void)info;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_progressive_decode(
+    j2k_progressive_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)decoder;
+    (void)layout;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_progressive_reset(
+    j2k_progressive_t* decoder
+) {
+    (void)decoder;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void j2k_progressive_destroy(
+    j2k_progressive_t* decoder
+) {
+    (void)decoder;
+}
+
+SHARPDICOM_API int j2k_tile_cache_create(
+    size_t byte_budget,
+    j2k_tile_cache_t** cache_out
+) {
+    (void)byte_budget;
+    if (cache_out) *cache_out = NULL;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_decode_region_cached(
+    j2k_tile_cache_t* cache,
+    uint64_t codestream_id,
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+) {
+    (void)cache;
+    (void)codestream_id;
+    (void)input;
+    (void)input_len;
+    (void)layout;
+    (void)x0;
+    (void)y0;
+    (void)x1;
+    (void)y1;
+    (void)options;
+    (void)out_width;
+    (void)out_height;
+    (void)out_components;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_tile_cache_evict(
+    j2k_tile_cache_t* cache,
+    uint64_t codestream_id
+) {
+    (void)cache;
+    (void)codestream_id;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_tile_cache_clear(
+    j2k_tile_cache_t* cache
+) {
+    (void)cache;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int j2k_tile_cache_get_stats(
+    j2k_tile_cache_t* cache,
+    J2kTileCacheStats* stats
+) {
+    (void)cache;
+    (void)stats;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void j2k_tile_cache_destroy(
+    j2k_tile_cache_t* cache
+) {
+    (void)cache;
+}
+
+SHARPDICOM_API int j2k_set_default_threads(int32_t num_threads) {
+    (void)num_threads;
+    set_error("JPEG 2000 support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int32_t j2k_get_default_threads(void) {
+    return 1;
+}
+
 SHARPDICOM_API void j2k_free(void* ptr) {
     if (ptr) {
         free(ptr);
     }
 }
 
+SHARPDICOM_API int32_t j2k_htj2k_support(void) {
+    return 0;
+}
+
 SHARPDICOM_API const char* j2k_version(void) {
     return NULL;
 }
@@ -2,9 +2,12 @@
  * SharpDicom JPEG 2000 Wrapper API
  *
  * Wraps OpenJPEG library for JPEG 2000 lossless and lossy codec support.
- * Provides resolution level decoding for thumbnails and ROI decode for large images.
+ * Provides resolution level decoding for thumbnails, ROI decode for large images
+ * and progressive decoding of codestreams that are still arriving.
  *
- * Thread Safety: All functions are thread-safe.
+ * Thread Safety: One-shot functions are thread-safe.
+ * Each j2k_decoder / j2k_progressive handle is NOT thread-safe; use one handle per thread.
+ * A j2k_tile_cache may be shared between threads.
  * Error messages are stored in thread-local storage via sharpdicom_last_error().
  */
 
@@ -12,6 +15,7 @@
 #define J2K_WRAPPER_H
 
 #include "sharpdicom_codecs.h"
+#include "display.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -79,6 +83,8 @@ typedef struct {
     int32_t num_tiles_y;
     /** Detected format (J2K or JP2) */
     J2kFormat format;
+    /** Whether code-blocks use the HTJ2K (Part 15) block coder */
+    int32_t is_htj2k;
 } J2kImageInfo;
 
 /*============================================================================
@@ -109,8 +115,55 @@ typedef struct {
     int32_t cblk_height_exp;
     /** Use progression order: LRCP=0, RLCP=1, RPCL=2, PCRL=3, CPRL=4 */
     int32_t progression_order;
+    /**
+     * Encode with the HTJ2K (Part 15) block coder instead of EBCOT
+     * (requires J2K_HTJ2K_ENCODE; J2K format only). HT lossy encoding has no
+     * rate control: compression_ratio is rejected and quality selects the
+     * quantization step.
+     */
+    int32_t high_throughput;
+    /**
+     * Worker threads (0 = process default, 1 = calling thread only). With
+     * tile_width/tile_height set, J2K format tiles are encoded in parallel
+     * on the worker pool; otherwise the threads go to OpenJPEG's code-block
+     * encoder where it supports them.
+     */
+    int32_t num_threads;
 } J2kEncodeParams;
 
+/**
+ * Grow callback for J2kOutputBuffer.
+ *
+ * Must return a buffer of at least min_capacity bytes whose first 'used'
+ * bytes match the current buffer (the current buffer may be reused or
+ * released), storing its size in *new_capacity, or NULL on failure.
+ */
+typedef uint8_t* (*J2kGrowFn)(void* opaque, uint8_t* data, size_t used,
+                              size_t min_capacity, size_t* new_capacity);
+
+/**
+ * Growable destination for j2k_encode_to_buffer().
+ *
+ * Keep one per worker and pass it to every encode: it grows to the largest
+ * codestream seen and is then reused without further allocation.
+ */
+typedef struct {
+    /** Buffer (NULL when capacity is 0) */
+    uint8_t* data;
+    /** Size of data in bytes */
+    size_t capacity;
+    /** Output: length of the codestream in data */
+    size_t size;
+    /** Called when data is full (NULL = realloc; release data with j2k_free) */
+    J2kGrowFn grow;
+    /** Passed to grow */
+    void* opaque;
+} J2kOutputBuffer;
+
+/** j2k_htj2k_support() capability bits */
+#define J2K_HTJ2K_DECODE    (1 << 0)  /* HTJ2K codestreams decode through OpenJPEG */
+#define J2K_HTJ2K_ENCODE    (1 << 1)  /* high_throughput encode through OpenJPH */
+
 /*============================================================================
  * JPEG 2000 Decode Options
  *============================================================================*/
@@ -121,8 +174,108 @@ typedef struct {
     int32_t reduce;
     /** Maximum quality layer to decode (0 = all layers) */
     int32_t max_quality_layers;
+    /** Worker threads for tile/code-block decoding (0 = process default, 1 = calling thread only) */
+    int32_t num_threads;
+    /**
+     * Write 8-bit display pixels through this transform instead of stored
+     * samples (NULL = stored samples). Output then takes one byte per sample
+     * at any precision. Must stay valid while the options are in use,
+     * including the lifetime of a j2k_decoder_t created with them.
+     * Not supported by j2k_decode_region_cached().
+     */
+    const display_params_t* display;
 } J2kDecodeOptions;
 
+/*============================================================================
+ * JPEG 2000 Output Layout
+ *============================================================================*/
+
+/** Maximum number of component planes addressable through J2kOutputLayout */
+#define J2K_MAX_PLANES 4
+
+/** Arrangement of decoded samples in the caller's buffer(s) */
+typedef enum {
+    /** Component-interleaved pixels (RGBRGB...), as written by j2k_decode */
+    J2K_LAYOUT_INTERLEAVED = 0,
+    /** One plane per component (RRR... GGG... BBB...) */
+    J2K_LAYOUT_PLANAR = 1
+} J2kLayoutMode;
+
+/**
+ * Caller-described destination for decoded samples.
+ * Samples are 8-bit for precision <= 8, otherwise 16-bit native-endian.
+ */
+typedef struct {
+    /** Interleaved or planar */
+    J2kLayoutMode mode;
+    /** Bytes between row starts, per plane in planar mode (0 = tightly packed; must be sample-aligned) */
+    size_t row_stride;
+    /** Interleaved: destination buffer. Planar: buffer that planes without a pointer are carved from */
+    uint8_t* data;
+    /** Size of data in bytes */
+    size_t data_len;
+    /** Planar: per-component destination (NULL = data + c * row_stride * height) */
+    uint8_t* planes[J2K_MAX_PLANES];
+    /** Planar: size in bytes of each non-NULL planes[c] */
+    size_t plane_lens[J2K_MAX_PLANES];
+} J2kOutputLayout;
+
+/*============================================================================
+ * JPEG 2000 Decoder Handle
+ *============================================================================*/
+
+/** Opaque handle to a reusable JPEG 2000 decoder context */
+typedef struct j2k_decoder j2k_decoder_t;
+
+/*============================================================================
+ * JPEG 2000 Progressive Decoder Handle
+ *============================================================================*/
+
+/** Opaque handle to a decoder fed with a codestream as it arrives */
+typedef struct j2k_progressive j2k_progressive_t;
+
+/** What the part of the codestream received so far decodes to */
+typedef struct {
+    /** 1 once the main header has arrived (j2k_progressive_get_info succeeds) */
+    int32_t header_ready;
+    /** Resolution levels decodable (0 = nothing yet, J2kImageInfo.num_resolutions = full size) */
+    int32_t resolutions;
+    /** Quality layers decodable at that resolution */
+    int32_t quality_layers;
+    /** Size j2k_progressive_decode produces at this level */
+    int32_t width;
+    int32_t height;
+    /** 1 if the last push changed resolutions or quality_layers */
+    int32_t improved;
+    /** 1 once the whole codestream, through EOC, has arrived */
+    int32_t complete;
+    /** Total bytes received */
+    size_t bytes_received;
+} J2kProgressiveStatus;
+
+/*============================================================================
+ * JPEG 2000 Decoded-Tile Cache
+ *============================================================================*/
+
+/** Opaque handle to a thread-safe cache of decoded tiles shared by region decodes */
+typedef struct j2k_tile_cache j2k_tile_cache_t;
+
+/** Tile cache counters, cumulative since creation */
+typedef struct {
+    /** Tiles served from the cache */
+    uint64_t hits;
+    /** Tiles that had to be decoded */
+    uint64_t misses;
+    /** Tiles dropped to stay within the byte budget */
+    uint64_t evictions;
+    /** Bytes of decoded samples currently held */
+    size_t bytes_used;
+    /** Byte budget given at creation */
+    size_t byte_budget;
+    /** Tiles currently held */
+    uint32_t num_tiles;
+} J2kTileCacheStats;
+
 /*============================================================================
  * JPEG 2000 API Functions
  *============================================================================*/
@@ -200,6 +353,59 @@ SHARPDICOM_API int j2k_decode_region(
     int32_t* out_components
 );
 
+/**
+ * Decode a JPEG 2000 codestream directly into a caller-described layout.
+ * Avoids a separate de-interleave pass when planar or strided output is needed.
+ *
+ * @param input         Pointer to compressed J2K/JP2 data
+ * @param input_len     Length of compressed data in bytes
+ * @param layout        Destination layout (interleaved or planar, row stride, plane pointers)
+ * @param options       Decode options (can be NULL for defaults)
+ * @param out_width     Output: Actual decoded width (may differ if reduce > 0)
+ * @param out_height    Output: Actual decoded height (may differ if reduce > 0)
+ * @param out_components Output: Number of components
+ * @return              SHARPDICOM_OK on success, error code on failure
+ */
+SHARPDICOM_API int j2k_decode_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
+/**
+ * Decode a region of a JPEG 2000 codestream directly into a caller-described layout.
+ *
+ * @param input         Pointer to compressed J2K/JP2 data
+ * @param input_len     Length of compressed data in bytes
+ * @param layout        Destination layout (interleaved or planar, row stride, plane pointers)
+ * @param x0            Left coordinate of region (in full resolution space)
+ * @param y0            Top coordinate of region (in full resolution space)
+ * @param x1            Right coordinate of region (exclusive)
+ * @param y1            Bottom coordinate of region (exclusive)
+ * @param options       Decode options (can be NULL for defaults)
+ * @param out_width     Output: Actual decoded region width
+ * @param out_height    Output: Actual decoded region height
+ * @param out_components Output: Number of components
+ * @return              SHARPDICOM_OK on success, error code on failure
+ */
+SHARPDICOM_API int j2k_decode_region_to_layout(
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
 /**
  * Encode raw pixels to JPEG 2000 format.
  * Supports both lossless (5/3 wavelet) and lossy (9/7 wavelet) compression.
@@ -231,6 +437,465 @@ SHARPDICOM_API int j2k_encode(
     size_t* out_size
 );
 
+/**
+ * Encode raw pixels to JPEG 2000 into a growable buffer.
+ *
+ * Same as j2k_encode(), but the output buffer is grown as the codestream
+ * is written instead of failing when it is too small.
+ *
+ * @param input         Pointer to raw pixel data (component-interleaved)
+ * @param input_len     Length of input data in bytes
+ * @param width         Image width in pixels
+ * @param height        Image height in pixels
+ * @param num_components Number of components (1, 3, or 4)
+ * @param bits_per_component Bits per component (8, 12, or 16)
+ * @param is_signed     Whether samples are signed
+ * @param params        Encoding parameters (can be NULL for lossless defaults)
+ * @param output        Destination; output->size receives the codestream length
+ * @return              SHARPDICOM_OK on success, error code on failure
+ *                      (SHARPDICOM_ERR_OUT_OF_MEMORY if the buffer could not grow)
+ */
+SHARPDICOM_API int j2k_encode_to_buffer(
+    const uint8_t* input,
+    size_t input_len,
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    int32_t is_signed,
+    const J2kEncodeParams* params,
+    J2kOutputBuffer* output
+);
+
+/**
+ * Get an output size that j2k_encode() will not overrun for an image.
+ *
+ * OpenJPEG has no bound of its own, so this is a conservative estimate:
+ * the raw samples plus a quarter for expansion of incompressible data,
+ * plus marker and tile-part headers.
+ *
+ * @param width         Image width in pixels
+ * @param height        Image height in pixels
+ * @param num_components Number of components (1-4)
+ * @param bits_per_component Bits per component (1-16)
+ * @param params        Encoding parameters (can be NULL for lossless defaults)
+ * @param max_size      Receives the maximum codestream size
+ * @return              SHARPDICOM_OK on success, error code on failure
+ */
+SHARPDICOM_API int j2k_get_encode_bound(
+    int32_t width,
+    int32_t height,
+    int32_t num_components,
+    int32_t bits_per_component,
+    const J2kEncodeParams* params,
+    size_t* max_size
+);
+
+/*============================================================================
+ * Decoder handle API
+ *============================================================================*/
+
+/**
+ * Creates a reusable JPEG 2000 decoder.
+ *
+ * A decoder parses the main header of an attached codestream once and keeps
+ * it between j2k_decoder_get_info() and decode calls, avoiding the repeated
+ * codec/stream setup of the one-shot functions. Decode options and the worker
+ * count are fixed for the lifetime of the handle.
+ *
+ * The decoder must be destroyed with j2k_decoder_destroy() when done.
+ *
+ * @param options       Decode options (can be NULL for defaults)
+ * @param decoder_out   Pointer to receive decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: decoder_out is NULL
+ *         - SHARPDICOM_ERR_UNSUPPORTED: JPEG 2000 support not compiled in
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int j2k_decoder_create(
+    const J2kDecodeOptions* options,
+    j2k_decoder_t** decoder_out
+);
+
+/**
+ * Attaches a codestream to the decoder and parses its main header.
+ * Replaces any previously attached codestream.
+ *
+ * The input buffer is not copied and must remain valid until the next
+ * j2k_decoder_set_input() or j2k_decoder_destroy() call.
+ *
+ * @param decoder       Decoder handle
+ * @param input         Pointer to compressed J2K/JP2 data
+ * @param input_len     Length of compressed data in bytes
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_decoder_set_input(
+    j2k_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len
+);
+
+/**
+ * Gets image information for the attached codestream from the cached header.
+ *
+ * @param decoder       Decoder handle
+ * @param info          Pointer to J2kImageInfo structure to fill
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_decoder_get_info(
+    j2k_decoder_t* decoder,
+    J2kImageInfo* info
+);
+
+/**
+ * Decodes the attached codestream into a component-interleaved buffer.
+ *
+ * The first decode after j2k_decoder_set_input() uses the already-parsed
+ * header. OpenJPEG codecs are single-use, so decoding the same codestream
+ * again re-parses the header internally.
+ *
+ * @param decoder       Decoder handle
+ * @param output        Pointer to output buffer for decoded pixels
+ * @param output_len    Size of output buffer in bytes
+ * @param out_width     Output: Actual decoded width (may differ if reduce > 0)
+ * @param out_height    Output: Actual decoded height (may differ if reduce > 0)
+ * @param out_components Output: Number of components
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_decoder_decode(
+    j2k_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
+/**
+ * Decodes the attached codestream directly into a caller-described layout.
+ *
+ * @param decoder       Decoder handle
+ * @param layout        Destination layout (interleaved or planar, row stride, plane pointers)
+ * @param out_width     Output: Actual decoded width (may differ if reduce > 0)
+ * @param out_height    Output: Actual decoded height (may differ if reduce > 0)
+ * @param out_components Output: Number of components
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_decoder_decode_to_layout(
+    j2k_decoder_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
+/**
+ * Decodes a region of the attached codestream directly into a caller-described layout.
+ *
+ * @param decoder       Decoder handle
+ * @param layout        Destination layout (interleaved or planar, row stride, plane pointers)
+ * @param x0            Left coordinate of region (in full resolution space)
+ * @param y0            Top coordinate of region (in full resolution space)
+ * @param x1            Right coordinate of region (exclusive)
+ * @param y1            Bottom coordinate of region (exclusive)
+ * @param out_width     Output: Actual decoded region width
+ * @param out_height    Output: Actual decoded region height
+ * @param out_components Output: Number of components
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_decoder_decode_region_to_layout(
+    j2k_decoder_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
+/**
+ * Destroys a decoder and frees all resources.
+ *
+ * @param decoder       Decoder handle (may be NULL)
+ */
+SHARPDICOM_API void j2k_decoder_destroy(
+    j2k_decoder_t* decoder
+);
+
+/*============================================================================
+ * Progressive decoder API
+ *============================================================================*/
+
+/**
+ * Creates a progressive decoder for a raw J2K codestream delivered in chunks,
+ * e.g. over a network, so a reduced image can be shown before it completes.
+ *
+ * Each chunk is scanned once for its markers and PLT packet lengths, which
+ * tell how many resolution levels and quality layers have fully arrived; no
+ * packet is decoded until j2k_progressive_decode() is called. Without PLT
+ * markers a tile counts only once all its tile-parts have arrived, so
+ * resolution-progressive (RLCP/RPCL) or layer-progressive (LRCP) streams
+ * written with PLT refine best.
+ *
+ * options->reduce and options->max_quality_layers cap the level the decoder
+ * refines to; options->num_threads applies to every decode.
+ *
+ * The decoder must be destroyed with j2k_progressive_destroy() when done.
+ *
+ * @param options       Decode options (can be NULL for defaults)
+ * @param decoder_out   Pointer to receive decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: decoder_out is NULL
+ *         - SHARPDICOM_ERR_UNSUPPORTED: JPEG 2000 support not compiled in
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int j2k_progressive_create(
+    const J2kDecodeOptions* options,
+    j2k_progressive_t** decoder_out
+);
+
+/**
+ * Appends the next chunk of the codestream and reports what it makes decodable.
+ *
+ * The chunk is copied, so the caller's buffer may be reused on return.
+ *
+ * @param decoder       Decoder handle
+ * @param data          Next bytes of the codestream (may be NULL if data_len is 0)
+ * @param data_len      Number of bytes
+ * @param status        Receives the decodable level (can be NULL)
+ *
+ * @return SHARPDICOM_OK on success (including when nothing is decodable yet), or:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL decoder or data
+ *         - SHARPDICOM_ERR_UNSUPPORTED: Input is a JP2 file rather than a raw codestream
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Malformed codestream (reset to start over)
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int j2k_progressive_push(
+    j2k_progressive_t* decoder,
+    const uint8_t* data,
+    size_t data_len,
+    J2kProgressiveStatus* status
+);
+
+/**
+ * Gets image information once the main header has arrived.
+ *
+ * @param decoder       Decoder handle
+ * @param info          Pointer to J2kImageInfo structure to fill
+ *
+ * @return SHARPDICOM_OK on success, SHARPDICOM_ERR_INVALID_ARGUMENT if the
+ *         header is not complete yet, or another negative error code
+ */
+SHARPDICOM_API int j2k_progressive_get_info(
+    j2k_progressive_t* decoder,
+    J2kImageInfo* info
+);
+
+/**
+ * Decodes the data received so far at the level last reported by
+ * j2k_progressive_push() into a caller-described layout.
+ *
+ * Only packets of the reported resolutions and layers are decoded, and the
+ * output has the reported width and height. Call again after a push that
+ * reports improved to refine the image. Each call is a full decode of the
+ * prefix: OpenJPEG parses the main header again and re-decodes the lower
+ * resolutions rather than continuing from the previous call; only the
+ * marker scan done by j2k_progressive_push() carries over.
+ *
+ * @param decoder       Decoder handle
+ * @param layout        Destination layout (interleaved or planar, row stride, plane pointers)
+ * @param out_width     Output: Decoded width
+ * @param out_height    Output: Decoded height
+ * @param out_components Output: Number of components
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_DECODE_FAILED: No resolution level has arrived yet, or decoding failed
+ */
+SHARPDICOM_API int j2k_progressive_decode(
+    j2k_progressive_t* decoder,
+    const J2kOutputLayout* layout,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
+/**
+ * Discards the received data to start a new codestream, keeping the
+ * allocated buffers and the options.
+ *
+ * @param decoder       Decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_progressive_reset(
+    j2k_progressive_t* decoder
+);
+
+/**
+ * Destroys a progressive decoder and frees all resources.
+ *
+ * @param decoder       Decoder handle (may be NULL)
+ */
+SHARPDICOM_API void j2k_progressive_destroy(
+    j2k_progressive_t* decoder
+);
+
+/*============================================================================
+ * Decoded-tile cache API
+ *============================================================================*/
+
+/**
+ * Creates a decoded-tile cache for repeated region decodes of the same
+ * codestreams, e.g. pan and zoom over a whole-slide image.
+ *
+ * Tiles are stored as output samples keyed by (codestream id, tile index,
+ * reduce, quality layers) and evicted least recently used first once their
+ * total size exceeds byte_budget. Tiles in use by a running decode are never
+ * evicted, so the budget can be exceeded briefly by one request's tiles.
+ *
+ * A cache may be shared by any number of threads.
+ * The cache must be destroyed with j2k_tile_cache_destroy() when done.
+ *
+ * @param byte_budget   Maximum bytes of decoded samples to keep
+ * @param cache_out     Pointer to receive cache handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: cache_out is NULL or byte_budget is 0
+ *         - SHARPDICOM_ERR_UNSUPPORTED: JPEG 2000 support not compiled in
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int j2k_tile_cache_create(
+    size_t byte_budget,
+    j2k_tile_cache_t** cache_out
+);
+
+/**
+ * Decodes a region through a tile cache.
+ *
+ * Only tiles overlapping the region that are not cached are decoded; the
+ * region is then assembled from cached tiles. The output matches
+ * j2k_decode_region_to_layout() for the same arguments. The region is
+ * clipped to the image on the right and bottom.
+ *
+ * codestream_id identifies the codestream bytes to the cache (for example a
+ * hash of the SOP Instance UID and frame number). It must differ for
+ * codestreams with different contents; reusing an id for new data returns
+ * stale tiles. j2k_tile_cache_evict() drops an id that is being reused.
+ *
+ * @param cache         Tile cache handle
+ * @param codestream_id Caller-chosen identity of input (non-zero)
+ * @param input         Pointer to compressed J2K/JP2 data
+ * @param input_len     Length of compressed data in bytes
+ * @param layout        Destination layout (interleaved or planar, row stride, plane pointers)
+ * @param x0            Left coordinate of region (in full resolution space)
+ * @param y0            Top coordinate of region (in full resolution space)
+ * @param x1            Right coordinate of region (exclusive)
+ * @param y1            Bottom coordinate of region (exclusive)
+ * @param options       Decode options (can be NULL for defaults)
+ * @param out_width     Output: Actual decoded region width
+ * @param out_height    Output: Actual decoded region height
+ * @param out_components Output: Number of components
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: Bad arguments, region outside the image, small buffers
+ *         - SHARPDICOM_ERR_UNSUPPORTED: Subsampled components, or JPEG 2000 support not compiled in
+ *         - SHARPDICOM_ERR_DECODE_FAILED: A tile failed to decode
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int j2k_decode_region_cached(
+    j2k_tile_cache_t* cache,
+    uint64_t codestream_id,
+    const uint8_t* input,
+    size_t input_len,
+    const J2kOutputLayout* layout,
+    int32_t x0,
+    int32_t y0,
+    int32_t x1,
+    int32_t y1,
+    const J2kDecodeOptions* options,
+    int32_t* out_width,
+    int32_t* out_height,
+    int32_t* out_components
+);
+
+/**
+ * Drops every cached tile of one codestream.
+ *
+ * @param cache         Tile cache handle
+ * @param codestream_id Identity passed to j2k_decode_region_cached()
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_tile_cache_evict(
+    j2k_tile_cache_t* cache,
+    uint64_t codestream_id
+);
+
+/**
+ * Drops every cached tile.
+ *
+ * @param cache         Tile cache handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_tile_cache_clear(
+    j2k_tile_cache_t* cache
+);
+
+/**
+ * Gets the cache counters.
+ *
+ * @param cache         Tile cache handle
+ * @param stats         Pointer to J2kTileCacheStats structure to fill
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int j2k_tile_cache_get_stats(
+    j2k_tile_cache_t* cache,
+    J2kTileCacheStats* stats
+);
+
+/**
+ * Destroys a tile cache and frees all cached tiles.
+ * No decode may be using the cache.
+ *
+ * @param cache         Tile cache handle (may be NULL)
+ */
+SHARPDICOM_API void j2k_tile_cache_destroy(
+    j2k_tile_cache_t* cache
+);
+
+/**
+ * Set the process-wide default worker count for JPEG 2000 decoding and
+ * encoding. Used whenever J2kDecodeOptions/J2kEncodeParams is NULL or its
+ * num_threads is 0. Tile and code-block decoding is spread across the
+ * workers by OpenJPEG; tiled encodes are spread across the worker pool.
+ *
+ * @param num_threads   Worker count (0 = library thread budget for frames of at least
+ *                      1024 x 1024 pixels and one thread below, 1 = single-threaded)
+ * @return              SHARPDICOM_OK on success, SHARPDICOM_ERR_INVALID_ARGUMENT if negative
+ */
+SHARPDICOM_API int j2k_set_default_threads(int32_t num_threads);
+
+/**
+ * Get the effective process-wide default worker count for JPEG 2000 decoding
+ * of frames large enough to use it (smaller frames decode on one thread
+ * unless a count is set). Returns 1 when OpenJPEG was built without thread
+ * support.
+ *
+ * @return              Number of decode workers used by default
+ */
+SHARPDICOM_API int32_t j2k_get_default_threads(void);
+
 /**
  * Free memory allocated by j2k_* functions.
  * Currently not used as all decoding writes to caller-provided buffers,
@@ -240,6 +905,16 @@ SHARPDICOM_API int j2k_encode(
  */
 SHARPDICOM_API void j2k_free(void* ptr);
 
+/**
+ * Report HTJ2K (High-Throughput JPEG 2000, ISO/IEC 15444-15) support.
+ *
+ * HTJ2K codestreams use the regular decode API; HT encoding is selected
+ * with J2kEncodeParams.high_throughput.
+ *
+ * @return              Bitmask of J2K_HTJ2K_DECODE and J2K_HTJ2K_ENCODE (0 if neither)
+ */
+SHARPDICOM_API int32_t j2k_htj2k_support(void);
+
 /**
  * Get the OpenJPEG library version string.
  *
@@ -2,12 +2,16 @@
  * JPEG-LS Wrapper Implementation (CharLS)
  *
  * Wraps the CharLS library C API for JPEG-LS encoding and decoding.
- * Uses charls_jpegls_decoder/encoder APIs from charls/charls.h.
+ * Uses charls_jpegls_decoder/encoder APIs from charls/charls.h, either per
+ * call or through reusable jls_decoder_t / jls_encoder_t handles.
  */
 
 #define SHARPDICOM_CODECS_EXPORTS
 #include "jls_wrapper.h"
 #include "sharpdicom_codecs.h"
+#include "pixel_convert.h"
+#include "allocator.h"
+#include "codec_stats.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -178,17 +182,18 @@ static charls_interleave_mode jls_to_charls_interleave(int mode) {
  * JPEG-LS decode implementation
  *============================================================================*/
 
-SHARPDICOM_API int jls_get_decode_size(
+/**
+ * Create a CharLS decoder over a codestream and read its SPIFF and JPEG-LS
+ * headers, leaving it ready to decode.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int jls_open_decoder(
     const uint8_t* input,
     size_t input_len,
-    size_t* output_size,
-    jls_decode_params_t* params)
+    charls_jpegls_decoder** decoder_out,
+    charls_frame_info* frame_info)
 {
-    if (input == NULL || input_len == 0 || output_size == NULL) {
-        set_error("Invalid argument: NULL input or output_size");
-        return SHARPDICOM_ERR_INVALID_ARGUMENT;
-    }
-
     /* Create decoder */
     charls_jpegls_decoder* decoder = charls_jpegls_decoder_create();
     if (decoder == NULL) {
@@ -219,39 +224,120 @@ SHARPDICOM_API int jls_get_decode_size(
     }
 
     /* Get frame info */
-    charls_frame_info frame_info;
-    error = charls_jpegls_decoder_get_frame_info(decoder, &frame_info);
+    error = charls_jpegls_decoder_get_frame_info(decoder, frame_info);
     if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
         set_error_fmt("Failed to get frame info: %s", charls_error_string(error));
         charls_jpegls_decoder_destroy(decoder);
         return charls_to_sharpdicom_error(error);
     }
 
-    /* Calculate output size */
-    size_t bytes_per_sample = (frame_info.bits_per_sample + 7) / 8;
-    *output_size = (size_t)frame_info.width * frame_info.height *
-                   frame_info.component_count * bytes_per_sample;
+    *decoder_out = decoder;
+    return SHARPDICOM_OK;
+}
 
-    /* Fill params if requested */
-    if (params != NULL) {
-        params->width = frame_info.width;
-        params->height = frame_info.height;
-        params->components = frame_info.component_count;
-        params->bits_per_sample = frame_info.bits_per_sample;
+/**
+ * Calculate the decoded size of a frame.
+ *
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT if it overflows size_t
+ */
+static int jls_frame_size(const charls_frame_info* frame_info, size_t* size) {
+    size_t bytes_per_sample = ((size_t)frame_info->bits_per_sample + 7) / 8;
+    *size = safe_mul4_size(frame_info->width, frame_info->height,
+                           (size_t)frame_info->component_count, bytes_per_sample);
+    if (*size == 0) {
+        set_error("Image dimensions too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Fill decode parameters from a decoder whose headers have been read.
+ */
+static void jls_fill_params(
+    const charls_jpegls_decoder* decoder,
+    const charls_frame_info* frame_info,
+    jls_decode_params_t* params)
+{
+    params->width = frame_info->width;
+    params->height = frame_info->height;
+    params->components = frame_info->component_count;
+    params->bits_per_sample = frame_info->bits_per_sample;
+
+    /* Get near-lossless parameter */
+    int32_t near_lossless = 0;
+    charls_jpegls_decoder_get_near_lossless(decoder, 0, &near_lossless);
+    params->near_lossless = near_lossless;
+
+    /* Get interleave mode */
+    charls_interleave_mode interleave_mode = CHARLS_INTERLEAVE_MODE_NONE;
+    charls_jpegls_decoder_get_interleave_mode(decoder, &interleave_mode);
+    params->interleave_mode = charls_to_jls_interleave(interleave_mode);
+}
+
+/**
+ * Decode an opened stream of input_len bytes after checking the output holds
+ * required_size bytes. The decoder cannot be used again afterwards.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int jls_decode_opened(
+    charls_jpegls_decoder* decoder,
+    size_t input_len,
+    size_t required_size,
+    uint8_t* output,
+    size_t output_len)
+{
+    /* Validate output buffer size */
+    if (output_len < required_size) {
+        set_error_fmt("Output buffer too small: need %zu bytes, have %zu",
+                      required_size, output_len);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Decode to output buffer */
+    int64_t start = codec_stats_start();
+    charls_jpegls_errc error = charls_jpegls_decoder_decode_to_buffer(
+        decoder, output, output_len, 0);
+    int result = SHARPDICOM_OK;
+    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
+        set_error_fmt("Failed to decode JPEG-LS data: %s", charls_error_string(error));
+        result = charls_to_sharpdicom_error(error);
+    }
+    codec_stats_record(SHARPDICOM_STATS_JLS, CODEC_STATS_DECODE, start,
+                       input_len, required_size, result);
+
+    return result;
+}
 
-        /* Get near-lossless parameter */
-        int32_t near_lossless = 0;
-        charls_jpegls_decoder_get_near_lossless(decoder, 0, &near_lossless);
-        params->near_lossless = near_lossless;
+SHARPDICOM_API int jls_get_decode_size(
+    const uint8_t* input,
+    size_t input_len,
+    size_t* output_size,
+    jls_decode_params_t* params)
+{
+    if (input == NULL || input_len == 0 || output_size == NULL) {
+        set_error("Invalid argument: NULL input or output_size");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
 
-        /* Get interleave mode */
-        charls_interleave_mode interleave_mode;
-        charls_jpegls_decoder_get_interleave_mode(decoder, &interleave_mode);
-        params->interleave_mode = charls_to_jls_interleave(interleave_mode);
+    charls_jpegls_decoder* decoder = NULL;
+    charls_frame_info frame_info;
+    int result = jls_open_decoder(input, input_len, &decoder, &frame_info);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    /* Calculate output size */
+    result = jls_frame_size(&frame_info, output_size);
+
+    /* Fill params if requested */
+    if (result == SHARPDICOM_OK && params != NULL) {
+        jls_fill_params(decoder, &frame_info, params);
     }
 
     charls_jpegls_decoder_destroy(decoder);
-    return SHARPDICOM_OK;
+    return result;
 }
 
 SHARPDICOM_API int jls_decode(
@@ -270,84 +356,266 @@ SHARPDICOM_API int jls_decode(
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Create decoder */
-    charls_jpegls_decoder* decoder = charls_jpegls_decoder_create();
+    charls_jpegls_decoder* decoder = NULL;
+    charls_frame_info frame_info;
+    int result = jls_open_decoder(input, input_len, &decoder, &frame_info);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    /* Fill params if requested */
+    if (params != NULL) {
+        jls_fill_params(decoder, &frame_info, params);
+    }
+
+    size_t required_size = 0;
+    result = jls_frame_size(&frame_info, &required_size);
+    if (result == SHARPDICOM_OK) {
+        result = jls_decode_opened(decoder, input_len, required_size, output, output_len);
+    }
+
+    charls_jpegls_decoder_destroy(decoder);
+    return result;
+}
+
+SHARPDICOM_API int jls_decode_display(
+    const uint8_t* input,
+    size_t input_len,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len,
+    jls_decode_params_t* params)
+{
+    if (input == NULL || input_len == 0) {
+        set_error("Invalid argument: NULL or empty input");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (display == NULL || output == NULL || output_len == 0) {
+        set_error("Invalid argument: NULL display parameters or empty output buffer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    charls_jpegls_decoder* decoder = NULL;
+    charls_frame_info frame_info;
+    int result = jls_open_decoder(input, input_len, &decoder, &frame_info);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    if (params != NULL) {
+        jls_fill_params(decoder, &frame_info, params);
+    }
+
+    /* Check the display buffer and compile the transform before decoding */
+    size_t required_size = 0;
+    size_t samples = 0;
+    int32_t bits = frame_info.bits_per_sample;
+    int is_signed = (display->is_signed != 0);
+    pixel_display_map map;
+    memset(&map, 0, sizeof(map));
+    uint8_t* decoded = NULL;
+
+    result = jls_frame_size(&frame_info, &required_size);
+    if (result == SHARPDICOM_OK) {
+        samples = required_size / (size_t)((bits + 7) / 8);
+        if (output_len < samples) {
+            set_error_fmt("Output buffer too small: need %zu bytes, have %zu", samples, output_len);
+            result = SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+    }
+    if (result == SHARPDICOM_OK) {
+        result = pixel_display_map_init(&map, display, bits, is_signed);
+    }
+    if (result == SHARPDICOM_OK) {
+        decoded = (uint8_t*)allocator_alloc(required_size);
+        if (decoded == NULL) {
+            set_error("Failed to allocate JPEG-LS decode buffer");
+            result = SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+    }
+    if (result == SHARPDICOM_OK) {
+        result = jls_decode_opened(decoder, input_len, required_size, decoded, required_size);
+    }
+    if (result == SHARPDICOM_OK) {
+        pixel_display_samples(decoded, samples, bits, is_signed, &map, output);
+    }
+
+    allocator_free(decoded);
+    pixel_display_map_release(&map);
+    charls_jpegls_decoder_destroy(decoder);
+    return result;
+}
+
+/*============================================================================
+ * JPEG-LS decoder handle
+ *
+ * Keeps the CharLS decoder of the last jls_decoder_read_header() so the
+ * following jls_decoder_decode() starts from the parsed headers. CharLS
+ * decoders are single-use, so each frame still gets a fresh one.
+ *============================================================================*/
+
+struct jls_decoder {
+    /** Decoder with headers read, awaiting jls_decoder_decode() (NULL = none) */
+    charls_jpegls_decoder* pending;
+    charls_frame_info frame_info;
+    size_t input_len;
+    size_t output_size;
+};
+
+/** Drop a pending parsed stream */
+static void jls_decoder_release(jls_decoder_t* decoder) {
+    if (decoder->pending != NULL) {
+        charls_jpegls_decoder_destroy(decoder->pending);
+        decoder->pending = NULL;
+    }
+}
+
+SHARPDICOM_API int jls_decoder_create(jls_decoder_t** decoder_out) {
+    if (decoder_out == NULL) {
+        set_error("Invalid argument: NULL decoder_out");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    jls_decoder_t* decoder = (jls_decoder_t*)allocator_calloc(1, sizeof(*decoder));
     if (decoder == NULL) {
-        set_error("Failed to create JPEG-LS decoder");
+        set_error("Failed to allocate JPEG-LS decoder");
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
     }
 
-    /* Set source buffer */
-    charls_jpegls_errc error = charls_jpegls_decoder_set_source_buffer(
-        decoder, input, input_len);
-    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
-        set_error_fmt("Failed to set source buffer: %s", charls_error_string(error));
-        charls_jpegls_decoder_destroy(decoder);
-        return charls_to_sharpdicom_error(error);
+    *decoder_out = decoder;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int jls_decoder_read_header(
+    jls_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* output_size,
+    jls_decode_params_t* params)
+{
+    if (decoder == NULL || input == NULL || input_len == 0) {
+        set_error("Invalid argument: NULL decoder or empty input");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Read SPIFF header (optional) */
-    charls_spiff_header spiff_header;
-    int32_t header_found = 0;
-    charls_jpegls_decoder_read_spiff_header(decoder, &spiff_header, &header_found);
+    jls_decoder_release(decoder);
 
-    /* Read frame info */
-    error = charls_jpegls_decoder_read_header(decoder);
-    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
-        set_error_fmt("Failed to read JPEG-LS header: %s", charls_error_string(error));
-        charls_jpegls_decoder_destroy(decoder);
-        return charls_to_sharpdicom_error(error);
+    charls_jpegls_decoder* parsed = NULL;
+    charls_frame_info frame_info;
+    int result = jls_open_decoder(input, input_len, &parsed, &frame_info);
+    if (result != SHARPDICOM_OK) {
+        return result;
     }
 
-    /* Get frame info for validation and params */
-    charls_frame_info frame_info;
-    error = charls_jpegls_decoder_get_frame_info(decoder, &frame_info);
-    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
-        set_error_fmt("Failed to get frame info: %s", charls_error_string(error));
-        charls_jpegls_decoder_destroy(decoder);
-        return charls_to_sharpdicom_error(error);
+    size_t size = 0;
+    result = jls_frame_size(&frame_info, &size);
+    if (result != SHARPDICOM_OK) {
+        charls_jpegls_decoder_destroy(parsed);
+        return result;
     }
 
-    /* Fill params if requested */
     if (params != NULL) {
-        params->width = frame_info.width;
-        params->height = frame_info.height;
-        params->components = frame_info.component_count;
-        params->bits_per_sample = frame_info.bits_per_sample;
+        jls_fill_params(parsed, &frame_info, params);
+    }
+    if (output_size != NULL) {
+        *output_size = size;
+    }
 
-        int32_t near_lossless = 0;
-        charls_jpegls_decoder_get_near_lossless(decoder, 0, &near_lossless);
-        params->near_lossless = near_lossless;
+    decoder->pending = parsed;
+    decoder->frame_info = frame_info;
+    decoder->input_len = input_len;
+    decoder->output_size = size;
+    return SHARPDICOM_OK;
+}
 
-        charls_interleave_mode interleave_mode;
-        charls_jpegls_decoder_get_interleave_mode(decoder, &interleave_mode);
-        params->interleave_mode = charls_to_jls_interleave(interleave_mode);
+SHARPDICOM_API int jls_decoder_decode(
+    jls_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len)
+{
+    if (decoder == NULL) {
+        set_error("Invalid argument: NULL decoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (output == NULL || output_len == 0) {
+        set_error("Invalid argument: NULL or empty output buffer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (decoder->pending == NULL) {
+        set_error("No JPEG-LS header read: call jls_decoder_read_header() first");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Validate output buffer size */
-    size_t bytes_per_sample = (frame_info.bits_per_sample + 7) / 8;
-    size_t required_size = (size_t)frame_info.width * frame_info.height *
-                           frame_info.component_count * bytes_per_sample;
-    if (output_len < required_size) {
+    /* A too-small buffer leaves the stream pending for a retry */
+    if (output_len < decoder->output_size) {
         set_error_fmt("Output buffer too small: need %zu bytes, have %zu",
-                      required_size, output_len);
-        charls_jpegls_decoder_destroy(decoder);
+                      decoder->output_size, output_len);
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Decode to output buffer */
-    error = charls_jpegls_decoder_decode_to_buffer(
-        decoder, output, output_len, 0);
-    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
-        set_error_fmt("Failed to decode JPEG-LS data: %s", charls_error_string(error));
-        charls_jpegls_decoder_destroy(decoder);
-        return charls_to_sharpdicom_error(error);
+    int result = jls_decode_opened(decoder->pending, decoder->input_len, decoder->output_size,
+                                   output, output_len);
+    jls_decoder_release(decoder);
+    return result;
+}
+
+SHARPDICOM_API int jls_decoder_decode_frame(
+    jls_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t** output,
+    size_t* output_len,
+    jls_decode_params_t* params)
+{
+    if (output == NULL || output_len == NULL) {
+        set_error("Invalid argument: NULL output or output_len");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    charls_jpegls_decoder_destroy(decoder);
+    int result = jls_decoder_read_header(decoder, input, input_len, NULL, params);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    /* Caller buffer is validated; otherwise allocate one of the exact size */
+    uint8_t* allocated = NULL;
+    if (*output == NULL) {
+        allocated = (uint8_t*)malloc(decoder->output_size);
+        if (allocated == NULL) {
+            set_error_fmt("Failed to allocate %zu byte output buffer", decoder->output_size);
+            jls_decoder_release(decoder);
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        *output = allocated;
+        *output_len = decoder->output_size;
+    }
+
+    size_t size = decoder->output_size;
+    result = jls_decode_opened(decoder->pending, input_len, size, *output, *output_len);
+    jls_decoder_release(decoder);
+
+    if (result != SHARPDICOM_OK) {
+        if (allocated != NULL) {
+            free(allocated);
+            *output = NULL;
+            *output_len = 0;
+        }
+        return result;
+    }
+
+    *output_len = size;
     return SHARPDICOM_OK;
 }
 
+SHARPDICOM_API void jls_decoder_destroy(jls_decoder_t* decoder) {
+    if (decoder == NULL) {
+        return;
+    }
+
+    jls_decoder_release(decoder);
+    allocator_free(decoder);
+}
+
 /*============================================================================
  * JPEG-LS encode implementation
  *============================================================================*/
@@ -390,12 +658,17 @@ SHARPDICOM_API int jls_get_encode_bound(
     return SHARPDICOM_OK;
 }
 
-SHARPDICOM_API int jls_encode(
+/**
+ * Validate the arguments of an encode call.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int jls_validate_encode(
     const uint8_t* input,
     size_t input_len,
-    uint8_t* output,
+    const uint8_t* output,
     size_t output_len,
-    size_t* actual_size,
+    const size_t* actual_size,
     const jls_encode_params_t* params)
 {
     if (input == NULL || input_len == 0) {
@@ -443,13 +716,23 @@ SHARPDICOM_API int jls_encode(
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Create encoder */
-    charls_jpegls_encoder* encoder = charls_jpegls_encoder_create();
-    if (encoder == NULL) {
-        set_error("Failed to create JPEG-LS encoder");
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
-    }
+    return SHARPDICOM_OK;
+}
 
+/**
+ * Configure an encoder whose destination is set, encode one frame and
+ * report the bytes written. Every setting is applied on each call so a
+ * rewound encoder carries nothing over from the previous frame.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int jls_encode_frame(
+    charls_jpegls_encoder* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* actual_size,
+    const jls_encode_params_t* params)
+{
     /* Set frame info */
     charls_frame_info frame_info = {
         .width = params->width,
@@ -461,18 +744,14 @@ SHARPDICOM_API int jls_encode(
     charls_jpegls_errc error = charls_jpegls_encoder_set_frame_info(encoder, &frame_info);
     if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
         set_error_fmt("Failed to set frame info: %s", charls_error_string(error));
-        charls_jpegls_encoder_destroy(encoder);
         return charls_to_sharpdicom_error(error);
     }
 
     /* Set near-lossless parameter */
-    if (params->near_lossless > 0) {
-        error = charls_jpegls_encoder_set_near_lossless(encoder, params->near_lossless);
-        if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
-            set_error_fmt("Failed to set near-lossless: %s", charls_error_string(error));
-            charls_jpegls_encoder_destroy(encoder);
-            return charls_to_sharpdicom_error(error);
-        }
+    error = charls_jpegls_encoder_set_near_lossless(encoder, params->near_lossless);
+    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
+        set_error_fmt("Failed to set near-lossless: %s", charls_error_string(error));
+        return charls_to_sharpdicom_error(error);
     }
 
     /* Set interleave mode */
@@ -480,39 +759,183 @@ SHARPDICOM_API int jls_encode(
         encoder, jls_to_charls_interleave(params->interleave_mode));
     if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
         set_error_fmt("Failed to set interleave mode: %s", charls_error_string(error));
-        charls_jpegls_encoder_destroy(encoder);
-        return charls_to_sharpdicom_error(error);
-    }
-
-    /* Set destination buffer */
-    error = charls_jpegls_encoder_set_destination_buffer(encoder, output, output_len);
-    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
-        set_error_fmt("Failed to set destination buffer: %s", charls_error_string(error));
-        charls_jpegls_encoder_destroy(encoder);
         return charls_to_sharpdicom_error(error);
     }
 
     /* Encode */
+    int64_t start = codec_stats_start();
     error = charls_jpegls_encoder_encode_from_buffer(
         encoder, input, input_len, 0);
     if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
         set_error_fmt("Failed to encode JPEG-LS data: %s", charls_error_string(error));
-        charls_jpegls_encoder_destroy(encoder);
-        return charls_to_sharpdicom_error(error);
+        int result = charls_to_sharpdicom_error(error);
+        codec_stats_record(SHARPDICOM_STATS_JLS, CODEC_STATS_ENCODE, start, input_len, 0, result);
+        return result;
     }
 
     /* Get actual encoded size */
     error = charls_jpegls_encoder_get_bytes_written(encoder, actual_size);
     if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
         set_error_fmt("Failed to get bytes written: %s", charls_error_string(error));
+        int result = charls_to_sharpdicom_error(error);
+        codec_stats_record(SHARPDICOM_STATS_JLS, CODEC_STATS_ENCODE, start, input_len, 0, result);
+        return result;
+    }
+
+    codec_stats_record(SHARPDICOM_STATS_JLS, CODEC_STATS_ENCODE, start,
+                       input_len, *actual_size, SHARPDICOM_OK);
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Create an encoder writing to a destination buffer.
+ *
+ * @return SHARPDICOM_OK on success, error code on failure (error message set)
+ */
+static int jls_create_encoder(
+    uint8_t* output,
+    size_t output_len,
+    charls_jpegls_encoder** encoder_out)
+{
+    /* Create encoder */
+    charls_jpegls_encoder* encoder = charls_jpegls_encoder_create();
+    if (encoder == NULL) {
+        set_error("Failed to create JPEG-LS encoder");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    /* Set destination buffer */
+    charls_jpegls_errc error = charls_jpegls_encoder_set_destination_buffer(encoder, output, output_len);
+    if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
+        set_error_fmt("Failed to set destination buffer: %s", charls_error_string(error));
         charls_jpegls_encoder_destroy(encoder);
         return charls_to_sharpdicom_error(error);
     }
 
+    *encoder_out = encoder;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int jls_encode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const jls_encode_params_t* params)
+{
+    int result = jls_validate_encode(input, input_len, output, output_len, actual_size, params);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    charls_jpegls_encoder* encoder = NULL;
+    result = jls_create_encoder(output, output_len, &encoder);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    result = jls_encode_frame(encoder, input, input_len, actual_size, params);
     charls_jpegls_encoder_destroy(encoder);
+    return result;
+}
+
+/*============================================================================
+ * JPEG-LS encoder handle
+ *
+ * CharLS binds an encoder to one destination buffer. Encoding the next frame
+ * into the same buffer rewinds the encoder instead of recreating it, which
+ * is the usual pattern when frames are encoded into a scratch buffer and
+ * copied out.
+ *============================================================================*/
+
+struct jls_encoder {
+    /** Encoder bound to destination, or NULL */
+    charls_jpegls_encoder* encoder;
+    uint8_t* destination;
+    size_t destination_len;
+};
+
+/** Drop the bound encoder */
+static void jls_encoder_release(jls_encoder_t* encoder) {
+    if (encoder->encoder != NULL) {
+        charls_jpegls_encoder_destroy(encoder->encoder);
+        encoder->encoder = NULL;
+    }
+    encoder->destination = NULL;
+    encoder->destination_len = 0;
+}
+
+SHARPDICOM_API int jls_encoder_create(jls_encoder_t** encoder_out) {
+    if (encoder_out == NULL) {
+        set_error("Invalid argument: NULL encoder_out");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    jls_encoder_t* encoder = (jls_encoder_t*)allocator_calloc(1, sizeof(*encoder));
+    if (encoder == NULL) {
+        set_error("Failed to allocate JPEG-LS encoder");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    *encoder_out = encoder;
     return SHARPDICOM_OK;
 }
 
+SHARPDICOM_API int jls_encoder_encode(
+    jls_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const jls_encode_params_t* params)
+{
+    if (encoder == NULL) {
+        set_error("Invalid argument: NULL encoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    int result = jls_validate_encode(input, input_len, output, output_len, actual_size, params);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    if (encoder->encoder != NULL &&
+        encoder->destination == output && encoder->destination_len == output_len) {
+        charls_jpegls_errc error = charls_jpegls_encoder_rewind(encoder->encoder);
+        if (error != CHARLS_JPEGLS_ERRC_SUCCESS) {
+            jls_encoder_release(encoder);
+        }
+    } else {
+        jls_encoder_release(encoder);
+    }
+
+    if (encoder->encoder == NULL) {
+        result = jls_create_encoder(output, output_len, &encoder->encoder);
+        if (result != SHARPDICOM_OK) {
+            return result;
+        }
+        encoder->destination = output;
+        encoder->destination_len = output_len;
+    }
+
+    result = jls_encode_frame(encoder->encoder, input, input_len, actual_size, params);
+    if (result != SHARPDICOM_OK) {
+        /* The encoder state after a failure is unspecified */
+        jls_encoder_release(encoder);
+    }
+    return result;
+}
+
+SHARPDICOM_API void jls_encoder_destroy(jls_encoder_t* encoder) {
+    if (encoder == NULL) {
+        return;
+    }
+
+    jls_encoder_release(encoder);
+    allocator_free(encoder);
+}
+
 /*============================================================================
  * Memory management
  *============================================================================*/
@@ -559,6 +982,24 @@ SHARPDICOM_API int jls_decode(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+SHARPDICOM_API int jls_decode_display(
+    const uint8_t* input,
+    size_t input_len,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len,
+    jls_decode_params_t* params)
+{
+    (void)input;
+    (void)input_len;
+    (void)display;
+    (void)output;
+    (void)output_len;
+    (void)params;
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
 SHARPDICOM_API int jls_get_encode_bound(
     const jls_encode_params_t* params,
     size_t* max_size)
@@ -587,6 +1028,96 @@ SHARPDICOM_API int jls_encode(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+SHARPDICOM_API int jls_decoder_create(jls_decoder_t** decoder_out) {
+    if (decoder_out != NULL) {
+        *decoder_out = NULL;
+    }
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int jls_decoder_read_header(
+    jls_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* output_size,
+    jls_decode_params_t* params)
+{
+    (void)decoder;
+    (void)input;
+    (void)input_len;
+    (void)output_size;
+    (void)params;
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int jls_decoder_decode(
+    jls_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len)
+{
+    (void)decoder;
+    (void)output;
+    (void)output_len;
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int jls_decoder_decode_frame(
+    jls_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t** output,
+    size_t* output_len,
+    jls_decode_params_t* params)
+{
+    (void)decoder;
+    (void)input;
+    (void)input_len;
+    (void)output;
+    (void)output_len;
+    (void)params;
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void jls_decoder_destroy(jls_decoder_t* decoder) {
+    (void)decoder;
+}
+
+SHARPDICOM_API int jls_encoder_create(jls_encoder_t** encoder_out) {
+    if (encoder_out != NULL) {
+        *encoder_out = NULL;
+    }
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int jls_encoder_encode(
+    jls_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const jls_encode_params_t* params)
+{
+    (void)encoder;
+    (void)input;
+    (void)input_len;
+    (void)output;
+    (void)output_len;
+    (void)actual_size;
+    (void)params;
+    set_error("JPEG-LS support not available (CharLS not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void jls_encoder_destroy(jls_encoder_t* encoder) {
+    (void)encoder;
+}
+
 SHARPDICOM_API void jls_free(void* buffer) {
     if (buffer != NULL) {
         free(buffer);
@@ -4,13 +4,15 @@
  * Provides JPEG-LS lossless and near-lossless encoding/decoding
  * using the CharLS library (ISO 14495-1).
  *
- * Thread Safety: All functions are thread-safe.
+ * Thread Safety: All functions are thread-safe. A jls_decoder_t or
+ * jls_encoder_t handle must only be used by one thread at a time.
  */
 
 #ifndef JLS_WRAPPER_H
 #define JLS_WRAPPER_H
 
 #include "sharpdicom_codecs.h"
+#include "display.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +59,16 @@ typedef struct {
     int interleave_mode;    /* JLS_INTERLEAVE_* value for output */
 } jls_encode_params_t;
 
+/*============================================================================
+ * JPEG-LS codec handles
+ *============================================================================*/
+
+/** Opaque reusable decoder for a sequence of frames */
+typedef struct jls_decoder jls_decoder_t;
+
+/** Opaque reusable encoder for a sequence of frames */
+typedef struct jls_encoder jls_encoder_t;
+
 /*============================================================================
  * JPEG-LS API functions
  *============================================================================*/
@@ -88,6 +100,32 @@ SHARPDICOM_API int jls_decode(
     jls_decode_params_t* params
 );
 
+/**
+ * Decodes JPEG-LS compressed data straight to 8-bit display pixels.
+ *
+ * The frame is decoded into an internal buffer and mapped through the display
+ * transform into output in one pass. Output takes one byte per sample, in the
+ * sample order jls_decode() would produce.
+ *
+ * @param input         Pointer to JPEG-LS compressed data
+ * @param input_len     Length of compressed data in bytes
+ * @param display       Stored value to display value transform (is_signed names the
+ *                      sample representation, which JPEG-LS does not record)
+ * @param output        Pointer to output buffer for display pixels
+ * @param output_len    Size of output buffer (width * height * components bytes)
+ * @param params        Pointer to receive image parameters (may be NULL)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code as jls_decode()
+ */
+SHARPDICOM_API int jls_decode_display(
+    const uint8_t* input,
+    size_t input_len,
+    const display_params_t* display,
+    uint8_t* output,
+    size_t output_len,
+    jls_decode_params_t* params
+);
+
 /**
  * Gets the required output buffer size for decoding.
  *
@@ -151,11 +189,155 @@ SHARPDICOM_API int jls_get_encode_bound(
     size_t* max_size
 );
 
+/*============================================================================
+ * JPEG-LS decoder handle API
+ *
+ * Parses each frame header once: jls_decoder_read_header() reports the size
+ * and jls_decoder_decode() continues from the parsed header, or
+ * jls_decoder_decode_frame() does both in one call.
+ *============================================================================*/
+
+/**
+ * Creates a reusable JPEG-LS decoder.
+ *
+ * @param decoder_out   Pointer to receive decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int jls_decoder_create(jls_decoder_t** decoder_out);
+
+/**
+ * Reads the headers of a frame and keeps it pending for jls_decoder_decode().
+ *
+ * Replaces any frame still pending. The input buffer must remain valid
+ * until the frame is decoded or replaced.
+ *
+ * @param decoder       Decoder handle
+ * @param input         Pointer to JPEG-LS compressed data
+ * @param input_len     Length of compressed data in bytes
+ * @param output_size   Pointer to receive required output buffer size (may be NULL)
+ * @param params        Pointer to receive image parameters (may be NULL)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL decoder or input
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Invalid JPEG-LS stream
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int jls_decoder_read_header(
+    jls_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    size_t* output_size,
+    jls_decode_params_t* params
+);
+
+/**
+ * Decodes the frame pending from jls_decoder_read_header().
+ *
+ * If the buffer is too small the frame stays pending and the call can be
+ * retried with a larger one; otherwise the frame is consumed.
+ *
+ * @param decoder       Decoder handle
+ * @param output        Pointer to output buffer for decoded pixels
+ * @param output_len    Size of output buffer in bytes
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: No pending frame, NULL or too small output
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Invalid JPEG-LS stream
+ *         - SHARPDICOM_ERR_DECODE_FAILED: Decode operation failed
+ */
+SHARPDICOM_API int jls_decoder_decode(
+    jls_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len
+);
+
+/**
+ * Reads the headers and decodes a frame in one pass.
+ *
+ * If *output is NULL a buffer of the exact size is allocated and must be
+ * freed with jls_free(); otherwise *output and *output_len describe a
+ * caller buffer that is checked against the frame size. On success
+ * *output_len is set to the decoded size.
+ *
+ * @param decoder       Decoder handle
+ * @param input         Pointer to JPEG-LS compressed data
+ * @param input_len     Length of compressed data in bytes
+ * @param output        In/out: output buffer, or NULL to allocate one
+ * @param output_len    In/out: output buffer size, then decoded size
+ * @param params        Pointer to receive image parameters (may be NULL)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL arguments or buffer too small
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Invalid JPEG-LS stream
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ *         - SHARPDICOM_ERR_DECODE_FAILED: Decode operation failed
+ */
+SHARPDICOM_API int jls_decoder_decode_frame(
+    jls_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t** output,
+    size_t* output_len,
+    jls_decode_params_t* params
+);
+
+/**
+ * Destroys a decoder handle.
+ *
+ * @param decoder       Decoder handle (may be NULL)
+ */
+SHARPDICOM_API void jls_decoder_destroy(jls_decoder_t* decoder);
+
+/*============================================================================
+ * JPEG-LS encoder handle API
+ *============================================================================*/
+
+/**
+ * Creates a reusable JPEG-LS encoder.
+ *
+ * @param encoder_out   Pointer to receive encoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int jls_encoder_create(jls_encoder_t** encoder_out);
+
+/**
+ * Encodes a frame; same contract as jls_encode().
+ *
+ * Consecutive frames encoded into the same output buffer reuse the
+ * underlying CharLS encoder.
+ *
+ * @param encoder       Encoder handle
+ * @param input         Pointer to raw pixel data
+ * @param input_len     Length of input data in bytes
+ * @param output        Pointer to output buffer for compressed data
+ * @param output_len    Size of output buffer in bytes
+ * @param actual_size   Pointer to receive actual encoded size
+ * @param params        Encoding parameters
+ *
+ * @return SHARPDICOM_OK on success, or negative error code (see jls_encode())
+ */
+SHARPDICOM_API int jls_encoder_encode(
+    jls_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const jls_encode_params_t* params
+);
+
 /**
- * Frees a buffer allocated by the JPEG-LS wrapper.
+ * Destroys an encoder handle.
  *
- * Currently unused as all functions use caller-provided buffers,
- * but provided for future streaming API compatibility.
+ * @param encoder       Encoder handle (may be NULL)
+ */
+SHARPDICOM_API void jls_encoder_destroy(jls_encoder_t* encoder);
+
+/**
+ * Frees a buffer allocated by the JPEG-LS wrapper
+ * (output of jls_decoder_decode_frame()).
  *
  * @param buffer        Pointer to buffer to free (may be NULL)
  */
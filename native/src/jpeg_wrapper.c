@@ -7,12 +7,15 @@
 
 #include "jpeg_wrapper.h"
 #include "sharpdicom_codecs.h"
+#include "codec_stats.h"
 
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 
-/* Forward declaration of set_error from sharpdicom_codecs.c */
+/* Forward declarations from sharpdicom_codecs.c */
 extern void set_error(const char* message);
+extern void set_error_fmt(const char* fmt, ...);
 
 #ifdef SHARPDICOM_WITH_JPEG
 
@@ -91,6 +94,28 @@ extern const char* tjGetErrorStr2(tjhandle handle);
 extern int tjPixelSize[];
 extern unsigned long tjBufSize(int width, int height, int jpegSubsamp);
 
+/** TurboJPEG 3 partial decompression (libjpeg-turbo 3.0+) */
+typedef struct {
+    int num;            /**< Numerator */
+    int denom;          /**< Denominator */
+} tjscalingfactor;
+
+typedef struct {
+    int x;              /**< Left boundary (multiple of the scaled iMCU width) */
+    int y;              /**< Top boundary */
+    int w;              /**< Width */
+    int h;              /**< Height */
+} tjregion;
+
+#define TJSCALED(dimension, scalingFactor) \
+    (((dimension) * (scalingFactor).num + (scalingFactor).denom - 1) / (scalingFactor).denom)
+
+extern int tj3SetScalingFactor(tjhandle handle, tjscalingfactor scalingFactor);
+extern int tj3SetCroppingRegion(tjhandle handle, tjregion croppingRegion);
+extern int tj3Decompress8(tjhandle handle,
+    const unsigned char* jpegBuf, size_t jpegSize,
+    unsigned char* dstBuf, int pitch, int pixelFormat);
+
 #endif /* TURBOJPEG_H */
 
 /*============================================================================
@@ -173,6 +198,120 @@ static int get_pixel_format(int colorspace, int components) {
     }
 }
 
+/**
+ * Output pixel format of a decode; updates components from the JPEG's
+ * count to the decoded count.
+ */
+static int decode_pixel_format(int colorspace, int* components) {
+    if (colorspace == JPEG_CS_GRAY) {
+        *components = 1;
+        return TJPF_GRAY;
+    }
+    if ((colorspace == JPEG_CS_RGB || colorspace == JPEG_CS_UNKNOWN) && *components == 1) {
+        /* Keep grayscale as-is */
+        return TJPF_GRAY;
+    }
+    *components = 3;
+    return TJPF_RGB;
+}
+
+/** Scaled iMCU width per TJSAMP value (tjMCUWidth in turbojpeg.h) */
+static const int mcu_width[] = { 8, 16, 16, 8, 8, 32, 8 };
+
+/** Geometry of a scaled/cropped decode */
+typedef struct {
+    tjscalingfactor scale;
+    int width;          /* Requested (output) width */
+    int height;         /* Requested (output) height */
+    int cropX;          /* Requested left edge in scaled pixels */
+    int alignedX;       /* cropX rounded down to the scaled iMCU width */
+    int alignedWidth;   /* width + cropX - alignedX */
+    int cropY;
+    int cropped;        /* Whether a cropping region is set at all */
+    int components;     /* Components in the JPEG */
+} scaled_region;
+
+/**
+ * Read the header into the thread's handle and resolve the scale and crop.
+ * Leaves the scaling factor set on the handle.
+ */
+static int resolve_scaled_region(
+    const char* func, tjhandle handle,
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    scaled_region* region)
+{
+    int w, h, tjSubsamp, tjColorspace;
+    if (tjDecompressHeader3(handle, input, (unsigned long)inputLen,
+                            &w, &h, &tjSubsamp, &tjColorspace) != 0) {
+        const char* err = tjGetErrorStr2(handle);
+        set_error(err ? err : "failed to read JPEG header");
+        return JPEG_ERR_INVALID_HEADER;
+    }
+
+    memset(region, 0, sizeof(*region));
+    region->scale.num = 1;
+    region->scale.denom = 1;
+    if (options != NULL && (options->scaleNum != 0 || options->scaleDenom != 0)) {
+        region->scale.num = options->scaleNum;
+        region->scale.denom = options->scaleDenom;
+    }
+    if (region->scale.num <= 0 || region->scale.denom <= 0 ||
+        tj3SetScalingFactor(handle, region->scale) != 0) {
+        set_error_fmt("%s: unsupported scaling factor %d/%d", func,
+                      region->scale.num, region->scale.denom);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int scaledWidth = TJSCALED(w, region->scale);
+    int scaledHeight = TJSCALED(h, region->scale);
+
+    int x = 0, y = 0, cw = 0, ch = 0;
+    if (options != NULL) {
+        x = options->cropX;
+        y = options->cropY;
+        cw = options->cropWidth;
+        ch = options->cropHeight;
+    }
+    if (x < 0 || y < 0 || cw < 0 || ch < 0 || x >= scaledWidth || y >= scaledHeight) {
+        set_error_fmt("%s: crop origin outside the %dx%d scaled image", func, scaledWidth, scaledHeight);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (cw == 0) cw = scaledWidth - x;
+    if (ch == 0) ch = scaledHeight - y;
+    if (cw > scaledWidth - x || ch > scaledHeight - y) {
+        set_error_fmt("%s: crop exceeds the %dx%d scaled image", func, scaledWidth, scaledHeight);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int mcu = (tjSubsamp >= 0 && tjSubsamp < (int)(sizeof(mcu_width) / sizeof(mcu_width[0])))
+              ? mcu_width[tjSubsamp] : 8;
+    int scaledMcu = TJSCALED(mcu, region->scale);
+    if (scaledMcu < 1) scaledMcu = 1;
+
+    region->width = cw;
+    region->height = ch;
+    region->cropX = x;
+    region->alignedX = x - x % scaledMcu;
+    region->alignedWidth = cw + (x - region->alignedX);
+    region->cropY = y;
+    region->cropped = (x != 0 || y != 0 || cw != scaledWidth || ch != scaledHeight);
+
+    switch (tjColorspace) {
+        case TJCS_GRAY:
+            region->components = 1;
+            break;
+        case TJCS_CMYK:
+        case TJCS_YCCK:
+            region->components = 4;
+            break;
+        default:
+            region->components = 3;
+            break;
+    }
+    return SHARPDICOM_OK;
+}
+
 /*============================================================================
  * 8-bit JPEG functions
  *============================================================================*/
@@ -270,21 +409,7 @@ int jpeg_decode(
     }
 
     /* Determine output pixel format and components */
-    if (colorspace == JPEG_CS_GRAY) {
-        pixelFormat = TJPF_GRAY;
-        comps = 1;
-    } else if (colorspace == JPEG_CS_RGB || colorspace == JPEG_CS_UNKNOWN) {
-        pixelFormat = TJPF_RGB;
-        if (comps == 1) {
-            /* Keep grayscale as-is */
-            pixelFormat = TJPF_GRAY;
-        } else {
-            comps = 3;
-        }
-    } else {
-        pixelFormat = TJPF_RGB;
-        comps = 3;
-    }
+    pixelFormat = decode_pixel_format(colorspace, &comps);
 
     /* Check output buffer size (with overflow protection) */
     requiredSize = safe_mul3_size((size_t)w, (size_t)h, (size_t)comps);
@@ -296,12 +421,17 @@ int jpeg_decode(
     /* Decode with accurate DCT for medical imaging quality */
     flags = TJFLAG_ACCURATEDCT;
 
+    int64_t start = codec_stats_start();
     if (tjDecompress2(handle, input, (unsigned long)inputLen,
                       output, w, 0, h, pixelFormat, flags) != 0) {
         const char* err = tjGetErrorStr2(handle);
         set_error(err ? err : "jpeg_decode: decompression failed");
+        codec_stats_record(SHARPDICOM_STATS_JPEG, CODEC_STATS_DECODE, start,
+                           (size_t)inputLen, 0, SHARPDICOM_ERR_DECODE_FAILED);
         return SHARPDICOM_ERR_DECODE_FAILED;
     }
+    codec_stats_record(SHARPDICOM_STATS_JPEG, CODEC_STATS_DECODE, start,
+                       (size_t)inputLen, requiredSize, SHARPDICOM_OK);
 
     /* Return dimensions */
     if (width != NULL) *width = w;
@@ -311,69 +441,213 @@ int jpeg_decode(
     return SHARPDICOM_OK;
 }
 
-int jpeg_encode(
-    const uint8_t* input, int width, int height, int components,
-    uint8_t** output, int* outputLen,
-    int quality, int subsamp)
+/** Validate encode arguments shared by jpeg_encode() and jpeg_encode_to_buffer() */
+static int validate_encode(
+    const char* func, const uint8_t* input, int width, int height, int components, int quality)
 {
-    tjhandle handle;
-    int pixelFormat;
-    int tjSubsamp;
-    unsigned char* jpegBuf = NULL;
-    unsigned long jpegSize = 0;
-    int flags;
-
-    /* Validate arguments */
     if (input == NULL) {
-        set_error("jpeg_encode: input cannot be NULL");
+        set_error_fmt("%s: input cannot be NULL", func);
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
     if (width <= 0 || height <= 0) {
-        set_error("jpeg_encode: invalid dimensions");
+        set_error_fmt("%s: invalid dimensions", func);
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
     if (components != 1 && components != 3) {
-        set_error("jpeg_encode: components must be 1 (grayscale) or 3 (RGB)");
+        set_error_fmt("%s: components must be 1 (grayscale) or 3 (RGB)", func);
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
-    if (output == NULL || outputLen == NULL) {
-        set_error("jpeg_encode: output parameters cannot be NULL");
+    if (quality < 1 || quality > 100) {
+        set_error_fmt("%s: quality must be 1-100", func);
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
-    if (quality < 1 || quality > 100) {
-        set_error("jpeg_encode: quality must be 1-100");
+    return SHARPDICOM_OK;
+}
+
+/** TurboJPEG subsampling for an encode (grayscale always uses TJSAMP_GRAY) */
+static int encode_subsamp(int components, int subsamp) {
+    return (components == 1) ? TJSAMP_GRAY : map_subsamp_to_tj(subsamp);
+}
+
+/** Compress with the thread's handle; jpegBuf/jpegSize follow tjCompress2() */
+static int compress_frame(
+    const char* func, const uint8_t* input, int width, int height, int components,
+    unsigned char** jpegBuf, unsigned long* jpegSize,
+    int quality, int subsamp, int flags)
+{
+    tjhandle handle = get_compress_handle();
+    if (handle == NULL) {
+        set_error_fmt("%s: failed to initialize compressor", func);
+        return SHARPDICOM_ERR_INTERNAL;
+    }
+
+    int pixelFormat = (components == 1) ? TJPF_GRAY : TJPF_RGB;
+
+    /* Use accurate DCT for medical imaging */
+    flags |= TJFLAG_ACCURATEDCT;
+
+    size_t rawSize = (size_t)width * (size_t)height * (size_t)components;
+    int64_t start = codec_stats_start();
+    if (tjCompress2(handle, input, width, 0, height, pixelFormat,
+                    jpegBuf, jpegSize, encode_subsamp(components, subsamp), quality, flags) != 0) {
+        const char* err = tjGetErrorStr2(handle);
+        if (err) {
+            set_error(err);
+        } else {
+            set_error_fmt("%s: compression failed", func);
+        }
+        codec_stats_record(SHARPDICOM_STATS_JPEG, CODEC_STATS_ENCODE, start,
+                           rawSize, 0, SHARPDICOM_ERR_ENCODE_FAILED);
+        return SHARPDICOM_ERR_ENCODE_FAILED;
+    }
+    codec_stats_record(SHARPDICOM_STATS_JPEG, CODEC_STATS_ENCODE, start,
+                       rawSize, (size_t)*jpegSize, SHARPDICOM_OK);
+    return SHARPDICOM_OK;
+}
+
+int jpeg_decode_header_scaled(
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    int* width, int* height, int* components, int* bufferSize)
+{
+    if (input == NULL || inputLen <= 0) {
+        set_error("jpeg_decode_header_scaled: invalid input");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (width == NULL || height == NULL || components == NULL) {
+        set_error("jpeg_decode_header_scaled: output parameters cannot be NULL");
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    /* Get handle */
-    handle = get_compress_handle();
+    tjhandle handle = get_decompress_handle();
     if (handle == NULL) {
-        set_error("jpeg_encode: failed to initialize compressor");
+        set_error("jpeg_decode_header_scaled: failed to initialize decompressor");
         return SHARPDICOM_ERR_INTERNAL;
     }
 
-    /* Determine pixel format */
-    pixelFormat = (components == 1) ? TJPF_GRAY : TJPF_RGB;
+    scaled_region region;
+    int status = resolve_scaled_region("jpeg_decode_header_scaled", handle,
+                                       input, inputLen, options, &region);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
 
-    /* Map subsampling */
-    if (components == 1) {
-        tjSubsamp = TJSAMP_GRAY;
-    } else {
-        tjSubsamp = map_subsamp_to_tj(subsamp);
+    if (bufferSize != NULL) {
+        size_t size = safe_mul3_size((size_t)region.alignedWidth, (size_t)region.height,
+                                     (size_t)region.components);
+        if (size == 0 || size > INT_MAX) {
+            set_error("jpeg_decode_header_scaled: dimensions too large");
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+        *bufferSize = (int)size;
     }
+    *width = region.width;
+    *height = region.height;
+    *components = region.components;
+    return SHARPDICOM_OK;
+}
 
-    /* Use accurate DCT for medical imaging */
-    flags = TJFLAG_ACCURATEDCT;
+int jpeg_decode_scaled(
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    uint8_t* output, int outputLen,
+    int* width, int* height, int* components,
+    int colorspace)
+{
+    if (input == NULL || inputLen <= 0) {
+        set_error("jpeg_decode_scaled: invalid input");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (output == NULL || outputLen <= 0) {
+        set_error("jpeg_decode_scaled: invalid output buffer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
 
-    /* Compress - TurboJPEG allocates the buffer */
-    if (tjCompress2(handle, input, width, 0, height, pixelFormat,
-                    &jpegBuf, &jpegSize, tjSubsamp, quality, flags) != 0) {
+    tjhandle handle = get_decompress_handle();
+    if (handle == NULL) {
+        set_error("jpeg_decode_scaled: failed to initialize decompressor");
+        return SHARPDICOM_ERR_INTERNAL;
+    }
+
+    scaled_region region;
+    int status = resolve_scaled_region("jpeg_decode_scaled", handle,
+                                       input, inputLen, options, &region);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    int comps = region.components;
+    int pixelFormat = decode_pixel_format(colorspace, &comps);
+
+    /* Rows are decoded alignedWidth wide, then packed to width */
+    size_t alignedRow = (size_t)region.alignedWidth * (size_t)comps;
+    size_t requiredSize = safe_mul_size(alignedRow, (size_t)region.height);
+    if (requiredSize == 0 || (size_t)outputLen < requiredSize || alignedRow > INT_MAX) {
+        set_error("jpeg_decode_scaled: output buffer too small or dimensions too large");
+        return JPEG_ERR_OUTPUT_TOO_SMALL;
+    }
+
+    int64_t start = codec_stats_start();
+    tjregion crop = { 0, 0, 0, 0 };
+    if (region.cropped) {
+        crop.x = region.alignedX;
+        crop.y = region.cropY;
+        crop.w = region.alignedWidth;
+        crop.h = region.height;
+    }
+    if (tj3SetCroppingRegion(handle, crop) != 0 ||
+        tj3Decompress8(handle, input, (size_t)inputLen, output, (int)alignedRow, pixelFormat) != 0) {
         const char* err = tjGetErrorStr2(handle);
-        set_error(err ? err : "jpeg_encode: compression failed");
+        set_error(err ? err : "jpeg_decode_scaled: decompression failed");
+        tj3SetCroppingRegion(handle, (tjregion){ 0, 0, 0, 0 });
+        codec_stats_record(SHARPDICOM_STATS_JPEG, CODEC_STATS_DECODE, start,
+                           (size_t)inputLen, 0, SHARPDICOM_ERR_DECODE_FAILED);
+        return SHARPDICOM_ERR_DECODE_FAILED;
+    }
+    tj3SetCroppingRegion(handle, (tjregion){ 0, 0, 0, 0 });
+
+    if (region.alignedX != region.cropX) {
+        /* Drop the columns left of cropX; rows only move towards the start */
+        size_t skip = (size_t)(region.cropX - region.alignedX) * (size_t)comps;
+        size_t row = (size_t)region.width * (size_t)comps;
+        for (int y = 0; y < region.height; y++) {
+            memmove(output + (size_t)y * row, output + (size_t)y * alignedRow + skip, row);
+        }
+    }
+    codec_stats_record(SHARPDICOM_STATS_JPEG, CODEC_STATS_DECODE, start, (size_t)inputLen,
+                       (size_t)region.width * (size_t)comps * (size_t)region.height, SHARPDICOM_OK);
+
+    if (width != NULL) *width = region.width;
+    if (height != NULL) *height = region.height;
+    if (components != NULL) *components = comps;
+    return SHARPDICOM_OK;
+}
+
+int jpeg_encode(
+    const uint8_t* input, int width, int height, int components,
+    uint8_t** output, int* outputLen,
+    int quality, int subsamp)
+{
+    unsigned char* jpegBuf = NULL;
+    unsigned long jpegSize = 0;
+
+    int status = validate_encode("jpeg_encode", input, width, height, components, quality);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    if (output == NULL || outputLen == NULL) {
+        set_error("jpeg_encode: output parameters cannot be NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Compress - TurboJPEG allocates the buffer */
+    status = compress_frame("jpeg_encode", input, width, height, components,
+                            &jpegBuf, &jpegSize, quality, subsamp, 0);
+    if (status != SHARPDICOM_OK) {
         if (jpegBuf != NULL) {
             tjFree(jpegBuf);
         }
-        return SHARPDICOM_ERR_ENCODE_FAILED;
+        return status;
     }
 
     *output = jpegBuf;
@@ -382,6 +656,66 @@ int jpeg_encode(
     return SHARPDICOM_OK;
 }
 
+int jpeg_get_encode_bound(
+    int width, int height, int components, int subsamp,
+    int* maxSize)
+{
+    if (maxSize == NULL || width <= 0 || height <= 0 || (components != 1 && components != 3)) {
+        set_error("jpeg_get_encode_bound: invalid arguments");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    unsigned long bound = tjBufSize(width, height, encode_subsamp(components, subsamp));
+    if (bound == (unsigned long)-1 || bound > (unsigned long)INT_MAX) {
+        set_error("jpeg_get_encode_bound: image too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *maxSize = (int)bound;
+    return SHARPDICOM_OK;
+}
+
+int jpeg_encode_to_buffer(
+    const uint8_t* input, int width, int height, int components,
+    uint8_t* output, int outputLen, int* actualSize,
+    int quality, int subsamp)
+{
+    int status = validate_encode("jpeg_encode_to_buffer", input, width, height, components, quality);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    if (output == NULL || actualSize == NULL) {
+        set_error("jpeg_encode_to_buffer: output parameters cannot be NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /*
+     * With TJFLAG_NOREALLOC TurboJPEG assumes the buffer holds tjBufSize()
+     * bytes and never checks outputLen, so a smaller buffer must be refused.
+     */
+    int bound = 0;
+    status = jpeg_get_encode_bound(width, height, components, subsamp, &bound);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    if (outputLen < bound) {
+        set_error_fmt("jpeg_encode_to_buffer: output buffer too small (%d bytes, need %d)",
+                      outputLen, bound);
+        return JPEG_ERR_OUTPUT_TOO_SMALL;
+    }
+
+    unsigned char* jpegBuf = output;
+    unsigned long jpegSize = (unsigned long)outputLen;
+    status = compress_frame("jpeg_encode_to_buffer", input, width, height, components,
+                            &jpegBuf, &jpegSize, quality, subsamp, TJFLAG_NOREALLOC);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    *actualSize = (int)jpegSize;
+    return SHARPDICOM_OK;
+}
+
 void jpeg_free(uint8_t* buffer) {
     if (buffer != NULL) {
         tjFree(buffer);
@@ -477,6 +811,29 @@ int jpeg_encode_12bit(
 #endif
 }
 
+int jpeg_encode_12bit_to_buffer(
+    const uint16_t* input, int width, int height, int components,
+    uint8_t* output, int outputLen, int* actualSize,
+    int quality)
+{
+    /* Same constraint as jpeg_encode_12bit(): needs a 12-bit libjpeg-turbo build */
+    (void)input;
+    (void)width;
+    (void)height;
+    (void)components;
+    (void)output;
+    (void)outputLen;
+    (void)actualSize;
+    (void)quality;
+
+#if JPEG_12BIT_AVAILABLE
+    set_error("jpeg_encode_12bit_to_buffer: 12-bit JPEG requires special libjpeg-turbo build");
+#else
+    set_error("jpeg_encode_12bit_to_buffer: 12-bit JPEG support not available (library built without -DWITH_12BIT)");
+#endif
+    return JPEG_ERR_12BIT_NOT_SUPPORTED;
+}
+
 #else /* SHARPDICOM_WITH_JPEG not defined */
 
 /*============================================================================
@@ -515,6 +872,42 @@ int jpeg_decode_header(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+int jpeg_decode_header_scaled(
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    int* width, int* height, int* components, int* bufferSize)
+{
+    (void)input;
+    (void)inputLen;
+    (void)options;
+    (void)width;
+    (void)height;
+    (void)components;
+    (void)bufferSize;
+    set_error("JPEG support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+int jpeg_decode_scaled(
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    uint8_t* output, int outputLen,
+    int* width, int* height, int* components,
+    int colorspace)
+{
+    (void)input;
+    (void)inputLen;
+    (void)options;
+    (void)output;
+    (void)outputLen;
+    (void)width;
+    (void)height;
+    (void)components;
+    (void)colorspace;
+    set_error("JPEG support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
 int jpeg_encode(
     const uint8_t* input, int width, int height, int components,
     uint8_t** output, int* outputLen,
@@ -532,6 +925,37 @@ int jpeg_encode(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+int jpeg_get_encode_bound(
+    int width, int height, int components, int subsamp,
+    int* maxSize)
+{
+    (void)width;
+    (void)height;
+    (void)components;
+    (void)subsamp;
+    (void)maxSize;
+    set_error("JPEG support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+int jpeg_encode_to_buffer(
+    const uint8_t* input, int width, int height, int components,
+    uint8_t* output, int outputLen, int* actualSize,
+    int quality, int subsamp)
+{
+    (void)input;
+    (void)width;
+    (void)height;
+    (void)components;
+    (void)output;
+    (void)outputLen;
+    (void)actualSize;
+    (void)quality;
+    (void)subsamp;
+    set_error("JPEG support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
 void jpeg_free(uint8_t* buffer)
 {
     (void)buffer;
@@ -569,6 +993,23 @@ int jpeg_encode_12bit(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+int jpeg_encode_12bit_to_buffer(
+    const uint16_t* input, int width, int height, int components,
+    uint8_t* output, int outputLen, int* actualSize,
+    int quality)
+{
+    (void)input;
+    (void)width;
+    (void)height;
+    (void)components;
+    (void)output;
+    (void)outputLen;
+    (void)actualSize;
+    (void)quality;
+    set_error("JPEG support not compiled in");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
 int jpeg_has_12bit_support(void)
 {
     return 0;
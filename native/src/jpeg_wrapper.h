@@ -47,6 +47,29 @@ typedef enum {
     JPEG_SAMP_411 = 5     /**< 4:1:1 (rare in JPEG) */
 } JpegSubsampling;
 
+/*============================================================================
+ * Scaled/cropped decode options
+ *============================================================================*/
+
+/**
+ * Scaling and cropping for jpeg_decode_scaled().
+ *
+ * Scaling happens in the DCT domain, so a 1/8 decode does roughly 1/64 of
+ * the IDCT and color conversion work. libjpeg-turbo supports M/8 for M in
+ * 1..16 (1/2, 1/4 and 1/8 are exact for any image).
+ *
+ * The crop rectangle is in scaled pixels. Only the rows and iMCU columns it
+ * touches are decoded.
+ */
+typedef struct {
+    int scaleNum;       /**< Scale numerator (0 = no scaling) */
+    int scaleDenom;     /**< Scale denominator (0 = no scaling) */
+    int cropX;          /**< Left edge of the crop in scaled pixels */
+    int cropY;          /**< Top edge of the crop in scaled pixels */
+    int cropWidth;      /**< Crop width (0 = to the right edge) */
+    int cropHeight;     /**< Crop height (0 = to the bottom edge) */
+} JpegDecodeOptions;
+
 /*============================================================================
  * Error codes (in addition to sharpdicom_codecs.h codes)
  *============================================================================*/
@@ -99,6 +122,51 @@ int jpeg_decode_header(
     const uint8_t* input, int inputLen,
     int* width, int* height, int* components, int* subsampling);
 
+/**
+ * Read JPEG header and report the dimensions of a scaled/cropped decode.
+ *
+ * @param input         Compressed JPEG data
+ * @param inputLen      Length of input in bytes
+ * @param options       Scale and crop (NULL = full size)
+ * @param width         [out] Decoded width in pixels
+ * @param height        [out] Decoded height in pixels
+ * @param components    [out] Number of color components in the JPEG (1=gray, 3=RGB, 4=CMYK)
+ * @param bufferSize    [out] Output buffer size jpeg_decode_scaled() needs for any colorspace (may be NULL)
+ *
+ * @return 0 on success, negative error code on failure
+ *
+ * bufferSize can exceed width * height * components: the decode starts at
+ * the iMCU column left of cropX and the extra columns are removed in place.
+ */
+int jpeg_decode_header_scaled(
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    int* width, int* height, int* components, int* bufferSize);
+
+/**
+ * Decode a JPEG image at reduced size and/or to a crop rectangle.
+ *
+ * @param input         Compressed JPEG data
+ * @param inputLen      Length of input in bytes
+ * @param options       Scale and crop (NULL = same as jpeg_decode())
+ * @param output        Output buffer (at least bufferSize from jpeg_decode_header_scaled())
+ * @param outputLen     Size of output buffer in bytes
+ * @param width         [out] Decoded width in pixels
+ * @param height        [out] Decoded height in pixels
+ * @param components    [out] Number of color components (1=gray, 3=RGB)
+ * @param colorspace    Desired output colorspace (as for jpeg_decode())
+ *
+ * @return 0 on success, negative error code on failure
+ *
+ * Output rows are packed: width * components bytes each.
+ */
+int jpeg_decode_scaled(
+    const uint8_t* input, int inputLen,
+    const JpegDecodeOptions* options,
+    uint8_t* output, int outputLen,
+    int* width, int* height, int* components,
+    int colorspace);
+
 /**
  * Encode raw pixel data to JPEG.
  *
@@ -120,6 +188,46 @@ int jpeg_encode(
     uint8_t** output, int* outputLen,
     int quality, int subsamp);
 
+/**
+ * Get the maximum compressed size for an image (wraps tjBufSize).
+ *
+ * @param width         Image width in pixels
+ * @param height        Image height in pixels
+ * @param components    Number of color components (1=gray, 3=RGB)
+ * @param subsamp       Chroma subsampling (ignored for grayscale)
+ * @param maxSize       [out] Worst-case compressed size in bytes
+ *
+ * @return 0 on success, negative error code on failure
+ */
+int jpeg_get_encode_bound(
+    int width, int height, int components, int subsamp,
+    int* maxSize);
+
+/**
+ * Encode raw pixel data to JPEG into a caller-provided buffer.
+ *
+ * Same as jpeg_encode(), but nothing is allocated: the buffer must hold at
+ * least jpeg_get_encode_bound() bytes for the same image, since
+ * libjpeg-turbo may fill up to that size before the final length is known.
+ *
+ * @param input         Raw pixel data (RGB or grayscale)
+ * @param width         Image width in pixels
+ * @param height        Image height in pixels
+ * @param components    Number of color components (1=gray, 3=RGB)
+ * @param output        Output buffer for compressed data
+ * @param outputLen     Size of output buffer in bytes
+ * @param actualSize    [out] Length of compressed data
+ * @param quality       JPEG quality (1-100, 90 recommended for medical)
+ * @param subsamp       Chroma subsampling (JPEG_SAMP_444 recommended for medical)
+ *
+ * @return 0 on success, JPEG_ERR_OUTPUT_TOO_SMALL if outputLen is below the
+ *         bound, or other negative error code on failure
+ */
+int jpeg_encode_to_buffer(
+    const uint8_t* input, int width, int height, int components,
+    uint8_t* output, int outputLen, int* actualSize,
+    int quality, int subsamp);
+
 /**
  * Free a buffer allocated by jpeg_encode().
  *
@@ -172,6 +280,26 @@ int jpeg_encode_12bit(
     uint8_t** output, int* outputLen,
     int quality);
 
+/**
+ * Encode 12-bit pixel data to JPEG into a caller-provided buffer.
+ *
+ * @param input         16-bit pixel data (12-bit values in uint16_t)
+ * @param width         Image width in pixels
+ * @param height        Image height in pixels
+ * @param components    Number of color components (typically 1 for grayscale)
+ * @param output        Output buffer (at least jpeg_get_encode_bound() bytes)
+ * @param outputLen     Size of output buffer in bytes
+ * @param actualSize    [out] Length of compressed data
+ * @param quality       JPEG quality (1-100)
+ *
+ * @return 0 on success, JPEG_ERR_12BIT_NOT_SUPPORTED if library lacks 12-bit support,
+ *         or other negative error code on failure
+ */
+int jpeg_encode_12bit_to_buffer(
+    const uint16_t* input, int width, int height, int components,
+    uint8_t* output, int outputLen, int* actualSize,
+    int quality);
+
 /*============================================================================
  * Utility functions
  *============================================================================*/
@@ -0,0 +1,60 @@
+/**
+ * SharpDicom OpenJPEG Allocation Hooks
+ *
+ * Replaces OpenJPEG's opj_malloc.c, so every allocation the library makes
+ * (code-block buffers, tile data, the opj_image_t component planes) goes
+ * through allocator.c and its per-thread cache. Allocator blocks are
+ * always 32-byte aligned, which covers both opj_aligned_malloc() (16) and
+ * opj_aligned_32_malloc().
+ *
+ * The zero-size behaviour of the originals is kept: a size of 0 returns
+ * NULL without touching the old block.
+ */
+
+#include "allocator.h"
+
+#ifdef SHARPDICOM_HAS_OPENJPEG
+
+#define OPJ_SKIP_POISON
+#include "opj_malloc.h"
+
+void* opj_malloc(size_t size) {
+    if (size == 0U) return NULL;
+    return allocator_alloc(size);
+}
+
+void* opj_calloc(size_t num, size_t size) {
+    if (num == 0U || size == 0U) return NULL;
+    return allocator_calloc(num, size);
+}
+
+void* opj_realloc(void* ptr, size_t size) {
+    if (size == 0U) return NULL;
+    return allocator_realloc(ptr, size);
+}
+
+void opj_free(void* ptr) {
+    allocator_free(ptr);
+}
+
+void* opj_aligned_malloc(size_t size) {
+    return opj_malloc(size);
+}
+
+void* opj_aligned_realloc(void* ptr, size_t size) {
+    return opj_realloc(ptr, size);
+}
+
+void* opj_aligned_32_malloc(size_t size) {
+    return opj_malloc(size);
+}
+
+void* opj_aligned_32_realloc(void* ptr, size_t size) {
+    return opj_realloc(ptr, size);
+}
+
+void opj_aligned_free(void* ptr) {
+    allocator_free(ptr);
+}
+
+#endif /* SHARPDICOM_HAS_OPENJPEG */
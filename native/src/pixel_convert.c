@@ -0,0 +1,983 @@
+/**
+ * SharpDicom Pixel Conversion Kernels Implementation
+ *
+ * Scalar reference loops plus SSE4.1, AVX2 and NEON kernels for the
+ * 1-component and 3-component, 8-bit and 16-bit output cases, and for the
+ * affine display (window) transform.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "pixel_convert.h"
+#include "sharpdicom_codecs.h"
+#include "allocator.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Forward declarations from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+
+/*============================================================================
+ * Platform detection
+ *============================================================================*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SHARPDICOM_ARCH_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SHARPDICOM_ARCH_ARM64 1
+#endif
+
+/**
+ * Row kernel: converts `count` pixels starting at sample `src_offset` of each
+ * plane into one output row.
+ */
+typedef void (*interleave_row_fn)(
+    const int32_t* const* planes,
+    size_t src_offset,
+    const int32_t* offsets,
+    int num_comps,
+    size_t count,
+    uint8_t* dst
+);
+
+/** Display row kernel: same as interleave_row_fn, mapping through a compiled transform */
+typedef void (*display_row_fn)(
+    const int32_t* const* planes,
+    size_t src_offset,
+    int num_comps,
+    size_t count,
+    const pixel_display_map* map,
+    uint8_t* dst
+);
+
+/*============================================================================
+ * Scalar kernels (reference and fallback)
+ *============================================================================*/
+
+static inline uint8_t clamp_u8(int32_t val) {
+    if (val < 0) return 0;
+    if (val > 255) return 255;
+    return (uint8_t)val;
+}
+
+static inline uint16_t clamp_u16(int32_t val) {
+    if (val < 0) return 0;
+    if (val > 65535) return 65535;
+    return (uint16_t)val;
+}
+
+/** Converts pixels [start, count) of a row; used directly and for SIMD tails */
+static void row_tail_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t start, size_t count, uint8_t* dst
+) {
+    for (size_t x = start; x < count; x++) {
+        uint8_t* out = dst + x * (size_t)num_comps;
+        for (int c = 0; c < num_comps; c++) {
+            out[c] = clamp_u8(planes[c][src_offset + x] + offsets[c]);
+        }
+    }
+}
+
+static void row_tail_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t start, size_t count, uint8_t* dst
+) {
+    uint16_t* dst16 = (uint16_t*)dst;
+    for (size_t x = start; x < count; x++) {
+        uint16_t* out = dst16 + x * (size_t)num_comps;
+        for (int c = 0; c < num_comps; c++) {
+            out[c] = clamp_u16(planes[c][src_offset + x] + offsets[c]);
+        }
+    }
+}
+
+static void row_scalar_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    row_tail_u8(planes, src_offset, offsets, num_comps, 0, count, dst);
+}
+
+static void row_scalar_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    row_tail_u16(planes, src_offset, offsets, num_comps, 0, count, dst);
+}
+
+/**
+ * Affine display value, as computed by the SIMD kernels: multiply and add
+ * are separate statements so the compiler does not fuse them.
+ */
+static inline uint8_t display_affine(int32_t val, float scale, float bias) {
+    float f = (float)val * scale;
+    f = f + bias;
+    if (f < 0.0f) f = 0.0f;
+    if (f > 255.0f) f = 255.0f;
+    return (uint8_t)f;
+}
+
+/** Maps pixels [start, count) of a row; used directly and for SIMD tails */
+static void display_tail(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t start, size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    for (size_t x = start; x < count; x++) {
+        uint8_t* out = dst + x * (size_t)num_comps;
+        for (int c = 0; c < num_comps; c++) {
+            out[c] = display_affine(planes[c][src_offset + x], map->scale, map->bias);
+        }
+    }
+}
+
+static void row_display_scalar(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    display_tail(planes, src_offset, num_comps, 0, count, map, dst);
+}
+
+/** Table form; byte gathers gain nothing from SIMD, so this is the only kernel */
+static void row_display_table(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const uint8_t* table = map->table;
+    int32_t first = map->table_first;
+    int32_t last = map->table_last;
+    for (size_t x = 0; x < count; x++) {
+        uint8_t* out = dst + x * (size_t)num_comps;
+        for (int c = 0; c < num_comps; c++) {
+            int32_t val = planes[c][src_offset + x];
+            if (val < first) val = first;
+            if (val > last) val = last;
+            out[c] = table[val - first];
+        }
+    }
+}
+
+/*============================================================================
+ * x86 kernels (SSE4.1 / AVX2)
+ *
+ * Compiled with per-function target attributes so the library itself does
+ * not require either extension; they only run after runtime detection.
+ *============================================================================*/
+
+#if SHARPDICOM_ARCH_X86
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define TARGET_SSE41 __attribute__((target("sse4.1")))
+    #define TARGET_AVX2  __attribute__((target("avx2")))
+#else
+    #define TARGET_SSE41
+    #define TARGET_AVX2
+#endif
+
+/**
+ * pshufb masks that scatter three planar registers into three interleaved
+ * registers: [component][output register][byte]. 0x80 yields a zero byte.
+ */
+static const uint8_t interleave3_u8_masks[3][3][16] = {
+    {
+        { 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05 },
+        { 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A, 0x80 },
+        { 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80, 0x80 }
+    },
+    {
+        { 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80 },
+        { 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A },
+        { 0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80 }
+    },
+    {
+        { 0x80, 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80 },
+        { 0x80, 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80 },
+        { 0x0A, 0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F }
+    }
+};
+
+/** Same as interleave3_u8_masks for 16-bit samples (byte pairs move together) */
+static const uint8_t interleave3_u16_masks[3][3][16] = {
+    {
+        { 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80 },
+        { 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80, 0x0A, 0x0B },
+        { 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80 }
+    },
+    {
+        { 0x80, 0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05 },
+        { 0x80, 0x80, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80 },
+        { 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F, 0x80, 0x80 }
+    },
+    {
+        { 0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80 },
+        { 0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80 },
+        { 0x80, 0x80, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F }
+    }
+};
+
+/** Offset and saturate 16 int32 samples to 16 uint8 */
+TARGET_SSE41 static inline __m128i sse41_pack16_u8(const int32_t* src, __m128i off) {
+    __m128i a = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src + 0)), off);
+    __m128i b = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src + 4)), off);
+    __m128i c = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src + 8)), off);
+    __m128i d = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src + 12)), off);
+    return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+/** Offset and saturate 8 int32 samples to 8 uint16 */
+TARGET_SSE41 static inline __m128i sse41_pack8_u16(const int32_t* src, __m128i off) {
+    __m128i a = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src + 0)), off);
+    __m128i b = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src + 4)), off);
+    return _mm_packus_epi32(a, b);
+}
+
+/** Interleave three planar registers into 48 output bytes */
+TARGET_SSE41 static inline void sse41_store3(
+    __m128i p0, __m128i p1, __m128i p2,
+    const uint8_t masks[3][3][16], uint8_t* dst
+) {
+    for (int j = 0; j < 3; j++) {
+        __m128i v = _mm_or_si128(
+            _mm_or_si128(
+                _mm_shuffle_epi8(p0, _mm_loadu_si128((const __m128i*)masks[0][j])),
+                _mm_shuffle_epi8(p1, _mm_loadu_si128((const __m128i*)masks[1][j]))),
+            _mm_shuffle_epi8(p2, _mm_loadu_si128((const __m128i*)masks[2][j])));
+        _mm_storeu_si128((__m128i*)(dst + 16 * j), v);
+    }
+}
+
+TARGET_SSE41 static void row_sse41_c1_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    __m128i off = _mm_set1_epi32(offsets[0]);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        _mm_storeu_si128((__m128i*)(dst + x), sse41_pack16_u8(s + x, off));
+    }
+    row_tail_u8(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+TARGET_SSE41 static void row_sse41_c1_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    __m128i off = _mm_set1_epi32(offsets[0]);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        _mm_storeu_si128((__m128i*)(dst + 2 * x), sse41_pack8_u16(s + x, off));
+    }
+    row_tail_u16(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+TARGET_SSE41 static void row_sse41_c3_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    __m128i off0 = _mm_set1_epi32(offsets[0]);
+    __m128i off1 = _mm_set1_epi32(offsets[1]);
+    __m128i off2 = _mm_set1_epi32(offsets[2]);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        sse41_store3(sse41_pack16_u8(s0 + x, off0),
+                     sse41_pack16_u8(s1 + x, off1),
+                     sse41_pack16_u8(s2 + x, off2),
+                     interleave3_u8_masks, dst + 3 * x);
+    }
+    row_tail_u8(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+TARGET_SSE41 static void row_sse41_c3_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    __m128i off0 = _mm_set1_epi32(offsets[0]);
+    __m128i off1 = _mm_set1_epi32(offsets[1]);
+    __m128i off2 = _mm_set1_epi32(offsets[2]);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        sse41_store3(sse41_pack8_u16(s0 + x, off0),
+                     sse41_pack8_u16(s1 + x, off1),
+                     sse41_pack8_u16(s2 + x, off2),
+                     interleave3_u16_masks, dst + 6 * x);
+    }
+    row_tail_u16(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+/** Offset and saturate 32 int32 samples to 32 uint8 (in pixel order) */
+TARGET_AVX2 static inline __m256i avx2_pack32_u8(const int32_t* src, __m256i off) {
+    __m256i a = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src + 0)), off);
+    __m256i b = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src + 8)), off);
+    __m256i c = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src + 16)), off);
+    __m256i d = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src + 24)), off);
+    /* In-lane packs leave 4-pixel groups as a0 b0 c0 d0 a1 b1 c1 d1; restore order */
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+    return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+/** Offset and saturate 16 int32 samples to 16 uint16 (in pixel order) */
+TARGET_AVX2 static inline __m256i avx2_pack16_u16(const int32_t* src, __m256i off) {
+    __m256i a = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src + 0)), off);
+    __m256i b = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src + 8)), off);
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+TARGET_AVX2 static void row_avx2_c1_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    __m256i off = _mm256_set1_epi32(offsets[0]);
+    size_t x = 0;
+    for (; x + 32 <= count; x += 32) {
+        _mm256_storeu_si256((__m256i*)(dst + x), avx2_pack32_u8(s + x, off));
+    }
+    row_tail_u8(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+TARGET_AVX2 static void row_avx2_c1_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    __m256i off = _mm256_set1_epi32(offsets[0]);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        _mm256_storeu_si256((__m256i*)(dst + 2 * x), avx2_pack16_u16(s + x, off));
+    }
+    row_tail_u16(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+TARGET_AVX2 static void row_avx2_c3_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    __m256i off0 = _mm256_set1_epi32(offsets[0]);
+    __m256i off1 = _mm256_set1_epi32(offsets[1]);
+    __m256i off2 = _mm256_set1_epi32(offsets[2]);
+    size_t x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i p0 = avx2_pack32_u8(s0 + x, off0);
+        __m256i p1 = avx2_pack32_u8(s1 + x, off1);
+        __m256i p2 = avx2_pack32_u8(s2 + x, off2);
+        /* pshufb cannot cross 128-bit lanes, so interleave each half separately */
+        sse41_store3(_mm256_castsi256_si128(p0), _mm256_castsi256_si128(p1),
+                     _mm256_castsi256_si128(p2), interleave3_u8_masks, dst + 3 * x);
+        sse41_store3(_mm256_extracti128_si256(p0, 1), _mm256_extracti128_si256(p1, 1),
+                     _mm256_extracti128_si256(p2, 1), interleave3_u8_masks, dst + 3 * x + 48);
+    }
+    row_tail_u8(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+TARGET_AVX2 static void row_avx2_c3_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    __m256i off0 = _mm256_set1_epi32(offsets[0]);
+    __m256i off1 = _mm256_set1_epi32(offsets[1]);
+    __m256i off2 = _mm256_set1_epi32(offsets[2]);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m256i p0 = avx2_pack16_u16(s0 + x, off0);
+        __m256i p1 = avx2_pack16_u16(s1 + x, off1);
+        __m256i p2 = avx2_pack16_u16(s2 + x, off2);
+        sse41_store3(_mm256_castsi256_si128(p0), _mm256_castsi256_si128(p1),
+                     _mm256_castsi256_si128(p2), interleave3_u16_masks, dst + 6 * x);
+        sse41_store3(_mm256_extracti128_si256(p0, 1), _mm256_extracti128_si256(p1, 1),
+                     _mm256_extracti128_si256(p2, 1), interleave3_u16_masks, dst + 6 * x + 48);
+    }
+    row_tail_u16(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+/** Map 4 int32 samples through the affine display transform, truncating to int32 */
+TARGET_SSE41 static inline __m128i sse41_affine4(const int32_t* src, __m128 scale, __m128 bias) {
+    __m128 f = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)src));
+    f = _mm_add_ps(_mm_mul_ps(f, scale), bias);
+    f = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    return _mm_cvttps_epi32(f);
+}
+
+/** Map 16 int32 samples to 16 display bytes */
+TARGET_SSE41 static inline __m128i sse41_display16_u8(const int32_t* src, __m128 scale, __m128 bias) {
+    __m128i a = sse41_affine4(src + 0, scale, bias);
+    __m128i b = sse41_affine4(src + 4, scale, bias);
+    __m128i c = sse41_affine4(src + 8, scale, bias);
+    __m128i d = sse41_affine4(src + 12, scale, bias);
+    return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+TARGET_SSE41 static void row_display_sse41_c1(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    __m128 scale = _mm_set1_ps(map->scale);
+    __m128 bias = _mm_set1_ps(map->bias);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        _mm_storeu_si128((__m128i*)(dst + x), sse41_display16_u8(s + x, scale, bias));
+    }
+    display_tail(planes, src_offset, num_comps, x, count, map, dst);
+}
+
+TARGET_SSE41 static void row_display_sse41_c3(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    __m128 scale = _mm_set1_ps(map->scale);
+    __m128 bias = _mm_set1_ps(map->bias);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        sse41_store3(sse41_display16_u8(s0 + x, scale, bias),
+                     sse41_display16_u8(s1 + x, scale, bias),
+                     sse41_display16_u8(s2 + x, scale, bias),
+                     interleave3_u8_masks, dst + 3 * x);
+    }
+    display_tail(planes, src_offset, num_comps, x, count, map, dst);
+}
+
+/** Map 8 int32 samples through the affine display transform, truncating to int32 */
+TARGET_AVX2 static inline __m256i avx2_affine8(const int32_t* src, __m256 scale, __m256 bias) {
+    __m256 f = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)src));
+    f = _mm256_add_ps(_mm256_mul_ps(f, scale), bias);
+    f = _mm256_min_ps(_mm256_max_ps(f, _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    return _mm256_cvttps_epi32(f);
+}
+
+/** Map 32 int32 samples to 32 display bytes (in pixel order) */
+TARGET_AVX2 static inline __m256i avx2_display32_u8(const int32_t* src, __m256 scale, __m256 bias) {
+    __m256i a = avx2_affine8(src + 0, scale, bias);
+    __m256i b = avx2_affine8(src + 8, scale, bias);
+    __m256i c = avx2_affine8(src + 16, scale, bias);
+    __m256i d = avx2_affine8(src + 24, scale, bias);
+    __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+    return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+TARGET_AVX2 static void row_display_avx2_c1(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    __m256 scale = _mm256_set1_ps(map->scale);
+    __m256 bias = _mm256_set1_ps(map->bias);
+    size_t x = 0;
+    for (; x + 32 <= count; x += 32) {
+        _mm256_storeu_si256((__m256i*)(dst + x), avx2_display32_u8(s + x, scale, bias));
+    }
+    display_tail(planes, src_offset, num_comps, x, count, map, dst);
+}
+
+TARGET_AVX2 static void row_display_avx2_c3(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    __m256 scale = _mm256_set1_ps(map->scale);
+    __m256 bias = _mm256_set1_ps(map->bias);
+    size_t x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i p0 = avx2_display32_u8(s0 + x, scale, bias);
+        __m256i p1 = avx2_display32_u8(s1 + x, scale, bias);
+        __m256i p2 = avx2_display32_u8(s2 + x, scale, bias);
+        sse41_store3(_mm256_castsi256_si128(p0), _mm256_castsi256_si128(p1),
+                     _mm256_castsi256_si128(p2), interleave3_u8_masks, dst + 3 * x);
+        sse41_store3(_mm256_extracti128_si256(p0, 1), _mm256_extracti128_si256(p1, 1),
+                     _mm256_extracti128_si256(p2, 1), interleave3_u8_masks, dst + 3 * x + 48);
+    }
+    display_tail(planes, src_offset, num_comps, x, count, map, dst);
+}
+
+#endif /* SHARPDICOM_ARCH_X86 */
+
+/*============================================================================
+ * ARM64 kernels (NEON)
+ *============================================================================*/
+
+#if SHARPDICOM_ARCH_ARM64
+
+#include <arm_neon.h>
+
+/** Offset and saturate 8 int32 samples to 8 uint16 */
+static inline uint16x8_t neon_pack8_u16(const int32_t* src, int32x4_t off) {
+    int32x4_t a = vaddq_s32(vld1q_s32(src + 0), off);
+    int32x4_t b = vaddq_s32(vld1q_s32(src + 4), off);
+    return vcombine_u16(vqmovun_s32(a), vqmovun_s32(b));
+}
+
+/** Offset and saturate 16 int32 samples to 16 uint8 */
+static inline uint8x16_t neon_pack16_u8(const int32_t* src, int32x4_t off) {
+    return vcombine_u8(vqmovn_u16(neon_pack8_u16(src, off)),
+                       vqmovn_u16(neon_pack8_u16(src + 8, off)));
+}
+
+static void row_neon_c1_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    int32x4_t off = vdupq_n_s32(offsets[0]);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        vst1q_u8(dst + x, neon_pack16_u8(s + x, off));
+    }
+    row_tail_u8(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+static void row_neon_c1_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    uint16_t* dst16 = (uint16_t*)dst;
+    int32x4_t off = vdupq_n_s32(offsets[0]);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        vst1q_u16(dst16 + x, neon_pack8_u16(s + x, off));
+    }
+    row_tail_u16(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+static void row_neon_c3_u8(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    int32x4_t off0 = vdupq_n_s32(offsets[0]);
+    int32x4_t off1 = vdupq_n_s32(offsets[1]);
+    int32x4_t off2 = vdupq_n_s32(offsets[2]);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        uint8x16x3_t v;
+        v.val[0] = neon_pack16_u8(s0 + x, off0);
+        v.val[1] = neon_pack16_u8(s1 + x, off1);
+        v.val[2] = neon_pack16_u8(s2 + x, off2);
+        vst3q_u8(dst + 3 * x, v);
+    }
+    row_tail_u8(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+static void row_neon_c3_u16(
+    const int32_t* const* planes, size_t src_offset, const int32_t* offsets,
+    int num_comps, size_t count, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    uint16_t* dst16 = (uint16_t*)dst;
+    int32x4_t off0 = vdupq_n_s32(offsets[0]);
+    int32x4_t off1 = vdupq_n_s32(offsets[1]);
+    int32x4_t off2 = vdupq_n_s32(offsets[2]);
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        uint16x8x3_t v;
+        v.val[0] = neon_pack8_u16(s0 + x, off0);
+        v.val[1] = neon_pack8_u16(s1 + x, off1);
+        v.val[2] = neon_pack8_u16(s2 + x, off2);
+        vst3q_u16(dst16 + 3 * x, v);
+    }
+    row_tail_u16(planes, src_offset, offsets, num_comps, x, count, dst);
+}
+
+/** Map 8 int32 samples to 8 uint16 display values */
+static inline uint16x8_t neon_display8_u16(const int32_t* src, float32x4_t scale, float32x4_t bias) {
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t top = vdupq_n_f32(255.0f);
+    float32x4_t a = vaddq_f32(vmulq_f32(vcvtq_f32_s32(vld1q_s32(src + 0)), scale), bias);
+    float32x4_t b = vaddq_f32(vmulq_f32(vcvtq_f32_s32(vld1q_s32(src + 4)), scale), bias);
+    a = vminq_f32(vmaxq_f32(a, zero), top);
+    b = vminq_f32(vmaxq_f32(b, zero), top);
+    return vcombine_u16(vqmovun_s32(vcvtq_s32_f32(a)), vqmovun_s32(vcvtq_s32_f32(b)));
+}
+
+/** Map 16 int32 samples to 16 display bytes */
+static inline uint8x16_t neon_display16_u8(const int32_t* src, float32x4_t scale, float32x4_t bias) {
+    return vcombine_u8(vqmovn_u16(neon_display8_u16(src, scale, bias)),
+                       vqmovn_u16(neon_display8_u16(src + 8, scale, bias)));
+}
+
+static void row_display_neon_c1(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const int32_t* s = planes[0] + src_offset;
+    float32x4_t scale = vdupq_n_f32(map->scale);
+    float32x4_t bias = vdupq_n_f32(map->bias);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        vst1q_u8(dst + x, neon_display16_u8(s + x, scale, bias));
+    }
+    display_tail(planes, src_offset, num_comps, x, count, map, dst);
+}
+
+static void row_display_neon_c3(
+    const int32_t* const* planes, size_t src_offset, int num_comps,
+    size_t count, const pixel_display_map* map, uint8_t* dst
+) {
+    const int32_t* s0 = planes[0] + src_offset;
+    const int32_t* s1 = planes[1] + src_offset;
+    const int32_t* s2 = planes[2] + src_offset;
+    float32x4_t scale = vdupq_n_f32(map->scale);
+    float32x4_t bias = vdupq_n_f32(map->bias);
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        uint8x16x3_t v;
+        v.val[0] = neon_display16_u8(s0 + x, scale, bias);
+        v.val[1] = neon_display16_u8(s1 + x, scale, bias);
+        v.val[2] = neon_display16_u8(s2 + x, scale, bias);
+        vst3q_u8(dst + 3 * x, v);
+    }
+    display_tail(planes, src_offset, num_comps, x, count, map, dst);
+}
+
+#endif /* SHARPDICOM_ARCH_ARM64 */
+
+/*============================================================================
+ * Runtime kernel selection
+ *============================================================================*/
+
+/** Caller-imposed SIMD restriction (-1 = none) */
+static volatile int g_simd_mask = -1;
+
+/** Selected SHARPDICOM_SIMD_* level (-1 = not yet selected) */
+static volatile int g_simd_level = -1;
+
+static int select_simd_level(void) {
+    int level = g_simd_level;
+    if (level >= 0) {
+        return level;
+    }
+
+    int simd = sharpdicom_simd_features();
+    if (g_simd_mask >= 0) {
+        simd &= g_simd_mask;
+    }
+
+    level = SHARPDICOM_SIMD_NONE;
+#if SHARPDICOM_ARCH_X86
+    if (simd & SHARPDICOM_SIMD_AVX2) {
+        level = SHARPDICOM_SIMD_AVX2;
+    } else if (simd & SHARPDICOM_SIMD_SSE4_1) {
+        level = SHARPDICOM_SIMD_SSE4_1;
+    }
+#elif SHARPDICOM_ARCH_ARM64
+    if (simd & SHARPDICOM_SIMD_NEON) {
+        level = SHARPDICOM_SIMD_NEON;
+    }
+#endif
+
+    g_simd_level = level;
+    return level;
+}
+
+/** Pick the row kernel for a component count and sample size */
+static interleave_row_fn select_row_kernel(int num_comps, int bytes_per_sample) {
+    int level = select_simd_level();
+    int wide = (bytes_per_sample == 2);
+
+#if SHARPDICOM_ARCH_X86
+    if (level == SHARPDICOM_SIMD_AVX2) {
+        if (num_comps == 1) return wide ? row_avx2_c1_u16 : row_avx2_c1_u8;
+        if (num_comps == 3) return wide ? row_avx2_c3_u16 : row_avx2_c3_u8;
+    } else if (level == SHARPDICOM_SIMD_SSE4_1) {
+        if (num_comps == 1) return wide ? row_sse41_c1_u16 : row_sse41_c1_u8;
+        if (num_comps == 3) return wide ? row_sse41_c3_u16 : row_sse41_c3_u8;
+    }
+#elif SHARPDICOM_ARCH_ARM64
+    if (level == SHARPDICOM_SIMD_NEON) {
+        if (num_comps == 1) return wide ? row_neon_c1_u16 : row_neon_c1_u8;
+        if (num_comps == 3) return wide ? row_neon_c3_u16 : row_neon_c3_u8;
+    }
+#else
+    (void)level;
+    (void)num_comps;
+#endif
+
+    return wide ? row_scalar_u16 : row_scalar_u8;
+}
+
+/** Pick the display row kernel for a component count and compiled transform */
+static display_row_fn select_display_kernel(int num_comps, const pixel_display_map* map) {
+    if (map->table) {
+        return row_display_table;
+    }
+
+    int level = select_simd_level();
+#if SHARPDICOM_ARCH_X86
+    if (level == SHARPDICOM_SIMD_AVX2) {
+        if (num_comps == 1) return row_display_avx2_c1;
+        if (num_comps == 3) return row_display_avx2_c3;
+    } else if (level == SHARPDICOM_SIMD_SSE4_1) {
+        if (num_comps == 1) return row_display_sse41_c1;
+        if (num_comps == 3) return row_display_sse41_c3;
+    }
+#elif SHARPDICOM_ARCH_ARM64
+    if (level == SHARPDICOM_SIMD_NEON) {
+        if (num_comps == 1) return row_display_neon_c1;
+        if (num_comps == 3) return row_display_neon_c3;
+    }
+#else
+    (void)level;
+    (void)num_comps;
+#endif
+
+    return row_display_scalar;
+}
+
+/*============================================================================
+ * Display transform compilation
+ *============================================================================*/
+
+/** Window output in [0, 255] for a rescaled value (C.11.2.1.2, C.11.2.1.3) */
+static double voi_window(int32_t function, double y, double center, double width) {
+    double out;
+    switch (function) {
+    case DISPLAY_VOI_SIGMOID:
+        out = 255.0 / (1.0 + exp(-4.0 * (y - center) / width));
+        break;
+    case DISPLAY_VOI_LINEAR_EXACT:
+        out = ((y - center) / width + 0.5) * 255.0;
+        break;
+    default:
+        /* LINEAR; width 1 is a threshold at center - 0.5 */
+        if (width <= 1.0) {
+            out = (y <= center - 0.5) ? 0.0 : 255.0;
+        } else {
+            out = ((y - (center - 0.5)) / (width - 1.0) + 0.5) * 255.0;
+        }
+        break;
+    }
+    if (out < 0.0) out = 0.0;
+    if (out > 255.0) out = 255.0;
+    return out;
+}
+
+int pixel_display_map_init(
+    pixel_display_map* map,
+    const display_params_t* display,
+    int32_t bits_stored,
+    int is_signed
+) {
+    memset(map, 0, sizeof(*map));
+    if (!display || bits_stored < 1 || bits_stored > 32) {
+        set_error("Invalid display parameters or bits stored");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    double slope = (display->rescale_slope != 0.0) ? display->rescale_slope : 1.0;
+    double intercept = display->rescale_intercept;
+    double center = display->window_center;
+    double width = display->window_width;
+    int32_t function = display->voi_function;
+    if (!isfinite(slope) || !isfinite(intercept) || !isfinite(center) || !isfinite(width)) {
+        set_error("Display parameters must be finite");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (function < DISPLAY_VOI_LINEAR || function > DISPLAY_VOI_SIGMOID) {
+        set_error("Invalid VOI LUT function");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (display->lut && display->lut_count <= 0) {
+        set_error("VOI LUT has no entries");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Stored range */
+    int64_t first = is_signed ? -((int64_t)1 << (bits_stored - 1)) : 0;
+    int64_t last = is_signed ? ((int64_t)1 << (bits_stored - 1)) - 1 : ((int64_t)1 << bits_stored) - 1;
+
+    if (width <= 0.0) {
+        /* No window: stretch the rescaled stored range over the output */
+        double a = (double)first * slope + intercept;
+        double b = (double)last * slope + intercept;
+        function = DISPLAY_VOI_LINEAR_EXACT;
+        center = (a + b) * 0.5;
+        width = (a < b) ? b - a : a - b;
+        if (width <= 0.0) width = 1.0;
+    } else if (function == DISPLAY_VOI_LINEAR && width < 1.0) {
+        set_error("Window width must be at least 1 for the LINEAR function");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int needs_table = display->lut || function == DISPLAY_VOI_SIGMOID ||
+                      (function == DISPLAY_VOI_LINEAR && width <= 1.0);
+    if (!needs_table) {
+        /* Fold rescale, window and inversion into one affine map of the stored value */
+        double k, m;
+        if (function == DISPLAY_VOI_LINEAR_EXACT) {
+            k = 255.0 / width;
+            m = (0.5 - center / width) * 255.0;
+        } else {
+            k = 255.0 / (width - 1.0);
+            m = ((0.5 - center) / (width - 1.0) + 0.5) * 255.0;
+        }
+        double scale = slope * k;
+        double bias = intercept * k + m;
+        if (display->invert) {
+            scale = -scale;
+            bias = 255.0 - bias;
+        }
+        map->scale = (float)scale;
+        map->bias = (float)(bias + 0.5);
+        return SHARPDICOM_OK;
+    }
+
+    if (bits_stored > 16) {
+        set_error("VOI LUT and SIGMOID display transforms need 16 or fewer bits stored");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+    size_t entries = (size_t)(last - first + 1);
+    map->table = (uint8_t*)allocator_alloc(entries);
+    if (!map->table) {
+        set_error("Failed to allocate display table");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    map->table_first = (int32_t)first;
+    map->table_last = (int32_t)last;
+
+    for (size_t i = 0; i < entries; i++) {
+        double y = (double)(first + (int64_t)i) * slope + intercept;
+        uint8_t out;
+        if (display->lut) {
+            /* Values outside the LUT map to its first or last entry */
+            double index = floor(y + 0.5) - (double)display->lut_first;
+            if (index < 0.0) index = 0.0;
+            if (index > (double)(display->lut_count - 1)) index = (double)(display->lut_count - 1);
+            out = display->lut[(size_t)index];
+        } else {
+            out = (uint8_t)(voi_window(function, y, center, width) + 0.5);
+        }
+        map->table[i] = display->invert ? (uint8_t)(255 - out) : out;
+    }
+    return SHARPDICOM_OK;
+}
+
+void pixel_display_map_release(pixel_display_map* map) {
+    if (map) {
+        allocator_free(map->table);
+        map->table = NULL;
+    }
+}
+
+/*============================================================================
+ * Public (library-internal) API
+ *============================================================================*/
+
+void pixel_interleave_i32(
+    const int32_t* const* planes,
+    const int32_t* offsets,
+    int num_comps,
+    size_t width,
+    size_t height,
+    int bytes_per_sample,
+    uint8_t* output,
+    size_t row_stride
+) {
+    if (!planes || !offsets || num_comps < 1 || !output || width == 0) {
+        return;
+    }
+
+    interleave_row_fn row_fn = select_row_kernel(num_comps, bytes_per_sample);
+    if (row_stride == 0) {
+        row_stride = width * (size_t)num_comps * (size_t)bytes_per_sample;
+    }
+
+    for (size_t y = 0; y < height; y++) {
+        row_fn(planes, y * width, offsets, num_comps, width, output + y * row_stride);
+    }
+}
+
+void pixel_interleave_display_i32(
+    const int32_t* const* planes,
+    int num_comps,
+    size_t width,
+    size_t height,
+    const pixel_display_map* map,
+    uint8_t* output,
+    size_t row_stride
+) {
+    if (!planes || num_comps < 1 || !map || !output || width == 0) {
+        return;
+    }
+
+    display_row_fn row_fn = select_display_kernel(num_comps, map);
+    if (row_stride == 0) {
+        row_stride = width * (size_t)num_comps;
+    }
+
+    for (size_t y = 0; y < height; y++) {
+        row_fn(planes, y * width, num_comps, width, map, output + y * row_stride);
+    }
+}
+
+/** Samples widened per chunk in pixel_display_samples() */
+#define DISPLAY_CHUNK 512
+
+void pixel_display_samples(
+    const uint8_t* input,
+    size_t count,
+    int32_t bits_stored,
+    int is_signed,
+    const pixel_display_map* map,
+    uint8_t* output
+) {
+    if (!input || !map || !output || bits_stored < 1 || bits_stored > 16) {
+        return;
+    }
+
+    display_row_fn row_fn = select_display_kernel(1, map);
+    int32_t mask = (int32_t)((1u << bits_stored) - 1);
+    int32_t sign = is_signed ? (int32_t)(1u << (bits_stored - 1)) : 0;
+    int32_t chunk[DISPLAY_CHUNK];
+    const int32_t* planes[1] = { chunk };
+
+    /* Widen to the int32 samples the row kernels read, dropping unused high bits */
+    for (size_t done = 0; done < count; done += DISPLAY_CHUNK) {
+        size_t n = (count - done < DISPLAY_CHUNK) ? count - done : DISPLAY_CHUNK;
+        if (bits_stored <= 8) {
+            const uint8_t* src = input + done;
+            for (size_t i = 0; i < n; i++) {
+                chunk[i] = (((int32_t)src[i] & mask) ^ sign) - sign;
+            }
+        } else {
+            const uint16_t* src = (const uint16_t*)input + done;
+            for (size_t i = 0; i < n; i++) {
+                chunk[i] = (((int32_t)src[i] & mask) ^ sign) - sign;
+            }
+        }
+        row_fn(planes, 0, 1, n, map, output + done);
+    }
+}
+
+int pixel_convert_simd_level(void) {
+    return select_simd_level();
+}
+
+void pixel_convert_set_simd_mask(int mask) {
+    g_simd_mask = mask;
+    g_simd_level = -1;
+}
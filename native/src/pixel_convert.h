@@ -0,0 +1,148 @@
+/**
+ * SharpDicom Pixel Conversion Kernels
+ *
+ * Converts decoder component planes (one int32 sample per pixel, as produced
+ * by OpenJPEG) into 8-bit or 16-bit output samples, applying the signed-sample
+ * offset and clamping to the output range.
+ *
+ * SSE4.1, AVX2 and NEON kernels cover the 1- and 3-component cases; other
+ * component counts and CPUs without those extensions use the scalar loop.
+ * Kernels are selected once at runtime from sharpdicom_simd_features().
+ *
+ * The display variants fold a display_params_t transform into the same
+ * loop and write 8-bit display samples.
+ *
+ * Internal to the native library - not part of the exported API.
+ * Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "display.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Interleave component planes into a component-interleaved output buffer.
+ *
+ * Output samples are uint8_t when bytes_per_sample is 1 and native-endian
+ * uint16_t when it is 2. Each sample is (plane value + offset) clamped to
+ * [0, 255] or [0, 65535].
+ *
+ * @param planes            Component planes, width * height samples each, rows tightly packed
+ * @param offsets           Per-component value added before clamping (e.g. 1 << (prec - 1) for signed)
+ * @param num_comps         Number of components (>= 1)
+ * @param width             Pixels per row
+ * @param height            Number of rows
+ * @param bytes_per_sample  1 or 2
+ * @param output            Output buffer
+ * @param row_stride        Bytes between output rows (0 = width * num_comps * bytes_per_sample)
+ */
+void pixel_interleave_i32(
+    const int32_t* const* planes,
+    const int32_t* offsets,
+    int num_comps,
+    size_t width,
+    size_t height,
+    int bytes_per_sample,
+    uint8_t* output,
+    size_t row_stride
+);
+
+/**
+ * A display_params_t compiled for one stored bit depth.
+ *
+ * Linear windows stay affine on the stored value and run in the SIMD
+ * kernels; SIGMOID and caller LUTs become a table over the stored range.
+ */
+typedef struct {
+    /** Affine form: display = clamp(stored * scale + bias) (bias includes the +0.5 rounding) */
+    float scale;
+    float bias;
+    /** Table form (NULL = affine): display = table[clamp(stored, first, last) - first] */
+    uint8_t* table;
+    int32_t table_first;
+    int32_t table_last;
+} pixel_display_map;
+
+/**
+ * Compile display parameters for stored values of the given depth.
+ * Release with pixel_display_map_release().
+ *
+ * @param map           Receives the compiled transform
+ * @param display       Parameters to compile
+ * @param bits_stored   Bits per stored value (1-32; tables need 16 or fewer)
+ * @param is_signed     Whether stored values are two's complement
+ *
+ * @return SHARPDICOM_OK, SHARPDICOM_ERR_INVALID_ARGUMENT, SHARPDICOM_ERR_UNSUPPORTED
+ *         or SHARPDICOM_ERR_OUT_OF_MEMORY (error message set)
+ */
+int pixel_display_map_init(
+    pixel_display_map* map,
+    const display_params_t* display,
+    int32_t bits_stored,
+    int is_signed
+);
+
+/** Free the table of a compiled transform (safe on a zeroed map) */
+void pixel_display_map_release(pixel_display_map* map);
+
+/**
+ * Same as pixel_interleave_i32, with each stored value mapped to an 8-bit
+ * display value instead of offset and clamped.
+ *
+ * @param row_stride        Bytes between output rows (0 = width * num_comps)
+ */
+void pixel_interleave_display_i32(
+    const int32_t* const* planes,
+    int num_comps,
+    size_t width,
+    size_t height,
+    const pixel_display_map* map,
+    uint8_t* output,
+    size_t row_stride
+);
+
+/**
+ * Map a run of 8-bit or 16-bit samples to display values.
+ *
+ * @param input             uint8_t samples when bits_stored <= 8, else native-endian uint16_t
+ * @param count             Number of samples
+ * @param bits_stored       Significant low bits of each sample
+ * @param is_signed         Sign-extend from bit bits_stored - 1
+ * @param map               Compiled for the same bits_stored and is_signed
+ * @param output            Receives count display bytes
+ */
+void pixel_display_samples(
+    const uint8_t* input,
+    size_t count,
+    int32_t bits_stored,
+    int is_signed,
+    const pixel_display_map* map,
+    uint8_t* output
+);
+
+/**
+ * Returns the SHARPDICOM_SIMD_* flag of the kernel set in use
+ * (SHARPDICOM_SIMD_NONE for the scalar fallback).
+ */
+int pixel_convert_simd_level(void);
+
+/**
+ * Restricts kernel selection to the given SHARPDICOM_SIMD_* mask.
+ * Pass -1 to restore runtime detection. Intended for tests and benchmarks
+ * that compare kernel sets; not to be called while conversions are running.
+ */
+void pixel_convert_set_simd_mask(int mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIXEL_CONVERT_H */
@@ -0,0 +1,480 @@
+/**
+ * SharpDicom Header Probe Implementation
+ *
+ * Bounds-checked walks over the marker segments of each format. Every read
+ * is checked against the bytes available first, so a prefix that stops
+ * inside the header is reported as truncated rather than corrupt.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "probe.h"
+#include "jpeg_wrapper.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Forward declarations from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+extern void set_error_fmt(const char* fmt, ...);
+
+/*============================================================================
+ * Marker constants
+ *============================================================================*/
+
+/* JPEG / JPEG-LS (second byte of the marker) */
+#define JPEG_SOI        0xD8
+#define JPEG_EOI        0xD9
+#define JPEG_SOS        0xDA
+#define JPEG_DHT        0xC4
+#define JPEG_JPG        0xC8
+#define JPEG_DAC        0xCC
+#define JPEG_TEM        0x01
+#define JLS_SOF55       0xF7
+#define JLS_LSE         0xF8
+
+/** LSE parameter ID carrying dimensions too large for SOF55 */
+#define JLS_LSE_OVERSIZE 4
+
+/* JPEG 2000 */
+#define CS_MARKER_SOC   0xFF4F
+#define CS_MARKER_SOT   0xFF90
+#define CS_MARKER_SIZ   0xFF51
+#define CS_MARKER_CAP   0xFF50
+#define CS_MARKER_COD   0xFF52
+
+/** Rsiz bit set by Part 15 (HTJ2K) codestreams */
+#define CS_RSIZ_PART15  0x4000u
+
+/** Pcap bit announcing Part 15 capabilities in the CAP marker */
+#define CS_PCAP_PART15  0x00020000u
+
+/** Code-block style bit selecting the HT block coder in COD */
+#define CS_CBLK_STYLE_HT 0x40
+
+/** JP2 box types */
+#define JP2_BOX_SIGNATURE   0x6A502020u  /* 'jP  ' */
+#define JP2_BOX_CODESTREAM  0x6A703263u  /* 'jp2c' */
+
+/*============================================================================
+ * Byte helpers
+ *============================================================================*/
+
+static uint32_t rd16(const uint8_t* p) {
+    return ((uint32_t)p[0] << 8) | p[1];
+}
+
+static uint32_t rd32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static int truncated(const char* format_name) {
+    set_error_fmt("%s header is truncated", format_name);
+    return PROBE_ERR_TRUNCATED;
+}
+
+/*============================================================================
+ * JPEG and JPEG-LS
+ *============================================================================*/
+
+/** SOFn markers: 0xC0-0xCF except DHT, JPG and DAC, plus JPEG-LS SOF55 */
+static int is_sof(uint32_t code) {
+    if (code == JLS_SOF55) {
+        return 1;
+    }
+    return code >= 0xC0 && code <= 0xCF && code != JPEG_DHT && code != JPEG_JPG && code != JPEG_DAC;
+}
+
+/** Maps the luma sampling factors of a 3-component frame to JpegSubsampling */
+static int32_t jpeg_subsampling(const uint8_t* components, uint32_t count) {
+    if (count == 1) {
+        return JPEG_SAMP_GRAY;
+    }
+    if (count != 3) {
+        return -1;
+    }
+    /* Each component: id, H << 4 | V, quantization table */
+    for (uint32_t c = 1; c < 3; c++) {
+        if (components[c * 3 + 1] != 0x11) {
+            return -1;
+        }
+    }
+    switch (components[1]) {
+        case 0x11: return JPEG_SAMP_444;
+        case 0x21: return JPEG_SAMP_422;
+        case 0x22: return JPEG_SAMP_420;
+        case 0x12: return JPEG_SAMP_440;
+        case 0x41: return JPEG_SAMP_411;
+        default:   return -1;
+    }
+}
+
+static int parse_sof(uint32_t code, const uint8_t* seg, size_t body, probe_info_t* info) {
+    if (body < 6 || body < 6 + 3 * (size_t)seg[5] || seg[5] == 0) {
+        set_error("Invalid JPEG frame header");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    info->codec = (code == JLS_SOF55) ? BATCH_CODEC_JPEG_LS : BATCH_CODEC_JPEG;
+    info->sof_marker = (int32_t)(0xFF00 | code);
+    info->bits_per_sample = seg[0];
+    info->height = (int32_t)rd16(seg + 1);
+    info->width = (int32_t)rd16(seg + 3);
+    info->num_components = seg[5];
+    info->subsampling = (code == JLS_SOF55) ? -1 : jpeg_subsampling(seg + 6, seg[5]);
+    return SHARPDICOM_OK;
+}
+
+/** JPEG-LS scan header: Ns, Ns * (Cs, Tm), NEAR, ILV, Al/Ah */
+static int parse_jls_sos(const uint8_t* seg, size_t body, probe_info_t* info) {
+    if (body < 1 || body < 1 + 2 * (size_t)seg[0] + 3) {
+        set_error("Invalid JPEG-LS scan header");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    const uint8_t* tail = seg + 1 + 2 * (size_t)seg[0];
+    info->near_lossless = tail[0];
+    info->interleave_mode = tail[1];
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Oversize dimensions (LSE ID 4): Wxy, then height and width of Wxy bytes.
+ * Only applied where SOF55 coded the dimension as zero.
+ */
+static int parse_jls_lse(const uint8_t* seg, size_t body, uint64_t* lse_width, uint64_t* lse_height) {
+    if (body < 2 || seg[0] != JLS_LSE_OVERSIZE) {
+        return SHARPDICOM_OK;
+    }
+    size_t wxy = seg[1];
+    if (wxy < 2 || wxy > 4 || body < 2 + 2 * wxy) {
+        set_error("Invalid JPEG-LS oversize dimension segment");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint64_t height = 0, width = 0;
+    for (size_t i = 0; i < wxy; i++) {
+        height = (height << 8) | seg[2 + i];
+        width = (width << 8) | seg[2 + wxy + i];
+    }
+    *lse_height = height;
+    *lse_width = width;
+    return SHARPDICOM_OK;
+}
+
+static int probe_jpeg(const uint8_t* data, size_t size, probe_info_t* info) {
+    const char* name = "JPEG";
+    uint64_t lse_width = 0, lse_height = 0;
+    int have_sof = 0;
+    size_t pos = 2;
+
+    for (;;) {
+        if (pos >= size) {
+            return truncated(name);
+        }
+        if (data[pos] != 0xFF) {
+            set_error_fmt("Expected %s marker at offset %zu", name, pos);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        size_t marker_pos = pos;
+        /* Any number of 0xFF fill bytes may precede the marker code */
+        while (pos < size && data[pos] == 0xFF) {
+            pos++;
+        }
+        if (pos >= size) {
+            return truncated(name);
+        }
+        uint32_t code = data[pos++];
+
+        if (code == JPEG_TEM || code == JPEG_SOI || (code >= 0xD0 && code <= 0xD7)) {
+            continue;
+        }
+        if (code == 0x00 || code == JPEG_EOI) {
+            set_error_fmt("Unexpected %s marker 0xFF%02X before the first scan", name, code);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (size - pos < 2) {
+            return truncated(name);
+        }
+        size_t seg_len = rd16(data + pos);
+        if (seg_len < 2) {
+            set_error_fmt("Invalid length for %s marker 0xFF%02X", name, code);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (size - pos < seg_len) {
+            return truncated(name);
+        }
+        const uint8_t* seg = data + pos + 2;
+        size_t body = seg_len - 2;
+
+        int status = SHARPDICOM_OK;
+        if (is_sof(code)) {
+            if (have_sof) {
+                set_error_fmt("Second %s frame header at offset %zu", name, marker_pos);
+                return SHARPDICOM_ERR_CORRUPT_DATA;
+            }
+            status = parse_sof(code, seg, body, info);
+            have_sof = 1;
+            if (code == JLS_SOF55) {
+                name = "JPEG-LS";
+            }
+        } else if (code == JLS_LSE) {
+            status = parse_jls_lse(seg, body, &lse_width, &lse_height);
+        } else if (code == JPEG_SOS) {
+            if (!have_sof) {
+                set_error_fmt("%s scan before the frame header", name);
+                return SHARPDICOM_ERR_CORRUPT_DATA;
+            }
+            if (info->codec == BATCH_CODEC_JPEG_LS) {
+                status = parse_jls_sos(seg, body, info);
+                if (info->width == 0 && lse_width <= INT32_MAX) {
+                    info->width = (int32_t)lse_width;
+                }
+                if (info->height == 0 && lse_height <= INT32_MAX) {
+                    info->height = (int32_t)lse_height;
+                }
+            }
+            info->header_size = marker_pos;
+            return status;
+        }
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+        pos += seg_len;
+    }
+}
+
+/*============================================================================
+ * JPEG 2000
+ *============================================================================*/
+
+/** Xsiz, Ysiz, XOsiz, YOsiz, XTsiz, YTsiz, XTOsiz, YTOsiz after Rsiz */
+static int parse_siz(const uint8_t* seg, size_t body, probe_info_t* info) {
+    if (body < 38) {
+        set_error("Invalid JPEG 2000 SIZ marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t rsiz = rd16(seg);
+    uint64_t x1 = rd32(seg + 2), y1 = rd32(seg + 6);
+    uint64_t x0 = rd32(seg + 10), y0 = rd32(seg + 14);
+    uint64_t tile_w = rd32(seg + 18), tile_h = rd32(seg + 22);
+    uint64_t tile_x0 = rd32(seg + 26), tile_y0 = rd32(seg + 30);
+    uint32_t num_comps = rd16(seg + 34);
+
+    if (x1 <= x0 || y1 <= y0 || tile_w == 0 || tile_h == 0 || tile_x0 > x0 || tile_y0 > y0 ||
+        tile_x0 + tile_w <= x0 || tile_y0 + tile_h <= y0 || num_comps == 0 ||
+        body < 36 + 3 * (size_t)num_comps) {
+        set_error("Invalid JPEG 2000 image geometry in SIZ");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (x1 - x0 > INT32_MAX || y1 - y0 > INT32_MAX) {
+        set_error("JPEG 2000 image too large to report");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    uint64_t tiles_x = (x1 - tile_x0 + tile_w - 1) / tile_w;
+    uint64_t tiles_y = (y1 - tile_y0 + tile_h - 1) / tile_h;
+    info->width = (int32_t)(x1 - x0);
+    info->height = (int32_t)(y1 - y0);
+    info->num_components = (int32_t)num_comps;
+    info->num_tiles_x = (int32_t)tiles_x;
+    info->num_tiles_y = (int32_t)tiles_y;
+    if (tiles_x * tiles_y > 1) {
+        info->tile_width = (int32_t)(tile_w > INT32_MAX ? INT32_MAX : tile_w);
+        info->tile_height = (int32_t)(tile_h > INT32_MAX ? INT32_MAX : tile_h);
+    }
+
+    /* Like j2k_get_info(), signedness is reported for the first component */
+    const uint8_t* comp = seg + 36;
+    info->is_signed = (comp[0] & 0x80) ? 1 : 0;
+    for (uint32_t c = 0; c < num_comps; c++, comp += 3) {
+        int32_t bits = (comp[0] & 0x7F) + 1;
+        if (bits > info->bits_per_sample) {
+            info->bits_per_sample = bits;
+        }
+    }
+    if (rsiz & CS_RSIZ_PART15) {
+        info->is_htj2k = 1;
+    }
+    return SHARPDICOM_OK;
+}
+
+/** Scod, progression, layers(2), MCT, levels, xcb, ycb, style */
+static int parse_cod(const uint8_t* seg, size_t body, probe_info_t* info) {
+    if (body < 9) {
+        set_error("Invalid JPEG 2000 COD marker");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    info->progression_order = seg[1];
+    info->num_quality_layers = (int32_t)rd16(seg + 2);
+    info->num_resolutions = seg[5] + 1;
+    if (seg[8] & CS_CBLK_STYLE_HT) {
+        info->is_htj2k = 1;
+    }
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Walks a main header from SOC to the first SOT.
+ *
+ * @param base          Offset of the codestream in the caller's input
+ */
+static int probe_codestream(const uint8_t* data, size_t size, size_t base, probe_info_t* info) {
+    if (size < 4) {
+        return truncated("JPEG 2000");
+    }
+    if (rd16(data) != CS_MARKER_SOC || rd16(data + 2) != CS_MARKER_SIZ) {
+        set_error("JPEG 2000 codestream does not start with SOC and SIZ");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+
+    int have_cod = 0;
+    size_t pos = 2;
+    for (;;) {
+        if (size - pos < 2) {
+            return truncated("JPEG 2000");
+        }
+        uint32_t marker = rd16(data + pos);
+        if (marker == CS_MARKER_SOT) {
+            if (!have_cod) {
+                set_error("JPEG 2000 main header has no COD marker");
+                return SHARPDICOM_ERR_CORRUPT_DATA;
+            }
+            info->header_size = base + pos;
+            return SHARPDICOM_OK;
+        }
+        if ((marker & 0xFF00) != 0xFF00 || marker < 0xFF30) {
+            set_error_fmt("Invalid JPEG 2000 marker 0x%04X at offset %zu", marker, base + pos);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (size - pos < 4) {
+            return truncated("JPEG 2000");
+        }
+        size_t seg_len = rd16(data + pos + 2);
+        if (seg_len < 2) {
+            set_error_fmt("Invalid length for JPEG 2000 marker 0x%04X", marker);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (size - pos - 2 < seg_len) {
+            return truncated("JPEG 2000");
+        }
+        const uint8_t* seg = data + pos + 4;
+        size_t body = seg_len - 2;
+
+        int status = SHARPDICOM_OK;
+        if (marker == CS_MARKER_SIZ) {
+            status = parse_siz(seg, body, info);
+        } else if (marker == CS_MARKER_COD) {
+            status = parse_cod(seg, body, info);
+            have_cod = 1;
+        } else if (marker == CS_MARKER_CAP && body >= 4 && (rd32(seg) & CS_PCAP_PART15)) {
+            info->is_htj2k = 1;
+        }
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+        pos += 2 + seg_len;
+    }
+}
+
+/**
+ * Walks the top-level JP2 boxes to the contiguous codestream box. The
+ * codestream box may extend past the bytes available.
+ */
+static int probe_jp2(const uint8_t* data, size_t size, probe_info_t* info) {
+    size_t pos = 0;
+    for (;;) {
+        if (size - pos < 8) {
+            return truncated("JP2");
+        }
+        uint64_t box_len = rd32(data + pos);
+        uint32_t box_type = rd32(data + pos + 4);
+        size_t header = 8;
+        if (box_len == 1) {
+            if (size - pos < 16) {
+                return truncated("JP2");
+            }
+            box_len = ((uint64_t)rd32(data + pos + 8) << 32) | rd32(data + pos + 12);
+            header = 16;
+        }
+        if (box_type == JP2_BOX_CODESTREAM) {
+            info->format = J2K_FORMAT_JP2;
+            return probe_codestream(data + pos + header, size - pos - header, pos + header, info);
+        }
+        if (box_len == 0) {
+            set_error("JP2 file has no codestream box");
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (box_len < header) {
+            set_error_fmt("Invalid JP2 box length at offset %zu", pos);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+        if (box_len > size - pos) {
+            return truncated("JP2");
+        }
+        pos += (size_t)box_len;
+    }
+}
+
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+SHARPDICOM_API int probe_frame(
+    const uint8_t* input,
+    size_t input_len,
+    probe_info_t* info
+) {
+    if (!input || !info) {
+        set_error("probe_frame: NULL argument");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    memset(info, 0, sizeof(*info));
+    info->subsampling = -1;
+
+    if (input_len < 2) {
+        set_error("Frame too short to identify");
+        return PROBE_ERR_TRUNCATED;
+    }
+    if (input[0] == 0xFF && input[1] == JPEG_SOI) {
+        return probe_jpeg(input, input_len, info);
+    }
+    if (rd16(input) == CS_MARKER_SOC) {
+        info->codec = BATCH_CODEC_J2K;
+        return probe_codestream(input, input_len, 0, info);
+    }
+    /* JP2 signature box: length 12, type 'jP  ' */
+    if (input_len < 8) {
+        static const uint8_t jp2_prefix[] = { 0x00, 0x00, 0x00, 0x0C, 0x6A, 0x50, 0x20 };
+        if (memcmp(input, jp2_prefix, input_len) == 0) {
+            return truncated("JP2");
+        }
+    } else if (rd32(input + 4) == JP2_BOX_SIGNATURE) {
+        info->codec = BATCH_CODEC_J2K;
+        return probe_jp2(input, input_len, info);
+    }
+
+    set_error("Not a JPEG, JPEG-LS or JPEG 2000 frame");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int probe_frames(
+    const uint8_t** inputs,
+    const size_t* input_lens,
+    int count,
+    probe_info_t* infos,
+    int* statuses
+) {
+    if (!inputs || !input_lens || !infos || count <= 0) {
+        set_error("Invalid probe arguments");
+        return 0;
+    }
+
+    int success_count = 0;
+    for (int i = 0; i < count; i++) {
+        int status = probe_frame(inputs[i], input_lens[i], &infos[i]);
+        if (statuses) {
+            statuses[i] = status;
+        }
+        if (status == SHARPDICOM_OK) {
+            success_count++;
+        }
+    }
+    return success_count;
+}
@@ -0,0 +1,134 @@
+/**
+ * SharpDicom Header Probe API
+ *
+ * Reads image geometry straight from the marker segments at the start of
+ * a compressed frame: JPEG (ISO/IEC 10918-1 Annex B), JPEG-LS (ISO/IEC
+ * 14495-1 Annex C) and JPEG 2000 / HTJ2K raw codestreams or JP2 files
+ * (ISO/IEC 15444-1 Annex A and I). No codec library is involved and
+ * nothing is allocated, so it can run over memory-mapped archives at the
+ * rate of a few header bytes per frame.
+ *
+ * Only the main header is read: JPEG and JPEG-LS stop at the first SOS,
+ * JPEG 2000 at the first SOT. Nothing past it is validated.
+ *
+ * Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include "sharpdicom_codecs.h"
+#include "batch_decode.h"
+#include "j2k_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================
+ * Error codes (in addition to sharpdicom_codecs.h codes)
+ *============================================================================*/
+
+#define PROBE_ERR_TRUNCATED     -110  /**< Data ends inside the main header; probe more bytes */
+
+/*============================================================================
+ * Probe structures
+ *============================================================================*/
+
+/** Header fields of one compressed frame */
+typedef struct {
+    /** BATCH_CODEC_JPEG, BATCH_CODEC_JPEG_LS or BATCH_CODEC_J2K */
+    int32_t codec;
+    /** Image width in pixels */
+    int32_t width;
+    /** Image height in pixels (0 for JPEG frames that defer it to a DNL marker) */
+    int32_t height;
+    /** Number of components */
+    int32_t num_components;
+    /** Bits per sample (largest over the components) */
+    int32_t bits_per_sample;
+    /** Whether samples are signed (JPEG 2000 only; always 0 otherwise) */
+    int32_t is_signed;
+
+    /** SOF marker of a JPEG or JPEG-LS frame (0xFFC0-0xFFCF, 0xFFF7), 0 for JPEG 2000 */
+    int32_t sof_marker;
+    /** JPEG chroma subsampling (JpegSubsampling value, -1 if none applies) */
+    int32_t subsampling;
+    /** JPEG-LS near-lossless threshold of the first scan */
+    int32_t near_lossless;
+    /** JPEG-LS interleave mode of the first scan (JLS_INTERLEAVE_* value) */
+    int32_t interleave_mode;
+
+    /** JPEG 2000 file format */
+    J2kFormat format;
+    /** Whether code-blocks use the HTJ2K (Part 15) block coder */
+    int32_t is_htj2k;
+    /** Tile width (0 if single tile) */
+    int32_t tile_width;
+    /** Tile height (0 if single tile) */
+    int32_t tile_height;
+    /** Number of tiles in X direction */
+    int32_t num_tiles_x;
+    /** Number of tiles in Y direction */
+    int32_t num_tiles_y;
+    /** Resolution levels (decomposition levels + 1) */
+    int32_t num_resolutions;
+    /** Quality layers */
+    int32_t num_quality_layers;
+    /** Progression order: LRCP=0, RLCP=1, RPCL=2, PCRL=3, CPRL=4 */
+    int32_t progression_order;
+
+    /** Bytes of the input read, up to the first SOS (JPEG, JPEG-LS) or SOT (JPEG 2000) */
+    size_t header_size;
+} probe_info_t;
+
+/*============================================================================
+ * Probe API functions
+ *============================================================================*/
+
+/**
+ * Identifies a compressed frame and reads its main header.
+ *
+ * The input may be any prefix of the frame that covers the main header;
+ * a prefix that is too short fails with PROBE_ERR_TRUNCATED.
+ *
+ * @param input         Start of the compressed frame
+ * @param input_len     Bytes available at input
+ * @param info          Receives the header fields (zeroed first)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL pointers
+ *         - SHARPDICOM_ERR_UNSUPPORTED: Not a JPEG, JPEG-LS or JPEG 2000 frame
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Malformed marker segments
+ *         - PROBE_ERR_TRUNCATED: Input ends inside the main header
+ */
+SHARPDICOM_API int probe_frame(
+    const uint8_t* input,
+    size_t input_len,
+    probe_info_t* info
+);
+
+/**
+ * Probes many frames in one call.
+ *
+ * @param inputs        Array of frame pointers
+ * @param input_lens    Array of bytes available per frame
+ * @param count         Number of frames
+ * @param infos         Array of 'count' results
+ * @param statuses      Array of 'count' probe_frame() return codes (may be NULL)
+ *
+ * @return Number of frames probed successfully (0 with an error message on bad arguments)
+ */
+SHARPDICOM_API int probe_frames(
+    const uint8_t** inputs,
+    const size_t* input_lens,
+    int count,
+    probe_info_t* infos,
+    int* statuses
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROBE_H */
@@ -0,0 +1,1050 @@
+/**
+ * RLE Lossless Codec Implementation
+ *
+ * PackBits segment coding and byte-plane split/merge for the DICOM RLE
+ * transfer syntax. Scalar reference kernels plus SSE4.1 and NEON kernels
+ * for run detection, run expansion and the 2/3-plane (16-bit grayscale,
+ * 8-bit color) split and merge.
+ */
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "rle_wrapper.h"
+#include "sharpdicom_codecs.h"
+#include "allocator.h"
+#include "codec_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+/*============================================================================
+ * Internal helper: Set error message
+ *============================================================================*/
+
+/* Forward declaration from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+
+/**
+ * Format and set an error message.
+ */
+static void set_error_fmt(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    set_error(buffer);
+}
+
+/*============================================================================
+ * Platform detection
+ *============================================================================*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SHARPDICOM_ARCH_X86 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define SHARPDICOM_ARCH_ARM64 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static inline unsigned ctz32(uint32_t v) {
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return (unsigned)index;
+}
+static inline unsigned ctz64(uint64_t v) {
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return (unsigned)index;
+}
+#else
+static inline unsigned ctz32(uint32_t v) {
+    return (unsigned)__builtin_ctz(v);
+}
+static inline unsigned ctz64(uint64_t v) {
+    return (unsigned)__builtin_ctzll(v);
+}
+#endif
+
+/*============================================================================
+ * Format constants
+ *============================================================================*/
+
+/** Longest literal or replicate run one PackBits control byte can describe */
+#define RLE_MAX_RUN 128
+
+static uint32_t read_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_le32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/*============================================================================
+ * Kernel table
+ *============================================================================*/
+
+/**
+ * Kernels that differ between the scalar and SIMD implementations.
+ *
+ * run_length:     Bytes equal to p[0] starting at p (1..max)
+ * literal_length: Bytes from p before the first run of three equal bytes,
+ *                 capped at max and avail (p[0] != p[1] is assumed)
+ * expand:         Expands PackBits from src[*in_pos] into dst[*out_pos]
+ *                 until dst is full or src is exhausted; -1 when a
+ *                 command runs past the end of src
+ * merge:          out[i * n + j] = planes[j][i]
+ * split:          planes[j][i] = in[i * n + j]
+ */
+typedef struct {
+    size_t (*run_length)(const uint8_t* p, size_t max);
+    size_t (*literal_length)(const uint8_t* p, size_t avail, size_t max);
+    int (*expand)(const uint8_t* src, size_t src_len, size_t* in_pos,
+                  uint8_t* dst, size_t dst_len, size_t* out_pos);
+    void (*merge)(const uint8_t* const* planes, int n, size_t count, uint8_t* out);
+    void (*split)(const uint8_t* in, int n, size_t count, uint8_t* const* planes);
+} rle_kernels_t;
+
+/*============================================================================
+ * Scalar kernels
+ *
+ * Reference implementations; the SIMD kernels fall back to these near
+ * buffer edges where a full vector would over-read or over-write.
+ *============================================================================*/
+
+static size_t run_length_scalar(const uint8_t* p, size_t max) {
+    size_t n = 1;
+    while (n < max && p[n] == p[0]) {
+        n++;
+    }
+    return n;
+}
+
+static size_t literal_tail(const uint8_t* p, size_t avail, size_t limit, size_t j) {
+    for (; j < limit && j + 2 < avail; j++) {
+        if (p[j] == p[j + 1] && p[j + 1] == p[j + 2]) {
+            return j;
+        }
+    }
+    return limit;
+}
+
+static size_t literal_length_scalar(const uint8_t* p, size_t avail, size_t max) {
+    return literal_tail(p, avail, avail < max ? avail : max, 1);
+}
+
+static int expand_scalar(
+    const uint8_t* src, size_t src_len, size_t* in_pos,
+    uint8_t* dst, size_t dst_len, size_t* out_pos
+) {
+    size_t in = *in_pos;
+    size_t out = *out_pos;
+    int status = 0;
+
+    while (in < src_len && out < dst_len) {
+        int control = (int8_t)src[in++];
+        if (control >= 0) {
+            size_t n = (size_t)control + 1;
+            if (n > src_len - in) {
+                status = -1;
+                break;
+            }
+            size_t copy = n < dst_len - out ? n : dst_len - out;
+            memcpy(dst + out, src + in, copy);
+            in += n;
+            out += copy;
+        } else if (control != -128) {
+            if (in >= src_len) {
+                status = -1;
+                break;
+            }
+            size_t n = (size_t)(1 - control);
+            size_t fill = n < dst_len - out ? n : dst_len - out;
+            memset(dst + out, src[in++], fill);
+            out += fill;
+        }
+    }
+
+    *in_pos = in;
+    *out_pos = out;
+    return status;
+}
+
+static void merge_tail(
+    const uint8_t* const* planes, int n, size_t start, size_t count, uint8_t* out
+) {
+    if (n == 1) {
+        memcpy(out + start, planes[0] + start, count - start);
+        return;
+    }
+    for (size_t i = start; i < count; i++) {
+        uint8_t* d = out + i * (size_t)n;
+        for (int j = 0; j < n; j++) {
+            d[j] = planes[j][i];
+        }
+    }
+}
+
+static void split_tail(
+    const uint8_t* in, int n, size_t start, size_t count, uint8_t* const* planes
+) {
+    if (n == 1) {
+        memcpy(planes[0] + start, in + start, count - start);
+        return;
+    }
+    for (size_t i = start; i < count; i++) {
+        const uint8_t* s = in + i * (size_t)n;
+        for (int j = 0; j < n; j++) {
+            planes[j][i] = s[j];
+        }
+    }
+}
+
+static void merge_scalar(const uint8_t* const* planes, int n, size_t count, uint8_t* out) {
+    merge_tail(planes, n, 0, count, out);
+}
+
+static void split_scalar(const uint8_t* in, int n, size_t count, uint8_t* const* planes) {
+    split_tail(in, n, 0, count, planes);
+}
+
+static const rle_kernels_t scalar_kernels = {
+    run_length_scalar,
+    literal_length_scalar,
+    expand_scalar,
+    merge_scalar,
+    split_scalar
+};
+
+/*============================================================================
+ * x86 kernels (SSE4.1)
+ *
+ * Runs are capped at 128 bytes, so wider vectors gain little over 16-byte
+ * registers; SSE4.1 is required for pshufb in the 3-plane kernels.
+ *============================================================================*/
+
+#if SHARPDICOM_ARCH_X86
+
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+    #define TARGET_SSE41
+#endif
+
+/**
+ * pshufb masks that scatter three planar registers into three interleaved
+ * registers: [plane][output register][byte]. 0x80 yields a zero byte.
+ */
+static const uint8_t merge3_masks[3][3][16] = {
+    {
+        { 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80, 0x05 },
+        { 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A, 0x80 },
+        { 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80, 0x80 }
+    },
+    {
+        { 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80, 0x80 },
+        { 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80, 0x0A },
+        { 0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F, 0x80 }
+    },
+    {
+        { 0x80, 0x80, 0x00, 0x80, 0x80, 0x01, 0x80, 0x80, 0x02, 0x80, 0x80, 0x03, 0x80, 0x80, 0x04, 0x80 },
+        { 0x80, 0x05, 0x80, 0x80, 0x06, 0x80, 0x80, 0x07, 0x80, 0x80, 0x08, 0x80, 0x80, 0x09, 0x80, 0x80 },
+        { 0x0A, 0x80, 0x80, 0x0B, 0x80, 0x80, 0x0C, 0x80, 0x80, 0x0D, 0x80, 0x80, 0x0E, 0x80, 0x80, 0x0F }
+    }
+};
+
+/**
+ * pshufb masks that gather three interleaved registers into one planar
+ * register: [plane][input register][byte].
+ */
+static const uint8_t split3_masks[3][3][16] = {
+    {
+        { 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+        { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80 },
+        { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D }
+    },
+    {
+        { 0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+        { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F, 0x80, 0x80, 0x80, 0x80, 0x80 },
+        { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02, 0x05, 0x08, 0x0B, 0x0E }
+    },
+    {
+        { 0x02, 0x05, 0x08, 0x0B, 0x0E, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+        { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x04, 0x07, 0x0A, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80 },
+        { 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x03, 0x06, 0x09, 0x0C, 0x0F }
+    }
+};
+
+TARGET_SSE41 static size_t run_length_sse41(const uint8_t* p, size_t max) {
+    __m128i b = _mm_set1_epi8((char)p[0]);
+    size_t n = 0;
+    for (; n + 16 <= max; n += 16) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + n)), b);
+        unsigned mask = (unsigned)_mm_movemask_epi8(eq);
+        if (mask != 0xFFFF) {
+            return n + ctz32(~mask);
+        }
+    }
+    while (n < max && p[n] == p[0]) {
+        n++;
+    }
+    return n;
+}
+
+TARGET_SSE41 static size_t literal_length_sse41(const uint8_t* p, size_t avail, size_t max) {
+    size_t limit = avail < max ? avail : max;
+    size_t j = 1;
+    /* Each step compares p[j..j+15] with its two right neighbours */
+    for (; j + 16 <= limit && j + 18 <= avail; j += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + j));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + j + 1));
+        __m128i c = _mm_loadu_si128((const __m128i*)(p + j + 2));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(b, c)));
+        if (mask != 0) {
+            return j + ctz32(mask);
+        }
+    }
+    return literal_tail(p, avail, limit, j);
+}
+
+/**
+ * Expands whole 16-byte blocks while a maximal command can neither read
+ * past src nor write past dst; bytes written beyond a short run are
+ * overwritten by the commands that follow.
+ */
+TARGET_SSE41 static int expand_sse41(
+    const uint8_t* src, size_t src_len, size_t* in_pos,
+    uint8_t* dst, size_t dst_len, size_t* out_pos
+) {
+    size_t in = *in_pos;
+    size_t out = *out_pos;
+
+    while (src_len - in > RLE_MAX_RUN && dst_len - out >= RLE_MAX_RUN) {
+        int control = (int8_t)src[in++];
+        if (control >= 0) {
+            size_t n = (size_t)control + 1;
+            for (size_t k = 0; k < n; k += 16) {
+                _mm_storeu_si128((__m128i*)(dst + out + k),
+                                 _mm_loadu_si128((const __m128i*)(src + in + k)));
+            }
+            in += n;
+            out += n;
+        } else if (control != -128) {
+            size_t n = (size_t)(1 - control);
+            __m128i v = _mm_set1_epi8((char)src[in++]);
+            for (size_t k = 0; k < n; k += 16) {
+                _mm_storeu_si128((__m128i*)(dst + out + k), v);
+            }
+            out += n;
+        }
+    }
+
+    *in_pos = in;
+    *out_pos = out;
+    return expand_scalar(src, src_len, in_pos, dst, dst_len, out_pos);
+}
+
+TARGET_SSE41 static void merge_sse41(
+    const uint8_t* const* planes, int n, size_t count, uint8_t* out
+) {
+    size_t i = 0;
+    if (n == 2) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(planes[0] + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(planes[1] + i));
+            _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi8(a, b));
+            _mm_storeu_si128((__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+        }
+    } else if (n == 3) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i p0 = _mm_loadu_si128((const __m128i*)(planes[0] + i));
+            __m128i p1 = _mm_loadu_si128((const __m128i*)(planes[1] + i));
+            __m128i p2 = _mm_loadu_si128((const __m128i*)(planes[2] + i));
+            for (int j = 0; j < 3; j++) {
+                __m128i v = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_shuffle_epi8(p0, _mm_loadu_si128((const __m128i*)merge3_masks[0][j])),
+                        _mm_shuffle_epi8(p1, _mm_loadu_si128((const __m128i*)merge3_masks[1][j]))),
+                    _mm_shuffle_epi8(p2, _mm_loadu_si128((const __m128i*)merge3_masks[2][j])));
+                _mm_storeu_si128((__m128i*)(out + 3 * i + 16 * j), v);
+            }
+        }
+    }
+    merge_tail(planes, n, i, count, out);
+}
+
+TARGET_SSE41 static void split_sse41(
+    const uint8_t* in, int n, size_t count, uint8_t* const* planes
+) {
+    size_t i = 0;
+    if (n == 2) {
+        __m128i low = _mm_set1_epi16(0x00FF);
+        for (; i + 16 <= count; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(in + 2 * i));
+            __m128i y = _mm_loadu_si128((const __m128i*)(in + 2 * i + 16));
+            _mm_storeu_si128((__m128i*)(planes[0] + i),
+                             _mm_packus_epi16(_mm_and_si128(x, low), _mm_and_si128(y, low)));
+            _mm_storeu_si128((__m128i*)(planes[1] + i),
+                             _mm_packus_epi16(_mm_srli_epi16(x, 8), _mm_srli_epi16(y, 8)));
+        }
+    } else if (n == 3) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i r0 = _mm_loadu_si128((const __m128i*)(in + 3 * i));
+            __m128i r1 = _mm_loadu_si128((const __m128i*)(in + 3 * i + 16));
+            __m128i r2 = _mm_loadu_si128((const __m128i*)(in + 3 * i + 32));
+            for (int c = 0; c < 3; c++) {
+                __m128i v = _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_shuffle_epi8(r0, _mm_loadu_si128((const __m128i*)split3_masks[c][0])),
+                        _mm_shuffle_epi8(r1, _mm_loadu_si128((const __m128i*)split3_masks[c][1]))),
+                    _mm_shuffle_epi8(r2, _mm_loadu_si128((const __m128i*)split3_masks[c][2])));
+                _mm_storeu_si128((__m128i*)(planes[c] + i), v);
+            }
+        }
+    }
+    split_tail(in, n, i, count, planes);
+}
+
+static const rle_kernels_t sse41_kernels = {
+    run_length_sse41,
+    literal_length_sse41,
+    expand_sse41,
+    merge_sse41,
+    split_sse41
+};
+
+#endif /* SHARPDICOM_ARCH_X86 */
+
+/*============================================================================
+ * ARM64 kernels (NEON)
+ *============================================================================*/
+
+#if SHARPDICOM_ARCH_ARM64
+
+#include <arm_neon.h>
+
+/** Packs a byte-wise comparison result into 4 bits per lane */
+static inline uint64_t neon_mask(uint8x16_t v) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+static size_t run_length_neon(const uint8_t* p, size_t max) {
+    uint8x16_t b = vdupq_n_u8(p[0]);
+    size_t n = 0;
+    for (; n + 16 <= max; n += 16) {
+        uint64_t mask = neon_mask(vceqq_u8(vld1q_u8(p + n), b));
+        if (mask != ~(uint64_t)0) {
+            return n + (ctz64(~mask) >> 2);
+        }
+    }
+    while (n < max && p[n] == p[0]) {
+        n++;
+    }
+    return n;
+}
+
+static size_t literal_length_neon(const uint8_t* p, size_t avail, size_t max) {
+    size_t limit = avail < max ? avail : max;
+    size_t j = 1;
+    for (; j + 16 <= limit && j + 18 <= avail; j += 16) {
+        uint8x16_t a = vld1q_u8(p + j);
+        uint8x16_t b = vld1q_u8(p + j + 1);
+        uint8x16_t c = vld1q_u8(p + j + 2);
+        uint64_t mask = neon_mask(vandq_u8(vceqq_u8(a, b), vceqq_u8(b, c)));
+        if (mask != 0) {
+            return j + (ctz64(mask) >> 2);
+        }
+    }
+    return literal_tail(p, avail, limit, j);
+}
+
+static int expand_neon(
+    const uint8_t* src, size_t src_len, size_t* in_pos,
+    uint8_t* dst, size_t dst_len, size_t* out_pos
+) {
+    size_t in = *in_pos;
+    size_t out = *out_pos;
+
+    while (src_len - in > RLE_MAX_RUN && dst_len - out >= RLE_MAX_RUN) {
+        int control = (int8_t)src[in++];
+        if (control >= 0) {
+            size_t n = (size_t)control + 1;
+            for (size_t k = 0; k < n; k += 16) {
+                vst1q_u8(dst + out + k, vld1q_u8(src + in + k));
+            }
+            in += n;
+            out += n;
+        } else if (control != -128) {
+            size_t n = (size_t)(1 - control);
+            uint8x16_t v = vdupq_n_u8(src[in++]);
+            for (size_t k = 0; k < n; k += 16) {
+                vst1q_u8(dst + out + k, v);
+            }
+            out += n;
+        }
+    }
+
+    *in_pos = in;
+    *out_pos = out;
+    return expand_scalar(src, src_len, in_pos, dst, dst_len, out_pos);
+}
+
+static void merge_neon(const uint8_t* const* planes, int n, size_t count, uint8_t* out) {
+    size_t i = 0;
+    if (n == 2) {
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x2_t v = { { vld1q_u8(planes[0] + i), vld1q_u8(planes[1] + i) } };
+            vst2q_u8(out + 2 * i, v);
+        }
+    } else if (n == 3) {
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x3_t v = { { vld1q_u8(planes[0] + i), vld1q_u8(planes[1] + i),
+                                 vld1q_u8(planes[2] + i) } };
+            vst3q_u8(out + 3 * i, v);
+        }
+    } else if (n == 4) {
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x4_t v = { { vld1q_u8(planes[0] + i), vld1q_u8(planes[1] + i),
+                                 vld1q_u8(planes[2] + i), vld1q_u8(planes[3] + i) } };
+            vst4q_u8(out + 4 * i, v);
+        }
+    }
+    merge_tail(planes, n, i, count, out);
+}
+
+static void split_neon(const uint8_t* in, int n, size_t count, uint8_t* const* planes) {
+    size_t i = 0;
+    if (n == 2) {
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x2_t v = vld2q_u8(in + 2 * i);
+            vst1q_u8(planes[0] + i, v.val[0]);
+            vst1q_u8(planes[1] + i, v.val[1]);
+        }
+    } else if (n == 3) {
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x3_t v = vld3q_u8(in + 3 * i);
+            vst1q_u8(planes[0] + i, v.val[0]);
+            vst1q_u8(planes[1] + i, v.val[1]);
+            vst1q_u8(planes[2] + i, v.val[2]);
+        }
+    } else if (n == 4) {
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x4_t v = vld4q_u8(in + 4 * i);
+            vst1q_u8(planes[0] + i, v.val[0]);
+            vst1q_u8(planes[1] + i, v.val[1]);
+            vst1q_u8(planes[2] + i, v.val[2]);
+            vst1q_u8(planes[3] + i, v.val[3]);
+        }
+    }
+    split_tail(in, n, i, count, planes);
+}
+
+static const rle_kernels_t neon_kernels = {
+    run_length_neon,
+    literal_length_neon,
+    expand_neon,
+    merge_neon,
+    split_neon
+};
+
+#endif /* SHARPDICOM_ARCH_ARM64 */
+
+/*============================================================================
+ * Runtime kernel selection
+ *============================================================================*/
+
+/** Caller-imposed SIMD restriction (-1 = none) */
+static volatile int g_simd_mask = -1;
+
+/** Selected SHARPDICOM_SIMD_* level (-1 = not yet selected) */
+static volatile int g_simd_level = -1;
+
+static int select_simd_level(void) {
+    int level = g_simd_level;
+    if (level >= 0) {
+        return level;
+    }
+
+    int simd = sharpdicom_simd_features();
+    if (g_simd_mask >= 0) {
+        simd &= g_simd_mask;
+    }
+
+    level = SHARPDICOM_SIMD_NONE;
+#if SHARPDICOM_ARCH_X86
+    if (simd & SHARPDICOM_SIMD_SSE4_1) {
+        level = SHARPDICOM_SIMD_SSE4_1;
+    }
+#elif SHARPDICOM_ARCH_ARM64
+    if (simd & SHARPDICOM_SIMD_NEON) {
+        level = SHARPDICOM_SIMD_NEON;
+    }
+#else
+    (void)simd;
+#endif
+
+    g_simd_level = level;
+    return level;
+}
+
+static const rle_kernels_t* select_kernels(void) {
+    int level = select_simd_level();
+#if SHARPDICOM_ARCH_X86
+    if (level == SHARPDICOM_SIMD_SSE4_1) {
+        return &sse41_kernels;
+    }
+#elif SHARPDICOM_ARCH_ARM64
+    if (level == SHARPDICOM_SIMD_NEON) {
+        return &neon_kernels;
+    }
+#else
+    (void)level;
+#endif
+    return &scalar_kernels;
+}
+
+/*============================================================================
+ * Frame layout helpers
+ *============================================================================*/
+
+/**
+ * Validates params and computes the byte-plane geometry.
+ *
+ * @param params            Frame geometry
+ * @param plane_size        Receives bytes per byte-plane (width * height)
+ * @param bytes_per_sample  Receives bits_allocated / 8
+ * @param num_segments      Receives samples_per_pixel * bytes_per_sample
+ */
+static int validate_params(
+    const rle_params_t* params,
+    size_t* plane_size,
+    int* bytes_per_sample,
+    int* num_segments
+) {
+    if (params == NULL) {
+        set_error("Invalid argument: NULL params");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->width <= 0 || params->height <= 0) {
+        set_error("Invalid argument: width and height must be positive");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->bits_allocated != 8 && params->bits_allocated != 16 &&
+        params->bits_allocated != 32) {
+        set_error("Invalid argument: bits_allocated must be 8, 16 or 32");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    int bps = params->bits_allocated / 8;
+    if (params->samples_per_pixel < 1 ||
+        params->samples_per_pixel * bps > RLE_MAX_SEGMENTS) {
+        set_error_fmt("Invalid argument: %d samples of %d bits exceed %d RLE segments",
+                      params->samples_per_pixel, params->bits_allocated, RLE_MAX_SEGMENTS);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->planar_configuration != RLE_PLANAR_INTERLEAVED &&
+        params->planar_configuration != RLE_PLANAR_SEPARATE) {
+        set_error("Invalid argument: planar_configuration must be 0 or 1");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t w = (size_t)params->width;
+    size_t h = (size_t)params->height;
+    int segments = params->samples_per_pixel * bps;
+    if (w > SIZE_MAX / h || w * h > SIZE_MAX / (size_t)segments) {
+        set_error("Invalid argument: frame size overflows");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *plane_size = w * h;
+    *bytes_per_sample = bps;
+    *num_segments = segments;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Fills planes[c * bps + b] with the byte-plane holding byte b (little-endian
+ * order) of sample c. Segments run most significant byte first, so that is
+ * segment c * bps + (bps - 1 - b) of the scratch area at base.
+ */
+static void order_planes(uint8_t* base, size_t plane_size, int spp, int bps, uint8_t** planes) {
+    for (int c = 0; c < spp; c++) {
+        for (int b = 0; b < bps; b++) {
+            planes[c * bps + b] = base + (size_t)(c * bps + (bps - 1 - b)) * plane_size;
+        }
+    }
+}
+
+/**
+ * Whether the raw layout is the segment layout itself (single-byte
+ * samples, one plane per sample), so segments map to the caller's buffer.
+ */
+static int planes_are_raw(const rle_params_t* params, int bps) {
+    return bps == 1 &&
+           (params->samples_per_pixel == 1 ||
+            params->planar_configuration == RLE_PLANAR_SEPARATE);
+}
+
+/*============================================================================
+ * Decode
+ *============================================================================*/
+
+SHARPDICOM_API int rle_get_decode_size(
+    const rle_params_t* params,
+    size_t* output_size
+) {
+    if (output_size == NULL) {
+        set_error("Invalid argument: NULL output_size");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t plane_size;
+    int bps, segments;
+    int result = validate_params(params, &plane_size, &bps, &segments);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    *output_size = plane_size * (size_t)segments;
+    return SHARPDICOM_OK;
+}
+
+static int decode_frame(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const rle_params_t* params
+) {
+    if (input == NULL || output == NULL) {
+        set_error("Invalid argument: NULL input or output");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t plane_size;
+    int bps, segments;
+    int result = validate_params(params, &plane_size, &bps, &segments);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    size_t required = plane_size * (size_t)segments;
+    if (output_len < required) {
+        set_error_fmt("Output buffer too small: need %zu bytes, have %zu",
+                      required, output_len);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    if (input_len < RLE_HEADER_SIZE) {
+        set_error("RLE frame shorter than its 64-byte header");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    uint32_t count = read_le32(input);
+    if (count != (uint32_t)segments) {
+        set_error_fmt("RLE segment count %u does not match %d expected byte-planes",
+                      count, segments);
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+
+    size_t offsets[RLE_MAX_SEGMENTS + 1];
+    for (int s = 0; s < segments; s++) {
+        offsets[s] = read_le32(input + 4 + 4 * s);
+        if (offsets[s] < RLE_HEADER_SIZE || offsets[s] > input_len ||
+            (s > 0 && offsets[s] < offsets[s - 1])) {
+            set_error_fmt("RLE segment %d offset %zu out of range", s, offsets[s]);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+    }
+    offsets[segments] = input_len;
+
+    /* Decode straight into the output when it already is the plane layout */
+    uint8_t* scratch = NULL;
+    uint8_t* seg_base = output;
+    if (!planes_are_raw(params, bps)) {
+        scratch = (uint8_t*)allocator_alloc(required);
+        if (scratch == NULL) {
+            set_error("Failed to allocate RLE plane buffer");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        seg_base = scratch;
+    }
+
+    const rle_kernels_t* k = select_kernels();
+    for (int s = 0; s < segments; s++) {
+        size_t in = offsets[s];
+        size_t out = 0;
+        uint8_t* plane = seg_base + (size_t)s * plane_size;
+        if (k->expand(input, offsets[s + 1], &in, plane, plane_size, &out) != 0 ||
+            out < plane_size) {
+            set_error_fmt("RLE segment %d decodes to %zu of %zu bytes", s, out, plane_size);
+            allocator_free(scratch);
+            return SHARPDICOM_ERR_CORRUPT_DATA;
+        }
+    }
+
+    if (scratch != NULL) {
+        uint8_t* planes[RLE_MAX_SEGMENTS];
+        int spp = params->samples_per_pixel;
+        order_planes(scratch, plane_size, spp, bps, planes);
+        if (params->planar_configuration == RLE_PLANAR_SEPARATE) {
+            size_t sample_plane = plane_size * (size_t)bps;
+            for (int c = 0; c < spp; c++) {
+                k->merge((const uint8_t* const*)(planes + c * bps), bps, plane_size,
+                         output + (size_t)c * sample_plane);
+            }
+        } else {
+            k->merge((const uint8_t* const*)planes, segments, plane_size, output);
+        }
+        allocator_free(scratch);
+    }
+
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int rle_decode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const rle_params_t* params
+) {
+    int64_t start = codec_stats_start();
+    int result = decode_frame(input, input_len, output, output_len, params);
+    size_t decoded = 0;
+    if (result == SHARPDICOM_OK) {
+        rle_get_decode_size(params, &decoded);
+    }
+    codec_stats_record(SHARPDICOM_STATS_RLE, CODEC_STATS_DECODE, start,
+                       input_len, decoded, result);
+    return result;
+}
+
+/*============================================================================
+ * Encode
+ *============================================================================*/
+
+/**
+ * PackBits-encodes one row into output[*pos]. Runs of two or more start a
+ * replicate command; literals extend until a run of three is found, since a
+ * shorter run costs as much as it saves.
+ *
+ * @return 0 on success, -1 if output_len is exhausted
+ */
+static int encode_row(
+    const rle_kernels_t* k,
+    const uint8_t* row,
+    size_t len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* pos
+) {
+    size_t i = 0;
+    size_t o = *pos;
+
+    while (i < len) {
+        size_t avail = len - i;
+        size_t run = k->run_length(row + i, avail < RLE_MAX_RUN ? avail : RLE_MAX_RUN);
+        if (run >= 2) {
+            if (output_len - o < 2) {
+                return -1;
+            }
+            output[o++] = (uint8_t)(257 - run);
+            output[o++] = row[i];
+            i += run;
+        } else {
+            size_t literal = k->literal_length(row + i, avail, RLE_MAX_RUN);
+            if (output_len - o < literal + 1) {
+                return -1;
+            }
+            output[o++] = (uint8_t)(literal - 1);
+            memcpy(output + o, row + i, literal);
+            o += literal;
+            i += literal;
+        }
+    }
+
+    *pos = o;
+    return 0;
+}
+
+SHARPDICOM_API int rle_get_encode_bound(
+    const rle_params_t* params,
+    size_t* max_size
+) {
+    if (max_size == NULL) {
+        set_error("Invalid argument: NULL max_size");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t plane_size;
+    int bps, segments;
+    int result = validate_params(params, &plane_size, &bps, &segments);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    /* Worst case per row is all literals: one control byte per 128 bytes */
+    size_t w = (size_t)params->width;
+    size_t h = (size_t)params->height;
+    size_t row_bound = w + (w + RLE_MAX_RUN - 1) / RLE_MAX_RUN;
+    if (row_bound > (SIZE_MAX - RLE_HEADER_SIZE) / h / (size_t)segments - 1) {
+        set_error("Invalid argument: encode bound overflows");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Each segment may need one pad byte to reach an even length */
+    *max_size = RLE_HEADER_SIZE + (size_t)segments * (row_bound * h + 1);
+    return SHARPDICOM_OK;
+}
+
+static int encode_frame(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const rle_params_t* params
+) {
+    if (input == NULL || input_len == 0) {
+        set_error("Invalid argument: NULL or empty input");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (output == NULL || output_len == 0) {
+        set_error("Invalid argument: NULL or empty output buffer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (actual_size == NULL) {
+        set_error("Invalid argument: NULL actual_size pointer");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    size_t plane_size;
+    int bps, segments;
+    int result = validate_params(params, &plane_size, &bps, &segments);
+    if (result != SHARPDICOM_OK) {
+        return result;
+    }
+
+    size_t expected_input = plane_size * (size_t)segments;
+    if (input_len < expected_input) {
+        set_error_fmt("Input buffer too small: expected %zu bytes, have %zu",
+                      expected_input, input_len);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (output_len < RLE_HEADER_SIZE) {
+        set_error("Output buffer too small for the RLE header");
+        return SHARPDICOM_ERR_ENCODE_FAILED;
+    }
+
+    const rle_kernels_t* k = select_kernels();
+
+    /* Split the raw samples into segment-ordered byte-planes */
+    uint8_t* scratch = NULL;
+    const uint8_t* seg_base = input;
+    if (!planes_are_raw(params, bps)) {
+        scratch = (uint8_t*)allocator_alloc(expected_input);
+        if (scratch == NULL) {
+            set_error("Failed to allocate RLE plane buffer");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+
+        uint8_t* planes[RLE_MAX_SEGMENTS];
+        int spp = params->samples_per_pixel;
+        order_planes(scratch, plane_size, spp, bps, planes);
+        if (params->planar_configuration == RLE_PLANAR_SEPARATE) {
+            size_t sample_plane = plane_size * (size_t)bps;
+            for (int c = 0; c < spp; c++) {
+                k->split(input + (size_t)c * sample_plane, bps, plane_size,
+                         (uint8_t* const*)(planes + c * bps));
+            }
+        } else {
+            k->split(input, segments, plane_size, (uint8_t* const*)planes);
+        }
+        seg_base = scratch;
+    }
+
+    memset(output, 0, RLE_HEADER_SIZE);
+    write_le32(output, (uint32_t)segments);
+
+    size_t w = (size_t)params->width;
+    size_t pos = RLE_HEADER_SIZE;
+    for (int s = 0; s < segments; s++) {
+        if (pos > UINT32_MAX) {
+            set_error("RLE segment offset exceeds 32 bits");
+            allocator_free(scratch);
+            return SHARPDICOM_ERR_ENCODE_FAILED;
+        }
+        write_le32(output + 4 + 4 * s, (uint32_t)pos);
+
+        const uint8_t* plane = seg_base + (size_t)s * plane_size;
+        int overflow = 0;
+        for (int y = 0; y < params->height && !overflow; y++) {
+            overflow = encode_row(k, plane + (size_t)y * w, w, output, output_len, &pos);
+        }
+        /* Pad with a no-op control byte so readers that consume the whole
+         * segment do not mistake the pad for a literal */
+        if (!overflow && (pos & 1) != 0) {
+            if (pos < output_len) {
+                output[pos++] = 0x80;
+            } else {
+                overflow = 1;
+            }
+        }
+        if (overflow) {
+            set_error_fmt("Output buffer too small: %zu bytes exhausted in segment %d",
+                          output_len, s);
+            allocator_free(scratch);
+            return SHARPDICOM_ERR_ENCODE_FAILED;
+        }
+    }
+
+    allocator_free(scratch);
+    *actual_size = pos;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int rle_encode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const rle_params_t* params
+) {
+    int64_t start = codec_stats_start();
+    int result = encode_frame(input, input_len, output, output_len, actual_size, params);
+    codec_stats_record(SHARPDICOM_STATS_RLE, CODEC_STATS_ENCODE, start, input_len,
+                       result == SHARPDICOM_OK ? *actual_size : 0, result);
+    return result;
+}
+
+/*============================================================================
+ * Memory management
+ *============================================================================*/
+
+SHARPDICOM_API void rle_free(void* buffer) {
+    free(buffer);
+}
+
+/*============================================================================
+ * Kernel selection hooks
+ *============================================================================*/
+
+int rle_simd_level(void) {
+    return select_simd_level();
+}
+
+void rle_set_simd_mask(int mask) {
+    g_simd_mask = mask;
+    g_simd_level = -1;
+}
@@ -0,0 +1,177 @@
+/**
+ * RLE Lossless Codec API
+ *
+ * Native implementation of the DICOM RLE Lossless transfer syntax
+ * (PS3.5 Annex G, 1.2.840.10008.1.2.5). Each frame is a 64-byte header
+ * followed by up to 15 PackBits segments, one per byte-plane, ordered
+ * most significant byte first within each sample.
+ *
+ * No external library is required, so this module is always available
+ * (SHARPDICOM_HAS_RLE). Run detection, run expansion and byte-plane
+ * split/merge use SSE4.1 or NEON kernels when the CPU supports them.
+ *
+ * Thread Safety: All functions are thread-safe.
+ */
+
+#ifndef RLE_WRAPPER_H
+#define RLE_WRAPPER_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================
+ * RLE constants
+ *============================================================================*/
+
+/** Size of the RLE header preceding the segments */
+#define RLE_HEADER_SIZE         64
+
+/** Maximum number of segments (byte-planes) in one frame */
+#define RLE_MAX_SEGMENTS        15
+
+/** Planar configurations of the raw (decoded) pixel data */
+#define RLE_PLANAR_INTERLEAVED  0  /* Color-by-pixel: RGBRGB... */
+#define RLE_PLANAR_SEPARATE     1  /* Color-by-plane: RRR...GGG...BBB... */
+
+/*============================================================================
+ * RLE frame parameters
+ *============================================================================*/
+
+/**
+ * Describes the raw pixel data of one frame.
+ *
+ * The RLE stream does not record image geometry, so the caller supplies it
+ * from the DICOM dataset for both encode and decode. Raw samples are
+ * little-endian.
+ */
+typedef struct {
+    int width;                  /* Columns */
+    int height;                 /* Rows */
+    int samples_per_pixel;      /* Samples per pixel (1=grayscale, 3=RGB/YBR) */
+    int bits_allocated;         /* Bits allocated per sample (8, 16 or 32) */
+    int planar_configuration;   /* RLE_PLANAR_* layout of the raw data */
+} rle_params_t;
+
+/*============================================================================
+ * RLE API functions
+ *============================================================================*/
+
+/**
+ * Decodes one RLE Lossless frame to raw pixel data.
+ *
+ * Segments are recombined into samples_per_pixel samples of
+ * bits_allocated / 8 bytes each, laid out as params->planar_configuration
+ * requests. Use rle_get_decode_size() for the required output size.
+ *
+ * @param input         Pointer to the RLE frame (header and segments)
+ * @param input_len     Length of the frame in bytes
+ * @param output        Pointer to output buffer for decoded pixels
+ * @param output_len    Size of output buffer in bytes
+ * @param params        Frame geometry
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL pointers, bad params or
+ *           output buffer too small
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: Bad header, segment count mismatch
+ *           or a segment that does not fill its byte-plane
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int rle_decode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    const rle_params_t* params
+);
+
+/**
+ * Gets the required output buffer size for decoding.
+ *
+ * @param params        Frame geometry
+ * @param output_size   Pointer to receive required output buffer size
+ *
+ * @return SHARPDICOM_OK on success, or SHARPDICOM_ERR_INVALID_ARGUMENT
+ */
+SHARPDICOM_API int rle_get_decode_size(
+    const rle_params_t* params,
+    size_t* output_size
+);
+
+/**
+ * Encodes raw pixel data to one RLE Lossless frame.
+ *
+ * Each row of each byte-plane is encoded separately, as PS3.5 G.3.1
+ * requires, and every segment is padded to an even length. The output
+ * buffer must be pre-allocated by the caller; rle_get_encode_bound() gives
+ * a size that always suffices.
+ *
+ * @param input         Pointer to raw pixel data
+ * @param input_len     Length of input data in bytes
+ * @param output        Pointer to output buffer for the RLE frame
+ * @param output_len    Size of output buffer in bytes
+ * @param actual_size   Pointer to receive actual encoded size
+ * @param params        Frame geometry and raw layout
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL pointers, bad params or
+ *           input buffer too small
+ *         - SHARPDICOM_ERR_ENCODE_FAILED: Output buffer too small
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int rle_encode(
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    size_t* actual_size,
+    const rle_params_t* params
+);
+
+/**
+ * Gets the maximum encoded size for given parameters.
+ *
+ * @param params        Frame geometry
+ * @param max_size      Pointer to receive maximum encoded size
+ *
+ * @return SHARPDICOM_OK on success, or SHARPDICOM_ERR_INVALID_ARGUMENT
+ */
+SHARPDICOM_API int rle_get_encode_bound(
+    const rle_params_t* params,
+    size_t* max_size
+);
+
+/**
+ * Frees a buffer allocated by the RLE codec.
+ *
+ * Currently unused as all functions use caller-provided buffers,
+ * but provided for API symmetry with the other codec wrappers.
+ *
+ * @param buffer        Pointer to buffer to free (may be NULL)
+ */
+SHARPDICOM_API void rle_free(void* buffer);
+
+/*============================================================================
+ * Kernel selection (library-internal)
+ *============================================================================*/
+
+/**
+ * Returns the SHARPDICOM_SIMD_* flag of the kernel set in use
+ * (SHARPDICOM_SIMD_NONE for the scalar fallback).
+ */
+int rle_simd_level(void);
+
+/**
+ * Restricts kernel selection to the given SHARPDICOM_SIMD_* mask.
+ * Pass -1 to restore runtime detection. Intended for tests and benchmarks
+ * that compare kernel sets; not to be called while codecs are running.
+ */
+void rle_set_simd_mask(int mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RLE_WRAPPER_H */
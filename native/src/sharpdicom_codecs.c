@@ -2,12 +2,19 @@
  * SharpDicom Native Codecs - Core Implementation
  *
  * Provides version detection, feature detection, SIMD capability detection,
- * GPU dispatch, and thread-local error message handling.
+ * thread pool configuration, GPU dispatch, and thread-local error message
+ * handling.
  */
 
 #define SHARPDICOM_CODECS_EXPORTS
 #include "sharpdicom_codecs.h"
+#include "allocator.h"
+#include "codec_stats.h"
+#include "deflate_wrapper.h"
 #include "gpu_wrapper.h"
+#include "j2k_wrapper.h"
+#include "thread_pool.h"
+#include "video_wrapper.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -230,21 +237,43 @@ SHARPDICOM_API int sharpdicom_features(void) {
     features |= SHARPDICOM_HAS_JPEG;
 #endif
 
-    /* Set J2K flag when OpenJPEG is linked */
-#ifdef SHARPDICOM_WITH_J2K
-    features |= SHARPDICOM_HAS_J2K;
-#endif
+    /*
+     * Set J2K flags when OpenJPEG is linked. Queried from the wrapper because
+     * this unit is not compiled with the OpenJPEG feature flags.
+     */
+    if (j2k_version() != NULL) {
+        features |= SHARPDICOM_HAS_J2K;
+    }
+    if (j2k_get_default_threads() > 1) {
+        features |= SHARPDICOM_HAS_J2K_MT;
+    }
+    if (j2k_htj2k_support() & J2K_HTJ2K_DECODE) {
+        features |= SHARPDICOM_HAS_HTJ2K;
+    }
 
     /* Set JLS flag when CharLS is linked */
 #ifdef SHARPDICOM_WITH_JLS
     features |= SHARPDICOM_HAS_JLS;
 #endif
 
+    /* RLE is implemented natively and always available */
+    features |= SHARPDICOM_HAS_RLE;
+
+    /* Set Deflate flag when zlib-ng is linked (queried like J2K above) */
+    if (deflate_version() != NULL) {
+        features |= SHARPDICOM_HAS_DEFLATE;
+    }
+
     /* Set Video flag when FFmpeg is linked */
 #ifdef SHARPDICOM_WITH_MPEG
     features |= SHARPDICOM_HAS_VIDEO;
 #endif
 
+    /* Compiled-in hardware video decode only; opening devices is left to video_hw_support() */
+    if (video_hw_compiled_support() != VIDEO_HW_NONE) {
+        features |= SHARPDICOM_HAS_VIDEO_HW;
+    }
+
     /* Check GPU availability at runtime */
     if (gpu_available()) {
         features |= SHARPDICOM_HAS_GPU;
@@ -265,6 +294,58 @@ SHARPDICOM_API void sharpdicom_clear_error(void) {
     tls_error_message[0] = '\0';
 }
 
+/*============================================================================
+ * Thread pool exports
+ *
+ * These re-export the thread_pool configuration for the managed code.
+ *============================================================================*/
+
+SHARPDICOM_API int sharpdicom_set_thread_count(int32_t num_threads) {
+    return thread_pool_set_size(num_threads);
+}
+
+SHARPDICOM_API int32_t sharpdicom_get_thread_count(void) {
+    return thread_pool_budget();
+}
+
+SHARPDICOM_API int sharpdicom_set_thread_affinity(const uint64_t* cpu_mask, int32_t mask_words) {
+    return thread_pool_set_affinity(cpu_mask, mask_words);
+}
+
+SHARPDICOM_API int sharpdicom_set_numa_node(int32_t node) {
+    return thread_pool_set_numa_node(node);
+}
+
+SHARPDICOM_API int32_t sharpdicom_get_numa_node(void) {
+    return thread_pool_numa_node();
+}
+
+SHARPDICOM_API int32_t sharpdicom_numa_node_count(void) {
+    return thread_pool_numa_node_count();
+}
+
+/*============================================================================
+ * Memory allocation exports
+ *
+ * These re-export the allocator configuration for the managed code.
+ *============================================================================*/
+
+SHARPDICOM_API int sharpdicom_set_allocator(const sharpdicom_allocator_t* allocator) {
+    return allocator_set_backing(allocator);
+}
+
+SHARPDICOM_API void sharpdicom_set_thread_cache_limit(size_t bytes) {
+    allocator_set_cache_limit(bytes);
+}
+
+SHARPDICOM_API size_t sharpdicom_get_thread_cache_limit(void) {
+    return allocator_cache_limit();
+}
+
+SHARPDICOM_API void sharpdicom_release_thread_cache(void) {
+    allocator_release_thread_cache();
+}
+
 /*============================================================================
  * GPU dispatch exports
  *
@@ -300,6 +381,36 @@ SHARPDICOM_API int sharpdicom_gpu_j2k_decode(
     return status;
 }
 
+/*============================================================================
+ * Statistics exports
+ *
+ * Codec counters from codec_stats.c, dispatch counters from gpu_wrapper.c.
+ *============================================================================*/
+
+SHARPDICOM_API int sharpdicom_get_stats(sharpdicom_stats_t* stats) {
+    if (stats == NULL) {
+        set_error("Invalid argument: stats is NULL");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    codec_stats_snapshot(stats->codecs);
+
+    gpu_dispatch_stats_t dispatch;
+    if (gpu_get_dispatch_stats(&dispatch) == GPU_OK) {
+        stats->gpu_frames = dispatch.gpu_frames;
+        stats->cpu_frames = dispatch.cpu_frames;
+        stats->gpu_fallbacks = dispatch.gpu_fallbacks;
+        stats->gpu_queue_overflows = dispatch.queue_overflows;
+    }
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API void sharpdicom_reset_stats(void) {
+    codec_stats_reset();
+    gpu_reset_dispatch_counters();
+}
+
 /*============================================================================
  * Codec functions
  *
@@ -52,6 +52,8 @@ extern "C" {
 #define SHARPDICOM_HAS_DEFLATE      (1 << 5)  /* zlib-ng: Deflate compression */
 #define SHARPDICOM_HAS_GPU          (1 << 6)  /* GPU acceleration available */
 #define SHARPDICOM_HAS_HTJ2K        (1 << 7)  /* High-Throughput JPEG 2000 */
+#define SHARPDICOM_HAS_J2K_MT       (1 << 8)  /* OpenJPEG: multi-threaded decode (default > 1 worker) */
+#define SHARPDICOM_HAS_VIDEO_HW     (1 << 9)  /* FFmpeg: built with hardware video decode (see video_hw_support) */
 
 /*============================================================================
  * SIMD feature bitmap constants
@@ -174,6 +176,121 @@ SHARPDICOM_API const char* sharpdicom_last_error(void);
  */
 SHARPDICOM_API void sharpdicom_clear_error(void);
 
+/*============================================================================
+ * Thread pool functions
+ *
+ * One process-wide worker pool runs the library's parallel work (batch
+ * decode) and sets the thread count used by OpenJPEG and FFmpeg, so the
+ * library as a whole stays within one concurrency budget. Changes apply to
+ * operations started afterwards.
+ *============================================================================*/
+
+/**
+ * Sets the number of threads one operation may use, including the caller.
+ *
+ * @param num_threads Thread count (0 = one per CPU of the affinity mask or machine, max 256)
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT if negative
+ */
+SHARPDICOM_API int sharpdicom_set_thread_count(int32_t num_threads);
+
+/**
+ * Gets the number of threads one operation may use, including the caller.
+ *
+ * @return Resolved thread count (at least 1)
+ */
+SHARPDICOM_API int32_t sharpdicom_get_thread_count(void);
+
+/**
+ * Restricts worker threads to a set of CPUs. Clears any NUMA node binding.
+ * The calling threads themselves are never re-pinned.
+ *
+ * Bit n of the mask (word n / 64, bit n % 64) selects logical CPU n. On
+ * Windows, word g is the processor mask of processor group g.
+ *
+ * @param cpu_mask   Mask words, or NULL to allow every CPU
+ * @param mask_words Number of words in cpu_mask
+ * @return SHARPDICOM_OK, SHARPDICOM_ERR_INVALID_ARGUMENT for an empty mask,
+ *         or SHARPDICOM_ERR_UNSUPPORTED where threads cannot be pinned (macOS)
+ */
+SHARPDICOM_API int sharpdicom_set_thread_affinity(const uint64_t* cpu_mask, int32_t mask_words);
+
+/**
+ * Binds worker threads to the CPUs of one NUMA node, so that frames are
+ * decoded into node-local memory. Replaces any affinity mask.
+ *
+ * @param node NUMA node number, or -1 to remove the binding
+ * @return SHARPDICOM_OK, SHARPDICOM_ERR_INVALID_ARGUMENT for an unknown node,
+ *         or SHARPDICOM_ERR_UNSUPPORTED if the node's CPUs cannot be determined
+ */
+SHARPDICOM_API int sharpdicom_set_numa_node(int32_t node);
+
+/**
+ * Gets the NUMA node worker threads are bound to.
+ *
+ * @return Node number, or -1 if unbound
+ */
+SHARPDICOM_API int32_t sharpdicom_get_numa_node(void);
+
+/**
+ * Gets the number of NUMA nodes in the system.
+ *
+ * @return Node count (1 on non-NUMA systems)
+ */
+SHARPDICOM_API int32_t sharpdicom_numa_node_count(void);
+
+/*============================================================================
+ * Memory allocation functions
+ *
+ * The library's working memory and the internal allocations of OpenJPEG
+ * and zlib-ng go through one allocator. Blocks of 64 KiB and more are kept
+ * in a per-thread cache when freed and reused by later frames, so a steady
+ * stream of same-sized frames stops allocating from the heap after the
+ * first one. Buffers the library returns to the caller (released with
+ * j2k_free(), jls_free(), rle_free() or jpeg_free()) still come from the C
+ * heap.
+ *============================================================================*/
+
+/** Backing allocator for the library's memory */
+typedef struct {
+    /** Returns size bytes aligned for any type, or NULL */
+    void* (*alloc)(void* opaque, size_t size);
+    /** Releases a block returned by alloc */
+    void (*free)(void* opaque, void* ptr);
+    /** Passed to both callbacks */
+    void* opaque;
+} sharpdicom_allocator_t;
+
+/**
+ * Installs the allocator the library takes memory from. Must be called
+ * before any codec is used; the callbacks may be called from any thread.
+ *
+ * @param allocator Callbacks (copied), or NULL for the C heap
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT if a callback
+ *         is NULL or memory was already allocated
+ */
+SHARPDICOM_API int sharpdicom_set_allocator(const sharpdicom_allocator_t* allocator);
+
+/**
+ * Sets how many bytes of freed blocks each thread keeps for reuse.
+ * Blocks already cached stay until they are reused or released.
+ *
+ * @param bytes Per-thread limit (0 = no caching, default 64 MiB)
+ */
+SHARPDICOM_API void sharpdicom_set_thread_cache_limit(size_t bytes);
+
+/**
+ * Gets the per-thread cache limit.
+ *
+ * @return Limit in bytes
+ */
+SHARPDICOM_API size_t sharpdicom_get_thread_cache_limit(void);
+
+/**
+ * Returns the blocks cached by the calling thread to the allocator. A
+ * thread's cache is also released when the thread exits.
+ */
+SHARPDICOM_API void sharpdicom_release_thread_cache(void);
+
 /*============================================================================
  * GPU acceleration functions
  *============================================================================*/
@@ -219,6 +336,81 @@ SHARPDICOM_API int sharpdicom_gpu_j2k_decode(
     int* components
 );
 
+/*============================================================================
+ * Statistics functions
+ *
+ * Process-wide counters of the work done by each codec and of the GPU
+ * dispatch decisions, cheap enough to stay on in production and meant to
+ * be scraped periodically. Counters only grow until reset, so rates come
+ * from the difference between two snapshots.
+ *============================================================================*/
+
+/** Codec indices of sharpdicom_stats_t.codecs */
+#define SHARPDICOM_STATS_JPEG       0  /* libjpeg-turbo */
+#define SHARPDICOM_STATS_J2K        1  /* OpenJPEG / OpenJPH (CPU decodes, including GPU fallbacks) */
+#define SHARPDICOM_STATS_JLS        2  /* CharLS */
+#define SHARPDICOM_STATS_RLE        3  /* Native RLE */
+#define SHARPDICOM_STATS_VIDEO      4  /* FFmpeg */
+#define SHARPDICOM_STATS_DEFLATE    5  /* zlib-ng */
+#define SHARPDICOM_STATS_CODECS     6
+
+/**
+ * Counters of one direction of one codec.
+ *
+ * A call is one frame (or stream chunk) handed to the codec. A call that
+ * returns an error counts in both calls and errors; frames rejected before
+ * they reach the codec (bad arguments, unreadable headers) may not be
+ * counted at all.
+ */
+typedef struct {
+    /** Calls made */
+    uint64_t calls;
+    /** Calls that returned an error */
+    uint64_t errors;
+    /** Bytes read: compressed data for decode, raw samples for encode */
+    uint64_t bytes_in;
+    /** Bytes written by successful calls */
+    uint64_t bytes_out;
+    /** Wall time spent in the calls, in nanoseconds */
+    uint64_t time_ns;
+} sharpdicom_op_stats_t;
+
+/** Counters of one codec */
+typedef struct {
+    sharpdicom_op_stats_t decode;
+    sharpdicom_op_stats_t encode;
+} sharpdicom_codec_stats_t;
+
+/** Snapshot of the library counters */
+typedef struct {
+    /** Per-codec counters, indexed by SHARPDICOM_STATS_* */
+    sharpdicom_codec_stats_t codecs[SHARPDICOM_STATS_CODECS];
+    /** JPEG 2000 frames decoded on the GPU */
+    uint64_t gpu_frames;
+    /** JPEG 2000 frames the dispatcher sent to the CPU */
+    uint64_t cpu_frames;
+    /** GPU decodes that failed and were redone on the CPU */
+    uint64_t gpu_fallbacks;
+    /** Frames sent to the CPU because the GPU queues were full */
+    uint64_t gpu_queue_overflows;
+} sharpdicom_stats_t;
+
+/**
+ * Takes a snapshot of the counters. Counters are read one by one while
+ * other threads keep updating them, so related counters may be a call
+ * apart.
+ *
+ * @param stats Receives the counters
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT if stats is NULL
+ */
+SHARPDICOM_API int sharpdicom_get_stats(sharpdicom_stats_t* stats);
+
+/**
+ * Resets every counter to zero. The GPU dispatcher keeps the timings it
+ * has learned.
+ */
+SHARPDICOM_API void sharpdicom_reset_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,659 @@
+/**
+ * SharpDicom Shared Worker Pool Implementation
+ *
+ * Each loop is a job with one index range per participant slot. A range is
+ * a single 64-bit word (next << 32 | end) updated with compare-and-swap:
+ * its owner takes indices from the front, thieves cut off the back half.
+ * Open jobs sit in a FIFO list that idle workers claim slots from.
+ *
+ * Changing the size or placement bumps a generation number: idle workers of
+ * an older generation exit, and the next loop starts a fresh set with the
+ * new settings.
+ */
+
+/* pthread and sysconf() under -std=c11; sched_setaffinity() needs _GNU_SOURCE */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#elif !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+    #define _DARWIN_C_SOURCE
+#endif
+
+#include "thread_pool.h"
+#include "allocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Forward declarations from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+extern void set_error_fmt(const char* fmt, ...);
+
+/*============================================================================
+ * Platform threads, locks and atomics
+ *============================================================================*/
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+
+static CRITICAL_SECTION g_lock;
+static CONDITION_VARIABLE g_work_cond;
+static CONDITION_VARIABLE g_done_cond;
+static volatile LONG g_lock_init = 0;
+
+static void init_lock(void) {
+    /* Same one-time initialization as gpu_wrapper.c */
+    if (g_lock_init == 2) return;
+
+    LONG state = InterlockedCompareExchange(&g_lock_init, 1, 0);
+    if (state == 0) {
+        InitializeCriticalSection(&g_lock);
+        InitializeConditionVariable(&g_work_cond);
+        InitializeConditionVariable(&g_done_cond);
+        InterlockedExchange(&g_lock_init, 2);
+    } else {
+        while (g_lock_init != 2) {
+            Sleep(0);
+        }
+    }
+}
+
+static void lock(void) {
+    init_lock();
+    EnterCriticalSection(&g_lock);
+}
+
+static void unlock(void) {
+    LeaveCriticalSection(&g_lock);
+}
+
+static void wait_work(void) { SleepConditionVariableCS(&g_work_cond, &g_lock, INFINITE); }
+static void wait_done(void) { SleepConditionVariableCS(&g_done_cond, &g_lock, INFINITE); }
+static void signal_work(void) { WakeAllConditionVariable(&g_work_cond); }
+static void signal_done(void) { WakeAllConditionVariable(&g_done_cond); }
+
+static DWORD WINAPI worker_main(LPVOID arg);
+
+static int start_thread(void) {
+    HANDLE thread = CreateThread(NULL, 0, worker_main, NULL, 0, NULL);
+    if (thread == NULL) {
+        return 0;
+    }
+    CloseHandle(thread);
+    return 1;
+}
+
+static int32_t cpu_count(void) {
+    DWORD n = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    if (n < 1) return 1;
+    return (n > THREAD_POOL_MAX_THREADS) ? THREAD_POOL_MAX_THREADS : (int32_t)n;
+}
+
+/** Pin the current worker to one processor group of the mask (round-robin over groups) */
+static void apply_affinity(const uint64_t* mask, int32_t worker_index) {
+    int32_t groups = 0;
+    for (int32_t w = 0; w < THREAD_POOL_MASK_WORDS; w++) {
+        if (mask[w]) groups++;
+    }
+    if (groups == 0) return;
+
+    int32_t pick = worker_index % groups;
+    for (int32_t w = 0; w < THREAD_POOL_MASK_WORDS; w++) {
+        if (mask[w] && pick-- == 0) {
+            GROUP_AFFINITY affinity;
+            memset(&affinity, 0, sizeof(affinity));
+            affinity.Mask = (KAFFINITY)mask[w];
+            affinity.Group = (WORD)w;
+            SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL);
+            return;
+        }
+    }
+}
+
+static int32_t numa_nodes(void) {
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) return 1;
+    return (int32_t)highest + 1;
+}
+
+/** Processors of a NUMA node as mask words (word = processor group) */
+static int numa_node_mask(int32_t node, uint64_t* mask) {
+    GROUP_AFFINITY affinity;
+    if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity) ||
+        affinity.Group >= THREAD_POOL_MASK_WORDS) {
+        return 0;
+    }
+    mask[affinity.Group] = (uint64_t)affinity.Mask;
+    return affinity.Mask != 0;
+}
+
+#define range_load(p) ((uint64_t)InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0))
+#define range_store(p, v) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+
+static int range_cas(volatile uint64_t* p, uint64_t expected, uint64_t desired) {
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)p, (LONG64)desired,
+                                                  (LONG64)expected) == expected;
+}
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_done_cond = PTHREAD_COND_INITIALIZER;
+
+static void lock(void) {
+    pthread_mutex_lock(&g_lock);
+}
+
+static void unlock(void) {
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void wait_work(void) { pthread_cond_wait(&g_work_cond, &g_lock); }
+static void wait_done(void) { pthread_cond_wait(&g_done_cond, &g_lock); }
+static void signal_work(void) { pthread_cond_broadcast(&g_work_cond); }
+static void signal_done(void) { pthread_cond_broadcast(&g_done_cond); }
+
+static void* worker_main(void* arg);
+
+static int start_thread(void) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, worker_main, NULL) != 0) {
+        return 0;
+    }
+    pthread_detach(thread);
+    return 1;
+}
+
+static int32_t cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    return (n > THREAD_POOL_MAX_THREADS) ? THREAD_POOL_MAX_THREADS : (int32_t)n;
+}
+
+#if defined(__linux__)
+    #include <sched.h>
+
+/** Restrict the current worker to the CPUs of the mask */
+static void apply_affinity(const uint64_t* mask, int32_t worker_index) {
+    (void)worker_index;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int32_t cpu = 0; cpu < THREAD_POOL_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+        if (mask[cpu / 64] & ((uint64_t)1 << (cpu % 64))) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    /* CPUs outside the process's allowed set fail here; the worker then stays unpinned */
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+/**
+ * Parse a sysfs CPU list ("0-3,8,10-11") into mask bits.
+ * Returns the highest value seen, or -1 if the file cannot be read.
+ */
+static int32_t read_cpu_list(const char* path, uint64_t* mask) {
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+
+    int32_t highest = -1;
+    long lo, hi;
+    while (fscanf(f, "%ld", &lo) == 1) {
+        char sep = '\n';
+        hi = lo;
+        if (fscanf(f, "%c", &sep) == 1 && sep == '-') {
+            sep = '\n';
+            if (fscanf(f, "%ld%c", &hi, &sep) < 1) break;
+        }
+        for (long v = lo; v <= hi && v >= 0 && v < THREAD_POOL_MAX_CPUS; v++) {
+            if (mask) mask[v / 64] |= (uint64_t)1 << (v % 64);
+            if (v > highest) highest = (int32_t)v;
+        }
+        if (sep != ',') break;
+    }
+    fclose(f);
+    return highest;
+}
+
+static int32_t numa_nodes(void) {
+    int32_t highest = read_cpu_list("/sys/devices/system/node/online", NULL);
+    return (highest < 0) ? 1 : highest + 1;
+}
+
+static int numa_node_mask(int32_t node, uint64_t* mask) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", (int)node);
+    return read_cpu_list(path, mask) >= 0;
+}
+#else
+/* No thread placement API (e.g. macOS); placement requests report UNSUPPORTED */
+    #define THREAD_POOL_NO_AFFINITY 1
+
+static void apply_affinity(const uint64_t* mask, int32_t worker_index) {
+    (void)mask;
+    (void)worker_index;
+}
+
+static int32_t numa_nodes(void) {
+    return 1;
+}
+
+static int numa_node_mask(int32_t node, uint64_t* mask) {
+    (void)node;
+    (void)mask;
+    return 0;
+}
+#endif
+
+#define range_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define range_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static int range_cas(volatile uint64_t* p, uint64_t expected, uint64_t desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+/*============================================================================
+ * Jobs
+ *============================================================================*/
+
+/** One participant's share of a loop; padded to keep owners off each other's cache line */
+struct tp_range {
+    volatile uint64_t bounds;
+    char pad[56];
+};
+
+#define RANGE_PACK(next, end) (((uint64_t)(next) << 32) | (uint64_t)(end))
+#define RANGE_NEXT(v) ((uint32_t)((v) >> 32))
+#define RANGE_END(v) ((uint32_t)(v))
+
+struct tp_job {
+    thread_pool_task_fn task;
+    void* context;
+    struct tp_range* ranges;
+    int32_t slots;
+    /** Slots handed out (slot 0 is the caller's); guarded by g_lock */
+    int32_t claimed;
+    /** Workers inside the job; guarded by g_lock */
+    int32_t active;
+    /** Whether the job is in the open list; guarded by g_lock */
+    int queued;
+    struct tp_job* next;
+};
+
+/** Open jobs, oldest first; guarded by g_lock */
+static struct tp_job* g_jobs = NULL;
+static struct tp_job* g_jobs_tail = NULL;
+
+/** Workers of the current generation (pool threads besides callers); guarded by g_lock */
+static int32_t g_workers = 0;
+static int g_started = 0;
+
+/** Workers of the current generation that are running; guarded by g_lock */
+static int32_t g_joined = 0;
+
+/** Pool settings; guarded by g_lock */
+static uint32_t g_generation = 0;
+static int32_t g_size = 0;
+static int32_t g_numa_node = -1;
+static int g_has_mask = 0;
+static uint64_t g_mask[THREAD_POOL_MASK_WORDS];
+
+/** Set on pool workers so wrappers can avoid starting threads of their own */
+#if defined(_MSC_VER)
+static __declspec(thread) int tls_on_worker = 0;
+#else
+static __thread int tls_on_worker = 0;
+#endif
+
+static void unlink_job(struct tp_job* job) {
+    struct tp_job** link = &g_jobs;
+    struct tp_job* prev = NULL;
+    while (*link != job) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    *link = job->next;
+    if (g_jobs_tail == job) {
+        g_jobs_tail = prev;
+    }
+    job->next = NULL;
+    job->queued = 0;
+}
+
+/** Take the next index of a range; returns 0 once it is empty */
+static int range_pop(struct tp_range* range, uint32_t* index) {
+    for (;;) {
+        uint64_t v = range_load(&range->bounds);
+        uint32_t next = RANGE_NEXT(v);
+        uint32_t end = RANGE_END(v);
+        if (next >= end) {
+            return 0;
+        }
+        if (range_cas(&range->bounds, v, RANGE_PACK(next + 1, end))) {
+            *index = next;
+            return 1;
+        }
+    }
+}
+
+/**
+ * Move the back half of the fullest other range into an empty own range.
+ * Returns 0 once every range is empty.
+ */
+static int range_steal(struct tp_job* job, int32_t self) {
+    for (;;) {
+        int32_t victim = -1;
+        uint32_t best = 0;
+        for (int32_t i = 0; i < job->slots; i++) {
+            uint64_t v = range_load(&job->ranges[i].bounds);
+            uint32_t left = (RANGE_NEXT(v) < RANGE_END(v)) ? RANGE_END(v) - RANGE_NEXT(v) : 0;
+            if (i != self && left > best) {
+                best = left;
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return 0;
+        }
+
+        uint64_t v = range_load(&job->ranges[victim].bounds);
+        uint32_t next = RANGE_NEXT(v);
+        uint32_t end = RANGE_END(v);
+        if (next >= end) {
+            continue;
+        }
+        uint32_t mid = next + (end - next) / 2;
+        if (range_cas(&job->ranges[victim].bounds, v, RANGE_PACK(next, mid))) {
+            range_store(&job->ranges[self].bounds, RANGE_PACK(mid, end));
+            return 1;
+        }
+    }
+}
+
+/** Work on a job from a slot until no range has indices left */
+static void job_run(struct tp_job* job, int32_t slot) {
+    for (;;) {
+        uint32_t index;
+        if (range_pop(&job->ranges[slot], &index)) {
+            job->task(job->context, (size_t)index);
+        } else if (!range_steal(job, slot)) {
+            return;
+        }
+    }
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI worker_main(LPVOID arg) {
+#else
+static void* worker_main(void* arg) {
+#endif
+    (void)arg;
+    tls_on_worker = 1;
+
+    lock();
+    if (g_joined >= g_workers) {
+        /* Started for a generation that has since been replaced */
+        unlock();
+#if defined(_WIN32) || defined(_WIN64)
+        return 0;
+#else
+        return NULL;
+#endif
+    }
+    uint32_t generation = g_generation;
+    int32_t worker_index = g_joined++;
+    if (g_has_mask) {
+        uint64_t mask[THREAD_POOL_MASK_WORDS];
+        memcpy(mask, g_mask, sizeof(mask));
+        unlock();
+        apply_affinity(mask, worker_index);
+        lock();
+    }
+
+    for (;;) {
+        while (g_jobs == NULL && generation == g_generation) {
+            wait_work();
+        }
+        if (generation != g_generation) {
+            /* Replaced by a reconfiguration; not counted in g_workers any more */
+            break;
+        }
+
+        struct tp_job* job = g_jobs;
+        int32_t slot = job->claimed++;
+        if (job->claimed >= job->slots) {
+            unlink_job(job);
+        }
+        job->active++;
+        unlock();
+
+        job_run(job, slot);
+
+        lock();
+        if (--job->active == 0) {
+            signal_done();
+        }
+    }
+    unlock();
+#if defined(_WIN32) || defined(_WIN64)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/** Threads a loop may use, including the caller; caller must hold g_lock */
+static int32_t budget_locked(void) {
+    int32_t budget = g_size;
+    if (budget <= 0 && g_has_mask) {
+        budget = 0;
+        for (int32_t w = 0; w < THREAD_POOL_MASK_WORDS; w++) {
+            for (uint64_t bits = g_mask[w]; bits; bits &= bits - 1) {
+                budget++;
+            }
+        }
+    }
+    if (budget <= 0) budget = cpu_count();
+    return (budget > THREAD_POOL_MAX_THREADS) ? THREAD_POOL_MAX_THREADS : budget;
+}
+
+/** Start the workers on first use or after a reconfiguration; caller must hold g_lock */
+static void start_pool_locked(void) {
+    if (g_started) {
+        return;
+    }
+    g_started = 1;
+
+    int32_t wanted = budget_locked() - 1;
+    while (g_workers < wanted && start_thread()) {
+        g_workers++;
+    }
+}
+
+/** Retire the current workers; the next loop starts new ones. Caller must hold g_lock */
+static void restart_pool_locked(void) {
+    g_generation++;
+    g_workers = 0;
+    g_joined = 0;
+    g_started = 0;
+    signal_work();
+}
+
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+int thread_pool_parallel_for(
+    size_t count,
+    int32_t max_threads,
+    thread_pool_task_fn task,
+    void* context
+) {
+    if (!task || count > UINT32_MAX) {
+        set_error("Invalid parallel loop: NULL task or more than UINT32_MAX indices");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int32_t slots = 1;
+    if (count > 1 && max_threads != 1) {
+        lock();
+        start_pool_locked();
+        slots = g_workers + 1;
+        unlock();
+        if (max_threads > 0 && slots > max_threads) slots = max_threads;
+        if ((size_t)slots > count) slots = (int32_t)count;
+    }
+
+    struct tp_range* ranges = NULL;
+    if (slots > 1) {
+        ranges = (struct tp_range*)allocator_calloc((size_t)slots, sizeof(*ranges));
+    }
+    if (!ranges) {
+        /* Single thread requested, nothing to share, or no memory for ranges */
+        for (size_t i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return SHARPDICOM_OK;
+    }
+
+    struct tp_job job;
+    memset(&job, 0, sizeof(job));
+    job.task = task;
+    job.context = context;
+    job.ranges = ranges;
+    job.slots = slots;
+    job.claimed = 1;
+    for (int32_t i = 0; i < slots; i++) {
+        uint64_t begin = (uint64_t)count * (uint64_t)i / (uint64_t)slots;
+        uint64_t end = (uint64_t)count * (uint64_t)(i + 1) / (uint64_t)slots;
+        ranges[i].bounds = RANGE_PACK(begin, end);
+    }
+
+    lock();
+    job.queued = 1;
+    if (g_jobs_tail) g_jobs_tail->next = &job;
+    else g_jobs = &job;
+    g_jobs_tail = &job;
+    signal_work();
+    unlock();
+
+    job_run(&job, 0);
+
+    /* Unclaimed slots were drained by stealing; wait for workers still inside */
+    lock();
+    if (job.queued) {
+        unlink_job(&job);
+    }
+    while (job.active > 0) {
+        wait_done();
+    }
+    unlock();
+
+    allocator_free(ranges);
+    return SHARPDICOM_OK;
+}
+
+int32_t thread_pool_concurrency(void) {
+    lock();
+    start_pool_locked();
+    int32_t workers = g_workers;
+    unlock();
+    return workers + 1;
+}
+
+int32_t thread_pool_budget(void) {
+    lock();
+    int32_t budget = budget_locked();
+    unlock();
+    return budget;
+}
+
+int thread_pool_on_worker(void) {
+    return tls_on_worker;
+}
+
+int thread_pool_set_size(int32_t num_threads) {
+    if (num_threads < 0) {
+        set_error("Thread count cannot be negative");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    lock();
+    g_size = (num_threads > THREAD_POOL_MAX_THREADS) ? THREAD_POOL_MAX_THREADS : num_threads;
+    restart_pool_locked();
+    unlock();
+    return SHARPDICOM_OK;
+}
+
+int thread_pool_set_affinity(const uint64_t* cpu_mask, int32_t mask_words) {
+    uint64_t mask[THREAD_POOL_MASK_WORDS];
+    memset(mask, 0, sizeof(mask));
+
+    int any = 0;
+    if (cpu_mask && mask_words > 0) {
+        if (mask_words > THREAD_POOL_MASK_WORDS) mask_words = THREAD_POOL_MASK_WORDS;
+        for (int32_t w = 0; w < mask_words; w++) {
+            mask[w] = cpu_mask[w];
+            any |= (mask[w] != 0);
+        }
+        if (!any) {
+            set_error("CPU affinity mask selects no CPUs");
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+    }
+#ifdef THREAD_POOL_NO_AFFINITY
+    if (any) {
+        set_error("Thread affinity not supported on this platform");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+#endif
+
+    lock();
+    memcpy(g_mask, mask, sizeof(mask));
+    g_has_mask = any;
+    g_numa_node = -1;
+    restart_pool_locked();
+    unlock();
+    return SHARPDICOM_OK;
+}
+
+int thread_pool_set_numa_node(int32_t node) {
+    uint64_t mask[THREAD_POOL_MASK_WORDS];
+    memset(mask, 0, sizeof(mask));
+
+    if (node >= 0) {
+        if (node >= numa_nodes()) {
+            set_error_fmt("NUMA node %d does not exist", (int)node);
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+        if (!numa_node_mask(node, mask)) {
+            set_error_fmt("Cannot read the CPUs of NUMA node %d", (int)node);
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+    }
+
+    lock();
+    memcpy(g_mask, mask, sizeof(mask));
+    g_has_mask = (node >= 0);
+    g_numa_node = (node >= 0) ? node : -1;
+    restart_pool_locked();
+    unlock();
+    return SHARPDICOM_OK;
+}
+
+int32_t thread_pool_numa_node(void) {
+    lock();
+    int32_t node = g_numa_node;
+    unlock();
+    return node;
+}
+
+int32_t thread_pool_numa_node_count(void) {
+    return numa_nodes();
+}
@@ -0,0 +1,141 @@
+/**
+ * SharpDicom Shared Worker Pool
+ *
+ * Process-wide pool of worker threads that runs parallel loops for the
+ * batch entry points. A loop's index range is split evenly across the
+ * threads taking part; a thread that runs out of work steals the back half
+ * of the largest remaining share, so frames of uneven cost still balance.
+ *
+ * The calling thread always takes part in its own loop, so a loop finishes
+ * even while every worker is busy with other callers' loops, and a task may
+ * itself start a nested loop.
+ *
+ * Workers are started on first use and live until the pool is resized or
+ * moved to other CPUs. The codec wrappers size their own library threads
+ * (OpenJPEG, FFmpeg) from thread_pool_budget(), so the whole library works
+ * within one concurrency budget.
+ *
+ * Internal to the native library - not part of the exported API.
+ * Thread Safety: Loops may be started from any number of threads at once.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "sharpdicom_codecs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Upper bound on threads in the pool, including a loop's caller */
+#define THREAD_POOL_MAX_THREADS 256
+
+/** Highest CPU number + 1 that an affinity mask can address */
+#define THREAD_POOL_MAX_CPUS 1024
+
+/** 64-bit words in an affinity mask */
+#define THREAD_POOL_MASK_WORDS (THREAD_POOL_MAX_CPUS / 64)
+
+/**
+ * Loop body, called once per index.
+ *
+ * @param context       Caller context passed to thread_pool_parallel_for()
+ * @param index         Index in [0, count)
+ */
+typedef void (*thread_pool_task_fn)(void* context, size_t index);
+
+/**
+ * Run task(context, i) for every i in [0, count) and wait for all of them.
+ *
+ * Falls back to running every index on the calling thread if the pool
+ * cannot be started.
+ *
+ * @param count         Number of indices (at most UINT32_MAX)
+ * @param max_threads   Threads to use including the caller (0 = all, 1 = caller only)
+ * @param task          Loop body
+ * @param context       Passed to every task call
+ *
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT for a NULL task or count too large
+ */
+int thread_pool_parallel_for(
+    size_t count,
+    int32_t max_threads,
+    thread_pool_task_fn task,
+    void* context
+);
+
+/**
+ * Threads a loop can run on, including the caller.
+ *
+ * @return Pool workers + 1 (at least 1)
+ */
+int32_t thread_pool_concurrency(void);
+
+/**
+ * Threads one operation may use, including the caller, without starting
+ * the pool. Library threads outside the pool are sized from this.
+ *
+ * @return Configured size, else CPUs in the affinity mask, else the CPU count
+ */
+int32_t thread_pool_budget(void);
+
+/**
+ * Whether the current thread is a pool worker. Work running on a worker is
+ * already parallel, so it should not start threads of its own.
+ *
+ * @return 1 on a pool worker, 0 otherwise
+ */
+int thread_pool_on_worker(void);
+
+/**
+ * Sets the number of threads a loop may use, including the caller.
+ *
+ * @param num_threads   Thread count (0 = one per CPU of the affinity mask or machine)
+ *
+ * @return SHARPDICOM_OK, or SHARPDICOM_ERR_INVALID_ARGUMENT if negative
+ */
+int thread_pool_set_size(int32_t num_threads);
+
+/**
+ * Restricts pool workers to a set of CPUs. Clears any NUMA node setting.
+ *
+ * Bit n of the mask (word n / 64, bit n % 64) selects logical CPU n; on
+ * Windows, word g is the processor mask of group g and each worker is
+ * placed in one group.
+ *
+ * @param cpu_mask      Mask words, or NULL to let workers run on any CPU
+ * @param mask_words    Number of words in cpu_mask (extra words beyond THREAD_POOL_MASK_WORDS are ignored)
+ *
+ * @return SHARPDICOM_OK, SHARPDICOM_ERR_INVALID_ARGUMENT for an empty mask, or
+ *         SHARPDICOM_ERR_UNSUPPORTED where threads cannot be pinned
+ */
+int thread_pool_set_affinity(const uint64_t* cpu_mask, int32_t mask_words);
+
+/**
+ * Restricts pool workers to the CPUs of one NUMA node. Replaces any
+ * affinity mask. Workers then allocate their codec buffers from that node's
+ * memory under the usual first-touch policy.
+ *
+ * @param node          NUMA node number, or -1 to clear
+ *
+ * @return SHARPDICOM_OK, SHARPDICOM_ERR_INVALID_ARGUMENT for a node that does
+ *         not exist, or SHARPDICOM_ERR_UNSUPPORTED if its CPUs cannot be read
+ */
+int thread_pool_set_numa_node(int32_t node);
+
+/**
+ * @return NUMA node the pool is bound to, or -1
+ */
+int32_t thread_pool_numa_node(void);
+
+/**
+ * @return Number of NUMA nodes (1 on non-NUMA systems)
+ */
+int32_t thread_pool_numa_node_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREAD_POOL_H */
@@ -0,0 +1,911 @@
+/**
+ * SharpDicom Native Transcode Implementation
+ *
+ * A frame is decoded into a scratch buffer and encoded from it, with the
+ * frame geometry carried between the two in a decoded_frame. JPEG-LS
+ * frames without interleave decode to planes; planes are reordered in a
+ * second per-thread buffer only when the target needs another layout.
+ *
+ * The batch pipeline keeps workers + 1 scratch slots. Workers never wait
+ * for a stage that nobody is running: they only block while another
+ * worker is decoding or encoding, so a batch on one thread (or on fewer
+ * pool workers than requested) simply alternates decode and encode.
+ *
+ * Per-thread scratch and JPEG-LS codecs are released from a thread-exit
+ * destructor (pthread key / fiber-local storage), like the allocator's
+ * thread cache, so retired pool workers do not leak them.
+ */
+
+/* pthread_key_create() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#define SHARPDICOM_CODECS_EXPORTS
+#include "transcode.h"
+#include "allocator.h"
+#include "jpeg_wrapper.h"
+#include "jls_wrapper.h"
+#include "thread_pool.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Forward declarations from sharpdicom_codecs.c */
+extern void set_error(const char* message);
+extern void set_error_fmt(const char* fmt, ...);
+
+#if defined(_MSC_VER)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #define claim_flag(p) (InterlockedCompareExchange((volatile LONG*)(p), 1, 0) == 0)
+
+typedef CRITICAL_SECTION pipeline_mutex;
+typedef CONDITION_VARIABLE pipeline_cond;
+
+static void pipeline_sync_init(pipeline_mutex* m, pipeline_cond* c) {
+    InitializeCriticalSection(m);
+    InitializeConditionVariable(c);
+}
+static void pipeline_sync_destroy(pipeline_mutex* m, pipeline_cond* c) {
+    (void)c;
+    DeleteCriticalSection(m);
+}
+static void pipeline_lock(pipeline_mutex* m) { EnterCriticalSection(m); }
+static void pipeline_unlock(pipeline_mutex* m) { LeaveCriticalSection(m); }
+static void pipeline_wait(pipeline_cond* c, pipeline_mutex* m) { SleepConditionVariableCS(c, m, INFINITE); }
+static void pipeline_wake(pipeline_cond* c) { WakeAllConditionVariable(c); }
+
+#else
+    #include <pthread.h>
+
+    static int claim_flag(volatile int32_t* p) {
+        int32_t expected = 0;
+        return __atomic_compare_exchange_n(p, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+
+typedef pthread_mutex_t pipeline_mutex;
+typedef pthread_cond_t pipeline_cond;
+
+static void pipeline_sync_init(pipeline_mutex* m, pipeline_cond* c) {
+    pthread_mutex_init(m, NULL);
+    pthread_cond_init(c, NULL);
+}
+static void pipeline_sync_destroy(pipeline_mutex* m, pipeline_cond* c) {
+    pthread_cond_destroy(c);
+    pthread_mutex_destroy(m);
+}
+static void pipeline_lock(pipeline_mutex* m) { pthread_mutex_lock(m); }
+static void pipeline_unlock(pipeline_mutex* m) { pthread_mutex_unlock(m); }
+static void pipeline_wait(pipeline_cond* c, pipeline_mutex* m) { pthread_cond_wait(c, m); }
+static void pipeline_wake(pipeline_cond* c) { pthread_cond_broadcast(c); }
+
+#endif
+
+/** Default JPEG target quality, as recommended for medical images in jpeg_wrapper.h */
+#define TRANSCODE_DEFAULT_JPEG_QUALITY 90
+
+/*============================================================================
+ * Scratch buffers
+ *============================================================================*/
+
+/** Buffer that only ever grows */
+typedef struct {
+    uint8_t* data;
+    size_t capacity;
+} scratch_buffer;
+
+#define STATE_UNREGISTERED  0
+#define STATE_ACTIVE        1  /* Released when the thread exits */
+#define STATE_CLOSED        2  /* Thread is exiting, or no exit hook was available */
+
+/** Scratch and codecs of the current thread (created on first use) */
+typedef struct {
+    /** Decode scratch of transcode() */
+    scratch_buffer decode_scratch;
+    /** Plane reordering scratch */
+    scratch_buffer reorder_scratch;
+    /** Reused JPEG-LS codecs */
+    jls_decoder_t* jls_decoder;
+    jls_encoder_t* jls_encoder;
+    int32_t state;
+} thread_state;
+
+static THREAD_LOCAL thread_state tls_state;
+
+static void thread_state_release(thread_state* state) {
+    allocator_free(state->decode_scratch.data);
+    allocator_free(state->reorder_scratch.data);
+    jls_decoder_destroy(state->jls_decoder);
+    jls_encoder_destroy(state->jls_encoder);
+    memset(&state->decode_scratch, 0, sizeof(state->decode_scratch));
+    memset(&state->reorder_scratch, 0, sizeof(state->reorder_scratch));
+    state->jls_decoder = NULL;
+    state->jls_encoder = NULL;
+}
+
+static void thread_state_exit(thread_state* state) {
+    thread_state_release(state);
+    /* Calls from later destructors on this thread release as they finish */
+    state->state = STATE_CLOSED;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+static DWORD g_state_fls = FLS_OUT_OF_INDEXES;
+static volatile LONG g_state_fls_init = 0;
+
+static VOID NTAPI state_fls_callback(PVOID data) {
+    if (data != NULL) thread_state_exit((thread_state*)data);
+}
+
+static int register_thread_exit(thread_state* state) {
+    /* Same one-time initialization as allocator.c */
+    if (g_state_fls_init != 2) {
+        LONG init = InterlockedCompareExchange(&g_state_fls_init, 1, 0);
+        if (init == 0) {
+            g_state_fls = FlsAlloc(state_fls_callback);
+            InterlockedExchange(&g_state_fls_init, 2);
+        } else {
+            while (g_state_fls_init != 2) {
+                Sleep(0);
+            }
+        }
+    }
+    return g_state_fls != FLS_OUT_OF_INDEXES && FlsSetValue(g_state_fls, state);
+}
+#else
+
+static pthread_key_t g_state_key;
+static pthread_once_t g_state_key_once = PTHREAD_ONCE_INIT;
+static int g_state_key_valid = 0;
+
+static void state_key_destructor(void* data) {
+    thread_state_exit((thread_state*)data);
+}
+
+static void state_key_create(void) {
+    g_state_key_valid = (pthread_key_create(&g_state_key, state_key_destructor) == 0);
+}
+
+static int register_thread_exit(thread_state* state) {
+    pthread_once(&g_state_key_once, state_key_create);
+    return g_state_key_valid && pthread_setspecific(g_state_key, state) == 0;
+}
+#endif
+
+/**
+ * Gets the calling thread's state at the start of a call, registering the
+ * thread-exit hook on first use.
+ */
+static thread_state* thread_state_begin(void) {
+    thread_state* state = &tls_state;
+    if (state->state == STATE_UNREGISTERED) {
+        state->state = register_thread_exit(state) ? STATE_ACTIVE : STATE_CLOSED;
+    }
+    return state;
+}
+
+/** Ends a call; without the exit hook the state would leak with its thread, so it is not kept */
+static void thread_state_end(thread_state* state) {
+    if (state->state != STATE_ACTIVE) {
+        thread_state_release(state);
+    }
+}
+
+static int scratch_reserve(scratch_buffer* scratch, size_t size) {
+    if (size <= scratch->capacity) {
+        return SHARPDICOM_OK;
+    }
+    uint8_t* data = (uint8_t*)allocator_realloc(scratch->data, size);
+    if (!data) {
+        set_error("Failed to allocate transcode scratch buffer");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    scratch->data = data;
+    scratch->capacity = size;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Makes room for an encoder that needs its whole bound up front. Nothing in
+ * the output is kept, so the grow callback is told no bytes are in use.
+ */
+static int output_reserve(J2kOutputBuffer* output, size_t size) {
+    if (size <= output->capacity && output->data) {
+        return SHARPDICOM_OK;
+    }
+    size_t capacity = size;
+    uint8_t* data;
+    if (output->grow) {
+        data = output->grow(output->opaque, output->data, 0, size, &capacity);
+    } else {
+        data = (uint8_t*)realloc(output->data, size);
+    }
+    if (!data || capacity < size) {
+        set_error("Failed to grow transcode output buffer");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    output->data = data;
+    output->capacity = capacity;
+    return SHARPDICOM_OK;
+}
+
+/*============================================================================
+ * Decode stage
+ *============================================================================*/
+
+/** Geometry and sample layout of a frame in a scratch buffer */
+typedef struct {
+    int32_t width;
+    int32_t height;
+    int32_t components;
+    int32_t precision;
+    int32_t bytes_per_sample;
+    int32_t is_signed;
+    /** Components stored as separate planes instead of interleaved */
+    int32_t planar;
+    size_t size;
+} decoded_frame;
+
+static int decode_jpeg_frame(
+    const uint8_t* input, size_t input_len,
+    const transcode_options_t* options,
+    scratch_buffer* scratch,
+    decoded_frame* frame
+) {
+    if (input_len > INT_MAX) {
+        set_error("JPEG frame too large");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int width = 0, height = 0, components = 0, subsampling = 0;
+    int status = jpeg_decode_header(input, (int)input_len, &width, &height, &components, &subsampling);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    /* Gray frames may be expanded to RGB, so reserve at least three samples per pixel */
+    size_t bound = (size_t)width * (size_t)height * (size_t)(components > 3 ? components : 3);
+    status = scratch_reserve(scratch, bound);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    int capacity = (scratch->capacity > INT_MAX) ? INT_MAX : (int)scratch->capacity;
+    status = jpeg_decode(input, (int)input_len, scratch->data, capacity,
+                         &width, &height, &components, options->jpeg_colorspace);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    frame->width = width;
+    frame->height = height;
+    frame->components = components;
+    frame->precision = 8;
+    frame->bytes_per_sample = 1;
+    frame->size = (size_t)width * (size_t)height * (size_t)components;
+    return SHARPDICOM_OK;
+}
+
+static int decode_jls_frame(
+    const uint8_t* input, size_t input_len,
+    scratch_buffer* scratch,
+    decoded_frame* frame
+) {
+    if (tls_state.jls_decoder == NULL) {
+        int status = jls_decoder_create(&tls_state.jls_decoder);
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+    }
+
+    size_t size = 0;
+    jls_decode_params_t params;
+    memset(&params, 0, sizeof(params));
+    int status = jls_decoder_read_header(tls_state.jls_decoder, input, input_len, &size, &params);
+    if (status == SHARPDICOM_OK) {
+        status = scratch_reserve(scratch, size);
+    }
+    if (status == SHARPDICOM_OK) {
+        status = jls_decoder_decode(tls_state.jls_decoder, scratch->data, scratch->capacity);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    frame->width = params.width;
+    frame->height = params.height;
+    frame->components = params.components;
+    frame->precision = params.bits_per_sample;
+    frame->bytes_per_sample = (params.bits_per_sample <= 8) ? 1 : 2;
+    frame->planar = (params.components > 1 && params.interleave_mode == JLS_INTERLEAVE_NONE);
+    frame->size = size;
+    return SHARPDICOM_OK;
+}
+
+static int decode_j2k_frame(
+    const uint8_t* input, size_t input_len,
+    const J2kDecodeOptions* j2k_options,
+    scratch_buffer* scratch,
+    decoded_frame* frame
+) {
+    /* The encoder needs stored samples, never display pixels */
+    J2kDecodeOptions decode_options = *j2k_options;
+    decode_options.display = NULL;
+
+    j2k_decoder_t* decoder = NULL;
+    int status = j2k_decoder_create(&decode_options, &decoder);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    J2kImageInfo info;
+    int32_t width = 0, height = 0, components = 0;
+    status = j2k_decoder_set_input(decoder, input, input_len);
+    if (status == SHARPDICOM_OK) {
+        status = j2k_decoder_get_info(decoder, &info);
+    }
+    size_t bytes_per_sample = 1;
+    if (status == SHARPDICOM_OK) {
+        /* A reduced decode is at most the full size shifted down, rounded up */
+        int32_t reduce = (j2k_options->reduce > 0 && j2k_options->reduce < 31) ? j2k_options->reduce : 0;
+        size_t reduced_width = ((size_t)info.width + ((size_t)1 << reduce) - 1) >> reduce;
+        size_t reduced_height = ((size_t)info.height + ((size_t)1 << reduce) - 1) >> reduce;
+        bytes_per_sample = (info.bits_per_component <= 8) ? 1 : 2;
+        status = scratch_reserve(scratch, reduced_width * reduced_height *
+                                          (size_t)info.num_components * bytes_per_sample);
+    }
+    if (status == SHARPDICOM_OK) {
+        status = j2k_decoder_decode(decoder, scratch->data, scratch->capacity, &width, &height, &components);
+    }
+    j2k_decoder_destroy(decoder);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    frame->width = width;
+    frame->height = height;
+    frame->components = components;
+    frame->precision = info.bits_per_component;
+    frame->bytes_per_sample = (int32_t)bytes_per_sample;
+    frame->is_signed = info.is_signed;
+    frame->size = (size_t)width * (size_t)height * (size_t)components * bytes_per_sample;
+    return SHARPDICOM_OK;
+}
+
+static int decode_rle_frame(
+    const uint8_t* input, size_t input_len,
+    const rle_params_t* source,
+    scratch_buffer* scratch,
+    decoded_frame* frame
+) {
+    rle_params_t params = *source;
+    params.planar_configuration = RLE_PLANAR_INTERLEAVED;
+
+    size_t size = 0;
+    int status = rle_get_decode_size(&params, &size);
+    if (status == SHARPDICOM_OK) {
+        status = scratch_reserve(scratch, size);
+    }
+    if (status == SHARPDICOM_OK) {
+        status = rle_decode(input, input_len, scratch->data, scratch->capacity, &params);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    frame->width = params.width;
+    frame->height = params.height;
+    frame->components = params.samples_per_pixel;
+    frame->precision = params.bits_allocated;
+    frame->bytes_per_sample = params.bits_allocated / 8;
+    frame->size = size;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Decodes one frame into scratch and applies the bits_stored override.
+ */
+static int decode_stage(
+    const uint8_t* input, size_t input_len,
+    const transcode_options_t* options,
+    scratch_buffer* scratch,
+    decoded_frame* frame
+) {
+    memset(frame, 0, sizeof(*frame));
+    if (!input || input_len == 0) {
+        set_error("Invalid transcode frame: NULL buffer or empty input");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    int status;
+    switch (options->source_codec) {
+        case BATCH_CODEC_JPEG:
+            status = decode_jpeg_frame(input, input_len, options, scratch, frame);
+            break;
+        case BATCH_CODEC_JPEG_LS:
+            status = decode_jls_frame(input, input_len, scratch, frame);
+            break;
+        case BATCH_CODEC_J2K:
+            status = decode_j2k_frame(input, input_len, &options->j2k_decode, scratch, frame);
+            break;
+        default:
+            status = decode_rle_frame(input, input_len, &options->rle, scratch, frame);
+            break;
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    if (options->bits_stored > 0) {
+        if (options->bits_stored > frame->bytes_per_sample * 8) {
+            set_error_fmt("bits_stored %d exceeds the %d-bit decoded samples",
+                          options->bits_stored, frame->bytes_per_sample * 8);
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+        frame->precision = options->bits_stored;
+    }
+    return SHARPDICOM_OK;
+}
+
+/*============================================================================
+ * Encode stage
+ *============================================================================*/
+
+/**
+ * Converts between planes and interleaved samples.
+ */
+static void reorder_samples(
+    const uint8_t* src, uint8_t* dst,
+    size_t pixels, size_t components, size_t bytes_per_sample,
+    int to_planar
+) {
+    for (size_t c = 0; c < components; c++) {
+        for (size_t i = 0; i < pixels; i++) {
+            size_t planar = (c * pixels + i) * bytes_per_sample;
+            size_t interleaved = (i * components + c) * bytes_per_sample;
+            if (to_planar) {
+                memcpy(dst + planar, src + interleaved, bytes_per_sample);
+            } else {
+                memcpy(dst + interleaved, src + planar, bytes_per_sample);
+            }
+        }
+    }
+}
+
+/**
+ * Returns the frame's samples in the requested layout, reordering them into
+ * the thread's reorder scratch if needed.
+ */
+static int frame_samples(
+    const decoded_frame* frame, const uint8_t* data,
+    int planar,
+    const uint8_t** samples
+) {
+    if (frame->components <= 1 || frame->planar == planar) {
+        *samples = data;
+        return SHARPDICOM_OK;
+    }
+    int status = scratch_reserve(&tls_state.reorder_scratch, frame->size);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    reorder_samples(data, tls_state.reorder_scratch.data,
+                    (size_t)frame->width * (size_t)frame->height,
+                    (size_t)frame->components, (size_t)frame->bytes_per_sample, planar);
+    *samples = tls_state.reorder_scratch.data;
+    return SHARPDICOM_OK;
+}
+
+static int encode_jpeg_frame(
+    const decoded_frame* frame, const uint8_t* samples,
+    const transcode_options_t* options,
+    J2kOutputBuffer* output
+) {
+    if (frame->bytes_per_sample != 1) {
+        set_error_fmt("JPEG target requires 8-bit samples (frame has %d bits)", frame->precision);
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    int bound = 0;
+    int status = jpeg_get_encode_bound(frame->width, frame->height, frame->components,
+                                       options->jpeg_subsampling, &bound);
+    if (status == SHARPDICOM_OK) {
+        status = output_reserve(output, (size_t)bound);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    int quality = (options->jpeg_quality > 0) ? options->jpeg_quality : TRANSCODE_DEFAULT_JPEG_QUALITY;
+    int capacity = (output->capacity > INT_MAX) ? INT_MAX : (int)output->capacity;
+    int size = 0;
+    status = jpeg_encode_to_buffer(samples, frame->width, frame->height, frame->components,
+                                   output->data, capacity, &size, quality, options->jpeg_subsampling);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    output->size = (size_t)size;
+    return SHARPDICOM_OK;
+}
+
+static int encode_jls_frame(
+    const decoded_frame* frame, const uint8_t* samples,
+    const transcode_options_t* options,
+    J2kOutputBuffer* output
+) {
+    if (tls_state.jls_encoder == NULL) {
+        int status = jls_encoder_create(&tls_state.jls_encoder);
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+    }
+
+    jls_encode_params_t params;
+    params.width = frame->width;
+    params.height = frame->height;
+    params.components = frame->components;
+    params.bits_per_sample = frame->precision;
+    params.near_lossless = options->jls_near_lossless;
+    params.interleave_mode = (frame->components > 1) ? options->jls_interleave_mode : JLS_INTERLEAVE_NONE;
+
+    size_t bound = 0;
+    int status = jls_get_encode_bound(&params, &bound);
+    if (status == SHARPDICOM_OK) {
+        status = output_reserve(output, bound);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    size_t size = 0;
+    status = jls_encoder_encode(tls_state.jls_encoder, samples, frame->size,
+                                output->data, output->capacity, &size, &params);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    output->size = size;
+    return SHARPDICOM_OK;
+}
+
+static int encode_rle_frame(
+    const decoded_frame* frame, const uint8_t* samples,
+    J2kOutputBuffer* output
+) {
+    rle_params_t params;
+    params.width = frame->width;
+    params.height = frame->height;
+    params.samples_per_pixel = frame->components;
+    params.bits_allocated = frame->bytes_per_sample * 8;
+    params.planar_configuration = frame->planar ? RLE_PLANAR_SEPARATE : RLE_PLANAR_INTERLEAVED;
+
+    size_t bound = 0;
+    int status = rle_get_encode_bound(&params, &bound);
+    if (status == SHARPDICOM_OK) {
+        status = output_reserve(output, bound);
+    }
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+
+    size_t size = 0;
+    status = rle_encode(samples, frame->size, output->data, output->capacity, &size, &params);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    output->size = size;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Encodes a decoded frame to the target codec and fills the result.
+ */
+static int encode_stage(
+    const decoded_frame* frame, const uint8_t* data,
+    const transcode_options_t* options,
+    J2kOutputBuffer* output,
+    transcode_result_t* result
+) {
+    output->size = 0;
+    if (options->target_codec != BATCH_CODEC_RLE && frame->bytes_per_sample > 2) {
+        set_error("Only an RLE target takes 32-bit samples");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    /* RLE encodes either layout; JPEG-LS without interleave wants planes */
+    int planar = frame->planar;
+    if (options->target_codec == BATCH_CODEC_JPEG_LS) {
+        planar = (options->jls_interleave_mode == JLS_INTERLEAVE_NONE);
+    } else if (options->target_codec != BATCH_CODEC_RLE) {
+        planar = 0;
+    }
+    const uint8_t* samples = NULL;
+    int status = frame_samples(frame, data, planar, &samples);
+    if (status != SHARPDICOM_OK) {
+        return status;
+    }
+    decoded_frame layout = *frame;
+    layout.planar = planar;
+
+    switch (options->target_codec) {
+        case BATCH_CODEC_JPEG:
+            status = encode_jpeg_frame(&layout, samples, options, output);
+            break;
+        case BATCH_CODEC_JPEG_LS:
+            status = encode_jls_frame(&layout, samples, options, output);
+            break;
+        case BATCH_CODEC_J2K:
+            status = j2k_encode_to_buffer(samples, layout.size, layout.width, layout.height,
+                                          layout.components, layout.precision, layout.is_signed,
+                                          &options->j2k_encode, output);
+            break;
+        default:
+            status = encode_rle_frame(&layout, samples, output);
+            break;
+    }
+    if (status != SHARPDICOM_OK) {
+        output->size = 0;
+        return status;
+    }
+
+    result->width = frame->width;
+    result->height = frame->height;
+    result->num_components = frame->components;
+    result->precision = frame->precision;
+    result->output_size = output->size;
+    return SHARPDICOM_OK;
+}
+
+/*============================================================================
+ * Batch pipeline
+ *============================================================================*/
+
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_DECODING,
+    SLOT_DECODED,
+    SLOT_ENCODING
+} slot_state;
+
+/** Scratch buffer holding one frame between the stages */
+typedef struct {
+    scratch_buffer buffer;
+    decoded_frame frame;
+    int frame_index;
+    slot_state state;
+} pipeline_slot;
+
+typedef struct {
+    const uint8_t** inputs;
+    const size_t* input_lens;
+    int count;
+    transcode_options_t options;
+    J2kOutputBuffer* outputs;
+    transcode_result_t* results;
+
+    pipeline_slot* slots;
+    int num_slots;
+    /** Next frame to decode */
+    int next_frame;
+    /** Slots being decoded or encoded */
+    int active;
+    pipeline_mutex mutex;
+    pipeline_cond changed;
+
+    /** Set by the first frame to fail, which then owns 'error' */
+    volatile int32_t error_claimed;
+    char error[256];
+} pipeline_context;
+
+static void record_failure(pipeline_context* ctx, transcode_result_t* result, int status) {
+    result->status = status;
+    if (claim_flag(&ctx->error_claimed)) {
+        /* The message is in this thread's error slot; hand it to the caller */
+        const char* message = sharpdicom_last_error();
+        strncpy(ctx->error, message ? message : "Batch frame transcode failed", sizeof(ctx->error) - 1);
+        ctx->error[sizeof(ctx->error) - 1] = '\0';
+    }
+}
+
+/**
+ * Claims the next unit of work: the oldest decoded frame, else a free slot
+ * for the next frame. Called with the mutex held.
+ */
+static pipeline_slot* claim_slot(pipeline_context* ctx) {
+    pipeline_slot* oldest = NULL;
+    pipeline_slot* free_slot = NULL;
+    for (int i = 0; i < ctx->num_slots; i++) {
+        pipeline_slot* slot = &ctx->slots[i];
+        if (slot->state == SLOT_DECODED && (!oldest || slot->frame_index < oldest->frame_index)) {
+            oldest = slot;
+        } else if (slot->state == SLOT_FREE && !free_slot) {
+            free_slot = slot;
+        }
+    }
+    if (oldest) {
+        oldest->state = SLOT_ENCODING;
+        return oldest;
+    }
+    if (free_slot && ctx->next_frame < ctx->count) {
+        free_slot->state = SLOT_DECODING;
+        free_slot->frame_index = ctx->next_frame++;
+        return free_slot;
+    }
+    return NULL;
+}
+
+static void pipeline_task(void* context, size_t index) {
+    pipeline_context* ctx = (pipeline_context*)context;
+    thread_state* state = thread_state_begin();
+    (void)index;
+
+    pipeline_lock(&ctx->mutex);
+    for (;;) {
+        pipeline_slot* slot = claim_slot(ctx);
+        if (!slot) {
+            /* Nothing to claim and nothing running that could change that */
+            if (ctx->active == 0) {
+                break;
+            }
+            pipeline_wait(&ctx->changed, &ctx->mutex);
+            continue;
+        }
+        int decoding = (slot->state == SLOT_DECODING);
+        int frame_index = slot->frame_index;
+        ctx->active++;
+        pipeline_unlock(&ctx->mutex);
+
+        transcode_result_t* result = &ctx->results[frame_index];
+        slot_state next;
+        int status;
+        if (decoding) {
+            status = decode_stage(ctx->inputs[frame_index], ctx->input_lens[frame_index],
+                                  &ctx->options, &slot->buffer, &slot->frame);
+            next = (status == SHARPDICOM_OK) ? SLOT_DECODED : SLOT_FREE;
+        } else {
+            status = encode_stage(&slot->frame, slot->buffer.data, &ctx->options,
+                                  &ctx->outputs[frame_index], result);
+            next = SLOT_FREE;
+        }
+        if (status != SHARPDICOM_OK) {
+            ctx->outputs[frame_index].size = 0;
+            record_failure(ctx, result, status);
+        }
+
+        pipeline_lock(&ctx->mutex);
+        slot->state = next;
+        ctx->active--;
+        pipeline_wake(&ctx->changed);
+    }
+    pipeline_unlock(&ctx->mutex);
+    thread_state_end(state);
+}
+
+/*============================================================================
+ * API Implementation
+ *============================================================================*/
+
+static int validate_options(const transcode_options_t* options) {
+    if (!options) {
+        set_error("Transcode options are required");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (options->source_codec < BATCH_CODEC_JPEG || options->source_codec > BATCH_CODEC_RLE ||
+        options->target_codec < BATCH_CODEC_JPEG || options->target_codec > BATCH_CODEC_RLE) {
+        set_error("Unknown transcode codec");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int transcode(
+    const uint8_t* input,
+    size_t input_len,
+    const transcode_options_t* options,
+    J2kOutputBuffer* output,
+    transcode_result_t* result
+) {
+    transcode_result_t local;
+    if (!result) {
+        result = &local;
+    }
+    memset(result, 0, sizeof(*result));
+
+    int status = validate_options(options);
+    if (status == SHARPDICOM_OK && !output) {
+        set_error("Transcode output cannot be NULL");
+        status = SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    thread_state* state = thread_state_begin();
+    decoded_frame frame;
+    if (status == SHARPDICOM_OK) {
+        output->size = 0;
+        status = decode_stage(input, input_len, options, &state->decode_scratch, &frame);
+    }
+    if (status == SHARPDICOM_OK) {
+        status = encode_stage(&frame, state->decode_scratch.data, options, output, result);
+    }
+    thread_state_end(state);
+    result->status = status;
+    return status;
+}
+
+SHARPDICOM_API int transcode_batch(
+    const uint8_t** inputs,
+    const size_t* input_lens,
+    int count,
+    const transcode_options_t* options,
+    J2kOutputBuffer* outputs,
+    transcode_result_t* results
+) {
+    if (!inputs || !input_lens || !outputs || !results || count <= 0) {
+        set_error("Invalid transcode batch arguments");
+        return 0;
+    }
+    if (validate_options(options) != SHARPDICOM_OK) {
+        return 0;
+    }
+
+    int32_t workers = (options->max_threads > 0) ? options->max_threads : thread_pool_concurrency();
+    if (workers > count) {
+        workers = count;
+    }
+    if (workers < 1) {
+        workers = 1;
+    }
+
+    pipeline_context ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.inputs = inputs;
+    ctx.input_lens = input_lens;
+    ctx.count = count;
+    ctx.options = *options;
+    ctx.outputs = outputs;
+    ctx.results = results;
+
+    /* Frames already run in parallel; keep OpenJPEG from starting its own threads */
+    if (options->max_threads != 1) {
+        ctx.options.j2k_decode.num_threads = 1;
+        ctx.options.j2k_encode.num_threads = 1;
+    }
+
+    /* One slot per worker plus one, so a decoded frame is waiting when an encode finishes */
+    ctx.num_slots = (workers < count) ? workers + 1 : count;
+    ctx.slots = (pipeline_slot*)allocator_calloc((size_t)ctx.num_slots, sizeof(pipeline_slot));
+    if (!ctx.slots) {
+        set_error("Failed to allocate transcode pipeline");
+        return 0;
+    }
+    memset(results, 0, (size_t)count * sizeof(*results));
+
+    pipeline_sync_init(&ctx.mutex, &ctx.changed);
+    int status = thread_pool_parallel_for((size_t)workers, workers, pipeline_task, &ctx);
+    pipeline_sync_destroy(&ctx.mutex, &ctx.changed);
+
+    for (int i = 0; i < ctx.num_slots; i++) {
+        allocator_free(ctx.slots[i].buffer.data);
+    }
+    allocator_free(ctx.slots);
+    if (status != SHARPDICOM_OK) {
+        return 0;
+    }
+
+    int success_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (results[i].status == SHARPDICOM_OK) {
+            success_count++;
+        }
+    }
+    if (ctx.error_claimed) {
+        set_error(ctx.error);
+    }
+    return success_count;
+}
@@ -0,0 +1,145 @@
+/**
+ * SharpDicom Native Transcode API
+ *
+ * Converts frames from one transfer syntax to another in a single native
+ * call: any decoder of the library (JPEG, JPEG-LS, JPEG 2000, RLE) feeds
+ * any encoder through a scratch buffer that is reused from frame to frame,
+ * so pixels never cross into managed memory.
+ *
+ * transcode_batch() runs a frame batch as a two-stage pipeline on the
+ * shared worker pool: while one frame is being encoded the next ones are
+ * already decoding.
+ *
+ * Thread Safety: All functions are thread-safe. Each call needs its own
+ * output buffers.
+ */
+
+#ifndef TRANSCODE_H
+#define TRANSCODE_H
+
+#include "sharpdicom_codecs.h"
+#include "batch_decode.h"
+#include "j2k_wrapper.h"
+#include "rle_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================
+ * Transcode structures
+ *============================================================================*/
+
+/**
+ * Source and target of a transcode. Codecs are BATCH_CODEC_* identifiers;
+ * HTJ2K is BATCH_CODEC_J2K with j2k_encode.high_throughput set.
+ *
+ * Target parameters are passed to the encoder as given; zero selects the
+ * defaults noted below.
+ */
+typedef struct {
+    /** BATCH_CODEC_* of the input frames */
+    int32_t source_codec;
+    /** BATCH_CODEC_* to encode to */
+    int32_t target_codec;
+    /** Threads to run on, including the caller (0 = whole pool, 1 = calling thread only) */
+    int32_t max_threads;
+
+    /** JPEG source output colorspace (JpegColorspace value; JPEG_CS_RGB keeps grayscale as-is) */
+    int32_t jpeg_colorspace;
+    /** JPEG 2000 source options; num_threads only applies when the batch runs on one thread, display is ignored */
+    J2kDecodeOptions j2k_decode;
+    /** RLE source geometry (required for an RLE source; planar_configuration is ignored) */
+    rle_params_t rle;
+    /** Bits per sample to encode with (0 = as the source reports; RLE reports bits_allocated) */
+    int32_t bits_stored;
+
+    /** JPEG target quality (1-100, 0 = 90) */
+    int32_t jpeg_quality;
+    /** JPEG target chroma subsampling for color frames (JpegSubsampling value) */
+    int32_t jpeg_subsampling;
+    /** JPEG-LS target near-lossless threshold (0 = lossless) */
+    int32_t jls_near_lossless;
+    /** JPEG-LS target interleave mode for color frames (JLS_INTERLEAVE_* value) */
+    int32_t jls_interleave_mode;
+    /** JPEG 2000 target parameters; num_threads only applies when the batch runs on one thread */
+    J2kEncodeParams j2k_encode;
+} transcode_options_t;
+
+/**
+ * Result for a single frame.
+ */
+typedef struct {
+    int status;              /* SHARPDICOM_OK or error code */
+    int width;               /* Frame width */
+    int height;              /* Frame height */
+    int num_components;      /* Number of components */
+    int precision;           /* Bits per sample encoded */
+    size_t output_size;      /* Bytes of the encoded frame (also in the output's size) */
+} transcode_result_t;
+
+/*============================================================================
+ * Transcode API functions
+ *============================================================================*/
+
+/**
+ * Decodes one frame and encodes it to the target codec.
+ *
+ * The decoded pixels go to a scratch buffer of the calling thread that is
+ * kept for the next call. The output grows like j2k_encode_to_buffer()'s:
+ * reuse one J2kOutputBuffer across frames to stop allocating once it has
+ * reached the largest frame. Samples are passed through unchanged, so a
+ * JPEG target needs 8-bit frames and only RLE takes 32-bit samples.
+ *
+ * @param input         Compressed source frame
+ * @param input_len     Length of the source frame in bytes
+ * @param options       Source, target and codec parameters
+ * @param output        Destination; output->size receives the encoded length
+ * @param result        Frame result (may be NULL)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code from the failing
+ *         decoder or encoder (SHARPDICOM_ERR_UNSUPPORTED for frames the
+ *         target cannot represent)
+ */
+SHARPDICOM_API int transcode(
+    const uint8_t* input,
+    size_t input_len,
+    const transcode_options_t* options,
+    J2kOutputBuffer* output,
+    transcode_result_t* result
+);
+
+/**
+ * Transcodes a batch of frames, overlapping decode and encode.
+ *
+ * Up to max_threads workers share the batch; each picks up the oldest
+ * decoded frame to encode, or otherwise decodes the next frame into a free
+ * scratch slot, so at most one more frame than there are workers is held
+ * decoded at a time. Every frame has its own output buffer and result; one
+ * failing frame does not stop the others. If any frame fails, the error
+ * message of a failed frame is left for sharpdicom_last_error() on the
+ * calling thread. Grow callbacks of the outputs may run on worker threads.
+ *
+ * @param inputs        Array of compressed frame pointers
+ * @param input_lens    Array of compressed frame lengths
+ * @param count         Number of frames
+ * @param options       Source, target and codec parameters
+ * @param outputs       Array of 'count' destinations
+ * @param results       Array of per-frame results (must have 'count' elements)
+ *
+ * @return Number of successfully transcoded frames (0 with an error message on bad arguments)
+ */
+SHARPDICOM_API int transcode_batch(
+    const uint8_t** inputs,
+    const size_t* input_lens,
+    int count,
+    const transcode_options_t* options,
+    J2kOutputBuffer* outputs,
+    transcode_result_t* results
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRANSCODE_H */
@@ -1,14 +1,23 @@
 /**
  * Video Codec Wrapper Implementation (FFmpeg)
  *
- * Wraps FFmpeg libavcodec for video frame decoding.
+ * Wraps FFmpeg libavcodec for video frame decoding and encoding.
  * Supports MPEG-2, MPEG-4/H.264, and HEVC/H.265.
  */
 
+/* pthread_once() under -std=c11 */
+#if !defined(_WIN32) && !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
 #define SHARPDICOM_CODECS_EXPORTS
 #include "video_wrapper.h"
 #include "sharpdicom_codecs.h"
+#include "allocator.h"
+#include "codec_stats.h"
+#include "thread_pool.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -16,8 +25,11 @@
 
 #ifdef SHARPDICOM_HAS_FFMPEG
 #include <libavcodec/avcodec.h>
+#include <libavutil/cpu.h>
 #include <libavutil/frame.h>
+#include <libavutil/hwcontext.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
 #include <libswscale/swscale.h>
 #endif
 
@@ -46,10 +58,71 @@ static void set_error_fmt(const char* format, ...) {
 
 #ifdef SHARPDICOM_HAS_FFMPEG
 
+/*============================================================================
+ * Atomics for the direct frame buffer pool
+ *============================================================================*/
+
+#if defined(_WIN32) || defined(_WIN64)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #define buffer_claim(p) (InterlockedCompareExchange((volatile LONG*)(p), 1, 0) == 0)
+    #define buffer_release(p) InterlockedExchange((volatile LONG*)(p), 0)
+    #define pool_ref(p) InterlockedIncrement((volatile LONG*)(p))
+    #define pool_unref_count(p) InterlockedDecrement((volatile LONG*)(p))
+#else
+    #include <pthread.h>
+
+    static int buffer_claim(volatile int32_t* p) {
+        int32_t expected = 0;
+        return __atomic_compare_exchange_n(p, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    }
+    #define buffer_release(p) __atomic_store_n((p), 0, __ATOMIC_RELEASE)
+    #define pool_ref(p) __atomic_add_fetch((p), 1, __ATOMIC_ACQ_REL)
+    #define pool_unref_count(p) __atomic_sub_fetch((p), 1, __ATOMIC_ACQ_REL)
+#endif
+
 /*============================================================================
  * Video decoder context structure
  *============================================================================*/
 
+typedef struct video_buffer_pool video_buffer_pool;
+
+/** One caller-registered frame buffer */
+typedef struct {
+    video_buffer_pool* pool;        /* Owning pool */
+    uint8_t* data;                  /* Caller buffer */
+    volatile int32_t in_use;        /* Referenced by the decoder */
+} video_buffer_slot;
+
+/**
+ * Caller-registered frame buffers (video_decoder_set_frame_buffers). Shared
+ * by the decoder and every buffer handed to FFmpeg, which may release it
+ * from its own threads after the decoder has moved on.
+ */
+struct video_buffer_pool {
+    volatile int32_t refs;          /* Decoder reference + buffers in use */
+    int output_format;              /* VIDEO_FORMAT_* of the buffers */
+    enum AVPixelFormat pix_fmt;     /* Matching decoder format */
+    size_t buffer_len;              /* Size of each buffer */
+    int count;                      /* Number of slots */
+    video_buffer_slot slots[];      /* Registered buffers */
+};
+
+/** One packet of an attached stream, in decode order */
+typedef struct {
+    int64_t offset;                 /* Byte offset in the concatenated fragments */
+    int size;                       /* Packet size in bytes */
+    int key_frame;                  /* Decoding can restart here */
+    int b_frame;                    /* Parser reported a B-picture */
+    int picture;                    /* Starts a frame (not a second field or header-only packet) */
+} video_packet_entry;
+
+/** Key frame of an attached stream */
+typedef struct {
+    int packet;                     /* Packet index (decode order) */
+    int64_t display;                /* Display position of the key frame */
+} video_keyframe_entry;
+
 struct video_decoder {
     AVCodecContext* codec_ctx;      /* FFmpeg codec context */
     const AVCodec* codec;           /* FFmpeg codec descriptor */
@@ -61,6 +134,38 @@ struct video_decoder {
     int width;                      /* Video width (from codec) */
     int height;                     /* Video height (from codec) */
     int last_output_format;         /* Last requested output format */
+
+    /* Hardware decoding (video_decoder_create_ex) */
+    int hw_device;                  /* Active VIDEO_HW_* device, VIDEO_HW_NONE for software */
+    int hw_opened;                  /* VIDEO_HW_* device the context was opened on */
+    enum AVPixelFormat hw_pix_fmt;  /* Device surface format, AV_PIX_FMT_NONE for software */
+    AVFrame* sw_frame;              /* System memory copy of a device frame */
+    int sw_threads;                 /* Requested software threads, for a reopen after fallback */
+    int sw_frame_threads;           /* Requested frame threading, for a reopen after fallback */
+    int packets_sent;               /* Packets sent since the context was opened */
+
+    /* Direct decoding into caller buffers (video_decoder_set_frame_buffers) */
+    video_buffer_pool* buffer_pool; /* Registered buffers, NULL if none */
+    int frame_buffer;               /* Buffer holding the last frame, -1 if copied */
+
+    /* Attached stream (video_decoder_set_stream) */
+    const uint8_t** fragments;      /* Fragment data (not owned) */
+    size_t* fragment_lens;          /* Fragment lengths */
+    int64_t* fragment_offsets;      /* Start of each fragment in the stream */
+    int fragment_count;             /* Number of fragments (0 = no stream) */
+    video_packet_entry* packets;    /* Packet index, decode order */
+    int packet_count;               /* Number of packets */
+    int frame_count;                /* Number of frames (packets starting a picture) */
+    video_keyframe_entry* keyframes;/* Key frames, ascending */
+    int keyframe_count;             /* Number of key frames */
+    uint8_t* packet_buf;            /* Contiguous, padded copy of one packet */
+    size_t packet_buf_size;         /* Capacity of packet_buf */
+    int next_packet;                /* Next packet to send */
+    int64_t next_display;           /* Display position of the next output frame */
+    int64_t seek_target;            /* Frames before this are not output */
+    int restart_packet;             /* Key frame awaited after a restart, -1 if none */
+    int draining;                   /* End of stream sent to the codec */
+    size_t bytes_sent;              /* Stream bytes sent to the codec, for statistics */
 };
 
 /*============================================================================
@@ -103,6 +208,69 @@ static const char* video_codec_name(int codec_id) {
     }
 }
 
+/*============================================================================
+ * Hardware device mapping
+ *============================================================================*/
+
+/** VIDEO_HW_* bits in the order devices are tried */
+static const int hw_device_bits[] = {
+    VIDEO_HW_CUDA, VIDEO_HW_VAAPI, VIDEO_HW_D3D11VA, VIDEO_HW_VIDEOTOOLBOX
+};
+
+/**
+ * Map a VIDEO_HW_* bit to the FFmpeg device type.
+ */
+static enum AVHWDeviceType video_hw_to_ffmpeg(int hw_device) {
+    switch (hw_device) {
+        case VIDEO_HW_CUDA:
+            return AV_HWDEVICE_TYPE_CUDA;
+        case VIDEO_HW_VAAPI:
+            return AV_HWDEVICE_TYPE_VAAPI;
+        case VIDEO_HW_D3D11VA:
+            return AV_HWDEVICE_TYPE_D3D11VA;
+        case VIDEO_HW_VIDEOTOOLBOX:
+            return AV_HWDEVICE_TYPE_VIDEOTOOLBOX;
+        default:
+            return AV_HWDEVICE_TYPE_NONE;
+    }
+}
+
+/**
+ * Find the surface format the codec decodes to on a device type, or
+ * AV_PIX_FMT_NONE if the codec has no hwaccel for it.
+ */
+static enum AVPixelFormat hw_surface_format(const AVCodec* codec, enum AVHWDeviceType type) {
+    for (int i = 0;; i++) {
+        const AVCodecHWConfig* config = avcodec_get_hw_config(codec, i);
+        if (config == NULL) {
+            return AV_PIX_FMT_NONE;
+        }
+        if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) &&
+            config->device_type == type) {
+            return config->pix_fmt;
+        }
+    }
+}
+
+/**
+ * get_format callback: take the device surface format when offered. When it
+ * is not (profile or bit depth the device cannot decode), FFmpeg's default
+ * choice is a software format, so decoding carries on in software. The
+ * context still has the single thread the device asked for; see
+ * send_codec_packet() for how the requested threads are restored.
+ */
+static enum AVPixelFormat select_hw_format(AVCodecContext* ctx, const enum AVPixelFormat* formats) {
+    video_decoder_t* decoder = ctx->opaque;
+    for (const enum AVPixelFormat* p = formats; *p != AV_PIX_FMT_NONE; p++) {
+        if (*p == decoder->hw_pix_fmt) {
+            decoder->hw_device = decoder->hw_opened;
+            return *p;
+        }
+    }
+    decoder->hw_device = VIDEO_HW_NONE;
+    return avcodec_default_get_format(ctx, formats);
+}
+
 /*============================================================================
  * Pixel format conversion
  *============================================================================*/
@@ -157,6 +325,19 @@ static int convert_frame(
     int width = frame->width;
     int height = frame->height;
 
+    /* Device frames are downloaded into system memory first */
+    if (decoder->hw_pix_fmt != AV_PIX_FMT_NONE && frame->format == decoder->hw_pix_fmt) {
+        av_frame_unref(decoder->sw_frame);
+        int ret = av_hwframe_transfer_data(decoder->sw_frame, frame, 0);
+        if (ret < 0) {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            set_error_fmt("Failed to download hardware frame: %s", errbuf);
+            return SHARPDICOM_ERR_DECODE_FAILED;
+        }
+        frame = decoder->sw_frame;
+    }
+
     /* Check output buffer size */
     size_t required = calculate_frame_size(width, height, output_format);
     if (output_len < required) {
@@ -213,21 +394,21 @@ static int convert_frame(
         return SHARPDICOM_OK;
     }
 
-    /* Create or update scaler context */
-    if (decoder->sws_ctx == NULL || decoder->last_output_format != output_format) {
-        if (decoder->sws_ctx != NULL) {
-            sws_freeContext(decoder->sws_ctx);
-        }
-        decoder->sws_ctx = sws_getContext(
-            width, height, frame->format,
-            width, height, dst_format,
-            SWS_BILINEAR, NULL, NULL, NULL);
-        if (decoder->sws_ctx == NULL) {
-            set_error("Failed to create pixel format converter");
-            return SHARPDICOM_ERR_INTERNAL;
-        }
-        decoder->last_output_format = output_format;
+    /*
+     * Create or update scaler context. The source format can change between
+     * frames (device surfaces, or a fallback to software), so let swscale
+     * compare all parameters.
+     */
+    decoder->sws_ctx = sws_getCachedContext(
+        decoder->sws_ctx,
+        width, height, frame->format,
+        width, height, dst_format,
+        SWS_BILINEAR, NULL, NULL, NULL);
+    if (decoder->sws_ctx == NULL) {
+        set_error("Failed to create pixel format converter");
+        return SHARPDICOM_ERR_INTERNAL;
     }
+    decoder->last_output_format = output_format;
 
     /* Set up output pointers */
     uint8_t* dst_data[4] = {0};
@@ -263,15 +444,562 @@ static int convert_frame(
     return SHARPDICOM_OK;
 }
 
+/*============================================================================
+ * Direct decoding into caller buffers
+ *============================================================================*/
+
+static void pool_unref(video_buffer_pool* pool) {
+    if (pool != NULL && pool_unref_count(&pool->refs) == 0) {
+        allocator_free(pool);
+    }
+}
+
+/** AVBuffer free callback: the decoder dropped its last reference */
+static void release_direct_buffer(void* opaque, uint8_t* data) {
+    video_buffer_slot* slot = opaque;
+    video_buffer_pool* pool = slot->pool;
+    (void)data;
+    buffer_release(&slot->in_use);
+    pool_unref(pool);
+}
+
+/**
+ * Whether the frame's planes can be laid out exactly as the packed
+ * VIDEO_FORMAT_* output: no cropping, whole macroblocks (so the decoder
+ * writes nothing outside the visible picture), and plane strides that meet
+ * FFmpeg's alignment.
+ */
+static int direct_layout_fits(const video_buffer_pool* pool, const AVCodecContext* ctx,
+                              const AVFrame* frame)
+{
+    size_t align = av_cpu_max_align();
+    int width = frame->width;
+    int height = frame->height;
+
+    if (width != ctx->width || height != ctx->height || width % 16 != 0 || height % 16 != 0) {
+        return 0;
+    }
+    if ((size_t)width % align != 0) {
+        return 0;
+    }
+    if (pool->output_format == VIDEO_FORMAT_YUV420P && (size_t)(width / 2) % align != 0) {
+        return 0;
+    }
+    /* Decoders may read up to two luma rows past the last plane */
+    return pool->buffer_len >= calculate_frame_size(width, height, pool->output_format) + 2 * (size_t)width;
+}
+
+/**
+ * get_buffer2 callback: hand a free caller buffer to the decoder when it
+ * fits, else use FFmpeg's own allocator. Called from frame threads, so the
+ * slots are claimed atomically.
+ */
+static int get_direct_buffer(AVCodecContext* ctx, AVFrame* frame, int flags) {
+    video_decoder_t* decoder = ctx->opaque;
+    video_buffer_pool* pool = decoder->buffer_pool;
+
+    if (pool == NULL || frame->format != pool->pix_fmt || !direct_layout_fits(pool, ctx, frame)) {
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
+
+    for (int i = 0; i < pool->count; i++) {
+        video_buffer_slot* slot = &pool->slots[i];
+        if (!buffer_claim(&slot->in_use)) {
+            continue;
+        }
+        pool_ref(&pool->refs);
+        frame->buf[0] = av_buffer_create(slot->data, pool->buffer_len, release_direct_buffer, slot, 0);
+        if (frame->buf[0] == NULL) {
+            buffer_release(&slot->in_use);
+            pool_unref(pool);
+            return AVERROR(ENOMEM);
+        }
+
+        size_t luma = (size_t)frame->width * frame->height;
+        frame->data[0] = slot->data;
+        frame->linesize[0] = frame->width;
+        if (pool->output_format == VIDEO_FORMAT_YUV420P) {
+            size_t chroma = luma / 4;
+            frame->data[1] = slot->data + luma;
+            frame->data[2] = slot->data + luma + chroma;
+            frame->linesize[1] = frame->width / 2;
+            frame->linesize[2] = frame->width / 2;
+        }
+        return 0;
+    }
+
+    /* Every buffer is still referenced (reference frames, frame threads) */
+    return avcodec_default_get_buffer2(ctx, frame, flags);
+}
+
+/**
+ * Index of the registered buffer the current frame was decoded into, or
+ * -1 if it has to be converted into the caller's output.
+ */
+static int direct_buffer_index(const video_decoder_t* decoder, int output_format) {
+    const video_buffer_pool* pool = decoder->buffer_pool;
+    if (pool == NULL || output_format != pool->output_format ||
+        decoder->frame->format != pool->pix_fmt) {
+        return -1;
+    }
+    for (int i = 0; i < pool->count; i++) {
+        if (decoder->frame->data[0] == pool->slots[i].data) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Hand the current frame to the caller: in place when it was decoded into
+ * a registered buffer, otherwise converted into 'output' (if given).
+ */
+static int deliver_frame(video_decoder_t* decoder, uint8_t* output, size_t output_len,
+                         int output_format)
+{
+    decoder->frame_buffer = direct_buffer_index(decoder, output_format);
+    if (decoder->frame_buffer >= 0 || output == NULL || output_len == 0) {
+        return SHARPDICOM_OK;
+    }
+    return convert_frame(decoder, output, output_len, output_format);
+}
+
+/*============================================================================
+ * Attached stream: packet and key frame index
+ *============================================================================*/
+
+/**
+ * Release the attached stream and its index.
+ */
+static void detach_stream(video_decoder_t* decoder) {
+    allocator_free(decoder->fragments);
+    allocator_free(decoder->fragment_lens);
+    allocator_free(decoder->fragment_offsets);
+    allocator_free(decoder->packets);
+    allocator_free(decoder->keyframes);
+    av_free(decoder->packet_buf);
+    decoder->fragments = NULL;
+    decoder->fragment_lens = NULL;
+    decoder->fragment_offsets = NULL;
+    decoder->fragment_count = 0;
+    decoder->packets = NULL;
+    decoder->packet_count = 0;
+    decoder->frame_count = 0;
+    decoder->keyframes = NULL;
+    decoder->keyframe_count = 0;
+    decoder->packet_buf = NULL;
+    decoder->packet_buf_size = 0;
+}
+
+/**
+ * Whether the packet the parser just returned is a restart point.
+ * The H.264 and HEVC parsers flag IDR/IRAP pictures and recovery points;
+ * for MPEG-2 and MPEG-4 Part 2 only the picture type is available.
+ */
+static int parsed_key_frame(int codec_id, const AVCodecParserContext* parser) {
+    if (codec_id == VIDEO_CODEC_H264 || codec_id == VIDEO_CODEC_HEVC) {
+        return parser->key_frame == 1;
+    }
+    return parser->pict_type == AV_PICTURE_TYPE_I;
+}
+
+/**
+ * Whether the packet the parser just returned starts a frame. Packets
+ * without a picture type (headers only) do not, nor does the second field
+ * of a field pair; pending_field tracks the first field between calls.
+ */
+static int parsed_picture(const AVCodecParserContext* parser, int* pending_field) {
+    if (parser->pict_type == AV_PICTURE_TYPE_NONE && parser->key_frame != 1) {
+        return 0;
+    }
+    int structure = parser->picture_structure;
+    if (structure != AV_PICTURE_STRUCTURE_TOP_FIELD &&
+        structure != AV_PICTURE_STRUCTURE_BOTTOM_FIELD) {
+        *pending_field = AV_PICTURE_STRUCTURE_UNKNOWN;
+        return 1;
+    }
+    if (*pending_field != AV_PICTURE_STRUCTURE_UNKNOWN && *pending_field != structure) {
+        *pending_field = AV_PICTURE_STRUCTURE_UNKNOWN;
+        return 0;
+    }
+    *pending_field = structure;
+    return 1;
+}
+
+static int append_packet(video_decoder_t* decoder, int* capacity, int* pending_field,
+                         const AVCodecParserContext* parser, int size)
+{
+    if (decoder->packet_count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 256;
+        video_packet_entry* grown = allocator_realloc(decoder->packets,
+                                                      (size_t)new_capacity * sizeof(video_packet_entry));
+        if (grown == NULL) {
+            set_error("Failed to allocate packet index");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        decoder->packets = grown;
+        *capacity = new_capacity;
+    }
+
+    video_packet_entry* entry = &decoder->packets[decoder->packet_count++];
+    entry->offset = parser->frame_offset;
+    entry->size = size;
+    entry->key_frame = parsed_key_frame(decoder->codec_id, parser);
+    entry->b_frame = parser->pict_type == AV_PICTURE_TYPE_B;
+    entry->picture = parsed_picture(parser, pending_field);
+    decoder->frame_count += entry->picture;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Split the attached fragments into packets with the codec's parser and
+ * count the frames they carry. Fragment boundaries need not match packet
+ * boundaries.
+ */
+static int index_packets(video_decoder_t* decoder) {
+    AVCodecParserContext* parser = av_parser_init(decoder->codec->id);
+    if (parser == NULL) {
+        set_error_fmt("No %s parser available", video_codec_name(decoder->codec_id));
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+    /* The parser updates its context; keep that away from the decoder's */
+    AVCodecContext* parse_ctx = avcodec_alloc_context3(decoder->codec);
+    if (parse_ctx == NULL) {
+        av_parser_close(parser);
+        set_error("Failed to allocate parser context");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    int status = SHARPDICOM_OK;
+    int capacity = 0;
+    int pending_field = AV_PICTURE_STRUCTURE_UNKNOWN;
+
+    /* The extra pass with no data flushes the last packet out of the parser */
+    for (int f = 0; f <= decoder->fragment_count && status == SHARPDICOM_OK; f++) {
+        int flushing = (f == decoder->fragment_count);
+        const uint8_t* data = flushing ? NULL : decoder->fragments[f];
+        size_t remaining = flushing ? 0 : decoder->fragment_lens[f];
+
+        while (remaining > 0 || flushing) {
+            int chunk = remaining > INT_MAX ? INT_MAX : (int)remaining;
+            uint8_t* out = NULL;
+            int out_size = 0;
+            /* The position passed on the first call anchors frame_offset; later calls advance it */
+            int used = av_parser_parse2(parser, parse_ctx, &out, &out_size, data, chunk,
+                                        AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+            if (used < 0) {
+                set_error("Failed to parse video stream");
+                status = SHARPDICOM_ERR_CORRUPT_DATA;
+                break;
+            }
+            if (used == 0 && out_size == 0 && !flushing) {
+                /* Stalled with input left: flush out what the parser holds, then feed the rest */
+                av_parser_parse2(parser, parse_ctx, &out, &out_size, NULL, 0,
+                                 AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+                if (out_size == 0) {
+                    set_error("Video parser made no progress");
+                    status = SHARPDICOM_ERR_CORRUPT_DATA;
+                    break;
+                }
+            }
+            if (out_size > 0) {
+                status = append_packet(decoder, &capacity, &pending_field, parser, out_size);
+                if (status != SHARPDICOM_OK) {
+                    break;
+                }
+            } else if (flushing) {
+                break;
+            }
+            if (!flushing) {
+                data += used;
+                remaining -= (size_t)used;
+            }
+        }
+    }
+
+    av_parser_close(parser);
+    avcodec_free_context(&parse_ctx);
+
+    /* A parser that reports no picture types at all: one frame per packet */
+    if (status == SHARPDICOM_OK && decoder->frame_count == 0) {
+        for (int i = 0; i < decoder->packet_count; i++) {
+            decoder->packets[i].picture = 1;
+        }
+        decoder->frame_count = decoder->packet_count;
+    }
+    return status;
+}
+
+/**
+ * Record every key frame with its display position. The B-pictures that
+ * directly follow a key frame in decode order are displayed before it;
+ * everything earlier in decode order is displayed before it as well.
+ */
+static int index_keyframes(video_decoder_t* decoder) {
+    int count = 0;
+    for (int i = 0; i < decoder->packet_count; i++) {
+        count += decoder->packets[i].key_frame && decoder->packets[i].picture;
+    }
+    if (count == 0) {
+        return SHARPDICOM_OK;
+    }
+
+    decoder->keyframes = allocator_alloc((size_t)count * sizeof(video_keyframe_entry));
+    if (decoder->keyframes == NULL) {
+        set_error("Failed to allocate key frame index");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    int64_t frame = 0;
+    for (int i = 0; i < decoder->packet_count; i++) {
+        if (!decoder->packets[i].picture) {
+            continue;
+        }
+        if (decoder->packets[i].key_frame) {
+            int leading = 0;
+            for (int j = i + 1; j < decoder->packet_count; j++) {
+                if (!decoder->packets[j].picture) {
+                    continue;
+                }
+                if (!decoder->packets[j].b_frame) {
+                    break;
+                }
+                leading++;
+            }
+            video_keyframe_entry* key = &decoder->keyframes[decoder->keyframe_count++];
+            key->packet = i;
+            key->display = frame + leading;
+        }
+        frame++;
+    }
+    return SHARPDICOM_OK;
+}
+
 /*============================================================================
  * Video decoder API implementation
  *============================================================================*/
 
+/**
+ * Allocate and open the codec context, on a hardware device when hw_device
+ * is not VIDEO_HW_NONE. On failure the context is freed and the decoder is
+ * left without one.
+ */
+static int open_codec_context(
+    video_decoder_t* decoder,
+    const uint8_t* extradata,
+    size_t extradata_len,
+    int hw_device,
+    const video_decoder_options_t* options)
+{
+    AVCodecContext* ctx = avcodec_alloc_context3(decoder->codec);
+    if (ctx == NULL) {
+        set_error("Failed to allocate codec context");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    /* Set extradata if provided (freed with the context) */
+    if (extradata != NULL && extradata_len > 0) {
+        ctx->extradata = av_malloc(extradata_len + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (ctx->extradata == NULL) {
+            set_error("Failed to allocate extradata");
+            avcodec_free_context(&ctx);
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        memcpy(ctx->extradata, extradata, extradata_len);
+        memset(ctx->extradata + extradata_len, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+        ctx->extradata_size = (int)extradata_len;
+    }
+
+    if (hw_device != VIDEO_HW_NONE) {
+        enum AVHWDeviceType type = video_hw_to_ffmpeg(hw_device);
+        enum AVPixelFormat surface = hw_surface_format(decoder->codec, type);
+        if (surface == AV_PIX_FMT_NONE) {
+            avcodec_free_context(&ctx);
+            set_error_fmt("%s has no %s hardware decoder",
+                          video_codec_name(decoder->codec_id), av_hwdevice_get_type_name(type));
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+        const char* hw_device_name = options ? options->hw_device_name : NULL;
+        int ret = av_hwdevice_ctx_create(&ctx->hw_device_ctx, type, hw_device_name, NULL, 0);
+        if (ret < 0) {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            avcodec_free_context(&ctx);
+            set_error_fmt("Failed to open %s device: %s", av_hwdevice_get_type_name(type), errbuf);
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+        ctx->get_format = select_hw_format;
+        decoder->hw_pix_fmt = surface;
+        decoder->hw_device = hw_device;
+        decoder->hw_opened = hw_device;
+
+        /* The device does the decoding; leave the CPU threads to others */
+        ctx->thread_count = 1;
+    } else {
+        /*
+         * Size FFmpeg's threads from the library thread budget unless asked
+         * otherwise; a decoder created on a pool worker already runs in
+         * parallel with others.
+         */
+        int threads = (options && options->num_threads > 0) ? options->num_threads :
+                      thread_pool_on_worker() ? 1 : thread_pool_budget();
+        ctx->thread_count = threads;
+        ctx->thread_type = FF_THREAD_SLICE;
+        if (options && options->frame_threads) {
+            ctx->thread_type |= FF_THREAD_FRAME;
+        }
+    }
+
+    /* Frames go into registered caller buffers when they fit */
+    ctx->opaque = decoder;
+    ctx->get_buffer2 = get_direct_buffer;
+
+    /* Open codec */
+    int ret = avcodec_open2(ctx, decoder->codec, NULL);
+    if (ret < 0) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        set_error_fmt("Failed to open %s codec: %s",
+                      video_codec_name(decoder->codec_id), errbuf);
+        avcodec_free_context(&ctx);
+        decoder->hw_pix_fmt = AV_PIX_FMT_NONE;
+        decoder->hw_device = VIDEO_HW_NONE;
+        decoder->hw_opened = VIDEO_HW_NONE;
+        return SHARPDICOM_ERR_INTERNAL;
+    }
+
+    decoder->codec_ctx = ctx;
+    decoder->packets_sent = 0;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Replace a context whose device turned the stream down with a software
+ * one sized like a software decoder would have been. If the new context
+ * cannot be opened, the old one keeps decoding on a single thread.
+ */
+static void reopen_software(video_decoder_t* decoder) {
+    AVCodecContext* fallback = decoder->codec_ctx;
+    video_decoder_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.num_threads = decoder->sw_threads;
+    options.frame_threads = decoder->sw_frame_threads;
+
+    decoder->hw_opened = VIDEO_HW_NONE;
+    decoder->hw_pix_fmt = AV_PIX_FMT_NONE;
+    if (open_codec_context(decoder, fallback->extradata, (size_t)fallback->extradata_size,
+                           VIDEO_HW_NONE, &options) != SHARPDICOM_OK) {
+        decoder->codec_ctx = fallback;
+        return;
+    }
+    avcodec_free_context(&fallback);
+}
+
+/**
+ * Send a packet to the codec. FFmpeg sizes its threads when the codec
+ * opens, so a device that turns the stream down in get_format leaves the
+ * software fallback on one thread. When that happens on the first packet
+ * nothing is buffered yet, and the packet is resent to a software context
+ * with the requested threads; a fallback later in the stream (a new
+ * sequence the device cannot decode) stays single-threaded.
+ */
+static int send_codec_packet(video_decoder_t* decoder, const AVPacket* packet) {
+    int ret = avcodec_send_packet(decoder->codec_ctx, packet);
+    if (ret >= 0 && decoder->packets_sent++ == 0 &&
+        decoder->hw_opened != VIDEO_HW_NONE && decoder->hw_device == VIDEO_HW_NONE) {
+        AVCodecContext* fallback = decoder->codec_ctx;
+        reopen_software(decoder);
+        if (decoder->codec_ctx != fallback) {
+            ret = avcodec_send_packet(decoder->codec_ctx, packet);
+        }
+    }
+    return ret;
+}
+
+/**
+ * Send one packet of the attached stream, tagged with its index as pts so
+ * the output frame can be matched to it after reordering.
+ */
+static int send_stream_packet(video_decoder_t* decoder, int index) {
+    const video_packet_entry* entry = &decoder->packets[index];
+    size_t needed = (size_t)entry->size + AV_INPUT_BUFFER_PADDING_SIZE;
+
+    if (decoder->packet_buf_size < needed) {
+        uint8_t* grown = av_realloc(decoder->packet_buf, needed);
+        if (grown == NULL) {
+            set_error("Failed to allocate packet buffer");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        decoder->packet_buf = grown;
+        decoder->packet_buf_size = needed;
+    }
+
+    /* Find the fragment holding the first byte, then copy across fragments */
+    int lo = 0, hi = decoder->fragment_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (decoder->fragment_offsets[mid] <= entry->offset) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    size_t copied = 0;
+    size_t skip = (size_t)(entry->offset - decoder->fragment_offsets[lo]);
+    for (int f = lo; f < decoder->fragment_count && copied < (size_t)entry->size; f++) {
+        size_t available = decoder->fragment_lens[f] - skip;
+        size_t take = (size_t)entry->size - copied;
+        if (take > available) {
+            take = available;
+        }
+        memcpy(decoder->packet_buf + copied, decoder->fragments[f] + skip, take);
+        copied += take;
+        skip = 0;
+    }
+    if (copied < (size_t)entry->size) {
+        set_error("Video packet extends past the end of the stream");
+        return SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    memset(decoder->packet_buf + entry->size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    AVPacket* packet = decoder->packet;
+    packet->data = decoder->packet_buf;
+    packet->size = entry->size;
+    packet->pts = index;
+    packet->dts = AV_NOPTS_VALUE;
+    packet->flags = entry->key_frame ? AV_PKT_FLAG_KEY : 0;
+
+    int ret = send_codec_packet(decoder, packet);
+
+    /* video_decode_frame() reuses the packet without timestamps */
+    packet->pts = AV_NOPTS_VALUE;
+    packet->flags = 0;
+
+    if (ret < 0) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        set_error_fmt("Failed to send packet: %s", errbuf);
+        return SHARPDICOM_ERR_DECODE_FAILED;
+    }
+    decoder->bytes_sent += (size_t)entry->size;
+    return SHARPDICOM_OK;
+}
+
 SHARPDICOM_API int video_decoder_create(
     int codec_id,
     const uint8_t* extradata,
     size_t extradata_len,
     video_decoder_t** decoder_out)
+{
+    return video_decoder_create_ex(codec_id, extradata, extradata_len, NULL, decoder_out);
+}
+
+SHARPDICOM_API int video_decoder_create_ex(
+    int codec_id,
+    const uint8_t* extradata,
+    size_t extradata_len,
+    const video_decoder_options_t* options,
+    video_decoder_t** decoder_out)
 {
     if (decoder_out == NULL) {
         set_error("Invalid argument: NULL decoder_out");
@@ -295,7 +1023,7 @@ SHARPDICOM_API int video_decoder_create(
     }
 
     /* Allocate decoder structure */
-    video_decoder_t* decoder = calloc(1, sizeof(video_decoder_t));
+    video_decoder_t* decoder = allocator_calloc(1, sizeof(video_decoder_t));
     if (decoder == NULL) {
         set_error("Failed to allocate decoder structure");
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
@@ -303,50 +1031,47 @@ SHARPDICOM_API int video_decoder_create(
 
     decoder->codec_id = codec_id;
     decoder->codec = codec;
-
-    /* Allocate codec context */
-    decoder->codec_ctx = avcodec_alloc_context3(codec);
-    if (decoder->codec_ctx == NULL) {
-        set_error("Failed to allocate codec context");
-        free(decoder);
-        return SHARPDICOM_ERR_OUT_OF_MEMORY;
-    }
-
-    /* Set extradata if provided */
-    if (extradata != NULL && extradata_len > 0) {
-        decoder->codec_ctx->extradata = av_malloc(extradata_len + AV_INPUT_BUFFER_PADDING_SIZE);
-        if (decoder->codec_ctx->extradata == NULL) {
-            set_error("Failed to allocate extradata");
-            avcodec_free_context(&decoder->codec_ctx);
-            free(decoder);
-            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    decoder->hw_device = VIDEO_HW_NONE;
+    decoder->hw_pix_fmt = AV_PIX_FMT_NONE;
+
+    decoder->frame_buffer = -1;
+    decoder->sw_threads = options ? options->num_threads : 0;
+    decoder->sw_frame_threads = options ? options->frame_threads : 0;
+
+    /* Try the requested devices in order, then software */
+    int hw_devices = options ? options->hw_devices : VIDEO_HW_NONE;
+    int status = SHARPDICOM_ERR_UNSUPPORTED;
+    for (size_t i = 0; i < sizeof(hw_device_bits) / sizeof(hw_device_bits[0]); i++) {
+        if (hw_devices & hw_device_bits[i]) {
+            status = open_codec_context(decoder, extradata, extradata_len,
+                                        hw_device_bits[i], options);
+            if (status == SHARPDICOM_OK || status == SHARPDICOM_ERR_OUT_OF_MEMORY) {
+                break;
+            }
         }
-        memcpy(decoder->codec_ctx->extradata, extradata, extradata_len);
-        memset(decoder->codec_ctx->extradata + extradata_len, 0, AV_INPUT_BUFFER_PADDING_SIZE);
-        decoder->codec_ctx->extradata_size = (int)extradata_len;
     }
-
-    /* Open codec */
-    int ret = avcodec_open2(decoder->codec_ctx, codec, NULL);
-    if (ret < 0) {
-        char errbuf[256];
-        av_strerror(ret, errbuf, sizeof(errbuf));
-        set_error_fmt("Failed to open %s codec: %s",
-                      video_codec_name(codec_id), errbuf);
-        if (decoder->codec_ctx->extradata) {
-            av_free(decoder->codec_ctx->extradata);
+    if (status != SHARPDICOM_OK && status != SHARPDICOM_ERR_OUT_OF_MEMORY) {
+        if (hw_devices != VIDEO_HW_NONE && options->hw_required) {
+            /* Keep the last device's error message */
+            allocator_free(decoder);
+            return SHARPDICOM_ERR_UNSUPPORTED;
         }
-        avcodec_free_context(&decoder->codec_ctx);
-        free(decoder);
-        return SHARPDICOM_ERR_INTERNAL;
+        status = open_codec_context(decoder, extradata, extradata_len, VIDEO_HW_NONE, options);
+    }
+    if (status != SHARPDICOM_OK) {
+        allocator_free(decoder);
+        return status;
     }
 
-    /* Allocate frame */
+    /* Allocate frames (sw_frame receives downloads from the device) */
     decoder->frame = av_frame_alloc();
-    if (decoder->frame == NULL) {
+    decoder->sw_frame = av_frame_alloc();
+    if (decoder->frame == NULL || decoder->sw_frame == NULL) {
         set_error("Failed to allocate frame");
+        av_frame_free(&decoder->frame);
+        av_frame_free(&decoder->sw_frame);
         avcodec_free_context(&decoder->codec_ctx);
-        free(decoder);
+        allocator_free(decoder);
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
     }
 
@@ -355,8 +1080,9 @@ SHARPDICOM_API int video_decoder_create(
     if (decoder->packet == NULL) {
         set_error("Failed to allocate packet");
         av_frame_free(&decoder->frame);
+        av_frame_free(&decoder->sw_frame);
         avcodec_free_context(&decoder->codec_ctx);
-        free(decoder);
+        allocator_free(decoder);
         return SHARPDICOM_ERR_OUT_OF_MEMORY;
     }
 
@@ -364,11 +1090,144 @@ SHARPDICOM_API int video_decoder_create(
     return SHARPDICOM_OK;
 }
 
-SHARPDICOM_API int video_decoder_get_info(
+SHARPDICOM_API int video_decoder_get_hw_device(
     video_decoder_t* decoder,
-    video_stream_info_t* info)
+    int* hw_device)
 {
-    if (decoder == NULL || info == NULL) {
+    if (decoder == NULL || hw_device == NULL) {
+        set_error("Invalid argument: NULL decoder or hw_device");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *hw_device = decoder->hw_device;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_decoder_set_frame_buffers(
+    video_decoder_t* decoder,
+    uint8_t* const* buffers,
+    int count,
+    size_t buffer_len,
+    int output_format)
+{
+    if (decoder == NULL) {
+        set_error("Invalid argument: NULL decoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    video_buffer_pool* pool = NULL;
+    if (buffers != NULL && count > 0) {
+        if (output_format != VIDEO_FORMAT_YUV420P && output_format != VIDEO_FORMAT_GRAY8) {
+            set_error("Direct frame buffers support YUV420P and GRAY8 output only");
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+        for (int i = 0; i < count; i++) {
+            if (buffers[i] == NULL || ((uintptr_t)buffers[i] % 64) != 0) {
+                set_error_fmt("Frame buffer %d is NULL or not 64-byte aligned", i);
+                return SHARPDICOM_ERR_INVALID_ARGUMENT;
+            }
+        }
+
+        pool = allocator_alloc(sizeof(video_buffer_pool) + (size_t)count * sizeof(video_buffer_slot));
+        if (pool == NULL) {
+            set_error("Failed to allocate frame buffer pool");
+            return SHARPDICOM_ERR_OUT_OF_MEMORY;
+        }
+        pool->refs = 1;
+        pool->output_format = output_format;
+        pool->pix_fmt = video_format_to_ffmpeg(output_format);
+        pool->buffer_len = buffer_len;
+        pool->count = count;
+        for (int i = 0; i < count; i++) {
+            pool->slots[i].pool = pool;
+            pool->slots[i].data = buffers[i];
+            pool->slots[i].in_use = 0;
+        }
+    }
+
+    /* Flushing waits for frame threads, so none is inside get_direct_buffer() */
+    avcodec_flush_buffers(decoder->codec_ctx);
+    av_frame_unref(decoder->frame);
+    decoder->frame_buffer = -1;
+
+    pool_unref(decoder->buffer_pool);
+    decoder->buffer_pool = pool;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_decoder_get_frame_buffer(
+    video_decoder_t* decoder,
+    int* buffer_index)
+{
+    if (decoder == NULL || buffer_index == NULL) {
+        set_error("Invalid argument: NULL decoder or buffer_index");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *buffer_index = decoder->frame_buffer;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_hw_compiled_support(void) {
+    int support = VIDEO_HW_NONE;
+    enum AVHWDeviceType type = AV_HWDEVICE_TYPE_NONE;
+    while ((type = av_hwdevice_iterate_types(type)) != AV_HWDEVICE_TYPE_NONE) {
+        for (size_t i = 0; i < sizeof(hw_device_bits) / sizeof(hw_device_bits[0]); i++) {
+            if (video_hw_to_ffmpeg(hw_device_bits[i]) == type) {
+                support |= hw_device_bits[i];
+            }
+        }
+    }
+    return support;
+}
+
+/** video_hw_support() result, written once by probe_hw_support() */
+static int probed_hw_support = VIDEO_HW_NONE;
+
+/** Open and release each compiled-in device type once */
+static void probe_hw_support(void) {
+    int compiled = video_hw_compiled_support();
+    int support = VIDEO_HW_NONE;
+    for (size_t i = 0; i < sizeof(hw_device_bits) / sizeof(hw_device_bits[0]); i++) {
+        AVBufferRef* device = NULL;
+        if ((compiled & hw_device_bits[i]) &&
+            av_hwdevice_ctx_create(&device, video_hw_to_ffmpeg(hw_device_bits[i]), NULL, NULL, 0) >= 0) {
+            support |= hw_device_bits[i];
+            av_buffer_unref(&device);
+        }
+    }
+    probed_hw_support = support;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+static INIT_ONCE g_hw_probe_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK hw_probe_callback(PINIT_ONCE once, PVOID parameter, PVOID* context) {
+    (void)once;
+    (void)parameter;
+    (void)context;
+    probe_hw_support();
+    return TRUE;
+}
+
+SHARPDICOM_API int video_hw_support(void) {
+    InitOnceExecuteOnce(&g_hw_probe_once, hw_probe_callback, NULL, NULL);
+    return probed_hw_support;
+}
+#else
+static pthread_once_t g_hw_probe_once = PTHREAD_ONCE_INIT;
+
+SHARPDICOM_API int video_hw_support(void) {
+    pthread_once(&g_hw_probe_once, probe_hw_support);
+    return probed_hw_support;
+}
+#endif
+
+SHARPDICOM_API int video_decoder_get_info(
+    video_decoder_t* decoder,
+    video_stream_info_t* info)
+{
+    if (decoder == NULL || info == NULL) {
         set_error("Invalid argument: NULL decoder or info");
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
@@ -379,7 +1238,8 @@ SHARPDICOM_API int video_decoder_get_info(
     info->width = ctx->width > 0 ? ctx->width : decoder->width;
     info->height = ctx->height > 0 ? ctx->height : decoder->height;
     info->bit_depth = ctx->bits_per_raw_sample > 0 ? ctx->bits_per_raw_sample : 8;
-    info->frame_count = -1; /* Unknown without container */
+    /* Known only from an attached stream's index; the parser yields one packet per frame */
+    info->frame_count = decoder->fragment_count > 0 ? decoder->frame_count : -1;
     info->duration_us = -1; /* Unknown without container */
 
     /* Calculate frame rate */
@@ -394,7 +1254,7 @@ SHARPDICOM_API int video_decoder_get_info(
     return SHARPDICOM_OK;
 }
 
-SHARPDICOM_API int video_decode_frame(
+static int decode_packet(
     video_decoder_t* decoder,
     const uint8_t* input,
     size_t input_len,
@@ -420,7 +1280,7 @@ SHARPDICOM_API int video_decode_frame(
     decoder->packet->size = (int)input_len;
 
     /* Send packet to decoder */
-    int ret = avcodec_send_packet(decoder->codec_ctx, decoder->packet);
+    int ret = send_codec_packet(decoder, decoder->packet);
     if (ret < 0) {
         char errbuf[256];
         av_strerror(ret, errbuf, sizeof(errbuf));
@@ -449,12 +1309,10 @@ SHARPDICOM_API int video_decode_frame(
     decoder->width = decoder->frame->width;
     decoder->height = decoder->frame->height;
 
-    /* Convert and copy to output if buffer provided */
-    if (output != NULL && output_len > 0) {
-        int conv_ret = convert_frame(decoder, output, output_len, output_format);
-        if (conv_ret != SHARPDICOM_OK) {
-            return conv_ret;
-        }
+    /* Convert and copy to output if buffer provided (unless decoded in place) */
+    int conv_ret = deliver_frame(decoder, output, output_len, output_format);
+    if (conv_ret != SHARPDICOM_OK) {
+        return conv_ret;
     }
 
     /* Fill frame info if requested */
@@ -474,6 +1332,34 @@ SHARPDICOM_API int video_decode_frame(
     return SHARPDICOM_OK;
 }
 
+/** Bytes delivered by a successful decode call, 0 if no frame came out */
+static size_t decoded_bytes(const video_decoder_t* decoder, int status,
+                            const int* frame_available, int output_format)
+{
+    if (status != SHARPDICOM_OK || frame_available == NULL || !*frame_available) {
+        return 0;
+    }
+    return calculate_frame_size(decoder->width, decoder->height, output_format);
+}
+
+SHARPDICOM_API int video_decode_frame(
+    video_decoder_t* decoder,
+    const uint8_t* input,
+    size_t input_len,
+    uint8_t* output,
+    size_t output_len,
+    int output_format,
+    video_frame_info_t* frame_info,
+    int* frame_available)
+{
+    int64_t start = codec_stats_start();
+    int status = decode_packet(decoder, input, input_len, output, output_len,
+                               output_format, frame_info, frame_available);
+    codec_stats_record(SHARPDICOM_STATS_VIDEO, CODEC_STATS_DECODE, start, input_len,
+                       decoded_bytes(decoder, status, frame_available, output_format), status);
+    return status;
+}
+
 SHARPDICOM_API int video_decoder_flush(
     video_decoder_t* decoder,
     uint8_t* output,
@@ -515,12 +1401,10 @@ SHARPDICOM_API int video_decoder_flush(
         return SHARPDICOM_ERR_DECODE_FAILED;
     }
 
-    /* Convert and copy to output */
-    if (output != NULL && output_len > 0) {
-        int conv_ret = convert_frame(decoder, output, output_len, output_format);
-        if (conv_ret != SHARPDICOM_OK) {
-            return conv_ret;
-        }
+    /* Convert and copy to output (unless decoded in place) */
+    int conv_ret = deliver_frame(decoder, output, output_len, output_format);
+    if (conv_ret != SHARPDICOM_OK) {
+        return conv_ret;
     }
 
     /* Fill frame info */
@@ -540,6 +1424,177 @@ SHARPDICOM_API int video_decoder_flush(
     return SHARPDICOM_OK;
 }
 
+SHARPDICOM_API int video_decoder_set_stream(
+    video_decoder_t* decoder,
+    const uint8_t* const* fragments,
+    const size_t* fragment_lens,
+    int fragment_count)
+{
+    if (decoder == NULL || fragments == NULL || fragment_lens == NULL || fragment_count <= 0) {
+        set_error("Invalid argument: NULL decoder, fragments or no fragments");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    for (int i = 0; i < fragment_count; i++) {
+        if (fragments[i] == NULL && fragment_lens[i] > 0) {
+            set_error_fmt("Invalid argument: NULL fragment %d", i);
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    detach_stream(decoder);
+    avcodec_flush_buffers(decoder->codec_ctx);
+    decoder->frame_number = 0;
+
+    decoder->fragments = allocator_alloc((size_t)fragment_count * sizeof(const uint8_t*));
+    decoder->fragment_lens = allocator_alloc((size_t)fragment_count * sizeof(size_t));
+    decoder->fragment_offsets = allocator_alloc((size_t)fragment_count * sizeof(int64_t));
+    if (decoder->fragments == NULL || decoder->fragment_lens == NULL ||
+        decoder->fragment_offsets == NULL) {
+        detach_stream(decoder);
+        set_error("Failed to allocate fragment table");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    int64_t offset = 0;
+    for (int i = 0; i < fragment_count; i++) {
+        decoder->fragments[i] = fragments[i];
+        decoder->fragment_lens[i] = fragment_lens[i];
+        decoder->fragment_offsets[i] = offset;
+        offset += (int64_t)fragment_lens[i];
+    }
+    decoder->fragment_count = fragment_count;
+
+    int status = index_packets(decoder);
+    if (status == SHARPDICOM_OK && decoder->frame_count == 0) {
+        set_error("No video frames found in stream");
+        status = SHARPDICOM_ERR_CORRUPT_DATA;
+    }
+    if (status == SHARPDICOM_OK) {
+        status = index_keyframes(decoder);
+    }
+    if (status != SHARPDICOM_OK) {
+        detach_stream(decoder);
+        return status;
+    }
+
+    decoder->next_packet = 0;
+    decoder->next_display = 0;
+    decoder->seek_target = 0;
+    decoder->restart_packet = -1;
+    decoder->draining = 0;
+    return SHARPDICOM_OK;
+}
+
+static int read_stream_frame(
+    video_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int output_format,
+    video_frame_info_t* frame_info,
+    int* frame_available)
+{
+    if (decoder == NULL) {
+        set_error("Invalid argument: NULL decoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (frame_available == NULL) {
+        set_error("Invalid argument: NULL frame_available");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *frame_available = 0;
+
+    if (decoder->fragment_count == 0) {
+        set_error("No stream attached; call video_decoder_set_stream first");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    for (;;) {
+        int ret = avcodec_receive_frame(decoder->codec_ctx, decoder->frame);
+        if (ret == AVERROR(EAGAIN)) {
+            int status;
+            if (decoder->next_packet < decoder->packet_count) {
+                status = send_stream_packet(decoder, decoder->next_packet++);
+            } else if (!decoder->draining) {
+                decoder->draining = 1;
+                ret = avcodec_send_packet(decoder->codec_ctx, NULL);
+                status = (ret < 0 && ret != AVERROR_EOF) ? SHARPDICOM_ERR_DECODE_FAILED : SHARPDICOM_OK;
+                if (status != SHARPDICOM_OK) {
+                    set_error("Failed to flush decoder");
+                }
+            } else {
+                return SHARPDICOM_OK;
+            }
+            if (status != SHARPDICOM_OK) {
+                return status;
+            }
+            continue;
+        }
+        if (ret == AVERROR_EOF) {
+            return SHARPDICOM_OK;
+        }
+        if (ret < 0) {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            set_error_fmt("Failed to receive frame: %s", errbuf);
+            return SHARPDICOM_ERR_DECODE_FAILED;
+        }
+
+        /* After a restart, pictures output before the key frame belong to earlier display positions */
+        int64_t packet_index = decoder->frame->pts;
+        if (decoder->restart_packet >= 0) {
+            if (packet_index != AV_NOPTS_VALUE && packet_index != decoder->restart_packet) {
+                continue;
+            }
+            decoder->restart_packet = -1;
+        }
+
+        int64_t display = decoder->next_display++;
+        if (display < decoder->seek_target) {
+            continue;
+        }
+
+        decoder->width = decoder->frame->width;
+        decoder->height = decoder->frame->height;
+
+        int conv_ret = deliver_frame(decoder, output, output_len, output_format);
+        if (conv_ret != SHARPDICOM_OK) {
+            return conv_ret;
+        }
+
+        if (frame_info != NULL) {
+            frame_info->width = decoder->frame->width;
+            frame_info->height = decoder->frame->height;
+            frame_info->format = output_format;
+            frame_info->pts = display;
+            frame_info->dts = packet_index;
+            frame_info->key_frame = (decoder->frame->flags & AV_FRAME_FLAG_KEY) != 0;
+            frame_info->frame_number = display;
+        }
+
+        *frame_available = 1;
+        return SHARPDICOM_OK;
+    }
+}
+
+SHARPDICOM_API int video_decoder_read_frame(
+    video_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int output_format,
+    video_frame_info_t* frame_info,
+    int* frame_available)
+{
+    int64_t start = codec_stats_start();
+    size_t sent = (decoder != NULL) ? decoder->bytes_sent : 0;
+    int status = read_stream_frame(decoder, output, output_len, output_format,
+                                   frame_info, frame_available);
+    codec_stats_record(SHARPDICOM_STATS_VIDEO, CODEC_STATS_DECODE, start,
+                       (decoder != NULL) ? decoder->bytes_sent - sent : 0,
+                       decoded_bytes(decoder, status, frame_available, output_format), status);
+    return status;
+}
+
 SHARPDICOM_API int video_decoder_seek(
     video_decoder_t* decoder,
     int64_t frame_number)
@@ -549,17 +1604,59 @@ SHARPDICOM_API int video_decoder_seek(
         return SHARPDICOM_ERR_INVALID_ARGUMENT;
     }
 
-    (void)frame_number;
+    if (decoder->fragment_count == 0) {
+        /* Flush decoder buffers */
+        avcodec_flush_buffers(decoder->codec_ctx);
+        decoder->frame_number = 0;
 
-    /* Flush decoder buffers */
-    avcodec_flush_buffers(decoder->codec_ctx);
-    decoder->frame_number = 0;
+        /* Without an attached stream there is no data to restart from;
+         * the caller must provide data starting from a key frame. */
+        set_error("Seek requires caller to provide key frame data");
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
 
-    /* Note: Actual seeking requires container support (demuxer).
-     * Without a demuxer, we can only reset the decoder state.
-     * The caller must provide data starting from a key frame. */
-    set_error("Seek requires caller to provide key frame data");
-    return SHARPDICOM_ERR_UNSUPPORTED;
+    if (frame_number < 0 || frame_number >= decoder->frame_count) {
+        set_error_fmt("Frame number %lld out of range (0-%d)",
+                      (long long)frame_number, decoder->frame_count - 1);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    /* Last key frame displayed at or before the target */
+    const video_keyframe_entry* key = NULL;
+    int lo = 0, hi = decoder->keyframe_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (decoder->keyframes[mid].display <= frame_number) {
+            key = &decoder->keyframes[mid];
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    int64_t restart_display = key ? key->display : 0;
+
+    decoder->seek_target = frame_number;
+
+    /* Forward within the GOP being decoded: keep going, nothing to restart */
+    if (decoder->restart_packet < 0 &&
+        decoder->next_display <= frame_number &&
+        restart_display <= decoder->next_display) {
+        return SHARPDICOM_OK;
+    }
+
+    avcodec_flush_buffers(decoder->codec_ctx);
+    decoder->draining = 0;
+    if (key != NULL) {
+        decoder->next_packet = key->packet;
+        decoder->next_display = key->display;
+        decoder->restart_packet = key->packet;
+    } else {
+        /* No key frame before the target: decode from the start */
+        decoder->next_packet = 0;
+        decoder->next_display = 0;
+        decoder->restart_packet = -1;
+    }
+    return SHARPDICOM_OK;
 }
 
 SHARPDICOM_API int video_decoder_get_frame_size(
@@ -599,6 +1696,7 @@ SHARPDICOM_API int video_decoder_reset(
 
     avcodec_flush_buffers(decoder->codec_ctx);
     decoder->frame_number = 0;
+    detach_stream(decoder);
 
     return SHARPDICOM_OK;
 }
@@ -614,6 +1712,8 @@ SHARPDICOM_API void video_decoder_destroy(
         sws_freeContext(decoder->sws_ctx);
     }
 
+    detach_stream(decoder);
+
     if (decoder->packet != NULL) {
         av_packet_free(&decoder->packet);
     }
@@ -622,14 +1722,541 @@ SHARPDICOM_API void video_decoder_destroy(
         av_frame_free(&decoder->frame);
     }
 
+    if (decoder->sw_frame != NULL) {
+        av_frame_free(&decoder->sw_frame);
+    }
+
+    /* Frees the extradata and releases the hardware device as well */
     if (decoder->codec_ctx != NULL) {
-        if (decoder->codec_ctx->extradata != NULL) {
-            av_free(decoder->codec_ctx->extradata);
-        }
         avcodec_free_context(&decoder->codec_ctx);
     }
 
-    free(decoder);
+    /* Buffers still referenced elsewhere keep the pool alive */
+    pool_unref(decoder->buffer_pool);
+
+    allocator_free(decoder);
+}
+
+/*============================================================================
+ * Video encoder
+ *============================================================================*/
+
+struct video_encoder {
+    AVCodecContext* codec_ctx;      /* FFmpeg codec context */
+    AVFrame* frame;                 /* Input staged in the encoder's software format */
+    AVFrame* hw_frame;              /* Device surface for upload encoders (VA-API) */
+    AVPacket* packet;               /* Output packet */
+    struct SwsContext* sws_ctx;     /* Input format converter */
+    int codec_id;                   /* VIDEO_CODEC_* identifier */
+    int width;                      /* Frame width */
+    int height;                     /* Frame height */
+    int input_format;               /* VIDEO_FORMAT_* of the input */
+    int hw_device;                  /* VIDEO_HW_* device, VIDEO_HW_NONE for software */
+    int quality;                    /* Per-frame qscale quality, -1 if not used */
+    int64_t next_pts;               /* Frame number of the next input */
+    int packet_pending;             /* Packet received but not yet copied out */
+};
+
+/**
+ * Software encoder for a codec. Looked up by name so that a hardware
+ * encoder registered for the same codec ID is never picked by accident.
+ */
+static const char* software_encoder_name(int codec_id) {
+    switch (codec_id) {
+        case VIDEO_CODEC_MPEG2:
+            return "mpeg2video";
+        case VIDEO_CODEC_MPEG4:
+            return "mpeg4";
+        case VIDEO_CODEC_H264:
+            return "libx264";
+        case VIDEO_CODEC_HEVC:
+            return "libx265";
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Hardware encoder for a codec on a device, or NULL if there is none.
+ */
+static const char* hw_encoder_name(int codec_id, int hw_device) {
+    switch (hw_device) {
+        case VIDEO_HW_CUDA:
+            return codec_id == VIDEO_CODEC_H264 ? "h264_nvenc" :
+                   codec_id == VIDEO_CODEC_HEVC ? "hevc_nvenc" : NULL;
+        case VIDEO_HW_VAAPI:
+            return codec_id == VIDEO_CODEC_MPEG2 ? "mpeg2_vaapi" :
+                   codec_id == VIDEO_CODEC_H264 ? "h264_vaapi" :
+                   codec_id == VIDEO_CODEC_HEVC ? "hevc_vaapi" : NULL;
+        case VIDEO_HW_D3D11VA:
+            return codec_id == VIDEO_CODEC_H264 ? "h264_mf" :
+                   codec_id == VIDEO_CODEC_HEVC ? "hevc_mf" : NULL;
+        case VIDEO_HW_VIDEOTOOLBOX:
+            return codec_id == VIDEO_CODEC_H264 ? "h264_videotoolbox" :
+                   codec_id == VIDEO_CODEC_HEVC ? "hevc_videotoolbox" : NULL;
+        default:
+            return NULL;
+    }
+}
+
+/**
+ * Constant-quality rate control: CRF (x264/x265), CQ (NVENC), a constant QP
+ * (VA-API), or a fixed qscale for the remaining software encoders
+ * (mpeg2video, mpeg4). Returns 1 if each frame has to carry the quality
+ * (qscale).
+ */
+static int apply_quality(AVCodecContext* ctx, int quality) {
+    if (av_opt_set_int(ctx->priv_data, "crf", quality, 0) >= 0) {
+        return 0;
+    }
+    if (av_opt_set_int(ctx->priv_data, "cq", quality, 0) >= 0) {
+        return 0;
+    }
+    /* VA-API takes global_quality as the QP itself, not as a lambda */
+    if (av_opt_set_int(ctx->priv_data, "qp", quality, 0) >= 0 ||
+        strstr(ctx->codec->name, "_vaapi") != NULL) {
+        ctx->global_quality = quality;
+        return 0;
+    }
+    ctx->flags |= AV_CODEC_FLAG_QSCALE;
+    ctx->global_quality = FF_QP2LAMBDA * quality;
+    return 1;
+}
+
+/**
+ * Give a VA-API context a pool of NV12 surfaces to upload frames into.
+ */
+static int create_upload_frames(AVCodecContext* ctx, int width, int height) {
+    AVBufferRef* frames_ref = av_hwframe_ctx_alloc(ctx->hw_device_ctx);
+    if (frames_ref == NULL) {
+        set_error("Failed to allocate hardware frame pool");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    AVHWFramesContext* frames = (AVHWFramesContext*)frames_ref->data;
+    frames->format = AV_PIX_FMT_VAAPI;
+    frames->sw_format = AV_PIX_FMT_NV12;
+    frames->width = width;
+    frames->height = height;
+    frames->initial_pool_size = 20;
+
+    int ret = av_hwframe_ctx_init(frames_ref);
+    if (ret < 0) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        set_error_fmt("Failed to create hardware frame pool: %s", errbuf);
+        av_buffer_unref(&frames_ref);
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+    ctx->hw_frames_ctx = frames_ref;
+    ctx->pix_fmt = AV_PIX_FMT_VAAPI;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Allocate and open the codec context with the named encoder, on a device
+ * when hw_device is not VIDEO_HW_NONE. On failure nothing is kept.
+ */
+static int open_encoder_context(
+    video_encoder_t* encoder,
+    const char* encoder_name,
+    int hw_device,
+    const video_encoder_params_t* params)
+{
+    const AVCodec* codec = avcodec_find_encoder_by_name(encoder_name);
+    if (codec == NULL) {
+        set_error_fmt("Encoder not available: %s", encoder_name);
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    AVCodecContext* ctx = avcodec_alloc_context3(codec);
+    if (ctx == NULL) {
+        set_error("Failed to allocate codec context");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    int fps_num = params->frame_rate_num > 0 ? params->frame_rate_num : 30;
+    int fps_den = params->frame_rate_num > 0 && params->frame_rate_den > 0 ? params->frame_rate_den : 1;
+    ctx->width = params->width;
+    ctx->height = params->height;
+    ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    ctx->framerate = (AVRational){fps_num, fps_den};
+    ctx->time_base = (AVRational){fps_den, fps_num};
+    if (params->gop_size > 0) {
+        ctx->gop_size = params->gop_size;
+    }
+    if (params->max_b_frames >= 0) {
+        ctx->max_b_frames = params->max_b_frames;
+    }
+
+    encoder->quality = -1;
+    if (params->bit_rate > 0) {
+        ctx->bit_rate = params->bit_rate;
+    } else if (params->quality >= 0 && apply_quality(ctx, params->quality)) {
+        encoder->quality = ctx->global_quality;
+    }
+
+    if (params->preset != NULL) {
+        int ret = av_opt_set(ctx->priv_data, "preset", params->preset, 0);
+        if (ret < 0 && ret != AVERROR_OPTION_NOT_FOUND) {
+            set_error_fmt("Invalid %s preset: %s", encoder_name, params->preset);
+            avcodec_free_context(&ctx);
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    ctx->thread_count = params->num_threads > 0 ? params->num_threads :
+                        thread_pool_on_worker() ? 1 : thread_pool_budget();
+
+    if (hw_device != VIDEO_HW_NONE) {
+        enum AVHWDeviceType type = video_hw_to_ffmpeg(hw_device);
+        int ret = av_hwdevice_ctx_create(&ctx->hw_device_ctx, type, params->hw_device_name, NULL, 0);
+        if (ret < 0) {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            avcodec_free_context(&ctx);
+            set_error_fmt("Failed to open %s device: %s", av_hwdevice_get_type_name(type), errbuf);
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+        /* VA-API encodes from device surfaces; the others take system memory frames */
+        if (hw_device == VIDEO_HW_VAAPI) {
+            int status = create_upload_frames(ctx, params->width, params->height);
+            if (status != SHARPDICOM_OK) {
+                avcodec_free_context(&ctx);
+                return status;
+            }
+        }
+    }
+
+    int ret = avcodec_open2(ctx, codec, NULL);
+    if (ret < 0) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        set_error_fmt("Failed to open %s encoder: %s", encoder_name, errbuf);
+        avcodec_free_context(&ctx);
+        return SHARPDICOM_ERR_UNSUPPORTED;
+    }
+
+    encoder->codec_ctx = ctx;
+    encoder->hw_device = hw_device;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_encoder_create(
+    int codec_id,
+    const video_encoder_params_t* params,
+    video_encoder_t** encoder_out)
+{
+    if (encoder_out == NULL || params == NULL) {
+        set_error("Invalid argument: NULL params or encoder_out");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *encoder_out = NULL;
+
+    const char* software_name = software_encoder_name(codec_id);
+    if (software_name == NULL) {
+        set_error_fmt("Invalid codec ID: %d", codec_id);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->width <= 0 || params->height <= 0 || (params->width | params->height) & 1) {
+        set_error_fmt("Invalid frame size %dx%d: dimensions must be positive and even",
+                      params->width, params->height);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (params->input_format != VIDEO_FORMAT_GRAY8 && params->input_format != VIDEO_FORMAT_RGB24 &&
+        params->input_format != VIDEO_FORMAT_YUV420P) {
+        set_error("Invalid input format: expected GRAY8, RGB24 or YUV420P");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    video_encoder_t* encoder = allocator_calloc(1, sizeof(video_encoder_t));
+    if (encoder == NULL) {
+        set_error("Failed to allocate encoder structure");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    encoder->codec_id = codec_id;
+    encoder->width = params->width;
+    encoder->height = params->height;
+    encoder->input_format = params->input_format;
+
+    /* Try the requested hardware encoders in order, then software */
+    int status = SHARPDICOM_ERR_UNSUPPORTED;
+    set_error_fmt("No hardware %s encoder for the requested devices", video_codec_name(codec_id));
+    for (size_t i = 0; i < sizeof(hw_device_bits) / sizeof(hw_device_bits[0]); i++) {
+        const char* name = hw_encoder_name(codec_id, hw_device_bits[i]);
+        if ((params->hw_devices & hw_device_bits[i]) && name != NULL) {
+            status = open_encoder_context(encoder, name, hw_device_bits[i], params);
+            if (status != SHARPDICOM_ERR_UNSUPPORTED) {
+                break;
+            }
+        }
+    }
+    if (status == SHARPDICOM_ERR_UNSUPPORTED) {
+        if (params->hw_devices != VIDEO_HW_NONE && params->hw_required) {
+            /* Keep the last device's error message */
+            allocator_free(encoder);
+            return SHARPDICOM_ERR_UNSUPPORTED;
+        }
+        status = open_encoder_context(encoder, software_name, VIDEO_HW_NONE, params);
+    }
+    if (status != SHARPDICOM_OK) {
+        allocator_free(encoder);
+        return status;
+    }
+
+    /* Staging frame in the format the encoder takes from system memory */
+    encoder->frame = av_frame_alloc();
+    encoder->packet = av_packet_alloc();
+    if (encoder->hw_device == VIDEO_HW_VAAPI) {
+        encoder->hw_frame = av_frame_alloc();
+    }
+    if (encoder->frame == NULL || encoder->packet == NULL ||
+        (encoder->hw_device == VIDEO_HW_VAAPI && encoder->hw_frame == NULL)) {
+        set_error("Failed to allocate frame");
+        video_encoder_destroy(encoder);
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    encoder->frame->format = encoder->hw_device == VIDEO_HW_VAAPI ? AV_PIX_FMT_NV12 : AV_PIX_FMT_YUV420P;
+    encoder->frame->width = params->width;
+    encoder->frame->height = params->height;
+    if (av_frame_get_buffer(encoder->frame, 0) < 0) {
+        set_error("Failed to allocate frame buffer");
+        video_encoder_destroy(encoder);
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    *encoder_out = encoder;
+    return SHARPDICOM_OK;
+}
+
+/**
+ * Convert caller input into the staging frame. YUV420P input going to a
+ * YUV420P encoder is copied plane by plane; everything else goes through
+ * swscale (limited range BT.601, as DICOM YBR_PARTIAL_420 expects).
+ */
+static int stage_input(video_encoder_t* encoder, const uint8_t* input) {
+    AVFrame* frame = encoder->frame;
+    int width = encoder->width;
+    int height = encoder->height;
+
+    /* The encoder may still reference the previous frame's buffer */
+    if (av_frame_make_writable(frame) < 0) {
+        set_error("Failed to allocate frame buffer");
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+
+    const uint8_t* src_data[4] = {0};
+    int src_linesize[4] = {0};
+    enum AVPixelFormat src_format = video_format_to_ffmpeg(encoder->input_format);
+    if (encoder->input_format == VIDEO_FORMAT_YUV420P) {
+        src_data[0] = input;
+        src_data[1] = input + (size_t)width * height;
+        src_data[2] = src_data[1] + (size_t)(width / 2) * (height / 2);
+        src_linesize[0] = width;
+        src_linesize[1] = width / 2;
+        src_linesize[2] = width / 2;
+    } else {
+        src_data[0] = input;
+        src_linesize[0] = width * (encoder->input_format == VIDEO_FORMAT_RGB24 ? 3 : 1);
+    }
+
+    if (src_format == frame->format) {
+        for (int plane = 0; plane < 3; plane++) {
+            int rows = plane == 0 ? height : height / 2;
+            for (int y = 0; y < rows; y++) {
+                memcpy(frame->data[plane] + (size_t)y * frame->linesize[plane],
+                       src_data[plane] + (size_t)y * src_linesize[plane],
+                       (size_t)src_linesize[plane]);
+            }
+        }
+        return SHARPDICOM_OK;
+    }
+
+    encoder->sws_ctx = sws_getCachedContext(
+        encoder->sws_ctx,
+        width, height, src_format,
+        width, height, frame->format,
+        SWS_BILINEAR, NULL, NULL, NULL);
+    if (encoder->sws_ctx == NULL) {
+        set_error("Failed to create pixel format converter");
+        return SHARPDICOM_ERR_INTERNAL;
+    }
+    if (sws_scale(encoder->sws_ctx, src_data, src_linesize, 0, height,
+                  frame->data, frame->linesize) <= 0) {
+        set_error("Pixel format conversion failed");
+        return SHARPDICOM_ERR_INTERNAL;
+    }
+    return SHARPDICOM_OK;
+}
+
+static int send_encoder_frame(
+    video_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len)
+{
+    if (encoder == NULL) {
+        set_error("Invalid argument: NULL encoder");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    const AVFrame* send = NULL;
+    if (input != NULL) {
+        size_t required = calculate_frame_size(encoder->width, encoder->height, encoder->input_format);
+        if (input_len < required) {
+            set_error_fmt("Input buffer too small: need %zu bytes, have %zu", required, input_len);
+            return SHARPDICOM_ERR_INVALID_ARGUMENT;
+        }
+
+        int status = stage_input(encoder, input);
+        if (status != SHARPDICOM_OK) {
+            return status;
+        }
+        encoder->frame->pts = encoder->next_pts++;
+        if (encoder->quality >= 0) {
+            encoder->frame->quality = encoder->quality;
+        }
+        send = encoder->frame;
+
+        if (encoder->hw_frame != NULL) {
+            av_frame_unref(encoder->hw_frame);
+            int ret = av_hwframe_get_buffer(encoder->codec_ctx->hw_frames_ctx, encoder->hw_frame, 0);
+            if (ret >= 0) {
+                ret = av_hwframe_transfer_data(encoder->hw_frame, encoder->frame, 0);
+            }
+            if (ret < 0) {
+                char errbuf[256];
+                av_strerror(ret, errbuf, sizeof(errbuf));
+                set_error_fmt("Failed to upload frame: %s", errbuf);
+                return SHARPDICOM_ERR_ENCODE_FAILED;
+            }
+            encoder->hw_frame->pts = encoder->frame->pts;
+            encoder->hw_frame->quality = encoder->frame->quality;
+            send = encoder->hw_frame;
+        }
+    }
+
+    int ret = avcodec_send_frame(encoder->codec_ctx, send);
+    if (ret == AVERROR(EAGAIN)) {
+        if (input != NULL) {
+            encoder->next_pts--;
+        }
+        set_error("Receive pending packets before sending more frames");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+    if (ret < 0 && !(input == NULL && ret == AVERROR_EOF)) {
+        char errbuf[256];
+        av_strerror(ret, errbuf, sizeof(errbuf));
+        set_error_fmt("Failed to send frame: %s", errbuf);
+        return SHARPDICOM_ERR_ENCODE_FAILED;
+    }
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_encoder_send_frame(
+    video_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len)
+{
+    int64_t start = codec_stats_start();
+    int status = send_encoder_frame(encoder, input, input_len);
+    codec_stats_record(SHARPDICOM_STATS_VIDEO, CODEC_STATS_ENCODE, start,
+                       (input != NULL) ? input_len : 0, 0, status);
+    return status;
+}
+
+SHARPDICOM_API int video_encoder_receive_packet(
+    video_encoder_t* encoder,
+    uint8_t* output,
+    size_t output_len,
+    video_packet_info_t* info,
+    int* packet_available)
+{
+    if (encoder == NULL || packet_available == NULL) {
+        set_error("Invalid argument: NULL encoder or packet_available");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *packet_available = 0;
+
+    /* Packets belong to the frames already counted by video_encoder_send_frame() */
+    int64_t start = codec_stats_start();
+    if (!encoder->packet_pending) {
+        int ret = avcodec_receive_packet(encoder->codec_ctx, encoder->packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return SHARPDICOM_OK;
+        }
+        if (ret < 0) {
+            char errbuf[256];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            set_error_fmt("Failed to receive packet: %s", errbuf);
+            return SHARPDICOM_ERR_ENCODE_FAILED;
+        }
+        encoder->packet_pending = 1;
+    }
+
+    AVPacket* packet = encoder->packet;
+    if (info != NULL) {
+        info->size = (size_t)packet->size;
+        info->pts = packet->pts;
+        info->dts = packet->dts;
+        info->key_frame = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+    }
+    if (output == NULL || output_len < (size_t)packet->size) {
+        set_error_fmt("Output buffer too small: need %d bytes, have %zu", packet->size, output_len);
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    memcpy(output, packet->data, (size_t)packet->size);
+    codec_stats_add(SHARPDICOM_STATS_VIDEO, CODEC_STATS_ENCODE, start,
+                    0, (size_t)packet->size, SHARPDICOM_OK);
+    av_packet_unref(packet);
+    encoder->packet_pending = 0;
+    *packet_available = 1;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_encoder_get_packet_bound(
+    video_encoder_t* encoder,
+    size_t* bound)
+{
+    if (encoder == NULL || bound == NULL) {
+        set_error("Invalid argument: NULL encoder or bound");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *bound = 2 * calculate_frame_size(encoder->width, encoder->height, VIDEO_FORMAT_YUV420P) + 65536;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API int video_encoder_get_hw_device(
+    video_encoder_t* encoder,
+    int* hw_device)
+{
+    if (encoder == NULL || hw_device == NULL) {
+        set_error("Invalid argument: NULL encoder or hw_device");
+        return SHARPDICOM_ERR_INVALID_ARGUMENT;
+    }
+
+    *hw_device = encoder->hw_device;
+    return SHARPDICOM_OK;
+}
+
+SHARPDICOM_API void video_encoder_destroy(
+    video_encoder_t* encoder)
+{
+    if (encoder == NULL) {
+        return;
+    }
+
+    if (encoder->sws_ctx != NULL) {
+        sws_freeContext(encoder->sws_ctx);
+    }
+    av_packet_free(&encoder->packet);
+    av_frame_free(&encoder->frame);
+    av_frame_free(&encoder->hw_frame);
+    avcodec_free_context(&encoder->codec_ctx);
+
+    allocator_free(encoder);
 }
 
 #else /* !SHARPDICOM_HAS_FFMPEG */
@@ -652,6 +2279,66 @@ SHARPDICOM_API int video_decoder_create(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+SHARPDICOM_API int video_decoder_create_ex(
+    int codec_id,
+    const uint8_t* extradata,
+    size_t extradata_len,
+    const video_decoder_options_t* options,
+    video_decoder_t** decoder_out)
+{
+    (void)codec_id;
+    (void)extradata;
+    (void)extradata_len;
+    (void)options;
+    (void)decoder_out;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_decoder_get_hw_device(
+    video_decoder_t* decoder,
+    int* hw_device)
+{
+    (void)decoder;
+    (void)hw_device;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_decoder_set_frame_buffers(
+    video_decoder_t* decoder,
+    uint8_t* const* buffers,
+    int count,
+    size_t buffer_len,
+    int output_format)
+{
+    (void)decoder;
+    (void)buffers;
+    (void)count;
+    (void)buffer_len;
+    (void)output_format;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_decoder_get_frame_buffer(
+    video_decoder_t* decoder,
+    int* buffer_index)
+{
+    (void)decoder;
+    (void)buffer_index;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_hw_compiled_support(void) {
+    return VIDEO_HW_NONE;
+}
+
+SHARPDICOM_API int video_hw_support(void) {
+    return VIDEO_HW_NONE;
+}
+
 SHARPDICOM_API int video_decoder_get_info(
     video_decoder_t* decoder,
     video_stream_info_t* info)
@@ -702,6 +2389,38 @@ SHARPDICOM_API int video_decoder_flush(
     return SHARPDICOM_ERR_UNSUPPORTED;
 }
 
+SHARPDICOM_API int video_decoder_set_stream(
+    video_decoder_t* decoder,
+    const uint8_t* const* fragments,
+    const size_t* fragment_lens,
+    int fragment_count)
+{
+    (void)decoder;
+    (void)fragments;
+    (void)fragment_lens;
+    (void)fragment_count;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_decoder_read_frame(
+    video_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int output_format,
+    video_frame_info_t* frame_info,
+    int* frame_available)
+{
+    (void)decoder;
+    (void)output;
+    (void)output_len;
+    (void)output_format;
+    (void)frame_info;
+    (void)frame_available;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
 SHARPDICOM_API int video_decoder_seek(
     video_decoder_t* decoder,
     int64_t frame_number)
@@ -739,4 +2458,71 @@ SHARPDICOM_API void video_decoder_destroy(
     /* Nothing to do */
 }
 
+SHARPDICOM_API int video_encoder_create(
+    int codec_id,
+    const video_encoder_params_t* params,
+    video_encoder_t** encoder_out)
+{
+    (void)codec_id;
+    (void)params;
+    (void)encoder_out;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_encoder_send_frame(
+    video_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len)
+{
+    (void)encoder;
+    (void)input;
+    (void)input_len;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_encoder_receive_packet(
+    video_encoder_t* encoder,
+    uint8_t* output,
+    size_t output_len,
+    video_packet_info_t* info,
+    int* packet_available)
+{
+    (void)encoder;
+    (void)output;
+    (void)output_len;
+    (void)info;
+    (void)packet_available;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_encoder_get_packet_bound(
+    video_encoder_t* encoder,
+    size_t* bound)
+{
+    (void)encoder;
+    (void)bound;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API int video_encoder_get_hw_device(
+    video_encoder_t* encoder,
+    int* hw_device)
+{
+    (void)encoder;
+    (void)hw_device;
+    set_error("Video support not available (FFmpeg not linked)");
+    return SHARPDICOM_ERR_UNSUPPORTED;
+}
+
+SHARPDICOM_API void video_encoder_destroy(
+    video_encoder_t* encoder)
+{
+    (void)encoder;
+    /* Nothing to do */
+}
+
 #endif /* SHARPDICOM_HAS_FFMPEG */
@@ -1,11 +1,12 @@
 /**
  * Video Codec Wrapper API (FFmpeg)
  *
- * Provides video frame decoding for MPEG-2, MPEG-4/H.264, and HEVC/H.265
- * video streams embedded in DICOM files.
+ * Provides video frame decoding and encoding for MPEG-2, MPEG-4/H.264, and
+ * HEVC/H.265 video streams embedded in DICOM files.
  *
- * Thread Safety: Each video_decoder handle is NOT thread-safe.
- * Different handles may be used from different threads concurrently.
+ * Thread Safety: Each video_decoder and video_encoder handle is NOT
+ * thread-safe. Different handles may be used from different threads
+ * concurrently.
  */
 
 #ifndef VIDEO_WRAPPER_H
@@ -37,6 +38,18 @@ extern "C" {
 #define VIDEO_FORMAT_RGB24      2   /* 24-bit RGB (interleaved) */
 #define VIDEO_FORMAT_YUV420P    3   /* YUV 4:2:0 planar (native format, fastest) */
 
+/*============================================================================
+ * Hardware decode device constants
+ *============================================================================*/
+
+/** Hardware decode devices (video_hw_support() bits, video_decoder_options_t.hw_devices) */
+#define VIDEO_HW_NONE           0
+#define VIDEO_HW_CUDA           (1 << 0)  /* NVIDIA NVDEC */
+#define VIDEO_HW_VAAPI          (1 << 1)  /* VA-API (Linux Intel/AMD) */
+#define VIDEO_HW_D3D11VA        (1 << 2)  /* Direct3D 11 Video (Windows) */
+#define VIDEO_HW_VIDEOTOOLBOX   (1 << 3)  /* VideoToolbox (macOS) */
+#define VIDEO_HW_ANY            (VIDEO_HW_CUDA | VIDEO_HW_VAAPI | VIDEO_HW_D3D11VA | VIDEO_HW_VIDEOTOOLBOX)
+
 /*============================================================================
  * Video decoder handle
  *============================================================================*/
@@ -73,11 +86,31 @@ typedef struct {
     int height;             /* Video height in pixels */
     int codec_id;           /* VIDEO_CODEC_* identifier */
     int bit_depth;          /* Bits per sample (typically 8 or 10) */
-    int frame_count;        /* Total frame count if known, -1 if unknown */
+    int frame_count;        /* Total frame count if known (attached stream), -1 if unknown */
     double frame_rate;      /* Frame rate (fps), 0 if unknown */
     int64_t duration_us;    /* Duration in microseconds, -1 if unknown */
 } video_stream_info_t;
 
+/*============================================================================
+ * Video decoder options
+ *============================================================================*/
+
+/**
+ * Options for video_decoder_create_ex().
+ */
+typedef struct {
+    /** VIDEO_HW_* devices to try, in bit order (0 = software only) */
+    int hw_devices;
+    /** 1 = fail when no device opens, 0 = fall back to software decoding */
+    int hw_required;
+    /** Device to open (e.g. "/dev/dri/renderD128" or a CUDA ordinal), NULL for the default */
+    const char* hw_device_name;
+    /** Software decode threads (0 = library thread budget, or 1 when created on a pool worker) */
+    int num_threads;
+    /** 1 = thread across frames as well as slices (adds up to num_threads - 1 frames of delay) */
+    int frame_threads;
+} video_decoder_options_t;
+
 /*============================================================================
  * Video decoder API functions
  *============================================================================*/
@@ -104,6 +137,126 @@ SHARPDICOM_API int video_decoder_create(
     video_decoder_t** decoder_out
 );
 
+/**
+ * Creates a video decoder, optionally decoding on a hardware device.
+ *
+ * The devices in options->hw_devices are tried in bit order; the first one
+ * that supports the codec and opens is used. Frames decoded on the device
+ * are copied back to system memory, so the VIDEO_FORMAT_* output contract
+ * is unchanged. A stream the device cannot decode (profile, bit depth)
+ * falls back to software decoding mid-stream. When its first packet is
+ * turned down, the fallback uses num_threads and frame_threads; a later
+ * sequence the device turns down decodes on a single thread.
+ *
+ * @param codec_id      VIDEO_CODEC_* identifier
+ * @param extradata     Codec-specific extradata (SPS/PPS for H.264, etc.)
+ * @param extradata_len Length of extradata in bytes (may be 0)
+ * @param options       Decoder options (NULL = software decoding)
+ * @param decoder_out   Pointer to receive decoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: Invalid codec_id
+ *         - SHARPDICOM_ERR_UNSUPPORTED: Codec not supported, or no requested
+ *           device available with hw_required set
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int video_decoder_create_ex(
+    int codec_id,
+    const uint8_t* extradata,
+    size_t extradata_len,
+    const video_decoder_options_t* options,
+    video_decoder_t** decoder_out
+);
+
+/**
+ * Gets the hardware device a decoder decodes on.
+ *
+ * @param decoder       Decoder handle
+ * @param hw_device     Pointer to receive the VIDEO_HW_* device (VIDEO_HW_NONE
+ *                      for software, including after a mid-stream fallback)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int video_decoder_get_hw_device(
+    video_decoder_t* decoder,
+    int* hw_device
+);
+
+/**
+ * Registers caller buffers that frames are decoded into directly.
+ *
+ * When the codec's output format matches output_format (YUV420P or GRAY8),
+ * the picture is macroblock-aligned with no cropping, and its width (and
+ * chroma width) is a multiple of the CPU's SIMD alignment, the decoder
+ * writes the planes of a frame straight into a free buffer in the packed
+ * VIDEO_FORMAT_* layout. video_decoder_get_frame_buffer() then reports the
+ * buffer and nothing is copied into 'output'. Otherwise, or while every
+ * registered buffer is still referenced by the decoder, frames are
+ * decoded internally and copied into 'output' as before.
+ *
+ * A frame's buffer is read-only and only valid until the next decode, read
+ * or flush call: the decoder keeps reference frames in it and reuses it
+ * once released. Register enough buffers for the codec's reference frames
+ * plus the frame threads (about 20 covers H.264 and HEVC).
+ *
+ * Buffers must be aligned to 64 bytes and hold video_decoder_get_frame_size()
+ * plus two luma rows, which the decoder may read past the last row.
+ *
+ * Call before decoding: the decoder is flushed. The buffers stay in use
+ * until the decoder releases its last reference to them, which can be
+ * after they are replaced; destroying the decoder releases all of them.
+ *
+ * @param decoder           Decoder handle
+ * @param buffers           Array of buffer pointers (NULL to unregister)
+ * @param count             Number of buffers (0 to unregister)
+ * @param buffer_len        Size of each buffer
+ * @param output_format     VIDEO_FORMAT_YUV420P or VIDEO_FORMAT_GRAY8
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL or misaligned buffer, or
+ *           unsupported output_format
+ */
+SHARPDICOM_API int video_decoder_set_frame_buffers(
+    video_decoder_t* decoder,
+    uint8_t* const* buffers,
+    int count,
+    size_t buffer_len,
+    int output_format
+);
+
+/**
+ * Gets the registered buffer holding the last frame returned.
+ *
+ * @param decoder       Decoder handle
+ * @param buffer_index  Pointer to receive the index into the registered
+ *                      buffers, or -1 if the frame was copied into 'output'
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int video_decoder_get_frame_buffer(
+    video_decoder_t* decoder,
+    int* buffer_index
+);
+
+/**
+ * Reports the hardware device types the linked FFmpeg was built with.
+ * Nothing is opened, so the answer says nothing about drivers or devices
+ * present on this machine; see video_hw_support().
+ *
+ * @return Bitmask of VIDEO_HW_* devices (0 if none or FFmpeg not linked)
+ */
+SHARPDICOM_API int video_hw_compiled_support(void);
+
+/**
+ * Reports the hardware decode devices that can be opened on this machine.
+ * The first call opens and releases a device of each compiled-in type,
+ * which initializes their drivers and can take hundreds of milliseconds;
+ * later calls return the cached result. Thread-safe.
+ *
+ * @return Bitmask of VIDEO_HW_* devices (0 if none or FFmpeg not linked)
+ */
+SHARPDICOM_API int video_hw_support(void);
+
 /**
  * Gets information about the video stream.
  *
@@ -177,17 +330,84 @@ SHARPDICOM_API int video_decoder_flush(
     int* frame_available
 );
 
+/**
+ * Attaches a complete elementary stream and indexes its frames.
+ *
+ * The fragments (the DICOM pixel data items, in order) are scanned once
+ * with the codec's parser to find every packet and key frame; nothing is
+ * decoded. A frame is a packet the parser reports a picture for, so
+ * header-only packets and the second field of a field pair are not
+ * counted. Frames are then read with video_decoder_read_frame() and
+ * random access goes through video_decoder_seek().
+ *
+ * The fragment data is not copied and must remain valid until the stream
+ * is replaced, the decoder is reset or destroyed. The pointer and length
+ * arrays themselves may be freed after the call.
+ *
+ * @param decoder           Decoder handle
+ * @param fragments         Array of fragment pointers
+ * @param fragment_lens     Array of fragment lengths
+ * @param fragment_count    Number of fragments
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: NULL arrays or no fragments
+ *         - SHARPDICOM_ERR_CORRUPT_DATA: No frames found in the stream
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int video_decoder_set_stream(
+    video_decoder_t* decoder,
+    const uint8_t* const* fragments,
+    const size_t* fragment_lens,
+    int fragment_count
+);
+
+/**
+ * Decodes the next frame of the attached stream.
+ *
+ * Frames come out in display order. frame_info->frame_number is the
+ * frame's display position in the whole stream; frame_info->pts equals it
+ * and frame_info->dts is the packet's position in decode order.
+ *
+ * @param decoder           Decoder handle (with a stream attached)
+ * @param output            Buffer for decoded frame pixels
+ * @param output_len        Size of output buffer
+ * @param output_format     Desired output format (VIDEO_FORMAT_*)
+ * @param frame_info        Pointer to receive frame information (may be NULL)
+ * @param frame_available   Pointer to receive flag (1=frame available, 0=end of stream)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int video_decoder_read_frame(
+    video_decoder_t* decoder,
+    uint8_t* output,
+    size_t output_len,
+    int output_format,
+    video_frame_info_t* frame_info,
+    int* frame_available
+);
+
 /**
  * Seeks to a specific frame number.
  *
- * This resets the decoder state. The next decode operation should
- * start from a key frame at or before the target position.
+ * With a stream attached (video_decoder_set_stream()), decoding restarts
+ * at the nearest key frame at or before the target, and the frames before
+ * the target are decoded but not output. The next
+ * video_decoder_read_frame() returns the target frame, so random access
+ * costs at most one GOP. A forward seek within the current GOP continues
+ * without restarting.
+ *
+ * Without an attached stream, the decoder is only flushed: the caller must
+ * provide data starting from a key frame.
+ *
+ * Key frame positions assume the usual GOP layout: only the B-frames that
+ * directly follow a key frame in decode order are displayed before it.
  *
  * @param decoder       Decoder handle
- * @param frame_number  Target frame number (0-based)
+ * @param frame_number  Target frame number (0-based, display order)
  *
  * @return SHARPDICOM_OK on success, or negative error code:
- *         - SHARPDICOM_ERR_UNSUPPORTED: Seeking not supported
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: Frame number out of range
+ *         - SHARPDICOM_ERR_UNSUPPORTED: No stream attached
  */
 SHARPDICOM_API int video_decoder_seek(
     video_decoder_t* decoder,
@@ -213,7 +433,8 @@ SHARPDICOM_API int video_decoder_get_frame_size(
  * Resets the decoder to initial state.
  *
  * Use this to reuse the decoder for a new video stream without
- * creating a new handle.
+ * creating a new handle. Detaches any stream set with
+ * video_decoder_set_stream().
  *
  * @param decoder       Decoder handle
  *
@@ -232,6 +453,158 @@ SHARPDICOM_API void video_decoder_destroy(
     video_decoder_t* decoder
 );
 
+/*============================================================================
+ * Video encoder
+ *============================================================================*/
+
+/** Opaque handle to video encoder context */
+typedef struct video_encoder video_encoder_t;
+
+/**
+ * Parameters for video_encoder_create().
+ *
+ * Streams are encoded as 8-bit YUV 4:2:0, the sampling the DICOM MPEG-2,
+ * H.264 and HEVC transfer syntaxes use; GRAY8 and RGB24 input is converted.
+ */
+typedef struct {
+    int width;              /* Frame width in pixels (even) */
+    int height;             /* Frame height in pixels (even) */
+    int input_format;       /* VIDEO_FORMAT_GRAY8, VIDEO_FORMAT_RGB24 or VIDEO_FORMAT_YUV420P */
+    int frame_rate_num;     /* Frame rate numerator (0 = 30 fps) */
+    int frame_rate_den;     /* Frame rate denominator */
+    int gop_size;           /* Key frame interval in frames (0 = encoder default) */
+    int max_b_frames;       /* B-frames between reference frames (-1 = encoder default) */
+    int64_t bit_rate;       /* Target bit rate in bits/s (0 = constant quality) */
+    int quality;            /* Constant quality when bit_rate is 0: CRF for x264/x265,
+                               CQ for NVENC, QP for VA-API, qscale otherwise
+                               (-1 = encoder default) */
+    const char* preset;     /* Encoder speed preset (e.g. "medium"), NULL for the default */
+    int num_threads;        /* Encode threads (0 = library thread budget, or 1 on a pool worker) */
+    int hw_devices;         /* VIDEO_HW_* encoders to try, in bit order (0 = software only) */
+    int hw_required;        /* 1 = fail when no hardware encoder opens */
+    const char* hw_device_name; /* Device to open, NULL for the default */
+} video_encoder_params_t;
+
+/**
+ * Information about an encoded packet.
+ */
+typedef struct {
+    size_t size;            /* Packet size in bytes (also set when the output buffer is too small) */
+    int64_t pts;            /* Presentation timestamp (frame number) */
+    int64_t dts;            /* Decode timestamp (frame units) */
+    int key_frame;          /* 1 if the packet starts a key frame */
+} video_packet_info_t;
+
+/**
+ * Creates a video encoder.
+ *
+ * Software encoders are FFmpeg's mpeg2video and mpeg4, libx264 and
+ * libx265. Hardware encoders are NVENC (VIDEO_HW_CUDA), VA-API,
+ * Media Foundation (VIDEO_HW_D3D11VA) and VideoToolbox; they are tried
+ * in bit order before falling back to software, unless hw_required is set.
+ *
+ * Packets are Annex B / elementary stream data with the parameter sets
+ * in-band, as the DICOM video transfer syntaxes store them.
+ *
+ * @param codec_id      VIDEO_CODEC_* identifier
+ * @param params        Encoder parameters
+ * @param encoder_out   Pointer to receive encoder handle
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: Invalid codec_id or parameters
+ *         - SHARPDICOM_ERR_UNSUPPORTED: No encoder for the codec, or no
+ *           hardware encoder with hw_required set
+ *         - SHARPDICOM_ERR_OUT_OF_MEMORY: Allocation failed
+ */
+SHARPDICOM_API int video_encoder_create(
+    int codec_id,
+    const video_encoder_params_t* params,
+    video_encoder_t** encoder_out
+);
+
+/**
+ * Submits one frame for encoding.
+ *
+ * Encoders buffer frames (lookahead, B-frames), so packets come out later
+ * through video_encoder_receive_packet(). Receive every available packet
+ * before sending the next frame.
+ *
+ * @param encoder       Encoder handle
+ * @param input         Frame pixels in params.input_format, or NULL to
+ *                      signal the end of the stream
+ * @param input_len     Size of input (at least one full frame)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code:
+ *         - SHARPDICOM_ERR_INVALID_ARGUMENT: Input too small, or packets
+ *           still waiting to be received
+ *         - SHARPDICOM_ERR_ENCODE_FAILED: Encoder error
+ */
+SHARPDICOM_API int video_encoder_send_frame(
+    video_encoder_t* encoder,
+    const uint8_t* input,
+    size_t input_len
+);
+
+/**
+ * Retrieves the next encoded packet into a caller buffer.
+ *
+ * If the buffer is too small, SHARPDICOM_ERR_INVALID_ARGUMENT is returned
+ * with info->size set to the packet size; the packet is kept and returned
+ * by the next call.
+ *
+ * @param encoder           Encoder handle
+ * @param output            Buffer for the packet
+ * @param output_len        Size of output buffer
+ * @param info              Pointer to receive packet information (may be NULL)
+ * @param packet_available  Pointer to receive flag (1=packet written, 0=none;
+ *                          after the end of the stream, 0 means fully drained)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int video_encoder_receive_packet(
+    video_encoder_t* encoder,
+    uint8_t* output,
+    size_t output_len,
+    video_packet_info_t* info,
+    int* packet_available
+);
+
+/**
+ * Gets an output buffer size that holds any packet at practical settings:
+ * twice the raw 4:2:0 frame plus room for headers.
+ *
+ * @param encoder       Encoder handle
+ * @param bound         Pointer to receive the size in bytes
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int video_encoder_get_packet_bound(
+    video_encoder_t* encoder,
+    size_t* bound
+);
+
+/**
+ * Gets the hardware device an encoder runs on.
+ *
+ * @param encoder       Encoder handle
+ * @param hw_device     Pointer to receive the VIDEO_HW_* device (VIDEO_HW_NONE for software)
+ *
+ * @return SHARPDICOM_OK on success, or negative error code
+ */
+SHARPDICOM_API int video_encoder_get_hw_device(
+    video_encoder_t* encoder,
+    int* hw_device
+);
+
+/**
+ * Destroys a video encoder and frees all resources.
+ *
+ * @param encoder       Encoder handle (may be NULL)
+ */
+SHARPDICOM_API void video_encoder_destroy(
+    video_encoder_t* encoder
+);
+
 #ifdef __cplusplus
 }
 #endif
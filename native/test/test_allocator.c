@@ -0,0 +1,236 @@
+/**
+ * SharpDicom Native Codecs - Memory Allocator Test Executable
+ *
+ * Checks:
+ * - A backing allocator can be installed before first use and not after
+ * - Blocks are 32-byte aligned; calloc zeroes, realloc keeps contents
+ * - Freed blocks of a size class are reused by the thread cache, within
+ *   the per-class count and the byte limit
+ * - Releasing the thread cache returns every block to the backing allocator
+ * - Blocks freed on pool workers stay valid and are accounted for
+ * - Steady-state RLE decode stops calling the backing allocator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/allocator.h"
+#include "../src/thread_pool.h"
+#include "../src/rle_wrapper.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+/** Backing allocator that counts its calls */
+typedef struct {
+    volatile int64_t allocs;
+    volatile int64_t frees;
+} counting_heap;
+
+static void* counting_alloc(void* opaque, size_t size) {
+    counting_heap* heap = (counting_heap*)opaque;
+    __atomic_fetch_add(&heap->allocs, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+static void counting_free(void* opaque, void* ptr) {
+    counting_heap* heap = (counting_heap*)opaque;
+    __atomic_fetch_add(&heap->frees, 1, __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+static int64_t heap_allocs(counting_heap* heap) {
+    return __atomic_load_n(&heap->allocs, __ATOMIC_RELAXED);
+}
+
+static int64_t heap_live(counting_heap* heap) {
+    return __atomic_load_n(&heap->allocs, __ATOMIC_RELAXED) -
+           __atomic_load_n(&heap->frees, __ATOMIC_RELAXED);
+}
+
+#define WORKER_BLOCKS 64
+
+static void free_task(void* context, size_t index) {
+    void** blocks = (void**)context;
+    allocator_free(blocks[index]);
+}
+
+int main(void) {
+    printf("=== SharpDicom Memory Allocator Tests ===\n\n");
+
+    static counting_heap heap;
+    sharpdicom_allocator_t backing = { counting_alloc, counting_free, &heap };
+
+    /* Test 1: Installing the backing allocator */
+    printf("Test 1: Backing allocator\n");
+    {
+        sharpdicom_allocator_t incomplete = { counting_alloc, NULL, &heap };
+        TEST(sharpdicom_set_allocator(&incomplete) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "Allocator without free callback rejected");
+        TEST(sharpdicom_set_allocator(&backing) == SHARPDICOM_OK, "Allocator installed before first use");
+
+        void* block = allocator_alloc(100);
+        TEST(block != NULL && heap_allocs(&heap) == 1, "Allocation reaches the backing allocator");
+        allocator_free(block);
+        TEST(heap_live(&heap) == 0, "Small block returned straight away");
+
+        TEST(sharpdicom_set_allocator(NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "Allocator cannot be replaced after use");
+        TEST(sharpdicom_get_thread_cache_limit() == ALLOCATOR_DEFAULT_CACHE_LIMIT, "Default cache limit");
+    }
+    printf("\n");
+
+    /* Test 2: Alignment, calloc and realloc */
+    printf("Test 2: Block contents\n");
+    {
+        static const size_t sizes[] = { 0, 1, 31, 33, 4096, 65535, 65536, 100000, 3u << 20 };
+        int aligned = 1;
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            uint8_t* block = (uint8_t*)allocator_alloc(sizes[i]);
+            aligned &= (block != NULL && ((uintptr_t)block % ALLOCATOR_ALIGNMENT) == 0);
+            if (block) {
+                memset(block, 0xA5, sizes[i] ? sizes[i] : 1);
+            }
+            allocator_free(block);
+        }
+        TEST(aligned, "Blocks are 32-byte aligned and writable");
+
+        uint8_t* zeroed = (uint8_t*)allocator_calloc(1000, 300);
+        int all_zero = (zeroed != NULL);
+        for (size_t i = 0; all_zero && i < 300000; i++) {
+            all_zero = (zeroed[i] == 0);
+        }
+        TEST(all_zero, "calloc zeroes a reused block");
+        allocator_free(zeroed);
+        TEST(allocator_calloc((size_t)-1 / 2, 4) == NULL, "calloc size overflow rejected");
+
+        uint8_t* grown = (uint8_t*)allocator_realloc(NULL, 1000);
+        for (int i = 0; grown && i < 1000; i++) {
+            grown[i] = (uint8_t)i;
+        }
+        uint8_t* same = (uint8_t*)allocator_realloc(grown, 500);
+        TEST(same == grown, "Shrinking realloc keeps the block");
+        grown = (uint8_t*)allocator_realloc(same, 200000);
+        int kept = (grown != NULL);
+        for (int i = 0; kept && i < 1000; i++) {
+            kept = (grown[i] == (uint8_t)i);
+        }
+        TEST(kept, "Growing realloc keeps the contents");
+        allocator_free(grown);
+
+        allocator_release_thread_cache();
+        TEST(heap_live(&heap) == 0, "Cache release returns every block");
+    }
+    printf("\n");
+
+    /* Test 3: Thread cache */
+    printf("Test 3: Thread cache\n");
+    {
+        void* first = allocator_alloc((size_t)1 << 20);
+        allocator_free(first);
+        int64_t allocs = heap_allocs(&heap);
+        void* again = allocator_alloc(900 * 1024);
+        TEST(again == first && heap_allocs(&heap) == allocs, "Same size class reuses the cached block");
+        allocator_free(again);
+
+        void* other = allocator_alloc(2u << 20);
+        TEST(other != first && heap_allocs(&heap) == allocs + 1, "Other size class allocates");
+        allocator_free(other);
+        allocator_release_thread_cache();
+
+        void* blocks[6];
+        for (int i = 0; i < 6; i++) {
+            blocks[i] = allocator_alloc(256 * 1024);
+        }
+        for (int i = 0; i < 6; i++) {
+            allocator_free(blocks[i]);
+        }
+        TEST(heap_live(&heap) == 4, "At most four blocks cached per size class");
+        allocator_release_thread_cache();
+
+        sharpdicom_set_thread_cache_limit(300 * 1024);
+        blocks[0] = allocator_alloc(256 * 1024);
+        blocks[1] = allocator_alloc(256 * 1024);
+        allocator_free(blocks[0]);
+        allocator_free(blocks[1]);
+        TEST(heap_live(&heap) == 1, "Cache stays within its byte limit");
+        allocator_release_thread_cache();
+
+        sharpdicom_set_thread_cache_limit(0);
+        blocks[0] = allocator_alloc(256 * 1024);
+        allocator_free(blocks[0]);
+        TEST(heap_live(&heap) == 0, "Limit 0 disables caching");
+        sharpdicom_set_thread_cache_limit(ALLOCATOR_DEFAULT_CACHE_LIMIT);
+    }
+    printf("\n");
+
+    /* Test 4: Blocks freed on other threads */
+    printf("Test 4: Cross-thread free\n");
+    {
+        void* blocks[WORKER_BLOCKS];
+        int allocated = 1;
+        for (int i = 0; i < WORKER_BLOCKS; i++) {
+            blocks[i] = allocator_alloc(128 * 1024);
+            allocated &= (blocks[i] != NULL);
+        }
+        TEST(allocated, "Blocks allocated on the calling thread");
+        TEST(thread_pool_parallel_for(WORKER_BLOCKS, 4, free_task, blocks) == SHARPDICOM_OK,
+             "Blocks freed on pool workers");
+        allocator_release_thread_cache();
+        /* Workers keep up to four blocks each in their own caches */
+        int64_t live = heap_live(&heap);
+        TEST(live >= 0 && live <= 4 * (THREAD_POOL_MAX_THREADS - 1), "Worker caches hold the rest");
+    }
+    printf("\n");
+
+    /* Test 5: Steady-state codec use */
+    printf("Test 5: Steady-state RLE decode\n");
+    {
+        rle_params_t params = { 512, 512, 3, 8, RLE_PLANAR_INTERLEAVED };
+        size_t raw_len = 512 * 512 * 3;
+        size_t bound = 0;
+        uint8_t* raw = (uint8_t*)malloc(raw_len);
+        uint8_t* decoded = (uint8_t*)malloc(raw_len);
+        uint8_t* rle = NULL;
+        size_t actual = 0;
+        int ok = raw && decoded && rle_get_encode_bound(&params, &bound) == SHARPDICOM_OK &&
+                 (rle = (uint8_t*)malloc(bound)) != NULL;
+        for (size_t i = 0; ok && i < raw_len; i++) {
+            raw[i] = (uint8_t)((i / 7) & 0xF0);
+        }
+        ok = ok && rle_encode(raw, raw_len, rle, bound, &actual, &params) == SHARPDICOM_OK;
+        ok = ok && rle_decode(rle, actual, decoded, raw_len, &params) == SHARPDICOM_OK;
+        TEST(ok && memcmp(raw, decoded, raw_len) == 0, "Frame round-trips");
+
+        int64_t allocs = heap_allocs(&heap);
+        for (int i = 0; ok && i < 5; i++) {
+            ok = rle_decode(rle, actual, decoded, raw_len, &params) == SHARPDICOM_OK;
+        }
+        TEST(ok && heap_allocs(&heap) == allocs, "Repeated decodes reuse the plane buffer");
+
+        free(raw);
+        free(decoded);
+        free(rle);
+    }
+    printf("\n");
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,510 @@
+/**
+ * SharpDicom Native Codecs - JPEG 2000 Codestream Scanner Test Executable
+ *
+ * Builds synthetic codestreams (real marker structure, filler packet bytes)
+ * and feeds them to the scanner in small chunks, checking after every chunk:
+ * - Reported resolutions/layers match a brute-force count of received packets
+ * - The decodable prefix never ends inside a header or a packet
+ * - Tile-parts without PLT, Psot of zero and reporting limits are honoured
+ * - Malformed streams are rejected and stay rejected
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/j2k_codestream.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+/*============================================================================
+ * Synthetic codestream builder
+ *============================================================================*/
+
+#define MAX_TILES    8
+#define MAX_PACKETS  512
+#define MAX_LAYERS   8
+#define MAX_RES      8
+
+typedef struct {
+    uint32_t width, height;
+    uint32_t tile_w, tile_h;
+    uint32_t comps;
+    uint32_t levels;
+    uint32_t layers;
+    uint32_t progression;     /* 0 = LRCP, 1 = RLCP */
+    uint32_t precinct_exp;    /* 0 = default precincts, else PPx = PPy = precinct_exp */
+    int plt;                  /* Write PLT markers */
+    uint32_t parts;           /* Tile-parts per tile */
+    int interleave_parts;     /* Part 0 of every tile, then part 1, ... */
+    int psot_zero;            /* Psot = 0 on the final tile-part */
+} cs_spec;
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t cap;
+    uint32_t num_tiles;
+    uint32_t num_packets[MAX_TILES];
+    uint8_t packet_layer[MAX_TILES][MAX_PACKETS];
+    uint8_t packet_res[MAX_TILES][MAX_PACKETS];
+    size_t packet_end[MAX_TILES][MAX_PACKETS];
+} cs_stream;
+
+static void put8(cs_stream* s, uint32_t v) {
+    if (s->size == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 1024;
+        s->data = (uint8_t*)realloc(s->data, s->cap);
+    }
+    s->data[s->size++] = (uint8_t)v;
+}
+
+static void put16(cs_stream* s, uint32_t v) {
+    put8(s, v >> 8);
+    put8(s, v);
+}
+
+static void put32(cs_stream* s, uint32_t v) {
+    put16(s, v >> 16);
+    put16(s, v);
+}
+
+static void patch32(cs_stream* s, size_t at, uint32_t v) {
+    s->data[at] = (uint8_t)(v >> 24);
+    s->data[at + 1] = (uint8_t)(v >> 16);
+    s->data[at + 2] = (uint8_t)(v >> 8);
+    s->data[at + 3] = (uint8_t)v;
+}
+
+static uint32_t ceil_div32(uint32_t a, uint32_t b) {
+    return (a + b - 1) / b;
+}
+
+/** Precincts of one component at resolution r of tile t (every component alike) */
+static uint32_t precincts(const cs_spec* spec, uint32_t t, uint32_t r) {
+    uint32_t tiles_x = ceil_div32(spec->width, spec->tile_w);
+    uint32_t x0 = (t % tiles_x) * spec->tile_w;
+    uint32_t y0 = (t / tiles_x) * spec->tile_h;
+    uint32_t x1 = x0 + spec->tile_w < spec->width ? x0 + spec->tile_w : spec->width;
+    uint32_t y1 = y0 + spec->tile_h < spec->height ? y0 + spec->tile_h : spec->height;
+    uint32_t scale = 1u << (spec->levels - r);
+    uint32_t rx0 = ceil_div32(x0, scale), rx1 = ceil_div32(x1, scale);
+    uint32_t ry0 = ceil_div32(y0, scale), ry1 = ceil_div32(y1, scale);
+    uint32_t pp = spec->precinct_exp ? spec->precinct_exp : 15;
+    return (ceil_div32(rx1, 1u << pp) - (rx0 >> pp)) * (ceil_div32(ry1, 1u << pp) - (ry0 >> pp));
+}
+
+static uint32_t packet_len(uint32_t t, uint32_t k) {
+    return 3 + (k * 37 + t * 11) % 190;
+}
+
+static void build_stream(const cs_spec* spec, cs_stream* s) {
+    memset(s, 0, sizeof(*s));
+    uint32_t tiles_x = ceil_div32(spec->width, spec->tile_w);
+    uint32_t tiles_y = ceil_div32(spec->height, spec->tile_h);
+    s->num_tiles = tiles_x * tiles_y;
+
+    /* Packet sequence of each tile */
+    for (uint32_t t = 0; t < s->num_tiles; t++) {
+        uint32_t n = 0;
+        for (uint32_t a = 0; a < (spec->progression ? spec->levels + 1 : spec->layers); a++) {
+            for (uint32_t b = 0; b < (spec->progression ? spec->layers : spec->levels + 1); b++) {
+                uint32_t l = spec->progression ? b : a;
+                uint32_t r = spec->progression ? a : b;
+                uint32_t count = spec->comps * precincts(spec, t, r);
+                for (uint32_t i = 0; i < count; i++, n++) {
+                    s->packet_layer[t][n] = (uint8_t)l;
+                    s->packet_res[t][n] = (uint8_t)r;
+                }
+            }
+        }
+        s->num_packets[t] = n;
+    }
+
+    /* Main header: SOC, SIZ, COD, QCD */
+    put16(s, 0xFF4F);
+    put16(s, 0xFF51);
+    put16(s, 38 + 3 * spec->comps);
+    put16(s, 0);
+    put32(s, spec->width);
+    put32(s, spec->height);
+    put32(s, 0);
+    put32(s, 0);
+    put32(s, spec->tile_w);
+    put32(s, spec->tile_h);
+    put32(s, 0);
+    put32(s, 0);
+    put16(s, spec->comps);
+    for (uint32_t c = 0; c < spec->comps; c++) {
+        put8(s, 7);
+        put8(s, 1);
+        put8(s, 1);
+    }
+    put16(s, 0xFF52);
+    put16(s, 12 + (spec->precinct_exp ? spec->levels + 1 : 0));
+    put8(s, spec->precinct_exp ? 1 : 0);
+    put8(s, spec->progression);
+    put16(s, spec->layers);
+    put8(s, 0);
+    put8(s, spec->levels);
+    put8(s, 4);
+    put8(s, 4);
+    put8(s, 0);
+    put8(s, 1);
+    for (uint32_t r = 0; spec->precinct_exp && r <= spec->levels; r++) {
+        put8(s, spec->precinct_exp | (spec->precinct_exp << 4));
+    }
+    put16(s, 0xFF5C);
+    put16(s, 3 + 1 + 3 * spec->levels);
+    put8(s, 0x40);
+    for (uint32_t i = 0; i < 1 + 3 * spec->levels; i++) {
+        put8(s, 0x48);
+    }
+
+    /* Tile-parts */
+    uint32_t total_parts = s->num_tiles * spec->parts;
+    for (uint32_t seq = 0; seq < total_parts; seq++) {
+        uint32_t t = spec->interleave_parts ? seq % s->num_tiles : seq / spec->parts;
+        uint32_t part = spec->interleave_parts ? seq / s->num_tiles : seq % spec->parts;
+        uint32_t first = s->num_packets[t] * part / spec->parts;
+        uint32_t last = s->num_packets[t] * (part + 1) / spec->parts;
+
+        size_t sot = s->size;
+        put16(s, 0xFF90);
+        put16(s, 10);
+        put16(s, t);
+        put32(s, 0);
+        put8(s, part);
+        put8(s, spec->parts);
+
+        if (spec->plt) {
+            size_t lplt_at = s->size + 2;
+            put16(s, 0xFF58);
+            put16(s, 0);
+            put8(s, 0);
+            for (uint32_t k = first; k < last; k++) {
+                uint32_t len = packet_len(t, k);
+                if (len >= 128) {
+                    put8(s, 0x80 | (len >> 7));
+                }
+                put8(s, len & 0x7F);
+            }
+            size_t lplt = s->size - lplt_at;
+            s->data[lplt_at] = (uint8_t)(lplt >> 8);
+            s->data[lplt_at + 1] = (uint8_t)lplt;
+        }
+
+        put16(s, 0xFF93);
+        for (uint32_t k = first; k < last; k++) {
+            uint32_t len = packet_len(t, k);
+            for (uint32_t i = 0; i < len; i++) {
+                put8(s, (k + i) & 0x7F);
+            }
+            s->packet_end[t][k] = s->size;
+        }
+
+        int final_part = (seq == total_parts - 1);
+        patch32(s, sot + 6, (spec->psot_zero && final_part) ? 0 : (uint32_t)(s->size - sot));
+    }
+    put16(s, 0xFFD9);
+}
+
+/*============================================================================
+ * Brute-force oracle
+ *============================================================================*/
+
+/** Resolutions decodable at `layers` layers from the packets received within n bytes */
+static uint32_t oracle_resolutions(const cs_spec* spec, const cs_stream* s, size_t n, uint32_t layers) {
+    uint32_t best = spec->levels + 1;
+    for (uint32_t t = 0; t < s->num_tiles; t++) {
+        int complete[MAX_LAYERS][MAX_RES];
+        for (uint32_t l = 0; l < spec->layers; l++) {
+            for (uint32_t r = 0; r <= spec->levels; r++) {
+                complete[l][r] = 1;
+            }
+        }
+        for (uint32_t k = 0; k < s->num_packets[t]; k++) {
+            if (s->packet_end[t][k] > n) {
+                complete[s->packet_layer[t][k]][s->packet_res[t][k]] = 0;
+            }
+        }
+        uint32_t res = 0;
+        while (res <= spec->levels) {
+            int ok = 1;
+            for (uint32_t l = 0; l < layers; l++) {
+                ok &= complete[l][res];
+            }
+            if (!ok) {
+                break;
+            }
+            res++;
+        }
+        if (res < best) {
+            best = res;
+        }
+    }
+    return best;
+}
+
+/**
+ * Feed the stream in chunks and compare every report against the oracle.
+ *
+ * @return Number of mismatching reports
+ */
+static int check_against_oracle(const cs_spec* spec, const cs_stream* s, size_t chunk,
+                                int* saw_partial, int* saw_cut) {
+    j2k_cs_scanner_t* cs = NULL;
+    if (j2k_cs_scanner_create(&cs) != SHARPDICOM_OK) {
+        return 1;
+    }
+
+    int mismatches = 0;
+    int32_t last_res = 0;
+    for (size_t n = 0; n <= s->size; n = (n == s->size) ? n + 1 : (n + chunk > s->size ? s->size : n + chunk)) {
+        J2kCsProgress pr;
+        if (j2k_cs_scanner_update(cs, s->data, n, &pr) != SHARPDICOM_OK) {
+            mismatches++;
+            break;
+        }
+        uint32_t want_res = (n == s->size) ? spec->levels + 1 : oracle_resolutions(spec, s, n, 1);
+        uint32_t want_layers = 0;
+        if (want_res > 0) {
+            want_layers = 1;
+            while (want_layers < spec->layers && (n == s->size ||
+                   oracle_resolutions(spec, s, n, want_layers + 1) == want_res)) {
+                want_layers++;
+            }
+        }
+        if ((uint32_t)pr.resolutions != want_res || (uint32_t)pr.layers != want_layers) {
+            if (mismatches < 3) {
+                printf("  at %zu/%zu: got R=%d L=%d, want R=%u L=%u\n",
+                       n, s->size, pr.resolutions, pr.layers, want_res, want_layers);
+            }
+            mismatches++;
+        }
+        if (pr.resolutions < last_res || pr.decodable_end > n) {
+            mismatches++;
+        }
+        last_res = pr.resolutions;
+
+        /* The reported level is backed by the decodable prefix alone */
+        if (n < s->size && oracle_resolutions(spec, s, pr.decodable_end, 1) < (uint32_t)pr.resolutions) {
+            mismatches++;
+        }
+        if (pr.resolutions > 0 && pr.resolutions < (int32_t)(spec->levels + 1)) {
+            *saw_partial = 1;
+        }
+        if (pr.cut_sot != 0) {
+            *saw_cut = 1;
+            if (pr.cut_sot >= pr.decodable_end || s->data[pr.cut_sot] != 0xFF ||
+                s->data[pr.cut_sot + 1] != 0x90) {
+                mismatches++;
+            }
+        }
+        if (n == s->size && !pr.complete) {
+            mismatches++;
+        }
+    }
+
+    j2k_cs_scanner_destroy(cs);
+    return mismatches;
+}
+
+/** Scan a whole stream at once */
+static int scan_all(const uint8_t* data, size_t n, J2kCsProgress* pr) {
+    j2k_cs_scanner_t* cs = NULL;
+    if (j2k_cs_scanner_create(&cs) != SHARPDICOM_OK) {
+        return SHARPDICOM_ERR_OUT_OF_MEMORY;
+    }
+    int status = j2k_cs_scanner_update(cs, data, n, pr);
+    j2k_cs_scanner_destroy(cs);
+    return status;
+}
+
+int main(void) {
+    printf("=== SharpDicom JPEG 2000 Codestream Scanner Test ===\n\n");
+
+    /* Test 1: Resolution-progressive single tile */
+    printf("Test 1: RLCP, one tile, PLT\n");
+    {
+        cs_spec spec = { 256, 192, 256, 192, 3, 5, 2, 1, 0, 1, 1, 0, 0 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        int partial = 0, cut = 0;
+        TEST(check_against_oracle(&spec, &s, 7, &partial, &cut) == 0,
+             "Reports match received packets at every 7-byte chunk");
+        TEST(partial && cut, "Intermediate resolutions reported from inside the tile-part");
+
+        J2kCsProgress pr;
+        TEST(scan_all(s.data, 40, &pr) == SHARPDICOM_OK && !pr.header_ready && pr.resolutions == 0,
+             "Partial main header is not ready");
+        TEST(scan_all(s.data, s.size, &pr) == SHARPDICOM_OK && pr.header_ready && pr.complete &&
+             pr.num_resolutions == 6 && pr.num_layers == 2 &&
+             pr.resolutions == 6 && pr.layers == 2 && pr.decodable_end == s.size - 2,
+             "Complete stream decodes in full");
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Test 2: Layer-progressive with user precincts */
+    printf("Test 2: LRCP, precinct partitions, byte-by-byte\n");
+    {
+        cs_spec spec = { 100, 70, 100, 70, 1, 3, 3, 0, 4, 1, 1, 0, 0 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        int partial = 0, cut = 0;
+        TEST(s.num_packets[0] == 3 * (1 + 4 + 12 + 35), "Builder precinct count is as expected");
+        TEST(check_against_oracle(&spec, &s, 1, &partial, &cut) == 0,
+             "Reports match received packets at every byte");
+        TEST(cut, "Layers reported from inside the tile-part");
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Test 3: Several tiles and tile-parts */
+    printf("Test 3: Multiple tiles and tile-parts\n");
+    {
+        cs_spec spec = { 200, 120, 128, 64, 2, 2, 2, 1, 0, 1, 3, 1, 0 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        int partial = 0, cut = 0;
+        TEST(s.num_tiles == 4, "Four tiles");
+        TEST(check_against_oracle(&spec, &s, 13, &partial, &cut) == 0,
+             "Interleaved tile-parts: reports are the minimum over tiles");
+        TEST(partial, "Interleaved tile-parts refine all tiles together");
+        free(s.data);
+
+        spec.interleave_parts = 0;
+        spec.progression = 0;
+        build_stream(&spec, &s);
+        TEST(check_against_oracle(&spec, &s, 13, &partial, &cut) == 0,
+             "Tile-ordered LRCP: reports are the minimum over tiles");
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Test 4: Tile-parts without PLT */
+    printf("Test 4: No packet lengths\n");
+    {
+        cs_spec spec = { 64, 64, 64, 64, 1, 2, 1, 1, 0, 0, 2, 0, 0 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        size_t part1_end = s.packet_end[0][s.num_packets[0] / 2 - 1];
+        J2kCsProgress pr;
+        TEST(scan_all(s.data, part1_end - 1, &pr) == SHARPDICOM_OK && pr.resolutions == 0 &&
+             pr.cut_sot == 0 && pr.decodable_end < part1_end,
+             "Nothing decodable inside a tile-part without PLT");
+        TEST(scan_all(s.data, part1_end, &pr) == SHARPDICOM_OK && pr.resolutions == 0 &&
+             pr.decodable_end == part1_end,
+             "First of two tile-parts completes the prefix only");
+        TEST(scan_all(s.data, s.size - 2, &pr) == SHARPDICOM_OK && pr.resolutions == 3 && !pr.complete,
+             "Last tile-part completes the tile");
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Test 5: Psot of zero */
+    printf("Test 5: Final tile-part runs to EOC\n");
+    {
+        cs_spec spec = { 64, 64, 64, 64, 1, 2, 1, 1, 0, 0, 1, 0, 1 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        J2kCsProgress pr;
+        TEST(scan_all(s.data, s.size - 1, &pr) == SHARPDICOM_OK && pr.resolutions == 0,
+             "Psot=0 tile-part without PLT is open until EOC");
+        TEST(scan_all(s.data, s.size, &pr) == SHARPDICOM_OK && pr.complete && pr.resolutions == 3,
+             "EOC closes the tile-part");
+        free(s.data);
+
+        spec.plt = 1;
+        build_stream(&spec, &s);
+        int partial = 0, cut = 0;
+        TEST(check_against_oracle(&spec, &s, 5, &partial, &cut) == 0,
+             "Psot=0 tile-part with PLT refines as packets arrive");
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Test 6: Reporting limits */
+    printf("Test 6: Reduce and layer limits\n");
+    {
+        cs_spec spec = { 128, 128, 128, 128, 1, 3, 4, 0, 0, 1, 1, 0, 0 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        j2k_cs_scanner_t* cs = NULL;
+        J2kCsProgress pr;
+        TEST(j2k_cs_scanner_create(&cs) == SHARPDICOM_OK, "Scanner created");
+        j2k_cs_scanner_set_limits(cs, 2, 3);
+        TEST(j2k_cs_scanner_update(cs, s.data, s.size, &pr) == SHARPDICOM_OK &&
+             pr.resolutions == 2 && pr.layers == 3 && pr.num_resolutions == 4,
+             "Complete stream reported at the limits");
+
+        j2k_cs_scanner_reset(cs);
+        j2k_cs_scanner_set_limits(cs, 0, 0);
+        TEST(j2k_cs_scanner_update(cs, s.data, s.packet_end[0][3], &pr) == SHARPDICOM_OK &&
+             pr.resolutions == 4 && pr.layers == 1,
+             "Reset scanner reports the first layer at full resolution");
+        j2k_cs_scanner_destroy(cs);
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Test 7: Error handling */
+    printf("Test 7: Error handling\n");
+    {
+        cs_spec spec = { 64, 64, 64, 64, 1, 1, 1, 1, 0, 1, 1, 0, 0 };
+        cs_stream s;
+        build_stream(&spec, &s);
+        J2kCsProgress pr;
+        j2k_cs_scanner_t* cs = NULL;
+
+        static const uint8_t jp2[12] = { 0, 0, 0, 12, 'j', 'P', ' ', ' ', 0x0D, 0x0A, 0x87, 0x0A };
+        TEST(j2k_cs_scanner_create(&cs) == SHARPDICOM_OK &&
+             j2k_cs_scanner_update(cs, jp2, sizeof(jp2), &pr) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "JP2 file rejected (raw codestreams only)");
+        TEST(j2k_cs_scanner_update(cs, s.data, s.size, &pr) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Scanner stays failed until reset");
+        j2k_cs_scanner_reset(cs);
+        TEST(j2k_cs_scanner_update(cs, s.data, s.size, &pr) == SHARPDICOM_OK && pr.complete,
+             "Reset scanner recovers");
+        TEST(j2k_cs_scanner_update(cs, s.data, 10, &pr) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "Shrinking prefix rejected");
+        j2k_cs_scanner_destroy(cs);
+
+        uint8_t* bad = (uint8_t*)malloc(s.size);
+        memcpy(bad, s.data, s.size);
+        bad[s.size - 1] = 0x42;
+        TEST(scan_all(bad, s.size, &pr) ==
+             SHARPDICOM_ERR_CORRUPT_DATA, "Unknown marker after the last tile-part rejected");
+        memcpy(bad, s.data, s.size);
+        bad[2 + 4 + 36 + 1] = 0;
+        TEST(scan_all(bad, s.size, &pr) ==
+             SHARPDICOM_ERR_CORRUPT_DATA, "Bad component subsampling rejected");
+        free(bad);
+
+        TEST(j2k_cs_scanner_create(NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT, "NULL scanner_out rejected");
+        j2k_cs_scanner_destroy(NULL);
+        free(s.data);
+    }
+    printf("\n");
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,326 @@
+/**
+ * SharpDicom Native Codecs - Pixel Conversion Test Executable
+ *
+ * Checks every SIMD kernel set available on this CPU against the scalar
+ * reference for 1/2/3/4-component, 8-bit and 16-bit conversion:
+ * - Signed offset and clamping
+ * - Row tails shorter than a vector
+ * - Output row stride
+ * - Display (window / VOI LUT) transform, against the PS3.3 formulas
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/pixel_convert.h"
+#include "../src/display.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+#define MAX_COMPS 4
+
+/** Deterministic pseudo-random samples covering out-of-range values */
+static uint32_t rng_state = 12345u;
+static int32_t next_sample(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (int32_t)((rng_state >> 8) % 140000u) - 70000;
+}
+
+/** Straightforward per-pixel reference conversion */
+static void reference_convert(
+    int32_t* const* planes, const int32_t* offsets, int comps,
+    size_t width, size_t height, int bps, uint8_t* out, size_t stride
+) {
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            for (int c = 0; c < comps; c++) {
+                int32_t v = planes[c][y * width + x] + offsets[c];
+                int32_t max = (bps == 1) ? 255 : 65535;
+                if (v < 0) v = 0;
+                if (v > max) v = max;
+                size_t idx = y * stride + (x * (size_t)comps + (size_t)c) * (size_t)bps;
+                if (bps == 1) {
+                    out[idx] = (uint8_t)v;
+                } else {
+                    uint16_t s = (uint16_t)v;
+                    memcpy(out + idx, &s, sizeof(s));
+                }
+            }
+        }
+    }
+}
+
+/** Run one conversion case with the current kernel set; returns 1 on match */
+static int run_case(int comps, int bps, size_t width, size_t height, size_t pad) {
+    int32_t* planes[MAX_COMPS];
+    int32_t offsets[MAX_COMPS];
+    size_t samples = width * height;
+    size_t stride = width * (size_t)comps * (size_t)bps + pad;
+    size_t out_len = stride * height;
+
+    for (int c = 0; c < comps; c++) {
+        planes[c] = (int32_t*)malloc(samples * sizeof(int32_t));
+        for (size_t i = 0; i < samples; i++) {
+            planes[c][i] = next_sample();
+        }
+        offsets[c] = (c == 1) ? (1 << 11) : 0;
+    }
+
+    uint8_t* expected = (uint8_t*)calloc(1, out_len);
+    uint8_t* actual = (uint8_t*)calloc(1, out_len);
+    reference_convert(planes, offsets, comps, width, height, bps, expected, stride);
+    pixel_interleave_i32((const int32_t* const*)planes, offsets, comps, width, height, bps,
+                         actual, pad ? stride : 0);
+
+    int ok = (memcmp(expected, actual, out_len) == 0);
+
+    free(expected);
+    free(actual);
+    for (int c = 0; c < comps; c++) {
+        free(planes[c]);
+    }
+    return ok;
+}
+
+/** Run all cases against the kernel set selected by the given SIMD mask */
+static void run_kernel_set(int mask, const char* name) {
+    static const size_t widths[] = { 1, 7, 8, 15, 16, 31, 33, 64, 97 };
+    char message[128];
+
+    pixel_convert_set_simd_mask(mask);
+    printf("  Kernel set: %s (level 0x%x)\n", name, pixel_convert_simd_level());
+
+    for (int comps = 1; comps <= MAX_COMPS; comps++) {
+        for (int bps = 1; bps <= 2; bps++) {
+            int ok = 1;
+            for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+                ok &= run_case(comps, bps, widths[w], 5, 0);
+                ok &= run_case(comps, bps, widths[w], 3, 6);
+            }
+            snprintf(message, sizeof(message), "%s: %d component(s), %d-bit matches reference",
+                     name, comps, bps * 8);
+            TEST(ok, message);
+        }
+    }
+}
+
+/** Display value straight from the PS3.3 C.11.2.1.2 / C.11.2.1.3 formulas */
+static double reference_display(int32_t stored, const display_params_t* p) {
+    double slope = (p->rescale_slope != 0.0) ? p->rescale_slope : 1.0;
+    double y = stored * slope + p->rescale_intercept;
+    double c = p->window_center, w = p->window_width, out;
+    if (p->voi_function == DISPLAY_VOI_LINEAR_EXACT) {
+        out = ((y - c) / w + 0.5) * 255.0;
+    } else {
+        out = ((y - (c - 0.5)) / (w - 1.0) + 0.5) * 255.0;
+    }
+    if (out < 0.0) out = 0.0;
+    if (out > 255.0) out = 255.0;
+    return p->invert ? 255.0 - out : out;
+}
+
+/** Window cases exercised by every kernel set */
+static const display_params_t display_cases[] = {
+    /* slope, intercept, center, width, function, invert */
+    { 1.0, -1024.0, 40.0, 400.0, DISPLAY_VOI_LINEAR, 0, 0, 0, 0, NULL },
+    { 1.0, -1024.0, 40.0, 400.0, DISPLAY_VOI_LINEAR, 1, 0, 0, 0, NULL },
+    { 0.5, 10.0, 300.0, 1500.0, DISPLAY_VOI_LINEAR_EXACT, 0, 0, 0, 0, NULL },
+    { 2.0, 0.0, -20.0, 7.0, DISPLAY_VOI_LINEAR, 0, 0, 0, 0, NULL },
+};
+
+#define NUM_DISPLAY_CASES (sizeof(display_cases) / sizeof(display_cases[0]))
+
+/** Display output of every window case, by the scalar kernels */
+static uint8_t* display_expected[NUM_DISPLAY_CASES][MAX_COMPS];
+
+/**
+ * Map random planes through each window case with the current kernel set.
+ * The scalar run records its output; SIMD runs must reproduce it exactly,
+ * and every run must stay within rounding of the double-precision formula.
+ */
+static void run_display_set(int mask, const char* name, size_t width, size_t height) {
+    char message[160];
+    size_t samples = width * height;
+    int record = (mask == SHARPDICOM_SIMD_NONE);
+
+    pixel_convert_set_simd_mask(mask);
+    for (size_t k = 0; k < NUM_DISPLAY_CASES; k++) {
+        for (int comps = 1; comps <= MAX_COMPS; comps++) {
+            int32_t* planes[MAX_COMPS];
+            uint32_t seed = 777u + (uint32_t)comps;
+            for (int c = 0; c < comps; c++) {
+                planes[c] = (int32_t*)malloc(samples * sizeof(int32_t));
+                for (size_t i = 0; i < samples; i++) {
+                    seed = seed * 1103515245u + 12345u;
+                    planes[c][i] = (int32_t)((seed >> 8) % 5000u) - 400;
+                }
+            }
+
+            pixel_display_map map;
+            int status = pixel_display_map_init(&map, &display_cases[k], 16, 1);
+            uint8_t* out = (uint8_t*)calloc(1, samples * (size_t)comps);
+            pixel_interleave_display_i32((const int32_t* const*)planes, comps, width, height,
+                                         &map, out, 0);
+            pixel_display_map_release(&map);
+
+            int within = (status == SHARPDICOM_OK && map.table == NULL);
+            for (size_t i = 0; i < samples * (size_t)comps && within; i++) {
+                double ref = reference_display(planes[i % (size_t)comps][i / (size_t)comps],
+                                               &display_cases[k]);
+                within = fabs((double)out[i] - ref) <= 0.51;
+            }
+
+            if (record) {
+                display_expected[k][comps - 1] = out;
+                snprintf(message, sizeof(message), "%s: window %zu, %d component(s) within rounding",
+                         name, k, comps);
+                TEST(within, message);
+            } else {
+                int same = (memcmp(out, display_expected[k][comps - 1], samples * (size_t)comps) == 0);
+                snprintf(message, sizeof(message), "%s: window %zu, %d component(s) matches scalar",
+                         name, k, comps);
+                TEST(within && same, message);
+                free(out);
+            }
+            for (int c = 0; c < comps; c++) {
+                free(planes[c]);
+            }
+        }
+    }
+}
+
+/** Convert one 16-bit sample through display_apply() */
+static int display_one(uint16_t sample, int32_t bits, const display_params_t* params) {
+    uint8_t out = 0;
+    int status = display_apply((const uint8_t*)&sample, sizeof(sample), 1, 1, 1, bits, params,
+                               &out, 1);
+    return (status == SHARPDICOM_OK) ? out : -1;
+}
+
+static void test_display_values(void) {
+    display_params_t params;
+
+    /* CT soft tissue window */
+    memset(&params, 0, sizeof(params));
+    params.rescale_slope = 1.0;
+    params.rescale_intercept = -1024.0;
+    params.window_center = 40.0;
+    params.window_width = 400.0;
+    TEST(display_one(1024, 12, &params) == 102, "LINEAR window: 0 HU maps to 102");
+    TEST(display_one(0, 12, &params) == 0, "LINEAR window: below the window is black");
+    TEST(display_one(4095, 12, &params) == 255, "LINEAR window: above the window is white");
+    TEST(display_one(0xF000 | 1024, 12, &params) == 102, "Bits above bits stored are ignored");
+    params.invert = 1;
+    TEST(display_one(1024, 12, &params) == 153, "MONOCHROME1 inverts the window");
+
+    /* No window: full stored range */
+    memset(&params, 0, sizeof(params));
+    TEST(display_one(0, 12, &params) == 0 && display_one(4095, 12, &params) == 255 &&
+         display_one(2048, 12, &params) == 128, "Zeroed parameters stretch the stored range");
+    params.is_signed = 1;
+    TEST(display_one(0x8000, 16, &params) == 0 && display_one(0x7FFF, 16, &params) == 255 &&
+         display_one(0xFFFF, 16, &params) == 127, "Signed samples are sign-extended");
+
+    /* SIGMOID is symmetric about the center */
+    memset(&params, 0, sizeof(params));
+    params.window_center = 500.0;
+    params.window_width = 200.0;
+    params.voi_function = DISPLAY_VOI_SIGMOID;
+    TEST(display_one(500, 12, &params) == 128 && display_one(0, 12, &params) == 0 &&
+         display_one(4000, 12, &params) == 255, "SIGMOID window");
+
+    /* VOI LUT indexed by rescaled value, clamped to its ends */
+    static const uint8_t lut[4] = { 10, 20, 30, 40 };
+    memset(&params, 0, sizeof(params));
+    params.rescale_intercept = 100.0;
+    params.lut = lut;
+    params.lut_first = 200;
+    params.lut_count = 4;
+    TEST(display_one(99, 12, &params) == 10 && display_one(101, 12, &params) == 20 &&
+         display_one(103, 12, &params) == 40 && display_one(900, 12, &params) == 40,
+         "VOI LUT lookup");
+
+    /* LINEAR needs width >= 1; width 1 is a threshold */
+    memset(&params, 0, sizeof(params));
+    params.window_center = 100.0;
+    params.window_width = 0.5;
+    TEST(display_one(100, 12, &params) == -1, "LINEAR rejects width below 1");
+    params.window_width = 1.0;
+    TEST(display_one(99, 12, &params) == 0 && display_one(100, 12, &params) == 255,
+         "LINEAR width 1 thresholds at center - 0.5");
+
+    uint8_t out[4];
+    uint16_t in[4] = { 0 };
+    memset(&params, 0, sizeof(params));
+    TEST(display_apply((const uint8_t*)in, sizeof(in), 2, 2, 1, 12, &params, out, 3) ==
+         SHARPDICOM_ERR_INVALID_ARGUMENT, "display_apply rejects a short output buffer");
+}
+
+int main(void) {
+    printf("=== SharpDicom Pixel Conversion Test ===\n\n");
+
+    int simd = sharpdicom_simd_features();
+
+    printf("Test 1: Scalar kernels\n");
+    run_kernel_set(SHARPDICOM_SIMD_NONE, "scalar");
+    printf("\n");
+
+    printf("Test 2: SIMD kernels\n");
+    if (simd & SHARPDICOM_SIMD_SSE4_1) {
+        run_kernel_set(SHARPDICOM_SIMD_SSE4_1, "SSE4.1");
+    }
+    if (simd & SHARPDICOM_SIMD_AVX2) {
+        run_kernel_set(SHARPDICOM_SIMD_AVX2, "AVX2");
+    }
+    if (simd & SHARPDICOM_SIMD_NEON) {
+        run_kernel_set(SHARPDICOM_SIMD_NEON, "NEON");
+    }
+    pixel_convert_set_simd_mask(-1);
+    TEST(pixel_convert_simd_level() >= 0, "Runtime kernel selection restored");
+    printf("\n");
+
+    printf("Test 3: Display kernels\n");
+    run_display_set(SHARPDICOM_SIMD_NONE, "scalar", 97, 3);
+    if (simd & SHARPDICOM_SIMD_SSE4_1) {
+        run_display_set(SHARPDICOM_SIMD_SSE4_1, "SSE4.1", 97, 3);
+    }
+    if (simd & SHARPDICOM_SIMD_AVX2) {
+        run_display_set(SHARPDICOM_SIMD_AVX2, "AVX2", 97, 3);
+    }
+    if (simd & SHARPDICOM_SIMD_NEON) {
+        run_display_set(SHARPDICOM_SIMD_NEON, "NEON", 97, 3);
+    }
+    pixel_convert_set_simd_mask(-1);
+    for (size_t k = 0; k < NUM_DISPLAY_CASES; k++) {
+        for (int c = 0; c < MAX_COMPS; c++) {
+            free(display_expected[k][c]);
+        }
+    }
+    printf("\n");
+
+    printf("Test 4: Display values\n");
+    test_display_values();
+    printf("\n");
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
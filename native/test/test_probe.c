@@ -0,0 +1,326 @@
+/**
+ * SharpDicom Native Codecs - Header Probe Test Executable
+ *
+ * Builds synthetic frame headers (real marker structure, filler entropy
+ * bytes) and checks:
+ * - JPEG, JPEG-LS, J2K, HTJ2K and JP2 headers report the coded fields
+ * - Every prefix shorter than the main header is reported as truncated
+ * - Malformed headers and unknown formats are rejected
+ * - The batch call probes each frame independently
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/probe.h"
+#include "../src/jpeg_wrapper.h"
+#include "../src/jls_wrapper.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+/*============================================================================
+ * Synthetic header builder
+ *============================================================================*/
+
+typedef struct {
+    uint8_t data[1024];
+    size_t size;
+} header_buf;
+
+static void put8(header_buf* b, uint32_t v) {
+    b->data[b->size++] = (uint8_t)v;
+}
+
+static void put16(header_buf* b, uint32_t v) {
+    put8(b, v >> 8);
+    put8(b, v);
+}
+
+static void put32(header_buf* b, uint32_t v) {
+    put16(b, v >> 16);
+    put16(b, v);
+}
+
+/** Marker segment with a filler body */
+static void put_filler_segment(header_buf* b, uint32_t marker, size_t body) {
+    put16(b, marker);
+    put16(b, (uint32_t)(body + 2));
+    for (size_t i = 0; i < body; i++) {
+        put8(b, (uint32_t)(i * 7));
+    }
+}
+
+/** JPEG baseline 4:2:0 color frame: SOI, APP0, DQT, SOF0, DHT, SOS */
+static void build_jpeg(header_buf* b, size_t* sos_offset) {
+    b->size = 0;
+    put16(b, 0xFFD8);
+    put_filler_segment(b, 0xFFE0, 14);
+    put_filler_segment(b, 0xFFDB, 65);
+    put16(b, 0xFFC0);
+    put16(b, 8 + 3 * 3);
+    put8(b, 8);
+    put16(b, 480);          /* Y */
+    put16(b, 640);          /* X */
+    put8(b, 3);
+    put8(b, 1); put8(b, 0x22); put8(b, 0);
+    put8(b, 2); put8(b, 0x11); put8(b, 1);
+    put8(b, 3); put8(b, 0x11); put8(b, 1);
+    put8(b, 0xFF);          /* Fill byte before the next marker */
+    put_filler_segment(b, 0xFFC4, 30);
+    *sos_offset = b->size;
+    put16(b, 0xFFDA);
+    put16(b, 6 + 2 * 3);
+    put8(b, 3);
+    put8(b, 1); put8(b, 0x00);
+    put8(b, 2); put8(b, 0x11);
+    put8(b, 3); put8(b, 0x11);
+    put8(b, 0); put8(b, 63); put8(b, 0);
+    for (int i = 0; i < 32; i++) {
+        put8(b, 0x5A);
+    }
+}
+
+/** JPEG-LS 12-bit gray frame with oversize dimensions in LSE */
+static void build_jls(header_buf* b, size_t* sos_offset) {
+    b->size = 0;
+    put16(b, 0xFFD8);
+    put16(b, 0xFFF7);
+    put16(b, 8 + 3);
+    put8(b, 12);
+    put16(b, 0);            /* Y in LSE */
+    put16(b, 0);            /* X in LSE */
+    put8(b, 1);
+    put8(b, 1); put8(b, 0x11); put8(b, 0);
+    put16(b, 0xFFF8);
+    put16(b, 2 + 2 + 2 * 3);
+    put8(b, 4);             /* Oversize dimensions */
+    put8(b, 3);             /* Wxy */
+    put8(b, 0x01); put8(b, 0x00); put8(b, 0x00);    /* Y = 65536 */
+    put8(b, 0x01); put8(b, 0x86); put8(b, 0xA0);    /* X = 100000 */
+    *sos_offset = b->size;
+    put16(b, 0xFFDA);
+    put16(b, 6 + 2);
+    put8(b, 1);
+    put8(b, 1); put8(b, 0);
+    put8(b, 2);             /* NEAR */
+    put8(b, JLS_INTERLEAVE_NONE);
+    put8(b, 0);
+    for (int i = 0; i < 16; i++) {
+        put8(b, 0x33);
+    }
+}
+
+/** JPEG 2000 main header: 2x2 tiles, signed 16-bit RGB, optional CAP/HT style */
+static void build_codestream(header_buf* b, int htj2k, size_t* sot_offset) {
+    put16(b, 0xFF4F);
+    put16(b, 0xFF51);
+    put16(b, 38 + 3 * 3);
+    put16(b, htj2k ? 0x4000 : 0);
+    put32(b, 1000);         /* Xsiz */
+    put32(b, 700);          /* Ysiz */
+    put32(b, 8);            /* XOsiz */
+    put32(b, 4);            /* YOsiz */
+    put32(b, 512);          /* XTsiz */
+    put32(b, 512);          /* YTsiz */
+    put32(b, 0);
+    put32(b, 0);
+    put16(b, 3);
+    for (int c = 0; c < 3; c++) {
+        put8(b, 0x80 | (c == 2 ? 11 : 15));
+        put8(b, 1);
+        put8(b, 1);
+    }
+    if (htj2k) {
+        put16(b, 0xFF50);
+        put16(b, 2 + 4 + 2);
+        put32(b, 0x00020000);
+        put16(b, 0);
+    }
+    put16(b, 0xFF52);
+    put16(b, 2 + 10);
+    put8(b, 0);              /* Scod */
+    put8(b, 2);              /* RPCL */
+    put16(b, 3);             /* Layers */
+    put8(b, 1);              /* MCT */
+    put8(b, 5);              /* Levels */
+    put8(b, 4);
+    put8(b, 4);
+    put8(b, htj2k ? 0x40 : 0);
+    put8(b, 1);
+    put_filler_segment(b, 0xFF5C, 13);
+    *sot_offset = b->size;
+    put16(b, 0xFF90);
+    put16(b, 10);
+    put16(b, 0);
+    put32(b, 0);
+    put8(b, 0);
+    put8(b, 1);
+    put16(b, 0xFF93);
+}
+
+/** JP2 wrapper: signature, ftyp, jp2h (filler) and a codestream box */
+static void build_jp2(header_buf* b, size_t* sot_offset) {
+    b->size = 0;
+    put32(b, 12); put32(b, 0x6A502020); put32(b, 0x0D0A870A);
+    put32(b, 20); put32(b, 0x66747970); put32(b, 0x6A703220); put32(b, 0); put32(b, 0x6A703220);
+    put32(b, 8 + 22); put32(b, 0x6A703268);
+    for (int i = 0; i < 22; i++) {
+        put8(b, 0);
+    }
+    put32(b, 0);             /* Codestream box runs to the end of the file */
+    put32(b, 0x6A703263);
+    build_codestream(b, 0, sot_offset);
+}
+
+/** Every prefix shorter than 'needed' must be reported as truncated */
+static int prefixes_truncated(const header_buf* b, size_t needed) {
+    probe_info_t info;
+    for (size_t len = 0; len < needed; len++) {
+        if (probe_frame(b->data, len, &info) != PROBE_ERR_TRUNCATED) {
+            printf("  prefix of %zu bytes not reported as truncated\n", len);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    printf("=== SharpDicom Header Probe Test ===\n\n");
+
+    header_buf buf;
+    probe_info_t info;
+    size_t header_end = 0;
+
+    /* Test 1: JPEG */
+    printf("Test 1: JPEG baseline\n");
+    build_jpeg(&buf, &header_end);
+    TEST(probe_frame(buf.data, buf.size, &info) == SHARPDICOM_OK, "Header probed");
+    TEST(info.codec == BATCH_CODEC_JPEG && info.sof_marker == 0xFFC0, "Codec and SOF reported");
+    TEST(info.width == 640 && info.height == 480 && info.num_components == 3 &&
+         info.bits_per_sample == 8, "Geometry matches SOF0");
+    TEST(info.subsampling == JPEG_SAMP_420, "4:2:0 subsampling recognised");
+    TEST(info.header_size == header_end, "Header ends at SOS");
+    TEST(prefixes_truncated(&buf, header_end + 4), "Short prefixes reported as truncated");
+    printf("\n");
+
+    /* Test 2: JPEG-LS */
+    printf("Test 2: JPEG-LS\n");
+    build_jls(&buf, &header_end);
+    TEST(probe_frame(buf.data, buf.size, &info) == SHARPDICOM_OK, "Header probed");
+    TEST(info.codec == BATCH_CODEC_JPEG_LS && info.sof_marker == 0xFFF7, "Codec and SOF reported");
+    TEST(info.width == 100000 && info.height == 65536, "Oversize dimensions taken from LSE");
+    TEST(info.num_components == 1 && info.bits_per_sample == 12 && info.subsampling == -1,
+         "Components and precision match SOF55");
+    TEST(info.near_lossless == 2 && info.interleave_mode == JLS_INTERLEAVE_NONE,
+         "Scan parameters reported");
+    TEST(prefixes_truncated(&buf, header_end + 10), "Short prefixes reported as truncated");
+    printf("\n");
+
+    /* Test 3: JPEG 2000 and HTJ2K codestreams */
+    printf("Test 3: JPEG 2000\n");
+    for (int htj2k = 0; htj2k <= 1; htj2k++) {
+        buf.size = 0;
+        build_codestream(&buf, htj2k, &header_end);
+        TEST(probe_frame(buf.data, buf.size, &info) == SHARPDICOM_OK, "Header probed");
+        TEST(info.codec == BATCH_CODEC_J2K && info.format == J2K_FORMAT_J2K && info.sof_marker == 0,
+             "Raw codestream reported");
+        TEST(info.width == 992 && info.height == 696 && info.num_components == 3 &&
+             info.bits_per_sample == 16 && info.is_signed == 1,
+             "Geometry matches SIZ");
+        TEST(info.tile_width == 512 && info.tile_height == 512 &&
+             info.num_tiles_x == 2 && info.num_tiles_y == 2,
+             "Tiling matches SIZ");
+        TEST(info.num_resolutions == 6 && info.num_quality_layers == 3 && info.progression_order == 2,
+             "Coding style matches COD");
+        TEST(info.is_htj2k == htj2k, htj2k ? "HTJ2K detected" : "Part 1 codestream not flagged as HTJ2K");
+        TEST(info.header_size == header_end, "Header ends at SOT");
+        TEST(prefixes_truncated(&buf, header_end + 2), "Short prefixes reported as truncated");
+    }
+    printf("\n");
+
+    /* Test 4: JP2 */
+    printf("Test 4: JP2\n");
+    build_jp2(&buf, &header_end);
+    TEST(probe_frame(buf.data, buf.size, &info) == SHARPDICOM_OK, "Header probed");
+    TEST(info.codec == BATCH_CODEC_J2K && info.format == J2K_FORMAT_JP2 &&
+         info.width == 992 && info.num_tiles_x == 2,
+         "Codestream inside the jp2c box probed");
+    TEST(info.header_size == header_end, "Header size counts the file boxes");
+    TEST(prefixes_truncated(&buf, header_end + 2), "Short prefixes reported as truncated");
+    printf("\n");
+
+    /* Test 5: Invalid input */
+    printf("Test 5: Invalid input\n");
+    {
+        static const uint8_t rle_header[16] = { 1, 0, 0, 0, 64 };
+        TEST(probe_frame(rle_header, sizeof(rle_header), &info) == SHARPDICOM_ERR_UNSUPPORTED,
+             "Unknown format rejected");
+        TEST(probe_frame(NULL, 4, &info) == SHARPDICOM_ERR_INVALID_ARGUMENT &&
+             probe_frame(rle_header, 4, NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "NULL arguments rejected");
+
+        build_jpeg(&buf, &header_end);
+        buf.data[header_end + 2] = 0;
+        buf.data[header_end + 3] = 1;
+        TEST(probe_frame(buf.data, buf.size, &info) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Bad segment length rejected");
+
+        static const uint8_t scan_first[] = { 0xFF, 0xD8, 0xFF, 0xDA, 0x00, 0x08, 1, 1, 0, 0, 63, 0 };
+        TEST(probe_frame(scan_first, sizeof(scan_first), &info) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Scan before frame header rejected");
+
+        buf.size = 0;
+        build_codestream(&buf, 0, &header_end);
+        buf.data[2 + 4 + 2 + 3] = 0;    /* Xsiz below XOsiz */
+        buf.data[2 + 4 + 2 + 2] = 0;
+        TEST(probe_frame(buf.data, buf.size, &info) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Empty image area rejected");
+        const char* error = sharpdicom_last_error();
+        TEST(error != NULL && error[0] != '\0', "Error message set");
+    }
+    printf("\n");
+
+    /* Test 6: Batch probe */
+    printf("Test 6: Batch probe\n");
+    {
+        header_buf jpeg, j2k;
+        size_t jpeg_end = 0, j2k_end = 0;
+        build_jpeg(&jpeg, &jpeg_end);
+        j2k.size = 0;
+        build_codestream(&j2k, 1, &j2k_end);
+
+        const uint8_t* inputs[3] = { jpeg.data, j2k.data, j2k.data };
+        size_t input_lens[3] = { jpeg.size, j2k.size, j2k_end - 1 };
+        probe_info_t infos[3];
+        int statuses[3];
+        TEST(probe_frames(inputs, input_lens, 3, infos, statuses) == 2, "Two of three frames probed");
+        TEST(statuses[0] == SHARPDICOM_OK && infos[0].codec == BATCH_CODEC_JPEG &&
+             statuses[1] == SHARPDICOM_OK && infos[1].is_htj2k == 1,
+             "Complete frames reported");
+        TEST(statuses[2] == PROBE_ERR_TRUNCATED, "Short frame reported as truncated");
+        TEST(probe_frames(inputs, input_lens, 3, infos, NULL) == 2, "Statuses are optional");
+        TEST(probe_frames(NULL, input_lens, 3, infos, statuses) == 0, "NULL input array rejected");
+    }
+    printf("\n");
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
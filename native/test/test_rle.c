@@ -0,0 +1,293 @@
+/**
+ * SharpDicom Native Codecs - RLE Lossless Test Executable
+ *
+ * Round-trips 8/16/32-bit, 1/3-sample frames in both planar configurations
+ * through every kernel set available on this CPU and checks:
+ * - Decoded pixels match the input
+ * - SIMD encoders produce the same bytes as the scalar encoder
+ * - Hand-built frames decode to the documented byte-plane layout
+ * - Malformed frames and undersized buffers are rejected
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/rle_wrapper.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+/** Deterministic pseudo-random bytes */
+static uint32_t rng_state = 12345u;
+static uint8_t next_byte(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (uint8_t)(rng_state >> 16);
+}
+
+/**
+ * Fills a buffer with a mix of noise, long runs, runs of two and runs
+ * crossing the 128-byte PackBits limit so every encoder branch is taken.
+ */
+static void fill_pattern(uint8_t* data, size_t len, int pattern) {
+    size_t i = 0;
+    while (i < len) {
+        size_t chunk = 1 + (next_byte() % (pattern == 0 ? 4u : 200u));
+        uint8_t value = next_byte();
+        int noisy = (pattern == 0) || (next_byte() & 1);
+        for (size_t k = 0; k < chunk && i < len; k++, i++) {
+            data[i] = noisy ? next_byte() : value;
+        }
+    }
+}
+
+/** Encodes and decodes one frame; optionally returns the encoded bytes */
+static int round_trip(const rle_params_t* params, int pattern, uint8_t** encoded, size_t* encoded_len) {
+    size_t raw_len = 0;
+    size_t bound = 0;
+    if (rle_get_decode_size(params, &raw_len) != SHARPDICOM_OK ||
+        rle_get_encode_bound(params, &bound) != SHARPDICOM_OK) {
+        return 0;
+    }
+
+    uint8_t* raw = (uint8_t*)malloc(raw_len);
+    uint8_t* rle = (uint8_t*)malloc(bound);
+    uint8_t* decoded = (uint8_t*)malloc(raw_len);
+    fill_pattern(raw, raw_len, pattern);
+
+    size_t actual = 0;
+    int ok = rle_encode(raw, raw_len, rle, bound, &actual, params) == SHARPDICOM_OK &&
+             actual <= bound && (actual & 1) == 0 &&
+             rle_decode(rle, actual, decoded, raw_len, params) == SHARPDICOM_OK &&
+             memcmp(raw, decoded, raw_len) == 0;
+
+    if (encoded != NULL && ok) {
+        *encoded = rle;
+        *encoded_len = actual;
+    } else {
+        free(rle);
+    }
+    free(raw);
+    free(decoded);
+    return ok;
+}
+
+/** Round-trips every case with the kernel set selected by the given SIMD mask */
+static void run_kernel_set(int mask, const char* name) {
+    static const int widths[] = { 1, 7, 16, 33, 127, 128, 129, 300 };
+    static const int bits[] = { 8, 16, 32 };
+    char message[128];
+
+    rle_set_simd_mask(mask);
+    printf("  Kernel set: %s (level 0x%x)\n", name, rle_simd_level());
+
+    for (int spp = 1; spp <= 3; spp += 2) {
+        for (int b = 0; b < 3; b++) {
+            for (int planar = 0; planar <= 1; planar++) {
+                int ok = 1;
+                for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+                    rle_params_t params = { widths[w], 5, spp, bits[b], planar };
+                    ok &= round_trip(&params, 0, NULL, NULL);
+                    ok &= round_trip(&params, 1, NULL, NULL);
+                }
+                snprintf(message, sizeof(message), "%s: %d sample(s), %d-bit, planar %d round-trips",
+                         name, spp, bits[b], planar);
+                TEST(ok, message);
+            }
+        }
+    }
+}
+
+/** Encodes the same frame with the scalar and the selected SIMD kernels */
+static int same_encoding(int mask, const rle_params_t* params, int pattern) {
+    uint8_t* scalar = NULL;
+    uint8_t* simd = NULL;
+    size_t scalar_len = 0;
+    size_t simd_len = 0;
+    uint32_t seed = rng_state;
+
+    rle_set_simd_mask(SHARPDICOM_SIMD_NONE);
+    int ok = round_trip(params, pattern, &scalar, &scalar_len);
+    rng_state = seed;
+    rle_set_simd_mask(mask);
+    ok = ok && round_trip(params, pattern, &simd, &simd_len);
+    ok = ok && scalar_len == simd_len && memcmp(scalar, simd, scalar_len) == 0;
+
+    free(scalar);
+    free(simd);
+    return ok;
+}
+
+/** Builds a frame header with the given segment offsets */
+static void put_header(uint8_t* frame, uint32_t count, const uint32_t* offsets) {
+    memset(frame, 0, RLE_HEADER_SIZE);
+    for (int i = 0; i < 4; i++) {
+        frame[i] = (uint8_t)(count >> (8 * i));
+    }
+    for (uint32_t s = 0; s < count; s++) {
+        for (int i = 0; i < 4; i++) {
+            frame[4 + 4 * s + i] = (uint8_t)(offsets[s] >> (8 * i));
+        }
+    }
+}
+
+int main(void) {
+    printf("=== SharpDicom RLE Lossless Test ===\n\n");
+
+    int simd = sharpdicom_simd_features();
+    char message[128];
+
+    /* Test 1: Feature flag */
+    printf("Test 1: Feature flag\n");
+    TEST((sharpdicom_features() & SHARPDICOM_HAS_RLE) != 0, "SHARPDICOM_HAS_RLE is reported");
+    printf("\n");
+
+    /* Test 2: Scalar round trips */
+    printf("Test 2: Scalar kernels\n");
+    run_kernel_set(SHARPDICOM_SIMD_NONE, "scalar");
+    printf("\n");
+
+    /* Test 3: SIMD round trips and encoder agreement */
+    printf("Test 3: SIMD kernels\n");
+    int masks[2] = { 0, 0 };
+    const char* names[2] = { "SSE4.1", "NEON" };
+    masks[0] = simd & SHARPDICOM_SIMD_SSE4_1;
+    masks[1] = simd & SHARPDICOM_SIMD_NEON;
+    for (int m = 0; m < 2; m++) {
+        if (masks[m] == 0) {
+            continue;
+        }
+        run_kernel_set(masks[m], names[m]);
+        int ok = 1;
+        for (int pattern = 0; pattern <= 1; pattern++) {
+            rle_params_t gray16 = { 257, 9, 1, 16, RLE_PLANAR_INTERLEAVED };
+            rle_params_t rgb8 = { 301, 7, 3, 8, RLE_PLANAR_INTERLEAVED };
+            ok &= same_encoding(masks[m], &gray16, pattern);
+            ok &= same_encoding(masks[m], &rgb8, pattern);
+        }
+        snprintf(message, sizeof(message), "%s encoder output matches scalar", names[m]);
+        TEST(ok, message);
+    }
+    rle_set_simd_mask(-1);
+    TEST(rle_simd_level() >= 0, "Runtime kernel selection restored");
+    printf("\n");
+
+    /* Test 4: Hand-built frames */
+    printf("Test 4: Known segment layouts\n");
+    {
+        /* 8 pixels: replicate 3, literal 3, no-op, replicate 2, pad */
+        uint8_t frame[RLE_HEADER_SIZE + 10];
+        uint32_t offsets[1] = { RLE_HEADER_SIZE };
+        static const uint8_t seg[10] = { 0xFE, 0x11, 0x02, 0xAA, 0xBB, 0xCC, 0x80, 0xFF, 0x22, 0x80 };
+        static const uint8_t expected[8] = { 0x11, 0x11, 0x11, 0xAA, 0xBB, 0xCC, 0x22, 0x22 };
+        put_header(frame, 1, offsets);
+        memcpy(frame + RLE_HEADER_SIZE, seg, sizeof(seg));
+        uint8_t out[8];
+        rle_params_t params = { 8, 1, 1, 8, RLE_PLANAR_INTERLEAVED };
+        TEST(rle_decode(frame, sizeof(frame), out, sizeof(out), &params) == SHARPDICOM_OK &&
+             memcmp(out, expected, sizeof(out)) == 0, "8-bit replicate/literal/no-op decode");
+    }
+    {
+        /* Two 16-bit pixels: segment 0 holds the high bytes, segment 1 the low */
+        uint8_t frame[RLE_HEADER_SIZE + 8];
+        uint32_t offsets[2] = { RLE_HEADER_SIZE, RLE_HEADER_SIZE + 4 };
+        static const uint8_t seg[8] = { 0x01, 0x12, 0x34, 0x80, 0xFF, 0xCD, 0x80, 0x80 };
+        put_header(frame, 2, offsets);
+        memcpy(frame + RLE_HEADER_SIZE, seg, sizeof(seg));
+        uint8_t out[4];
+        rle_params_t params = { 2, 1, 1, 16, RLE_PLANAR_INTERLEAVED };
+        TEST(rle_decode(frame, sizeof(frame), out, sizeof(out), &params) == SHARPDICOM_OK &&
+             out[0] == 0xCD && out[1] == 0x12 && out[2] == 0xCD && out[3] == 0x34,
+             "16-bit decode is little-endian, high byte segment first");
+    }
+    {
+        /* 2x1 RGB: one segment per sample, output interleaved or planar */
+        uint8_t frame[RLE_HEADER_SIZE + 6];
+        uint32_t offsets[3] = { RLE_HEADER_SIZE, RLE_HEADER_SIZE + 2, RLE_HEADER_SIZE + 4 };
+        static const uint8_t seg[6] = { 0xFF, 0x10, 0xFF, 0x20, 0xFF, 0x30 };
+        static const uint8_t interleaved[6] = { 0x10, 0x20, 0x30, 0x10, 0x20, 0x30 };
+        static const uint8_t planar[6] = { 0x10, 0x10, 0x20, 0x20, 0x30, 0x30 };
+        put_header(frame, 3, offsets);
+        memcpy(frame + RLE_HEADER_SIZE, seg, sizeof(seg));
+        uint8_t out[6];
+        rle_params_t params = { 2, 1, 3, 8, RLE_PLANAR_INTERLEAVED };
+        TEST(rle_decode(frame, sizeof(frame), out, sizeof(out), &params) == SHARPDICOM_OK &&
+             memcmp(out, interleaved, sizeof(out)) == 0, "RGB decode to interleaved output");
+        params.planar_configuration = RLE_PLANAR_SEPARATE;
+        TEST(rle_decode(frame, sizeof(frame), out, sizeof(out), &params) == SHARPDICOM_OK &&
+             memcmp(out, planar, sizeof(out)) == 0, "RGB decode to planar output");
+    }
+    printf("\n");
+
+    /* Test 5: Error handling */
+    printf("Test 5: Error handling\n");
+    {
+        rle_params_t params = { 64, 4, 1, 16, RLE_PLANAR_INTERLEAVED };
+        size_t raw_len = 0;
+        size_t bound = 0;
+        rle_get_decode_size(&params, &raw_len);
+        rle_get_encode_bound(&params, &bound);
+        uint8_t* raw = (uint8_t*)malloc(raw_len);
+        uint8_t* rle = (uint8_t*)malloc(bound);
+        size_t actual = 0;
+        fill_pattern(raw, raw_len, 0);
+
+        TEST(rle_encode(raw, raw_len, rle, bound, &actual, &params) == SHARPDICOM_OK,
+             "Encode noise at the encode bound");
+        TEST(rle_encode(raw, raw_len, rle, RLE_HEADER_SIZE + 8, &actual, &params) ==
+             SHARPDICOM_ERR_ENCODE_FAILED, "Undersized encode buffer rejected");
+        rle_encode(raw, raw_len, rle, bound, &actual, &params);
+        TEST(rle_decode(rle, actual, raw, raw_len - 1, &params) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "Undersized decode buffer rejected");
+        TEST(rle_decode(rle, actual - 16, raw, raw_len, &params) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Truncated segment rejected");
+        TEST(rle_decode(rle, 32, raw, raw_len, &params) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Truncated header rejected");
+
+        rle_params_t rgb = { 64, 4, 3, 16, RLE_PLANAR_INTERLEAVED };
+        uint8_t* rgb_out = (uint8_t*)malloc(raw_len * 3);
+        TEST(rle_decode(rle, actual, rgb_out, raw_len * 3, &rgb) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Segment count mismatch rejected");
+        free(rgb_out);
+
+        uint8_t saved[4];
+        memcpy(saved, rle + 8, sizeof(saved));
+        memset(rle + 8, 0xFF, sizeof(saved));
+        TEST(rle_decode(rle, actual, raw, raw_len, &params) == SHARPDICOM_ERR_CORRUPT_DATA,
+             "Out-of-range segment offset rejected");
+        memcpy(rle + 8, saved, sizeof(saved));
+
+        rle_params_t bad = { 64, 4, 1, 12, RLE_PLANAR_INTERLEAVED };
+        TEST(rle_get_decode_size(&bad, &raw_len) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "bits_allocated 12 rejected");
+        rle_params_t too_many = { 64, 4, 4, 32, RLE_PLANAR_INTERLEAVED };
+        TEST(rle_get_encode_bound(&too_many, &bound) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "More than 15 segments rejected");
+        TEST(rle_decode(NULL, 0, raw, raw_len, &params) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "NULL input rejected");
+
+        free(raw);
+        free(rle);
+    }
+    rle_free(NULL);
+    printf("\n");
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+/**
+ * SharpDicom Native Codecs - Worker Pool and Batch Decode Test Executable
+ *
+ * Checks:
+ * - Every loop index runs exactly once for any count and thread limit
+ * - Loops started from inside pool tasks (nested and concurrent) finish
+ * - Batch RLE decode matches per-frame decode, with per-frame errors
+ *   staying isolated and the failure message reaching the caller
+ * - Resizing and re-pinning the pool between loops keeps loops correct
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/thread_pool.h"
+#include "../src/batch_decode.h"
+#include "../src/rle_wrapper.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+/** Per-index hit counters shared with the loop bodies */
+typedef struct {
+    volatile int32_t* hits;
+    size_t count;
+} count_context;
+
+static void count_task(void* context, size_t index) {
+    count_context* ctx = (count_context*)context;
+    /* Uneven cost so that stealing has something to rebalance */
+    volatile uint32_t spin = 0;
+    for (size_t i = 0; i < (index % 7) * 200; i++) {
+        spin += (uint32_t)i;
+    }
+    __atomic_fetch_add(&ctx->hits[index], 1, __ATOMIC_RELAXED);
+}
+
+/** Runs one loop and checks that each index ran exactly once */
+static int run_counted(size_t count, int32_t max_threads) {
+    count_context ctx;
+    ctx.count = count;
+    ctx.hits = (volatile int32_t*)calloc(count ? count : 1, sizeof(int32_t));
+    if (!ctx.hits) {
+        return 0;
+    }
+
+    int ok = thread_pool_parallel_for(count, max_threads, count_task, &ctx) == SHARPDICOM_OK;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = (ctx.hits[i] == 1);
+    }
+    free((void*)ctx.hits);
+    return ok;
+}
+
+#define NESTED_OUTER 24
+#define NESTED_INNER 500
+
+/** Each outer index starts its own loop from whichever thread runs it */
+typedef struct {
+    volatile int32_t hits[NESTED_OUTER * NESTED_INNER];
+    volatile int32_t failures;
+} nested_context;
+
+typedef struct {
+    nested_context* parent;
+    size_t outer;
+} inner_context;
+
+static void inner_task(void* context, size_t index) {
+    inner_context* ctx = (inner_context*)context;
+    __atomic_fetch_add(&ctx->parent->hits[ctx->outer * NESTED_INNER + index], 1, __ATOMIC_RELAXED);
+}
+
+static void outer_task(void* context, size_t index) {
+    inner_context inner;
+    inner.parent = (nested_context*)context;
+    inner.outer = index;
+    if (thread_pool_parallel_for(NESTED_INNER, (int32_t)(index % 4), inner_task, &inner) != SHARPDICOM_OK) {
+        __atomic_fetch_add(&inner.parent->failures, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/** Deterministic pseudo-random bytes */
+static uint32_t rng_state = 4242u;
+static uint8_t next_byte(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (uint8_t)(rng_state >> 16);
+}
+
+#define BATCH_FRAMES 12
+
+int main(void) {
+    printf("=== SharpDicom Worker Pool Test ===\n\n");
+
+    /* Test 1: Pool size */
+    printf("Test 1: Pool size\n");
+    int32_t concurrency = thread_pool_concurrency();
+    printf("  Concurrency: %d\n", concurrency);
+    TEST(concurrency >= 1 && concurrency <= THREAD_POOL_MAX_THREADS, "Concurrency within bounds");
+    printf("\n");
+
+    /* Test 2: Every index exactly once */
+    printf("Test 2: Index coverage\n");
+    {
+        static const size_t counts[] = { 0, 1, 2, 3, 7, 64, 1000, 100000 };
+        static const int32_t limits[] = { 0, 1, 2, 3, 1000 };
+        int all_ok = 1;
+        for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+            for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+                if (!run_counted(counts[c], limits[l])) {
+                    printf("  count=%zu max_threads=%d failed\n", counts[c], limits[l]);
+                    all_ok = 0;
+                }
+            }
+        }
+        TEST(all_ok, "All counts and thread limits run each index once");
+
+        int repeat_ok = 1;
+        for (int i = 0; i < 200 && repeat_ok; i++) {
+            repeat_ok = run_counted(97, 0);
+        }
+        TEST(repeat_ok, "Repeated short loops complete");
+    }
+    printf("\n");
+
+    /* Test 3: Nested and concurrent loops */
+    printf("Test 3: Nested loops\n");
+    {
+        nested_context* ctx = (nested_context*)calloc(1, sizeof(nested_context));
+        TEST(ctx != NULL, "Context allocated");
+        if (ctx) {
+            int status = thread_pool_parallel_for(NESTED_OUTER, 0, outer_task, ctx);
+            TEST(status == SHARPDICOM_OK && ctx->failures == 0, "Outer loop and all inner loops succeed");
+
+            int ok = 1;
+            for (size_t i = 0; i < NESTED_OUTER * NESTED_INNER; i++) {
+                if (ctx->hits[i] != 1) {
+                    ok = 0;
+                    break;
+                }
+            }
+            TEST(ok, "Every inner index ran once");
+            free(ctx);
+        }
+    }
+    printf("\n");
+
+    /* Test 4: Error handling */
+    printf("Test 4: Error handling\n");
+    TEST(thread_pool_parallel_for(4, 0, NULL, NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+         "NULL task rejected");
+    printf("\n");
+
+    /* Test 5: Batch RLE decode */
+    printf("Test 5: Batch decode\n");
+    {
+        batch_decode_options_t options;
+        memset(&options, 0, sizeof(options));
+        options.rle.width = 61;
+        options.rle.height = 37;
+        options.rle.samples_per_pixel = 3;
+        options.rle.bits_allocated = 16;
+        options.rle.planar_configuration = RLE_PLANAR_INTERLEAVED;
+
+        size_t raw_len = 0;
+        size_t bound = 0;
+        int ok = rle_get_decode_size(&options.rle, &raw_len) == SHARPDICOM_OK &&
+                 rle_get_encode_bound(&options.rle, &bound) == SHARPDICOM_OK;
+
+        uint8_t* raw = (uint8_t*)malloc(raw_len * BATCH_FRAMES);
+        uint8_t* encoded = (uint8_t*)malloc(bound * BATCH_FRAMES);
+        uint8_t* decoded = (uint8_t*)malloc(raw_len * BATCH_FRAMES);
+        const uint8_t* inputs[BATCH_FRAMES];
+        size_t input_lens[BATCH_FRAMES];
+        uint8_t* outputs[BATCH_FRAMES];
+        size_t output_lens[BATCH_FRAMES];
+        batch_decode_result_t results[BATCH_FRAMES];
+        ok = ok && raw && encoded && decoded;
+
+        for (int f = 0; ok && f < BATCH_FRAMES; f++) {
+            uint8_t* frame = raw + (size_t)f * raw_len;
+            for (size_t i = 0; i < raw_len; i++) {
+                /* Runs for even frames, noise for odd ones */
+                frame[i] = (f & 1) ? next_byte() : (uint8_t)(i / 97);
+            }
+            inputs[f] = encoded + (size_t)f * bound;
+            outputs[f] = decoded + (size_t)f * raw_len;
+            output_lens[f] = raw_len;
+            ok = rle_encode(frame, raw_len, encoded + (size_t)f * bound, bound,
+                            &input_lens[f], &options.rle) == SHARPDICOM_OK;
+        }
+        TEST(ok, "Frames encoded");
+
+        if (ok) {
+            static const int32_t limits[] = { 0, 1, 3 };
+            for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+                options.max_threads = limits[l];
+                memset(decoded, 0, raw_len * BATCH_FRAMES);
+                int decoded_count = batch_decode(BATCH_CODEC_RLE, inputs, input_lens, outputs, output_lens,
+                                                 BATCH_FRAMES, &options, results);
+
+                int match = (decoded_count == BATCH_FRAMES);
+                for (int f = 0; match && f < BATCH_FRAMES; f++) {
+                    match = results[f].status == SHARPDICOM_OK &&
+                            results[f].width == 61 && results[f].height == 37 &&
+                            results[f].num_components == 3 && results[f].precision == 16 &&
+                            results[f].output_size == raw_len &&
+                            memcmp(outputs[f], raw + (size_t)f * raw_len, raw_len) == 0;
+                }
+                printf("  max_threads=%d: %d frames\n", limits[l], decoded_count);
+                TEST(match, "Batch output matches source frames");
+            }
+
+            /* One truncated frame and one undersized output */
+            options.max_threads = 0;
+            size_t saved_len = input_lens[4];
+            input_lens[4] = 10;
+            output_lens[9] = raw_len - 1;
+            sharpdicom_clear_error();
+            int decoded_count = batch_decode(BATCH_CODEC_RLE, inputs, input_lens, outputs, output_lens,
+                                             BATCH_FRAMES, &options, results);
+            TEST(decoded_count == BATCH_FRAMES - 2, "Other frames still decode");
+            TEST(results[4].status != SHARPDICOM_OK && results[9].status != SHARPDICOM_OK,
+                 "Failed frames report their own status");
+            TEST(results[3].status == SHARPDICOM_OK && results[10].status == SHARPDICOM_OK,
+                 "Neighbouring frames unaffected");
+            const char* error = sharpdicom_last_error();
+            TEST(error != NULL && error[0] != '\0', "Failure message reaches the caller");
+            input_lens[4] = saved_len;
+            output_lens[9] = raw_len;
+        }
+
+        TEST(batch_decode(BATCH_CODEC_RLE, inputs, input_lens, outputs, output_lens,
+                          BATCH_FRAMES, NULL, results) == 0,
+             "RLE without options rejected");
+        TEST(batch_decode(99, inputs, input_lens, outputs, output_lens,
+                          BATCH_FRAMES, &options, results) == 0,
+             "Unknown codec rejected");
+        TEST(batch_decode(BATCH_CODEC_RLE, NULL, input_lens, outputs, output_lens,
+                          BATCH_FRAMES, &options, results) == 0,
+             "NULL input array rejected");
+
+        free(raw);
+        free(encoded);
+        free(decoded);
+    }
+    printf("\n");
+
+    /* Test 6: Size, affinity and NUMA configuration */
+    printf("Test 6: Pool configuration\n");
+    {
+        TEST(sharpdicom_set_thread_count(-1) == SHARPDICOM_ERR_INVALID_ARGUMENT, "Negative thread count rejected");
+        TEST(sharpdicom_set_thread_count(3) == SHARPDICOM_OK && sharpdicom_get_thread_count() == 3,
+             "Thread count set");
+        TEST(run_counted(5000, 0) && thread_pool_concurrency() <= 3, "Loops run on the resized pool");
+        TEST(sharpdicom_set_thread_count(100000) == SHARPDICOM_OK &&
+             sharpdicom_get_thread_count() == THREAD_POOL_MAX_THREADS,
+             "Thread count capped");
+        TEST(sharpdicom_set_thread_count(1) == SHARPDICOM_OK && run_counted(300, 0) &&
+             thread_pool_concurrency() == 1,
+             "Single-thread budget runs on the caller");
+
+        /* Rapid reconfiguration while loops keep running */
+        int churn_ok = 1;
+        for (int i = 0; i < 50 && churn_ok; i++) {
+            churn_ok = sharpdicom_set_thread_count(1 + i % 5) == SHARPDICOM_OK && run_counted(257, 0);
+        }
+        TEST(churn_ok, "Loops survive repeated resizing");
+        TEST(sharpdicom_set_thread_count(0) == SHARPDICOM_OK && sharpdicom_get_thread_count() >= 1,
+             "Automatic thread count restored");
+
+        uint64_t empty_mask[2] = { 0, 0 };
+        TEST(sharpdicom_set_thread_affinity(empty_mask, 2) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "Empty affinity mask rejected");
+        uint64_t cpu0 = 1;
+        int status = sharpdicom_set_thread_affinity(&cpu0, 1);
+        if (status == SHARPDICOM_OK) {
+            TEST(sharpdicom_get_thread_count() == 1, "Thread count follows the affinity mask");
+            TEST(sharpdicom_set_thread_count(4) == SHARPDICOM_OK && run_counted(2000, 0),
+                 "Loops run on pinned workers");
+            sharpdicom_set_thread_count(0);
+        } else {
+            TEST(status == SHARPDICOM_ERR_UNSUPPORTED, "Affinity reported unsupported");
+        }
+        TEST(sharpdicom_set_thread_affinity(NULL, 0) == SHARPDICOM_OK, "Affinity cleared");
+
+        int32_t nodes = sharpdicom_numa_node_count();
+        printf("  NUMA nodes: %d\n", nodes);
+        TEST(nodes >= 1, "NUMA node count reported");
+        TEST(sharpdicom_set_numa_node(nodes) == SHARPDICOM_ERR_INVALID_ARGUMENT, "Unknown NUMA node rejected");
+        status = sharpdicom_set_numa_node(0);
+        if (status == SHARPDICOM_OK) {
+            TEST(sharpdicom_get_numa_node() == 0 && run_counted(2000, 0), "Loops run on NUMA node 0");
+        } else {
+            TEST(status == SHARPDICOM_ERR_UNSUPPORTED, "NUMA binding reported unsupported");
+        }
+        TEST(sharpdicom_set_numa_node(-1) == SHARPDICOM_OK && sharpdicom_get_numa_node() == -1,
+             "NUMA binding cleared");
+    }
+    printf("\n");
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
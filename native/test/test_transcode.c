@@ -0,0 +1,163 @@
+/**
+ * SharpDicom Native Codecs - Transcode Test Executable
+ *
+ * Checks:
+ * - Single-frame and pipelined RLE transcodes reproduce the source frames
+ * - A failed frame in a batch stays isolated and its message reaches the caller
+ * - Invalid options are rejected
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/sharpdicom_codecs.h"
+#include "../src/transcode.h"
+#include "../src/rle_wrapper.h"
+
+/* Test result counters */
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(condition, message) do { \
+    if (condition) { \
+        printf("[PASS] %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("[FAIL] %s\n", message); \
+        tests_failed++; \
+    } \
+} while (0)
+
+/** Deterministic pseudo-random bytes */
+static uint32_t rng_state = 4242u;
+static uint8_t next_byte(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (uint8_t)(rng_state >> 16);
+}
+
+#define BATCH_FRAMES 12
+
+int main(void) {
+    printf("=== SharpDicom Transcode Test ===\n\n");
+
+    /* Planar source frames; RLE segments do not depend on the raw layout */
+    rle_params_t params = { 53, 29, 3, 16, RLE_PLANAR_SEPARATE };
+    transcode_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.source_codec = BATCH_CODEC_RLE;
+    options.target_codec = BATCH_CODEC_RLE;
+    options.rle = params;
+
+    size_t raw_len = 0;
+    size_t bound = 0;
+    int ok = rle_get_decode_size(&params, &raw_len) == SHARPDICOM_OK &&
+             rle_get_encode_bound(&params, &bound) == SHARPDICOM_OK;
+
+    uint8_t* raw = (uint8_t*)malloc(raw_len);
+    uint8_t* encoded = (uint8_t*)malloc(bound * BATCH_FRAMES);
+    const uint8_t* inputs[BATCH_FRAMES];
+    size_t input_lens[BATCH_FRAMES];
+    J2kOutputBuffer outputs[BATCH_FRAMES];
+    transcode_result_t results[BATCH_FRAMES];
+    memset(outputs, 0, sizeof(outputs));
+    ok = ok && raw && encoded;
+
+    for (int f = 0; ok && f < BATCH_FRAMES; f++) {
+        for (size_t i = 0; i < raw_len; i++) {
+            raw[i] = (f & 1) ? next_byte() : (uint8_t)(i / 61 + f);
+        }
+        inputs[f] = encoded + (size_t)f * bound;
+        ok = rle_encode(raw, raw_len, encoded + (size_t)f * bound, bound,
+                        &input_lens[f], &params) == SHARPDICOM_OK;
+    }
+    TEST(ok, "Source frames encoded");
+    printf("\n");
+
+    /* Test 1: Single-frame transcode */
+    printf("Test 1: Single frame\n");
+    J2kOutputBuffer single;
+    memset(&single, 0, sizeof(single));
+    if (ok) {
+        transcode_result_t result;
+        int match = 1;
+        for (int f = 0; match && f < BATCH_FRAMES; f++) {
+            match = transcode(inputs[f], input_lens[f], &options, &single, &result) == SHARPDICOM_OK &&
+                    result.status == SHARPDICOM_OK && result.precision == 16 &&
+                    single.size == input_lens[f] && result.output_size == single.size &&
+                    memcmp(single.data, inputs[f], single.size) == 0;
+        }
+        TEST(match, "Single-frame transcode reproduces the source frames");
+        j2k_free(single.data);
+        memset(&single, 0, sizeof(single));
+    }
+    printf("\n");
+
+    /* Test 2: Pipelined batch transcode */
+    printf("Test 2: Batch pipeline\n");
+    if (ok) {
+        static const int32_t limits[] = { 0, 1, 2, 5 };
+        for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+            options.max_threads = limits[l];
+            int transcoded_count = transcode_batch(inputs, input_lens, BATCH_FRAMES,
+                                                   &options, outputs, results);
+            int match = (transcoded_count == BATCH_FRAMES);
+            for (int f = 0; match && f < BATCH_FRAMES; f++) {
+                match = results[f].status == SHARPDICOM_OK &&
+                        results[f].width == 53 && results[f].height == 29 &&
+                        results[f].num_components == 3 &&
+                        outputs[f].size == input_lens[f] &&
+                        memcmp(outputs[f].data, inputs[f], outputs[f].size) == 0;
+            }
+            printf("  max_threads=%d: %d frames\n", limits[l], transcoded_count);
+            TEST(match, "Batch transcode reproduces the source frames");
+        }
+        options.max_threads = 0;
+    }
+    printf("\n");
+
+    /* Test 3: Error handling */
+    printf("Test 3: Error handling\n");
+    if (ok) {
+        /* One truncated frame */
+        size_t saved_len = input_lens[5];
+        input_lens[5] = 10;
+        sharpdicom_clear_error();
+        int transcoded_count = transcode_batch(inputs, input_lens, BATCH_FRAMES,
+                                               &options, outputs, results);
+        TEST(transcoded_count == BATCH_FRAMES - 1 && results[5].status != SHARPDICOM_OK &&
+             outputs[5].size == 0 && results[6].status == SHARPDICOM_OK,
+             "Failed frame stays isolated");
+        const char* error = sharpdicom_last_error();
+        TEST(error != NULL && error[0] != '\0', "Failure message reaches the caller");
+        input_lens[5] = saved_len;
+
+        options.bits_stored = 17;
+        TEST(transcode(inputs[0], input_lens[0], &options, &single, NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+             "bits_stored wider than the samples rejected");
+        options.bits_stored = 0;
+        j2k_free(single.data);
+    }
+
+    TEST(transcode(inputs[0], input_lens[0], &options, NULL, NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT,
+         "Missing output rejected");
+    TEST(transcode_batch(inputs, input_lens, BATCH_FRAMES, NULL, outputs, results) == 0,
+         "Missing options rejected");
+    options.target_codec = 99;
+    TEST(transcode_batch(inputs, input_lens, BATCH_FRAMES, &options, outputs, results) == 0,
+         "Unknown codec rejected");
+    printf("\n");
+
+    for (int f = 0; f < BATCH_FRAMES; f++) {
+        j2k_free(outputs[f].data);
+    }
+    free(raw);
+    free(encoded);
+
+    /* Summary */
+    printf("=== Test Summary ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    printf("\n");
+
+    return (tests_failed > 0) ? 1 : 0;
+}
@@ -6,12 +6,15 @@
  * - Feature detection
  * - SIMD capability detection
  * - Error message handling
+ * - JPEG 2000 decode thread defaults
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "../src/sharpdicom_codecs.h"
+#include "../src/j2k_wrapper.h"
+#include "../src/rle_wrapper.h"
 
 /* Test result counters */
 static int tests_passed = 0;
@@ -109,6 +112,10 @@ static void print_codec_features(int features) {
             printf("%sHTJ2K", first ? "" : ", ");
             first = 0;
         }
+        if (features & SHARPDICOM_HAS_J2K_MT) {
+            printf("%sJPEG2000-MT", first ? "" : ", ");
+            first = 0;
+        }
     }
     printf("\n");
 }
@@ -161,6 +168,60 @@ int main(void) {
     TEST(strlen(error) == 0, "clear_error clears the message");
     printf("\n");
 
+    /* Test 5: JPEG 2000 decode threads */
+    printf("Test 5: JPEG 2000 Decode Threads\n");
+    int32_t j2k_threads = j2k_get_default_threads();
+    printf("  Default decode workers: %d\n", (int)j2k_threads);
+    TEST(j2k_threads >= 1, "Default J2K worker count is at least 1");
+    TEST(((features & SHARPDICOM_HAS_J2K_MT) != 0) == (j2k_threads > 1),
+         "J2K-MT feature bit matches default worker count");
+    TEST(j2k_set_default_threads(-1) != SHARPDICOM_OK, "Negative J2K worker count is rejected");
+    sharpdicom_clear_error();
+    printf("\n");
+
+    /* Test 6: Codec statistics */
+    printf("Test 6: Codec Statistics\n");
+    {
+        sharpdicom_stats_t stats;
+        TEST(sharpdicom_get_stats(NULL) == SHARPDICOM_ERR_INVALID_ARGUMENT, "NULL stats rejected");
+        sharpdicom_clear_error();
+
+        sharpdicom_reset_stats();
+        TEST(sharpdicom_get_stats(&stats) == SHARPDICOM_OK &&
+             stats.codecs[SHARPDICOM_STATS_RLE].decode.calls == 0 &&
+             stats.codecs[SHARPDICOM_STATS_RLE].encode.calls == 0, "Counters start at zero after reset");
+
+        rle_params_t params = { 64, 32, 1, 16, RLE_PLANAR_INTERLEAVED };
+        static uint8_t raw[64 * 32 * 2];
+        static uint8_t decoded[64 * 32 * 2];
+        static uint8_t encoded[16384];
+        for (size_t i = 0; i < sizeof(raw); i++) {
+            raw[i] = (uint8_t)(i / 16);
+        }
+        size_t encoded_len = 0;
+        int ok = rle_encode(raw, sizeof(raw), encoded, sizeof(encoded), &encoded_len, &params) == SHARPDICOM_OK;
+        ok = ok && rle_decode(encoded, encoded_len, decoded, sizeof(decoded), &params) == SHARPDICOM_OK;
+        ok = ok && rle_decode(encoded, 8, decoded, sizeof(decoded), &params) != SHARPDICOM_OK;
+        sharpdicom_clear_error();
+
+        sharpdicom_get_stats(&stats);
+        const sharpdicom_op_stats_t* enc = &stats.codecs[SHARPDICOM_STATS_RLE].encode;
+        const sharpdicom_op_stats_t* dec = &stats.codecs[SHARPDICOM_STATS_RLE].decode;
+        TEST(ok && enc->calls == 1 && enc->errors == 0 && enc->bytes_in == sizeof(raw) &&
+             enc->bytes_out == encoded_len, "RLE encode counted with its bytes");
+        TEST(dec->calls == 2 && dec->errors == 1 && dec->bytes_in == encoded_len + 8 &&
+             dec->bytes_out == sizeof(raw), "RLE decodes counted, failed one as an error");
+        TEST(stats.codecs[SHARPDICOM_STATS_JPEG].decode.calls == 0 &&
+             stats.codecs[SHARPDICOM_STATS_DEFLATE].encode.calls == 0, "Other codecs untouched");
+
+        sharpdicom_reset_stats();
+        sharpdicom_get_stats(&stats);
+        TEST(stats.codecs[SHARPDICOM_STATS_RLE].decode.calls == 0 &&
+             stats.codecs[SHARPDICOM_STATS_RLE].decode.time_ns == 0 && stats.gpu_frames == 0,
+             "Reset clears the counters");
+    }
+    printf("\n");
+
     /* Summary */
     printf("=== Test Summary ===\n");
     printf("Passed: %d\n", tests_passed);